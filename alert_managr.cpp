@@ -1,5 +1,6 @@
 #include "alert.h"
-#include "config.h"
+#include "confi.h"
+#include "trace_log.h"
 
 AlertManager alertManager;
 
@@ -44,7 +45,7 @@ void AlertManager::addAlert(AlertType type, String message) {
     }
     
     // Log alert
-    Serial.printf("ALERT: %s\n", message.c_str());
+    TRACE("ALERT: %s\n", message.c_str());
 }
 
 void AlertManager::acknowledgeAlert(int index) {
@@ -0,0 +1,423 @@
+/*
+ * Batch analyzer for exported sessions: runs folders of recordings through
+ * the monitor's estimator and alarm rules, many at a time, and reports on
+ * each and on the lot. The estimator is the device's, spo2_algorithm.cpp of
+ * the SparkFun MAX3010x library from lib_deps, and beats are the IR valleys
+ * it finds. Its working buffers are statics, so workers take turns in it.
+ *
+ *   pio run -e analyze && .pio/build/analyze/program --out results --report report.json \
+ *       --hr-min 50 --spo2-min 92 sessions/
+ *
+ * Arguments are recordings or directories of them: CSV waveforms as
+ * bench/replay.cpp reads them, and .bin vitals log segments. Per file,
+ * --out gets <name>.timeline.csv, one row per --interval with the heart
+ * rate and SpO2 on screen, beats, SDNN / RMSSD and alarms, and <name>.json
+ * with the session summary and every alarm raised (session_analyzer.h).
+ * --report writes the aggregate, the per-file summaries included.
+ *
+ * The alarm rules run twice: with the --hr-min / --hr-max / --spo2-min
+ * being evaluated and with the --baseline-* the recordings were taken
+ * under (the settings screen's defaults unless given), so a report shows
+ * what a change of thresholds would have done to each session.
+ *
+ * Files are shared out over a work-stealing pool (work_stealing_pool.h),
+ * largest first, and read through memory maps. Each worker keeps one
+ * analyzer, so nothing is allocated per sample. Results do not depend on
+ * the number of threads.
+ *
+ * --bench times the same batch at 1, 2, 4 ... --threads workers without
+ * writing anything, and prints the speedup; on a single-core host that
+ * shows overhead only, not scaling. --generate DIR first writes
+ * --sessions synthetic recordings of varied patients and lengths into DIR
+ * and analyses them:
+ *
+ *   .pio/build/analyze/program --generate .analyze_sessions --sessions 64 --minutes 60 --bench
+ *
+ * With g++, from the repository root, once PlatformIO has fetched the
+ * library:
+ *   pio pkg install -e analyze
+ *   MAXIM=$(ls -d .pio/libdeps/analyze/SparkFun*)/src
+ *   g++ -O2 -std=gnu++17 -DARDUINO=10819 -Inative -I. -I"$MAXIM" -pthread -o analyze analyze/analyze.cpp \
+ *       analyze/session_analyzer.cpp analyze/work_stealing_pool.cpp analyze/mapped_file.cpp \
+ *       "$MAXIM"/spo2_algorithm.cpp vitals_pipeline.cpp vitals_log.cpp \
+ *       signal_generator.cpp native/arduino_core.cpp metrics.cpp http_stream.cpp
+ */
+
+#include <Arduino.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../hal.h"
+#include "../signal_generator.h"
+#include "session_analyzer.h"
+#include "work_stealing_pool.h"
+
+// Nothing but the clock is needed on this path
+Hal hal = {&sessionClock, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+
+struct AnalyzeOptions {
+    AnalyzerOptions analyzer;
+    int threads = std::max(1, (int)std::thread::hardware_concurrency());
+    std::string reportPath;
+    bool bench = false;
+    int repetitions = 3;
+    std::string generateDir;
+    int sessions = 32;
+    double minutes = 60;
+};
+
+// A recording in the batch
+struct Input {
+    std::string path;
+    std::string name;           // Output file stem, unique in the batch
+    off_t size;
+};
+
+static double nowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool endsWith(const std::string& text, const char* suffix) {
+    size_t length = strlen(suffix);
+    return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+// ==================== INPUTS ====================
+static void addInput(std::vector<Input>& inputs, const std::string& path, off_t size) {
+    Input input;
+    input.path = path;
+    size_t slash = path.find_last_of('/');
+    input.name = slash == std::string::npos ? path : path.substr(slash + 1);
+    size_t dot = input.name.find_last_of('.');
+    if (dot != std::string::npos && dot > 0) input.name.erase(dot);
+    input.size = size;
+    inputs.push_back(input);
+}
+
+// Files as given; directories for their .csv and .bin files, by name
+static bool collectInputs(const std::vector<std::string>& paths, std::vector<Input>& inputs) {
+    for (const std::string& path : paths) {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0) {
+            fprintf(stderr, "%s: %s\n", path.c_str(), strerror(errno));
+            return false;
+        }
+        if (!S_ISDIR(info.st_mode)) {
+            addInput(inputs, path, info.st_size);
+            continue;
+        }
+        DIR* dir = opendir(path.c_str());
+        if (!dir) {
+            fprintf(stderr, "%s: %s\n", path.c_str(), strerror(errno));
+            return false;
+        }
+        std::vector<std::string> names;
+        while (struct dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (endsWith(name, ".csv") || endsWith(name, ".bin")) names.push_back(name);
+        }
+        closedir(dir);
+        std::sort(names.begin(), names.end());
+        for (const std::string& name : names) {
+            std::string file = path + (endsWith(path, "/") ? "" : "/") + name;
+            if (stat(file.c_str(), &info) == 0 && S_ISREG(info.st_mode)) addInput(inputs, file, info.st_size);
+        }
+    }
+
+    // session.csv and session.bin, or two folders' day1.csv, must not
+    // write over each other's results
+    std::set<std::string> taken;
+    for (Input& input : inputs) {
+        std::string name = input.name;
+        for (int n = 2; taken.count(name); n++) name = input.name + "-" + std::to_string(n);
+        input.name = name;
+        taken.insert(name);
+    }
+    return true;
+}
+
+// ==================== SYNTHETIC SESSIONS ====================
+// Varied patients, as the gateway's simulated ward has them, and lengths
+// from half to twice --minutes so that the batch is uneven
+static bool generateSession(const std::string& path, int session, double minutes) {
+    PhysiologyParams patient;
+    patient.heartRate = 58.0f + (session * 37) % 50;
+    patient.spO2 = 99.0f - (session * 5) % 8;
+    if (session % 17 == 5) patient.heartRate = 42.0f;
+    patient.motionRate = (session % 7 == 3) ? 2.0f : 0.0f;
+    const float rate = 25.0f;
+    SignalGenerator generator(rate, session + 1);
+    generator.setParams(patient);
+
+    FILE* out = fopen(path.c_str(), "w");
+    if (!out) return false;
+    fprintf(out, "# synthetic session %d: %.0f BPM, SpO2 %.0f%%, motion %.0f/min\n", session, patient.heartRate,
+            patient.spO2, patient.motionRate);
+    fprintf(out, "t_ms,red,ir,ecg,hr,spo2,beat\n");
+    size_t count = (size_t)(minutes * 60 * rate * (0.5 + (session * 7 % 4) * 0.5));
+    SignalSample sample;
+    for (size_t i = 0; i < count; i++) {
+        generator.next(sample);
+        uint32_t time = (uint32_t)((generator.getSampleIndex() - 1) * 1000.0 / rate);
+        fprintf(out, "%u,%u,%u,%u,%.1f,%.0f,%d\n", time, sample.red, sample.ir, sample.ecg, sample.heartRate,
+                patient.spO2, sample.beat ? 1 : 0);
+    }
+    return fclose(out) == 0;
+}
+
+static bool generateSessions(const AnalyzeOptions& options) {
+    mkdir(options.generateDir.c_str(), 0755);
+    WorkStealingPool pool(options.threads);
+    std::vector<char> written(options.sessions);
+    double start = nowSeconds();
+    pool.run(options.sessions, [&](int, size_t session) {
+        char name[32];
+        snprintf(name, sizeof(name), "/session-%03zu.csv", session + 1);
+        written[session] = generateSession(options.generateDir + name, (int)session, options.minutes);
+    });
+    if (std::find(written.begin(), written.end(), 0) != written.end()) {
+        fprintf(stderr, "Could not write sessions into %s\n", options.generateDir.c_str());
+        return false;
+    }
+    fprintf(stderr, "Generated %d sessions in %s in %.1f s\n", options.sessions, options.generateDir.c_str(),
+            nowSeconds() - start);
+    return true;
+}
+
+// ==================== BATCH ====================
+struct BatchRun {
+    double wallSeconds = 0;
+    uint64_t steals = 0;
+};
+
+// Analyses every input on `threads` workers into `summaries`, in input order
+static BatchRun runBatch(const std::vector<Input>& inputs, const AnalyzerOptions& options, int threads,
+                         std::vector<SessionSummary>& summaries) {
+    // Largest first, so what is left to steal at the end is small
+    std::vector<size_t> order(inputs.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return inputs[a].size > inputs[b].size; });
+
+    std::vector<std::unique_ptr<SessionAnalyzer>> analyzers;
+    for (int w = 0; w < threads; w++) analyzers.emplace_back(new SessionAnalyzer(options));
+    summaries.assign(inputs.size(), SessionSummary());
+
+    WorkStealingPool pool(threads);
+    BatchRun run;
+    double start = nowSeconds();
+    pool.run(order.size(), [&](int worker, size_t task) {
+        const Input& input = inputs[order[task]];
+        SessionSummary& summary = summaries[order[task]];
+        analyzers[worker]->analyze(input.path, input.name, summary);
+        summary.worker = worker;
+    });
+    run.wallSeconds = nowSeconds() - start;
+    run.steals = pool.getSteals();
+    return run;
+}
+
+// ==================== REPORTING ====================
+static void printSummary(const SessionSummary& s) {
+    if (!s.error.empty()) {
+        printf("%s: %s\n", s.path.c_str(), s.error.c_str());
+        return;
+    }
+    printf("%s: %zu %s (%.1f min)", s.path.c_str(), s.samples, s.waveform ? "samples" : "readings",
+           s.recordedSeconds / 60);
+    if (s.heartRateMean > 0) printf(", HR %.0f (%.0f-%.0f)", s.heartRateMean, s.heartRateMin, s.heartRateMax);
+    if (s.spO2Mean > 0) printf(", SpO2 %.0f (min %.0f)", s.spO2Mean, s.spO2Min);
+    printf(", shown %.0f%%", 100 * s.coverage);
+    if (s.rrIntervals > 1) printf(", SDNN %.0f ms RMSSD %.0f ms", s.sdnn, s.rmssd);
+    printf(", alarms %u (%u critical, %u before)\n", s.alarmCount(), s.criticalAlarms, s.baselineAlarmCount());
+}
+
+static void writeThresholds(FILE* out, const char* name, const AlertThresholds& t) {
+    fprintf(out, "\"%s\":{\"heartRateMin\":%.1f,\"heartRateMax\":%.1f,\"spO2Min\":%.1f,\"batteryMin\":%.1f}", name,
+            t.heartRateMin, t.heartRateMax, t.spO2Min, t.batteryMin);
+}
+
+struct ScalingPoint {
+    int threads;
+    double wallSeconds;
+};
+
+static bool writeReport(const std::string& path, const AnalyzeOptions& options, int threads, const BatchRun& run,
+                        const std::vector<SessionSummary>& summaries, const std::vector<ScalingPoint>& scaling) {
+    FILE* out = fopen(path.c_str(), "w");
+    if (!out) return false;
+
+    size_t samples = 0, failed = 0;
+    double recorded = 0;
+    uint32_t alarms[ALARM_KIND_COUNT] = {}, baseline[ALARM_KIND_COUNT] = {}, critical = 0;
+    for (const SessionSummary& s : summaries) {
+        if (!s.error.empty()) {
+            failed++;
+            continue;
+        }
+        samples += s.samples;
+        recorded += s.recordedSeconds;
+        critical += s.criticalAlarms;
+        for (int k = 0; k < ALARM_KIND_COUNT; k++) alarms[k] += s.alarms[k], baseline[k] += s.baselineAlarms[k];
+    }
+
+    fprintf(out, "{\"threads\":%d,\"wallSeconds\":%.4f,\"files\":%zu,\"failed\":%zu,\"samples\":%zu,"
+                 "\"recordedSeconds\":%.1f,\"samplesPerSecond\":%.0f,\"steals\":%llu,",
+            threads, run.wallSeconds, summaries.size(), failed, samples, recorded,
+            run.wallSeconds > 0 ? samples / run.wallSeconds : 0.0, (unsigned long long)run.steals);
+    writeThresholds(out, "thresholds", options.analyzer.thresholds);
+    fprintf(out, ",");
+    writeThresholds(out, "baseline", options.analyzer.baseline);
+    fprintf(out, ",\n\"alarms\":{\"heart_rate\":%u,\"spo2\":%u,\"battery\":%u,\"critical\":%u},"
+                 "\"baselineAlarms\":{\"heart_rate\":%u,\"spo2\":%u,\"battery\":%u},",
+            alarms[0], alarms[1], alarms[2], critical, baseline[0], baseline[1], baseline[2]);
+    if (!scaling.empty()) {
+        fprintf(out, "\n\"scaling\":[");
+        for (size_t i = 0; i < scaling.size(); i++) {
+            double speedup = scaling[i].wallSeconds > 0 ? scaling[0].wallSeconds / scaling[i].wallSeconds : 0;
+            fprintf(out, "%s{\"threads\":%d,\"wallSeconds\":%.4f,\"speedup\":%.2f,\"efficiency\":%.3f}", i ? "," : "",
+                    scaling[i].threads, scaling[i].wallSeconds, speedup, speedup / scaling[i].threads);
+        }
+        fprintf(out, "],");
+    }
+    fprintf(out, "\n\"sessions\":[");
+    for (size_t i = 0; i < summaries.size(); i++) {
+        fprintf(out, "%s\n{", i ? "," : "");
+        writeSummaryJson(out, summaries[i]);
+        fprintf(out, "}");
+    }
+    fprintf(out, "\n]}\n");
+    return fclose(out) == 0;
+}
+
+static void usage() {
+    fprintf(stderr,
+        "Usage: analyze [options] FILE|DIR...\n"
+        "  --threads N            workers (default: the cores)\n"
+        "  --out DIR              per-file <name>.timeline.csv and <name>.json\n"
+        "  --report FILE          aggregate JSON report\n"
+        "  --interval S           timeline resolution (default 60)\n"
+        "  --rate HZ              sample rate of CSV files without t_ms (default 25)\n"
+        "  --hr-min BPM           thresholds to evaluate (defaults as in the settings screen)\n"
+        "  --hr-max BPM\n"
+        "  --spo2-min PCT\n"
+        "  --baseline-hr-min BPM  thresholds the recordings were taken under (same defaults)\n"
+        "  --baseline-hr-max BPM\n"
+        "  --baseline-spo2-min PCT\n"
+        "  --bench                time the batch at 1, 2, 4 ... --threads workers\n"
+        "  --repetitions N        runs per thread count under --bench (default 3)\n"
+        "  --generate DIR         write synthetic sessions into DIR and analyse them\n"
+        "  --sessions N           how many (default 32)\n"
+        "  --minutes N            their typical length (default 60)\n");
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    AnalyzeOptions options;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--bench") {
+            options.bench = true;
+            continue;
+        }
+        if (option.compare(0, 2, "--") != 0) {
+            paths.push_back(option);
+            continue;
+        }
+        if (i + 1 >= argc) usage();
+        const char* value = argv[++i];
+        if (option == "--threads") options.threads = atoi(value);
+        else if (option == "--out") options.analyzer.outDir = value;
+        else if (option == "--report") options.reportPath = value;
+        else if (option == "--interval") options.analyzer.intervalMs = (uint32_t)(atof(value) * 1000);
+        else if (option == "--rate") options.analyzer.rate = atof(value);
+        else if (option == "--hr-min") options.analyzer.thresholds.heartRateMin = atof(value);
+        else if (option == "--hr-max") options.analyzer.thresholds.heartRateMax = atof(value);
+        else if (option == "--spo2-min") options.analyzer.thresholds.spO2Min = atof(value);
+        else if (option == "--baseline-hr-min") options.analyzer.baseline.heartRateMin = atof(value);
+        else if (option == "--baseline-hr-max") options.analyzer.baseline.heartRateMax = atof(value);
+        else if (option == "--baseline-spo2-min") options.analyzer.baseline.spO2Min = atof(value);
+        else if (option == "--repetitions") options.repetitions = atoi(value);
+        else if (option == "--generate") options.generateDir = value;
+        else if (option == "--sessions") options.sessions = atoi(value);
+        else if (option == "--minutes") options.minutes = atof(value);
+        else usage();
+    }
+    if (!options.generateDir.empty()) paths.push_back(options.generateDir);
+    if (paths.empty() || options.threads <= 0 || options.repetitions <= 0 || options.analyzer.rate <= 0 ||
+        options.analyzer.intervalMs < 1000 || options.sessions <= 0 || options.minutes <= 0) {
+        usage();
+    }
+
+    if (!options.generateDir.empty() && !generateSessions(options)) return 1;
+    std::vector<Input> inputs;
+    if (!collectInputs(paths, inputs)) return 1;
+    if (inputs.empty()) {
+        fprintf(stderr, "No recordings found\n");
+        return 1;
+    }
+    if (!options.analyzer.outDir.empty()) mkdir(options.analyzer.outDir.c_str(), 0755);
+
+    std::vector<SessionSummary> summaries;
+    std::vector<ScalingPoint> scaling;
+    BatchRun run;
+    if (options.bench) {
+        // Outputs would time the disk, not the analysis; the first run
+        // brings the recordings into the page cache
+        AnalyzerOptions quiet = options.analyzer;
+        quiet.outDir.clear();
+        runBatch(inputs, quiet, options.threads, summaries);
+        std::vector<int> counts;
+        for (int t = 1; t < options.threads; t *= 2) counts.push_back(t);
+        counts.push_back(options.threads);
+        printf("threads   wall s    M samples/s  speedup  efficiency  steals\n");
+        for (int t : counts) {
+            std::vector<double> times;
+            for (int r = 0; r < options.repetitions; r++) {
+                run = runBatch(inputs, quiet, t, summaries);
+                times.push_back(run.wallSeconds);
+            }
+            std::sort(times.begin(), times.end());
+            scaling.push_back({t, times[times.size() / 2]});
+            size_t samples = 0;
+            for (const SessionSummary& s : summaries) samples += s.samples;
+            double wall = scaling.back().wallSeconds;
+            double speedup = wall > 0 ? scaling[0].wallSeconds / wall : 0;
+            printf("%7d %8.3f %14.2f %8.2f %11.2f %7llu\n", t, wall, wall > 0 ? samples / wall / 1e6 : 0.0, speedup,
+                   speedup / t, (unsigned long long)run.steals);
+        }
+    }
+    if (!options.bench || !options.analyzer.outDir.empty()) {
+        run = runBatch(inputs, options.analyzer, options.threads, summaries);
+    }
+
+    size_t samples = 0;
+    double recorded = 0;
+    int failures = 0;
+    for (const SessionSummary& s : summaries) {
+        if (!options.bench) printSummary(s);
+        if (!s.error.empty()) failures++;
+        samples += s.samples;
+        recorded += s.recordedSeconds;
+    }
+    printf("total: %zu files, %zu samples (%.1f h) in %.3f s on %d threads: %.2f M samples/s, %.0fx real time, "
+           "%llu stolen\n",
+           inputs.size(), samples, recorded / 3600, run.wallSeconds, options.threads,
+           run.wallSeconds > 0 ? samples / run.wallSeconds / 1e6 : 0.0,
+           run.wallSeconds > 0 ? recorded / run.wallSeconds : 0.0, (unsigned long long)run.steals);
+    if (failures) fprintf(stderr, "%d of %zu files failed\n", failures, inputs.size());
+
+    if (!options.reportPath.empty() &&
+        !writeReport(options.reportPath, options, options.threads, run, summaries, scaling)) {
+        fprintf(stderr, "Could not write %s\n", options.reportPath.c_str());
+        return 1;
+    }
+    return failures ? 1 : 0;
+}
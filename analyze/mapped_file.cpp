@@ -0,0 +1,54 @@
+// Read-only file maps; see mapped_file.h
+#include "mapped_file.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const uint8_t EMPTY[1] = {0};
+
+MappedFile::MappedFile() : base(EMPTY), length(0) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        int saved = errno;
+        ::close(fd);
+        errno = saved;
+        return false;
+    }
+    if (!S_ISREG(info.st_mode)) {
+        ::close(fd);
+        errno = EISDIR;
+        return false;
+    }
+    if (info.st_size > 0) {
+        void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            int saved = errno;
+            ::close(fd);
+            errno = saved;
+            return false;
+        }
+        // Parsed front to back, once
+        madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+        base = (const uint8_t*)mapped;
+        length = info.st_size;
+    }
+    ::close(fd);
+    return true;
+}
+
+void MappedFile::close() {
+    if (length > 0) munmap((void*)base, length);
+    base = EMPTY;
+    length = 0;
+}
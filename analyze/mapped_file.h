@@ -0,0 +1,33 @@
+#ifndef ANALYZE_MAPPED_FILE_H
+#define ANALYZE_MAPPED_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// A whole file as a read-only memory map, for as long as the object lives.
+// The pages come straight from the page cache, so parsing a recording
+// copies nothing; the map is not NUL-terminated, so parsers go by end().
+
+class MappedFile {
+private:
+    const uint8_t* base;
+    size_t length;
+
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Maps `path`, dropping any earlier map; an empty file maps to no bytes.
+    // Returns false with errno set if it cannot be read.
+    bool open(const std::string& path);
+    void close();
+
+    const uint8_t* data() const { return base; }
+    const uint8_t* end() const { return base + length; }
+    size_t size() const { return length; }
+};
+
+#endif
@@ -0,0 +1,446 @@
+// Offline analysis of recorded sessions; see session_analyzer.h
+#include "session_analyzer.h"
+#include <ctype.h>
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include "../vitals_log.h"
+
+// ==================== CLOCK ====================
+static thread_local uint32_t sampleTimeMs = 0;
+
+SessionClock sessionClock;
+
+uint32_t SessionClock::millis() {
+    return sampleTimeMs;
+}
+
+uint32_t SessionClock::micros() {
+    return sampleTimeMs * 1000;
+}
+
+void SessionClock::delay(uint32_t ms) {
+    sampleTimeMs += ms;
+}
+
+void SessionClock::set(uint32_t ms) {
+    sampleTimeMs = ms;
+}
+
+// ==================== STATISTICS ====================
+void SessionAnalyzer::Stats::add(double value) {
+    if (count == 0) {
+        min = max = value;
+    } else {
+        min = std::min(min, (float)value);
+        max = std::max(max, (float)value);
+    }
+    count++;
+    double delta = value - mean;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+}
+
+double SessionAnalyzer::Stats::sd() const {
+    return count > 1 ? sqrt(m2 / (count - 1)) : 0;
+}
+
+void SessionAnalyzer::Hrv::add(uint32_t interval) {
+    if (lastRr > 0) {
+        double diff = (double)interval - lastRr;
+        squaredDiffs += diff * diff;
+        diffs++;
+    }
+    lastRr = interval;
+    rr.add(interval);
+}
+
+// ==================== SESSION ====================
+SessionAnalyzer::SessionAnalyzer(const AnalyzerOptions& options) : options(options) {
+    timeline.reserve(24 * 60);
+    alarms.reserve(256);
+    begin();
+}
+
+void SessionAnalyzer::begin() {
+    // Fresh monitor objects, so a file's results do not depend on what the
+    // worker analysed before it
+    estimator = PpgEstimator();
+    rules = AlarmRules();
+    baselineRules = AlarmRules();
+    vitals = VitalSigns();
+    vitals.batteryLevel = 100;  // Recordings carry no battery level
+
+    samples = 0;
+    firstTime = lastTime = 0;
+    lastAlarmCheck = 0;
+    windowFill = 0;
+    coveredSamples = 0;
+    heartRate.clear();
+    spO2.clear();
+    hrv.clear();
+    memset(baselineCounts, 0, sizeof(baselineCounts));
+    timeline.clear();
+    alarms.clear();
+}
+
+void SessionAnalyzer::openInterval(uint32_t start) {
+    interval.start = start;
+    interval.samples = 0;
+    interval.covered = 0;
+    interval.heartRate.clear();
+    interval.spO2.clear();
+    interval.hrv.clear();
+    interval.beats = 0;
+    interval.alarms = 0;
+    interval.baselineAlarms = 0;
+}
+
+void SessionAnalyzer::closeInterval() {
+    TimelineRow row;
+    row.start = interval.start - firstTime;
+    row.heartRate = interval.heartRate.mean;
+    row.heartRateMin = interval.heartRate.min;
+    row.heartRateMax = interval.heartRate.max;
+    row.spO2 = interval.spO2.mean;
+    row.spO2Min = interval.spO2.min;
+    row.coverage = interval.samples ? (float)interval.covered / interval.samples : 0;
+    row.beats = interval.beats;
+    row.rrMean = interval.hrv.rr.mean;
+    row.sdnn = interval.hrv.rr.sd();
+    row.rmssd = interval.hrv.rmssd();
+    row.alarms = interval.alarms;
+    row.baselineAlarms = interval.baselineAlarms;
+    timeline.push_back(row);
+}
+
+uint32_t SessionAnalyzer::advance(uint32_t now) {
+    if (samples == 0) {
+        firstTime = lastTime = now;
+        openInterval(now);
+    }
+    // A clock that steps back is taken as standing still
+    if (now < lastTime) now = lastTime;
+    while (now - interval.start >= options.intervalMs) {
+        uint32_t next = interval.start + options.intervalMs;
+        closeInterval();
+        openInterval(next);
+    }
+    lastTime = now;
+    samples++;
+    interval.samples++;
+    return now;
+}
+
+void SessionAnalyzer::checkAlarms(uint32_t now) {
+    // Once a second, as in loop()
+    if (now - lastAlarmCheck < 1000) return;
+    lastAlarmCheck = now;
+    AlarmEvent alarm;
+    if (rules.check(vitals, options.thresholds, now, alarm)) {
+        alarms.push_back(alarm);
+        interval.alarms++;
+    }
+    if (baselineRules.check(vitals, options.baseline, now, alarm)) {
+        baselineCounts[(int)alarm.kind]++;
+        interval.baselineAlarms++;
+    }
+}
+
+// RR intervals are only taken between valleys of one window, the ones the
+// estimator averages; across windows a valley at the edge may be missed
+void SessionAnalyzer::addBeats() {
+    int32_t locs[PPG_MAX_VALLEYS], count;
+    findPpgValleys(windowIr, locs, count);
+    hrv.lastRr = 0;
+    interval.hrv.lastRr = 0;
+    for (int32_t k = 0; k < count; k++) {
+        interval.beats++;
+        if (k == 0) continue;
+        uint32_t rr = windowTime[locs[k]] - windowTime[locs[k - 1]];
+        if (rr >= RR_MIN_MS && rr <= RR_MAX_MS) {
+            hrv.add(rr);
+            interval.hrv.add(rr);
+        } else {
+            // RMSSD only takes differences between adjacent accepted intervals
+            hrv.lastRr = 0;
+            interval.hrv.lastRr = 0;
+        }
+    }
+}
+
+void SessionAnalyzer::addSample(uint32_t now, uint32_t red, uint32_t ir) {
+    now = advance(now);
+    SessionClock::set(now);
+    vitals.timestamp = now;
+    windowIr[windowFill] = ir;
+    windowTime[windowFill] = now;
+    windowFill = (windowFill + 1) % PpgEstimator::WINDOW_SAMPLES;
+    if (estimator.addSample(red, ir, vitals) && vitals.isFingerDetected) addBeats();
+
+    // What the screen shows after this sample
+    if (vitals.isFingerDetected && vitals.heartRate > 0) {
+        coveredSamples++;
+        interval.covered++;
+        heartRate.add(vitals.heartRate);
+        interval.heartRate.add(vitals.heartRate);
+        if (vitals.spO2 > 0) {
+            spO2.add(vitals.spO2);
+            interval.spO2.add(vitals.spO2);
+        }
+    }
+
+    checkAlarms(now);
+}
+
+void SessionAnalyzer::addVitals(const VitalSigns& reading) {
+    uint32_t now = advance(reading.timestamp);
+    vitals = reading;
+    vitals.timestamp = now;
+    if (vitals.isFingerDetected && vitals.heartRate > 0) {
+        coveredSamples++;
+        interval.covered++;
+        heartRate.add(vitals.heartRate);
+        interval.heartRate.add(vitals.heartRate);
+        if (vitals.spO2 > 0) {
+            spO2.add(vitals.spO2);
+            interval.spO2.add(vitals.spO2);
+        }
+    }
+    checkAlarms(now);
+}
+
+void SessionAnalyzer::finish(SessionSummary& summary) {
+    if (samples > 0) closeInterval();
+    summary.samples = samples;
+    summary.recordedSeconds = (lastTime - firstTime) / 1000.0;
+    summary.heartRateMean = heartRate.mean;
+    summary.heartRateMin = heartRate.min;
+    summary.heartRateMax = heartRate.max;
+    summary.spO2Mean = spO2.mean;
+    summary.spO2Min = spO2.min;
+    summary.coverage = samples ? (float)coveredSamples / samples : 0;
+    summary.rrIntervals = hrv.rr.count;
+    summary.sdnn = hrv.rr.sd();
+    summary.rmssd = hrv.rmssd();
+    summary.beats = 0;
+    for (const TimelineRow& row : timeline) summary.beats += row.beats;
+    for (const AlarmEvent& alarm : alarms) {
+        summary.alarms[(int)alarm.kind]++;
+        if (alarm.level == AlertLevel::CRITICAL) summary.criticalAlarms++;
+    }
+    memcpy(summary.baselineAlarms, baselineCounts, sizeof(baselineCounts));
+    summary.timelineRows = timeline.size();
+}
+
+// ==================== PARSING ====================
+// The map has no terminating NUL, so numbers are read within [p, end)
+// rather than with strtoul and friends. Returns false for an empty field.
+static bool parseNumber(const char* p, const char* end, double& value) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) end--;
+    if (p == end) return false;
+    bool negative = *p == '-';
+    if (*p == '-' || *p == '+') p++;
+    double result = 0;
+    while (p < end && *p >= '0' && *p <= '9') result = result * 10 + (*p++ - '0');
+    if (p < end && *p == '.') {
+        double scale = 0.1;
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++, scale *= 0.1) result += (*p - '0') * scale;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool negativeExponent = p < end && *p == '-';
+        if (p < end && (*p == '-' || *p == '+')) p++;
+        int exponent = 0;
+        while (p < end && *p >= '0' && *p <= '9') exponent = exponent * 10 + (*p++ - '0');
+        result *= pow(10.0, negativeExponent ? -exponent : exponent);
+    }
+    value = negative ? -result : result;
+    return true;
+}
+
+bool SessionAnalyzer::parseCsv(std::string& error) {
+    // The columns bench/replay.cpp reads; the reference labels are not needed
+    enum Column { TIME, RED, IR, IGNORED };
+    static const int MAX_COLUMNS = 32;
+    Column columns[MAX_COLUMNS];
+    int columnCount = 0;
+    bool hasTime = false, hasRed = false, hasIr = false;
+
+    const char* p = (const char*)file.data();
+    const char* end = (const char*)file.end();
+    size_t row = 0;
+
+    while (p < end) {
+        const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+        if (!lineEnd) lineEnd = end;
+        if (*p == '#' || *p == '\r' || p == lineEnd) {
+            p = lineEnd + 1;
+            continue;
+        }
+
+        if (columnCount == 0) {
+            // Header row
+            for (const char* field = p; field <= lineEnd && columnCount < MAX_COLUMNS;) {
+                const char* fieldEnd = field;
+                while (fieldEnd < lineEnd && *fieldEnd != ',') fieldEnd++;
+                const char* a = field;
+                const char* b = fieldEnd;
+                while (a < b && isspace((unsigned char)*a)) a++;
+                while (b > a && isspace((unsigned char)b[-1])) b--;
+                std::string name(a, b);
+                for (char& c : name) c = tolower((unsigned char)c);
+
+                Column column = IGNORED;
+                if (name == "t_ms" || name == "time_ms" || name == "timestamp") column = TIME, hasTime = true;
+                else if (name == "red") column = RED, hasRed = true;
+                else if (name == "ir") column = IR, hasIr = true;
+                columns[columnCount++] = column;
+                field = fieldEnd + 1;
+            }
+            if (!hasRed || !hasIr) {
+                error = "header needs red and ir columns";
+                return false;
+            }
+            p = lineEnd + 1;
+            continue;
+        }
+
+        uint32_t time = hasTime ? 0 : (uint32_t)(row * 1000.0 / options.rate);
+        uint32_t red = 0, ir = 0;
+        for (int c = 0; c < columnCount && p <= lineEnd; c++) {
+            const char* fieldEnd = p;
+            while (fieldEnd < lineEnd && *fieldEnd != ',') fieldEnd++;
+            double value;
+            if (columns[c] != IGNORED && parseNumber(p, fieldEnd, value)) {
+                switch (columns[c]) {
+                    case TIME: time = (uint32_t)value; break;
+                    case RED: red = (uint32_t)value; break;
+                    case IR: ir = (uint32_t)value; break;
+                    default: break;
+                }
+            }
+            p = fieldEnd + 1;
+        }
+
+        addSample(time, red, ir);
+        row++;
+        p = lineEnd + 1;
+    }
+
+    if (row == 0) {
+        error = "no samples";
+        return false;
+    }
+    return true;
+}
+
+bool SessionAnalyzer::parseVitalsLog(std::string& error) {
+    size_t count = file.size() / sizeof(VitalsRecord);
+    if (count == 0) {
+        error = "no records";
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        VitalsRecord record;
+        memcpy(&record, file.data() + i * sizeof(VitalsRecord), sizeof(record));
+        addVitals(VitalsLog::toVitalSigns(record));
+    }
+    return true;
+}
+
+// ==================== OUTPUT ====================
+static void writeJsonString(FILE* out, const std::string& text) {
+    fputc('"', out);
+    for (char c : text) {
+        if (c == '"' || c == '\\') fprintf(out, "\\%c", c);
+        else if ((unsigned char)c < 0x20) fprintf(out, "\\u%04x", c);
+        else fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+void writeSummaryJson(FILE* out, const SessionSummary& s) {
+    fprintf(out, "\"path\":");
+    writeJsonString(out, s.path);
+    if (!s.error.empty()) {
+        fprintf(out, ",\"error\":");
+        writeJsonString(out, s.error);
+        return;
+    }
+    fprintf(out, ",\"waveform\":%s,\"worker\":%d,\"samples\":%zu,\"recordedSeconds\":%.3f,\"wallSeconds\":%.6f,",
+            s.waveform ? "true" : "false", s.worker, s.samples, s.recordedSeconds, s.wallSeconds);
+    fprintf(out, "\"heartRate\":{\"mean\":%.2f,\"min\":%.1f,\"max\":%.1f},\"spO2\":{\"mean\":%.2f,\"min\":%.1f},"
+                 "\"coverage\":%.4f,",
+            s.heartRateMean, s.heartRateMin, s.heartRateMax, s.spO2Mean, s.spO2Min, s.coverage);
+    fprintf(out, "\"beats\":%u,\"hrv\":{\"rrIntervals\":%u,\"sdnnMs\":%.1f,\"rmssdMs\":%.1f},",
+            s.beats, s.rrIntervals, s.sdnn, s.rmssd);
+    fprintf(out, "\"alarms\":{\"heart_rate\":%u,\"spo2\":%u,\"battery\":%u,\"critical\":%u},",
+            s.alarms[0], s.alarms[1], s.alarms[2], s.criticalAlarms);
+    fprintf(out, "\"baselineAlarms\":{\"heart_rate\":%u,\"spo2\":%u,\"battery\":%u},\"timelineRows\":%u",
+            s.baselineAlarms[0], s.baselineAlarms[1], s.baselineAlarms[2], s.timelineRows);
+}
+
+bool SessionAnalyzer::writeTimeline(const std::string& path) const {
+    FILE* out = fopen(path.c_str(), "w");
+    if (!out) return false;
+    fprintf(out, "t_s,hr,hr_min,hr_max,spo2,spo2_min,coverage,beats,rr_ms,sdnn_ms,rmssd_ms,alarms,baseline_alarms\n");
+    for (const TimelineRow& row : timeline) {
+        fprintf(out, "%.0f,%.1f,%.0f,%.0f,%.1f,%.0f,%.3f,%u,%.0f,%.1f,%.1f,%u,%u\n", row.start / 1000.0,
+                row.heartRate, row.heartRateMin, row.heartRateMax, row.spO2, row.spO2Min, row.coverage, row.beats,
+                row.rrMean, row.sdnn, row.rmssd, row.alarms, row.baselineAlarms);
+    }
+    return fclose(out) == 0;
+}
+
+bool SessionAnalyzer::writeSummary(const std::string& path, const SessionSummary& summary) const {
+    FILE* out = fopen(path.c_str(), "w");
+    if (!out) return false;
+    const AlertThresholds& t = options.thresholds;
+    fprintf(out, "{");
+    writeSummaryJson(out, summary);
+    fprintf(out, ",\n\"thresholds\":{\"heartRateMin\":%.1f,\"heartRateMax\":%.1f,\"spO2Min\":%.1f,\"batteryMin\":%.1f},",
+            t.heartRateMin, t.heartRateMax, t.spO2Min, t.batteryMin);
+    fprintf(out, "\n\"alarmList\":[");
+    for (size_t i = 0; i < alarms.size(); i++) {
+        const AlarmEvent& alarm = alarms[i];
+        char message[48];
+        formatAlarmMessage(alarm, message, sizeof(message));
+        fprintf(out, "%s\n{\"t\":%u,\"kind\":\"%s\",\"level\":\"%s\",\"value\":%.1f,\"message\":\"%s\"}", i ? "," : "",
+                alarm.timestamp - firstTime, alarmKindName(alarm.kind),
+                alarm.level == AlertLevel::CRITICAL ? "critical" : "warning", alarm.value, message);
+    }
+    fprintf(out, "\n]}\n");
+    return fclose(out) == 0;
+}
+
+// ==================== ANALYSIS ====================
+static bool endsWith(const std::string& text, const char* suffix) {
+    size_t length = strlen(suffix);
+    return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+void SessionAnalyzer::analyze(const std::string& path, const std::string& name, SessionSummary& summary) {
+    auto start = std::chrono::steady_clock::now();
+    summary = SessionSummary();
+    summary.path = path;
+    begin();
+    if (!file.open(path)) {
+        summary.error = strerror(errno);
+        return;
+    }
+    summary.waveform = !endsWith(path, ".bin");
+    bool parsed = summary.waveform ? parseCsv(summary.error) : parseVitalsLog(summary.error);
+    file.close();
+    if (!parsed) return;
+    finish(summary);
+    summary.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (options.outDir.empty()) return;
+    std::string base = options.outDir + "/" + name;
+    if (!writeTimeline(base + ".timeline.csv") || !writeSummary(base + ".json", summary)) {
+        summary.error = "cannot write " + base + ": " + strerror(errno);
+    }
+}
@@ -0,0 +1,206 @@
+#ifndef ANALYZE_SESSION_ANALYZER_H
+#define ANALYZE_SESSION_ANALYZER_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "../hal.h"
+#include "../vitals_pipeline.h"
+#include "mapped_file.h"
+
+// Offline analysis of one recorded session with the monitor's own code:
+// samples go through PpgEstimator, on the MAX3010x library's estimator, as
+// the sketch feeds them, and the alarm rules are run once a second twice
+// over, with the thresholds being evaluated and with the ones the recording
+// was taken under. Beats are the IR valleys the estimator times the heart
+// rate by (findPpgValleys()). The result is a timeline of the displayed
+// heart rate and SpO2, beat-to-beat HRV and alarms per interval, and a
+// summary of the session.
+//
+// Input is what bench/replay.cpp reads: CSV waveforms (t_ms, red, ir; an
+// ecg column is ignored) and .bin vitals log segments, which have no waveform and
+// so only give the timeline and the alarms. Files are parsed straight out
+// of a memory map and fed sample by sample; an analyzer keeps its buffers
+// from file to file, so once warmed up it allocates per interval and per
+// alarm, never per sample.
+
+// ==================== CLOCK ====================
+// millis() for the monitor code: the time of the sample being analysed,
+// per thread, so one analyzer per worker runs without interference.
+// analyze.cpp installs it as hal.clock.
+class SessionClock : public HalClock {
+public:
+    uint32_t millis() override;
+    uint32_t micros() override;
+    void delay(uint32_t ms) override;
+    static void set(uint32_t ms);
+};
+
+extern SessionClock sessionClock;
+
+// ==================== RESULTS ====================
+// One --interval of the recording. Vitals are what the screen showed,
+// averaged over the samples it showed a reading; HRV is over the RR
+// intervals between beats in the same estimator window that pass the
+// plausibility check. Beats count in the interval their window ends in.
+struct TimelineRow {
+    uint32_t start;             // ms from the start of the recording
+    float heartRate;            // 0 if no reading in the interval
+    float heartRateMin;
+    float heartRateMax;
+    float spO2;
+    float spO2Min;
+    float coverage;             // Fraction of the interval with a reading
+    uint32_t beats;
+    float rrMean;               // ms; 0 with fewer than two beats
+    float sdnn;
+    float rmssd;
+    uint16_t alarms;            // Under the evaluated thresholds
+    uint16_t baselineAlarms;    // Under the recording's own
+};
+
+struct SessionSummary {
+    std::string path;
+    std::string error;          // Empty once analysed
+    bool waveform = false;      // False for a vitals log
+    int worker = -1;
+    size_t samples = 0;
+    double recordedSeconds = 0;
+    double wallSeconds = 0;
+
+    float heartRateMean = 0;
+    float heartRateMin = 0;
+    float heartRateMax = 0;
+    float spO2Mean = 0;
+    float spO2Min = 0;
+    float coverage = 0;
+    uint32_t beats = 0;
+    uint32_t rrIntervals = 0;   // Accepted into HRV
+    float sdnn = 0;             // ms, whole session
+    float rmssd = 0;
+
+    uint32_t alarms[ALARM_KIND_COUNT] = {};
+    uint32_t criticalAlarms = 0;
+    uint32_t baselineAlarms[ALARM_KIND_COUNT] = {};
+    uint32_t timelineRows = 0;
+
+    uint32_t alarmCount() const { return alarms[0] + alarms[1] + alarms[2]; }
+    uint32_t baselineAlarmCount() const { return baselineAlarms[0] + baselineAlarms[1] + baselineAlarms[2]; }
+};
+
+struct AnalyzerOptions {
+    AlertThresholds thresholds;     // Being evaluated
+    AlertThresholds baseline;       // The recordings were taken under
+    float rate = 25.0f;             // CSV files without t_ms
+    uint32_t intervalMs = 60000;
+    std::string outDir;             // Per-file timeline and summary; none if empty
+};
+
+// ==================== ANALYZER ====================
+class SessionAnalyzer {
+public:
+    // RR intervals outside 30 .. 200 BPM are detection artifacts
+    static const uint32_t RR_MIN_MS = 300;
+    static const uint32_t RR_MAX_MS = 2000;
+
+private:
+    // Running mean, min, max and variance
+    struct Stats {
+        uint64_t count;
+        double mean;
+        double m2;
+        float min;
+        float max;
+
+        void clear() { count = 0, mean = 0, m2 = 0, min = 0, max = 0; }
+        void add(double value);
+        double sd() const;
+    };
+
+    // Beat-to-beat intervals, for SDNN and RMSSD
+    struct Hrv {
+        Stats rr;
+        double squaredDiffs;
+        uint32_t diffs;
+        uint32_t lastRr;
+
+        void clear() { rr.clear(), squaredDiffs = 0, diffs = 0, lastRr = 0; }
+        void add(uint32_t interval);
+        float rmssd() const { return diffs ? sqrt(squaredDiffs / diffs) : 0; }
+    };
+
+    struct Interval {
+        uint32_t start;
+        uint32_t samples;
+        uint32_t covered;
+        Stats heartRate;
+        Stats spO2;
+        Hrv hrv;
+        uint32_t beats;
+        uint16_t alarms;
+        uint16_t baselineAlarms;
+    };
+
+    const AnalyzerOptions& options;
+    MappedFile file;
+    PpgEstimator estimator;
+    AlarmRules rules;
+    AlarmRules baselineRules;
+    VitalSigns vitals;
+
+    // Whole-session state
+    size_t samples;
+    uint32_t firstTime;
+    uint32_t lastTime;
+    uint32_t lastAlarmCheck;
+    uint64_t coveredSamples;
+    Stats heartRate;
+    Stats spO2;
+    Hrv hrv;
+    Interval interval;
+    uint32_t baselineCounts[ALARM_KIND_COUNT];
+
+    // The estimator's window, again, for the valleys in it
+    uint32_t windowIr[PpgEstimator::WINDOW_SAMPLES];
+    uint32_t windowTime[PpgEstimator::WINDOW_SAMPLES];
+    int windowFill;
+
+    // Kept from file to file
+    std::vector<TimelineRow> timeline;
+    std::vector<AlarmEvent> alarms;
+
+    void begin();
+    void openInterval(uint32_t start);
+    void closeInterval();
+    // Moves time on to `now`, closing intervals on the way; returns the
+    // time used, which never goes backwards
+    uint32_t advance(uint32_t now);
+    void checkAlarms(uint32_t now);
+    void addSample(uint32_t now, uint32_t red, uint32_t ir);
+    void addBeats();
+    void addVitals(const VitalSigns& reading);
+    void finish(SessionSummary& summary);
+
+    bool parseCsv(std::string& error);
+    bool parseVitalsLog(std::string& error);
+    bool writeTimeline(const std::string& path) const;
+    bool writeSummary(const std::string& path, const SessionSummary& summary) const;
+
+public:
+    explicit SessionAnalyzer(const AnalyzerOptions& options);
+
+    // Analyses `path` into `summary`; with options.outDir set, also writes
+    // <outDir>/<name>.timeline.csv and <outDir>/<name>.json. Errors end up
+    // in summary.error.
+    void analyze(const std::string& path, const std::string& name, SessionSummary& summary);
+
+    const std::vector<TimelineRow>& getTimeline() const { return timeline; }
+    const std::vector<AlarmEvent>& getAlarms() const { return alarms; }
+};
+
+// Writes the summary's fields as the members of a JSON object, no braces
+void writeSummaryJson(FILE* out, const SessionSummary& summary);
+
+#endif
@@ -0,0 +1,47 @@
+// Batch thread pool with per-worker queues; see work_stealing_pool.h
+#include "work_stealing_pool.h"
+#include <thread>
+
+WorkStealingPool::WorkStealingPool(int threads) : threadCount(threads > 0 ? threads : 1), steals(0) {
+    for (int i = 0; i < threadCount; i++) queues.emplace_back(new Queue());
+}
+
+bool WorkStealingPool::take(int worker, size_t& task) {
+    Queue& queue = *queues[worker];
+    std::lock_guard<std::mutex> guard(queue.lock);
+    if (queue.tasks.empty()) return false;
+    task = queue.tasks.front();
+    queue.tasks.pop_front();
+    return true;
+}
+
+bool WorkStealingPool::steal(int worker, size_t& task) {
+    // Start with the next worker along, so thieves spread over the victims
+    for (int i = 1; i < threadCount; i++) {
+        Queue& victim = *queues[(worker + i) % threadCount];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (victim.tasks.empty()) continue;
+        task = victim.tasks.back();
+        victim.tasks.pop_back();
+        steals++;
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::work(int worker, const Task& task) {
+    // Nothing is queued once the batch has started, so empty everywhere
+    // means done
+    size_t next;
+    while (take(worker, next) || steal(worker, next)) task(worker, next);
+}
+
+void WorkStealingPool::run(size_t count, const Task& task) {
+    steals = 0;
+    for (size_t i = 0; i < count; i++) queues[i % threadCount]->tasks.push_back(i);
+
+    std::vector<std::thread> threads;
+    for (int w = 1; w < threadCount; w++) threads.emplace_back([this, w, &task] { work(w, task); });
+    work(0, task);
+    for (std::thread& thread : threads) thread.join();
+}
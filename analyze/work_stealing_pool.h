@@ -0,0 +1,55 @@
+#ifndef ANALYZE_WORK_STEALING_POOL_H
+#define ANALYZE_WORK_STEALING_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Runs a batch of independent tasks on a fixed number of threads. Each
+// worker has its own queue, dealt round robin in task order, and takes from
+// the front of it; a worker whose queue runs dry steals from the back of
+// the others'. Put the costliest tasks first: they are started early, and
+// what is stolen at the end is the small stuff, so the batch finishes
+// together even when one file is ten times the size of the rest.
+//
+// A queue's lock is only contended while a thief is at it, which is once
+// per stolen task, so the pool costs nothing next to a task that reads a
+// recording.
+
+class WorkStealingPool {
+public:
+    // `worker` is 0 .. threads - 1, for per-worker state
+    typedef std::function<void(int worker, size_t task)> Task;
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<size_t> tasks;
+    };
+
+    int threadCount;
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::atomic<uint64_t> steals;
+
+    bool take(int worker, size_t& task);
+    bool steal(int worker, size_t& task);
+    void work(int worker, const Task& task);
+
+public:
+    explicit WorkStealingPool(int threads);
+
+    // Runs tasks 0 .. count - 1 and returns when all are done. The calling
+    // thread is worker 0.
+    void run(size_t count, const Task& task);
+
+    int getThreadCount() const { return threadCount; }
+    // Tasks that ran on a worker other than the one dealt them, last run
+    uint64_t getSteals() const { return steals.load(); }
+};
+
+#endif
@@ -20,7 +20,8 @@ class CardiacMonitorDashboard {
     
     setupWebSocket() {
         const protocol = window.location.protocol === 'https:' ? 'wss:' : 'ws:';
-        const wsUrl = `${protocol}//${window.location.host}/ws`;
+        // The feed is its own server on port 81 (web_interface.h)
+        const wsUrl = `${protocol}//${window.location.hostname}:81/ws`;
         
         this.websocket = new WebSocket(wsUrl);
         
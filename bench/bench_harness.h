@@ -0,0 +1,280 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+/*
+ * Minimal micro-benchmark harness for the host benchmarks in bench/.
+ *
+ * Benchmarks are written the way Google Benchmark spells them, so moving
+ * to the real library later is a matter of swapping this include:
+ *
+ *   static void BM_Thing(BenchState& state) {
+ *       for (auto _ : state) benchDoNotOptimize(thing());
+ *       state.setItemsProcessed(state.iterations());
+ *   }
+ *   BENCHMARK(BM_Thing);
+ *
+ * Each benchmark is calibrated until one run lasts --min-time, then run
+ * --repetitions times; the median is reported. --json writes the results
+ * in Google Benchmark's JSON layout, and --baseline compares against such
+ * a file and fails when anything slowed down by more than --threshold.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+// ==================== STATE ====================
+class BenchState {
+private:
+    uint64_t target;
+    uint64_t done;
+    double itemsProcessed;
+    double bytesProcessed;
+
+public:
+    explicit BenchState(uint64_t iterations)
+        : target(iterations), done(0), itemsProcessed(0), bytesProcessed(0) {}
+
+    // Range-for support: `for (auto _ : state)` runs the body target times.
+    // Value has a destructor so the unused loop variable draws no warning.
+    struct Value {
+        ~Value() {}
+    };
+    struct Iterator {
+        BenchState* state;
+        bool operator!=(const Iterator&) const { return state->done < state->target; }
+        void operator++() { state->done++; }
+        Value operator*() const { return Value(); }
+    };
+    Iterator begin() { return Iterator{this}; }
+    Iterator end() { return Iterator{this}; }
+
+    uint64_t iterations() const { return target; }
+    void setItemsProcessed(double items) { itemsProcessed = items; }
+    void setBytesProcessed(double bytes) { bytesProcessed = bytes; }
+    double getItemsProcessed() const { return itemsProcessed; }
+    double getBytesProcessed() const { return bytesProcessed; }
+};
+
+template <typename T>
+inline void benchDoNotOptimize(T&& value) {
+    asm volatile("" : : "g"(value) : "memory");
+}
+
+inline void benchClobberMemory() {
+    asm volatile("" : : : "memory");
+}
+
+// ==================== REGISTRY ====================
+typedef void (*BenchFunction)(BenchState&);
+
+struct BenchEntry {
+    const char* name;
+    BenchFunction function;
+};
+
+inline std::vector<BenchEntry>& benchRegistry() {
+    static std::vector<BenchEntry> entries;
+    return entries;
+}
+
+inline int benchRegister(const char* name, BenchFunction function) {
+    benchRegistry().push_back({name, function});
+    return 0;
+}
+
+#define BENCH_CONCAT_(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_(a, b)
+#define BENCHMARK(function) \
+    static int BENCH_CONCAT(benchRegistered_, __LINE__) = benchRegister(#function, function)
+
+// ==================== RUNNER ====================
+struct BenchResult {
+    std::string name;
+    uint64_t iterations;
+    double realNs;          // Per iteration, median of the repetitions
+    double cpuNs;
+    double itemsPerSecond;
+    double bytesPerSecond;
+};
+
+struct BenchOptions {
+    std::string filter;
+    double minTime = 0.2;
+    int repetitions = 3;
+    std::string jsonPath;
+    std::string baselinePath;
+    double threshold = 10.0;  // Percent
+};
+
+inline double benchCpuSeconds() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+inline BenchResult benchRun(const BenchEntry& entry, const BenchOptions& options) {
+    // Grow the iteration count until a run lasts minTime
+    uint64_t iterations = 1;
+    for (;;) {
+        BenchState state(iterations);
+        auto start = std::chrono::steady_clock::now();
+        entry.function(state);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (seconds >= options.minTime || iterations >= 1000000000ULL) break;
+        double scale = seconds > 0 ? options.minTime * 1.4 / seconds : 10;
+        iterations = (uint64_t)(iterations * std::min(std::max(scale, 2.0), 10.0));
+    }
+
+    std::vector<double> real, cpu, items, bytes;
+    for (int r = 0; r < options.repetitions; r++) {
+        BenchState state(iterations);
+        double cpuStart = benchCpuSeconds();
+        auto start = std::chrono::steady_clock::now();
+        entry.function(state);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double cpuSeconds = benchCpuSeconds() - cpuStart;
+        real.push_back(seconds * 1e9 / iterations);
+        cpu.push_back(cpuSeconds * 1e9 / iterations);
+        items.push_back(seconds > 0 ? state.getItemsProcessed() / seconds : 0);
+        bytes.push_back(seconds > 0 ? state.getBytesProcessed() / seconds : 0);
+    }
+
+    auto median = [](std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+        size_t middle = values.size() / 2;
+        return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+    };
+    return {entry.name, iterations, median(real), median(cpu), median(items), median(bytes)};
+}
+
+// ==================== JSON ====================
+inline bool benchWriteJson(const std::string& path, const std::vector<BenchResult>& results) {
+    FILE* out = fopen(path.c_str(), "w");
+    if (!out) return false;
+
+    char date[32];
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    fprintf(out, "{\n  \"context\": {\n    \"date\": \"%s\",\n    \"library_build_type\": \"release\"\n  },\n", date);
+    fprintf(out, "  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        fprintf(out, "    {\n      \"name\": \"%s\",\n      \"run_type\": \"aggregate\",\n"
+                     "      \"aggregate_name\": \"median\",\n      \"iterations\": %llu,\n"
+                     "      \"real_time\": %.3f,\n      \"cpu_time\": %.3f,\n      \"time_unit\": \"ns\"",
+                r.name.c_str(), (unsigned long long)r.iterations, r.realNs, r.cpuNs);
+        if (r.itemsPerSecond > 0) fprintf(out, ",\n      \"items_per_second\": %.1f", r.itemsPerSecond);
+        if (r.bytesPerSecond > 0) fprintf(out, ",\n      \"bytes_per_second\": %.1f", r.bytesPerSecond);
+        fprintf(out, "\n    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    return fclose(out) == 0;
+}
+
+// Pulls name/real_time pairs out of a Google Benchmark JSON file. Only
+// what benchWriteJson and the real library emit needs to be understood.
+inline bool benchReadBaseline(const std::string& path, std::vector<std::pair<std::string, double>>& entries) {
+    FILE* in = fopen(path.c_str(), "r");
+    if (!in) return false;
+    std::string text;
+    char chunk[4096];
+    size_t length;
+    while ((length = fread(chunk, 1, sizeof(chunk), in)) > 0) text.append(chunk, length);
+    fclose(in);
+
+    size_t at = 0;
+    while ((at = text.find("\"name\"", at)) != std::string::npos) {
+        size_t open = text.find('"', text.find(':', at) + 1);
+        size_t close = text.find('"', open + 1);
+        if (open == std::string::npos || close == std::string::npos) break;
+        std::string name = text.substr(open + 1, close - open - 1);
+
+        size_t next = text.find("\"name\"", close);
+        size_t real = text.find("\"real_time\"", close);
+        at = close;
+        if (real == std::string::npos || (next != std::string::npos && real > next)) continue;
+        entries.push_back({name, atof(text.c_str() + text.find(':', real) + 1)});
+    }
+    return true;
+}
+
+// ==================== MAIN ====================
+inline void benchUsage() {
+    fprintf(stderr,
+        "Usage: bench [options]\n"
+        "  --filter TEXT      run only benchmarks whose name contains TEXT\n"
+        "  --min-time S       calibrate each run to at least S seconds (default 0.2)\n"
+        "  --repetitions N    runs per benchmark; the median is reported (default 3)\n"
+        "  --json FILE        write results as Google Benchmark JSON\n"
+        "  --baseline FILE    compare with an earlier --json file\n"
+        "  --threshold PCT    slowdown that counts as a regression (default 10)\n");
+    exit(2);
+}
+
+inline int benchMain(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) benchUsage();
+        const char* value = argv[++i];
+        if (option == "--filter") options.filter = value;
+        else if (option == "--min-time") options.minTime = atof(value);
+        else if (option == "--repetitions") options.repetitions = std::max(1, atoi(value));
+        else if (option == "--json") options.jsonPath = value;
+        else if (option == "--baseline") options.baselinePath = value;
+        else if (option == "--threshold") options.threshold = atof(value);
+        else benchUsage();
+    }
+
+    std::vector<std::pair<std::string, double>> baseline;
+    if (!options.baselinePath.empty() && !benchReadBaseline(options.baselinePath, baseline)) {
+        fprintf(stderr, "Could not read %s\n", options.baselinePath.c_str());
+        return 2;
+    }
+
+    printf("%-36s %14s %14s %12s", "Benchmark", "Time (ns)", "CPU (ns)", "Iterations");
+    if (!baseline.empty()) printf(" %10s", "vs base");
+    printf("\n");
+
+    std::vector<BenchResult> results;
+    int regressions = 0;
+    for (const BenchEntry& entry : benchRegistry()) {
+        if (!options.filter.empty() && !strstr(entry.name, options.filter.c_str())) continue;
+        BenchResult result = benchRun(entry, options);
+        results.push_back(result);
+
+        printf("%-36s %14.1f %14.1f %12llu", result.name.c_str(), result.realNs, result.cpuNs,
+               (unsigned long long)result.iterations);
+        for (const auto& base : baseline) {
+            if (base.first != result.name || base.second <= 0) continue;
+            double change = (result.realNs - base.second) / base.second * 100;
+            bool regressed = change > options.threshold;
+            regressions += regressed;
+            printf(" %+9.1f%%%s", change, regressed ? "  REGRESSION" : "");
+            break;
+        }
+        if (result.itemsPerSecond > 0) printf("  %.3gM items/s", result.itemsPerSecond / 1e6);
+        if (result.bytesPerSecond > 0) printf("  %.3g MB/s", result.bytesPerSecond / 1e6);
+        printf("\n");
+        fflush(stdout);
+    }
+
+    if (!options.jsonPath.empty() && !benchWriteJson(options.jsonPath, results)) {
+        fprintf(stderr, "Could not write %s\n", options.jsonPath.c_str());
+        return 2;
+    }
+    if (regressions > 0) {
+        printf("%d benchmark(s) slower than the baseline by more than %.0f%%\n", regressions, options.threshold);
+        return 1;
+    }
+    return 0;
+}
+
+#endif
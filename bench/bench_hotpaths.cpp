@@ -0,0 +1,299 @@
+/*
+ * Host micro-benchmarks for the firmware's per-sample and per-frame hot
+ * paths: beat detection, SpO2, the MAX3010x estimator, alert handling,
+ * vitals JSON, chart rendering and the profiler's and trace log's own
+ * overhead.
+ * Sources are compiled unmodified against the native shims; millis()
+ * follows the simulated clock in hal_sim.cpp.
+ *
+ *   pio run -e bench && .pio/build/bench/program --json bench/latest.json
+ *   .pio/build/bench/program --baseline bench/baseline.json --threshold 10
+ *
+ * or without PlatformIO, from the repository root:
+ *   g++ -O2 -std=gnu++17 -DARDUINO=10819 -Inative -I. -pthread -o bench_hotpaths \
+ *       bench/bench_hotpaths.cpp $(ls native/[a-z]*.cpp | grep -v -e main.cpp -e sketch.cpp) \
+ *       heartrate.cpp spo2_Algorithm.cpp alert_managr.cpp ui_elements.cpp \
+ *       http_stream.cpp wifi_manager.cpp signal_generator.cpp profiler.cpp trace_log.cpp \
+ *       memory_accounting.cpp
+ *
+ * Figures are host figures. Use them to compare revisions of the code, not
+ * to predict milliseconds on the ESP32.
+ */
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+#include "bench_harness.h"
+#include "../native/hal_sim.h"
+#include "../heartrate.h"
+#include "../spo2_Algorithm.h"
+#include <spo2_algorithm.h>          // After spo2_Algorithm.h: it #defines BUFFER_SIZE
+#include "../alert.h"
+#include "../confi.h"
+#include "../ui_elements.h"
+#include "../vital_signs.h"
+#include "../http_stream.h"
+#include "../signal_generator.h"
+#include "../profiler.h"
+#include "../trace_log.h"
+
+static const int SAMPLE_RATE = 25;        // FreqS, Hz
+static const int SIGNAL_LENGTH = 1000;    // 40 s of signal
+static const int HISTORY_ENTRIES = 100;   // DATA_BUFFER_SIZE in the firmware
+static const int CHART_POINTS = 320;      // WAVEFORM_BUFFER_SIZE
+
+// ==================== TEST SIGNALS ====================
+// Fingertip PPG at 72 BPM: a systolic peak and a dicrotic bump on a slow
+// baseline wander, plus a little deterministic noise
+static float ppgShape(int i, float rateBpm) {
+    float phase = fmodf(i * rateBpm / 60.0f / SAMPLE_RATE, 1.0f);
+    float systolic = expf(-powf((phase - 0.15f) / 0.06f, 2));
+    float dicrotic = 0.35f * expf(-powf((phase - 0.45f) / 0.08f, 2));
+    float wander = 0.1f * sinf(2 * PI * i / (SAMPLE_RATE * 8.0f));
+    float noise = 0.02f * ((i * 7919 % 101) / 50.0f - 1);
+    return systolic + dicrotic + wander + noise;
+}
+
+struct TestSignals {
+    long analog[SIGNAL_LENGTH];       // 10-bit ADC counts, for HeartRateCalculator
+    uint32_t ir[SIGNAL_LENGTH];       // MAX30102 counts
+    uint32_t red[SIGNAL_LENGTH];
+    float chart[CHART_POINTS];
+    VitalSigns history[HISTORY_ENTRIES];
+
+    TestSignals() {
+        for (int i = 0; i < SIGNAL_LENGTH; i++) {
+            float p = ppgShape(i, 72);
+            analog[i] = 450 + (long)(300 * p);
+            ir[i] = 100000 + (uint32_t)(4000 * p);
+            red[i] = 80000 + (uint32_t)(1900 * p);
+        }
+        for (int i = 0; i < CHART_POINTS; i++) {
+            chart[i] = 72 + 8 * ppgShape(i, 72);
+        }
+        for (int i = 0; i < HISTORY_ENTRIES; i++) {
+            history[i].heartRate = 70 + (i % 7) * 1.3f;
+            history[i].spO2 = 96 + (i % 3) * 0.7f;
+            history[i].batteryLevel = 85 - i * 0.05f;
+            history[i].isFingerDetected = true;
+            history[i].timestamp = 1000UL * (3600 + i * 5);
+        }
+    }
+};
+
+static const TestSignals signals;
+
+// ==================== HEART RATE ====================
+static void BM_HeartRate_CheckForBeat(BenchState& state) {
+    HeartRateCalculator calculator;
+    int i = 0;
+    for (auto _ : state) {
+        // One sample period of virtual time, so the 300 ms refractory
+        // window and the beat intervals behave as on the device
+        simClock.advance(1000000 / SAMPLE_RATE);
+        benchDoNotOptimize(calculator.checkForBeat(signals.analog[i]));
+        if (++i == SIGNAL_LENGTH) i = 0;
+    }
+    benchDoNotOptimize(calculator.getBeatsPerMinute());
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HeartRate_CheckForBeat);
+
+// ==================== SPO2 ====================
+static void BM_SpO2_AddSample(BenchState& state) {
+    SpO2Calculator calculator;
+    int i = 0;
+    for (auto _ : state) {
+        calculator.addSample(signals.ir[i], signals.red[i]);
+        benchClobberMemory();
+        if (++i == SIGNAL_LENGTH) i = 0;
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SpO2_AddSample);
+
+static void BM_SpO2_Calculate(BenchState& state) {
+    SpO2Calculator calculator;
+    for (int i = 0; i < 100; i++) {
+        calculator.addSample(signals.ir[i], signals.red[i]);
+    }
+    for (auto _ : state) {
+        benchDoNotOptimize(calculator.calculateSpO2());
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SpO2_Calculate);
+
+// One full window, BUFFER_SIZE samples, as PpgEstimator hands it over, to
+// the MAX3010x library's estimator
+static void BM_Maxim_HeartRateAndSpO2(BenchState& state) {
+    const int window = BUFFER_SIZE;
+    uint32_t ir[window], red[window];
+    int offset = 0;
+    for (auto _ : state) {
+        memcpy(ir, signals.ir + offset, sizeof(ir));
+        memcpy(red, signals.red + offset, sizeof(red));
+        int32_t spo2, heartRate;
+        int8_t spo2Valid, heartRateValid;
+        maxim_heart_rate_and_oxygen_saturation(ir, window, red, &spo2, &spo2Valid, &heartRate, &heartRateValid);
+        benchDoNotOptimize(spo2);
+        benchDoNotOptimize(heartRate);
+        offset = (offset + window) % (SIGNAL_LENGTH - window);
+    }
+    state.setItemsProcessed(state.iterations() * window);
+}
+BENCHMARK(BM_Maxim_HeartRateAndSpO2);
+
+// ==================== SIGNAL GENERATOR ====================
+// Input for the simulated board, replay and soak runs; it has to stay far
+// ahead of any consumer
+static void BM_SignalGenerator(BenchState& state) {
+    PhysiologyParams params;
+    params.motionRate = 2;
+    SignalGenerator generator(100, 7);
+    generator.setParams(params);
+    SignalSample block[256];
+    for (auto _ : state) {
+        generator.generate(block, 256);
+        benchDoNotOptimize(block[255].ir);
+    }
+    state.setItemsProcessed(state.iterations() * 256);
+}
+BENCHMARK(BM_SignalGenerator);
+
+// ==================== ALERTS ====================
+// The common case in the alert check loop: the same condition again within
+// 30 s, dropped by the duplicate scan over a full alert list
+static void BM_Alert_AddDuplicate(BenchState& state) {
+    Serial.setMuted(true);
+    AlertManager manager;
+    manager.setBuzzerEnabled(false);
+    for (int i = 0; i < 10; i++) {
+        manager.addAlert((AlertType)(ALERT_HIGH_HEART_RATE + i % 6), "High heart rate: 142 BPM");
+    }
+    String message = "Low SpO2: 88%";
+    for (auto _ : state) {
+        manager.addAlert(ALERT_LOW_SPO2, message);
+    }
+    benchDoNotOptimize(manager.getAlertCount());
+    Serial.setMuted(false);
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Alert_AddDuplicate);
+
+// A new alert every time: 30 s pass between calls, so the list is shifted
+// and the message copied and traced. The buzzer is off; its tone sequence
+// waits on delay() and measures the clock rather than the code. The trace
+// ring is drained here, amortized, instead of by its task.
+static void BM_Alert_AddNew(BenchState& state) {
+    Serial.setMuted(true);
+    traceLog.setBinary(true);
+    AlertManager manager;
+    manager.setBuzzerEnabled(false);
+    String message = "High heart rate: 142 BPM";
+    int pending = 0;
+    for (auto _ : state) {
+        simClock.advance(30001000);
+        manager.addAlert(ALERT_HIGH_HEART_RATE, message);
+        if (++pending == 64) {
+            traceLog.drain();
+            pending = 0;
+        }
+    }
+    traceLog.drain();
+    benchDoNotOptimize(manager.getAlertCount());
+    Serial.setMuted(false);
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Alert_AddNew);
+
+// ==================== JSON ====================
+static void BM_Json_VitalsMessage(BenchState& state) {
+    char buffer[256];
+    size_t bytes = 0;
+    for (auto _ : state) {
+        bytes += jsonSerialize<VitalsMessageSchema>(signals.history[7], buffer, sizeof(buffer));
+        benchClobberMemory();
+    }
+    state.setItemsProcessed(state.iterations());
+    state.setBytesProcessed(bytes);
+}
+BENCHMARK(BM_Json_VitalsMessage);
+
+static void BM_Json_VitalsMeasure(BenchState& state) {
+    for (auto _ : state) {
+        benchDoNotOptimize(jsonMeasure(signals.history[7]));
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Json_VitalsMeasure);
+
+// The whole /data body: current reading plus 100 history entries, pulled
+// through the chunked generator in sendChunked()'s 512-byte buffer
+static void BM_Json_DataBody(BenchState& state) {
+    uint8_t chunk[512];
+    size_t bytes = 0;
+    for (auto _ : state) {
+        VitalsJsonGenerator generator(signals.history[HISTORY_ENTRIES - 1], signals.history, HISTORY_ENTRIES);
+        size_t length;
+        while ((length = generator.fill(chunk, sizeof(chunk))) > 0) {
+            bytes += length;
+        }
+        benchClobberMemory();
+    }
+    state.setItemsProcessed(state.iterations() * HISTORY_ENTRIES);
+    state.setBytesProcessed(bytes);
+}
+BENCHMARK(BM_Json_DataBody);
+
+// ==================== RENDERING ====================
+// The trend chart drawn into RAM; no bus transfer is involved
+static void BM_Ui_DrawLineChart(BenchState& state) {
+    GFXcanvas16 canvas(SCREEN_WIDTH, 120);
+    UIElements ui(&canvas);
+    for (auto _ : state) {
+        ui.drawLineChart(0, 0, SCREEN_WIDTH, 120, (float*)signals.chart, CHART_POINTS, COLOR_ACCENT);
+        benchDoNotOptimize(canvas.getBuffer()[0]);
+    }
+    state.setItemsProcessed(state.iterations() * CHART_POINTS);
+    state.setBytesProcessed((double)state.iterations() * SCREEN_WIDTH * 120 * 2);
+}
+BENCHMARK(BM_Ui_DrawLineChart);
+
+// ==================== PROFILER ====================
+// Cost of one PROFILE_SCOPE around an empty body, i.e. what every profiled
+// section pays on top of its own work
+static void BM_Profiler_Scope(BenchState& state) {
+    static ProfileSection section("bench");
+    for (auto _ : state) {
+        PROFILE_SCOPE(section);
+        benchClobberMemory();
+    }
+    benchDoNotOptimize(section.getCount());
+}
+BENCHMARK(BM_Profiler_Scope);
+
+// ==================== TRACE LOG ====================
+// A TRACE with two string arguments, as in triggerAlert(), plus its share
+// of a binary drain every 64 records
+static void BM_Trace_Record(BenchState& state) {
+    Serial.setMuted(true);
+    traceLog.setBinary(true);
+    uint32_t droppedBefore = traceLog.getDropped();
+    int pending = 0;
+    for (auto _ : state) {
+        TRACE("ALERT [%s]: %s\n", "WARNING", "Heart rate: 104 BPM");
+        if (++pending == 64) {
+            traceLog.drain();
+            pending = 0;
+        }
+    }
+    traceLog.drain();
+    Serial.setMuted(false);
+    benchDoNotOptimize(traceLog.getDropped() - droppedBefore);
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Trace_Record);
+
+int main(int argc, char** argv) {
+    return benchMain(argc, argv);
+}
@@ -0,0 +1,129 @@
+/*
+ * Host benchmark: schema serializer (json_schema.h) vs ArduinoJson 6 for the
+ * payloads the firmware actually sends.
+ *
+ * Build and run on the host; PlatformIO fetches ArduinoJson:
+ *   pio run -e bench_json && .pio/build/bench_json/program
+ */
+
+#include <ArduinoJson.h>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "../vital_signs.h"
+
+static const int ITERATIONS = 200000;
+static const int HISTORY_ITERATIONS = 2000;
+static const int HISTORY_ENTRIES = 100;   // DATA_BUFFER_SIZE in the firmware
+
+static volatile size_t sinkBytes = 0;      // Keeps the optimizer honest
+
+template <typename F>
+static double nsPerOp(int iterations, F fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        sinkBytes += fn(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+static void report(const char* payload, double arduinoJsonNs, double schemaNs, size_t bytes) {
+    printf("%-16s %8zu B  ArduinoJson %9.1f ns  schema %9.1f ns  speedup %5.2fx\n",
+           payload, bytes, arduinoJsonNs, schemaNs, arduinoJsonNs / schemaNs);
+}
+
+int main() {
+    VitalSigns vitals;
+    vitals.heartRate = 72.5f;
+    vitals.spO2 = 97.0f;
+    vitals.batteryLevel = 84.3f;
+    vitals.isFingerDetected = true;
+    vitals.timestamp = 1234567;
+
+    std::vector<VitalSigns> history(HISTORY_ENTRIES, vitals);
+    for (int i = 0; i < HISTORY_ENTRIES; i++) {
+        history[i].heartRate = 60.0f + (i % 40);
+        history[i].timestamp = 1000UL * i;
+    }
+
+    char buffer[16384];
+
+    // /api/vitals
+    double ajVitals = nsPerOp(ITERATIONS, [&](int i) {
+        DynamicJsonDocument doc(512);
+        doc["heartRate"] = vitals.heartRate;
+        doc["spO2"] = vitals.spO2;
+        doc["batteryLevel"] = vitals.batteryLevel;
+        doc["isFingerDetected"] = vitals.isFingerDetected;
+        doc["timestamp"] = vitals.timestamp + i;
+        return serializeJson(doc, buffer, sizeof(buffer));
+    });
+    double schemaVitals = nsPerOp(ITERATIONS, [&](int i) {
+        VitalSigns v = vitals;
+        v.timestamp += i;
+        return jsonSerialize(v, buffer, sizeof(buffer));
+    });
+    report("/api/vitals", ajVitals, schemaVitals, jsonMeasure(vitals));
+
+    // WebSocket vitals broadcast
+    double ajMessage = nsPerOp(ITERATIONS, [&](int i) {
+        DynamicJsonDocument doc(512);
+        doc["type"] = "vitals";
+        doc["heartRate"] = vitals.heartRate;
+        doc["spO2"] = vitals.spO2;
+        doc["battery"] = vitals.batteryLevel;
+        doc["fingerDetected"] = vitals.isFingerDetected;
+        doc["timestamp"] = vitals.timestamp + i;
+        return serializeJson(doc, buffer, sizeof(buffer));
+    });
+    double schemaMessage = nsPerOp(ITERATIONS, [&](int i) {
+        VitalSigns v = vitals;
+        v.timestamp += i;
+        return jsonSerialize<VitalsMessageSchema>(v, buffer, sizeof(buffer));
+    });
+    report("ws vitals", ajMessage, schemaMessage, jsonMeasure<VitalsMessageSchema>(vitals));
+
+    // /data with a full history buffer
+    double ajData = nsPerOp(HISTORY_ITERATIONS, [&](int) {
+        DynamicJsonDocument doc(16384);
+        JsonObject current = doc.createNestedObject("current");
+        current["heartRate"] = vitals.heartRate;
+        current["spO2"] = vitals.spO2;
+        current["batteryLevel"] = vitals.batteryLevel;
+        current["fingerDetected"] = vitals.isFingerDetected;
+        current["timestamp"] = vitals.timestamp;
+        JsonArray entries = doc.createNestedArray("history");
+        for (const auto& data : history) {
+            JsonObject entry = entries.createNestedObject();
+            entry["heartRate"] = data.heartRate;
+            entry["spO2"] = data.spO2;
+            entry["batteryLevel"] = data.batteryLevel;
+            entry["timestamp"] = data.timestamp;
+        }
+        return serializeJson(doc, buffer, sizeof(buffer));
+    });
+    size_t dataBytes = 0;
+    double schemaData = nsPerOp(HISTORY_ITERATIONS, [&](int) {
+        JsonBufferSink sink(buffer, sizeof(buffer));
+        JsonWriter<JsonBufferSink> writer(sink);
+        writer.beginObject();
+        writer.key("current");
+        writer.object<VitalsCurrentSchema>(vitals);
+        writer.key("history");
+        writer.array<VitalsHistorySchema>(history.begin(), history.end());
+        writer.endObject();
+        sink.finish();
+        dataBytes = sink.getLength();
+        return sink.getLength();
+    });
+    report("/data (100)", ajData, schemaData, dataBytes);
+
+    // Exact size precomputation alone (Content-Length)
+    double measureNs = nsPerOp(ITERATIONS, [&](int) {
+        return jsonMeasure(vitals);
+    });
+    printf("%-16s %8s    measure only %9.1f ns\n", "/api/vitals", "", measureNs);
+
+    return sinkBytes == 0;
+}
@@ -0,0 +1,244 @@
+/*
+ * Host benchmark of the central station's vitals store (store/): ingest
+ * rate, size on disk, and query latency over a day of 1 Hz vitals from a
+ * ward of monitors.
+ *
+ * Rows are appended as the gateway would, a second at a time across every
+ * device, with a flush each simulated hour. The store is then closed and
+ * opened again, so the queries read the memory-mapped segments:
+ *
+ *   - scan: every row and column of the window, across all devices
+ *   - rollup: 5-minute min/mean/max buckets per device
+ *   - device: one device's rows as VitalSigns
+ *   - recent: the last hour across all devices
+ *
+ * Each query runs --repetitions times; the median is reported.
+ *
+ *   pio run -e bench_store && .pio/build/bench_store/program --devices 200 --hours 24
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../store/vitals_store.h"
+
+static const int64_t EPOCH = 1760000000000LL;     // Unix ms the generated day starts at
+static const int64_t HOUR = 3600 * 1000LL;
+
+static volatile size_t sinkRows = 0;                // Keeps the optimizer honest
+
+static double nowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ==================== PATIENTS ====================
+// What a bed's monitor reports: whole BPM and percent from the estimator, a
+// slowly draining battery, arrival times that wander by a few ms and the
+// odd spell with the finger off the sensor
+struct SyntheticBed {
+    uint64_t state;
+    float heartRate;
+    float spO2;
+    float battery;
+    int offFor;                 // Seconds left without a finger
+
+    explicit SyntheticBed(int bed) : state(0x9E3779B97F4A7C15ULL * (bed + 1)), heartRate(60 + bed % 40),
+                                     spO2(94 + bed % 6), battery(100), offFor(0) {}
+
+    uint32_t random() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return (uint32_t)state;
+    }
+
+    void next(int64_t second, VitalSigns& vitals) {
+        uint32_t r = random();
+        if (offFor > 0) {
+            offFor--;
+        } else if (r % 3600 == 0) {
+            offFor = 30 + r % 300;
+        }
+        if (r % 4 == 0) heartRate = std::max(40.0f, std::min(160.0f, heartRate + (int)(r >> 8) % 3 - 1));
+        if (r % 16 == 1) spO2 = std::max(85.0f, std::min(100.0f, spO2 + (int)(r >> 12) % 3 - 1));
+        if (r % 600 == 2) battery = std::max(5.0f, battery - 0.5f);
+        vitals.isFingerDetected = offFor == 0;
+        vitals.heartRate = vitals.isFingerDetected ? heartRate : 0;
+        vitals.spO2 = vitals.isFingerDetected ? spO2 : 0;
+        vitals.batteryLevel = battery;
+        vitals.timestamp = (unsigned long)(EPOCH + second * 1000 + (int)(r >> 20) % 25);
+    }
+};
+
+// ==================== QUERIES ====================
+template <typename F>
+static double medianMs(int repetitions, F query) {
+    std::vector<double> times;
+    for (int i = 0; i < repetitions; i++) {
+        double start = nowSeconds();
+        query();
+        times.push_back((nowSeconds() - start) * 1e3);
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+static void report(const char* name, int threads, double ms, uint64_t rows) {
+    printf("%-8s %2d threads %9.2f ms  %10llu rows  %8.1f M rows/s\n", name, threads, ms,
+           (unsigned long long)rows, ms > 0 ? rows / ms / 1e3 : 0.0);
+}
+
+static void usage() {
+    fprintf(stderr,
+        "Usage: bench_store [options]\n"
+        "  --devices N       monitors (default 200)\n"
+        "  --hours N         hours of 1 Hz vitals each (default 24)\n"
+        "  --threads N       scan threads (default: the cores, at most 8)\n"
+        "  --repetitions N   runs of each query (default 5)\n"
+        "  --dir DIR         store directory, emptied first (default .bench_store)\n");
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    int deviceCount = 200;
+    int hours = 24;
+    int threads = std::max(1, std::min(8, (int)std::thread::hardware_concurrency()));
+    int repetitions = 5;
+    std::string dir = ".bench_store";
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) usage();
+        const char* value = argv[++i];
+        if (option == "--devices") deviceCount = atoi(value);
+        else if (option == "--hours") hours = atoi(value);
+        else if (option == "--threads") threads = atoi(value);
+        else if (option == "--repetitions") repetitions = atoi(value);
+        else if (option == "--dir") dir = value;
+        else usage();
+    }
+    if (deviceCount <= 0 || hours <= 0 || threads <= 0 || repetitions <= 0) usage();
+    std::string wipe = "rm -rf '" + dir + "'";
+    if (system(wipe.c_str()) != 0) return 1;
+
+    // Ingest
+    std::vector<std::string> names;
+    std::vector<SyntheticBed> beds;
+    for (int d = 0; d < deviceCount; d++) {
+        names.push_back("bed-" + std::to_string(d + 1));
+        beds.push_back(SyntheticBed(d));
+    }
+    VitalsStore store;
+    if (!store.open(dir.c_str())) {
+        fprintf(stderr, "Could not open %s\n", dir.c_str());
+        return 1;
+    }
+    int64_t seconds = hours * 3600LL;
+    VitalSigns vitals;
+    double start = nowSeconds();
+    for (int64_t s = 0; s < seconds; s++) {
+        for (int d = 0; d < deviceCount; d++) {
+            beds[d].next(s, vitals);
+            store.append(names[d], vitals);
+        }
+        if (s % 3600 == 3599 && !store.flush()) {
+            fprintf(stderr, "Flush failed\n");
+            return 1;
+        }
+    }
+    store.close();
+    double ingest = nowSeconds() - start;
+    uint64_t rows = (uint64_t)seconds * deviceCount;
+
+    start = nowSeconds();
+    store.open(dir.c_str());
+    double opened = nowSeconds() - start;
+    VitalsStoreStats stats = store.getStats();
+    printf("ingest   %llu rows, %d devices x %d h in %.2f s: %.2f M rows/s\n", (unsigned long long)rows, deviceCount,
+           hours, ingest, rows / ingest / 1e6);
+    printf("disk     %.1f MB in %u segments, %.2f bytes/row (VitalsRecord: 16), opened in %.1f ms\n",
+           stats.segmentBytes / 1e6, stats.segments, (double)stats.segmentBytes / rows, opened * 1e3);
+    if (stats.rows != rows) {
+        fprintf(stderr, "Store holds %llu rows, expected %llu\n", (unsigned long long)stats.rows,
+                (unsigned long long)rows);
+        return 1;
+    }
+
+    // A day's window, or the whole run if shorter
+    int64_t to = EPOCH + seconds * 1000;
+    int64_t from = std::max(EPOCH, to - 24 * HOUR);
+    uint64_t windowRows = (uint64_t)(to - from) / 1000 * deviceCount;
+
+    for (int t : {1, threads}) {
+        VitalsScan scan;
+        scan.from = from;
+        scan.to = to;
+        scan.threads = t;
+        std::vector<uint64_t> counted(t);
+        double ms = medianMs(repetitions, [&] {
+            std::fill(counted.begin(), counted.end(), 0);
+            store.scan(scan, [&](int worker, const std::string&, const VitalsColumns& columns) {
+                counted[worker] += columns.size();
+            });
+        });
+        uint64_t total = 0;
+        for (uint64_t c : counted) total += c;
+        if (total != windowRows) {
+            fprintf(stderr, "Scan read %llu rows, expected %llu\n", (unsigned long long)total,
+                    (unsigned long long)windowRows);
+            return 1;
+        }
+        report("scan", t, ms, total);
+        if (t == threads) break;
+    }
+
+    VitalsScan window;
+    window.from = from;
+    window.to = to;
+    window.threads = threads;
+    std::vector<VitalsRollup> buckets;
+    double rollupMs = medianMs(repetitions, [&] {
+        buckets.clear();
+        store.rollup(window, 5 * 60 * 1000, buckets);
+    });
+    report("rollup", threads, rollupMs, windowRows);
+    printf("         %zu buckets\n", buckets.size());
+
+    std::vector<VitalSigns> one;
+    double deviceMs = medianMs(repetitions, [&] {
+        one.clear();
+        store.read(names[0], from, to, one);
+    });
+    report("device", 1, deviceMs, one.size());
+    // Lossless: the same bed again, row for row
+    SyntheticBed replay(0);
+    size_t matched = 0;
+    for (int64_t s = 0; s < seconds; s++) {
+        replay.next(s, vitals);
+        if ((int64_t)vitals.timestamp < from) continue;
+        if (matched >= one.size()) break;
+        const VitalSigns& stored = one[matched];
+        if (stored.timestamp != vitals.timestamp || stored.heartRate != vitals.heartRate ||
+            stored.spO2 != vitals.spO2 || stored.batteryLevel != vitals.batteryLevel ||
+            stored.isFingerDetected != vitals.isFingerDetected) {
+            break;
+        }
+        matched++;
+    }
+    if (matched != one.size()) {
+        fprintf(stderr, "%s differs from what was stored at row %zu\n", names[0].c_str(), matched);
+        return 1;
+    }
+
+    VitalsScan recent = window;
+    recent.from = to - HOUR;
+    double recentMs = medianMs(repetitions, [&] {
+        store.scan(recent, [&](int, const std::string&, const VitalsColumns& columns) { sinkRows += columns.size(); });
+    });
+    report("recent", threads, recentMs, (uint64_t)HOUR / 1000 * deviceCount);
+    return 0;
+}
@@ -0,0 +1,603 @@
+/*
+ * Replays recorded waveforms through the monitor's sample-to-alarm path
+ * (vitals_pipeline.h) as fast as the host allows, and scores the output
+ * against reference labels. The estimator is the device's:
+ * spo2_algorithm.cpp of the SparkFun MAX3010x library, which the env takes
+ * from lib_deps. Its beats are the IR valleys it times the heart rate by.
+ *
+ *   pio run -e replay && .pio/build/replay/program session1.csv session2.csv
+ *
+ * or with g++, from the repository root, once PlatformIO has fetched the
+ * library:
+ *   pio pkg install -e replay
+ *   MAXIM=$(ls -d .pio/libdeps/replay/SparkFun*)/src
+ *   g++ -O2 -std=gnu++17 -DARDUINO=10819 -Inative -I. -I"$MAXIM" -pthread -o replay bench/replay.cpp \
+ *       native/arduino_core.cpp "$MAXIM"/spo2_algorithm.cpp \
+ *       vitals_pipeline.cpp vitals_log.cpp metrics.cpp http_stream.cpp signal_generator.cpp
+ *
+ * CSV recordings have a header row naming the columns; `#` lines are
+ * comments and column order is free:
+ *   t_ms    sample time in ms (else samples are --rate Hz apart)
+ *   red,ir  MAX30102 counts (required)
+ *   hr,spo2 reference values; empty where unknown
+ *   beat    1 on samples holding a reference beat
+ *
+ * Files ending in .bin are vitals log segments (vitals_log.h). They hold
+ * no waveform, so only the alarm rules are replayed from them.
+ *
+ * --synthetic SECONDS adds a labelled recording from SignalGenerator,
+ * shaped by the --patient-* options and --seed.
+ *
+ * Time comes from the recording, not the host, so two runs over the same
+ * input give the same results apart from the throughput figures.
+ */
+
+#include <Arduino.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "../hal.h"
+#include "../vitals_pipeline.h"
+#include "../vitals_log.h"
+#include "../signal_generator.h"
+
+// ==================== REPLAY CLOCK ====================
+// hal.clock for the metrics and the vitals log follows the recording
+class ReplayClock : public HalClock {
+private:
+    uint64_t nowUs = 0;
+
+public:
+    uint32_t millis() override { return nowUs / 1000; }
+    uint32_t micros() override { return (uint32_t)nowUs; }
+    void delay(uint32_t ms) override { nowUs += (uint64_t)ms * 1000; }
+    void set(uint32_t ms) { nowUs = (uint64_t)ms * 1000; }
+};
+
+static ReplayClock replayClock;
+
+// Nothing but the clock is needed on this path
+Hal hal = {&replayClock, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+
+// ==================== RECORDINGS ====================
+struct Recording {
+    std::vector<uint32_t> time;     // ms
+    std::vector<uint32_t> red;
+    std::vector<uint32_t> ir;
+    std::vector<float> hr;          // NAN where unknown
+    std::vector<float> spo2;
+    std::vector<uint32_t> beats;    // Reference beat times, ms
+    std::vector<VitalSigns> vitals; // Vitals log segments only
+    bool hasBeats = false;
+};
+
+struct ReplayOptions {
+    float rate = 25.0f;             // FreqS of the estimator
+    AlertThresholds thresholds;
+    uint32_t beatTolerance = 150;   // ms, as in ANSI/AAMI EC57
+    bool listAlarms = false;
+    std::string jsonPath;
+    PhysiologyParams patient;       // For --synthetic
+    uint64_t seed = 1;
+};
+
+static bool readFile(const std::string& path, std::string& text) {
+    FILE* in = fopen(path.c_str(), "rb");
+    if (!in) return false;
+    char chunk[65536];
+    size_t length;
+    while ((length = fread(chunk, 1, sizeof(chunk), in)) > 0) text.append(chunk, length);
+    fclose(in);
+    return true;
+}
+
+static bool endsWith(const std::string& text, const char* suffix) {
+    size_t length = strlen(suffix);
+    return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+static bool loadVitalsLog(const std::string& path, Recording& recording) {
+    std::string data;
+    if (!readFile(path, data)) return false;
+    size_t count = data.size() / sizeof(VitalsRecord);
+    recording.vitals.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        VitalsRecord record;
+        memcpy(&record, data.data() + i * sizeof(VitalsRecord), sizeof(record));
+        recording.vitals.push_back(VitalsLog::toVitalSigns(record));
+    }
+    return true;
+}
+
+static const char SYNTHETIC_PREFIX[] = "synthetic:";
+
+// Labelled input straight from the generator, at the estimator's rate
+static void loadSynthetic(double seconds, const ReplayOptions& options, Recording& recording) {
+    SignalGenerator generator(options.rate, options.seed);
+    generator.setParams(options.patient);
+    size_t count = (size_t)(seconds * options.rate);
+    recording.time.reserve(count);
+    recording.red.reserve(count);
+    recording.ir.reserve(count);
+    recording.hr.reserve(count);
+    recording.spo2.reserve(count);
+    recording.hasBeats = true;
+
+    for (size_t i = 0; i < count; i++) {
+        SignalSample sample;
+        generator.next(sample);
+        // Samples lost to simulated FIFO overflow leave a gap in time
+        uint32_t time = (uint32_t)((generator.getSampleIndex() - 1) * 1000.0 / options.rate);
+        recording.time.push_back(time);
+        recording.red.push_back(sample.red);
+        recording.ir.push_back(sample.ir);
+        recording.hr.push_back(sample.heartRate);
+        recording.spo2.push_back(options.patient.spO2);
+        if (sample.beat) recording.beats.push_back(time);
+    }
+}
+
+static bool loadCsv(const std::string& path, const ReplayOptions& options, Recording& recording, std::string& error) {
+    std::string text;
+    if (!readFile(path, text)) {
+        error = "cannot read file";
+        return false;
+    }
+
+    enum Column { TIME, RED, IR, HR, SPO2, BEAT, IGNORED };
+    std::vector<Column> columns;
+    const char* p = text.c_str();
+    const char* end = p + text.size();
+    bool hasTime = false;
+    size_t sample = 0;
+
+    while (p < end) {
+        const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+        if (!lineEnd) lineEnd = end;
+        if (*p == '#' || *p == '\r' || p == lineEnd) {
+            p = lineEnd + 1;
+            continue;
+        }
+
+        if (columns.empty()) {
+            // Header row
+            std::string header(p, lineEnd);
+            size_t start = 0;
+            while (start <= header.size()) {
+                size_t comma = header.find(',', start);
+                if (comma == std::string::npos) comma = header.size();
+                std::string name = header.substr(start, comma - start);
+                while (!name.empty() && isspace((unsigned char)name.back())) name.pop_back();
+                while (!name.empty() && isspace((unsigned char)name[0])) name.erase(0, 1);
+                for (char& c : name) c = tolower((unsigned char)c);
+
+                Column column = IGNORED;
+                if (name == "t_ms" || name == "time_ms" || name == "timestamp") column = TIME, hasTime = true;
+                else if (name == "red") column = RED;
+                else if (name == "ir") column = IR;
+                else if (name == "hr") column = HR;
+                else if (name == "spo2") column = SPO2;
+                else if (name == "beat") column = BEAT, recording.hasBeats = true;
+                columns.push_back(column);
+                start = comma + 1;
+            }
+            if (std::find(columns.begin(), columns.end(), RED) == columns.end() ||
+                std::find(columns.begin(), columns.end(), IR) == columns.end()) {
+                error = "header needs red and ir columns";
+                return false;
+            }
+            p = lineEnd + 1;
+            continue;
+        }
+
+        uint32_t time = hasTime ? 0 : (uint32_t)(sample * 1000.0 / options.rate);
+        uint32_t red = 0, ir = 0;
+        float hr = NAN, spo2 = NAN;
+        bool beat = false;
+
+        for (size_t c = 0; c < columns.size() && p <= lineEnd; c++) {
+            const char* fieldEnd = p;
+            while (fieldEnd < lineEnd && *fieldEnd != ',') fieldEnd++;
+            bool empty = fieldEnd == p || (fieldEnd == p + 1 && *p == '\r');
+            if (!empty) {
+                switch (columns[c]) {
+                    case TIME: time = strtoul(p, nullptr, 10); break;
+                    case RED: red = strtoul(p, nullptr, 10); break;
+                    case IR: ir = strtoul(p, nullptr, 10); break;
+                    case HR: hr = strtof(p, nullptr); break;
+                    case SPO2: spo2 = strtof(p, nullptr); break;
+                    case BEAT: beat = strtol(p, nullptr, 10) != 0; break;
+                    default: break;
+                }
+            }
+            p = fieldEnd + 1;
+        }
+
+        recording.time.push_back(time);
+        recording.red.push_back(red);
+        recording.ir.push_back(ir);
+        recording.hr.push_back(hr);
+        recording.spo2.push_back(spo2);
+        if (beat) recording.beats.push_back(time);
+        sample++;
+        p = lineEnd + 1;
+    }
+
+    if (recording.time.empty()) {
+        error = "no samples";
+        return false;
+    }
+    return true;
+}
+
+// ==================== SCORING ====================
+struct ErrorStats {
+    uint32_t windows = 0;
+    uint32_t covered = 0;       // Windows with an estimate on display
+    uint32_t scored = 0;        // ... and a reference to compare with
+    double absSum = 0;
+    double squareSum = 0;
+    double sum = 0;
+
+    void add(float estimate, double reference, bool hasReference) {
+        windows++;
+        if (estimate <= 0) return;
+        covered++;
+        if (!hasReference) return;
+        double error = estimate - reference;
+        scored++;
+        absSum += fabs(error);
+        squareSum += error * error;
+        sum += error;
+    }
+    double mae() const { return scored ? absSum / scored : 0; }
+    double rmse() const { return scored ? sqrt(squareSum / scored) : 0; }
+    double bias() const { return scored ? sum / scored : 0; }
+};
+
+// A stretch of the recording where the reference labels break a threshold
+struct Episode {
+    AlarmKind kind;
+    uint32_t onset;
+    uint32_t end;
+    bool detected;
+    uint32_t latency;
+};
+
+struct ReplayResult {
+    std::string path;
+    size_t samples = 0;
+    double recordedSeconds = 0;
+    double wallSeconds = 0;
+
+    ErrorStats heartRate;
+    ErrorStats spO2;
+
+    uint32_t referenceBeats = 0;
+    uint32_t detectedBeats = 0;
+    uint32_t matchedBeats = 0;
+    uint32_t beatWindowsOff = 0;    // Windows whose valleys time another heart rate than the estimator gave
+
+    std::vector<AlarmEvent> alarms;
+    std::vector<Episode> episodes;
+    uint32_t falseAlarms = 0;
+
+    double sensitivity() const { return referenceBeats ? (double)matchedBeats / referenceBeats : 0; }
+    double ppv() const { return detectedBeats ? (double)matchedBeats / detectedBeats : 0; }
+};
+
+static uint32_t matchBeats(const std::vector<uint32_t>& reference, const std::vector<uint32_t>& detected, uint32_t tolerance) {
+    uint32_t matched = 0;
+    size_t r = 0;
+    for (uint32_t beat : detected) {
+        while (r < reference.size() && reference[r] + tolerance < beat) r++;
+        if (r < reference.size() && reference[r] <= beat + tolerance) {
+            matched++;
+            r++;
+        }
+    }
+    return matched;
+}
+
+static void trackEpisode(std::vector<Episode>& episodes, int& open, AlarmKind kind, bool abnormal, uint32_t time) {
+    if (abnormal && open < 0) {
+        episodes.push_back({kind, time, time, false, 0});
+        open = episodes.size() - 1;
+    } else if (abnormal) {
+        episodes[open].end = time;
+    } else {
+        open = -1;
+    }
+}
+
+// Pairs each alarm with the reference episode it answers. Estimates trail
+// the signal by up to a window, so an alarm still counts that long after
+// the episode ended.
+static void scoreAlarms(ReplayResult& result, uint32_t grace) {
+    for (const AlarmEvent& alarm : result.alarms) {
+        bool explained = false;
+        for (Episode& episode : result.episodes) {
+            if (episode.kind != alarm.kind) continue;
+            if (alarm.timestamp < episode.onset || alarm.timestamp > episode.end + grace) continue;
+            if (!episode.detected) {
+                episode.detected = true;
+                episode.latency = alarm.timestamp - episode.onset;
+            }
+            explained = true;
+            break;
+        }
+        if (!explained && alarm.kind != AlarmKind::BATTERY) result.falseAlarms++;
+    }
+}
+
+// ==================== REPLAY ====================
+static void replayWaveform(const Recording& recording, const ReplayOptions& options, ReplayResult& result) {
+    PpgEstimator estimator;
+    AlarmRules rules;
+    VitalSigns vitals;
+    vitals.batteryLevel = 100;  // Recordings carry no battery level
+
+    std::vector<uint32_t> detected;
+    detected.reserve(recording.beats.size() + 64);
+    uint32_t lastAlarmCheck = 0;
+    double hrSum = 0, spo2Sum = 0;
+    uint32_t hrCount = 0, spo2Count = 0;
+    int openHr = -1, openSpo2 = -1;
+    const AlertThresholds& thresholds = options.thresholds;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < recording.time.size(); i++) {
+        uint32_t now = recording.time[i];
+        replayClock.set(now);
+        vitals.timestamp = now;
+
+        float hr = recording.hr[i];
+        float spo2 = recording.spo2[i];
+        if (!isnan(hr)) hrSum += hr, hrCount++;
+        if (!isnan(spo2)) spo2Sum += spo2, spo2Count++;
+        trackEpisode(result.episodes, openHr, AlarmKind::HEART_RATE,
+                     !isnan(hr) && (hr < thresholds.heartRateMin || hr > thresholds.heartRateMax), now);
+        trackEpisode(result.episodes, openSpo2, AlarmKind::SPO2, !isnan(spo2) && spo2 < thresholds.spO2Min, now);
+
+        float previousHeartRate = vitals.heartRate;
+        if (estimator.addSample(recording.red[i], recording.ir[i], vitals)) {
+            size_t first = i + 1 - PpgEstimator::WINDOW_SAMPLES;
+            if (vitals.isFingerDetected) {
+                int32_t locs[PPG_MAX_VALLEYS], count;
+                int32_t heartRate = findPpgValleys(&recording.ir[first], locs, count);
+                for (int32_t k = 0; k < count; k++) detected.push_back(recording.time[first + locs[k]]);
+                // The estimator keeps its last reading when it rejects a window
+                bool accepted = heartRate > 0 && heartRate < 200;
+                if (vitals.heartRate != (accepted ? heartRate : previousHeartRate)) result.beatWindowsOff++;
+            }
+
+            // The estimate covers the window, so compare it with the window's mean label
+            result.heartRate.add(vitals.heartRate, hrCount ? hrSum / hrCount : 0, hrCount > 0);
+            result.spO2.add(vitals.spO2, spo2Count ? spo2Sum / spo2Count : 0, spo2Count > 0);
+            hrSum = spo2Sum = 0;
+            hrCount = spo2Count = 0;
+        }
+
+        // Alarms are checked once a second, as in loop()
+        if (now - lastAlarmCheck >= 1000) {
+            lastAlarmCheck = now;
+            AlarmEvent alarm;
+            if (rules.check(vitals, thresholds, now, alarm)) result.alarms.push_back(alarm);
+        }
+    }
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    result.samples = recording.time.size();
+    uint32_t first = recording.time.front(), last = recording.time.back();
+    result.recordedSeconds = (last - first) / 1000.0;
+    result.detectedBeats = detected.size();
+    if (recording.hasBeats) {
+        result.referenceBeats = recording.beats.size();
+        result.matchedBeats = matchBeats(recording.beats, detected, options.beatTolerance);
+    }
+
+    double msPerSample = recording.time.size() > 1 ? (double)(last - first) / (recording.time.size() - 1) : 0;
+    scoreAlarms(result, (uint32_t)(msPerSample * PpgEstimator::WINDOW_SAMPLES));
+}
+
+static void replayVitals(const Recording& recording, const ReplayOptions& options, ReplayResult& result) {
+    AlarmRules rules;
+    auto start = std::chrono::steady_clock::now();
+    for (const VitalSigns& vitals : recording.vitals) {
+        AlarmEvent alarm;
+        if (rules.check(vitals, options.thresholds, vitals.timestamp, alarm)) result.alarms.push_back(alarm);
+    }
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.samples = recording.vitals.size();
+    if (!recording.vitals.empty()) {
+        result.recordedSeconds = (recording.vitals.back().timestamp - recording.vitals.front().timestamp) / 1000.0;
+    }
+}
+
+// ==================== REPORTING ====================
+static void printErrors(const char* label, const char* unit, const ErrorStats& stats) {
+    printf("  %-10s windows %u, covered %.1f%%", label, stats.windows,
+           stats.windows ? 100.0 * stats.covered / stats.windows : 0.0);
+    if (stats.scored) {
+        printf(", MAE %.2f %s, RMSE %.2f, bias %+.2f", stats.mae(), unit, stats.rmse(), stats.bias());
+    }
+    printf("\n");
+}
+
+static void printResult(const ReplayResult& r, const Recording& recording, const ReplayOptions& options) {
+    printf("%s: %zu samples (%.1f s) in %.4f s, %.0f samples/s (%.0fx real time)\n",
+           r.path.c_str(), r.samples, r.recordedSeconds, r.wallSeconds,
+           r.wallSeconds > 0 ? r.samples / r.wallSeconds : 0.0,
+           r.wallSeconds > 0 ? r.recordedSeconds / r.wallSeconds : 0.0);
+
+    if (recording.vitals.empty()) {
+        printErrors("heart rate", "BPM", r.heartRate);
+        printErrors("SpO2", "%", r.spO2);
+        if (recording.hasBeats) {
+            printf("  %-10s reference %u, detected %u, sensitivity %.1f%%, PPV %.1f%% (+/-%u ms, estimator's IR valleys)",
+                   "beats", r.referenceBeats, r.detectedBeats, 100 * r.sensitivity(), 100 * r.ppv(),
+                   options.beatTolerance);
+        } else {
+            printf("  %-10s detected %u, no reference", "beats", r.detectedBeats);
+        }
+        if (r.beatWindowsOff) printf(", %u windows off the estimator's heart rate", r.beatWindowsOff);
+        printf("\n");
+    }
+
+    uint32_t detected = 0, worst = 0;
+    double latencySum = 0;
+    for (const Episode& episode : r.episodes) {
+        if (!episode.detected) continue;
+        detected++;
+        latencySum += episode.latency;
+        worst = max(worst, episode.latency);
+    }
+    printf("  %-10s raised %zu", "alarms", r.alarms.size());
+    if (!r.episodes.empty()) {
+        printf(", episodes %zu, detected %u", r.episodes.size(), detected);
+        if (detected) printf(", latency mean %.1f s max %.1f s", latencySum / detected / 1000, worst / 1000.0);
+        printf(", false %u", r.falseAlarms);
+    }
+    printf("\n");
+
+    if (options.listAlarms) {
+        for (const AlarmEvent& alarm : r.alarms) {
+            char message[48];
+            formatAlarmMessage(alarm, message, sizeof(message));
+            printf("    %10.1f s  %-8s  %s\n", alarm.timestamp / 1000.0,
+                   alarm.level == AlertLevel::CRITICAL ? "CRITICAL" : "WARNING", message);
+        }
+    }
+}
+
+static void writeJson(const std::string& path, const std::vector<ReplayResult>& results) {
+    FILE* out = fopen(path.c_str(), "w");
+    if (!out) {
+        fprintf(stderr, "Could not write %s\n", path.c_str());
+        return;
+    }
+    fprintf(out, "{\"files\":[");
+    for (size_t i = 0; i < results.size(); i++) {
+        const ReplayResult& r = results[i];
+        fprintf(out, "%s\n{\"path\":\"%s\",\"samples\":%zu,\"recordedSeconds\":%.3f,\"wallSeconds\":%.6f,"
+                     "\"samplesPerSecond\":%.0f,",
+                i ? "," : "", r.path.c_str(), r.samples, r.recordedSeconds, r.wallSeconds,
+                r.wallSeconds > 0 ? r.samples / r.wallSeconds : 0.0);
+        fprintf(out, "\"heartRate\":{\"windows\":%u,\"covered\":%u,\"scored\":%u,\"mae\":%.3f,\"rmse\":%.3f,\"bias\":%.3f},",
+                r.heartRate.windows, r.heartRate.covered, r.heartRate.scored, r.heartRate.mae(), r.heartRate.rmse(), r.heartRate.bias());
+        fprintf(out, "\"spO2\":{\"windows\":%u,\"covered\":%u,\"scored\":%u,\"mae\":%.3f,\"rmse\":%.3f,\"bias\":%.3f},",
+                r.spO2.windows, r.spO2.covered, r.spO2.scored, r.spO2.mae(), r.spO2.rmse(), r.spO2.bias());
+        fprintf(out, "\"beats\":{\"reference\":%u,\"detected\":%u,\"matched\":%u,\"sensitivity\":%.4f,\"ppv\":%.4f,"
+                     "\"windowsOff\":%u},",
+                r.referenceBeats, r.detectedBeats, r.matchedBeats, r.sensitivity(), r.ppv(), r.beatWindowsOff);
+        fprintf(out, "\"alarms\":[");
+        for (size_t a = 0; a < r.alarms.size(); a++) {
+            const AlarmEvent& alarm = r.alarms[a];
+            fprintf(out, "%s{\"t\":%u,\"kind\":\"%s\",\"level\":\"%s\",\"value\":%.1f}", a ? "," : "",
+                    alarm.timestamp, alarmKindName(alarm.kind),
+                    alarm.level == AlertLevel::CRITICAL ? "critical" : "warning", alarm.value);
+        }
+        fprintf(out, "],\"episodes\":[");
+        for (size_t e = 0; e < r.episodes.size(); e++) {
+            const Episode& episode = r.episodes[e];
+            fprintf(out, "%s{\"kind\":\"%s\",\"onset\":%u,\"end\":%u,\"detected\":%s", e ? "," : "",
+                    alarmKindName(episode.kind), episode.onset, episode.end, episode.detected ? "true" : "false");
+            if (episode.detected) fprintf(out, ",\"latency\":%u", episode.latency);
+            fprintf(out, "}");
+        }
+        fprintf(out, "],\"falseAlarms\":%u}", r.falseAlarms);
+    }
+    fprintf(out, "\n]}\n");
+    fclose(out);
+}
+
+static void usage() {
+    fprintf(stderr,
+        "Usage: replay [options] FILE...\n"
+        "  --rate HZ            sample rate of CSV files without t_ms (default 25)\n"
+        "  --hr-min BPM         alarm thresholds (defaults as in the settings screen)\n"
+        "  --hr-max BPM\n"
+        "  --spo2-min PCT\n"
+        "  --beat-tolerance MS  match window for reference beats (default 150)\n"
+        "  --alarms             list every alarm raised\n"
+        "  --json FILE          write the results as JSON\n"
+        "  --synthetic SECONDS  also replay a generated, labelled recording\n"
+        "  --patient-hr BPM     its heart rate (default 72)\n"
+        "  --patient-spo2 PCT   its saturation (default 97)\n"
+        "  --motion N           its motion artifacts per minute (default 0)\n"
+        "  --seed N             its generator seed (default 1)\n");
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    ReplayOptions options;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--alarms") {
+            options.listAlarms = true;
+            continue;
+        }
+        if (option.compare(0, 2, "--") != 0) {
+            paths.push_back(option);
+            continue;
+        }
+        if (i + 1 >= argc) usage();
+        const char* value = argv[++i];
+        if (option == "--rate") options.rate = atof(value);
+        else if (option == "--hr-min") options.thresholds.heartRateMin = atof(value);
+        else if (option == "--hr-max") options.thresholds.heartRateMax = atof(value);
+        else if (option == "--spo2-min") options.thresholds.spO2Min = atof(value);
+        else if (option == "--beat-tolerance") options.beatTolerance = atoi(value);
+        else if (option == "--json") options.jsonPath = value;
+        else if (option == "--synthetic") paths.push_back(std::string(SYNTHETIC_PREFIX) + value);
+        else if (option == "--patient-hr") options.patient.heartRate = atof(value);
+        else if (option == "--patient-spo2") options.patient.spO2 = atof(value);
+        else if (option == "--motion") options.patient.motionRate = atof(value);
+        else if (option == "--seed") options.seed = strtoull(value, nullptr, 10);
+        else usage();
+    }
+    if (paths.empty() || options.rate <= 0) usage();
+
+    std::vector<ReplayResult> results;
+    size_t totalSamples = 0;
+    double totalWall = 0, totalRecorded = 0;
+    int failures = 0;
+
+    for (const std::string& path : paths) {
+        Recording recording;
+        std::string error;
+        bool loaded = true;
+        if (path.compare(0, strlen(SYNTHETIC_PREFIX), SYNTHETIC_PREFIX) == 0) {
+            loadSynthetic(atof(path.c_str() + strlen(SYNTHETIC_PREFIX)), options, recording);
+        } else if (endsWith(path, ".bin")) {
+            loaded = loadVitalsLog(path, recording);
+        } else {
+            loaded = loadCsv(path, options, recording, error);
+        }
+        if (!loaded) {
+            fprintf(stderr, "%s: %s\n", path.c_str(), error.empty() ? "cannot read file" : error.c_str());
+            failures++;
+            continue;
+        }
+
+        ReplayResult result;
+        result.path = path;
+        if (recording.vitals.empty()) replayWaveform(recording, options, result);
+        else replayVitals(recording, options, result);
+        printResult(result, recording, options);
+
+        totalSamples += result.samples;
+        totalWall += result.wallSeconds;
+        totalRecorded += result.recordedSeconds;
+        results.push_back(result);
+    }
+
+    if (results.size() > 1) {
+        printf("total: %zu samples (%.1f s) in %.4f s, %.0f samples/s\n", totalSamples, totalRecorded, totalWall,
+               totalWall > 0 ? totalSamples / totalWall : 0.0);
+    }
+    if (!options.jsonPath.empty()) writeJson(options.jsonPath, results);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,52 @@
+#ifndef BOARD_PINS_H
+#define BOARD_PINS_H
+
+#include "target_profile.h"
+
+// Pin assignment of the cardiac_monitor_complete board, shared by the
+// sketch and the ESP32 HAL
+
+#if defined(TARGET_ESP32_PARALLEL)
+// Display: 8-bit parallel ILI9341 on MCUFRIEND_kbv's fixed ESP32 map
+// (D0-D7 12, 13, 26, 25, 17, 16, 27, 14; RD 2, WR 4, RS 15, CS 33, RST 32),
+// which leaves the VSPI pins to the touch controller
+
+// Touch Pins; no pin left for the IRQ, so touch is polled
+#define TOUCH_CS  5
+#define TOUCH_IRQ 255
+
+// Sensor Pins (I2C)
+#define SDA_PIN   21
+#define SCL_PIN   22
+
+// Battery and Buzzer; GPIO0 is a strapping pin, so the buzzer driver must
+// not pull it low at reset
+#define BATTERY_PIN 36
+#define BUZZER_PIN  0
+
+#else
+// Display Pins
+#define TFT_CS    5
+#define TFT_DC    2
+#define TFT_MOSI  23
+#define TFT_CLK   18
+#define TFT_RST   4
+#define TFT_MISO  19
+
+// Touch Pins
+#define TOUCH_CS  15
+#define TOUCH_IRQ 21
+
+// Sensor Pins (I2C)
+#define SDA_PIN   21
+#define SCL_PIN   22
+
+// Battery and Buzzer
+#define BATTERY_PIN 36
+#define BUZZER_PIN  25
+#endif
+
+// Optional single-lead ECG front end (AD8232), traced by the esp32_ecg profile
+#define ECG_PIN     34
+
+#endif
@@ -6,6 +6,15 @@ import random
 import math
 import sys
 
+# The firmware's own signal path, when libcardiac_dsp.so has been built (see
+# cardiac_dsp.py); without it the monitor falls back to the simulation below
+try:
+    import cardiac_dsp
+    if not cardiac_dsp.available():
+        cardiac_dsp = None
+except ImportError:
+    cardiac_dsp = None
+
 # ==================== CONSTANTS ====================
 FIRMWARE_VERSION = "1.0.0"
 DEVICE_NAME = "CardiacMonitor"
@@ -228,6 +237,16 @@ class CardiacMonitor:
         self.bufferIndex = 0
         self.fingerDetected = False
         
+        # Firmware signal path (None without libcardiac_dsp)
+        self.signal = None
+        self.estimator = None
+        self.alarmRules = None
+        self.lastDspSample = 0.0
+        if cardiac_dsp is not None:
+            self.signal = cardiac_dsp.SignalGenerator()
+            self.estimator = cardiac_dsp.PpgEstimator()
+            self.alarmRules = cardiac_dsp.AlarmRules()
+        
         # Alerts
         self.activeAlerts = []
         self.alertHistory = []
@@ -634,6 +653,10 @@ class CardiacMonitor:
         self.currentVitals.batteryLevel = self.readBatteryLevel()
         self.currentVitals.timestamp = time.time()
         
+        if self.estimator is not None:
+            self.updateSensorsDsp()
+            return
+            
         if self.particleSensor.available():
             self.redBuffer[self.bufferIndex] = self.particleSensor.getRed()
             self.irBuffer[self.bufferIndex] = self.particleSensor.getIR()
@@ -660,6 +683,33 @@ class CardiacMonitor:
                     
             self.particleSensor.nextSample()
             
+    def updateSensorsDsp(self):
+        """Runs the samples since the last update through the firmware's estimator"""
+        now = time.time()
+        if self.lastDspSample == 0.0:
+            self.lastDspSample = now
+        count = int((now - self.lastDspSample) * cardiac_dsp.PPG_SAMPLE_RATE)
+        if count <= 0:
+            return
+        self.lastDspSample += count / cardiac_dsp.PPG_SAMPLE_RATE
+        
+        samples = self.signal.generate(count)
+        windows, _, finger = self.estimator.process(samples["red"], samples["ir"])
+        
+        # Keep the latest samples for the waveform
+        tail = samples["ir"][-BUFFER_SIZE:]
+        self.irBuffer = np.roll(self.irBuffer, -len(tail))
+        self.irBuffer[-len(tail):] = tail
+        tail = samples["red"][-BUFFER_SIZE:]
+        self.redBuffer = np.roll(self.redBuffer, -len(tail))
+        self.redBuffer[-len(tail):] = tail
+        
+        self.fingerDetected = bool(finger[-1])
+        self.currentVitals.isFingerDetected = self.fingerDetected
+        if len(windows) > 0:
+            self.currentVitals.heartRate = float(windows[-1]["heart_rate"])
+            self.currentVitals.spO2 = float(windows[-1]["spo2"])
+            
     def readBatteryLevel(self):
         """Read and calculate battery level"""
         # Simulate battery level (3.0V to 4.2V range)
@@ -739,6 +789,10 @@ class CardiacMonitor:
         if not self.alertThresholds.enabled:
             return
             
+        if self.alarmRules is not None:
+            self.checkAlertsDsp()
+            return
+            
         if (self.currentVitals.isFingerDetected and 
             self.currentVitals.heartRate > 0 and
             (self.currentVitals.heartRate < self.alertThresholds.heartRateMin or
@@ -761,6 +815,23 @@ class CardiacMonitor:
             
         self.removeOldAlerts()
         
+    def checkAlertsDsp(self):
+        """The firmware's alarm rules and messages on the current reading"""
+        thresholds = cardiac_dsp.Thresholds(
+            self.alertThresholds.heartRateMin, self.alertThresholds.heartRateMax,
+            self.alertThresholds.spO2Min, self.alertThresholds.batteryMin, int(self.alertThresholds.enabled))
+        reading = np.zeros(1, cardiac_dsp.VITALS_DTYPE)
+        reading["heart_rate"] = self.currentVitals.heartRate
+        reading["spo2"] = self.currentVitals.spO2
+        reading["battery_level"] = self.currentVitals.batteryLevel
+        reading["finger_detected"] = int(self.currentVitals.isFingerDetected)
+        reading["timestamp_ms"] = int(self.currentVitals.timestamp * 1000) & 0xFFFFFFFF
+        alarms, _ = self.alarmRules.process(reading, thresholds)
+        for alarm in alarms:
+            self.triggerAlert(int(alarm["level"]), cardiac_dsp.format_alarm(alarm))
+            
+        self.removeOldAlerts()
+        
     def triggerAlert(self, level, message):
         """Trigger a new alert"""
         currentTime = time.time()
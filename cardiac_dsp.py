@@ -0,0 +1,372 @@
+"""
+ctypes binding of libcardiac_dsp, the monitor's signal path as a shared
+library (dsp/cardiac_dsp.h): the synthetic patient, HeartRateCalculator,
+SpO2Calculator, the windowed PPG estimator and the alarm rules, from the
+same sources as the native build. The PPG estimator is the device's, the
+MAX3010x library's spo2_algorithm.cpp.
+
+Every call hands whole numpy arrays across, so an hour of 100 Hz signal is
+one call per stage rather than 360000.
+
+Build the library from the repository root, then point CARDIAC_DSP_LIB at
+it or leave it next to this file:
+    pio pkg install -e native
+    MAXIM=$(ls -d .pio/libdeps/native/SparkFun*)/src
+    g++ -O2 -std=gnu++17 -DARDUINO=10819 -Inative -I. -I"$MAXIM" -fPIC -shared -fvisibility=hidden \\
+        -o libcardiac_dsp.so dsp/cardiac_dsp.cpp heartrate.cpp spo2_Algorithm.cpp \\
+        vitals_pipeline.cpp "$MAXIM"/spo2_algorithm.cpp signal_generator.cpp
+
+    python cardiac_dsp.py --hours 2 --hr 130    # runs the whole path, prints a summary
+"""
+
+import argparse
+import ctypes
+import os
+import time
+
+import numpy as np
+
+ABI_VERSION = 2
+PPG_WINDOW_SAMPLES = 100
+PPG_SAMPLE_RATE = 25            # The estimator assumes it; feed it anything else and the BPM scale with it
+
+ALERT_INFO = 0
+ALERT_WARNING = 1
+ALERT_CRITICAL = 2
+
+ALARM_HEART_RATE = 0
+ALARM_SPO2 = 1
+ALARM_BATTERY = 2
+
+# ==================== STRUCTS ====================
+# Field for field with cardiac_dsp.h, as numpy dtypes so arrays of them pass
+# straight through
+VITALS_DTYPE = np.dtype([
+    ("heart_rate", np.float32),
+    ("spo2", np.float32),
+    ("battery_level", np.float32),
+    ("finger_detected", np.int32),
+    ("timestamp_ms", np.uint32),
+    ("sequence", np.uint32),
+])
+
+ALARM_DTYPE = np.dtype([
+    ("kind", np.int32),
+    ("level", np.int32),
+    ("value", np.float32),
+    ("timestamp_ms", np.uint32),
+    ("sequence", np.uint32),
+])
+
+
+class Thresholds(ctypes.Structure):
+    _fields_ = [
+        ("heart_rate_min", ctypes.c_float),
+        ("heart_rate_max", ctypes.c_float),
+        ("spo2_min", ctypes.c_float),
+        ("battery_min", ctypes.c_float),
+        ("enabled", ctypes.c_int32),
+    ]
+
+
+class Physiology(ctypes.Structure):
+    _fields_ = [
+        ("heart_rate", ctypes.c_float),
+        ("hrv", ctypes.c_float),
+        ("respiration_rate", ctypes.c_float),
+        ("respiratory_sinus", ctypes.c_float),
+        ("spo2", ctypes.c_float),
+        ("perfusion", ctypes.c_float),
+        ("respiration_depth", ctypes.c_float),
+        ("finger_present", ctypes.c_int32),
+        ("baseline_wander", ctypes.c_float),
+        ("noise", ctypes.c_float),
+        ("motion_rate", ctypes.c_float),
+        ("motion_amplitude", ctypes.c_float),
+        ("fifo_overflow_rate", ctypes.c_float),
+        ("fifo_overflow_samples", ctypes.c_uint32),
+        ("ir_dc", ctypes.c_uint32),
+        ("red_dc", ctypes.c_uint32),
+        ("full_scale", ctypes.c_uint32),
+        ("ecg_gain", ctypes.c_float),
+        ("ecg_baseline", ctypes.c_uint32),
+    ]
+
+
+# ==================== LIBRARY ====================
+_lib = None
+
+
+def _pointer(array, ctype):
+    return None if array is None else array.ctypes.data_as(ctypes.POINTER(ctype))
+
+
+def _declare(lib):
+    handle = ctypes.c_void_p
+    size = ctypes.c_size_t
+    u8 = ctypes.POINTER(ctypes.c_uint8)
+    u16 = ctypes.POINTER(ctypes.c_uint16)
+    u32 = ctypes.POINTER(ctypes.c_uint32)
+    i32 = ctypes.POINTER(ctypes.c_int32)
+    f32 = ctypes.POINTER(ctypes.c_float)
+    signatures = {
+        "cardiac_dsp_abi_version": (ctypes.c_uint32, []),
+        "cardiac_thresholds_default": (None, [ctypes.POINTER(Thresholds)]),
+        "cardiac_physiology_default": (None, [ctypes.POINTER(Physiology)]),
+        "cardiac_signal_create": (handle, [ctypes.POINTER(Physiology), ctypes.c_float, ctypes.c_uint64]),
+        "cardiac_signal_destroy": (None, [handle]),
+        "cardiac_signal_set_params": (None, [handle, ctypes.POINTER(Physiology)]),
+        "cardiac_signal_generate": (None, [handle, size, u32, u32, u16, f32, u8, u16]),
+        "cardiac_heart_rate_create": (handle, []),
+        "cardiac_heart_rate_destroy": (None, [handle]),
+        "cardiac_heart_rate_reset": (None, [handle]),
+        "cardiac_heart_rate_set_threshold": (None, [handle, ctypes.c_int32]),
+        "cardiac_heart_rate_process": (size, [handle, i32, u32, size, u8, i32]),
+        "cardiac_spo2_create": (handle, []),
+        "cardiac_spo2_destroy": (None, [handle]),
+        "cardiac_spo2_reset": (None, [handle]),
+        "cardiac_spo2_process": (None, [handle, u32, u32, size, f32, u8]),
+        "cardiac_ppg_create": (handle, []),
+        "cardiac_ppg_destroy": (None, [handle]),
+        "cardiac_ppg_reset": (None, [handle]),
+        "cardiac_ppg_process": (size, [handle, u32, u32, size, u8, ctypes.c_void_p, u32, size,
+                                       ctypes.POINTER(size)]),
+        "cardiac_alarms_create": (handle, []),
+        "cardiac_alarms_destroy": (None, [handle]),
+        "cardiac_alarms_reset": (None, [handle]),
+        "cardiac_alarms_process": (size, [handle, ctypes.POINTER(Thresholds), ctypes.c_void_p, size,
+                                          ctypes.c_void_p, u32, size]),
+        "cardiac_alarm_format": (size, [ctypes.c_void_p, ctypes.c_char_p, size]),
+    }
+    for name, (restype, argtypes) in signatures.items():
+        function = getattr(lib, name)
+        function.restype = restype
+        function.argtypes = argtypes
+
+
+def load(path=None):
+    """Loads the library once; raises OSError if it is missing or of another ABI"""
+    global _lib
+    if _lib is not None:
+        return _lib
+    if path is None:
+        path = os.environ.get("CARDIAC_DSP_LIB") or os.path.join(
+            os.path.dirname(os.path.abspath(__file__)), "libcardiac_dsp.so")
+    lib = ctypes.CDLL(path)
+    _declare(lib)
+    version = lib.cardiac_dsp_abi_version()
+    if version != ABI_VERSION:
+        raise OSError(f"{path} has ABI version {version}, this binding wants {ABI_VERSION}")
+    _lib = lib
+    return lib
+
+
+def available():
+    try:
+        load()
+        return True
+    except OSError:
+        return False
+
+
+def default_thresholds():
+    thresholds = Thresholds()
+    load().cardiac_thresholds_default(ctypes.byref(thresholds))
+    return thresholds
+
+
+def default_physiology():
+    params = Physiology()
+    load().cardiac_physiology_default(ctypes.byref(params))
+    return params
+
+
+class _Handle:
+    _prefix = ""
+
+    def __init__(self, *args):
+        self._lib = load()
+        self._handle = getattr(self._lib, self._prefix + "create")(*args)
+        if not self._handle:
+            raise MemoryError(self._prefix + "create failed")
+
+    def __del__(self):
+        if getattr(self, "_handle", None):
+            getattr(self._lib, self._prefix + "destroy")(self._handle)
+            self._handle = None
+
+
+class _Resettable(_Handle):
+    def reset(self):
+        getattr(self._lib, self._prefix + "reset")(self._handle)
+
+
+# ==================== STAGES ====================
+class SignalGenerator(_Handle):
+    """The native build's synthetic patient: red/IR counts, ECG and reference beats"""
+    _prefix = "cardiac_signal_"
+
+    def __init__(self, params=None, sample_rate=PPG_SAMPLE_RATE, seed=1):
+        super().__init__(ctypes.byref(params if params is not None else default_physiology()),
+                         sample_rate, seed)
+
+    def set_params(self, params):
+        self._lib.cardiac_signal_set_params(self._handle, ctypes.byref(params))
+
+    def generate(self, count):
+        """The next `count` samples as a dict of arrays"""
+        out = {
+            "red": np.empty(count, np.uint32),
+            "ir": np.empty(count, np.uint32),
+            "ecg": np.empty(count, np.uint16),
+            "heart_rate": np.empty(count, np.float32),
+            "beat": np.empty(count, np.uint8),
+            "lost": np.empty(count, np.uint16),
+        }
+        self._lib.cardiac_signal_generate(
+            self._handle, count, _pointer(out["red"], ctypes.c_uint32), _pointer(out["ir"], ctypes.c_uint32),
+            _pointer(out["ecg"], ctypes.c_uint16), _pointer(out["heart_rate"], ctypes.c_float),
+            _pointer(out["beat"], ctypes.c_uint8), _pointer(out["lost"], ctypes.c_uint16))
+        return out
+
+
+class HeartRateCalculator(_Resettable):
+    """heartrate.cpp's beat detector, on the caller's sample times"""
+    _prefix = "cardiac_heart_rate_"
+
+    def set_threshold(self, threshold):
+        self._lib.cardiac_heart_rate_set_threshold(self._handle, int(threshold))
+
+    def process(self, samples, times_ms):
+        """Returns (beats, bpm): 1 where a beat was found, BPM after each sample"""
+        samples = np.ascontiguousarray(samples, np.int32)
+        times_ms = np.ascontiguousarray(times_ms, np.uint32)
+        count = len(samples)
+        beats = np.empty(count, np.uint8)
+        bpm = np.empty(count, np.int32)
+        self._lib.cardiac_heart_rate_process(
+            self._handle, _pointer(samples, ctypes.c_int32), _pointer(times_ms, ctypes.c_uint32), count,
+            _pointer(beats, ctypes.c_uint8), _pointer(bpm, ctypes.c_int32))
+        return beats, bpm
+
+
+class SpO2Calculator(_Resettable):
+    """spo2_Algorithm.cpp's ratio-of-ratios estimate over its 100-sample buffer"""
+    _prefix = "cardiac_spo2_"
+
+    def process(self, ir, red):
+        """Returns (spo2, valid) after each sample"""
+        ir = np.ascontiguousarray(ir, np.uint32)
+        red = np.ascontiguousarray(red, np.uint32)
+        count = len(ir)
+        spo2 = np.empty(count, np.float32)
+        valid = np.empty(count, np.uint8)
+        self._lib.cardiac_spo2_process(
+            self._handle, _pointer(ir, ctypes.c_uint32), _pointer(red, ctypes.c_uint32), count,
+            _pointer(spo2, ctypes.c_float), _pointer(valid, ctypes.c_uint8))
+        return spo2, valid
+
+
+class PpgEstimator(_Resettable):
+    """The monitor core's heart rate / SpO2 path: 100-sample windows at 25 Hz through the MAX3010x library's estimator"""
+    _prefix = "cardiac_ppg_"
+
+    def process(self, red, ir):
+        """Returns (windows, ends, finger): a VITALS_DTYPE array with one entry
+        per completed window, the index of the sample that completed each, and
+        finger presence after every sample"""
+        red = np.ascontiguousarray(red, np.uint32)
+        ir = np.ascontiguousarray(ir, np.uint32)
+        count = len(red)
+        capacity = count // PPG_WINDOW_SAMPLES + 1
+        windows = np.zeros(capacity, VITALS_DTYPE)
+        ends = np.empty(capacity, np.uint32)
+        finger = np.empty(count, np.uint8)
+        written = self._lib.cardiac_ppg_process(
+            self._handle, _pointer(red, ctypes.c_uint32), _pointer(ir, ctypes.c_uint32), count,
+            _pointer(finger, ctypes.c_uint8), windows.ctypes.data, _pointer(ends, ctypes.c_uint32), capacity, None)
+        return windows[:written], ends[:written], finger
+
+
+class AlarmRules(_Resettable):
+    """vitals_pipeline.cpp's alarm rules, cooldown included"""
+    _prefix = "cardiac_alarms_"
+
+    def process(self, vitals, thresholds=None):
+        """Checks a VITALS_DTYPE array at each reading's timestamp_ms; returns
+        (alarms, at): an ALARM_DTYPE array and the index of the reading behind each"""
+        vitals = np.ascontiguousarray(vitals, VITALS_DTYPE)
+        if thresholds is None:
+            thresholds = default_thresholds()
+        count = len(vitals)
+        alarms = np.zeros(count, ALARM_DTYPE)
+        at = np.empty(count, np.uint32)
+        raised = self._lib.cardiac_alarms_process(
+            self._handle, ctypes.byref(thresholds), vitals.ctypes.data, count, alarms.ctypes.data,
+            _pointer(at, ctypes.c_uint32), count)
+        return alarms[:raised], at[:raised]
+
+
+def format_alarm(alarm):
+    """"Heart rate: 42 BPM" etc., as the monitor shows it"""
+    record = np.array([alarm], ALARM_DTYPE)
+    buffer = ctypes.create_string_buffer(96)
+    load().cardiac_alarm_format(record.ctypes.data, buffer, len(buffer))
+    return buffer.value.decode()
+
+
+# ==================== SIMULATION ====================
+def simulate(seconds, params=None, seed=1, sample_rate=PPG_SAMPLE_RATE, battery=85.0, thresholds=None, block_seconds=600):
+    """Runs the synthetic patient through the estimator and the alarm
+    rules, a block at a time. Returns (vitals, alarms): a reading per
+    completed window, stamped with the device time, and the alarms raised"""
+    generator = SignalGenerator(params, sample_rate, seed)
+    estimator = PpgEstimator()
+    rules = AlarmRules()
+    total = int(seconds * sample_rate)
+    block = int(block_seconds * sample_rate)
+    readings, raised = [], []
+    done = 0
+    while done < total:
+        count = min(block, total - done)
+        samples = generator.generate(count)
+        windows, ends, _ = estimator.process(samples["red"], samples["ir"])
+        windows["battery_level"] = battery
+        windows["timestamp_ms"] = ((done + ends.astype(np.int64) + 1) * 1000 / sample_rate).astype(np.uint32)
+        alarms, _ = rules.process(windows, thresholds)
+        readings.append(windows)
+        raised.append(alarms)
+        done += count
+    return np.concatenate(readings), np.concatenate(raised)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Run the native build's signal path on a synthetic patient")
+    parser.add_argument("--hours", type=float, default=1.0)
+    parser.add_argument("--hr", type=float, default=72.0, help="heart rate, BPM")
+    parser.add_argument("--spo2", type=float, default=97.0, help="saturation, %%")
+    parser.add_argument("--motion", type=float, default=0.0, help="motion artifacts per minute")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--lib", help="path of libcardiac_dsp.so")
+    args = parser.parse_args()
+
+    load(args.lib)
+    params = default_physiology()
+    params.heart_rate = args.hr
+    params.spo2 = args.spo2
+    params.motion_rate = args.motion
+    started = time.time()
+    vitals, alarms = simulate(args.hours * 3600, params, args.seed)
+    elapsed = time.time() - started
+
+    valid = vitals[vitals["heart_rate"] > 0]
+    print(f"{args.hours:g} h of signal in {elapsed:.2f} s ({args.hours * 3600 / elapsed:.0f}x real time)")
+    print(f"{len(vitals)} readings, heart rate {np.mean(valid['heart_rate']):.1f} BPM, "
+          f"SpO2 {np.mean(valid['spo2']):.1f} %" if len(valid) else f"{len(vitals)} readings, none valid")
+    print(f"{len(alarms)} alarms")
+    for alarm in alarms[:5]:
+        print(f"  {alarm['timestamp_ms'] / 1000:9.1f} s  {format_alarm(alarm)}")
+
+
+if __name__ == "__main__":
+    main()
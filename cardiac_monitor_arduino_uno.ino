@@ -20,8 +20,14 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_ILI9341.h>
 #include "MAX30105.h"
-#include "heartRate.h"
-#include "spo2_algorithm.h"
+#include "target_profile.h"
+#include "vital_signs.h"
+#include "vitals_pipeline.h"
+#include "monitor_core.h"
+
+#if !defined(TARGET_UNO)
+#error "Build with -DTARGET_UNO; see [env:uno] in platformio.ini"
+#endif
 
 // ==================== PIN DEFINITIONS ====================
 // Display Pins (SPI)
@@ -40,39 +46,17 @@
 #define BATTERY_PIN A0 // Analog input for battery
 
 // ==================== CONFIGURATION ====================
-// System Configuration
+// System Configuration; intervals and buffer sizes are the Uno profile's
+// (target_profile.h)
 const char* FIRMWARE_VERSION = "1.0.0";
-const int SENSOR_UPDATE_INTERVAL = 100;  // ms
-const int DISPLAY_UPDATE_INTERVAL = 500; // ms, slower for Uno
-const int DATA_LOG_INTERVAL = 5000;      // ms, less frequent
-
-// Sensor Configuration
-const int SAMPLE_RATE = 50;  // Reduced for Uno
-const int BUFFER_SIZE = 50;  // Smaller buffer to save memory
-const int FINGER_THRESHOLD = 50000;
-
-// Alert Thresholds
-struct AlertThresholds {
-    float heartRateMin = 60.0f;
-    float heartRateMax = 100.0f;
-    float spO2Min = 95.0f;
-    float batteryMin = 20.0f;
-};
+const int SENSOR_UPDATE_INTERVAL = TargetProfile::SENSOR_INTERVAL_MS;
+const int DISPLAY_UPDATE_INTERVAL = TargetProfile::DISPLAY_INTERVAL_MS;
+const int DATA_LOG_INTERVAL = TargetProfile::LOG_INTERVAL_MS;
+const int ALERT_CHECK_INTERVAL = TargetProfile::ALERT_INTERVAL_MS;
 
 // ==================== DATA STRUCTURES ====================
-struct VitalSigns {
-    float heartRate = 0;
-    float spO2 = 0;
-    float batteryLevel = 0;
-    bool isFingerDetected = false;
-    unsigned long timestamp = 0;
-};
-
-enum class AlertLevel {
-    INFO,
-    WARNING,
-    CRITICAL
-};
+// VitalSigns, AlertThresholds, AlertLevel and the alarm rules are the
+// ESP32 monitor's; the sensor, log and alarm path is monitor_core.h
 
 struct Alert {
     AlertLevel level;
@@ -85,6 +69,28 @@ enum class ScreenType {
     HISTORY
 };
 
+// ==================== FUNCTION PROTOTYPES ====================
+// Written out so the sketch also builds as plain C++
+bool initializeDisplay();
+void showSplashScreen();
+void showMainScreen();
+void updateVitalSigns();
+void showHistoryScreen();
+void showError(const String& title, const String& message);
+bool initializeSensor();
+void updateSensors();
+void handleButtons();
+void handleScreenTimeout();
+void logData();
+void saveDataToEEPROM();
+void loadDataFromEEPROM();
+void checkAlerts();
+void showAlert();
+void playAlertSound();
+void loadSettings();
+void saveSettings();
+void updateDisplay();
+
 // ==================== GLOBAL OBJECTS ====================
 Adafruit_ILI9341 tft = Adafruit_ILI9341(TFT_CS, TFT_DC, TFT_RST);
 MAX30105 particleSensor;
@@ -92,8 +98,6 @@ MAX30105 particleSensor;
 // ==================== GLOBAL VARIABLES ====================
 // System State
 ScreenType currentScreen = ScreenType::MAIN;
-VitalSigns currentVitals;
-AlertThresholds alertThresholds;
 
 // Timing Variables
 unsigned long lastSensorUpdate = 0;
@@ -101,17 +105,6 @@ unsigned long lastDisplayUpdate = 0;
 unsigned long lastDataLog = 0;
 unsigned long lastAlertCheck = 0;
 
-// Sensor Variables
-uint32_t irBuffer[BUFFER_SIZE];
-uint32_t redBuffer[BUFFER_SIZE];
-int32_t bufferLength = BUFFER_SIZE;
-int32_t spo2;
-int8_t validSPO2;
-int32_t heartRate;
-int8_t validHeartRate;
-int bufferIndex = 0;
-bool fingerDetected = false;
-
 // Display Variables
 bool displayOn = true;
 unsigned long lastInputTime = 0;
@@ -120,10 +113,9 @@ const unsigned long SCREEN_TIMEOUT = 30000; // 30 seconds
 // Alert Variables
 Alert activeAlert;
 bool alertActive = false;
-const unsigned long ALERT_COOLDOWN = 5000; // 5 seconds
 
-// Data Logging (EEPROM)
-const int DATA_BUFFER_SIZE = 10; // Limited by EEPROM size
+// Data Logging (EEPROM); oldest first
+const int DATA_BUFFER_SIZE = TargetProfile::HISTORY;
 VitalSigns dataBuffer[DATA_BUFFER_SIZE];
 int dataBufferIndex = 0;
 
@@ -135,11 +127,57 @@ int dataBufferIndex = 0;
 #define COLOR_BLUE      0x001F
 #define COLOR_YELLOW    0xFFE0
 #define COLOR_ORANGE    0xFD20
+#define COLOR_GRAY      0x7BEF
 
 // EEPROM Configuration
-#define EEPROM_SIZE 1024
 #define EEPROM_DATA_START 0
 #define EEPROM_SETTINGS_ADDR 500
+#define EEPROM_RECORD_SIZE 16
+
+// ==================== MONITOR CORE ====================
+// The MAX30102 and ADC straight from the libraries, settings and readings
+// in EEPROM; no instrumentation
+struct UnoBoard {
+    static uint16_t check() { return particleSensor.check(); }
+    static bool available() { return particleSensor.available(); }
+    static uint32_t getRed() { return particleSensor.getRed(); }
+    static uint32_t getIR() { return particleSensor.getIR(); }
+    static void nextSample() { particleSensor.nextSample(); }
+    static uint16_t readBattery() { return analogRead(BATTERY_PIN); }
+    static uint32_t now() { return millis(); }
+};
+
+struct UnoSettings {
+    static void load(AlertThresholds& thresholds) {
+        AlertThresholds stored;
+        EEPROM.get(EEPROM_SETTINGS_ADDR, stored);
+        // Erased EEPROM reads as NaN; keep the defaults until first saved
+        if (stored.heartRateMin >= 20 && stored.heartRateMax <= 250 && stored.spO2Min >= 50 &&
+            stored.spO2Min <= 100 && stored.batteryMin >= 0 && stored.batteryMin <= 100) {
+            thresholds = stored;
+        }
+    }
+
+    // put() skips bytes that are unchanged, sparing the EEPROM
+    static void save(const AlertThresholds& thresholds) {
+        EEPROM.put(EEPROM_SETTINGS_ADDR, thresholds);
+    }
+};
+
+struct UnoLog {
+    static void append(const VitalSigns& vitals) {
+        if (dataBufferIndex == DATA_BUFFER_SIZE) {
+            memmove(dataBuffer, dataBuffer + 1, sizeof(VitalSigns) * (DATA_BUFFER_SIZE - 1));
+            dataBufferIndex--;
+        }
+        dataBuffer[dataBufferIndex++] = vitals;
+    }
+
+    static void flush() { saveDataToEEPROM(); }
+};
+
+MonitorCore<TargetProfile, UnoBoard, UnoSettings, UnoLog> monitor;
+VitalSigns& currentVitals = monitor.getVitals();
 
 // ==================== SETUP FUNCTION ====================
 void setup() {
@@ -154,8 +192,7 @@ void setup() {
     pinMode(BATTERY_PIN, INPUT);
     digitalWrite(BUZZER_PIN, LOW);
     
-    // Initialize EEPROM
-    EEPROM.begin(EEPROM_SIZE);
+    // Settings and readings from EEPROM
     loadSettings();
     loadDataFromEEPROM();
     
@@ -207,7 +244,7 @@ void loop() {
     }
     
     // Check alerts
-    if (currentTime - lastAlertCheck >= 1000) {
+    if (currentTime - lastAlertCheck >= ALERT_CHECK_INTERVAL) {
         lastAlertCheck = currentTime;
         checkAlerts();
     }
@@ -376,7 +413,7 @@ bool initializeSensor() {
         return false;
     }
     
-    particleSensor.setup();
+    particleSensor.setup(0x1F, 4, 2, 100, 411, 4096);     // 25 samples/s, FreqS
     particleSensor.setPulseAmplitudeRed(0x0A);
     particleSensor.setPulseAmplitudeGreen(0);
     
@@ -385,49 +422,7 @@ bool initializeSensor() {
 }
 
 void updateSensors() {
-    currentVitals.batteryLevel = readBatteryLevel();
-    currentVitals.timestamp = millis();
-    
-    if (particleSensor.available()) {
-        redBuffer[bufferIndex] = particleSensor.getRed();
-        irBuffer[bufferIndex] = particleSensor.getIR();
-        
-        fingerDetected = (irBuffer[bufferIndex] > FINGER_THRESHOLD);
-        currentVitals.isFingerDetected = fingerDetected;
-        
-        bufferIndex++;
-        
-        if (bufferIndex >= BUFFER_SIZE) {
-            bufferIndex = 0;
-            
-            if (fingerDetected) {
-                maxim_heart_rate_and_oxygen_saturation(
-                    irBuffer, bufferLength, redBuffer,
-                    &spo2, &validSPO2, &heartRate, &validHeartRate
-                );
-                
-                if (validHeartRate && heartRate > 0 && heartRate < 200) {
-                    currentVitals.heartRate = heartRate;
-                }
-                
-                if (validSPO2 && spo2 > 0 && spo2 <= 100) {
-                    currentVitals.spO2 = spo2;
-                }
-            } else {
-                currentVitals.heartRate = 0;
-                currentVitals.spO2 = 0;
-            }
-        }
-        
-        particleSensor.nextSample();
-    }
-}
-
-float readBatteryLevel() {
-    int rawValue = analogRead(BATTERY_PIN);
-    float voltage = (rawValue / 1023.0) * 5.0; // 5V reference
-    float percentage = ((voltage - 3.0) / 1.2) * 100.0;
-    return constrain(percentage, 0, 100);
+    monitor.updateSensors();
 }
 
 // ==================== BUTTON HANDLING ====================
@@ -469,18 +464,18 @@ void handleScreenTimeout() {
 
 // ==================== DATA LOGGING ====================
 void logData() {
-    if (currentVitals.isFingerDetected && currentVitals.heartRate > 0) {
-        if (dataBufferIndex < DATA_BUFFER_SIZE) {
-            dataBuffer[dataBufferIndex] = currentVitals;
-            dataBufferIndex++;
-            saveDataToEEPROM();
-        }
-    }
+    monitor.logData();
 }
 
 void saveDataToEEPROM() {
+    // Unused records are zeroed, so loading skips them
     int addr = EEPROM_DATA_START;
-    for (int i = 0; i < dataBufferIndex; i++) {
+    for (int i = 0; i < DATA_BUFFER_SIZE; i++) {
+        if (i >= dataBufferIndex) {
+            for (int b = 0; b < EEPROM_RECORD_SIZE; b++) EEPROM.update(addr + b, 0);
+            addr += EEPROM_RECORD_SIZE;
+            continue;
+        }
         VitalSigns& data = dataBuffer[i];
         EEPROM.put(addr, data.heartRate);
         addr += sizeof(float);
@@ -491,13 +486,12 @@ void saveDataToEEPROM() {
         EEPROM.put(addr, data.timestamp);
         addr += sizeof(unsigned long);
     }
-    EEPROM.commit();
 }
 
 void loadDataFromEEPROM() {
     int addr = EEPROM_DATA_START;
     dataBufferIndex = 0;
-    while (addr < EEPROM_SETTINGS_ADDR && dataBufferIndex < DATA_BUFFER_SIZE) {
+    while (addr + EEPROM_RECORD_SIZE <= EEPROM_SETTINGS_ADDR && dataBufferIndex < DATA_BUFFER_SIZE) {
         VitalSigns data;
         EEPROM.get(addr, data.heartRate);
         addr += sizeof(float);
@@ -508,6 +502,7 @@ void loadDataFromEEPROM() {
         EEPROM.get(addr, data.timestamp);
         addr += sizeof(unsigned long);
         
+        // Zeroed or never written (NaN); both fail the comparison
         if (data.heartRate > 0 && data.spO2 > 0) {
             dataBuffer[dataBufferIndex] = data;
             dataBufferIndex++;
@@ -517,35 +512,12 @@ void loadDataFromEEPROM() {
 
 // ==================== ALERT SYSTEM ====================
 void checkAlerts() {
-    if (millis() - lastAlertCheck < ALERT_COOLDOWN) return;
-    
-    if (currentVitals.isFingerDetected && currentVitals.heartRate > 0) {
-        if (currentVitals.heartRate < alertThresholds.heartRateMin || 
-            currentVitals.heartRate > alertThresholds.heartRateMax) {
-            snprintf(activeAlert.message, 20, "HR: %d BPM", (int)currentVitals.heartRate);
-            activeAlert.level = AlertLevel::WARNING;
-            activeAlert.timestamp = millis();
-            alertActive = true;
-            showAlert();
-            playAlertSound();
-        }
-    }
-    
-    if (currentVitals.isFingerDetected && currentVitals.spO2 > 0) {
-        if (currentVitals.spO2 < alertThresholds.spO2Min) {
-            snprintf(activeAlert.message, 20, "SpO2: %d%%", (int)currentVitals.spO2);
-            activeAlert.level = AlertLevel::WARNING;
-            activeAlert.timestamp = millis();
-            alertActive = true;
-            showAlert();
-            playAlertSound();
-        }
-    }
-    
-    if (currentVitals.batteryLevel < alertThresholds.batteryMin) {
-        snprintf(activeAlert.message, 20, "Bat: %d%%", (int)currentVitals.batteryLevel);
-        activeAlert.level = AlertLevel::WARNING;
-        activeAlert.timestamp = millis();
+    // The most severe of heart rate, SpO2 and battery; the rules apply the cooldown
+    AlarmEvent alarm;
+    if (monitor.checkAlerts(alarm)) {
+        formatAlarmMessage(alarm, activeAlert.message, sizeof(activeAlert.message));
+        activeAlert.level = alarm.level;
+        activeAlert.timestamp = alarm.timestamp;
         alertActive = true;
         showAlert();
         playAlertSound();
@@ -577,12 +549,11 @@ void playAlertSound() {
 
 // ==================== SETTINGS MANAGEMENT ====================
 void loadSettings() {
-    EEPROM.get(EEPROM_SETTINGS_ADDR, alertThresholds);
+    monitor.loadSettings();
 }
 
 void saveSettings() {
-    EEPROM.put(EEPROM_SETTINGS_ADDR, alertThresholds);
-    EEPROM.commit();
+    monitor.saveSettings();
 }
 
 // ==================== DISPLAY UPDATE ====================
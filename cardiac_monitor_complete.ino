@@ -6,9 +6,12 @@
  * Hardware Requirements:
  * - ESP32 Development Board
  * - MAX30102 Heart Rate/SpO2 Sensor
- * - ILI9341 3.2" TFT Display with Touch
+ * - ILI9341 3.2" TFT Display with Touch, on SPI or, with the
+ *   esp32_parallel environment, on an 8-bit parallel bus
  * - XPT2046 Touch Controller
  * - LiPo Battery with TP4056 Charger
+ * - Optional AD8232 ECG front end on ECG_PIN, traced on the main screen
+ *   with the esp32_ecg environment
  * 
  * WARNING: This is for educational purposes only. Not for medical use.
  */
@@ -17,81 +20,50 @@
 #include <WebServer.h>
 #include <DNSServer.h>
 #include <Preferences.h>
-#include <SPIFFS.h>
-#include <ArduinoJson.h>
 #include <SPI.h>
 #include <Adafruit_GFX.h>
-#include <Adafruit_ILI9341.h>
-#include <XPT2046_Touchscreen.h>
 #include <Wire.h>
-#include "MAX30105.h"
-#include "heartRate.h"
-#include "spo2_algorithm.h"
-
-// ==================== PIN DEFINITIONS ====================
-// Display Pins
-#define TFT_CS    5
-#define TFT_DC    2
-#define TFT_MOSI  23
-#define TFT_CLK   18
-#define TFT_RST   4
-#define TFT_MISO  19
-
-// Touch Pins
-#define TOUCH_CS  15
-#define TOUCH_IRQ 21
-
-// Sensor Pins (I2C)
-#define SDA_PIN   21
-#define SCL_PIN   22
-
-// Battery and Buzzer
-#define BATTERY_PIN 36
-#define BUZZER_PIN  25
+#include "target_profile.h"
+#include "display_panel.h"
+#include "board_pins.h"
+#include "hal.h"
+#include "vital_signs.h"
+#include "vitals_pipeline.h"
+#include "monitor_core.h"
+#include "http_stream.h"
+#include "vitals_log.h"
+#include "vitals_history.h"
+#include "uplink.h"
+#include "wifi_manager.h"
+#include "metrics.h"
+#include "profiler.h"
+#include "latency_trace.h"
+#include "trace_log.h"
+#include "memory_accounting.h"
+#include "self_benchmark.h"
+#include "journal.h"
+#include "web_interface.h"
 
 // ==================== CONFIGURATION ====================
 // System Configuration
 const char* FIRMWARE_VERSION = "2.0.0";
 const char* DEVICE_NAME = "CardiacMonitor";
-const int SENSOR_UPDATE_INTERVAL = 100;  // ms
-const int DISPLAY_UPDATE_INTERVAL = 100; // ms
-const int DATA_LOG_INTERVAL = 1000;      // ms
-
-// Sensor Configuration
-const int SAMPLE_RATE = 100;
-const int BUFFER_SIZE = 500;
-const int FINGER_THRESHOLD = 50000;
-const int SPO2_BUFFER_SIZE = 100;
+const int SENSOR_UPDATE_INTERVAL = TargetProfile::SENSOR_INTERVAL_MS;
+const int DISPLAY_UPDATE_INTERVAL = TargetProfile::DISPLAY_INTERVAL_MS;
+const int DATA_LOG_INTERVAL = TargetProfile::LOG_INTERVAL_MS;
+const int ALERT_CHECK_INTERVAL = TargetProfile::ALERT_INTERVAL_MS;
 
 // WiFi Configuration
 const char* AP_SSID = "CardiacMonitor_Setup";
 const char* AP_PASSWORD = "12345678";
-const int CONNECTION_TIMEOUT = 10000;
-const int MAX_RETRY_ATTEMPTS = 3;
-
-// Alert Thresholds
-struct AlertThresholds {
-    float heartRateMin = 60.0f;
-    float heartRateMax = 100.0f;
-    float spO2Min = 95.0f;
-    float batteryMin = 20.0f;
-    bool enabled = true;
-};
 
-// ==================== DATA STRUCTURES ====================
-struct VitalSigns {
-    float heartRate = 0;
-    float spO2 = 0;
-    float batteryLevel = 0;
-    bool isFingerDetected = false;
-    unsigned long timestamp = 0;
-};
+// Buzzer
+const uint16_t BUZZER_FREQUENCY = 2700; // Hz, resonance of the buzzer; ignored by active buzzers
 
-enum class AlertLevel {
-    INFO,
-    WARNING,
-    CRITICAL
-};
+// ==================== DATA STRUCTURES ====================
+// VitalSigns and its JSON schemas live in vital_signs.h; AlertThresholds,
+// AlertLevel and the alarm rules in vitals_pipeline.h; the sensor, log and
+// alarm path in monitor_core.h
 
 struct Alert {
     AlertLevel level;
@@ -117,43 +89,34 @@ enum class ScreenType {
 };
 
 // ==================== GLOBAL OBJECTS ====================
-Adafruit_ILI9341 tft = Adafruit_ILI9341(TFT_CS, TFT_DC, TFT_MOSI, TFT_CLK, TFT_RST, TFT_MISO);
-XPT2046_Touchscreen ts(TOUCH_CS, TOUCH_IRQ);
-MAX30105 particleSensor;
+DisplayPanel tft = DISPLAY_PANEL_INIT;
 WebServer server(80);
 DNSServer dnsServer;
-Preferences preferences;
+JournaledPreferences preferences;     // Settings are inputs too, for the journal
+WifiManager wifiManager;
 
 // ==================== GLOBAL VARIABLES ====================
 // System State
 SystemState currentState = SystemState::INITIALIZING;
 ScreenType currentScreen = ScreenType::MAIN;
-VitalSigns currentVitals;
-AlertThresholds alertThresholds;
 
 // Timing Variables
 unsigned long lastSensorUpdate = 0;
 unsigned long lastDisplayUpdate = 0;
 unsigned long lastDataLog = 0;
 unsigned long lastAlertCheck = 0;
+unsigned long lastEcgSample = 0;
 
 // WiFi Variables
 String wifiSSID = "";
 String wifiPassword = "";
 bool wifiConnected = false;
 bool configModeActive = false;
-int connectionAttempts = 0;
-
-// Sensor Variables
-uint32_t irBuffer[BUFFER_SIZE];
-uint32_t redBuffer[BUFFER_SIZE];
-int32_t bufferLength = BUFFER_SIZE;
-int32_t spo2;
-int8_t validSPO2;
-int32_t heartRate;
-int8_t validHeartRate;
-int bufferIndex = 0;
-bool fingerDetected = false;
+
+// Dashboard files in /www, from the table tools/gzip_www.py writes
+const int MAX_ASSETS = 8;
+StaticAsset dashboardAssets[MAX_ASSETS];
+int dashboardAssetCount = 0;
 
 // Display Variables
 int screenBrightness = 128;
@@ -161,15 +124,14 @@ bool displayOn = true;
 unsigned long lastTouchTime = 0;
 const unsigned long SCREEN_TIMEOUT = 30000; // 30 seconds
 
-// Alert Variables
-std::vector<Alert> activeAlerts;
-std::vector<Alert> alertHistory;
-unsigned long lastAlertTime = 0;
-const unsigned long ALERT_COOLDOWN = 5000; // 5 seconds
+// Alert Variables; both charged to memoryAlerts
+typedef std::vector<Alert, AccountedAllocator<Alert>> AlertList;
+AlertList activeAlerts{AccountedAllocator<Alert>(memoryAlerts)};
+AlertList alertHistory{AccountedAllocator<Alert>(memoryAlerts)};
 
-// Data Logging
-std::vector<VitalSigns> dataBuffer;
-const int DATA_BUFFER_SIZE = 100;
+// Data Logging; reserved once in setup() so trimming never reallocates
+std::vector<VitalSigns, AccountedAllocator<VitalSigns>> dataBuffer{AccountedAllocator<VitalSigns>(memoryVitals)};
+const int DATA_BUFFER_SIZE = TargetProfile::HISTORY;
 
 // Colors
 #define COLOR_BLACK     0x0000
@@ -183,16 +145,195 @@ const int DATA_BUFFER_SIZE = 100;
 #define COLOR_GRAY      0x7BEF
 #define COLOR_DARKGRAY  0x39E7
 
+// ==================== FUNCTION PROTOTYPES ====================
+// Written out so the sketch also builds as plain C++ (see native/sketch.cpp)
+bool initializeDisplay();
+void showSplashScreen();
+void showMainScreen();
+void drawStatusBar();
+void drawVitalSignsLayout();
+void drawMainButtons();
+void updateVitalSigns();
+void drawWaveform();
+void sampleEcg();
+void drawEcgTrace();
+void showError(const String& title, const String& message);
+void showSettingsScreen();
+void showHistoryScreen();
+void drawHeart(int x, int y, uint16_t color);
+bool initializeSensor();
+void updateSensors();
+float readBatteryLevel();
+void handleTouch();
+void handleTouchEvent(int x, int y);
+void handleMainScreenTouch(int x, int y);
+void handleSettingsScreenTouch(int x, int y);
+void handleHistoryScreenTouch(int x, int y);
+void handleScreenTimeout();
+void initializeWiFi();
+void onWiFiStateChange(WifiState previous, WifiState current);
+void handleWiFiConnection();
+void startConfigMode();
+void appendEncoded(String& out, const String& text);
+String requestTarget();
+void onJournaled(const char* uri, void (*handler)());
+void setupWebServer();
+void setupConfigServer();
+void handleRoot();
+void handleConfigRoot();
+void handleConfigSave();
+void handleWiFiScan();
+void setupDashboardRoutes();
+void broadcastVitals();
+void serveAsset(const StaticAsset& asset);
+void sendChunked(int code, const char* contentType, ChunkGenerator& generator);
+void sendFile(const char* path, const char* contentType, bool acceptRanges);
+void handleDataRequest();
+void handleExportRequest();
+void handleMetricsRequest();
+void handleProfileRequest();
+void handleJournalRequest();
+void handleStatusRequest();
+void handleHistoryRequest();
+void logData();
+void saveDataToFile();
+bool parseDataLine(const char* line, VitalSigns& data);
+void loadDataFromFile();
+void exportData();
+void clearData();
+void checkAlerts();
+void triggerAlert(AlertLevel level, const String& message);
+void raiseAlert(AlertLevel level, const String& message, uint32_t sequence);
+void playAlertSound(AlertLevel level);
+void showAlert(const String& message, AlertLevel level);
+void removeOldAlerts();
+void loadSettings();
+void saveSettings();
+void updateDisplay();
+String formatTime(unsigned long timestamp);
+void printSystemInfo();
+void performSelfTest();
+void handleSerialCommands();
+void printProfile();
+void printMemoryReport();
+void runBenchmark();
+void watchdogFeed();
+void handleLowPowerMode();
+void checkMemoryUsage();
+void initializeSystem();
+void handleSystemError(const String& errorMessage);
+void loopIteration();
+
+// ==================== MONITOR CORE ====================
+static_assert(TargetProfile::HAS_WIFI && TargetProfile::HAS_FLASH_LOG && TargetProfile::HAS_INSTRUMENTATION,
+              "this is the ESP32 monitor; the Uno profile builds cardiac_monitor_arduino_uno.ino");
+
+// The board behind the core: the sensor and ADC through the HAL, settings
+// in NVS, readings into the history buffer and the flash log
+struct SketchBoard {
+    static uint16_t check() { return hal.sensor->check(); }
+    static bool available() { return hal.sensor->available(); }
+    static uint32_t getRed() { return hal.sensor->getRed(); }
+    static uint32_t getIR() { return hal.sensor->getIR(); }
+    static void nextSample() { hal.sensor->nextSample(); }
+    static uint16_t readBattery() { return hal.adc->read(BATTERY_PIN); }
+    static uint32_t now() { return millis(); }
+};
+
+struct SketchSettings {
+    static void load(AlertThresholds& thresholds) {
+        thresholds.heartRateMin = preferences.getFloat("hr_min", 60.0f);
+        thresholds.heartRateMax = preferences.getFloat("hr_max", 100.0f);
+        thresholds.spO2Min = preferences.getFloat("spo2_min", 95.0f);
+        thresholds.batteryMin = preferences.getFloat("bat_min", 20.0f);
+        thresholds.enabled = preferences.getBool("alerts_en", true);
+        screenBrightness = preferences.getInt("brightness", 128);
+    }
+
+    static void save(const AlertThresholds& thresholds) {
+        preferences.putFloat("hr_min", thresholds.heartRateMin);
+        preferences.putFloat("hr_max", thresholds.heartRateMax);
+        preferences.putFloat("spo2_min", thresholds.spO2Min);
+        preferences.putFloat("bat_min", thresholds.batteryMin);
+        preferences.putBool("alerts_en", thresholds.enabled);
+        preferences.putInt("brightness", screenBrightness);
+    }
+};
+
+struct SketchLog {
+    static void append(const VitalSigns& vitals) {
+        dataBuffer.push_back(vitals);
+        vitalsLog.append(vitals);
+        
+        // Limit buffer size
+        if (dataBuffer.size() > DATA_BUFFER_SIZE) {
+            dataBuffer.erase(dataBuffer.begin());
+        }
+    }
+
+    static void flush() { saveDataToFile(); }
+};
+
+// Metrics, the profiler and the latency tracer
+struct SketchEvents {
+    struct SampleScope {
+        MetricTimer sampleTimer{metricSampleLatency};
+#if PROFILING_ENABLED
+        ProfileScope estimatorScope{profileEstimator};
+#endif
+    };
+
+    // Newest sensor burst; the outputs derived from it are timed back to it
+    static uint32_t burst;
+
+    static void burstArrived(uint16_t arrived) {
+        // 32 means the FIFO was full and older samples were lost
+        if (arrived >= 32) {
+            metricFifoOverflows.inc();
+        }
+        if (arrived > 0) {
+            burst = latencyTracer.acquired(micros());
+        }
+    }
+
+    static void windowEstimated(VitalSigns& vitals) {
+        vitals.sequence = burst;
+        latencyTracer.reached(LatencyPath::ESTIMATE, burst, micros());
+    }
+
+    static void alarmRaised(const AlarmEvent& alarm) {
+        latencyTracer.reached(LatencyPath::ALARM, alarm.sequence, micros());
+    }
+};
+
+uint32_t SketchEvents::burst = 0;
+
+MonitorCore<TargetProfile, SketchBoard, SketchSettings, SketchLog, SketchEvents> monitor;
+VitalSigns& currentVitals = monitor.getVitals();
+AlertThresholds& alertThresholds = monitor.getThresholds();
+
 // ==================== SETUP FUNCTION ====================
 void setup() {
     Serial.begin(115200);
+    traceLog.begin();
+    // Before anything reads an input
+    journal.begin();
+#ifdef CONFIG_ARDUINO_LOOP_STACK_SIZE
+    memoryTrackTask("loop", xTaskGetCurrentTaskHandle(), CONFIG_ARDUINO_LOOP_STACK_SIZE, false);
+#else
+    memoryTrackTask("loop", xTaskGetCurrentTaskHandle(), 8192, false);
+#endif
+    
+    // Allocated up front, at their largest, while the heap is still whole
+    dataBuffer.reserve(DATA_BUFFER_SIZE + 1);
+    alertHistory.reserve(51);
+    activeAlerts.reserve(16);
     Serial.println("\n=== Cardiac Monitor v2.0 ===");
     Serial.println("Initializing system...");
     
     // Initialize pins
-    pinMode(BUZZER_PIN, OUTPUT);
+    hal.tone->begin(BUZZER_PIN);
     pinMode(BATTERY_PIN, INPUT);
-    digitalWrite(BUZZER_PIN, LOW);
     
     // Initialize preferences
     preferences.begin("cardiac", false);
@@ -208,10 +349,12 @@ void setup() {
     delay(2000);
     
     // Initialize SPIFFS
-    if (!SPIFFS.begin(true)) {
+    if (!hal.storage->begin(true)) {
         Serial.println("SPIFFS initialization failed");
         showError("Storage Error", "Failed to initialize storage");
         delay(3000);
+    } else {
+        vitalsLog.begin();
     }
     
     // Initialize sensor
@@ -224,74 +367,37 @@ void setup() {
     // Initialize WiFi
     initializeWiFi();
     
+    // Upload the vitals log to the collector whenever WiFi is up
+    uplink.begin(preferences.getString("uplink_url", "").c_str());
+    
     // System ready
     currentState = SystemState::RUNNING;
     currentScreen = ScreenType::MAIN;
+    
+    // Boot option for benchmarking a batch: set with `bench boot on`
+    if (preferences.getBool("bench_boot", false)) {
+        runBenchmark();
+    }
     showMainScreen();
     
     Serial.println("System initialization complete");
     Serial.println("=================================");
 }
 
-// ==================== MAIN LOOP ====================
-void loop() {
-    unsigned long currentTime = millis();
-    
-    // Handle WiFi and web server
-    if (configModeActive) {
-        dnsServer.processNextRequest();
-        server.handleClient();
-    } else {
-        handleWiFiConnection();
-    }
-    
-    // Handle touch input
-    handleTouch();
-    
-    // Update sensors
-    if (currentTime - lastSensorUpdate >= SENSOR_UPDATE_INTERVAL) {
-        lastSensorUpdate = currentTime;
-        updateSensors();
-    }
-    
-    // Update display
-    if (currentTime - lastDisplayUpdate >= DISPLAY_UPDATE_INTERVAL) {
-        lastDisplayUpdate = currentTime;
-        updateDisplay();
-    }
-    
-    // Log data
-    if (currentTime - lastDataLog >= DATA_LOG_INTERVAL) {
-        lastDataLog = currentTime;
-        logData();
-    }
-    
-    // Check alerts
-    if (currentTime - lastAlertCheck >= 1000) { // Check every second
-        lastAlertCheck = currentTime;
-        checkAlerts();
-    }
-    
-    // Handle screen timeout
-    handleScreenTimeout();
-    
-    delay(10); // Prevent watchdog timeout
-}
-
 // ==================== DISPLAY FUNCTIONS ====================
 bool initializeDisplay() {
     Serial.println("Initializing display...");
     
-    tft.begin();
+    beginDisplayPanel(tft);
     tft.setRotation(1); // Landscape
     tft.fillScreen(COLOR_BLACK);
     
-    if (!ts.begin()) {
+    if (!hal.touch->begin()) {
         Serial.println("Touch screen initialization failed");
         return false;
     }
     
-    ts.setRotation(1);
+    hal.touch->setRotation(1);
     
     Serial.println("Display initialized successfully");
     return true;
@@ -376,7 +482,7 @@ void drawVitalSignsLayout() {
     // Waveform area
     tft.drawRect(10, 130, 300, 60, COLOR_WHITE);
     tft.setCursor(15, 135);
-    tft.println("Waveform");
+    tft.println(TargetProfile::HAS_ECG_TRACE ? "ECG" : "Waveform");
 }
 
 void drawMainButtons() {
@@ -401,6 +507,7 @@ void drawMainButtons() {
 void updateVitalSigns() {
     // Update heart rate display
     tft.fillRect(15, 55, 130, 60, COLOR_BLACK);
+    metricSpiBytes.add((130 * 60 + 130 * 60 + 100 * 10) * 2); // All three fills below
     tft.setTextColor(COLOR_RED);
     tft.setTextSize(3);
     tft.setCursor(20, 70);
@@ -426,20 +533,28 @@ void updateVitalSigns() {
     tft.setCursor(15, 105);
     tft.fillRect(15, 105, 100, 10, COLOR_BLACK);
     tft.println(currentVitals.isFingerDetected ? "Finger detected" : "Place finger");
+    
+    latencyTracer.reached(LatencyPath::DISPLAY, currentVitals.sequence, micros());
 }
 
 void drawWaveform() {
+    if constexpr (TargetProfile::HAS_ECG_TRACE) {
+        drawEcgTrace();
+        return;
+    }
     static int waveformX = 15;
     static int lastY = 160;
     
     // Clear old waveform point
     tft.drawPixel(waveformX, lastY, COLOR_BLACK);
+    metricSpiBytes.add(2);
     
     // Draw new point if finger detected
     if (currentVitals.isFingerDetected) {
         // Simulate waveform based on heart rate
         int waveY = 160 + sin(millis() * 0.01) * 20;
         tft.drawPixel(waveformX, waveY, COLOR_GREEN);
+        metricSpiBytes.add(2);
         lastY = waveY;
     }
     
@@ -449,7 +564,56 @@ void drawWaveform() {
         waveformX = 15;
         // Clear waveform area
         tft.fillRect(15, 140, 290, 45, COLOR_BLACK);
+        metricSpiBytes.add(290 * 45 * 2);
+    }
+}
+
+// ==================== ECG TRACE ====================
+// On profiles with HAS_ECG_TRACE the waveform box sweeps the AD8232 lead,
+// as cardiac.ino's screen did. Samples taken every ECG_INTERVAL_MS wait
+// here for the next display update, which draws one column per sample
+// and wipes a few ahead of the pen. Other profiles never reference it, so
+// the linker drops it.
+struct EcgTrace {
+    static const int PENDING = 16;      // Three display updates' worth
+    uint16_t pending[PENDING];
+    uint8_t count = 0;
+    int x = 15;
+    int lastY = -1;                     // None yet on this sweep
+};
+
+EcgTrace ecgTrace;
+
+void sampleEcg() {
+    // A display update held up past PENDING samples loses the newest
+    if (ecgTrace.count < EcgTrace::PENDING) {
+        ecgTrace.pending[ecgTrace.count++] = hal.adc->read(ECG_PIN);
+    }
+}
+
+void drawEcgTrace() {
+    // Below the label: rows 144..184, mid-scale on row 164, 64 counts a row
+    for (int i = 0; i < ecgTrace.count; i++) {
+        int y = constrain(164 - ((int)ecgTrace.pending[i] - 2048) / 64, 144, 184);
+        int x = ecgTrace.x;
+        int wipe = min(4, 306 - x);
+        tft.fillRect(x, 144, wipe, 41, COLOR_BLACK);
+        int drawn = 1;
+        if (ecgTrace.lastY < 0) {
+            tft.drawPixel(x, y, COLOR_GREEN);
+        } else {
+            tft.drawLine(x - 1, ecgTrace.lastY, x, y, COLOR_GREEN);
+            drawn = abs(y - ecgTrace.lastY) + 1;
+        }
+        metricSpiBytes.add((wipe * 41 + drawn) * 2);
+
+        ecgTrace.lastY = y;
+        if (++ecgTrace.x > 305) {
+            ecgTrace.x = 15;
+            ecgTrace.lastY = -1;
+        }
     }
+    ecgTrace.count = 0;
 }
 
 void showError(const String& title, const String& message) {
@@ -589,78 +753,36 @@ bool initializeSensor() {
     
     Wire.begin(SDA_PIN, SCL_PIN);
     
-    if (!particleSensor.begin()) {
+    if (!hal.sensor->begin()) {
         Serial.println("MAX30102 not found");
         return false;
     }
     
     // Configure sensor
-    particleSensor.setup();
-    particleSensor.setPulseAmplitudeRed(0x0A);
-    particleSensor.setPulseAmplitudeGreen(0);
+    hal.sensor->setup();
+    hal.sensor->setPulseAmplitudeRed(0x0A);
+    hal.sensor->setPulseAmplitudeGreen(0);
     
     Serial.println("MAX30102 initialized successfully");
     return true;
 }
 
 void updateSensors() {
-    // Read battery level
-    currentVitals.batteryLevel = readBatteryLevel();
-    currentVitals.timestamp = millis();
-    
-    // Read sensor data
-    if (particleSensor.available()) {
-        // Read and store data in buffers
-        redBuffer[bufferIndex] = particleSensor.getRed();
-        irBuffer[bufferIndex] = particleSensor.getIR();
-        
-        // Check finger detection
-        fingerDetected = (irBuffer[bufferIndex] > FINGER_THRESHOLD);
-        currentVitals.isFingerDetected = fingerDetected;
-        
-        bufferIndex++;
-        
-        // Process data when buffer is full
-        if (bufferIndex >= BUFFER_SIZE) {
-            bufferIndex = 0;
-            
-            if (fingerDetected) {
-                // Calculate heart rate and SpO2
-                maxim_heart_rate_and_oxygen_saturation(
-                    irBuffer, bufferLength, redBuffer,
-                    &spo2, &validSPO2, &heartRate, &validHeartRate
-                );
-                
-                if (validHeartRate && heartRate > 0 && heartRate < 200) {
-                    currentVitals.heartRate = heartRate;
-                }
-                
-                if (validSPO2 && spo2 > 0 && spo2 <= 100) {
-                    currentVitals.spO2 = spo2;
-                }
-            } else {
-                currentVitals.heartRate = 0;
-                currentVitals.spO2 = 0;
-            }
-        }
-        
-        particleSensor.nextSample();
+    PROFILE_SCOPE(profileSensors);
+    if (monitor.updateSensors()) {
+        broadcastVitals();
     }
 }
 
 float readBatteryLevel() {
-    int rawValue = analogRead(BATTERY_PIN);
-    float voltage = (rawValue / 4095.0) * 3.3 * 2; // Voltage divider
-    
-    // Convert to percentage (3.0V = 0%, 4.2V = 100%)
-    float percentage = ((voltage - 3.0) / 1.2) * 100.0;
-    return constrain(percentage, 0, 100);
+    return monitor.batteryPercent(SketchBoard::readBattery());
 }
 
 // ==================== TOUCH HANDLING ====================
 void handleTouch() {
-    if (ts.touched()) {
-        TS_Point p = ts.getPoint();
+    PROFILE_SCOPE(profileTouch);
+    if (hal.touch->touched()) {
+        HalTouchPoint p = hal.touch->getPoint();
         
         // Map touch coordinates to screen coordinates
         int x = map(p.x, 200, 3700, 0, 320);
@@ -710,7 +832,7 @@ void handleMainScreenTouch(int x, int y) {
     }
     // WiFi button (220, 200, 90, 30)
     else if (x >= 220 && x <= 310 && y >= 200 && y <= 230) {
-        startConfigMode();
+        wifiManager.openPortal(millis());
     }
 }
 
@@ -751,63 +873,54 @@ void initializeWiFi() {
     wifiSSID = preferences.getString("wifi_ssid", "");
     wifiPassword = preferences.getString("wifi_pass", "");
     
-    if (wifiSSID.length() > 0) {
-        connectToWiFi();
-    } else {
+    if (wifiSSID.length() == 0) {
         Serial.println("No WiFi credentials found");
     }
+    
+    // Returns immediately; the connection completes in the background
+    hal.network->attach(&wifiManager);
+    wifiManager.begin(hal.network, wifiSSID.c_str(), wifiPassword.c_str(), onWiFiStateChange, millis());
 }
 
-void connectToWiFi() {
-    if (wifiSSID.length() == 0) return;
-    
-    Serial.printf("Connecting to WiFi: %s\n", wifiSSID.c_str());
-    
-    WiFi.begin(wifiSSID.c_str(), wifiPassword.c_str());
+void onWiFiStateChange(WifiState previous, WifiState current) {
+    TRACE("WiFi: %s -> %s\n", WifiManager::stateName(previous), WifiManager::stateName(current));
+    wifiConnected = current == WifiState::CONNECTED;
     
-    unsigned long startTime = millis();
-    while (WiFi.status() != WL_CONNECTED && millis() - startTime < CONNECTION_TIMEOUT) {
-        delay(500);
-        Serial.print(".");
-    }
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        wifiConnected = true;
-        Serial.printf("\nWiFi connected! IP: %s\n", WiFi.localIP().toString().c_str());
-        setupWebServer();
-    } else {
-        wifiConnected = false;
-        Serial.println("\nWiFi connection failed");
-        connectionAttempts++;
-        
-        if (connectionAttempts >= MAX_RETRY_ATTEMPTS) {
-            Serial.println("Max retry attempts reached, starting config mode");
+    switch (current) {
+        case WifiState::CONNECTED:
+            TRACE("WiFi connected! IP: %s\n", WiFi.localIP().toString().c_str());
+            setupWebServer();
+            break;
+        case WifiState::BACKOFF:
+            TRACE("WiFi connection failed, retrying in %u ms\n", (unsigned)wifiManager.getBackoff());
+            break;
+        case WifiState::PORTAL:
             startConfigMode();
-        }
+            break;
+        default:
+            break;
     }
 }
 
 void handleWiFiConnection() {
-    if (!wifiConnected && WiFi.status() == WL_CONNECTED) {
-        wifiConnected = true;
-        Serial.println("WiFi reconnected");
-        setupWebServer();
-    } else if (wifiConnected && WiFi.status() != WL_CONNECTED) {
-        wifiConnected = false;
-        Serial.println("WiFi disconnected");
-    }
+    wifiManager.update(millis());
 }
 
 void startConfigMode() {
+    if (configModeActive) return;
     Serial.println("Starting WiFi configuration mode...");
     
     configModeActive = true;
     
-    // Start access point
-    WiFi.softAP(AP_SSID, AP_PASSWORD);
-    
-    // Start DNS server
-    dnsServer.start(53, "*", WiFi.softAPIP());
+    {
+        JournalPause pause;
+        
+        // Start access point
+        WiFi.softAP(AP_SSID, AP_PASSWORD);
+        
+        // Start DNS server
+        dnsServer.start(53, "*", WiFi.softAPIP());
+    }
     
     // Setup web server for configuration
     setupConfigServer();
@@ -815,18 +928,75 @@ void startConfigMode() {
     Serial.printf("Config mode active. Connect to '%s' and go to http://192.168.4.1\n", AP_SSID);
 }
 
+// Appends text percent-encoded, as in a query string
+void appendEncoded(String& out, const String& text) {
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+    for (unsigned int i = 0; i < text.length(); i++) {
+        char c = text.c_str()[i];
+        char escaped[4] = {c, '\0', '\0', '\0'};
+        if (!isalnum((unsigned char)c) && c != '-' && c != '_' && c != '.' && c != '~') {
+            escaped[0] = '%';
+            escaped[1] = HEX_DIGITS[(uint8_t)c >> 4];
+            escaped[2] = HEX_DIGITS[c & 15];
+        }
+        out += escaped;
+    }
+}
+
+// "path?query" of the request being served
+String requestTarget() {
+    String target = server.uri();
+    for (int i = 0; i < server.args(); i++) {
+        target += i == 0 ? "?" : "&";
+        appendEncoded(target, server.argName(i));
+        target += "=";
+        appendEncoded(target, server.arg(i));
+    }
+    return target;
+}
+
+// Registers a route whose requests go into the input journal, so that a
+// replay serves them again at the same point in the loop
+void onJournaled(const char* uri, void (*handler)()) {
+    server.on(uri, [handler]() {
+        String target = journal.isRecording() ? requestTarget() : String();
+        journal.beginRequest(target.c_str());
+        handler();
+        journal.endRequest();
+    });
+}
+
 void setupWebServer() {
-    server.on("/", handleRoot);
-    server.on("/data", handleDataRequest);
-    server.on("/export", handleExportRequest);
+    // Called on every reconnect; routes only need registering once
+    static bool started = false;
+    if (started) return;
+    started = true;
+    
+    onJournaled("/", handleRoot);
+    onJournaled("/data", handleDataRequest);
+    onJournaled("/export", handleExportRequest);
+    onJournaled("/api/vitals/history", handleHistoryRequest);
+    onJournaled("/metrics", handleMetricsRequest);
+    onJournaled("/api/profile", handleProfileRequest);
+    onJournaled("/api/status", handleStatusRequest);
+    server.on("/api/journal", handleJournalRequest);
+    setupDashboardRoutes();
+    {
+        JournalPause pause;
+        webInterface.begin();
+    }
+    
+    // The only request headers the routes read; the server drops the rest
+    static const char* headerKeys[] = {"If-None-Match", "Accept-Encoding", "Range"};
+    server.collectHeaders(headerKeys, sizeof(headerKeys) / sizeof(headerKeys[0]));
     server.begin();
     Serial.println("Web server started");
 }
 
 void setupConfigServer() {
-    server.on("/", handleConfigRoot);
-    server.on("/save", handleConfigSave);
-    server.on("/scan", handleWiFiScan);
+    onJournaled("/", handleConfigRoot);
+    onJournaled("/save", handleConfigSave);
+    onJournaled("/scan", handleWiFiScan);
     server.begin();
     Serial.println("Config server started");
 }
@@ -838,7 +1008,7 @@ void handleRoot() {
     html += "<p>SpO2: " + String((int)currentVitals.spO2) + "%</p>";
     html += "<p>Battery: " + String((int)currentVitals.batteryLevel) + "%</p>";
     html += "<p>Finger Detected: " + String(currentVitals.isFingerDetected ? "Yes" : "No") + "</p>";
-    html += "<p><a href='/data'>View Data</a> | <a href='/export'>Export Data</a></p>";
+    html += "<p><a href='/index.html'>Dashboard</a> | <a href='/data'>View Data</a> | <a href='/export'>Export Data</a></p>";
     html += "</body></html>";
     
     server.send(200, "text/html", html);
@@ -852,6 +1022,7 @@ void handleConfigRoot() {
     html += "<form action='/save' method='post'>";
     html += "<p><label>Network Name (SSID):</label><br><input type='text' name='ssid' style='width:300px;padding:5px;'></p>";
     html += "<p><label>Password:</label><br><input type='password' name='password' style='width:300px;padding:5px;'></p>";
+    html += "<p><label>Collector URL (optional):</label><br><input type='text' name='uplink' value='" + preferences.getString("uplink_url", "") + "' style='width:300px;padding:5px;'></p>";
     html += "<p><input type='submit' value='Save Configuration' class='btn'></p>";
     html += "</form>";
     html += "<p><a href='/scan' class='btn'>Scan Networks</a></p>";
@@ -868,6 +1039,7 @@ void handleConfigSave() {
     if (ssid.length() > 0) {
         preferences.putString("wifi_ssid", ssid);
         preferences.putString("wifi_pass", password);
+        preferences.putString("uplink_url", server.arg("uplink"));
         
         wifiSSID = ssid;
         wifiPassword = password;
@@ -890,7 +1062,11 @@ void handleWiFiScan() {
     String html = "<!DOCTYPE html><html><head><title>Available Networks</title></head><body>";
     html += "<h1>Available WiFi Networks</h1>";
     
-    int n = WiFi.scanNetworks();
+    int n;
+    {
+        JournalPause pause;
+        n = WiFi.scanNetworks();
+    }
     if (n == 0) {
         html += "<p>No networks found</p>";
     } else {
@@ -909,117 +1085,259 @@ void handleWiFiScan() {
     server.send(200, "text/html", html);
 }
 
-void handleDataRequest() {
-    DynamicJsonDocument doc(2048);
-    JsonObject current = doc.createNestedObject("current");
+// Response bodies go out through this one buffer, so memory per request
+// stays constant however large the body
+static uint8_t responseChunk[512];
+
+// Streams a generator as a chunked response
+void sendChunked(int code, const char* contentType, ChunkGenerator& generator) {
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(code, contentType, "");
     
-    current["heartRate"] = currentVitals.heartRate;
-    current["spO2"] = currentVitals.spO2;
-    current["batteryLevel"] = currentVitals.batteryLevel;
-    current["fingerDetected"] = currentVitals.isFingerDetected;
-    current["timestamp"] = currentVitals.timestamp;
+    size_t length;
+    while ((length = generator.fill(responseChunk, sizeof(responseChunk))) > 0) {
+        server.sendContent((const char*)responseChunk, length);
+    }
+    server.sendContent(""); // Terminating zero-length chunk
+}
+
+// Streams a file with an exact Content-Length. With acceptRanges a Range
+// request gets 206 and only those bytes, so an interrupted download
+// resumes where it stopped instead of starting over.
+void sendFile(const char* path, const char* contentType, bool acceptRanges) {
+    int file = hal.storage->open(path, "r");
+    if (file == HAL_INVALID_FILE) {
+        server.send(404, "text/plain", "Not found");
+        return;
+    }
     
-    JsonArray history = doc.createNestedArray("history");
-    for (const auto& data : dataBuffer) {
-        JsonObject entry = history.createNestedObject();
-        entry["heartRate"] = data.heartRate;
-        entry["spO2"] = data.spO2;
-        entry["batteryLevel"] = data.batteryLevel;
-        entry["timestamp"] = data.timestamp;
+    size_t fileSize = hal.storage->size(file);
+    ByteRange range = {0, fileSize > 0 ? fileSize - 1 : 0};
+    int code = 200;
+    if (acceptRanges) {
+        server.sendHeader("Accept-Ranges", "bytes");
+        RangeResult result = server.hasHeader("Range")
+            ? parseRangeHeader(server.header("Range").c_str(), fileSize, range)
+            : RANGE_IGNORED;
+        char contentRange[48];
+        if (result == RANGE_UNSATISFIABLE) {
+            hal.storage->close(file);
+            snprintf(contentRange, sizeof(contentRange), "bytes */%u", (unsigned)fileSize);
+            server.sendHeader("Content-Range", contentRange);
+            server.send(416, "text/plain", "Range not satisfiable");
+            return;
+        }
+        if (result == RANGE_SATISFIABLE) {
+            code = 206;
+            snprintf(contentRange, sizeof(contentRange), "bytes %u-%u/%u",
+                     (unsigned)range.start, (unsigned)range.end, (unsigned)fileSize);
+            server.sendHeader("Content-Range", contentRange);
+        }
     }
     
-    String response;
-    serializeJson(doc, response);
-    server.send(200, "application/json", response);
+    size_t remaining = fileSize > 0 ? range.end - range.start + 1 : 0;
+    server.setContentLength(remaining);
+    server.send(code, contentType, "");
+    hal.storage->seek(file, range.start);
+    while (remaining > 0) {
+        size_t length = hal.storage->read(file, responseChunk,
+                                          remaining < sizeof(responseChunk) ? remaining : sizeof(responseChunk));
+        if (length == 0) break;
+        server.sendContent((const char*)responseChunk, length);
+        remaining -= length;
+    }
+    hal.storage->close(file);
+}
+
+void handleDataRequest() {
+    VitalsJsonGenerator generator(currentVitals, dataBuffer.data(), dataBuffer.size());
+    sendChunked(200, "application/json", generator);
+    latencyTracer.reached(LatencyPath::NETWORK, currentVitals.sequence, micros());
 }
 
 void handleExportRequest() {
-    String csv = "Timestamp,HeartRate,SpO2,BatteryLevel\n";
+    VitalsCsvGenerator generator(dataBuffer.data(), dataBuffer.size());
+    sendChunked(200, "text/csv", generator);
+}
+
+void handleMetricsRequest() {
+    HeapStatus heap;
+    readHeapStatus(heap);
+    metricFreeHeap.set(heap.freeBytes);
+    metricMinFreeHeap.set(heap.minFreeBytes);
+    metricLargestFreeBlock.set(heap.largestFreeBlock);
+    metricUptime.set(millis() / 1000);
+    metricSpiBytes.set(hal.display->getBytesSent());
+    MetricsGenerator generator;
+    sendChunked(200, "text/plain; version=0.0.4", generator);
+}
+
+// Section timings since the last dump; every dump starts a new window
+void handleProfileRequest() {
+    ProfileGenerator generator(ProfileGenerator::JSON);
+    sendChunked(200, "application/json", generator);
+    ProfileSection::resetAll();
+}
+
+// The input journal recorded since boot, for replay on the native build.
+// Up to JOURNAL_FILE_LIMIT, so a dropped download resumes with Range.
+void handleJournalRequest() {
+    journal.save();
+    sendFile(JOURNAL_PATH, "application/octet-stream", true);
+}
+
+// Heap, per-subsystem accounting and task stacks
+void handleStatusRequest() {
+    MemoryReportGenerator generator(MemoryReportGenerator::JSON, FIRMWARE_VERSION, wifiConnected);
+    sendChunked(200, "application/json", generator);
+}
+
+void handleHistoryRequest() {
+    // server.arg() returns temporaries, so copy each value into stable storage
+    static char values[5][16];
+    static const char* names[5] = {"from", "to", "resolution", "limit", "cursor"};
+    
+    auto getParam = [](const char* name) -> const char* {
+        for (int i = 0; i < 5; i++) {
+            if (strcmp(name, names[i]) == 0 && server.hasArg(name)) {
+                strlcpy(values[i], server.arg(name).c_str(), sizeof(values[i]));
+                return values[i];
+            }
+        }
+        return nullptr;
+    };
+    
+    HistoryQuery query;
+    parseHistoryQuery(getParam, vitalsLog.now(), query);
+    VitalsHistoryGenerator generator(&vitalsLog, query);
+    sendChunked(200, "application/json", generator);
+}
+
+// ==================== DASHBOARD ====================
+// tools/gzip_www.py's files in /www with validators. Served outside the
+// journal like /api/journal: they are not inputs of the loop.
+void setupDashboardRoutes() {
+    int file = hal.storage->open("/www/etags.txt", "r");
+    if (file == HAL_INVALID_FILE) {
+        Serial.println("No /www/etags.txt, dashboard not served");
+        return;
+    }
     
-    for (const auto& data : dataBuffer) {
-        csv += String(data.timestamp) + ",";
-        csv += String(data.heartRate) + ",";
-        csv += String(data.spO2) + ",";
-        csv += String(data.batteryLevel) + "\n";
+    // One asset per line: <url> "<etag>" <immutable>
+    char table[MAX_ASSETS * 80];
+    size_t length = hal.storage->read(file, (uint8_t*)table, sizeof(table) - 1);
+    hal.storage->close(file);
+    table[length] = '\0';
+    
+    char* line = table;
+    while (line && *line && dashboardAssetCount < MAX_ASSETS) {
+        char* next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+        if (parseAssetLine(line, dashboardAssets[dashboardAssetCount])) dashboardAssetCount++;
+        line = next;
     }
     
-    server.send(200, "text/csv", csv);
+    for (int i = 0; i < dashboardAssetCount; i++) {
+        const StaticAsset& asset = dashboardAssets[i];
+        server.on(asset.url, HTTP_GET, [&asset]() { serveAsset(asset); });
+    }
+    Serial.printf("Dashboard: %d precompressed assets\n", dashboardAssetCount);
+}
+
+void serveAsset(const StaticAsset& asset) {
+    server.sendHeader("ETag", asset.etag);
+    server.sendHeader("Cache-Control", asset.immutable ? "public, max-age=31536000, immutable" : "no-cache");
+    
+    // Browser already has this exact content
+    if (server.hasHeader("If-None-Match") && etagMatches(server.header("If-None-Match").c_str(), asset.etag)) {
+        server.send(304);
+        return;
+    }
+    
+    // Each asset is stored plain and gzipped; the gzipped copy only goes to
+    // clients that said they take it
+    bool gzip = server.hasHeader("Accept-Encoding") && acceptsGzip(server.header("Accept-Encoding").c_str());
+    char path[48];
+    snprintf(path, sizeof(path), "/www%s%s", asset.url, gzip ? ".gz" : "");
+    server.sendHeader("Vary", "Accept-Encoding");
+    if (gzip) server.sendHeader("Content-Encoding", "gzip");
+    sendFile(path, assetContentType(asset.url), false);
+}
+
+// The dashboard's live feed (web_interface.h) gets each new estimate. Its
+// clients are not inputs the journal replays, so it runs outside it.
+void broadcastVitals() {
+    if (!wifiConnected) return;
+    JournalPause pause;
+    webInterface.broadcastVitalSigns(currentVitals.heartRate, currentVitals.spO2,
+                                     currentVitals.batteryLevel, currentVitals.isFingerDetected);
 }
 
 // ==================== DATA LOGGING ====================
 void logData() {
-    if (currentVitals.isFingerDetected && currentVitals.heartRate > 0) {
-        dataBuffer.push_back(currentVitals);
-        
-        // Limit buffer size
-        if (dataBuffer.size() > DATA_BUFFER_SIZE) {
-            dataBuffer.erase(dataBuffer.begin());
-        }
-        
-        // Save to SPIFFS periodically
-        static int saveCounter = 0;
-        saveCounter++;
-        if (saveCounter >= 10) { // Save every 10 readings
-            saveCounter = 0;
-            saveDataToFile();
-        }
-    }
+    PROFILE_SCOPE(profileLog);
+    monitor.logData();
 }
 
 void saveDataToFile() {
-    File file = SPIFFS.open("/data.csv", "w");
-    if (file) {
-        file.println("Timestamp,HeartRate,SpO2,BatteryLevel");
+    int file = hal.storage->open("/data.csv", "w");
+    if (file != HAL_INVALID_FILE) {
+        char line[64];
+        int length = snprintf(line, sizeof(line), "Timestamp,HeartRate,SpO2,BatteryLevel\r\n");
+        hal.storage->write(file, (const uint8_t*)line, length);
         for (const auto& data : dataBuffer) {
-            file.print(data.timestamp);
-            file.print(",");
-            file.print(data.heartRate);
-            file.print(",");
-            file.print(data.spO2);
-            file.print(",");
-            file.println(data.batteryLevel);
+            length = snprintf(line, sizeof(line), "%lu,%.2f,%.2f,%.2f\r\n",
+                data.timestamp, data.heartRate, data.spO2, data.batteryLevel);
+            hal.storage->write(file, (const uint8_t*)line, length);
         }
-        file.close();
-        Serial.println("Data saved to file");
+        hal.storage->close(file);
+        TRACE("Data saved to file\n");
     } else {
-        Serial.println("Failed to save data to file");
+        TRACE("Failed to save data to file\n");
     }
 }
 
+// One "timestamp,heartRate,spO2,battery" line of /data.csv
+bool parseDataLine(const char* line, VitalSigns& data) {
+    char* end;
+    data.timestamp = strtoul(line, &end, 10);
+    if (*end != ',') return false;
+    data.heartRate = strtof(end + 1, &end);
+    if (*end != ',') return false;
+    data.spO2 = strtof(end + 1, &end);
+    if (*end != ',') return false;
+    data.batteryLevel = strtof(end + 1, &end);
+    return true;
+}
+
 void loadDataFromFile() {
-    File file = SPIFFS.open("/data.csv", "r");
-    if (file) {
-        dataBuffer.clear();
-        String line = file.readStringUntil('\n'); // Skip header
-        
-        while (file.available()) {
-            line = file.readStringUntil('\n');
-            if (line.length() > 0) {
-                VitalSigns data;
-                int commaIndex = 0;
-                int lastIndex = 0;
-                
-                // Parse CSV line
-                commaIndex = line.indexOf(',', lastIndex);
-                data.timestamp = line.substring(lastIndex, commaIndex).toInt();
-                lastIndex = commaIndex + 1;
-                
-                commaIndex = line.indexOf(',', lastIndex);
-                data.heartRate = line.substring(lastIndex, commaIndex).toFloat();
-                lastIndex = commaIndex + 1;
-                
-                commaIndex = line.indexOf(',', lastIndex);
-                data.spO2 = line.substring(lastIndex, commaIndex).toFloat();
-                lastIndex = commaIndex + 1;
-                
-                data.batteryLevel = line.substring(lastIndex).toFloat();
-                
+    int file = hal.storage->open("/data.csv", "r");
+    if (file == HAL_INVALID_FILE) return;
+    dataBuffer.clear();
+    
+    // Split into lines through a small buffer; the first is the header
+    char chunk[64];
+    char line[64];
+    size_t lineLength = 0;
+    bool header = true;
+    size_t count;
+    while ((count = hal.storage->read(file, (uint8_t*)chunk, sizeof(chunk))) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            if (chunk[i] != '\n') {
+                if (lineLength < sizeof(line) - 1) line[lineLength++] = chunk[i];
+                continue;
+            }
+            line[lineLength] = '\0';
+            lineLength = 0;
+            VitalSigns data;
+            if (!header && parseDataLine(line, data)) {
                 dataBuffer.push_back(data);
             }
+            header = false;
         }
-        file.close();
-        Serial.printf("Loaded %d data entries from file\n", dataBuffer.size());
     }
+    hal.storage->close(file);
+    Serial.printf("Loaded %d data entries from file\n", dataBuffer.size());
 }
 
 void exportData() {
@@ -1040,7 +1358,7 @@ void exportData() {
 void clearData() {
     Serial.println("Clearing data...");
     dataBuffer.clear();
-    SPIFFS.remove("/data.csv");
+    hal.storage->remove("/data.csv");
     
     // Show confirmation on display
     tft.fillRect(50, 100, 220, 60, COLOR_RED);
@@ -1055,44 +1373,29 @@ void clearData() {
 
 // ==================== ALERT SYSTEM ====================
 void checkAlerts() {
+    PROFILE_SCOPE(profileAlerts);
     if (!alertThresholds.enabled) return;
     
-    // Check heart rate
-    if (currentVitals.isFingerDetected && currentVitals.heartRate > 0) {
-        if (currentVitals.heartRate < alertThresholds.heartRateMin || 
-            currentVitals.heartRate > alertThresholds.heartRateMax) {
-            
-            String message = "Heart rate: " + String((int)currentVitals.heartRate) + " BPM";
-            AlertLevel level = (currentVitals.heartRate < 50 || currentVitals.heartRate > 120) ? 
-                              AlertLevel::CRITICAL : AlertLevel::WARNING;
-            triggerAlert(level, message);
-        }
-    }
-    
-    // Check SpO2
-    if (currentVitals.isFingerDetected && currentVitals.spO2 > 0) {
-        if (currentVitals.spO2 < alertThresholds.spO2Min) {
-            String message = "Low SpO2: " + String((int)currentVitals.spO2) + "%";
-            AlertLevel level = (currentVitals.spO2 < 90) ? AlertLevel::CRITICAL : AlertLevel::WARNING;
-            triggerAlert(level, message);
-        }
-    }
-    
-    // Check battery
-    if (currentVitals.batteryLevel < alertThresholds.batteryMin) {
-        String message = "Low battery: " + String((int)currentVitals.batteryLevel) + "%";
-        AlertLevel level = (currentVitals.batteryLevel < 10) ? AlertLevel::CRITICAL : AlertLevel::WARNING;
-        triggerAlert(level, message);
+    AlarmEvent alarm;
+    if (monitor.checkAlerts(alarm)) {
+        char message[48];
+        formatAlarmMessage(alarm, message, sizeof(message));
+        raiseAlert(alarm.level, message, alarm.sequence);
     }
     
     // Remove old alerts
     removeOldAlerts();
 }
 
+// Alarms from outside the vitals rules take the rules' cooldown, so every
+// source together raises at most one alarm per 5 s
 void triggerAlert(AlertLevel level, const String& message) {
-    // Check cooldown
-    if (millis() - lastAlertTime < 5000) return; // 5 second cooldown
-    
+    if (!monitor.admitAlarm(level)) return;
+    raiseAlert(level, message, 0);
+}
+
+// The rules have already applied the cooldown to their own alarms
+void raiseAlert(AlertLevel level, const String& message, uint32_t sequence) {
     Alert alert;
     alert.level = level;
     alert.message = message;
@@ -1107,15 +1410,26 @@ void triggerAlert(AlertLevel level, const String& message) {
         alertHistory.erase(alertHistory.begin());
     }
     
-    lastAlertTime = millis();
+    switch (level) {
+        case AlertLevel::CRITICAL: metricAlarmsCritical.inc(); break;
+        case AlertLevel::WARNING: metricAlarmsWarning.inc(); break;
+        default: metricAlarmsInfo.inc(); break;
+    }
     
     // Play alert sound
+    latencyTracer.reached(LatencyPath::BUZZER, sequence, micros());
     playAlertSound(level);
     
     // Show alert on display
     showAlert(message, level);
+    latencyTracer.reached(LatencyPath::ALARM_BANNER, sequence, micros());
     
-    Serial.printf("ALERT [%s]: %s\n", 
+    if (wifiConnected) {
+        JournalPause pause;
+        webInterface.sendAlert(message);
+    }
+    
+    TRACE("ALERT [%s]: %s\n", 
         level == AlertLevel::CRITICAL ? "CRITICAL" : 
         level == AlertLevel::WARNING ? "WARNING" : "INFO", 
         message.c_str());
@@ -1141,9 +1455,9 @@ void playAlertSound(AlertLevel level) {
     }
     
     for (int i = 0; i < beepCount; i++) {
-        digitalWrite(BUZZER_PIN, HIGH);
+        hal.tone->tone(BUZZER_FREQUENCY);
         delay(beepDuration);
-        digitalWrite(BUZZER_PIN, LOW);
+        hal.tone->noTone();
         if (i < beepCount - 1) delay(200);
     }
 }
@@ -1192,29 +1506,18 @@ void removeOldAlerts() {
 
 // ==================== SETTINGS MANAGEMENT ====================
 void loadSettings() {
-    alertThresholds.heartRateMin = preferences.getFloat("hr_min", 60.0f);
-    alertThresholds.heartRateMax = preferences.getFloat("hr_max", 100.0f);
-    alertThresholds.spO2Min = preferences.getFloat("spo2_min", 95.0f);
-    alertThresholds.batteryMin = preferences.getFloat("bat_min", 20.0f);
-    alertThresholds.enabled = preferences.getBool("alerts_en", true);
-    screenBrightness = preferences.getInt("brightness", 128);
-    
+    monitor.loadSettings();
     Serial.println("Settings loaded from preferences");
 }
 
 void saveSettings() {
-    preferences.putFloat("hr_min", alertThresholds.heartRateMin);
-    preferences.putFloat("hr_max", alertThresholds.heartRateMax);
-    preferences.putFloat("spo2_min", alertThresholds.spO2Min);
-    preferences.putFloat("bat_min", alertThresholds.batteryMin);
-    preferences.putBool("alerts_en", alertThresholds.enabled);
-    preferences.putInt("brightness", screenBrightness);
-    
-    Serial.println("Settings saved to preferences");
+    monitor.saveSettings();
+    TRACE("Settings saved to preferences\n");
 }
 
 // ==================== UTILITY FUNCTIONS ====================
 void updateDisplay() {
+    PROFILE_SCOPE(profileDisplay);
     if (!displayOn) return;
     
     switch (currentScreen) {
@@ -1272,9 +1575,9 @@ void printSystemInfo() {
         Serial.println("WiFi: Not connected");
     }
     
-    Serial.printf("Sensor Status: %s\n", particleSensor.begin() ? "Connected" : "Disconnected");
+    Serial.printf("Sensor Status: %s\n", hal.sensor->begin() ? "Connected" : "Disconnected");
     Serial.printf("Display Status: Active\n");
-    Serial.printf("Touch Status: %s\n", ts.begin() ? "Active" : "Inactive");
+    Serial.printf("Touch Status: %s\n", hal.touch->begin() ? "Active" : "Inactive");
     Serial.printf("Data Buffer: %d/%d entries\n", dataBuffer.size(), DATA_BUFFER_SIZE);
     Serial.printf("Active Alerts: %d\n", activeAlerts.size());
     Serial.println("========================\n");
@@ -1298,7 +1601,7 @@ void performSelfTest() {
     
     // Test touch
     Serial.print("Testing touch controller... ");
-    if (ts.begin()) {
+    if (hal.touch->begin()) {
         Serial.println("OK");
     } else {
         Serial.println("FAILED");
@@ -1307,7 +1610,7 @@ void performSelfTest() {
     
     // Test sensor
     Serial.print("Testing MAX30102 sensor... ");
-    if (particleSensor.begin()) {
+    if (hal.sensor->begin()) {
         Serial.println("OK");
     } else {
         Serial.println("FAILED");
@@ -1316,7 +1619,7 @@ void performSelfTest() {
     
     // Test SPIFFS
     Serial.print("Testing file system... ");
-    if (SPIFFS.begin(true)) {
+    if (hal.storage->begin(true)) {
         Serial.println("OK");
     } else {
         Serial.println("FAILED");
@@ -1325,9 +1628,9 @@ void performSelfTest() {
     
     // Test buzzer
     Serial.print("Testing buzzer... ");
-    digitalWrite(BUZZER_PIN, HIGH);
+    hal.tone->tone(BUZZER_FREQUENCY);
     delay(200);
-    digitalWrite(BUZZER_PIN, LOW);
+    hal.tone->noTone();
     Serial.println("OK");
     
     // Test battery reading
@@ -1344,25 +1647,27 @@ void performSelfTest() {
     if (testsPassed) {
         // Success indication
         for (int i = 0; i < 3; i++) {
-            digitalWrite(BUZZER_PIN, HIGH);
+            hal.tone->tone(BUZZER_FREQUENCY);
             delay(100);
-            digitalWrite(BUZZER_PIN, LOW);
+            hal.tone->noTone();
             delay(100);
         }
     } else {
         // Failure indication
         for (int i = 0; i < 5; i++) {
-            digitalWrite(BUZZER_PIN, HIGH);
+            hal.tone->tone(BUZZER_FREQUENCY);
             delay(200);
-            digitalWrite(BUZZER_PIN, LOW);
+            hal.tone->noTone();
             delay(200);
         }
+        triggerAlert(AlertLevel::WARNING, "Self-test failed");
     }
 }
 
 void handleSerialCommands() {
-    if (Serial.available()) {
-        String command = Serial.readStringUntil('\n');
+    String command;
+    if (journal.readConsoleLine(command)) {
+        PROFILE_SCOPE(profileSerial);
         command.trim();
         command.toLowerCase();
         
@@ -1378,6 +1683,12 @@ void handleSerialCommands() {
             Serial.println("clear - Clear data buffer");
             Serial.println("alerts - Show active alerts");
             Serial.println("config - Enter configuration mode");
+            Serial.println("profile - Show and reset section timings");
+            Serial.println("memory - Show heap, per-subsystem memory and task stacks");
+            Serial.println("bench - Time sensor, display, storage, DSP and JSON on this board");
+            Serial.println("bench boot on|off - Also run the benchmark at every boot");
+            Serial.println("trace text|binary - Format log messages here or leave it to trace_decode.py");
+            Serial.println("journal [on|off|save] - Record inputs for replay from next boot; save writes it out");
             Serial.println("========================\n");
         }
         else if (command == "info") {
@@ -1391,7 +1702,8 @@ void handleSerialCommands() {
             ESP.restart();
         }
         else if (command == "wifi") {
-            Serial.printf("WiFi Status: %s\n", wifiConnected ? "Connected" : "Disconnected");
+            Serial.printf("WiFi Status: %s (%d failed attempts)\n",
+                WifiManager::stateName(wifiManager.getState()), wifiManager.getFailures());
             if (wifiConnected) {
                 Serial.printf("SSID: %s\n", WiFi.SSID().c_str());
                 Serial.printf("IP: %s\n", WiFi.localIP().toString().c_str());
@@ -1425,15 +1737,85 @@ void handleSerialCommands() {
             }
         }
         else if (command == "config") {
-            startConfigMode();
+            wifiManager.openPortal(millis());
             Serial.println("Configuration mode started");
         }
+        else if (command == "profile") {
+            printProfile();
+        }
+        else if (command == "memory") {
+            printMemoryReport();
+        }
+        else if (command == "bench") {
+            runBenchmark();
+            if (currentScreen == ScreenType::SETTINGS) showSettingsScreen();
+            else if (currentScreen == ScreenType::HISTORY) showHistoryScreen();
+            else showMainScreen();
+        }
+        else if (command == "bench boot on" || command == "bench boot off") {
+            preferences.putBool("bench_boot", command == "bench boot on");
+            Serial.printf("Benchmark at boot: %s\n", command == "bench boot on" ? "on" : "off");
+        }
+        else if (command == "trace text" || command == "trace binary") {
+            traceLog.drain();
+            traceLog.setBinary(command == "trace binary");
+            Serial.printf("Trace output: %s, %u records dropped so far\n",
+                traceLog.isBinary() ? "binary" : "text", (unsigned)traceLog.getDropped());
+        }
+        else if (command == "journal") {
+            Serial.printf("Journal: %s, %u bytes in %u loops; %s from next boot\n",
+                journal.isRecording() ? "recording" : (journal.getMode() == Journal::RECORDING ? "stopped" : "off"),
+                (unsigned)journal.getBytes(), (unsigned)journal.getLoops(), journal.isEnabled() ? "on" : "off");
+        }
+        else if (command == "journal on" || command == "journal off") {
+            journal.setEnabled(command == "journal on");
+            Serial.printf("Journal %s from next boot\n", command == "journal on" ? "on" : "off");
+        }
+        else if (command == "journal save") {
+            if (journal.save()) {
+                Serial.printf("Journal saved to %s, %u bytes\n", JOURNAL_PATH, (unsigned)journal.getBytes());
+            } else {
+                Serial.println("Journal is not recording");
+            }
+        }
         else {
             Serial.println("Unknown command. Type 'help' for available commands.");
         }
     }
 }
 
+void printProfile() {
+    ProfileGenerator generator(ProfileGenerator::TEXT);
+    uint8_t chunk[128];
+    size_t length;
+    while ((length = generator.fill(chunk, sizeof(chunk))) > 0) {
+        Serial.write(chunk, length);
+    }
+    ProfileSection::resetAll();
+}
+
+// One JSON line, for collecting across hardware batches
+void runBenchmark() {
+    Serial.println("Running self-benchmark, monitoring paused...");
+    SelfBenchConfig config;
+    config.firmwareVersion = FIRMWARE_VERSION;
+    SelfBenchResults results;
+    runSelfBenchmark(config, results);
+    
+    char json[768];
+    jsonSerialize(results, json, sizeof(json));
+    Serial.println(json);
+}
+
+void printMemoryReport() {
+    MemoryReportGenerator generator(MemoryReportGenerator::TEXT);
+    uint8_t chunk[128];
+    size_t length;
+    while ((length = generator.fill(chunk, sizeof(chunk))) > 0) {
+        Serial.write(chunk, length);
+    }
+}
+
 void watchdogFeed() {
     // Feed the watchdog timer to prevent system reset
     // This is automatically handled by the ESP32 framework
@@ -1444,7 +1826,7 @@ void watchdogFeed() {
 void handleLowPowerMode() {
     if (currentVitals.batteryLevel < 10 && !wifiConnected) {
         // Enter low power mode
-        Serial.println("Entering low power mode...");
+        TRACE("Entering low power mode...\n");
         
         // Reduce display brightness
         // Note: Actual brightness control would require PWM on backlight pin
@@ -1455,6 +1837,7 @@ void handleLowPowerMode() {
         
         // Disable WiFi if not connected
         if (!wifiConnected) {
+            JournalPause pause;
             WiFi.mode(WIFI_OFF);
         }
         
@@ -1473,20 +1856,26 @@ void checkMemoryUsage() {
     if (millis() - lastMemCheck > 30000) { // Check every 30 seconds
         lastMemCheck = millis();
         
-        size_t freeHeap = ESP.getFreeHeap();
-        if (freeHeap < 10000) { // Less than 10KB free
-            Serial.printf("WARNING: Low memory - %d bytes free\n", freeHeap);
+        // Plenty free can still fail an allocation if it is in small pieces
+        HeapStatus heap;
+        readHeapStatus(heap);
+        // What is done about it is journaled, so the figures are too
+        heap.freeBytes = journal.input(Journal::KIND_VALUE, [&] { return heap.freeBytes; });
+        heap.largestFreeBlock = journal.input(Journal::KIND_VALUE, [&] { return heap.largestFreeBlock; });
+        if (heap.freeBytes < 10000 || heap.largestFreeBlock < 4096) {
+            TRACE("WARNING: Low memory - %u bytes free, largest block %u (%u%% fragmented)\n",
+                (unsigned)heap.freeBytes, (unsigned)heap.largestFreeBlock, (unsigned)heap.fragmentation);
             
             // Clean up old data if memory is low
             if (dataBuffer.size() > 50) {
                 dataBuffer.erase(dataBuffer.begin(), dataBuffer.begin() + 25);
-                Serial.println("Cleaned up data buffer to free memory");
+                TRACE("Cleaned up data buffer to free memory\n");
             }
             
             // Clean up old alerts
             if (alertHistory.size() > 25) {
                 alertHistory.erase(alertHistory.begin(), alertHistory.begin() + 10);
-                Serial.println("Cleaned up alert history to free memory");
+                TRACE("Cleaned up alert history to free memory\n");
             }
         }
     }
@@ -1494,7 +1883,15 @@ void checkMemoryUsage() {
 
 // ==================== ENHANCED MAIN LOOP ====================
 void loop() {
+    journal.loopStarted();
+    loopIteration();
+    delay(10); // Prevent watchdog timeout and allow other tasks
+}
+
+void loopIteration() {
+    PROFILE_SCOPE(profileLoop);
     unsigned long currentTime = millis();
+    uint32_t loopStart = micros();
     
     // Handle serial commands
     handleSerialCommands();
@@ -1509,13 +1906,19 @@ void loop() {
     handleLowPowerMode();
     
     // Handle WiFi and web server
-    if (configModeActive) {
-        dnsServer.processNextRequest();
-        server.handleClient();
-    } else {
-        handleWiFiConnection();
-        if (wifiConnected) {
+    {
+        PROFILE_SCOPE(profileNetwork);
+        if (configModeActive) {
+            // The server libraries are left out of the journal; journaled routes resume it
+            JournalPause pause;
+            dnsServer.processNextRequest();
             server.handleClient();
+        } else {
+            handleWiFiConnection();
+            if (wifiConnected) {
+                JournalPause pause;
+                server.handleClient();
+            }
         }
     }
     
@@ -1527,6 +1930,14 @@ void loop() {
         lastSensorUpdate = currentTime;
         updateSensors();
     }
+
+    // ECG lead, on boards that trace it
+    if constexpr (TargetProfile::HAS_ECG_TRACE) {
+        if (currentTime - lastEcgSample >= TargetProfile::ECG_INTERVAL_MS) {
+            lastEcgSample = currentTime;
+            sampleEcg();
+        }
+    }
     
     // Update display
     if (currentTime - lastDisplayUpdate >= DISPLAY_UPDATE_INTERVAL) {
@@ -1541,7 +1952,7 @@ void loop() {
     }
     
     // Check alerts
-    if (currentTime - lastAlertCheck >= 1000) { // Check every second
+    if (currentTime - lastAlertCheck >= ALERT_CHECK_INTERVAL) {
         lastAlertCheck = currentTime;
         checkAlerts();
     }
@@ -1552,6 +1963,7 @@ void loop() {
     // Periodic system maintenance
     static unsigned long lastMaintenance = 0;
     if (currentTime - lastMaintenance > 60000) { // Every minute
+        PROFILE_SCOPE(profileMaintenance);
         lastMaintenance = currentTime;
         
         // Save settings periodically
@@ -1559,13 +1971,13 @@ void loop() {
         
         // Print status update
         if (Serial.available() == 0) { // Only if no serial input pending
-            Serial.printf("Status: HR=%.1f SpO2=%.1f Bat=%.1f%% Mem=%dKB\n",
+            TRACE("Status: HR=%.1f SpO2=%.1f Bat=%.1f%% Mem=%uKB\n",
                 currentVitals.heartRate, currentVitals.spO2, 
-                currentVitals.batteryLevel, ESP.getFreeHeap()/1024);
+                currentVitals.batteryLevel, (unsigned)(ESP.getFreeHeap()/1024));
         }
     }
     
-    delay(10); // Prevent watchdog timeout and allow other tasks
+    metricLoopDuration.observe(micros() - loopStart);
 }
 
 // ==================== INITIALIZATION HELPERS ====================
@@ -1578,15 +1990,14 @@ void initializeSystem() {
     currentScreen = ScreenType::MAIN;
     
     // Clear buffers
-    bufferIndex = 0;
-    memset(irBuffer, 0, sizeof(irBuffer));
-    memset(redBuffer, 0, sizeof(redBuffer));
+    monitor.reset();
     
     // Reset timing
     lastSensorUpdate = 0;
     lastDisplayUpdate = 0;
     lastDataLog = 0;
     lastAlertCheck = 0;
+    lastEcgSample = 0;
     
     // Load data from file
     loadDataFromFile();
@@ -1609,9 +2020,9 @@ void handleSystemError(const String& errorMessage) {
     
     // Sound error alert
     for (int i = 0; i < 5; i++) {
-        digitalWrite(BUZZER_PIN, HIGH);
+        hal.tone->tone(BUZZER_FREQUENCY);
         delay(100);
-        digitalWrite(BUZZER_PIN, LOW);
+        hal.tone->noTone();
         delay(100);
     }
     
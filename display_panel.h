@@ -0,0 +1,100 @@
+#ifndef DISPLAY_PANEL_H
+#define DISPLAY_PANEL_H
+
+#include "target_profile.h"
+
+// The ILI9341 driver for the profile's display bus. Both are Adafruit_GFX,
+// so the sketch draws the same way on either; these cover the few calls
+// that differ: construction, start-up, the raw window writes the HAL's
+// display bus makes and the bytes the bus has carried.
+
+#if defined(TARGET_ESP32_PARALLEL)
+#include <MCUFRIEND_kbv.h>
+
+// Pins are fixed by the library; see board_pins.h
+typedef MCUFRIEND_kbv DisplayPanel;
+#define DISPLAY_PANEL_INIT MCUFRIEND_kbv()
+
+inline void beginDisplayPanel(DisplayPanel& panel) {
+    panel.begin(panel.readID());
+}
+
+inline void setDisplayPanelWindow(DisplayPanel& panel, int16_t x, int16_t y, int16_t w, int16_t h) {
+    panel.setAddrWindow(x, y, x + w - 1, y + h - 1);
+}
+
+inline void fillDisplayPanel(DisplayPanel& panel, uint16_t color, uint32_t count) {
+    // The parallel driver only streams from memory, a block at a time
+    uint16_t block[32];
+    for (int i = 0; i < 32; i++) block[i] = color;
+    bool first = true;
+    while (count > 0) {
+        int16_t n = count > 32 ? 32 : (int16_t)count;
+        panel.pushColors(block, n, first);
+        first = false;
+        count -= n;
+    }
+}
+
+// Not an SPI bus, and the library draws through its own parallel writes
+inline uint32_t displayPanelBytesSent(DisplayPanel& panel) {
+    (void)panel;
+    return 0;
+}
+
+#else
+#include <Adafruit_ILI9341.h>
+
+// Adafruit_SPITFT opens an address window for every primitive it draws,
+// the sketch's and the HAL bus's alike, and fills it; so the bytes on the
+// wire follow from the windows. The driver skips CASET/PASET when they are
+// unchanged, and so does the count.
+class DisplayPanel : public Adafruit_ILI9341 {
+private:
+    uint16_t lastX1 = 0xffff, lastX2 = 0xffff;
+    uint16_t lastY1 = 0xffff, lastY2 = 0xffff;
+    uint32_t bytesSent = 0;
+
+public:
+    using Adafruit_ILI9341::Adafruit_ILI9341;
+
+    void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) override {
+        Adafruit_ILI9341::setAddrWindow(x, y, w, h);
+        uint16_t x2 = x + w - 1, y2 = y + h - 1;
+        uint32_t bytes = 1 + (uint32_t)w * h * 2;   // RAMWR, then the pixels
+        if (x != lastX1 || x2 != lastX2) bytes += 5;
+        if (y != lastY1 || y2 != lastY2) bytes += 5;
+        lastX1 = x;
+        lastX2 = x2;
+        lastY1 = y;
+        lastY2 = y2;
+        bytesSent += bytes;
+    }
+
+    uint32_t getBytesSent() const { return bytesSent; }
+};
+
+#define DISPLAY_PANEL_INIT DisplayPanel(TFT_CS, TFT_DC, TFT_MOSI, TFT_CLK, TFT_RST, TFT_MISO)
+
+inline void beginDisplayPanel(DisplayPanel& panel) {
+    panel.begin();
+}
+
+inline void setDisplayPanelWindow(DisplayPanel& panel, int16_t x, int16_t y, int16_t w, int16_t h) {
+    panel.startWrite();
+    panel.setAddrWindow(x, y, w, h);
+    panel.endWrite();
+}
+
+inline void fillDisplayPanel(DisplayPanel& panel, uint16_t color, uint32_t count) {
+    panel.startWrite();
+    panel.writeColor(color, count);
+    panel.endWrite();
+}
+
+inline uint32_t displayPanelBytesSent(DisplayPanel& panel) {
+    return panel.getBytesSent();
+}
+#endif
+
+#endif
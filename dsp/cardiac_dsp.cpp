@@ -0,0 +1,332 @@
+// C ABI of the monitor's signal path; see cardiac_dsp.h
+#include "cardiac_dsp.h"
+#include <Arduino.h>
+#include <new>
+#include "../hal.h"
+#include "../heartrate.h"
+#include "../spo2_Algorithm.h"
+#include "../vitals_pipeline.h"
+#include "../signal_generator.h"
+#include <spo2_algorithm.h>           // FreqS, from the MAX3010x library
+
+static_assert((int)AlertLevel::CRITICAL == CARDIAC_ALERT_CRITICAL, "cardiac_dsp.h levels follow AlertLevel");
+static_assert(PpgEstimator::WINDOW_SAMPLES == CARDIAC_PPG_WINDOW_SAMPLES, "cardiac_dsp.h window follows PpgEstimator");
+static_assert(FreqS == CARDIAC_PPG_SAMPLE_RATE, "cardiac_dsp.h rate follows spo2_algorithm.h");
+static_assert((int)AlarmKind::BATTERY == CARDIAC_ALARM_BATTERY, "cardiac_dsp.h kinds follow AlarmKind");
+
+// ==================== CLOCK ====================
+// millis() for HeartRateCalculator: the time of the sample being processed,
+// per thread, as bench/replay.cpp does for a recording
+static thread_local uint32_t sampleTimeMs = 0;
+
+class SampleClock : public HalClock {
+public:
+    uint32_t millis() override { return sampleTimeMs; }
+    uint32_t micros() override { return sampleTimeMs * 1000; }
+    void delay(uint32_t ms) override { sampleTimeMs += ms; }
+};
+
+static SampleClock sampleClock;
+
+// Nothing but the clock is needed on this path
+Hal hal = {&sampleClock, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+
+// ==================== CONVERSIONS ====================
+static VitalSigns toVitals(const cardiac_vitals& in) {
+    VitalSigns out;
+    out.heartRate = in.heart_rate;
+    out.spO2 = in.spo2;
+    out.batteryLevel = in.battery_level;
+    out.isFingerDetected = in.finger_detected != 0;
+    out.timestamp = in.timestamp_ms;
+    out.sequence = in.sequence;
+    return out;
+}
+
+static cardiac_vitals fromVitals(const VitalSigns& in) {
+    cardiac_vitals out;
+    out.heart_rate = in.heartRate;
+    out.spo2 = in.spO2;
+    out.battery_level = in.batteryLevel;
+    out.finger_detected = in.isFingerDetected ? 1 : 0;
+    out.timestamp_ms = (uint32_t)in.timestamp;
+    out.sequence = in.sequence;
+    return out;
+}
+
+static AlertThresholds toThresholds(const cardiac_thresholds& in) {
+    AlertThresholds out;
+    out.heartRateMin = in.heart_rate_min;
+    out.heartRateMax = in.heart_rate_max;
+    out.spO2Min = in.spo2_min;
+    out.batteryMin = in.battery_min;
+    out.enabled = in.enabled != 0;
+    return out;
+}
+
+static AlarmEvent toAlarm(const cardiac_alarm& in) {
+    AlarmEvent out;
+    out.kind = (AlarmKind)in.kind;
+    out.level = (AlertLevel)in.level;
+    out.value = in.value;
+    out.timestamp = in.timestamp_ms;
+    out.sequence = in.sequence;
+    return out;
+}
+
+static cardiac_alarm fromAlarm(const AlarmEvent& in) {
+    cardiac_alarm out;
+    out.kind = (int32_t)in.kind;
+    out.level = (int32_t)in.level;
+    out.value = in.value;
+    out.timestamp_ms = in.timestamp;
+    out.sequence = in.sequence;
+    return out;
+}
+
+static PhysiologyParams toPhysiology(const cardiac_physiology& in) {
+    PhysiologyParams out;
+    out.heartRate = in.heart_rate;
+    out.hrv = in.hrv;
+    out.respirationRate = in.respiration_rate;
+    out.respiratorySinus = in.respiratory_sinus;
+    out.spO2 = in.spo2;
+    out.perfusion = in.perfusion;
+    out.respirationDepth = in.respiration_depth;
+    out.fingerPresent = in.finger_present != 0;
+    out.baselineWander = in.baseline_wander;
+    out.noise = in.noise;
+    out.motionRate = in.motion_rate;
+    out.motionAmplitude = in.motion_amplitude;
+    out.fifoOverflowRate = in.fifo_overflow_rate;
+    out.fifoOverflowSamples = (uint16_t)in.fifo_overflow_samples;
+    out.irDc = in.ir_dc;
+    out.redDc = in.red_dc;
+    out.fullScale = in.full_scale;
+    out.ecgGain = in.ecg_gain;
+    out.ecgBaseline = (uint16_t)in.ecg_baseline;
+    return out;
+}
+
+uint32_t cardiac_dsp_abi_version(void) {
+    return CARDIAC_DSP_ABI_VERSION;
+}
+
+void cardiac_thresholds_default(cardiac_thresholds* out) {
+    if (!out) return;
+    AlertThresholds defaults;
+    out->heart_rate_min = defaults.heartRateMin;
+    out->heart_rate_max = defaults.heartRateMax;
+    out->spo2_min = defaults.spO2Min;
+    out->battery_min = defaults.batteryMin;
+    out->enabled = defaults.enabled ? 1 : 0;
+}
+
+void cardiac_physiology_default(cardiac_physiology* out) {
+    if (!out) return;
+    PhysiologyParams defaults;
+    out->heart_rate = defaults.heartRate;
+    out->hrv = defaults.hrv;
+    out->respiration_rate = defaults.respirationRate;
+    out->respiratory_sinus = defaults.respiratorySinus;
+    out->spo2 = defaults.spO2;
+    out->perfusion = defaults.perfusion;
+    out->respiration_depth = defaults.respirationDepth;
+    out->finger_present = defaults.fingerPresent ? 1 : 0;
+    out->baseline_wander = defaults.baselineWander;
+    out->noise = defaults.noise;
+    out->motion_rate = defaults.motionRate;
+    out->motion_amplitude = defaults.motionAmplitude;
+    out->fifo_overflow_rate = defaults.fifoOverflowRate;
+    out->fifo_overflow_samples = defaults.fifoOverflowSamples;
+    out->ir_dc = defaults.irDc;
+    out->red_dc = defaults.redDc;
+    out->full_scale = defaults.fullScale;
+    out->ecg_gain = defaults.ecgGain;
+    out->ecg_baseline = defaults.ecgBaseline;
+}
+
+// ==================== SIGNAL GENERATOR ====================
+struct cardiac_signal {
+    SignalGenerator generator;
+    SignalSample block[256];
+
+    cardiac_signal(float sampleRate, uint64_t seed) : generator(sampleRate, seed) {}
+};
+
+cardiac_signal* cardiac_signal_create(const cardiac_physiology* params, float sample_rate, uint64_t seed) {
+    if (sample_rate <= 0) return nullptr;
+    cardiac_signal* signal = new (std::nothrow) cardiac_signal(sample_rate, seed);
+    if (signal && params) signal->generator.setParams(toPhysiology(*params));
+    return signal;
+}
+
+void cardiac_signal_destroy(cardiac_signal* signal) {
+    delete signal;
+}
+
+void cardiac_signal_set_params(cardiac_signal* signal, const cardiac_physiology* params) {
+    if (signal && params) signal->generator.setParams(toPhysiology(*params));
+}
+
+void cardiac_signal_generate(cardiac_signal* signal, size_t count, uint32_t* red, uint32_t* ir, uint16_t* ecg,
+                             float* heart_rate, uint8_t* beat, uint16_t* lost) {
+    if (!signal) return;
+    // In blocks, through the generator's batch path
+    const size_t blockSize = sizeof(signal->block) / sizeof(signal->block[0]);
+    for (size_t done = 0; done < count;) {
+        size_t n = count - done < blockSize ? count - done : blockSize;
+        signal->generator.generate(signal->block, n);
+        for (size_t i = 0; i < n; i++) {
+            const SignalSample& sample = signal->block[i];
+            if (red) red[done + i] = sample.red;
+            if (ir) ir[done + i] = sample.ir;
+            if (ecg) ecg[done + i] = sample.ecg;
+            if (heart_rate) heart_rate[done + i] = sample.heartRate;
+            if (beat) beat[done + i] = sample.beat;
+            if (lost) lost[done + i] = sample.lost;
+        }
+        done += n;
+    }
+}
+
+// ==================== HEART RATE ====================
+struct cardiac_heart_rate {
+    HeartRateCalculator calculator;
+};
+
+cardiac_heart_rate* cardiac_heart_rate_create(void) {
+    return new (std::nothrow) cardiac_heart_rate();
+}
+
+void cardiac_heart_rate_destroy(cardiac_heart_rate* detector) {
+    delete detector;
+}
+
+void cardiac_heart_rate_reset(cardiac_heart_rate* detector) {
+    if (detector) detector->calculator.reset();
+}
+
+void cardiac_heart_rate_set_threshold(cardiac_heart_rate* detector, int32_t threshold) {
+    if (detector) detector->calculator.setThreshold(threshold);
+}
+
+size_t cardiac_heart_rate_process(cardiac_heart_rate* detector, const int32_t* samples, const uint32_t* times_ms,
+                                  size_t count, uint8_t* beats, int32_t* bpm) {
+    if (!detector || !samples || !times_ms) return 0;
+    size_t found = 0;
+    for (size_t i = 0; i < count; i++) {
+        sampleTimeMs = times_ms[i];
+        bool beat = detector->calculator.checkForBeat(samples[i]);
+        found += beat;
+        if (beats) beats[i] = beat;
+        if (bpm) bpm[i] = detector->calculator.getBeatsPerMinute();
+    }
+    return found;
+}
+
+// ==================== SPO2 ====================
+struct cardiac_spo2 {
+    SpO2Calculator calculator;
+};
+
+cardiac_spo2* cardiac_spo2_create(void) {
+    return new (std::nothrow) cardiac_spo2();
+}
+
+void cardiac_spo2_destroy(cardiac_spo2* estimator) {
+    delete estimator;
+}
+
+void cardiac_spo2_reset(cardiac_spo2* estimator) {
+    if (estimator) estimator->calculator.reset();
+}
+
+void cardiac_spo2_process(cardiac_spo2* estimator, const uint32_t* ir, const uint32_t* red, size_t count,
+                          float* spo2, uint8_t* valid) {
+    if (!estimator || !ir || !red) return;
+    for (size_t i = 0; i < count; i++) {
+        estimator->calculator.addSample(ir[i], red[i]);
+        if (spo2) spo2[i] = estimator->calculator.calculateSpO2();
+        if (valid) valid[i] = estimator->calculator.isValidReading();
+    }
+}
+
+// ==================== PPG ESTIMATOR ====================
+struct cardiac_ppg {
+    PpgEstimator estimator;
+    VitalSigns vitals;          // currentVitals in the sketch: what a rejected window leaves
+};
+
+cardiac_ppg* cardiac_ppg_create(void) {
+    return new (std::nothrow) cardiac_ppg();
+}
+
+void cardiac_ppg_destroy(cardiac_ppg* estimator) {
+    delete estimator;
+}
+
+void cardiac_ppg_reset(cardiac_ppg* estimator) {
+    if (!estimator) return;
+    estimator->estimator.reset();
+    estimator->vitals = VitalSigns();
+}
+
+size_t cardiac_ppg_process(cardiac_ppg* estimator, const uint32_t* red, const uint32_t* ir, size_t count,
+                           uint8_t* finger, cardiac_vitals* windows, uint32_t* window_ends, size_t capacity,
+                           size_t* consumed) {
+    size_t written = 0;
+    size_t i = 0;
+    if (estimator && red && ir) {
+        while (i < count && (written < capacity || !windows)) {
+            bool completed = estimator->estimator.addSample(red[i], ir[i], estimator->vitals);
+            if (finger) finger[i] = estimator->vitals.isFingerDetected;
+            if (completed && windows) {
+                windows[written] = fromVitals(estimator->vitals);
+                if (window_ends) window_ends[written] = (uint32_t)i;
+                written++;
+            }
+            i++;
+        }
+    }
+    if (consumed) *consumed = i;
+    return written;
+}
+
+// ==================== ALARM RULES ====================
+struct cardiac_alarms {
+    AlarmRules rules;
+};
+
+cardiac_alarms* cardiac_alarms_create(void) {
+    return new (std::nothrow) cardiac_alarms();
+}
+
+void cardiac_alarms_destroy(cardiac_alarms* rules) {
+    delete rules;
+}
+
+void cardiac_alarms_reset(cardiac_alarms* rules) {
+    if (rules) rules->rules.reset();
+}
+
+size_t cardiac_alarms_process(cardiac_alarms* rules, const cardiac_thresholds* thresholds,
+                              const cardiac_vitals* vitals, size_t count, cardiac_alarm* alarms, uint32_t* at,
+                              size_t capacity) {
+    if (!rules || !thresholds || !vitals || !alarms) return 0;
+    AlertThresholds limits = toThresholds(*thresholds);
+    size_t raised = 0;
+    for (size_t i = 0; i < count && raised < capacity; i++) {
+        AlarmEvent alarm;
+        if (!rules->rules.check(toVitals(vitals[i]), limits, vitals[i].timestamp_ms, alarm)) continue;
+        alarms[raised] = fromAlarm(alarm);
+        if (at) at[raised] = (uint32_t)i;
+        raised++;
+    }
+    return raised;
+}
+
+size_t cardiac_alarm_format(const cardiac_alarm* alarm, char* buffer, size_t size) {
+    if (!alarm || !buffer) return 0;
+    return formatAlarmMessage(toAlarm(*alarm), buffer, size);
+}
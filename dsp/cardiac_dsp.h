@@ -0,0 +1,189 @@
+#ifndef CARDIAC_DSP_H
+#define CARDIAC_DSP_H
+
+/*
+ * C ABI of the monitor's signal path, built as a shared library for
+ * cardiac.py (through ctypes, see cardiac_dsp.py) and anything else that
+ * wants the native build's numbers without running it:
+ *
+ *   - the synthetic patient of the native build (SignalGenerator)
+ *   - HeartRateCalculator, the IR/ECG beat detector
+ *   - SpO2Calculator, the ratio-of-ratios estimate
+ *   - PpgEstimator, the windowed MAX3010x heart rate / SpO2 estimator
+ *   - AlarmRules and the alarm messages
+ *
+ * The library compiles the same sources as the native build, so for the
+ * same samples it matches the native build, and PpgEstimator runs on the
+ * MAX3010x library's spo2_algorithm.cpp as the device does.
+ * tools/dsp_smoke.py checks a built library against the vendor code.
+ *
+ * Every entry point takes arrays, so a caller crosses the ABI once per
+ * block rather than once per sample. Objects are opaque handles; output
+ * arrays are the caller's, and optional ones may be NULL. The structs are
+ * plain C with fixed-width fields and are only ever added to at the end;
+ * cardiac_dsp_abi_version() goes up with any change a caller could notice.
+ *
+ * Handles are not shared between threads. Time for HeartRateCalculator is
+ * whatever the caller passes with the samples, kept per thread, so separate
+ * handles on separate threads do not interfere.
+ *
+ * Build from the repository root, once PlatformIO has fetched the MAX3010x
+ * library (pio pkg install -e native):
+ *   MAXIM=$(ls -d .pio/libdeps/native/SparkFun*)/src
+ *   g++ -O2 -std=gnu++17 -DARDUINO=10819 -Inative -I. -I"$MAXIM" -fPIC -shared -fvisibility=hidden \
+ *       -o libcardiac_dsp.so dsp/cardiac_dsp.cpp heartrate.cpp spo2_Algorithm.cpp \
+ *       vitals_pipeline.cpp "$MAXIM"/spo2_algorithm.cpp signal_generator.cpp
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CARDIAC_DSP_ABI_VERSION 2
+#define CARDIAC_DSP_API __attribute__((visibility("default")))
+
+// Match AlertLevel and AlarmKind in vitals_pipeline.h
+enum {
+    CARDIAC_ALERT_INFO = 0,
+    CARDIAC_ALERT_WARNING = 1,
+    CARDIAC_ALERT_CRITICAL = 2
+};
+
+enum {
+    CARDIAC_ALARM_HEART_RATE = 0,
+    CARDIAC_ALARM_SPO2 = 1,
+    CARDIAC_ALARM_BATTERY = 2
+};
+
+// VitalSigns
+typedef struct {
+    float heart_rate;
+    float spo2;
+    float battery_level;
+    int32_t finger_detected;
+    uint32_t timestamp_ms;
+    uint32_t sequence;
+} cardiac_vitals;
+
+// AlertThresholds
+typedef struct {
+    float heart_rate_min;
+    float heart_rate_max;
+    float spo2_min;
+    float battery_min;
+    int32_t enabled;
+} cardiac_thresholds;
+
+// AlarmEvent
+typedef struct {
+    int32_t kind;
+    int32_t level;
+    float value;
+    uint32_t timestamp_ms;
+    uint32_t sequence;
+} cardiac_alarm;
+
+// PhysiologyParams
+typedef struct {
+    float heart_rate;
+    float hrv;
+    float respiration_rate;
+    float respiratory_sinus;
+    float spo2;
+    float perfusion;
+    float respiration_depth;
+    int32_t finger_present;
+    float baseline_wander;
+    float noise;
+    float motion_rate;
+    float motion_amplitude;
+    float fifo_overflow_rate;
+    uint32_t fifo_overflow_samples;
+    uint32_t ir_dc;
+    uint32_t red_dc;
+    uint32_t full_scale;
+    float ecg_gain;
+    uint32_t ecg_baseline;
+} cardiac_physiology;
+
+CARDIAC_DSP_API uint32_t cardiac_dsp_abi_version(void);
+CARDIAC_DSP_API void cardiac_thresholds_default(cardiac_thresholds* out);
+CARDIAC_DSP_API void cardiac_physiology_default(cardiac_physiology* out);
+
+// ==================== SIGNAL GENERATOR ====================
+typedef struct cardiac_signal cardiac_signal;
+
+CARDIAC_DSP_API cardiac_signal* cardiac_signal_create(const cardiac_physiology* params, float sample_rate, uint64_t seed);
+CARDIAC_DSP_API void cardiac_signal_destroy(cardiac_signal* signal);
+// Takes effect from the next sample; the sequence carries on
+CARDIAC_DSP_API void cardiac_signal_set_params(cardiac_signal* signal, const cardiac_physiology* params);
+// The next `count` samples; ecg, heart_rate, beat and lost may be NULL
+CARDIAC_DSP_API void cardiac_signal_generate(cardiac_signal* signal, size_t count, uint32_t* red, uint32_t* ir,
+                                             uint16_t* ecg, float* heart_rate, uint8_t* beat, uint16_t* lost);
+
+// ==================== HEART RATE ====================
+typedef struct cardiac_heart_rate cardiac_heart_rate;
+
+CARDIAC_DSP_API cardiac_heart_rate* cardiac_heart_rate_create(void);
+CARDIAC_DSP_API void cardiac_heart_rate_destroy(cardiac_heart_rate* detector);
+CARDIAC_DSP_API void cardiac_heart_rate_reset(cardiac_heart_rate* detector);
+CARDIAC_DSP_API void cardiac_heart_rate_set_threshold(cardiac_heart_rate* detector, int32_t threshold);
+// checkForBeat() on each sample at its time; beats[i] is 1 where it found
+// one and bpm[i] getBeatsPerMinute() after it. Returns the beats found.
+CARDIAC_DSP_API size_t cardiac_heart_rate_process(cardiac_heart_rate* detector, const int32_t* samples,
+                                                  const uint32_t* times_ms, size_t count, uint8_t* beats, int32_t* bpm);
+
+// ==================== SPO2 ====================
+typedef struct cardiac_spo2 cardiac_spo2;
+
+CARDIAC_DSP_API cardiac_spo2* cardiac_spo2_create(void);
+CARDIAC_DSP_API void cardiac_spo2_destroy(cardiac_spo2* estimator);
+CARDIAC_DSP_API void cardiac_spo2_reset(cardiac_spo2* estimator);
+// addSample() on each pair; spo2[i] is calculateSpO2() after it and valid[i]
+// isValidReading()
+CARDIAC_DSP_API void cardiac_spo2_process(cardiac_spo2* estimator, const uint32_t* ir, const uint32_t* red,
+                                          size_t count, float* spo2, uint8_t* valid);
+
+// ==================== PPG ESTIMATOR ====================
+typedef struct cardiac_ppg cardiac_ppg;
+
+#define CARDIAC_PPG_WINDOW_SAMPLES 100
+#define CARDIAC_PPG_SAMPLE_RATE 25          // FreqS: the rate the estimator's windows assume
+
+CARDIAC_DSP_API cardiac_ppg* cardiac_ppg_create(void);
+CARDIAC_DSP_API void cardiac_ppg_destroy(cardiac_ppg* estimator);
+CARDIAC_DSP_API void cardiac_ppg_reset(cardiac_ppg* estimator);
+// Feeds samples until done or `capacity` windows have completed. Each
+// window writes the vitals as the monitor core then holds them (a reading the
+// estimator rejects keeps the previous value) and the index of the sample
+// that completed it. finger[i], if given, follows every sample. Returns
+// the windows written; *consumed, if given, the samples taken. A capacity
+// of count / CARDIAC_PPG_WINDOW_SAMPLES + 1 always takes them all.
+CARDIAC_DSP_API size_t cardiac_ppg_process(cardiac_ppg* estimator, const uint32_t* red, const uint32_t* ir,
+                                           size_t count, uint8_t* finger, cardiac_vitals* windows,
+                                           uint32_t* window_ends, size_t capacity, size_t* consumed);
+
+// ==================== ALARM RULES ====================
+typedef struct cardiac_alarms cardiac_alarms;
+
+CARDIAC_DSP_API cardiac_alarms* cardiac_alarms_create(void);
+CARDIAC_DSP_API void cardiac_alarms_destroy(cardiac_alarms* rules);
+CARDIAC_DSP_API void cardiac_alarms_reset(cardiac_alarms* rules);
+// check() on each reading at its timestamp_ms, stopping after the
+// `capacity`-th alarm; a capacity of `count` always takes every reading.
+// Returns the alarms raised; at[k], if given, is the index of the reading
+// behind alarms[k].
+CARDIAC_DSP_API size_t cardiac_alarms_process(cardiac_alarms* rules, const cardiac_thresholds* thresholds,
+                                              const cardiac_vitals* vitals, size_t count, cardiac_alarm* alarms,
+                                              uint32_t* at, size_t capacity);
+// "Heart rate: 42 BPM" etc., as shown on screen; returns the length
+CARDIAC_DSP_API size_t cardiac_alarm_format(const cardiac_alarm* alarm, char* buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,244 @@
+#include "feed_server.h"
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <memory>
+#include <unordered_map>
+#include "ws_protocol.h"
+#include "monitor_feed.h"
+
+// Default subscription of a monitor's /ws, see ws_clients.cpp
+static const uint8_t DEFAULT_CHANNELS = WS_CHANNEL_VITALS | WS_CHANNEL_ALERTS;
+
+struct FeedSubscriber {
+    int fd;
+    bool open = false;
+    bool closing = false;
+    std::string in;             // Until the handshake is done
+    std::string out;
+    size_t sent = 0;            // Of out
+    WsDecoder decoder;
+    uint8_t channels = DEFAULT_CHANNELS;
+
+    size_t backlog() const { return out.size() - sent; }
+};
+
+// Sends what the socket takes; false if the connection failed
+static bool flush(FeedSubscriber& subscriber) {
+    while (subscriber.sent < subscriber.out.size()) {
+        ssize_t n = send(subscriber.fd, subscriber.out.data() + subscriber.sent,
+                         subscriber.out.size() - subscriber.sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            subscriber.sent += n;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return false;
+        }
+    }
+    if (subscriber.sent == subscriber.out.size()) {
+        subscriber.out.clear();
+        subscriber.sent = 0;
+    } else if (subscriber.sent > 64 * 1024) {
+        subscriber.out.erase(0, subscriber.sent);
+        subscriber.sent = 0;
+    }
+    return true;
+}
+
+// ==================== SERVER ====================
+FeedServer::FeedServer()
+    : listener(-1), wakeup(-1), stopping(false), subscriberCount(0), framesSent(0), framesDropped(0) {}
+
+FeedServer::~FeedServer() {
+    stop();
+}
+
+bool FeedServer::start(uint16_t port) {
+    listener = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (listener < 0) return false;
+    int yes = 1, no = 0;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    setsockopt(listener, IPPROTO_IPV6, IPV6_V6ONLY, &no, sizeof(no));
+
+    sockaddr_in6 address = {};
+    address.sin6_family = AF_INET6;
+    address.sin6_addr = in6addr_any;
+    address.sin6_port = htons(port);
+    if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 64) != 0) {
+        close(listener);
+        listener = -1;
+        return false;
+    }
+    wakeup = eventfd(0, EFD_NONBLOCK);
+    thread = std::thread([this] { run(); });
+    return true;
+}
+
+void FeedServer::stop() {
+    if (!thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    uint64_t one = 1;
+    (void)!write(wakeup, &one, sizeof(one));
+    thread.join();
+    close(wakeup);
+    close(listener);
+    listener = wakeup = -1;
+}
+
+void FeedServer::publish(std::vector<FeedFrame>& batch) {
+    bool wasEmpty;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        wasEmpty = pending.empty();
+        if (wasEmpty) {
+            pending.swap(batch);
+        } else {
+            for (FeedFrame& frame : batch) pending.push_back(std::move(frame));
+        }
+    }
+    batch.clear();
+    // The thread takes everything pending at once, so one wakeup per batch
+    // it has not seen yet is enough
+    if (wasEmpty) {
+        uint64_t one = 1;
+        (void)!write(wakeup, &one, sizeof(one));
+    }
+}
+
+void FeedServer::run() {
+    int epoll = epoll_create1(0);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = (uint64_t)listener;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event);
+    event.data.u64 = (uint64_t)wakeup;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, wakeup, &event);
+
+    std::unordered_map<FeedSubscriber*, std::unique_ptr<FeedSubscriber>> subscribers;
+    std::vector<FeedSubscriber*> dropped;
+    std::vector<FeedFrame> frames;
+    auto drop = [&](FeedSubscriber* subscriber) {
+        if (subscriber->closing) return;
+        subscriber->closing = true;
+        epoll_ctl(epoll, EPOLL_CTL_DEL, subscriber->fd, nullptr);
+        close(subscriber->fd);
+        dropped.push_back(subscriber);
+    };
+
+    epoll_event events[64];
+    bool running = true;
+    while (running) {
+        int ready = epoll_wait(epoll, events, 64, -1);
+        for (int i = 0; i < ready; i++) {
+            uint64_t tag = events[i].data.u64;
+
+            if (tag == (uint64_t)wakeup) {
+                uint64_t count;
+                (void)!read(wakeup, &count, sizeof(count));
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    frames.swap(pending);
+                    running = !stopping;
+                }
+                uint64_t sent = 0, skipped = 0;
+                for (auto& entry : subscribers) {
+                    FeedSubscriber* subscriber = entry.first;
+                    if (!subscriber->open || subscriber->closing) continue;
+                    for (const FeedFrame& frame : frames) {
+                        if (!(subscriber->channels & frame.channel)) continue;
+                        if (frame.channel != WS_CHANNEL_ALERTS && subscriber->backlog() > SOFT_BACKLOG) {
+                            skipped++;
+                            continue;
+                        }
+                        subscriber->out += frame.bytes;
+                        sent++;
+                    }
+                    if (!flush(*subscriber) || subscriber->backlog() > HARD_BACKLOG) drop(subscriber);
+                }
+                frames.clear();
+                framesSent.fetch_add(sent, std::memory_order_relaxed);
+                framesDropped.fetch_add(skipped, std::memory_order_relaxed);
+            } else if (tag == (uint64_t)listener) {
+                int fd;
+                while ((fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK)) >= 0) {
+                    int yes = 1;
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+                    std::unique_ptr<FeedSubscriber> subscriber(new FeedSubscriber());
+                    subscriber->fd = fd;
+                    epoll_event added = {};
+                    added.events = EPOLLIN | EPOLLOUT | EPOLLET | EPOLLRDHUP;
+                    added.data.ptr = subscriber.get();
+                    epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &added);
+                    subscribers[subscriber.get()] = std::move(subscriber);
+                }
+            } else {
+                FeedSubscriber* subscriber = (FeedSubscriber*)events[i].data.ptr;
+                if (subscriber->closing) continue;
+                bool keep = true;
+                auto onMessage = [&](uint8_t opcode, const char* payload, size_t length) {
+                    if (opcode == WS_OP_CLOSE) {
+                        wsAppendFrame(subscriber->out, WS_OP_CLOSE, payload, length >= 2 ? 2 : 0, false);
+                        flush(*subscriber);
+                        keep = false;
+                    } else if (opcode == WS_OP_PING) {
+                        wsAppendFrame(subscriber->out, WS_OP_PONG, payload, length, false);
+                    } else if (opcode == WS_OP_TEXT) {
+                        bool subscribe;
+                        uint8_t channels;
+                        if (!readSubscription(payload, length, subscribe, channels)) return;
+                        if (subscribe) {
+                            subscriber->channels |= channels;
+                        } else {
+                            subscriber->channels &= ~(channels & ~WS_CHANNEL_ALERTS);
+                        }
+                    }
+                };
+
+                char buffer[4096];
+                ssize_t n = 0;
+                while (keep && (n = recv(subscriber->fd, buffer, sizeof(buffer), 0)) > 0) {
+                    if (subscriber->open) {
+                        keep = subscriber->decoder.feed(buffer, n, onMessage) && keep;
+                        continue;
+                    }
+                    subscriber->in.append(buffer, n);
+                    std::string path, key;
+                    size_t consumed;
+                    WsHandshakeResult result = wsReadUpgradeRequest(subscriber->in, path, key, consumed);
+                    if (result == WS_HANDSHAKE_FAILED) keep = false;
+                    if (result != WS_HANDSHAKE_DONE) continue;
+                    wsAppendUpgradeResponse(subscriber->out, key);
+                    subscriber->open = true;
+                    subscriberCount.fetch_add(1, std::memory_order_relaxed);
+                    std::string rest = subscriber->in.substr(consumed);
+                    subscriber->in.clear();
+                    keep = subscriber->decoder.feed(rest.data(), rest.size(), onMessage) && keep;
+                }
+                if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) keep = false;
+                if (keep) keep = flush(*subscriber);
+                if (!keep) drop(subscriber);
+            }
+        }
+
+        for (FeedSubscriber* subscriber : dropped) {
+            if (subscriber->open) subscriberCount.fetch_sub(1, std::memory_order_relaxed);
+            subscribers.erase(subscriber);
+        }
+        dropped.clear();
+    }
+
+    for (auto& entry : subscribers) {
+        if (!entry.first->closing) close(entry.first->fd);
+    }
+    subscriberCount.store(0, std::memory_order_relaxed);
+    close(epoll);
+}
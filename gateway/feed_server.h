@@ -0,0 +1,64 @@
+#ifndef GATEWAY_FEED_SERVER_H
+#define GATEWAY_FEED_SERVER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../ws_clients.h"
+
+// The merged feed: a WebSocket server for the central station on which
+// every monitor's messages arrive, tagged with the device (monitor_feed.h).
+// Subscribers pick channels the way a dashboard does on a monitor: vitals
+// and alerts by default, more with {"type":"subscribe","data":"all"}.
+//
+// Workers hand frames over in batches, already encoded, and one thread owns
+// the subscribers. A subscriber that falls behind loses vitals, waveform
+// and status frames first, like a lagging client on the monitor; alerts
+// are still queued until its backlog reaches HARD_BACKLOG, and then it is
+// dropped.
+
+struct FeedFrame {
+    std::string bytes;          // A whole WebSocket frame
+    WsChannel channel;
+};
+
+class FeedServer {
+public:
+    static const size_t SOFT_BACKLOG = 256 * 1024;
+    static const size_t HARD_BACKLOG = 4 * 1024 * 1024;
+
+private:
+    int listener;
+    int wakeup;                 // eventfd: frames pending, or stop
+    std::thread thread;
+    std::mutex lock;
+    std::vector<FeedFrame> pending;
+    bool stopping;
+    std::atomic<int> subscriberCount;
+    std::atomic<uint64_t> framesSent;
+    std::atomic<uint64_t> framesDropped;
+
+    void run();
+
+public:
+    FeedServer();
+    ~FeedServer();
+
+    // Listens on all interfaces
+    bool start(uint16_t port);
+    void stop();
+
+    // From any thread; takes the frames out of `batch`
+    void publish(std::vector<FeedFrame>& batch);
+    // Lets workers skip building frames nobody would receive
+    bool hasSubscribers() const { return subscriberCount.load(std::memory_order_relaxed) > 0; }
+
+    int getSubscriberCount() const { return subscriberCount.load(std::memory_order_relaxed); }
+    uint64_t getFramesSent() const { return framesSent.load(std::memory_order_relaxed); }
+    uint64_t getFramesDropped() const { return framesDropped.load(std::memory_order_relaxed); }
+};
+
+#endif
@@ -0,0 +1,309 @@
+/*
+ * Ward gateway: keeps a WebSocket connection to every monitor's /ws,
+ * decodes the vitals, alert, waveform and status messages, and republishes
+ * them as one merged feed for the central station, so that it no longer
+ * polls each monitor's /api/vitals.
+ *
+ *   pio run -e gateway && .pio/build/gateway/program \
+ *       --monitor bed-1=10.0.4.21 --monitor bed-2=10.0.4.22 --listen 8090
+ *
+ * or with g++, from the repository root, once PlatformIO has fetched the
+ * MAX3010x library (pio pkg install -e gateway):
+ *   MAXIM=$(ls -d .pio/libdeps/gateway/SparkFun*)/src
+ *   g++ -O2 -std=gnu++17 -DARDUINO=10819 -Inative -I. -I"$MAXIM" -pthread -o gateway gateway/gateway.cpp \
+ *       gateway/monitor_link.cpp gateway/feed_server.cpp gateway/monitor_feed.cpp gateway/ws_protocol.cpp \
+ *       gateway/sim_fleet.cpp gateway/sim_bed.cpp store/vitals_store.cpp store/gorilla.cpp "$MAXIM"/spo2_algorithm.cpp \
+ *       vitals_pipeline.cpp signal_generator.cpp ws_clients.cpp ws_frame_pool.cpp
+ *
+ * Central station clients connect to ws://gateway:8090/ and subscribe as
+ * they would on a monitor (feed_server.h); every message carries "device"
+ * and the gateway's measured "lag" in ms (monitor_link.h).
+ *
+ * --simulate N starts N monitors in-process on loopback (sim_fleet.h) and
+ * connects to those, to measure what the gateway takes:
+ *
+ *   .pio/build/gateway/program --simulate 300 --seconds 60 --json gateway.json --max-lag 50
+ *
+ * --store DIR keeps every vitals message in a VitalsStore there
+ * (store/vitals_store.h), stamped with the gateway's Unix time in ms; the
+ * sealed chunks are flushed to a segment with each report, and the rest on
+ * exit.
+ *
+ * Every --report seconds a line goes to stderr with the monitors up,
+ * messages and bytes per second in and out, and the spread of per-monitor
+ * lag; --json writes the totals and every monitor's figures at the end.
+ * Linux only: the workers are epoll loops.
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#include "monitor_link.h"
+#include "feed_server.h"
+#include "sim_fleet.h"
+#include "../store/vitals_store.h"
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+    stopRequested = 1;
+}
+
+static void usage() {
+    fprintf(stderr,
+        "Usage: gateway [options]\n"
+        "  --monitor SPEC       [NAME=]HOST[:PORT][/PATH] of a monitor's WebSocket\n"
+        "                       (port 80, path /ws by default); repeatable\n"
+        "  --monitors FILE      one SPEC per line, # comments\n"
+        "  --listen PORT        merged feed port (default 8090)\n"
+        "  --workers N          connection worker threads (default 2)\n"
+        "  --simulate N         add N simulated monitors on loopback\n"
+        "  --waveform-rate HZ   waveform frames per second per simulated monitor (default 4)\n"
+        "  --seconds S          run for S seconds, then report and exit (default: until ^C)\n"
+        "  --report S           seconds between stats lines (default 10)\n"
+        "  --json FILE          write the final stats, per monitor, to FILE\n"
+        "  --store DIR          keep the vitals in a time-series store in DIR\n"
+        "  --max-lag MS         exit with status 1 if any monitor's lag exceeded MS\n");
+    exit(2);
+}
+
+static bool readTargets(const char* path, std::vector<MonitorTarget>& targets) {
+    FILE* in = fopen(path, "r");
+    if (!in) return false;
+    char line[512];
+    while (fgets(line, sizeof(line), in)) {
+        std::string spec = line;
+        size_t hash = spec.find('#');
+        if (hash != std::string::npos) spec.erase(hash);
+        spec.erase(spec.find_last_not_of(" \t\r\n") + 1);
+        spec.erase(0, spec.find_first_not_of(" \t"));
+        if (spec.empty()) continue;
+        MonitorTarget target;
+        if (!parseMonitorTarget(spec, target)) {
+            fprintf(stderr, "%s: bad monitor \"%s\"\n", path, spec.c_str());
+            fclose(in);
+            return false;
+        }
+        targets.push_back(target);
+    }
+    fclose(in);
+    return true;
+}
+
+static int32_t percentile(std::vector<int32_t> values, double fraction) {
+    if (values.empty()) return 0;
+    size_t index = (size_t)(fraction * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+// ==================== REPORTING ====================
+struct Totals {
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+    uint32_t failures = 0;
+    int up = 0;
+};
+
+static Totals sumStats(std::vector<std::unique_ptr<MonitorLink>>& links) {
+    Totals totals;
+    for (auto& link : links) {
+        MonitorStats& stats = link->getStats();
+        totals.messages += stats.messages.load(std::memory_order_relaxed);
+        totals.bytes += stats.bytes.load(std::memory_order_relaxed);
+        totals.failures += stats.failures.load(std::memory_order_relaxed);
+        if (stats.up.load(std::memory_order_relaxed)) totals.up++;
+    }
+    return totals;
+}
+
+static bool writeJson(const char* path, std::vector<std::unique_ptr<MonitorLink>>& links, const FeedServer& feed,
+                      double seconds) {
+    FILE* out = fopen(path, "w");
+    if (!out) return false;
+    Totals totals = sumStats(links);
+    std::vector<int32_t> lags;
+    for (auto& link : links) lags.push_back(link->getStats().maxLagMs.load(std::memory_order_relaxed));
+
+    fprintf(out,
+            "{\"seconds\":%.1f,\"monitors\":%u,\"up\":%d,\"messages\":%llu,\"messagesPerSecond\":%.1f,"
+            "\"bytesPerSecond\":%.0f,\"maxLagP50Ms\":%d,\"maxLagP99Ms\":%d,\"maxLagMs\":%d,"
+            "\"feedSubscribers\":%d,\"feedFrames\":%llu,\"feedDropped\":%llu,\"connections\":[",
+            seconds, (unsigned)links.size(), totals.up, (unsigned long long)totals.messages,
+            seconds > 0 ? totals.messages / seconds : 0.0, seconds > 0 ? totals.bytes / seconds : 0.0,
+            (int)percentile(lags, 0.5), (int)percentile(lags, 0.99),
+            lags.empty() ? 0 : (int)*std::max_element(lags.begin(), lags.end()), feed.getSubscriberCount(),
+            (unsigned long long)feed.getFramesSent(), (unsigned long long)feed.getFramesDropped());
+    for (size_t i = 0; i < links.size(); i++) {
+        MonitorStats& stats = links[i]->getStats();
+        fprintf(out,
+                "%s{\"device\":\"%s\",\"up\":%s,\"messages\":%llu,\"bytes\":%llu,\"alerts\":%u,\"connects\":%u,"
+                "\"failures\":%u,\"badMessages\":%u,\"lagMs\":%d,\"maxLagMs\":%d}",
+                i > 0 ? "," : "", links[i]->getTarget().name.c_str(), stats.up.load() ? "true" : "false",
+                (unsigned long long)stats.messages.load(), (unsigned long long)stats.bytes.load(),
+                (unsigned)stats.alerts.load(), (unsigned)stats.connects.load(), (unsigned)stats.failures.load(),
+                (unsigned)stats.badMessages.load(), (int)stats.lagMs.load(), (int)stats.maxLagMs.load());
+    }
+    fprintf(out, "]}\n");
+    fclose(out);
+    return true;
+}
+
+// ==================== MAIN ====================
+int main(int argc, char** argv) {
+    std::vector<MonitorTarget> targets;
+    uint16_t listenPort = 8090;
+    int workerCount = 2;
+    int simulated = 0;
+    SimFleetOptions simOptions;
+    double duration = 0;
+    double reportInterval = 10;
+    const char* jsonPath = nullptr;
+    int32_t maxLag = -1;
+    const char* storeDir = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) usage();
+        const char* value = argv[++i];
+        if (option == "--monitor") {
+            MonitorTarget target;
+            if (!parseMonitorTarget(value, target)) usage();
+            targets.push_back(target);
+        } else if (option == "--monitors") {
+            if (!readTargets(value, targets)) {
+                fprintf(stderr, "Could not read %s\n", value);
+                return 2;
+            }
+        } else if (option == "--listen") listenPort = (uint16_t)atoi(value);
+        else if (option == "--workers") workerCount = atoi(value);
+        else if (option == "--simulate") simulated = atoi(value);
+        else if (option == "--waveform-rate") simOptions.rates.waveformRate = atof(value);
+        else if (option == "--seconds") duration = atof(value);
+        else if (option == "--report") reportInterval = atof(value);
+        else if (option == "--json") jsonPath = value;
+        else if (option == "--max-lag") maxLag = atoi(value);
+        else if (option == "--store") storeDir = value;
+        else usage();
+    }
+    if ((targets.empty() && simulated <= 0) || workerCount < 1 || reportInterval <= 0 ||
+        simOptions.rates.waveformRate <= 0) {
+        usage();
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    SimFleet fleet;
+    if (simulated > 0) {
+        if (!fleet.start(simOptions)) {
+            fprintf(stderr, "Could not start the simulated monitors\n");
+            return 1;
+        }
+        for (int i = 1; i <= simulated; i++) {
+            char spec[64];
+            snprintf(spec, sizeof(spec), "sim-%03d=127.0.0.1:%u/ws?bed=%d", i, fleet.getPort(), i);
+            MonitorTarget target;
+            parseMonitorTarget(spec, target);
+            targets.push_back(target);
+        }
+    }
+
+    std::vector<std::unique_ptr<MonitorLink>> links;
+    for (MonitorTarget& target : targets) {
+        if (!resolveMonitorTarget(target)) {
+            fprintf(stderr, "Cannot resolve %s\n", target.host.c_str());
+            return 1;
+        }
+        links.emplace_back(new MonitorLink(target));
+    }
+
+    FeedServer feed;
+    if (!feed.start(listenPort)) {
+        fprintf(stderr, "Cannot listen on port %u\n", listenPort);
+        return 1;
+    }
+
+    VitalsStore store;
+    if (storeDir && !store.open(storeDir)) {
+        fprintf(stderr, "Cannot open the store in %s\n", storeDir);
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<MonitorWorker>> workers;
+    for (int i = 0; i < workerCount; i++) workers.emplace_back(new MonitorWorker(feed));
+    for (auto& worker : workers) worker->setStore(storeDir ? &store : nullptr);
+    for (size_t i = 0; i < links.size(); i++) workers[i % workerCount]->add(links[i].get());
+    for (auto& worker : workers) worker->start();
+
+    fprintf(stderr, "gateway: %u monitors on %d workers, merged feed on port %u\n", (unsigned)links.size(),
+            workerCount, listenPort);
+
+    uint64_t started = gatewayMillis();
+    uint64_t lastReport = started;
+    Totals last;
+    uint64_t lastFeedFrames = 0;
+    while (!stopRequested) {
+        usleep(100 * 1000);
+        uint64_t now = gatewayMillis();
+        bool finished = duration > 0 && now - started >= duration * 1000;
+        if (now - lastReport < reportInterval * 1000 && !finished) continue;
+
+        double seconds = (now - lastReport) / 1000.0;
+        Totals totals = sumStats(links);
+        uint64_t feedFrames = feed.getFramesSent();
+        std::vector<int32_t> peaks;
+        int32_t worst = -1;
+        const char* worstName = "";
+        for (auto& link : links) {
+            int32_t peak = link->getStats().peakLagMs.exchange(0, std::memory_order_relaxed);
+            peaks.push_back(peak);
+            if (peak > worst) {
+                worst = peak;
+                worstName = link->getTarget().name.c_str();
+            }
+        }
+        fprintf(stderr,
+                "gateway: %d/%u up, %.0f msg/s, %.0f KB/s in, feed %d subscribers %.0f msg/s (%llu dropped), "
+                "lag p50 %d p99 %d max %d ms (%s), %u failures\n",
+                totals.up, (unsigned)links.size(), (totals.messages - last.messages) / seconds,
+                (totals.bytes - last.bytes) / seconds / 1024, feed.getSubscriberCount(),
+                (feedFrames - lastFeedFrames) / seconds, (unsigned long long)feed.getFramesDropped(),
+                (int)percentile(peaks, 0.5), (int)percentile(peaks, 0.99), (int)worst, worstName,
+                totals.failures - last.failures);
+        if (storeDir && !store.flush()) fprintf(stderr, "gateway: could not write to %s\n", storeDir);
+        last = totals;
+        lastFeedFrames = feedFrames;
+        lastReport = now;
+        if (finished) break;
+    }
+
+    double seconds = (gatewayMillis() - started) / 1000.0;
+    if (jsonPath && !writeJson(jsonPath, links, feed, seconds)) {
+        fprintf(stderr, "Could not write %s\n", jsonPath);
+    }
+    for (auto& worker : workers) worker->stop();
+    feed.stop();
+    fleet.stop();
+    if (storeDir) {
+        VitalsStoreStats stored = store.getStats();
+        if (!store.close()) fprintf(stderr, "Could not write the store in %s\n", storeDir);
+        fprintf(stderr, "store: %llu rows from %u devices\n", (unsigned long long)stored.rows, (unsigned)stored.devices);
+    }
+
+    if (maxLag >= 0) {
+        int32_t worst = 0;
+        for (auto& link : links) worst = std::max(worst, link->getStats().maxLagMs.load());
+        fprintf(stderr, "max lag %d ms (budget %d ms): %s\n", (int)worst, (int)maxLag,
+                worst <= maxLag ? "ok" : "over");
+        if (worst > maxLag) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include "monitor_feed.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+// ==================== MONITOR MESSAGES ====================
+bool decodeMonitorMessage(const char* json, size_t length, MonitorMessage& out) {
+    FlatJsonReader reader(json, length);
+    out.type = MonitorMessageType::OTHER;
+    out.timestamp = 0;
+    out.vitals = VitalSigns();
+    out.alert[0] = '\0';
+    out.waveformCount = 0;
+    out.freeHeap = 0;
+    out.uptime = 0;
+
+    const char* key;
+    size_t keyLength;
+    double number;
+    while (reader.next(key, keyLength)) {
+        if (jsonKeyIs(key, keyLength, "type")) {
+            char type[16];
+            reader.readString(type, sizeof(type));
+            if (strcmp(type, "vitals") == 0) out.type = MonitorMessageType::VITALS;
+            else if (strcmp(type, "alert") == 0) out.type = MonitorMessageType::ALERT;
+            else if (strcmp(type, "waveform") == 0) out.type = MonitorMessageType::WAVEFORM;
+            else if (strcmp(type, "status") == 0) out.type = MonitorMessageType::STATUS;
+        } else if (jsonKeyIs(key, keyLength, "timestamp")) {
+            if (reader.readNumber(number)) {
+                out.timestamp = (uint32_t)number;
+                out.vitals.timestamp = out.timestamp;
+            }
+        } else if (jsonKeyIs(key, keyLength, "heartRate")) {
+            if (reader.readNumber(number)) out.vitals.heartRate = (float)number;
+        } else if (jsonKeyIs(key, keyLength, "spO2")) {
+            if (reader.readNumber(number)) out.vitals.spO2 = (float)number;
+        } else if (jsonKeyIs(key, keyLength, "battery")) {
+            if (reader.readNumber(number)) out.vitals.batteryLevel = (float)number;
+        } else if (jsonKeyIs(key, keyLength, "fingerDetected")) {
+            reader.readBool(out.vitals.isFingerDetected);
+        } else if (jsonKeyIs(key, keyLength, "seq")) {
+            if (reader.readNumber(number)) out.vitals.sequence = (uint32_t)number;
+        } else if (jsonKeyIs(key, keyLength, "message")) {
+            reader.readString(out.alert, sizeof(out.alert));
+        } else if (jsonKeyIs(key, keyLength, "data")) {
+            reader.readNumberArray(out.waveform, MonitorMessage::MAX_WAVEFORM, out.waveformCount);
+        } else if (jsonKeyIs(key, keyLength, "freeHeap")) {
+            if (reader.readNumber(number)) out.freeHeap = (uint32_t)number;
+        } else if (jsonKeyIs(key, keyLength, "uptime")) {
+            if (reader.readNumber(number)) out.uptime = (uint32_t)number;
+        } else {
+            reader.skip();
+        }
+    }
+    // The status message has no timestamp; its uptime is the same clock
+    if (out.type == MonitorMessageType::STATUS) out.timestamp = out.uptime;
+    return !reader.hasFailed();
+}
+
+WsChannel monitorMessageChannel(MonitorMessageType type) {
+    switch (type) {
+        case MonitorMessageType::ALERT: return WS_CHANNEL_ALERTS;
+        case MonitorMessageType::WAVEFORM: return WS_CHANNEL_WAVEFORM;
+        case MonitorMessageType::STATUS: return WS_CHANNEL_STATUS;
+        default: return WS_CHANNEL_VITALS;
+    }
+}
+
+// ==================== MERGED FEED ====================
+void appendFeedMessage(std::string& out, const char* device, int32_t lagMs, const char* json, size_t length) {
+    const char* body = (const char*)memchr(json, '{', length);
+    if (!body) return;
+    body++;
+    size_t rest = json + length - body;
+
+    char head[96];
+    int n = snprintf(head, sizeof(head), "{\"device\":\"%s\",\"lag\":%d", device, (int)lagMs);
+    if (n <= 0 || n >= (int)sizeof(head)) return;
+    out.append(head, n);
+    // An empty object stays valid
+    const char* first = body;
+    while (first < json + length && (*first == ' ' || *first == '\n')) first++;
+    if (first < json + length && *first != '}') out += ',';
+    out.append(body, rest);
+}
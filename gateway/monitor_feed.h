@@ -0,0 +1,50 @@
+#ifndef GATEWAY_MONITOR_FEED_H
+#define GATEWAY_MONITOR_FEED_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include "../vital_signs.h"
+#include "../ws_messages.h"
+#include "../json_reader.h"
+#include "../ws_clients.h"
+
+// Decoding of the messages a monitor sends on /ws (ws_messages.h) and the
+// merged feed the gateway republishes them on.
+
+// ==================== MONITOR MESSAGES ====================
+enum class MonitorMessageType : uint8_t {
+    VITALS,
+    ALERT,
+    WAVEFORM,
+    STATUS,
+    OTHER           // Command replies and anything newer firmware sends
+};
+
+struct MonitorMessage {
+    static const size_t MAX_WAVEFORM = 64;
+
+    MonitorMessageType type;
+    uint32_t timestamp;         // Device ms since boot
+    VitalSigns vitals;          // VITALS
+    char alert[96];             // ALERT
+    int32_t waveform[MAX_WAVEFORM];
+    size_t waveformCount;       // WAVEFORM
+    uint32_t freeHeap;          // STATUS
+    uint32_t uptime;
+};
+
+// False if the text is not a JSON object; unknown types decode as OTHER
+bool decodeMonitorMessage(const char* json, size_t length, MonitorMessage& out);
+// The WsChannel a message travels on, for subscriptions
+WsChannel monitorMessageChannel(MonitorMessageType type);
+
+// ==================== MERGED FEED ====================
+// A feed message is the monitor's own, with the device and the gateway's
+// measured lag in front:
+//   {"device":"bed-12","lag":3,"type":"vitals","heartRate":72.0,...}
+// The original members are copied through, not re-serialized, so a field
+// newer firmware adds reaches the central station unchanged.
+void appendFeedMessage(std::string& out, const char* device, int32_t lagMs, const char* json, size_t length);
+
+#endif
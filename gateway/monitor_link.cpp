@@ -0,0 +1,320 @@
+#include "monitor_link.h"
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/tcp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <random>
+#include "monitor_feed.h"
+#include "../store/vitals_store.h"
+
+static const char* SUBSCRIBE_ALL = "{\"type\":\"subscribe\",\"data\":\"all\"}";
+static const int SWEEP_INTERVAL = 100;      // ms between timeout checks
+
+uint64_t gatewayMillis() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static void raiseTo(std::atomic<int32_t>& peak, int32_t value) {
+    int32_t current = peak.load(std::memory_order_relaxed);
+    while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+// ==================== TARGETS ====================
+bool parseMonitorTarget(const std::string& spec, MonitorTarget& target) {
+    std::string rest = spec;
+    size_t equals = rest.find('=');
+    if (equals != std::string::npos) {
+        target.name = rest.substr(0, equals);
+        rest = rest.substr(equals + 1);
+    }
+    size_t slash = rest.find('/');
+    if (slash != std::string::npos) {
+        target.path = rest.substr(slash);
+        rest = rest.substr(0, slash);
+    }
+    size_t colon = rest.find(':');
+    if (colon != std::string::npos) {
+        int port = atoi(rest.c_str() + colon + 1);
+        if (port <= 0 || port > 65535) return false;
+        target.port = (uint16_t)port;
+        rest = rest.substr(0, colon);
+    }
+    if (rest.empty()) return false;
+    target.host = rest;
+    if (target.name.empty()) target.name = target.host + ":" + std::to_string(target.port);
+    // The name goes into the feed's JSON as it is
+    return target.name.find_first_of("\"\\") == std::string::npos;
+}
+
+bool resolveMonitorTarget(MonitorTarget& target) {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(target.host.c_str(), nullptr, &hints, &result) != 0 || !result) return false;
+    memcpy(&target.address, result->ai_addr, sizeof(target.address));
+    target.address.sin_port = htons(target.port);
+    freeaddrinfo(result);
+    return true;
+}
+
+// ==================== LINK ====================
+MonitorLink::MonitorLink(const MonitorTarget& monitorTarget)
+    : target(monitorTarget), fd(-1), state(IDLE), since(0), lastMessageAt(0), retryAt(0), backoff(MIN_BACKOFF),
+      windowStart(0) {
+    windowMin[0] = windowMin[1] = INT64_MAX;
+}
+
+int32_t MonitorLink::measureLag(uint32_t timestamp, uint64_t now) {
+    if (now - windowStart >= LAG_WINDOW) {
+        windowMin[1] = windowMin[0];
+        windowMin[0] = INT64_MAX;
+        windowStart = now;
+    }
+    int64_t delay = (int64_t)now - (int64_t)timestamp;
+    if (delay < windowMin[0]) windowMin[0] = delay;
+    int64_t baseline = windowMin[0] < windowMin[1] ? windowMin[0] : windowMin[1];
+    return (int32_t)(delay - baseline);
+}
+
+// ==================== WORKER ====================
+MonitorWorker::MonitorWorker(FeedServer& feedServer) : feed(feedServer), store(nullptr), epoll(-1), wakeup(-1) {}
+
+MonitorWorker::~MonitorWorker() {
+    stop();
+}
+
+void MonitorWorker::start() {
+    epoll = epoll_create1(0);
+    wakeup = eventfd(0, EFD_NONBLOCK);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, wakeup, &event);
+    thread = std::thread([this] { run(); });
+}
+
+void MonitorWorker::stop() {
+    if (!thread.joinable()) return;
+    uint64_t one = 1;
+    (void)!write(wakeup, &one, sizeof(one));
+    thread.join();
+    for (MonitorLink* link : links) {
+        if (link->fd >= 0) close(link->fd);
+        link->fd = -1;
+        link->stats.up.store(false, std::memory_order_relaxed);
+    }
+    close(wakeup);
+    close(epoll);
+    wakeup = epoll = -1;
+}
+
+void MonitorWorker::run() {
+    // Spread the first connections over a second, not all in one burst
+    uint64_t now = gatewayMillis();
+    for (size_t i = 0; i < links.size(); i++) links[i]->retryAt = now + i * 1000 / links.size();
+
+    epoll_event events[256];
+    uint64_t nextSweep = 0;
+    while (true) {
+        int ready = epoll_wait(epoll, events, 256, SWEEP_INTERVAL);
+        now = gatewayMillis();
+        for (int i = 0; i < ready; i++) {
+            MonitorLink* link = (MonitorLink*)events[i].data.ptr;
+            if (!link) return;
+            // Failed earlier in this batch
+            if (link->fd < 0) continue;
+            onEvent(*link, events[i].events, now);
+        }
+        if (now >= nextSweep) {
+            sweep(now);
+            nextSweep = now + SWEEP_INTERVAL;
+        }
+        if (!batch.empty()) feed.publish(batch);
+    }
+}
+
+void MonitorWorker::sweep(uint64_t now) {
+    for (MonitorLink* link : links) {
+        switch (link->state) {
+            case MonitorLink::IDLE:
+                if (now >= link->retryAt) connect(*link, now);
+                break;
+            case MonitorLink::CONNECTING:
+            case MonitorLink::HANDSHAKE:
+                if (now - link->since > MonitorLink::CONNECT_TIMEOUT) fail(*link, now);
+                break;
+            case MonitorLink::OPEN:
+                if (now - link->lastMessageAt > MonitorLink::IDLE_TIMEOUT) fail(*link, now);
+                break;
+        }
+    }
+}
+
+void MonitorWorker::connect(MonitorLink& link, uint64_t now) {
+    link.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (link.fd < 0) {
+        fail(link, now);
+        return;
+    }
+    int yes = 1;
+    setsockopt(link.fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    link.state = MonitorLink::CONNECTING;
+    link.since = now;
+    if (::connect(link.fd, (const sockaddr*)&link.target.address, sizeof(link.target.address)) != 0 &&
+        errno != EINPROGRESS) {
+        fail(link, now);
+        return;
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLET | EPOLLRDHUP;
+    event.data.ptr = &link;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, link.fd, &event);
+}
+
+void MonitorWorker::fail(MonitorLink& link, uint64_t now) {
+    if (link.fd >= 0) {
+        epoll_ctl(epoll, EPOLL_CTL_DEL, link.fd, nullptr);
+        close(link.fd);
+        link.fd = -1;
+    }
+    if (link.state == MonitorLink::OPEN) link.stats.up.store(false, std::memory_order_relaxed);
+    link.stats.failures.fetch_add(1, std::memory_order_relaxed);
+    link.state = MonitorLink::IDLE;
+    link.in.clear();
+    link.out.clear();
+    link.decoder.reset();
+
+    // 0.5 to 1.5 times the backoff, so a ward that lost its access point
+    // does not come back all at once
+    static thread_local std::minstd_rand rng(std::random_device{}());
+    link.retryAt = now + link.backoff / 2 + rng() % (link.backoff + 1);
+    link.backoff = link.backoff * 2 > MonitorLink::MAX_BACKOFF ? MonitorLink::MAX_BACKOFF : link.backoff * 2;
+}
+
+bool MonitorWorker::flush(MonitorLink& link) {
+    while (!link.out.empty()) {
+        ssize_t n = send(link.fd, link.out.data(), link.out.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+            link.out.erase(0, n);
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MonitorWorker::onEvent(MonitorLink& link, uint32_t events, uint64_t now) {
+    if (link.state == MonitorLink::CONNECTING) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        getsockopt(link.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+        if (error != 0 || (events & (EPOLLERR | EPOLLHUP))) {
+            fail(link, now);
+            return;
+        }
+        if (!(events & EPOLLOUT)) return;
+        link.key = wsMakeKey();
+        wsAppendUpgradeRequest(link.out, link.target.host, link.target.path, link.key);
+        link.state = MonitorLink::HANDSHAKE;
+        link.since = now;
+    }
+
+    bool keep = true;
+    char buffer[16384];
+    ssize_t n = 0;
+    while (keep && (n = recv(link.fd, buffer, sizeof(buffer), 0)) > 0) {
+        if (link.state == MonitorLink::OPEN) {
+            keep = link.decoder.feed(buffer, n, [&](uint8_t opcode, const char* payload, size_t length) {
+                keep = onMessage(link, opcode, payload, length, now) && keep;
+            }) && keep;
+            continue;
+        }
+
+        link.in.append(buffer, n);
+        size_t consumed;
+        WsHandshakeResult result = wsCheckUpgradeResponse(link.in, link.key, consumed);
+        if (result == WS_HANDSHAKE_FAILED) keep = false;
+        if (result != WS_HANDSHAKE_DONE) continue;
+
+        link.state = MonitorLink::OPEN;
+        link.since = link.lastMessageAt = now;
+        link.backoff = MonitorLink::MIN_BACKOFF;
+        // Delays seen over the last connection say nothing about this one
+        link.windowMin[0] = link.windowMin[1] = INT64_MAX;
+        link.stats.up.store(true, std::memory_order_relaxed);
+        link.stats.connects.fetch_add(1, std::memory_order_relaxed);
+        wsAppendFrame(link.out, WS_OP_TEXT, SUBSCRIBE_ALL, strlen(SUBSCRIBE_ALL), true);
+
+        std::string rest = link.in.substr(consumed);
+        link.in.clear();
+        keep = link.decoder.feed(rest.data(), rest.size(), [&](uint8_t opcode, const char* payload, size_t length) {
+            keep = onMessage(link, opcode, payload, length, now) && keep;
+        }) && keep;
+    }
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) keep = false;
+    if (keep) keep = flush(link);
+    if (!keep) fail(link, now);
+}
+
+bool MonitorWorker::onMessage(MonitorLink& link, uint8_t opcode, const char* payload, size_t length, uint64_t now) {
+    if (opcode == WS_OP_CLOSE) {
+        wsAppendFrame(link.out, WS_OP_CLOSE, payload, length >= 2 ? 2 : 0, true);
+        flush(link);
+        return false;
+    }
+    if (opcode == WS_OP_PING) {
+        wsAppendFrame(link.out, WS_OP_PONG, payload, length, true);
+        return true;
+    }
+    if (opcode == WS_OP_PONG) return true;
+
+    link.lastMessageAt = now;
+    MonitorStats& stats = link.stats;
+    stats.messages.fetch_add(1, std::memory_order_relaxed);
+    stats.bytes.fetch_add(length, std::memory_order_relaxed);
+    // The monitors send text; anything else is counted and passed over
+    if (opcode != WS_OP_TEXT) return true;
+
+    MonitorMessage message;
+    if (!decodeMonitorMessage(payload, length, message)) {
+        stats.badMessages.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    if (message.type == MonitorMessageType::ALERT) stats.alerts.fetch_add(1, std::memory_order_relaxed);
+    if (message.type == MonitorMessageType::VITALS && store) {
+        // The monitor's millis() restarts with it; the store wants one clock for the ward
+        VitalSigns stamped = message.vitals;
+        stamped.timestamp = (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+                                std::chrono::system_clock::now().time_since_epoch()).count();
+        store->append(link.target.name, stamped);
+    }
+
+    int32_t lag = 0;
+    if (message.type != MonitorMessageType::OTHER) {
+        lag = link.measureLag(message.timestamp, now);
+        stats.lagMs.store(lag, std::memory_order_relaxed);
+        raiseTo(stats.peakLagMs, lag);
+        raiseTo(stats.maxLagMs, lag);
+    }
+
+    if (message.type != MonitorMessageType::OTHER && feed.hasSubscribers()) {
+        scratch.clear();
+        appendFeedMessage(scratch, link.target.name.c_str(), lag, payload, length);
+        FeedFrame frame;
+        wsAppendFrame(frame.bytes, WS_OP_TEXT, scratch.data(), scratch.size(), false);
+        frame.channel = monitorMessageChannel(message.type);
+        batch.push_back(std::move(frame));
+    }
+    return true;
+}
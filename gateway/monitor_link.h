@@ -0,0 +1,130 @@
+#ifndef GATEWAY_MONITOR_LINK_H
+#define GATEWAY_MONITOR_LINK_H
+
+#include <stdint.h>
+#include <netinet/in.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ws_protocol.h"
+#include "feed_server.h"
+
+class VitalsStore;
+
+// The gateway's side of the monitors: one persistent WebSocket connection
+// per monitor, subscribed to every channel, and a small pool of workers
+// that each run an epoll loop over their share of the connections. A
+// connection that fails, closes or goes quiet (a monitor sends vitals every
+// second) is retried with jittered backoff from 1 s up to 30 s.
+//
+// Lag: monitors stamp their messages with their own millis(), which shares
+// no epoch with the gateway's clock. Arrival time minus the stamp is the
+// one-way delay plus an unknown offset; the smallest value seen stands for
+// the offset, and a message's lag is how far it arrived beyond that. The
+// smallest is taken over the last two minutes, so clock drift and reboots
+// do not pile up.
+
+struct MonitorTarget {
+    std::string name;           // "device" in the merged feed
+    std::string host;
+    uint16_t port = 80;
+    std::string path = "/ws";
+    sockaddr_in address;        // Resolved once, at startup
+};
+
+// [NAME=]HOST[:PORT][/PATH]; the name defaults to HOST:PORT
+bool parseMonitorTarget(const std::string& spec, MonitorTarget& target);
+bool resolveMonitorTarget(MonitorTarget& target);
+
+// What the reporting thread reads; written by the link's worker
+struct MonitorStats {
+    std::atomic<bool> up{false};
+    std::atomic<uint64_t> messages{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint32_t> alerts{0};
+    std::atomic<uint32_t> connects{0};
+    std::atomic<uint32_t> failures{0};
+    std::atomic<uint32_t> badMessages{0};   // Not JSON
+    std::atomic<int32_t> lagMs{0};          // Of the latest message
+    std::atomic<int32_t> peakLagMs{0};      // Since the reporter last took it
+    std::atomic<int32_t> maxLagMs{0};       // Whole run
+};
+
+class MonitorLink {
+public:
+    enum State : uint8_t {
+        IDLE,                   // Waiting to retry
+        CONNECTING,
+        HANDSHAKE,
+        OPEN
+    };
+
+    static const uint32_t CONNECT_TIMEOUT = 5000;
+    static const uint32_t IDLE_TIMEOUT = 10000;
+    static const uint32_t MIN_BACKOFF = 1000;
+    static const uint32_t MAX_BACKOFF = 30000;
+    static const uint32_t LAG_WINDOW = 60000;
+
+private:
+    MonitorTarget target;
+    MonitorStats stats;
+    int fd;
+    State state;
+    uint64_t since;             // Of the current state, ms
+    uint64_t lastMessageAt;
+    uint64_t retryAt;
+    uint32_t backoff;
+    std::string key;
+    std::string in;             // Until the handshake is done
+    std::string out;
+    WsDecoder decoder;
+
+    int64_t windowMin[2];       // Smallest arrival - stamp, this and the last window
+    uint64_t windowStart;
+
+    friend class MonitorWorker;
+
+public:
+    explicit MonitorLink(const MonitorTarget& monitorTarget);
+
+    const MonitorTarget& getTarget() const { return target; }
+    MonitorStats& getStats() { return stats; }
+    // Lag of a message stamped `timestamp` arriving at `now`
+    int32_t measureLag(uint32_t timestamp, uint64_t now);
+};
+
+class MonitorWorker {
+private:
+    FeedServer& feed;
+    VitalsStore* store;         // Where vitals are kept, if anywhere
+    std::vector<MonitorLink*> links;
+    int epoll;
+    int wakeup;
+    std::thread thread;
+    std::vector<FeedFrame> batch;
+    std::string scratch;
+
+    void run();
+    void connect(MonitorLink& link, uint64_t now);
+    void fail(MonitorLink& link, uint64_t now);
+    void onEvent(MonitorLink& link, uint32_t events, uint64_t now);
+    bool onMessage(MonitorLink& link, uint8_t opcode, const char* payload, size_t length, uint64_t now);
+    bool flush(MonitorLink& link);
+    void sweep(uint64_t now);
+
+public:
+    explicit MonitorWorker(FeedServer& feedServer);
+    ~MonitorWorker();
+
+    // Before start()
+    void add(MonitorLink* link) { links.push_back(link); }
+    // Appends every vitals message, stamped with the gateway's Unix time
+    void setStore(VitalsStore* vitalsStore) { store = vitalsStore; }
+    void start();
+    void stop();
+};
+
+uint64_t gatewayMillis();
+
+#endif
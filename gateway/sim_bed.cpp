@@ -0,0 +1,125 @@
+#include "sim_bed.h"
+#include <stdio.h>
+#include <string.h>
+#include "spo2_algorithm.h"       // FreqS, from the MAX3010x library
+
+SimBed::SimBed()
+    : bed(0), generator(FreqS), waveformCount(0), startedAt(0), samples(0), nextVitals(0), nextWaveform(0),
+      nextStatus(0), random(1) {}
+
+uint32_t SimBed::interval(float ms) {
+    if (rates.jitter <= 0) return (uint32_t)ms;
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    float spread = (random >> 8) / (float)(1 << 24) * 2 - 1;
+    float varied = ms * (1 + rates.jitter * spread);
+    return varied < 1 ? 1 : (uint32_t)varied;
+}
+
+void SimBed::admit(uint32_t bedNumber, uint32_t deviceNow, const SimBedRates& bedRates) {
+    bed = bedNumber;
+    rates = bedRates;
+    random = bedNumber * 2654435761u | 1;
+
+    PhysiologyParams patient;
+    patient.heartRate = 58.0f + (bed * 37) % 50;
+    patient.spO2 = 99.0f - (bed * 5) % 8;
+    if (bed % 17 == 5) patient.heartRate = 42.0f;
+    patient.motionRate = (bed % 7 == 3) ? 2.0f : 0.0f;
+    generator.setParams(patient);
+    generator.seed(bed + 1);
+    vitals.batteryLevel = 100.0f - bed % 60;
+
+    // Fill the estimator's first window at once, and by a different amount
+    // on every bed so that their windows do not all complete on one tick
+    SignalSample sample;
+    int prime = PpgEstimator::WINDOW_SAMPLES + (int)(bed * 31) % PpgEstimator::WINDOW_SAMPLES;
+    for (int i = 0; i < prime; i++) {
+        generator.next(sample);
+        estimator.addSample(sample.red, sample.ir, vitals);
+    }
+    startedAt = deviceNow;
+    samples = 0;
+    waveformCount = 0;
+
+    // Spread the beds' schedules, so a fleet does not send in bursts
+    uint32_t vitalsMs = (uint32_t)(1000 / rates.vitalsRate);
+    uint32_t waveformMs = (uint32_t)(1000 / rates.waveformRate);
+    uint32_t statusMs = (uint32_t)(rates.statusInterval * 1000);
+    nextVitals = deviceNow + (bed * 53) % (vitalsMs > 0 ? vitalsMs : 1);
+    nextWaveform = deviceNow + (bed * 13) % (waveformMs > 0 ? waveformMs : 1);
+    nextStatus = deviceNow + (bed * 211) % (statusMs > 0 ? statusMs : 1);
+}
+
+void SimBed::advance(uint32_t deviceNow, uint8_t wanted, const Emit& emit) {
+    char text[512];
+
+    // Samples first, so that a message due now reports them
+    uint64_t due = (uint64_t)(deviceNow - startedAt) * FreqS / 1000;
+    SignalSample sample;
+    while (samples < due) {
+        generator.next(sample);
+        samples++;
+        estimator.addSample(sample.red, sample.ir, vitals);
+        if (waveformCount == MonitorMessage::MAX_WAVEFORM) {
+            memmove(waveform, waveform + 1, (MonitorMessage::MAX_WAVEFORM - 1) * sizeof(waveform[0]));
+            waveformCount--;
+        }
+        waveform[waveformCount++] = (int32_t)sample.ir;
+    }
+
+    while ((int32_t)(deviceNow - nextWaveform) >= 0) {
+        nextWaveform += interval(1000 / rates.waveformRate);
+        if (!(wanted & WS_CHANNEL_WAVEFORM) || waveformCount == 0) {
+            waveformCount = 0;
+            continue;
+        }
+        int n = snprintf(text, sizeof(text), "{\"type\":\"waveform\",\"timestamp\":%u,\"data\":[", deviceNow);
+        for (size_t i = 0; i < waveformCount && n < (int)sizeof(text) - 16; i++) {
+            n += snprintf(text + n, sizeof(text) - n, "%s%d", i > 0 ? "," : "", (int)waveform[i]);
+        }
+        n += snprintf(text + n, sizeof(text) - n, "]}");
+        waveformCount = 0;
+        emit(WS_CHANNEL_WAVEFORM, text, n);
+    }
+
+    while ((int32_t)(deviceNow - nextVitals) >= 0) {
+        nextVitals += interval(1000 / rates.vitalsRate);
+        vitals.timestamp = deviceNow;
+        vitals.sequence = (uint32_t)samples;
+        if (wanted & WS_CHANNEL_VITALS) {
+            size_t n = jsonSerialize<VitalsMessageSchema>(vitals, text, sizeof(text));
+            emit(WS_CHANNEL_VITALS, text, n);
+        }
+
+        AlarmEvent alarm;
+        if (vitals.isFingerDetected && rules.check(vitals, thresholds, deviceNow, alarm)) {
+            char message[64];
+            formatAlarmMessage(alarm, message, sizeof(message));
+            AlertMessage alert;
+            alert.message = message;
+            alert.timestamp = deviceNow;
+            size_t n = jsonSerialize(alert, text, sizeof(text));
+            emit(WS_CHANNEL_ALERTS, text, n);
+        }
+    }
+
+    while ((int32_t)(deviceNow - nextStatus) >= 0) {
+        nextStatus += interval(rates.statusInterval * 1000);
+        if (wanted & WS_CHANNEL_STATUS) {
+            size_t n = jsonSerialize<StatusMessageSchema>(getStatus(deviceNow, 1), text, sizeof(text));
+            emit(WS_CHANNEL_STATUS, text, n);
+        }
+    }
+}
+
+SystemStatus SimBed::getStatus(uint32_t deviceNow, int clients) const {
+    SystemStatus status;
+    status.wifiConnected = true;
+    status.freeHeap = 180000 + bed % 4096;
+    status.uptime = deviceNow;
+    status.version = "2.0.0";
+    status.clients = clients;
+    return status;
+}
@@ -0,0 +1,69 @@
+#ifndef GATEWAY_SIM_BED_H
+#define GATEWAY_SIM_BED_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include "monitor_feed.h"
+#include "../signal_generator.h"
+#include "../vitals_pipeline.h"
+
+// One simulated monitor: the firmware's sample-to-alarm path
+// (vitals_pipeline.h) on a SignalGenerator patient, producing what /ws
+// sends (ws_messages.h) on a schedule of its own. The gateway's
+// --simulate fleet (sim_fleet.h) and the load generator (loadgen/) serve
+// these over their sockets.
+//
+// Bed N always shows the same patient. Some beds are bradycardic, hypoxic
+// or moving, so that alerts and dropouts flow too. Times are device ms
+// since the monitor's boot, as in the messages.
+
+struct SimBedRates {
+    float vitalsRate = 1;           // Vitals messages per second; the firmware sends 1
+    float waveformRate = 4;         // Waveform frames per second
+    float statusInterval = 5;       // Seconds between status messages
+    float jitter = 0;               // Each interval varies by up to this fraction either way
+};
+
+class SimBed {
+public:
+    // A message due on `channel`; `text` is only valid during the call
+    typedef std::function<void(WsChannel channel, const char* text, size_t length)> Emit;
+
+private:
+    uint32_t bed;
+    SimBedRates rates;
+    SignalGenerator generator;
+    PpgEstimator estimator;
+    AlarmRules rules;
+    AlertThresholds thresholds;
+    VitalSigns vitals;
+    int32_t waveform[MonitorMessage::MAX_WAVEFORM];
+    size_t waveformCount;
+    uint32_t startedAt;
+    uint64_t samples;
+    uint32_t nextVitals;
+    uint32_t nextWaveform;
+    uint32_t nextStatus;
+    uint32_t random;                // xorshift32 state of the jitter
+
+    // `ms` varied by the jitter
+    uint32_t interval(float ms);
+
+public:
+    SimBed();
+
+    // Bed `bedNumber`'s patient, as of device time `deviceNow`
+    void admit(uint32_t bedNumber, uint32_t deviceNow, const SimBedRates& bedRates);
+    // Runs the bed up to `deviceNow`; calls emit for every message due on
+    // a channel in `wanted`. Alerts are always due.
+    void advance(uint32_t deviceNow, uint8_t wanted, const Emit& emit);
+
+    uint32_t getBed() const { return bed; }
+    // The latest estimate, as /api/vitals serves it
+    const VitalSigns& getVitals() const { return vitals; }
+    // As /api/status and the status message report it
+    SystemStatus getStatus(uint32_t deviceNow, int clients) const;
+};
+
+#endif
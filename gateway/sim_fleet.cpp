@@ -0,0 +1,252 @@
+#include "sim_fleet.h"
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ws_protocol.h"
+#include "monitor_feed.h"
+#include "sim_bed.h"
+
+static const uint32_t TICK_MS = 40;                 // One sample at the estimator's 25 Hz
+static const size_t MAX_BACKLOG = 1024 * 1024;      // Unsent bytes before the monitor drops the client
+
+static uint64_t steadyMillis() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// ==================== MONITOR ====================
+struct SimMonitor {
+    int fd;
+    bool open = false;              // Handshake done
+    bool closing = false;           // Dropped; freed after the current batch of events
+    std::string in;                 // Until the handshake is done
+    std::string out;
+    WsDecoder decoder;
+    uint8_t channels = WS_CHANNEL_VITALS | WS_CHANNEL_ALERTS;
+    uint64_t bootAt = 0;            // steadyMillis() of the simulated boot
+    SimBed bed;
+};
+
+// Boots are staggered over the hour before the fleet started
+static void admit(SimMonitor& monitor, uint32_t bed, uint64_t now, const SimBedRates& rates) {
+    monitor.bootAt = now - 60000 - (uint64_t)(bed * 7919) % 3600000;
+    monitor.bed.admit(bed, (uint32_t)(now - monitor.bootAt), rates);
+}
+
+static void sendText(SimMonitor& monitor, const char* text, size_t length) {
+    wsAppendFrame(monitor.out, WS_OP_TEXT, text, length, false);
+}
+
+static bool flush(SimMonitor& monitor) {
+    while (!monitor.out.empty()) {
+        ssize_t n = send(monitor.fd, monitor.out.data(), monitor.out.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+            monitor.out.erase(0, n);
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return monitor.out.size() <= MAX_BACKLOG;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Subscribe/unsubscribe as web_interface.cpp handles them; false on close
+static bool handleMessage(SimMonitor& monitor, uint8_t opcode, const char* payload, size_t length) {
+    if (opcode == WS_OP_CLOSE) {
+        wsAppendFrame(monitor.out, WS_OP_CLOSE, payload, length >= 2 ? 2 : 0, false);
+        flush(monitor);
+        return false;
+    }
+    if (opcode == WS_OP_PING) {
+        wsAppendFrame(monitor.out, WS_OP_PONG, payload, length, false);
+        return true;
+    }
+    if (opcode != WS_OP_TEXT) return true;
+
+    bool subscribe;
+    uint8_t channels;
+    if (readSubscription(payload, length, subscribe, channels)) {
+        if (subscribe) {
+            monitor.channels |= channels;
+        } else {
+            monitor.channels &= ~(channels & ~WS_CHANNEL_ALERTS);
+        }
+    }
+    return true;
+}
+
+// Runs the monitor up to `now`; what it has to say goes into its buffer
+static void advance(SimMonitor& monitor, uint64_t now, std::atomic<uint64_t>& sent) {
+    uint64_t messages = 0;
+    monitor.bed.advance((uint32_t)(now - monitor.bootAt), monitor.channels,
+                        [&](WsChannel, const char* text, size_t length) {
+        sendText(monitor, text, length);
+        messages++;
+    });
+    sent.fetch_add(messages, std::memory_order_relaxed);
+}
+
+// ==================== FLEET ====================
+SimFleet::SimFleet() : listener(-1), wakeup(-1), port(0), messagesSent(0), monitorCount(0) {}
+
+SimFleet::~SimFleet() {
+    stop();
+}
+
+bool SimFleet::start(const SimFleetOptions& fleetOptions) {
+    options = fleetOptions;
+    listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (listener < 0) return false;
+    int yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(options.port);
+    if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 1024) != 0) {
+        close(listener);
+        listener = -1;
+        return false;
+    }
+    socklen_t length = sizeof(address);
+    getsockname(listener, (sockaddr*)&address, &length);
+    port = ntohs(address.sin_port);
+
+    wakeup = eventfd(0, EFD_NONBLOCK);
+    thread = std::thread([this] { run(); });
+    return true;
+}
+
+void SimFleet::stop() {
+    if (!thread.joinable()) return;
+    uint64_t one = 1;
+    (void)!write(wakeup, &one, sizeof(one));
+    thread.join();
+    close(wakeup);
+    close(listener);
+    listener = wakeup = -1;
+}
+
+void SimFleet::run() {
+    int epoll = epoll_create1(0);
+    int timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    itimerspec period = {};
+    period.it_interval.tv_nsec = TICK_MS * 1000000L;
+    period.it_value = period.it_interval;
+    timerfd_settime(timer, 0, &period, nullptr);
+
+    // data.fd for the fixed descriptors, data.ptr for monitors: the fixed
+    // ones are told apart by value, descriptors being small
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = (uint64_t)listener;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event);
+    event.data.u64 = (uint64_t)timer;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, timer, &event);
+    event.data.u64 = (uint64_t)wakeup;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, wakeup, &event);
+
+    std::unordered_map<SimMonitor*, std::unique_ptr<SimMonitor>> monitors;
+    std::vector<SimMonitor*> dropped;
+    auto drop = [&](SimMonitor* monitor) {
+        if (monitor->closing) return;
+        monitor->closing = true;
+        epoll_ctl(epoll, EPOLL_CTL_DEL, monitor->fd, nullptr);
+        close(monitor->fd);
+        dropped.push_back(monitor);
+    };
+
+    epoll_event events[256];
+    bool running = true;
+    while (running) {
+        int ready = epoll_wait(epoll, events, 256, -1);
+        for (int i = 0; i < ready; i++) {
+            uint64_t tag = events[i].data.u64;
+
+            if (tag == (uint64_t)wakeup) {
+                running = false;
+            } else if (tag == (uint64_t)listener) {
+                int fd;
+                while ((fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK)) >= 0) {
+                    int yes = 1;
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+                    std::unique_ptr<SimMonitor> monitor(new SimMonitor());
+                    monitor->fd = fd;
+                    epoll_event added = {};
+                    added.events = EPOLLIN | EPOLLOUT | EPOLLET | EPOLLRDHUP;
+                    added.data.ptr = monitor.get();
+                    epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &added);
+                    monitors[monitor.get()] = std::move(monitor);
+                }
+                monitorCount.store((int)monitors.size(), std::memory_order_relaxed);
+            } else if (tag == (uint64_t)timer) {
+                uint64_t expirations;
+                (void)!read(timer, &expirations, sizeof(expirations));
+                uint64_t now = steadyMillis();
+                for (auto& entry : monitors) {
+                    SimMonitor* monitor = entry.first;
+                    if (!monitor->open || monitor->closing) continue;
+                    advance(*monitor, now, messagesSent);
+                    if (!flush(*monitor)) drop(monitor);
+                }
+            } else {
+                SimMonitor* monitor = (SimMonitor*)events[i].data.ptr;
+                if (monitor->closing) continue;
+                bool keep = true;
+                char buffer[4096];
+                ssize_t n = 0;
+                while (keep && (n = recv(monitor->fd, buffer, sizeof(buffer), 0)) > 0) {
+                    if (!monitor->open) {
+                        monitor->in.append(buffer, n);
+                        std::string path, key;
+                        size_t consumed;
+                        WsHandshakeResult result = wsReadUpgradeRequest(monitor->in, path, key, consumed);
+                        if (result == WS_HANDSHAKE_FAILED) keep = false;
+                        if (result != WS_HANDSHAKE_DONE) continue;
+                        size_t bed = path.find("bed=");
+                        admit(*monitor, bed != std::string::npos ? (uint32_t)atoi(path.c_str() + bed + 4) : 0,
+                              steadyMillis(), options.rates);
+                        wsAppendUpgradeResponse(monitor->out, key);
+                        monitor->open = true;
+                        std::string rest = monitor->in.substr(consumed);
+                        monitor->in.clear();
+                        keep = monitor->decoder.feed(rest.data(), rest.size(), [&](uint8_t opcode, const char* p, size_t l) {
+                            keep = keep && handleMessage(*monitor, opcode, p, l);
+                        }) && keep;
+                    } else {
+                        keep = monitor->decoder.feed(buffer, n, [&](uint8_t opcode, const char* p, size_t l) {
+                            keep = keep && handleMessage(*monitor, opcode, p, l);
+                        }) && keep;
+                    }
+                }
+                if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) keep = false;
+                if (keep) keep = flush(*monitor);
+                if (!keep) drop(monitor);
+            }
+        }
+        for (SimMonitor* monitor : dropped) monitors.erase(monitor);
+        dropped.clear();
+        monitorCount.store((int)monitors.size(), std::memory_order_relaxed);
+    }
+
+    for (auto& entry : monitors) {
+        if (!entry.first->closing) close(entry.first->fd);
+    }
+    close(timer);
+    close(epoll);
+}
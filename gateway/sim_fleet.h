@@ -0,0 +1,49 @@
+#ifndef GATEWAY_SIM_FLEET_H
+#define GATEWAY_SIM_FLEET_H
+
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include "sim_bed.h"
+
+// Simulated monitors to measure the gateway against: a loopback WebSocket
+// server on which every connection is one monitor (sim_bed.h), sending
+// what /ws sends: vitals every second, waveform frames, status every 5 s
+// and an alert whenever the alarm rules raise one.
+//
+// The bed number comes from the path, /ws?bed=N; it picks the patient, so
+// a bed always shows the same vitals. Timestamps are ms since the
+// monitor's boot, which is staggered over the hour before the fleet
+// started.
+
+struct SimFleetOptions {
+    uint16_t port = 0;              // 0: any free loopback port
+    SimBedRates rates;
+};
+
+class SimFleet {
+private:
+    int listener;
+    int wakeup;                     // eventfd that stops the thread
+    uint16_t port;
+    SimFleetOptions options;
+    std::thread thread;
+    std::atomic<uint64_t> messagesSent;
+    std::atomic<int> monitorCount;
+
+    void run();
+
+public:
+    SimFleet();
+    ~SimFleet();
+
+    // Binds and starts serving; false if the port could not be bound
+    bool start(const SimFleetOptions& fleetOptions);
+    void stop();
+
+    uint16_t getPort() const { return port; }
+    uint64_t getMessagesSent() const { return messagesSent.load(std::memory_order_relaxed); }
+    int getMonitorCount() const { return monitorCount.load(std::memory_order_relaxed); }
+};
+
+#endif
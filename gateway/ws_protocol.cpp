@@ -0,0 +1,273 @@
+#include "ws_protocol.h"
+#include <string.h>
+#include <strings.h>
+#include <random>
+
+static const char* WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+// ==================== SHA-1 / BASE64 ====================
+// Only for the 60-byte accept key, so one straightforward block loop
+static void sha1(const uint8_t* data, size_t length, uint8_t digest[20]) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    std::string padded((const char*)data, length);
+    padded += (char)0x80;
+    while (padded.size() % 64 != 56) padded += (char)0;
+    uint64_t bits = (uint64_t)length * 8;
+    for (int i = 7; i >= 0; i--) padded += (char)(bits >> (i * 8));
+
+    for (size_t block = 0; block < padded.size(); block += 64) {
+        const uint8_t* p = (const uint8_t*)padded.data() + block;
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (uint32_t)p[i * 4] << 24 | (uint32_t)p[i * 4 + 1] << 16 | (uint32_t)p[i * 4 + 2] << 8 | p[i * 4 + 3];
+        }
+        for (int i = 16; i < 80; i++) {
+            uint32_t x = w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16];
+            w[i] = x << 1 | x >> 31;
+        }
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20) { f = (b & c) | (~b & d); k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else { f = b ^ c ^ d; k = 0xCA62C1D6; }
+            uint32_t t = (a << 5 | a >> 27) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = b << 30 | b >> 2;
+            b = a;
+            a = t;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+    for (int i = 0; i < 20; i++) digest[i] = (uint8_t)(h[i / 4] >> (24 - (i % 4) * 8));
+}
+
+static std::string base64(const uint8_t* data, size_t length) {
+    static const char* ALPHABET = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    for (size_t i = 0; i < length; i += 3) {
+        uint32_t v = (uint32_t)data[i] << 16;
+        if (i + 1 < length) v |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < length) v |= data[i + 2];
+        out += ALPHABET[v >> 18 & 63];
+        out += ALPHABET[v >> 12 & 63];
+        out += i + 1 < length ? ALPHABET[v >> 6 & 63] : '=';
+        out += i + 2 < length ? ALPHABET[v & 63] : '=';
+    }
+    return out;
+}
+
+static uint32_t randomWord() {
+    static thread_local std::mt19937 rng(std::random_device{}());
+    return rng();
+}
+
+// ==================== HANDSHAKE ====================
+std::string wsAcceptKey(const std::string& key) {
+    std::string text = key + WS_GUID;
+    uint8_t digest[20];
+    sha1((const uint8_t*)text.data(), text.size(), digest);
+    return base64(digest, sizeof(digest));
+}
+
+std::string wsMakeKey() {
+    uint8_t nonce[16];
+    for (int i = 0; i < 16; i += 4) {
+        uint32_t word = randomWord();
+        memcpy(nonce + i, &word, 4);
+    }
+    return base64(nonce, sizeof(nonce));
+}
+
+void wsAppendUpgradeRequest(std::string& out, const std::string& host, const std::string& path, const std::string& key) {
+    out += "GET " + path + " HTTP/1.1\r\n"
+           "Host: " + host + "\r\n"
+           "Upgrade: websocket\r\n"
+           "Connection: Upgrade\r\n"
+           "Sec-WebSocket-Key: " + key + "\r\n"
+           "Sec-WebSocket-Version: 13\r\n\r\n";
+}
+
+void wsAppendUpgradeResponse(std::string& out, const std::string& key) {
+    out += "HTTP/1.1 101 Switching Protocols\r\n"
+           "Upgrade: websocket\r\n"
+           "Connection: Upgrade\r\n"
+           "Sec-WebSocket-Accept: " + wsAcceptKey(key) + "\r\n\r\n";
+}
+
+std::string httpHeaderValue(const std::string& in, size_t length, const char* name) {
+    size_t nameLength = strlen(name);
+    size_t line = in.find("\r\n");
+    while (line != std::string::npos && line + 2 < length) {
+        size_t start = line + 2;
+        size_t end = in.find("\r\n", start);
+        if (end == std::string::npos || end > length) break;
+        if (end - start > nameLength && in[start + nameLength] == ':' &&
+            strncasecmp(in.data() + start, name, nameLength) == 0) {
+            size_t value = start + nameLength + 1;
+            while (value < end && in[value] == ' ') value++;
+            return in.substr(value, end - value);
+        }
+        line = end;
+    }
+    return std::string();
+}
+
+WsHandshakeResult wsCheckUpgradeResponse(const std::string& in, const std::string& key, size_t& consumed) {
+    size_t end = in.find("\r\n\r\n");
+    if (end == std::string::npos) {
+        return in.size() > 4096 ? WS_HANDSHAKE_FAILED : WS_HANDSHAKE_INCOMPLETE;
+    }
+    consumed = end + 4;
+    if (in.compare(0, 12, "HTTP/1.1 101") != 0) return WS_HANDSHAKE_FAILED;
+    return httpHeaderValue(in, end + 2, "Sec-WebSocket-Accept") == wsAcceptKey(key) ? WS_HANDSHAKE_DONE
+                                                                                : WS_HANDSHAKE_FAILED;
+}
+
+WsHandshakeResult wsReadUpgradeRequest(const std::string& in, std::string& path, std::string& key, size_t& consumed) {
+    size_t end = in.find("\r\n\r\n");
+    if (end == std::string::npos) {
+        return in.size() > 4096 ? WS_HANDSHAKE_FAILED : WS_HANDSHAKE_INCOMPLETE;
+    }
+    consumed = end + 4;
+    if (in.compare(0, 4, "GET ") != 0) return WS_HANDSHAKE_FAILED;
+    size_t pathEnd = in.find(' ', 4);
+    if (pathEnd == std::string::npos || pathEnd > end) return WS_HANDSHAKE_FAILED;
+    path = in.substr(4, pathEnd - 4);
+    key = httpHeaderValue(in, end + 2, "Sec-WebSocket-Key");
+    return key.empty() ? WS_HANDSHAKE_FAILED : WS_HANDSHAKE_DONE;
+}
+
+// ==================== FRAMES ====================
+void wsAppendFrame(std::string& out, uint8_t opcode, const char* payload, size_t length, bool mask) {
+    out += (char)(0x80 | opcode);
+    uint8_t maskBit = mask ? 0x80 : 0;
+    if (length < 126) {
+        out += (char)(maskBit | length);
+    } else if (length < 65536) {
+        out += (char)(maskBit | 126);
+        out += (char)(length >> 8);
+        out += (char)length;
+    } else {
+        out += (char)(maskBit | 127);
+        for (int i = 7; i >= 0; i--) out += (char)((uint64_t)length >> (i * 8));
+    }
+    if (!mask) {
+        out.append(payload, length);
+        return;
+    }
+    uint8_t key[4];
+    uint32_t word = randomWord();
+    memcpy(key, &word, 4);
+    out.append((const char*)key, 4);
+    size_t start = out.size();
+    out.append(payload, length);
+    for (size_t i = 0; i < length; i++) out[start + i] ^= key[i & 3];
+}
+
+WsDecoder::WsDecoder() {
+    reset();
+}
+
+void WsDecoder::reset() {
+    input.clear();
+    offset = 0;
+    message.clear();
+    messageOpcode = 0;
+    failed = false;
+}
+
+bool WsDecoder::next(uint8_t& opcode, const char*& payload, size_t& payloadLength) {
+    while (!failed) {
+        size_t available = input.size() - offset;
+        if (available < 2) return false;
+        const uint8_t* p = (const uint8_t*)input.data() + offset;
+
+        bool final = p[0] & 0x80;
+        uint8_t frameOpcode = p[0] & 0x0F;
+        bool masked = p[1] & 0x80;
+        uint64_t length = p[1] & 0x7F;
+        size_t header = 2;
+        if (length == 126) {
+            if (available < 4) return false;
+            length = (uint64_t)p[2] << 8 | p[3];
+            header = 4;
+        } else if (length == 127) {
+            if (available < 10) return false;
+            length = 0;
+            for (int i = 0; i < 8; i++) length = length << 8 | p[2 + i];
+            header = 10;
+        }
+        if (length > MAX_MESSAGE || (p[0] & 0x70) != 0) {
+            failed = true;
+            return false;
+        }
+        if (masked) header += 4;
+        if (available < header + length) return false;
+
+        char* data = &input[offset + header];
+        if (masked) {
+            const uint8_t* key = p + header - 4;
+            for (uint64_t i = 0; i < length; i++) data[i] ^= key[i & 3];
+        }
+        offset += header + length;
+
+        // Control frames may arrive between the fragments of a message
+        if (frameOpcode >= WS_OP_CLOSE) {
+            if (!final || length > 125) {
+                failed = true;
+                return false;
+            }
+            opcode = frameOpcode;
+            payload = data;
+            payloadLength = length;
+            return true;
+        }
+
+        if (frameOpcode == WS_OP_CONTINUATION) {
+            if (messageOpcode == 0 || message.size() + length > MAX_MESSAGE) {
+                failed = true;
+                return false;
+            }
+            message.append(data, length);
+            if (!final) continue;
+            opcode = messageOpcode;
+            messageOpcode = 0;
+            // Valid until the next call, which compacts first
+            payload = message.data();
+            payloadLength = message.size();
+            return true;
+        }
+
+        if (frameOpcode != WS_OP_TEXT && frameOpcode != WS_OP_BINARY) {
+            failed = true;
+            return false;
+        }
+        if (messageOpcode != 0) {
+            failed = true;       // A new message before the last one ended
+            return false;
+        }
+        if (final) {
+            opcode = frameOpcode;
+            payload = data;
+            payloadLength = length;
+            return true;
+        }
+        messageOpcode = frameOpcode;
+        message.assign(data, length);
+    }
+    return false;
+}
+
+void WsDecoder::compact() {
+    if (messageOpcode == 0 && !message.empty()) message.clear();
+    if (offset == input.size()) {
+        input.clear();
+        offset = 0;
+    } else if (offset > 4096) {
+        input.erase(0, offset);
+        offset = 0;
+    }
+}
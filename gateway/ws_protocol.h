@@ -0,0 +1,91 @@
+#ifndef GATEWAY_WS_PROTOCOL_H
+#define GATEWAY_WS_PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+// WebSocket (RFC 6455) for the host side of the monitor protocol: the
+// opening handshake in both directions, frame encoding and an incremental
+// decoder that reassembles messages from whatever the socket delivered.
+// No extensions; the monitors do not negotiate any.
+
+enum WsOpcode : uint8_t {
+    WS_OP_CONTINUATION = 0x0,
+    WS_OP_TEXT = 0x1,
+    WS_OP_BINARY = 0x2,
+    WS_OP_CLOSE = 0x8,
+    WS_OP_PING = 0x9,
+    WS_OP_PONG = 0xA
+};
+
+// ==================== HANDSHAKE ====================
+// Value of header `name` in the HTTP head at the start of `in`, looking at
+// the first `length` bytes only; empty if absent
+std::string httpHeaderValue(const std::string& in, size_t length, const char* name);
+
+// Sec-WebSocket-Accept for a Sec-WebSocket-Key: base64(SHA-1(key + GUID))
+std::string wsAcceptKey(const std::string& key);
+// A random 16-byte key, base64
+std::string wsMakeKey();
+
+// Client side: appends the upgrade request for ws://host/path
+void wsAppendUpgradeRequest(std::string& out, const std::string& host, const std::string& path, const std::string& key);
+// Server side: appends the 101 response to a request carrying `key`
+void wsAppendUpgradeResponse(std::string& out, const std::string& key);
+
+enum WsHandshakeResult {
+    WS_HANDSHAKE_INCOMPLETE,    // Headers not all received yet
+    WS_HANDSHAKE_DONE,
+    WS_HANDSHAKE_FAILED
+};
+
+// Client side: checks the response in `in` for a 101 with the right accept
+// key. On DONE, `consumed` is the length of the headers; what follows is
+// already WebSocket data.
+WsHandshakeResult wsCheckUpgradeResponse(const std::string& in, const std::string& key, size_t& consumed);
+// Server side: reads the upgrade request in `in`, giving its path and key
+WsHandshakeResult wsReadUpgradeRequest(const std::string& in, std::string& path, std::string& key, size_t& consumed);
+
+// ==================== FRAMES ====================
+// Appends one final frame. Clients must mask (RFC 6455 5.3), servers must not.
+void wsAppendFrame(std::string& out, uint8_t opcode, const char* payload, size_t length, bool mask);
+
+class WsDecoder {
+public:
+    static const size_t MAX_MESSAGE = 64 * 1024;    // The monitors' frames are under 1 KB
+
+private:
+    std::string input;          // Received, not yet decoded
+    size_t offset;              // Decoded up to here
+    std::string message;        // Fragments of the message being reassembled
+    uint8_t messageOpcode;
+    bool failed;
+
+public:
+    WsDecoder();
+    void reset();
+
+    // Decodes what `data` completes; calls onMessage(opcode, payload,
+    // length) for every whole message and control frame, in order. Returns
+    // false on a protocol error (the connection should be dropped).
+    template <typename OnMessage>
+    bool feed(const char* data, size_t length, OnMessage onMessage) {
+        if (failed) return false;
+        input.append(data, length);
+        uint8_t opcode;
+        const char* payload;
+        size_t payloadLength;
+        while (next(opcode, payload, payloadLength)) {
+            onMessage(opcode, payload, payloadLength);
+        }
+        compact();
+        return !failed;
+    }
+
+private:
+    bool next(uint8_t& opcode, const char*& payload, size_t& payloadLength);
+    void compact();
+};
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef HAL_H
+#define HAL_H
+
+/*
+ * Hardware abstraction layer.
+ *
+ * Everything the firmware needs from the board sits behind one of the
+ * interfaces below. hal_esp32.cpp implements them on the device;
+ * native/hal_sim.cpp simulates them on Linux for [env:native], where the
+ * Arduino, SPIFFS and WiFi APIs used by the sketch are thin shims over the
+ * same interfaces (see native/). The `hal` table is statically initialised
+ * by whichever of the two is linked, so it is usable before setup().
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "wifi_manager.h"
+
+class HalClock {
+public:
+    virtual ~HalClock() {}
+    virtual uint32_t millis() = 0;
+    virtual uint32_t micros() = 0;
+    virtual void delay(uint32_t ms) = 0;
+};
+
+// Pulse oximetry front end, shaped after the MAX3010x driver
+class HalPpgSensor {
+public:
+    virtual ~HalPpgSensor() {}
+    virtual bool begin() = 0;
+    virtual void setup() = 0;
+    virtual void setPulseAmplitudeRed(uint8_t amplitude) = 0;
+    virtual void setPulseAmplitudeGreen(uint8_t amplitude) = 0;
+
+    // Moves new samples out of the sensor FIFO; returns how many arrived
+    virtual uint16_t check() = 0;
+    virtual uint8_t available() = 0;
+    virtual uint32_t getRed() = 0;
+    virtual uint32_t getIR() = 0;
+    virtual void nextSample() = 0;
+};
+
+// 12-bit analog inputs
+class HalAdc {
+public:
+    virtual ~HalAdc() {}
+    virtual uint16_t read(uint8_t pin) = 0;
+};
+
+// RGB565 panel as seen on the wire: an address window, then pixel data
+class HalDisplayBus {
+public:
+    virtual ~HalDisplayBus() {}
+    virtual void setWindow(int16_t x, int16_t y, int16_t w, int16_t h) = 0;
+    virtual void pushColor(uint16_t color, uint32_t count) = 0;
+    // Everything sent to the panel so far, including the sketch's drawing
+    virtual uint32_t getBytesSent() = 0;
+};
+
+struct HalTouchPoint {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+};
+
+// Resistive touch controller; coordinates are raw 12-bit readings
+class HalTouch {
+public:
+    virtual ~HalTouch() {}
+    virtual bool begin() = 0;
+    virtual void setRotation(uint8_t rotation) = 0;
+    virtual bool touched() = 0;
+    virtual HalTouchPoint getPoint() = 0;
+};
+
+// Flash file system with integer handles; HAL_INVALID_FILE on failure
+static const int HAL_INVALID_FILE = -1;
+
+class HalStorage {
+public:
+    virtual ~HalStorage() {}
+    virtual bool begin(bool formatOnFail) = 0;
+    virtual int open(const char* path, const char* mode) = 0;
+    virtual size_t read(int file, uint8_t* buffer, size_t length) = 0;
+    virtual size_t write(int file, const uint8_t* data, size_t length) = 0;
+    virtual bool seek(int file, size_t position) = 0;
+    virtual size_t position(int file) = 0;
+    virtual size_t size(int file) = 0;
+    virtual void close(int file) = 0;
+    virtual bool exists(const char* path) = 0;
+    virtual bool remove(const char* path) = 0;
+    virtual bool rename(const char* from, const char* to) = 0;
+    virtual bool mkdir(const char* path) = 0;
+};
+
+// WiFi station; connection outcomes are reported to the attached manager
+class HalNetwork : public WifiDriver {
+public:
+    virtual void attach(WifiManager* manager) = 0;
+    virtual bool isConnected() = 0;
+    virtual int8_t getRssi() = 0;
+};
+
+// Alarm sounder. The board uses an active buzzer, which ignores frequency.
+class HalTone {
+public:
+    virtual ~HalTone() {}
+    virtual void begin(uint8_t pin) = 0;
+    virtual void tone(uint16_t frequency) = 0;
+    virtual void noTone() = 0;
+};
+
+struct Hal {
+    HalClock* clock;
+    HalPpgSensor* sensor;
+    HalAdc* adc;
+    HalDisplayBus* display;
+    HalTouch* touch;
+    HalStorage* storage;
+    HalNetwork* network;
+    HalTone* tone;
+};
+
+extern Hal hal;
+
+#endif
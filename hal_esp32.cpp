@@ -0,0 +1,236 @@
+// ESP32 implementation of the HAL; see hal.h
+#if defined(ARDUINO) && defined(ESP32)
+
+#include "hal.h"
+#include "board_pins.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <SPIFFS.h>
+#include <Wire.h>
+#include "display_panel.h"
+#include <XPT2046_Touchscreen.h>
+#include "MAX30105.h"
+
+// ==================== CLOCK ====================
+#if defined(HAL_CLOCK_WRAPPED)
+// The build links with -Wl,--wrap=millis,--wrap=micros, so that the
+// sketch's own millis() and micros() calls go through hal.clock as they do
+// on the native build, and the input journal sees them. The board's clock
+// is the real one underneath.
+extern "C" {
+unsigned long __real_millis();
+unsigned long __real_micros();
+
+unsigned long __wrap_millis() {
+    return hal.clock->millis();
+}
+
+unsigned long __wrap_micros() {
+    return hal.clock->micros();
+}
+}
+#define BOARD_MILLIS __real_millis
+#define BOARD_MICROS __real_micros
+#else
+#define BOARD_MILLIS ::millis
+#define BOARD_MICROS ::micros
+#endif
+
+class Esp32Clock : public HalClock {
+public:
+    uint32_t millis() override { return BOARD_MILLIS(); }
+    uint32_t micros() override { return BOARD_MICROS(); }
+    void delay(uint32_t ms) override { ::delay(ms); }
+};
+
+// ==================== SENSOR ====================
+class Esp32PpgSensor : public HalPpgSensor {
+private:
+    MAX30105 sensor;
+
+public:
+    bool begin() override { return sensor.begin(Wire, I2C_SPEED_FAST); }
+    // 100 Hz averaged by 4: the 25 samples/s the SpO2 code's FreqS expects.
+    // Default LED current, red + IR, 411 us pulses, 4096 nA range.
+    void setup() override { sensor.setup(0x1F, 4, 2, 100, 411, 4096); }
+    void setPulseAmplitudeRed(uint8_t amplitude) override { sensor.setPulseAmplitudeRed(amplitude); }
+    void setPulseAmplitudeGreen(uint8_t amplitude) override { sensor.setPulseAmplitudeGreen(amplitude); }
+    uint16_t check() override { return sensor.check(); }
+    uint8_t available() override { return sensor.available(); }
+    uint32_t getRed() override { return sensor.getRed(); }
+    uint32_t getIR() override { return sensor.getIR(); }
+    void nextSample() override { sensor.nextSample(); }
+};
+
+// ==================== ADC ====================
+class Esp32Adc : public HalAdc {
+public:
+    uint16_t read(uint8_t pin) override { return analogRead(pin); }
+};
+
+// ==================== DISPLAY BUS ====================
+// The sketch owns the panel and draws on it through Adafruit_GFX; the bus
+// gives HAL users raw window/pixel access to the same panel
+extern DisplayPanel tft;
+
+class Esp32DisplayBus : public HalDisplayBus {
+public:
+    void setWindow(int16_t x, int16_t y, int16_t w, int16_t h) override {
+        setDisplayPanelWindow(tft, x, y, w, h);
+    }
+
+    void pushColor(uint16_t color, uint32_t count) override {
+        fillDisplayPanel(tft, color, count);
+    }
+
+    // Counted by the panel, so the sketch's own drawing is included
+    uint32_t getBytesSent() override { return displayPanelBytesSent(tft); }
+};
+
+// ==================== TOUCH ====================
+class Esp32Touch : public HalTouch {
+private:
+    XPT2046_Touchscreen touch;
+
+public:
+    Esp32Touch() : touch(TOUCH_CS, TOUCH_IRQ) {}
+    bool begin() override { return touch.begin(); }
+    void setRotation(uint8_t rotation) override { touch.setRotation(rotation); }
+    bool touched() override { return touch.touched(); }
+
+    HalTouchPoint getPoint() override {
+        TS_Point p = touch.getPoint();
+        HalTouchPoint point = {p.x, p.y, p.z};
+        return point;
+    }
+};
+
+// ==================== STORAGE ====================
+class Esp32Storage : public HalStorage {
+private:
+    static const int MAX_OPEN_FILES = 4;
+    File files[MAX_OPEN_FILES];
+
+    File* get(int file) {
+        return file >= 0 && file < MAX_OPEN_FILES && files[file] ? &files[file] : nullptr;
+    }
+
+public:
+    bool begin(bool formatOnFail) override { return SPIFFS.begin(formatOnFail); }
+
+    int open(const char* path, const char* mode) override {
+        for (int i = 0; i < MAX_OPEN_FILES; i++) {
+            if (!files[i]) {
+                files[i] = SPIFFS.open(path, mode);
+                return files[i] ? i : HAL_INVALID_FILE;
+            }
+        }
+        return HAL_INVALID_FILE;
+    }
+
+    size_t read(int file, uint8_t* buffer, size_t length) override {
+        File* f = get(file);
+        return f ? f->read(buffer, length) : 0;
+    }
+
+    size_t write(int file, const uint8_t* data, size_t length) override {
+        File* f = get(file);
+        return f ? f->write(data, length) : 0;
+    }
+
+    bool seek(int file, size_t position) override {
+        File* f = get(file);
+        return f && f->seek(position);
+    }
+
+    size_t position(int file) override {
+        File* f = get(file);
+        return f ? f->position() : 0;
+    }
+
+    size_t size(int file) override {
+        File* f = get(file);
+        return f ? f->size() : 0;
+    }
+
+    void close(int file) override {
+        File* f = get(file);
+        if (f) f->close();
+    }
+
+    bool exists(const char* path) override { return SPIFFS.exists(path); }
+    bool remove(const char* path) override { return SPIFFS.remove(path); }
+    bool rename(const char* from, const char* to) override { return SPIFFS.rename(from, to); }
+    bool mkdir(const char* path) override { return SPIFFS.mkdir(path); }
+};
+
+// ==================== NETWORK ====================
+class Esp32Network : public HalNetwork {
+public:
+    void attach(WifiManager* manager) override {
+        // The manager owns reconnection, so the core must not retry behind its back
+        WiFi.setAutoReconnect(false);
+        WiFi.onEvent([manager](WiFiEvent_t event, WiFiEventInfo_t info) {
+            (void)event;
+            (void)info;
+            manager->notifyConnected();
+        }, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+        WiFi.onEvent([manager](WiFiEvent_t event, WiFiEventInfo_t info) {
+            (void)event;
+            (void)info;
+            manager->notifyDisconnected();
+        }, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    }
+
+    void connect(const char* ssid, const char* password) override {
+        WiFi.mode(WIFI_STA);
+        WiFi.begin(ssid, password);
+    }
+
+    void disconnect() override { WiFi.disconnect(); }
+    bool isConnected() override { return WiFi.status() == WL_CONNECTED; }
+    int8_t getRssi() override { return WiFi.RSSI(); }
+};
+
+// ==================== TONE ====================
+class Esp32Tone : public HalTone {
+private:
+    uint8_t pin = 0;
+
+public:
+    void begin(uint8_t buzzerPin) override {
+        pin = buzzerPin;
+        pinMode(pin, OUTPUT);
+        digitalWrite(pin, LOW);
+    }
+
+    void tone(uint16_t frequency) override {
+        (void)frequency;
+        digitalWrite(pin, HIGH);
+    }
+
+    void noTone() override { digitalWrite(pin, LOW); }
+};
+
+// ==================== TABLE ====================
+static Esp32Clock esp32Clock;
+static Esp32PpgSensor esp32Sensor;
+static Esp32Adc esp32Adc;
+static Esp32DisplayBus esp32Display;
+static Esp32Touch esp32Touch;
+static Esp32Storage esp32Storage;
+static Esp32Network esp32Network;
+static Esp32Tone esp32Tone;
+
+Hal hal = {
+    &esp32Clock,
+    &esp32Sensor,
+    &esp32Adc,
+    &esp32Display,
+    &esp32Touch,
+    &esp32Storage,
+    &esp32Network,
+    &esp32Tone
+};
+
+#endif
@@ -1,4 +1,4 @@
-#include "heartRate.h"
+#include "heartrate.h"
 
 HeartRateCalculator heartRateCalc;
 
@@ -0,0 +1,239 @@
+#include "http_stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <limits.h>
+
+// ==================== CHUNK GENERATOR ====================
+ChunkGenerator::ChunkGenerator() {
+    pieceLength = 0;
+    pieceOffset = 0;
+    finished = false;
+}
+
+size_t ChunkGenerator::fill(uint8_t* buffer, size_t maxLen) {
+    size_t written = 0;
+
+    while (written < maxLen && !finished) {
+        if (pieceOffset >= pieceLength) {
+            pieceLength = renderNext(piece, PIECE_SIZE);
+            pieceOffset = 0;
+            if (pieceLength == 0) {
+                finished = true;
+                break;
+            }
+            // A piece that did not fit was truncated by its renderer
+            if (pieceLength >= PIECE_SIZE) {
+                pieceLength = PIECE_SIZE - 1;
+            }
+        }
+
+        size_t available = pieceLength - pieceOffset;
+        size_t toCopy = available < (maxLen - written) ? available : (maxLen - written);
+        memcpy(buffer + written, piece + pieceOffset, toCopy);
+        pieceOffset += toCopy;
+        written += toCopy;
+    }
+
+    return written;
+}
+
+// ==================== CSV EXPORT ====================
+VitalsCsvGenerator::VitalsCsvGenerator(const VitalSigns* data, size_t dataCount) {
+    records = data;
+    count = dataCount;
+    next = 0;
+    headerSent = false;
+}
+
+size_t VitalsCsvGenerator::renderNext(char* out, size_t size) {
+    if (!headerSent) {
+        headerSent = true;
+        return snprintf(out, size, "Timestamp,HeartRate,SpO2,BatteryLevel\n");
+    }
+
+    if (next >= count) {
+        return 0;
+    }
+
+    const VitalSigns& data = records[next++];
+    return snprintf(out, size, "%lu,%.2f,%.2f,%.2f\n",
+                    data.timestamp, data.heartRate, data.spO2, data.batteryLevel);
+}
+
+// ==================== JSON HISTORY ====================
+VitalsJsonGenerator::VitalsJsonGenerator(const VitalSigns& currentVitals, const VitalSigns* data, size_t dataCount) {
+    current = currentVitals;
+    records = data;
+    count = dataCount;
+    next = 0;
+    headerSent = false;
+    footerSent = false;
+}
+
+size_t VitalsJsonGenerator::renderNext(char* out, size_t size) {
+    JsonBufferSink sink(out, size);
+    JsonWriter<JsonBufferSink> writer(sink);
+
+    if (!headerSent) {
+        headerSent = true;
+        sink.write("{\"current\":", 11);
+        writer.object<VitalsCurrentSchema>(current);
+        sink.write(",\"history\":[", 12);
+        return sink.getLength();
+    }
+
+    if (next < count) {
+        if (next > 0) sink.put(',');
+        writer.object<VitalsHistorySchema>(records[next++]);
+        return sink.getLength();
+    }
+
+    if (!footerSent) {
+        footerSent = true;
+        sink.write("]}", 2);
+        return sink.getLength();
+    }
+
+    return 0;
+}
+
+// ==================== RANGE REQUESTS ====================
+RangeResult parseRangeHeader(const char* header, size_t totalSize, ByteRange& range) {
+    // Anything but one well-formed byte range is ignored, and the whole
+    // resource is sent (RFC 7233, 3.1); only a valid range that lies past
+    // the end is refused
+    if (!header || strncmp(header, "bytes=", 6) != 0) {
+        return RANGE_IGNORED;
+    }
+
+    const char* spec = header + 6;
+    if (strchr(spec, ',')) {
+        return RANGE_IGNORED;
+    }
+
+    const char* dash = strchr(spec, '-');
+    if (!dash) {
+        return RANGE_IGNORED;
+    }
+
+    char* end;
+    if (dash == spec) {
+        // Suffix range: last N bytes
+        if (!isdigit((unsigned char)*(dash + 1))) return RANGE_IGNORED;
+        unsigned long suffix = strtoul(dash + 1, &end, 10);
+        if (*end != '\0') return RANGE_IGNORED;
+        if (suffix == 0 || totalSize == 0) return RANGE_UNSATISFIABLE;
+        if (suffix > totalSize) suffix = totalSize;
+        range.start = totalSize - suffix;
+        range.end = totalSize - 1;
+        return RANGE_SATISFIABLE;
+    }
+
+    if (!isdigit((unsigned char)*spec)) {
+        return RANGE_IGNORED;
+    }
+    unsigned long start = strtoul(spec, &end, 10);
+    if (end != dash) {
+        return RANGE_IGNORED;
+    }
+
+    unsigned long last = ULONG_MAX;
+    if (*(dash + 1) != '\0') {
+        if (!isdigit((unsigned char)*(dash + 1))) return RANGE_IGNORED;
+        last = strtoul(dash + 1, &end, 10);
+        if (*end != '\0' || last < start) return RANGE_IGNORED;
+    }
+
+    if (start >= totalSize) {
+        return RANGE_UNSATISFIABLE;
+    }
+    range.start = start;
+    range.end = last < totalSize ? last : totalSize - 1;
+    return RANGE_SATISFIABLE;
+}
+
+// ==================== CONDITIONAL REQUESTS ====================
+// Skips a W/ prefix; the rest of the tag, quotes included, is compared
+static const char* opaqueTag(const char* tag, const char* end) {
+    if (end - tag >= 2 && tag[0] == 'W' && tag[1] == '/') tag += 2;
+    return tag;
+}
+
+bool etagMatches(const char* ifNoneMatch, const char* etag) {
+    if (!ifNoneMatch || !etag) return false;
+    const char* want = opaqueTag(etag, etag + strlen(etag));
+    size_t wantLength = strlen(want);
+
+    const char* p = ifNoneMatch;
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == ',') p++;
+        if (!*p) break;
+        const char* entry = p;
+        // An entity tag is quoted, and a comma inside the quotes is its own
+        if (*p == 'W' && *(p + 1) == '/') p += 2;
+        if (*p == '"') {
+            const char* close = strchr(p + 1, '"');
+            p = close ? close + 1 : p + strlen(p);
+        } else {
+            while (*p && *p != ',' && *p != ' ' && *p != '\t') p++;
+        }
+
+        if (p - entry == 1 && *entry == '*') return true;
+        const char* tag = opaqueTag(entry, p);
+        if ((size_t)(p - tag) == wantLength && strncmp(tag, want, wantLength) == 0) return true;
+    }
+    return false;
+}
+
+bool acceptsGzip(const char* acceptEncoding) {
+    if (!acceptEncoding) return false;
+    bool gzip = false;
+    bool listed = false;
+    bool wildcard = false;
+
+    const char* p = acceptEncoding;
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == ',') p++;
+        if (!*p) break;
+        const char* name = p;
+        while (*p && *p != ',' && *p != ';' && *p != ' ' && *p != '\t') p++;
+        size_t nameLength = p - name;
+
+        // q=0 means "not acceptable"; any other weight means acceptable
+        bool allowed = true;
+        while (*p && *p != ',') {
+            if ((*p == 'q' || *p == 'Q') && *(p + 1) == '=') {
+                allowed = strtod(p + 2, nullptr) > 0;
+            }
+            p++;
+        }
+
+        if (nameLength == 4 && strncasecmp(name, "gzip", 4) == 0) {
+            listed = true;
+            gzip = allowed;
+        } else if (nameLength == 1 && *name == '*') {
+            wildcard = allowed;
+        }
+    }
+    return listed ? gzip : wildcard;
+}
+
+// ==================== STATIC ASSETS ====================
+bool parseAssetLine(const char* line, StaticAsset& asset) {
+    int immutable = 0;
+    if (sscanf(line, "%39s %23s %d", asset.url, asset.etag, &immutable) != 3) return false;
+    asset.immutable = immutable != 0;
+    return true;
+}
+
+const char* assetContentType(const char* url) {
+    const char* dot = strrchr(url, '.');
+    if (!dot) return "application/octet-stream";
+    if (strcmp(dot, ".html") == 0) return "text/html";
+    if (strcmp(dot, ".js") == 0) return "application/javascript";
+    if (strcmp(dot, ".css") == 0) return "text/css";
+    return "application/octet-stream";
+}
@@ -0,0 +1,106 @@
+#ifndef HTTP_STREAM_H
+#define HTTP_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "vital_signs.h"
+
+// Produces an HTTP body on demand, one chunk at a time. Subclasses render
+// one small piece (a header, a record, a footer) per call; the base class
+// splits pieces across chunks, so memory per request is one piece buffer
+// no matter how long the body is.
+class ChunkGenerator {
+public:
+    static const size_t PIECE_SIZE = 192;
+
+private:
+    char piece[PIECE_SIZE];
+    size_t pieceLength;
+    size_t pieceOffset;
+    bool finished;
+
+public:
+    ChunkGenerator();
+    virtual ~ChunkGenerator() {}
+
+    // Fills up to maxLen bytes; returns 0 once the body is complete
+    size_t fill(uint8_t* buffer, size_t maxLen);
+
+protected:
+    // Renders the next piece into out; returns 0 when there is nothing left
+    virtual size_t renderNext(char* out, size_t size) = 0;
+};
+
+// CSV export of vitals records: Timestamp,HeartRate,SpO2,BatteryLevel
+class VitalsCsvGenerator : public ChunkGenerator {
+private:
+    const VitalSigns* records;
+    size_t count;
+    size_t next;
+    bool headerSent;
+
+public:
+    VitalsCsvGenerator(const VitalSigns* data, size_t dataCount);
+
+protected:
+    size_t renderNext(char* out, size_t size) override;
+};
+
+// {"current": {...}, "history": [{...}, ...]} as served by /data
+class VitalsJsonGenerator : public ChunkGenerator {
+private:
+    VitalSigns current;
+    const VitalSigns* records;
+    size_t count;
+    size_t next;
+    bool headerSent;
+    bool footerSent;
+
+public:
+    VitalsJsonGenerator(const VitalSigns& currentVitals, const VitalSigns* data, size_t dataCount);
+
+protected:
+    size_t renderNext(char* out, size_t size) override;
+};
+
+// Single byte range from an HTTP Range header, end inclusive
+struct ByteRange {
+    size_t start;
+    size_t end;
+};
+
+enum RangeResult {
+    RANGE_IGNORED,          // Malformed, multi-range or not bytes: send 200 and everything
+    RANGE_SATISFIABLE,      // Send 206 with `range`
+    RANGE_UNSATISFIABLE     // Well-formed but past the end: send 416
+};
+
+// Parses "bytes=start-end", "bytes=start-" and "bytes=-suffix" against a
+// resource of totalSize bytes. Multi-range requests are not supported and
+// are ignored like malformed ones.
+RangeResult parseRangeHeader(const char* header, size_t totalSize, ByteRange& range);
+
+// ==================== CONDITIONAL REQUESTS ====================
+// If-None-Match against a quoted etag: "*", or any entry of a comma-separated
+// list, compared weakly as RFC 7232 3.2 asks (a W/ prefix is ignored)
+bool etagMatches(const char* ifNoneMatch, const char* etag);
+
+// Accept-Encoding allows gzip: listed, or covered by "*", without q=0
+bool acceptsGzip(const char* acceptEncoding);
+
+// ==================== STATIC ASSETS ====================
+// Precompressed dashboard file listed in /www/etags.txt by tools/gzip_www.py
+struct StaticAsset {
+    char url[40];
+    char etag[24];
+    bool immutable;   // Content-hashed name, safe to cache for a year
+};
+
+// One line of /www/etags.txt: <url> "<etag>" <immutable>
+bool parseAssetLine(const char* line, StaticAsset& asset);
+
+// Content type by extension; the .gz on disk would otherwise make it
+// application/x-gzip
+const char* assetContentType(const char* url);
+
+#endif
@@ -0,0 +1,657 @@
+#include "journal.h"
+#include <stdio.h>
+#include <string.h>
+#include <new>
+#include "memory_accounting.h"
+#include "trace_log.h"
+#include "wifi_manager.h"
+
+Journal journal;
+
+// The RAM buffer, while recording
+MemoryAccount memoryJournal("journal", Journal::BUFFER_SIZE);
+
+static const uint8_t MAGIC[4] = {'J', 'R', 'N', '1'};
+
+static const char* const KIND_NAMES[] = {
+    "LOOP", "MILLIS", "MICROS", "SAMPLES", "RED", "IR", "ADC", "TOUCH",
+    "POINT", "STORAGE", "WIFI", "CONSOLE", "REQUEST", "VALUE", "TEXT", "?"
+};
+
+static uint32_t zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+// A sample or coordinate, journaled as the zigzag difference to the last one
+template <typename Read>
+static uint32_t journalDelta(Journal::Kind kind, uint32_t& last, Read read) {
+    if (!journal.journaling()) return read();
+    uint32_t value;
+    if (journal.isReplaying()) {
+        value = last + unzigzag(journal.take(kind));
+    } else {
+        journal.pause();
+        value = read();
+        journal.resume();
+        journal.put(kind, zigzag((int32_t)(value - last)));
+    }
+    last = value;
+    return value;
+}
+
+// ==================== CLOCK ====================
+// Readings are journaled as the time since the previous one. Other tasks
+// see the latest time the loop task was given, in replay as well.
+class JournalClock : public HalClock {
+private:
+    HalClock* board = nullptr;
+    uint32_t lastMillis = 0;
+    uint32_t lastMicros = 0;
+    std::atomic<uint32_t> replayMillis{0};
+    std::atomic<uint32_t> replayMicros{0};
+
+    uint32_t read(Journal::Kind kind, uint32_t& last, std::atomic<uint32_t>& latest) {
+        uint32_t now;
+        if (journal.isReplaying()) {
+            now = last + journal.take(kind);
+        } else {
+            now = kind == Journal::KIND_MILLIS ? board->millis() : board->micros();
+            journal.put(kind, now - last);
+        }
+        last = now;
+        latest.store(now, std::memory_order_relaxed);
+        return now;
+    }
+
+public:
+    void wrap(HalClock* target) { board = target; }
+
+    uint32_t millis() override {
+        if (journal.journaling()) return read(Journal::KIND_MILLIS, lastMillis, replayMillis);
+        return journal.isReplaying() ? replayMillis.load(std::memory_order_relaxed) : board->millis();
+    }
+
+    uint32_t micros() override {
+        if (journal.journaling()) return read(Journal::KIND_MICROS, lastMicros, replayMicros);
+        return journal.isReplaying() ? replayMicros.load(std::memory_order_relaxed) : board->micros();
+    }
+
+    // Replayed time moves by the readings alone
+    void delay(uint32_t ms) override {
+        if (!journal.isReplaying()) board->delay(ms);
+    }
+};
+
+// ==================== SENSOR ====================
+class JournalSensor : public HalPpgSensor {
+private:
+    HalPpgSensor* board = nullptr;
+    uint32_t lastRed = 0;
+    uint32_t lastIr = 0;
+
+public:
+    void wrap(HalPpgSensor* target) { board = target; }
+
+    bool begin() override {
+        return journal.input(Journal::KIND_VALUE, [this] { return (uint32_t)board->begin(); }) != 0;
+    }
+
+    void setup() override {
+        if (!journal.replayed()) board->setup();
+    }
+
+    void setPulseAmplitudeRed(uint8_t amplitude) override {
+        if (!journal.replayed()) board->setPulseAmplitudeRed(amplitude);
+    }
+
+    void setPulseAmplitudeGreen(uint8_t amplitude) override {
+        if (!journal.replayed()) board->setPulseAmplitudeGreen(amplitude);
+    }
+
+    uint16_t check() override {
+        return journal.input(Journal::KIND_SAMPLES, [this] { return (uint32_t)board->check(); });
+    }
+
+    uint8_t available() override {
+        return journal.input(Journal::KIND_SAMPLES, [this] { return (uint32_t)board->available(); });
+    }
+
+    uint32_t getRed() override {
+        return journalDelta(Journal::KIND_RED, lastRed, [this] { return board->getRed(); });
+    }
+
+    uint32_t getIR() override {
+        return journalDelta(Journal::KIND_IR, lastIr, [this] { return board->getIR(); });
+    }
+
+    void nextSample() override {
+        if (!journal.replayed()) board->nextSample();
+    }
+};
+
+// ==================== ADC ====================
+class JournalAdc : public HalAdc {
+private:
+    HalAdc* board = nullptr;
+
+public:
+    void wrap(HalAdc* target) { board = target; }
+
+    uint16_t read(uint8_t pin) override {
+        return journal.input(Journal::KIND_ADC, [this, pin] { return (uint32_t)board->read(pin); });
+    }
+};
+
+// ==================== TOUCH ====================
+class JournalTouch : public HalTouch {
+private:
+    HalTouch* board = nullptr;
+    uint32_t lastX = 0;
+    uint32_t lastY = 0;
+    uint32_t lastZ = 0;
+
+public:
+    void wrap(HalTouch* target) { board = target; }
+
+    bool begin() override {
+        return journal.input(Journal::KIND_VALUE, [this] { return (uint32_t)board->begin(); }) != 0;
+    }
+
+    void setRotation(uint8_t rotation) override {
+        if (!journal.replayed()) board->setRotation(rotation);
+    }
+
+    bool touched() override {
+        return journal.input(Journal::KIND_TOUCH, [this] { return (uint32_t)board->touched(); }) != 0;
+    }
+
+    HalTouchPoint getPoint() override {
+        if (!journal.journaling()) return board->getPoint();
+        HalTouchPoint point = {0, 0, 0};
+        if (!journal.isReplaying()) {
+            journal.pause();
+            point = board->getPoint();
+            journal.resume();
+        }
+        point.x = (int16_t)journalDelta(Journal::KIND_POINT, lastX, [&point] { return (uint32_t)point.x; });
+        point.y = (int16_t)journalDelta(Journal::KIND_POINT, lastY, [&point] { return (uint32_t)point.y; });
+        point.z = (int16_t)journalDelta(Journal::KIND_POINT, lastZ, [&point] { return (uint32_t)point.z; });
+        return point;
+    }
+};
+
+// ==================== STORAGE ====================
+// Results and the bytes read are journaled, not what is written; in replay
+// the files are not touched at all
+class JournalStorage : public HalStorage {
+private:
+    HalStorage* board = nullptr;
+
+public:
+    void wrap(HalStorage* target) { board = target; }
+
+    bool begin(bool formatOnFail) override {
+        return journal.input(Journal::KIND_STORAGE, [&] { return (uint32_t)board->begin(formatOnFail); }) != 0;
+    }
+
+    int open(const char* path, const char* mode) override {
+        return unzigzag(journal.input(Journal::KIND_STORAGE, [&] { return zigzag(board->open(path, mode)); }));
+    }
+
+    size_t read(int file, uint8_t* buffer, size_t length) override {
+        if (!journal.journaling()) return board->read(file, buffer, length);
+        size_t count;
+        if (journal.isReplaying()) {
+            count = journal.take(Journal::KIND_STORAGE);
+            size_t kept = count < length ? count : length;
+            journal.takeBytes(buffer, kept);
+            journal.takeBytes(nullptr, count - kept);
+            return kept;
+        }
+        journal.pause();
+        count = board->read(file, buffer, length);
+        journal.resume();
+        journal.put(Journal::KIND_STORAGE, count);
+        journal.putBytes(buffer, count);
+        return count;
+    }
+
+    size_t write(int file, const uint8_t* data, size_t length) override {
+        return journal.input(Journal::KIND_STORAGE, [&] { return (uint32_t)board->write(file, data, length); });
+    }
+
+    bool seek(int file, size_t position) override {
+        return journal.input(Journal::KIND_STORAGE, [&] { return (uint32_t)board->seek(file, position); }) != 0;
+    }
+
+    size_t position(int file) override {
+        return journal.input(Journal::KIND_STORAGE, [&] { return (uint32_t)board->position(file); });
+    }
+
+    size_t size(int file) override {
+        return journal.input(Journal::KIND_STORAGE, [&] { return (uint32_t)board->size(file); });
+    }
+
+    void close(int file) override {
+        if (!journal.replayed()) board->close(file);
+    }
+
+    bool exists(const char* path) override {
+        return journal.input(Journal::KIND_STORAGE, [&] { return (uint32_t)board->exists(path); }) != 0;
+    }
+
+    bool remove(const char* path) override {
+        return journal.input(Journal::KIND_STORAGE, [&] { return (uint32_t)board->remove(path); }) != 0;
+    }
+
+    bool rename(const char* from, const char* to) override {
+        return journal.input(Journal::KIND_STORAGE, [&] { return (uint32_t)board->rename(from, to); }) != 0;
+    }
+
+    bool mkdir(const char* path) override {
+        return journal.input(Journal::KIND_STORAGE, [&] { return (uint32_t)board->mkdir(path); }) != 0;
+    }
+};
+
+// ==================== NETWORK ====================
+// The WifiManager's events are journaled as it consumes them. In replay
+// the radio is left alone and the link is up between the replayed
+// connected and disconnected events, for the loop task only.
+class JournalNetwork : public HalNetwork {
+private:
+    HalNetwork* board = nullptr;
+    bool replayConnected = false;
+
+    static uint8_t filterEvent(uint8_t event);
+
+public:
+    void wrap(HalNetwork* target) { board = target; }
+
+    void attach(WifiManager* manager) override {
+        manager->setEventFilter(filterEvent);
+        if (!journal.isReplaying()) board->attach(manager);
+    }
+
+    void connect(const char* ssid, const char* password) override {
+        if (journal.isReplaying()) return;
+        JournalPause pause;
+        board->connect(ssid, password);
+    }
+
+    void disconnect() override {
+        if (journal.isReplaying()) return;
+        JournalPause pause;
+        board->disconnect();
+    }
+
+    bool isConnected() override {
+        if (journal.isReplaying()) return replayConnected && journal.onLoopTask();
+        JournalPause pause;
+        return board->isConnected();
+    }
+
+    int8_t getRssi() override {
+        if (journal.isReplaying()) return 0;
+        JournalPause pause;
+        return board->getRssi();
+    }
+};
+
+static JournalClock journalClock;
+static JournalSensor journalSensor;
+static JournalAdc journalAdc;
+static JournalTouch journalTouch;
+static JournalStorage journalStorage;
+static JournalNetwork journalNetwork;
+
+uint8_t JournalNetwork::filterEvent(uint8_t event) {
+    if (!journal.journaling()) return event;
+    if (journal.isReplaying()) {
+        if (!journal.peek(Journal::KIND_WIFI)) return WifiManager::EVENT_NONE;
+        event = journal.take(Journal::KIND_WIFI);
+        if (event == WifiManager::EVENT_CONNECTED) journalNetwork.replayConnected = true;
+        if (event == WifiManager::EVENT_DISCONNECTED) journalNetwork.replayConnected = false;
+    } else if (event != WifiManager::EVENT_NONE) {
+        journal.put(Journal::KIND_WIFI, event);
+    }
+    return event;
+}
+
+// ==================== JOURNAL ====================
+Journal::Journal()
+    : mode(OFF), stopped(false), loopTask(nullptr), paused(0), resumedPause(0), loops(0),
+      buffer(nullptr), length(0), spilled(0), data(nullptr), size(0), position(0), diverged(false),
+      endHandler(nullptr) {
+    divergence[0] = '\0';
+}
+
+void Journal::install() {
+    journalClock.wrap(hal.clock);
+    journalSensor.wrap(hal.sensor);
+    journalAdc.wrap(hal.adc);
+    journalTouch.wrap(hal.touch);
+    journalStorage.wrap(hal.storage);
+    journalNetwork.wrap(hal.network);
+    hal.clock = &journalClock;
+    hal.sensor = &journalSensor;
+    hal.adc = &journalAdc;
+    hal.touch = &journalTouch;
+    hal.storage = &journalStorage;
+    hal.network = &journalNetwork;
+}
+
+void Journal::begin() {
+    if (mode != OFF || !isEnabled()) return;
+
+    buffer = new (std::nothrow) uint8_t[BUFFER_SIZE];
+    if (!buffer) {
+        memoryJournal.failed();
+        TRACE("Journal: no memory for the buffer, not recording\n");
+        return;
+    }
+    memoryJournal.charge(BUFFER_SIZE);
+
+    // Every boot starts a new journal
+    hal.storage->begin(true);
+    hal.storage->remove(JOURNAL_PATH);
+    memcpy(buffer, MAGIC, sizeof(MAGIC));
+    length = sizeof(MAGIC);
+
+    // Before the decorators go in: replay has no such line to read the time for
+    TRACE("Journal: recording to %s\n", JOURNAL_PATH);
+    loopTask = xTaskGetCurrentTaskHandle();
+    mode = RECORDING;
+    install();
+}
+
+bool Journal::replay(const uint8_t* journalData, size_t journalSize, void (*onEnd)()) {
+    if (mode != OFF || journalSize < sizeof(MAGIC) || memcmp(journalData, MAGIC, sizeof(MAGIC)) != 0) {
+        return false;
+    }
+    data = journalData;
+    size = journalSize;
+    position = sizeof(MAGIC);
+    endHandler = onEnd;
+    loopTask = xTaskGetCurrentTaskHandle();
+    mode = REPLAYING;
+    install();
+    return true;
+}
+
+void Journal::setEnabled(bool enabled) {
+    if (mode == REPLAYING) return;
+    JournalPause pause;
+    Preferences settings;
+    settings.begin("journal", false);
+    settings.putBool("enabled", enabled);
+    settings.end();
+}
+
+bool Journal::isEnabled() {
+    JournalPause pause;
+    Preferences settings;
+    settings.begin("journal", true);
+    bool enabled = settings.getBool("enabled", false);
+    settings.end();
+    return enabled;
+}
+
+bool Journal::save() {
+    return isRecording() && spill();
+}
+
+bool Journal::spill() {
+    if (length == 0) return true;
+    if (spilled + length > FILE_LIMIT) {
+        stop("file limit reached");
+        return false;
+    }
+
+    JournalPause pause;
+    int file = hal.storage->open(JOURNAL_PATH, "a");
+    bool written = file != HAL_INVALID_FILE && hal.storage->write(file, buffer, length) == length;
+    if (file != HAL_INVALID_FILE) hal.storage->close(file);
+    if (!written) {
+        stop("write failed");
+        return false;
+    }
+    spilled += length;
+    length = 0;
+    return true;
+}
+
+void Journal::stop(const char* reason) {
+    stopped = true;
+    delete[] buffer;
+    buffer = nullptr;
+    length = 0;
+    memoryJournal.credit(BUFFER_SIZE);
+    TRACE("Journal: stopped after %u bytes and %u loops, %s\n", (unsigned)spilled, (unsigned)loops, reason);
+}
+
+void Journal::loopStarted() {
+    if (!journaling()) return;
+    loops++;
+    if (mode == REPLAYING) {
+        take(KIND_LOOP);
+        return;
+    }
+    if (length >= SPILL_SIZE && !spill()) return;
+    put(KIND_LOOP, 0);
+}
+
+// ==================== RECORDS ====================
+void Journal::put(Kind kind, uint32_t value) {
+    // Header and the longest varint
+    if (length + 6 > BUFFER_SIZE && !spill()) return;
+    if (value < 15) {
+        buffer[length++] = (uint8_t)(kind << 4 | value);
+        return;
+    }
+    buffer[length++] = (uint8_t)(kind << 4 | 15);
+    putVarint(value - 15);
+}
+
+void Journal::putVarint(uint32_t value) {
+    while (value >= 0x80) {
+        buffer[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buffer[length++] = (uint8_t)value;
+}
+
+void Journal::putBytes(const uint8_t* bytes, size_t count) {
+    if (stopped) return;
+    if (count > BUFFER_SIZE / 2) {
+        stop("record too large");
+        return;
+    }
+    if (length + count > BUFFER_SIZE && !spill()) return;
+    memcpy(buffer + length, bytes, count);
+    length += count;
+}
+
+void Journal::putText(Kind kind, const char* text, size_t count) {
+    put(kind, count);
+    putBytes((const uint8_t*)text, count);
+}
+
+void Journal::diverge(Kind expected) {
+    diverged = true;
+    uint8_t found = data[position] >> 4;
+    snprintf(divergence, sizeof(divergence), "loop %u, byte %u: firmware read %s, journal has %s",
+             (unsigned)loops, (unsigned)position, KIND_NAMES[expected], KIND_NAMES[found]);
+    end();
+}
+
+void Journal::end() {
+    void (*handler)() = endHandler;
+    endHandler = nullptr;
+    if (handler) handler();
+}
+
+bool Journal::peek(Kind kind) const {
+    return !diverged && position < size && data[position] >> 4 == kind;
+}
+
+uint32_t Journal::take(Kind kind) {
+    // Past the end or a divergence nothing more happens: no time passes,
+    // no samples arrive
+    if (diverged || position >= size) {
+        end();
+        return 0;
+    }
+    if (data[position] >> 4 != kind) {
+        diverge(kind);
+        return 0;
+    }
+    uint32_t value = data[position++] & 15;
+    if (value == 15) value += takeVarint();
+    return value;
+}
+
+uint32_t Journal::takeVarint() {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35 && position < size; shift += 7) {
+        uint8_t byte = data[position++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+    }
+    return value;
+}
+
+void Journal::takeBytes(uint8_t* bytes, size_t count) {
+    size_t available = position < size ? size - position : 0;
+    if (count > available) count = available;
+    if (bytes) memcpy(bytes, data + position, count);
+    position += count;
+}
+
+String Journal::takeText(Kind kind) {
+    uint32_t count = take(kind);
+    String text;
+    text.reserve(count);
+    for (uint32_t i = 0; i < count && position < size; i++) {
+        text += (char)data[position++];
+    }
+    return text;
+}
+
+// ==================== CONSOLE AND WEB ====================
+bool Journal::readConsoleLine(String& line) {
+    if (replayed()) {
+        if (!peek(KIND_CONSOLE)) return false;
+        line = takeText(KIND_CONSOLE);
+        return true;
+    }
+    if (!Serial.available()) return false;
+    {
+        // The device's Serial times out on the clock
+        JournalPause pause;
+        line = Serial.readStringUntil('\n');
+    }
+    if (journaling()) putText(KIND_CONSOLE, line.c_str(), line.length());
+    return true;
+}
+
+void Journal::beginRequest(const char* target) {
+    resumedPause = paused;
+    paused = 0;
+    if (journaling() && mode == RECORDING) putText(KIND_REQUEST, target, strlen(target));
+}
+
+void Journal::endRequest() {
+    paused = resumedPause;
+}
+
+bool Journal::nextRequest(String& target) {
+    if (mode != REPLAYING || !onLoopTask() || !peek(KIND_REQUEST)) return false;
+    target = takeText(KIND_REQUEST);
+    return true;
+}
+
+// ==================== PAUSE ====================
+JournalPause::JournalPause() : active(journal.onLoopTask()) {
+    if (active) journal.pause();
+}
+
+JournalPause::~JournalPause() {
+    if (active) journal.resume();
+}
+
+// ==================== PREFERENCES ====================
+bool JournaledPreferences::begin(const char* name, bool readOnly) {
+    if (journal.isReplaying()) return true;
+    JournalPause pause;
+    return Preferences::begin(name, readOnly);
+}
+
+size_t JournaledPreferences::putString(const char* key, const String& value) {
+    if (journal.isReplaying()) return value.length();
+    JournalPause pause;
+    return Preferences::putString(key, value);
+}
+
+size_t JournaledPreferences::putFloat(const char* key, float value) {
+    if (journal.isReplaying()) return sizeof(value);
+    JournalPause pause;
+    return Preferences::putFloat(key, value);
+}
+
+size_t JournaledPreferences::putInt(const char* key, int32_t value) {
+    if (journal.isReplaying()) return sizeof(value);
+    JournalPause pause;
+    return Preferences::putInt(key, value);
+}
+
+size_t JournaledPreferences::putUInt(const char* key, uint32_t value) {
+    if (journal.isReplaying()) return sizeof(value);
+    JournalPause pause;
+    return Preferences::putUInt(key, value);
+}
+
+size_t JournaledPreferences::putBool(const char* key, bool value) {
+    if (journal.isReplaying()) return sizeof(value);
+    JournalPause pause;
+    return Preferences::putBool(key, value);
+}
+
+String JournaledPreferences::getString(const char* key, const String& defaultValue) {
+    if (!journal.journaling()) return Preferences::getString(key, defaultValue);
+    if (journal.isReplaying()) return journal.takeText(Journal::KIND_TEXT);
+    String value;
+    {
+        JournalPause pause;
+        value = Preferences::getString(key, defaultValue);
+    }
+    journal.putText(Journal::KIND_TEXT, value.c_str(), value.length());
+    return value;
+}
+
+float JournaledPreferences::getFloat(const char* key, float defaultValue) {
+    uint32_t bits = journal.input(Journal::KIND_VALUE, [&] {
+        float value = Preferences::getFloat(key, defaultValue);
+        uint32_t raw;
+        memcpy(&raw, &value, sizeof(raw));
+        return raw;
+    });
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+int32_t JournaledPreferences::getInt(const char* key, int32_t defaultValue) {
+    return (int32_t)journal.input(Journal::KIND_VALUE, [&] { return (uint32_t)Preferences::getInt(key, defaultValue); });
+}
+
+uint32_t JournaledPreferences::getUInt(const char* key, uint32_t defaultValue) {
+    return journal.input(Journal::KIND_VALUE, [&] { return Preferences::getUInt(key, defaultValue); });
+}
+
+bool JournaledPreferences::getBool(const char* key, bool defaultValue) {
+    return journal.input(Journal::KIND_VALUE, [&] { return (uint32_t)Preferences::getBool(key, defaultValue); }) != 0;
+}
@@ -0,0 +1,230 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <Arduino.h>
+#include <Preferences.h>
+#include "hal.h"
+
+// Input journal: records every input the loop task takes from outside the
+// firmware, so that the native build can run setup() and loop() again on
+// exactly the same inputs and a problem seen on a ward can be stepped
+// through, profiled and traced at the desk.
+//
+// Journaled: the clock, sensor samples, ADC readings, touches, file system
+// results and reads, WiFi connection events, serial command lines, web
+// requests and the settings read from Preferences. hal.clock, sensor, adc,
+// touch, storage and network are swapped for decorators that record what
+// the board returned; in replay the same decorators hand it back without
+// asking the board, delay() returns at once and nothing is written to
+// files or NVS, so an hour replays in seconds.
+//
+// Only the loop task is journaled. Other tasks (uplink, trace) use the
+// board directly while recording; in replay they see the replayed time and
+// no network, so the uplink stays idle.
+//
+// Calls a driver makes inside a journaled call are not journaled: a
+// decorator pauses the journal while the board runs, so the MAX3010x
+// library's own clock reads are not taken for the firmware's. The sketch
+// pauses it the same way around the web server and DNS libraries, and a
+// journaled route resumes it for the handler (beginRequest()).
+//
+// Format: "JRN1", then one header byte per record, the kind in the high
+// nibble and a value below 15 in the low one (15: value - 15 follows as a
+// varint). Clock readings are stored as the difference to the previous
+// one, sensor samples as the zigzag difference to the previous sample. A LOOP record
+// starts each loop() iteration. Replay stops at the end of the journal or
+// at the first record that does not match the call the firmware makes,
+// which means the firmware or the build differs from the recorded one.
+//
+// Recording is switched on with `journal on` and starts at the next boot,
+// since replay starts at setup(). The RAM buffer drains to JOURNAL_PATH at
+// loop boundaries once SPILL_SIZE has built up, and on `journal save`;
+// when the file reaches FILE_LIMIT recording stops, keeping the part from
+// boot on. The file is replaced at every boot, so fetch it (/api/journal)
+// before restarting a monitor that misbehaved.
+//
+// Capacity: a monitor on the ward journals about 1.25 KB per second, so the
+// device's 1 MB holds about the first 14 minutes after boot; whatever goes
+// wrong later is not in the journal. test/test_journal checks the rate.
+
+#define JOURNAL_PATH "/journal.bin"
+
+// Of the 1920 KB SPIFFS partition (partitions.csv), next to the vitals
+// log's 512 KB and the dashboard
+#define JOURNAL_DEVICE_FILE_LIMIT (1024 * 1024)
+
+#ifndef JOURNAL_FILE_LIMIT
+#if defined(ESP32)
+#define JOURNAL_FILE_LIMIT JOURNAL_DEVICE_FILE_LIMIT
+#else
+#define JOURNAL_FILE_LIMIT (256 * 1024 * 1024)
+#endif
+#endif
+
+class Journal {
+public:
+    enum Mode : uint8_t {
+        OFF,
+        RECORDING,
+        REPLAYING
+    };
+
+    enum Kind : uint8_t {
+        KIND_LOOP,
+        KIND_MILLIS,        // Difference to the previous reading
+        KIND_MICROS,
+        KIND_SAMPLES,       // Sensor check() and available()
+        KIND_RED,           // Zigzag difference to the previous sample
+        KIND_IR,
+        KIND_ADC,
+        KIND_TOUCH,         // touched()
+        KIND_POINT,         // One per coordinate, zigzag
+        KIND_STORAGE,       // Result of a file operation; reads are followed by the bytes
+        KIND_WIFI,          // WifiManager event
+        KIND_CONSOLE,       // Length, then the serial command line
+        KIND_REQUEST,       // Length, then "path?query"
+        KIND_VALUE,         // Anything else: settings, begin() results, heap
+        KIND_TEXT           // Length, then a setting's text
+    };
+
+    static const size_t BUFFER_SIZE = 16 * 1024;
+    static const size_t SPILL_SIZE = 4 * 1024;
+    static const size_t FILE_LIMIT = JOURNAL_FILE_LIMIT;
+
+private:
+    Mode mode;
+    bool stopped;           // Full or failed; the board is used directly from then on
+    TaskHandle_t loopTask;
+    int paused;             // Loop task only
+    int resumedPause;
+    uint32_t loops;
+
+    // Recording
+    uint8_t* buffer;
+    size_t length;
+    size_t spilled;
+
+    // Replay
+    const uint8_t* data;
+    size_t size;
+    size_t position;
+    bool diverged;
+    char divergence[96];
+    void (*endHandler)();
+
+    bool spill();
+    void stop(const char* reason);
+    void putVarint(uint32_t value);
+    uint32_t takeVarint();
+    void diverge(Kind expected);
+    void end();
+    void install();
+
+public:
+    Journal();
+
+    // Starts recording if `journal on` was given before this boot. Call
+    // first thing in setup(), before any input is read.
+    void begin();
+    // Native builds: replays a journal read from a file through setup()
+    // and loop(); call before setup(). Returns false if it is not one.
+    // onEnd is called, once, when the firmware reads past the end or
+    // diverges: the firmware may be waiting for time to pass by then, as in
+    // a fatal error loop, and would never return to the caller.
+    bool replay(const uint8_t* journal, size_t journalSize, void (*onEnd)() = nullptr);
+
+    Mode getMode() const { return mode; }
+    bool isRecording() const { return mode == RECORDING && !stopped; }
+    bool isReplaying() const { return mode == REPLAYING; }
+    // Replay: records left for another loop() iteration
+    bool hasMore() const { return mode == REPLAYING && !diverged && position < size; }
+    bool hasDiverged() const { return diverged; }
+    // What the firmware asked for and what the journal had instead
+    const char* getDivergence() const { return divergence; }
+    uint32_t getLoops() const { return loops; }
+    // Bytes recorded, or replayed so far
+    size_t getBytes() const { return mode == REPLAYING ? position : spilled + length; }
+
+    // Takes effect at the next boot
+    void setEnabled(bool enabled);
+    bool isEnabled();
+    // Writes out what is still in RAM; false if nothing is being recorded
+    bool save();
+
+    // Marks the start of a loop() iteration
+    void loopStarted();
+
+    // A serial command line, read from Serial or from the journal
+    bool readConsoleLine(String& line);
+    // Called by a journaled web route as it starts and ends; journals the
+    // request and resumes the journal for the handler
+    void beginRequest(const char* target);
+    void endRequest();
+    // Replay: the request that the loop served at this point, if any
+    bool nextRequest(String& target);
+
+    // ---- For the decorators ----
+    bool onLoopTask() const { return xTaskGetCurrentTaskHandle() == loopTask; }
+    // Whether this call is journaled: journal running, loop task, not paused
+    bool journaling() const { return mode != OFF && !stopped && paused == 0 && onLoopTask(); }
+    // Whether this call is served from the journal instead of the board
+    bool replayed() const { return mode == REPLAYING && journaling(); }
+    void pause() { paused++; }
+    void resume() { paused--; }
+    void put(Kind kind, uint32_t value);
+    void putBytes(const uint8_t* bytes, size_t count);
+    void putText(Kind kind, const char* text, size_t count);
+    uint32_t take(Kind kind);
+    // Skips the bytes if given nullptr
+    void takeBytes(uint8_t* bytes, size_t count);
+    String takeText(Kind kind);
+    bool peek(Kind kind) const;
+
+    // Journals what read() returns: records it, or in replay returns the
+    // recorded value without calling read
+    template <typename Read>
+    uint32_t input(Kind kind, Read read) {
+        if (!journaling()) return read();
+        if (mode == REPLAYING) return take(kind);
+        pause();
+        uint32_t value = read();
+        resume();
+        put(kind, value);
+        return value;
+    }
+};
+
+// Leaves the calls in its scope out of the journal: library code whose
+// inputs the journal does not replay, or the journal's own file access
+class JournalPause {
+private:
+    bool active;        // Only the loop task's calls are journaled anyway
+
+public:
+    JournalPause();
+    ~JournalPause();
+};
+
+// Preferences whose reads are journaled; in replay they return the
+// recorded settings and writes are dropped
+class JournaledPreferences : public Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false);
+    size_t putString(const char* key, const String& value);
+    size_t putFloat(const char* key, float value);
+    size_t putInt(const char* key, int32_t value);
+    size_t putUInt(const char* key, uint32_t value);
+    size_t putBool(const char* key, bool value);
+    String getString(const char* key, const String& defaultValue = String());
+    float getFloat(const char* key, float defaultValue = 0);
+    int32_t getInt(const char* key, int32_t defaultValue = 0);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    bool getBool(const char* key, bool defaultValue = false);
+};
+
+extern Journal journal;
+
+#endif
@@ -0,0 +1,172 @@
+#include "json_reader.h"
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+FlatJsonReader::FlatJsonReader(const char* json, size_t length) : p(json), end(json + length), failed(false) {
+    skipSpace();
+    if (p < end && *p == '{') {
+        p++;
+    } else {
+        failed = true;
+    }
+}
+
+void FlatJsonReader::skipSpace() {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+}
+
+bool FlatJsonReader::skipString() {
+    // At the opening quote
+    for (p++; p < end; p++) {
+        if (*p == '\\') {
+            p++;
+        } else if (*p == '"') {
+            p++;
+            return true;
+        }
+    }
+    failed = true;
+    return false;
+}
+
+bool FlatJsonReader::skipValue() {
+    skipSpace();
+    if (p >= end) {
+        failed = true;
+        return false;
+    }
+    if (*p == '"') return skipString();
+    if (*p == '{' || *p == '[') {
+        int depth = 0;
+        while (p < end) {
+            if (*p == '"') {
+                if (!skipString()) return false;
+                continue;
+            }
+            if (*p == '{' || *p == '[') depth++;
+            if (*p == '}' || *p == ']') depth--;
+            p++;
+            if (depth == 0) return true;
+        }
+        failed = true;
+        return false;
+    }
+    // Number, true, false, null
+    while (p < end && *p != ',' && *p != '}' && *p != ']' && *p != ' ') p++;
+    return true;
+}
+
+bool FlatJsonReader::next(const char*& key, size_t& keyLength) {
+    if (failed) return false;
+    skipSpace();
+    if (p < end && *p == ',') {
+        p++;
+        skipSpace();
+    }
+    if (p >= end || *p == '}') return false;
+    if (*p != '"') {
+        failed = true;
+        return false;
+    }
+    key = p + 1;
+    if (!skipString()) return false;
+    keyLength = p - 1 - key;
+    skipSpace();
+    if (p >= end || *p != ':') {
+        failed = true;
+        return false;
+    }
+    p++;
+    skipSpace();
+    return true;
+}
+
+bool FlatJsonReader::readNumber(double& value) {
+    char* stop;
+    value = strtod(p, &stop);
+    if (stop == p || stop > end) {
+        skipValue();
+        return false;
+    }
+    p = stop;
+    return true;
+}
+
+bool FlatJsonReader::readBool(bool& value) {
+    if (end - p >= 4 && memcmp(p, "true", 4) == 0) {
+        value = true;
+        p += 4;
+        return true;
+    }
+    if (end - p >= 5 && memcmp(p, "false", 5) == 0) {
+        value = false;
+        p += 5;
+        return true;
+    }
+    skipValue();
+    return false;
+}
+
+bool FlatJsonReader::readString(char* out, size_t size) {
+    if (p >= end || *p != '"') {
+        skipValue();
+        return false;
+    }
+    size_t n = 0;
+    for (p++; p < end && *p != '"'; p++) {
+        char c = *p;
+        if (c == '\\' && p + 1 < end) {
+            c = *++p;
+            if (c == 'n') c = '\n';
+            else if (c == 't') c = '\t';
+            else if (c == 'u') {
+                // The monitors only escape control characters; keep a placeholder
+                p += std::min<ptrdiff_t>(4, end - p - 1);
+                c = '?';
+            }
+        }
+        if (n + 1 < size) out[n++] = c;
+    }
+    if (size > 0) out[n] = '\0';
+    if (p >= end) {
+        failed = true;
+        return false;
+    }
+    p++;
+    return true;
+}
+
+bool FlatJsonReader::readNumberArray(int32_t* out, size_t capacity, size_t& count) {
+    count = 0;
+    if (p >= end || *p != '[') {
+        skipValue();
+        return false;
+    }
+    p++;
+    while (true) {
+        skipSpace();
+        if (p < end && *p == ']') {
+            p++;
+            return true;
+        }
+        if (p < end && *p == ',') {
+            p++;
+            continue;
+        }
+        char* stop;
+        long value = strtol(p, &stop, 10);
+        if (stop == p || stop > end) {
+            failed = true;
+            return false;
+        }
+        // Fractions are cut off; the firmware sends whole counts
+        while (stop < end && *stop != ',' && *stop != ']') stop++;
+        p = stop;
+        if (count < capacity) out[count++] = (int32_t)value;
+    }
+}
+
+bool jsonKeyIs(const char* key, size_t keyLength, const char* name) {
+    return strncmp(key, name, keyLength) == 0 && name[keyLength] == '\0';
+}
@@ -0,0 +1,72 @@
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+/*
+ * In-place reader for the flat JSON objects of the /ws protocol
+ * (ws_messages.h): the commands a dashboard sends the monitor and the
+ * messages the monitor sends back. The counterpart of json_schema.h, with
+ * no document and no heap: keys point into the input and values are read
+ * straight into the caller's variables.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Walks the top-level members of one JSON object without building a
+// document. The messages are flat apart from the waveform's number array
+// and a subscription's channel list; nested objects are skipped whole.
+class FlatJsonReader {
+private:
+    const char* p;
+    const char* end;
+    bool failed;
+
+    void skipSpace();
+    bool skipValue();
+    bool skipString();
+
+public:
+    FlatJsonReader(const char* json, size_t length);
+
+    // Moves to the next member; `key` points into the input (no escapes in
+    // the monitors' keys). False at the end of the object or on bad input.
+    bool next(const char*& key, size_t& keyLength);
+    bool hasFailed() const { return failed; }
+
+    // Value readers for the current member; each consumes it
+    bool readNumber(double& value);
+    bool readBool(bool& value);
+    // Unescapes into out (truncated, always terminated)
+    bool readString(char* out, size_t size);
+    // Numbers of an array, up to `capacity`; the rest are skipped
+    bool readNumberArray(int32_t* out, size_t capacity, size_t& count);
+    bool skip() { return skipValue(); }
+    // A string, or an array of strings, each passed to onString
+    template <typename OnString>
+    bool readStrings(OnString onString) {
+        char text[32];
+        if (p < end && *p == '"') {
+            if (!readString(text, sizeof(text))) return false;
+            onString(text);
+            return true;
+        }
+        if (p >= end || *p != '[') return skipValue();
+        for (p++;;) {
+            skipSpace();
+            if (p < end && *p == ']') {
+                p++;
+                return true;
+            }
+            if (p < end && *p == ',') {
+                p++;
+                continue;
+            }
+            if (!readString(text, sizeof(text))) return false;
+            onString(text);
+        }
+    }
+};
+
+bool jsonKeyIs(const char* key, size_t keyLength, const char* name);
+
+#endif
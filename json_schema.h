@@ -0,0 +1,411 @@
+#ifndef JSON_SCHEMA_H
+#define JSON_SCHEMA_H
+
+/*
+ * Compile-time schema JSON serializer for fixed-shape payloads.
+ *
+ * A struct's field list is declared once by specializing JsonSchema<T>:
+ *
+ *   template <> struct JsonSchema<VitalSigns> {
+ *       static constexpr auto fields() {
+ *           return std::make_tuple(
+ *               jsonMember("heartRate", &VitalSigns::heartRate, 1),
+ *               jsonMember("timestamp", &VitalSigns::timestamp));
+ *       }
+ *   };
+ *
+ * Objects are then written straight into a buffer or stream with no DOM and
+ * no heap. jsonMeasure() runs the same code against a counting sink, so the
+ * exact length is known before anything is sent (Content-Length).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <tuple>
+#include <type_traits>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+template <typename T>
+struct JsonSchema;
+
+// ==================== FIELD DESCRIPTORS ====================
+template <typename T, typename M>
+struct JsonMember {
+    const char* name;
+    M T::*member;
+    uint8_t decimals;  // Only used for floating point members
+};
+
+template <typename T, typename M>
+constexpr JsonMember<T, M> jsonMember(const char* name, M T::*member, uint8_t decimals = 2) {
+    return JsonMember<T, M>{name, member, decimals};
+}
+
+// Fixed key/value pair, e.g. {"type": "vitals"}
+struct JsonConstant {
+    const char* name;
+    const char* value;
+};
+
+constexpr JsonConstant jsonConstant(const char* name, const char* value) {
+    return JsonConstant{name, value};
+}
+
+// ==================== SINKS ====================
+// Writes into a caller-provided buffer; always NUL-terminates when size > 0
+class JsonBufferSink {
+private:
+    char* buffer;
+    size_t size;
+    size_t length;
+
+public:
+    JsonBufferSink(char* buf, size_t bufSize) : buffer(buf), size(bufSize), length(0) {}
+
+    // Points the sink at a new buffer; a writer using it keeps its nesting state
+    void reset(char* buf, size_t bufSize) {
+        buffer = buf;
+        size = bufSize;
+        length = 0;
+    }
+
+    void write(const char* data, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            put(data[i]);
+        }
+    }
+
+    // The last byte is kept for the terminator finish() writes
+    void put(char c) {
+        if (length + 1 < size) {
+            buffer[length] = c;
+        }
+        length++;
+    }
+
+    // Terminates what fit, once, after the last put()
+    void finish() {
+        if (size > 0) {
+            buffer[length < size ? length : size - 1] = '\0';
+        }
+    }
+
+    // Total length of the document, even if it did not fit
+    size_t getLength() const { return length; }
+    bool overflowed() const { return length + 1 > size; }
+};
+
+// Counts bytes only; used for exact size precomputation
+class JsonCountingSink {
+private:
+    size_t length;
+
+public:
+    JsonCountingSink() : length(0) {}
+    void write(const char* data, size_t len) { (void)data; length += len; }
+    void put(char c) { (void)c; length++; }
+    size_t getLength() const { return length; }
+};
+
+// Emits only the bytes in [offset, offset + size) of the document. Lets a
+// chunked HTTP filler regenerate any window of the output without storing it.
+class JsonWindowSink {
+private:
+    char* buffer;
+    size_t size;
+    size_t offset;
+    size_t position;
+    size_t written;
+
+public:
+    JsonWindowSink(char* buf, size_t bufSize, size_t start)
+        : buffer(buf), size(bufSize), offset(start), position(0), written(0) {}
+
+    void write(const char* data, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            put(data[i]);
+        }
+    }
+
+    void put(char c) {
+        if (position >= offset && written < size) {
+            buffer[written++] = c;
+        }
+        position++;
+    }
+
+    size_t getWritten() const { return written; }
+};
+
+#ifdef ARDUINO
+// Streams to any Print (File, WiFiClient, Serial) through a small staging buffer
+class JsonPrintSink {
+private:
+    static const size_t STAGING_SIZE = 64;
+    Print& out;
+    char staging[STAGING_SIZE];
+    size_t used;
+    size_t length;
+
+public:
+    explicit JsonPrintSink(Print& target) : out(target), used(0), length(0) {}
+    ~JsonPrintSink() { flush(); }
+
+    void write(const char* data, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            put(data[i]);
+        }
+    }
+
+    void put(char c) {
+        staging[used++] = c;
+        length++;
+        if (used == STAGING_SIZE) {
+            flush();
+        }
+    }
+
+    void flush() {
+        if (used > 0) {
+            out.write((const uint8_t*)staging, used);
+            used = 0;
+        }
+    }
+
+    size_t getLength() const { return length; }
+};
+#endif
+
+// ==================== WRITER ====================
+template <typename Sink>
+class JsonWriter {
+private:
+    static const int MAX_DEPTH = 8;
+    Sink& sink;
+    int depth;
+    bool first[MAX_DEPTH];
+
+public:
+    explicit JsonWriter(Sink& target) : sink(target), depth(0) {
+        first[0] = true;
+    }
+
+    void beginObject() { separator(); sink.put('{'); push(); }
+    void endObject() { pop(); sink.put('}'); }
+    void beginArray() { separator(); sink.put('['); push(); }
+    void endArray() { pop(); sink.put(']'); }
+
+    void key(const char* name) {
+        separator();
+        writeString(name);
+        sink.put(':');
+        // The value that follows must not emit another separator
+        first[depth] = true;
+    }
+
+    void value(bool v) {
+        separator();
+        if (v) sink.write("true", 4);
+        else sink.write("false", 5);
+    }
+
+    void value(const char* v) {
+        separator();
+        if (v) writeString(v);
+        else sink.write("null", 4);
+    }
+
+#ifdef ARDUINO
+    void value(const String& v) { value(v.c_str()); }
+#endif
+
+    template <typename V>
+    typename std::enable_if<std::is_integral<V>::value && !std::is_same<V, bool>::value>::type
+    value(V v) {
+        separator();
+        if (std::is_signed<V>::value && v < 0) {
+            sink.put('-');
+            // Negated as unsigned: -INT64_MIN does not fit in int64_t
+            writeUnsigned(0 - (uint64_t)(int64_t)v);
+        } else {
+            writeUnsigned((uint64_t)v);
+        }
+    }
+
+    template <typename V>
+    typename std::enable_if<std::is_floating_point<V>::value>::type
+    value(V v, uint8_t decimals = 2) {
+        separator();
+        writeFloat((double)v, decimals);
+    }
+
+    // Writes obj using its schema (or an alternative view of the same type)
+    template <typename Schema = void, typename T>
+    void object(const T& obj) {
+        using S = typename std::conditional<std::is_void<Schema>::value, JsonSchema<T>, Schema>::type;
+        beginObject();
+        std::apply([&](const auto&... fields) { (writeField(obj, fields), ...); }, S::fields());
+        endObject();
+    }
+
+    template <typename Schema = void, typename Iterator>
+    void array(Iterator begin, Iterator end) {
+        beginArray();
+        for (Iterator it = begin; it != end; ++it) {
+            object<Schema>(*it);
+        }
+        endArray();
+    }
+
+private:
+    void push() {
+        if (depth < MAX_DEPTH - 1) depth++;
+        first[depth] = true;
+    }
+
+    void pop() {
+        if (depth > 0) depth--;
+    }
+
+    void separator() {
+        if (!first[depth]) sink.put(',');
+        first[depth] = false;
+    }
+
+    template <typename T, typename M>
+    void writeField(const T& obj, const JsonMember<T, M>& field) {
+        key(field.name);
+        writeMember(obj.*(field.member), field.decimals);
+    }
+
+    template <typename T>
+    void writeField(const T& obj, const JsonConstant& field) {
+        (void)obj;
+        key(field.name);
+        value(field.value);
+    }
+
+    template <typename M>
+    typename std::enable_if<std::is_floating_point<M>::value>::type
+    writeMember(const M& m, uint8_t decimals) { value(m, decimals); }
+
+    template <typename M>
+    typename std::enable_if<!std::is_floating_point<M>::value>::type
+    writeMember(const M& m, uint8_t decimals) { (void)decimals; value(m); }
+
+    void writeString(const char* s) {
+        static const char HEX_DIGITS[] = "0123456789abcdef";
+        sink.put('"');
+        for (; *s; s++) {
+            char c = *s;
+            switch (c) {
+                case '"':  sink.write("\\\"", 2); break;
+                case '\\': sink.write("\\\\", 2); break;
+                case '\n': sink.write("\\n", 2); break;
+                case '\r': sink.write("\\r", 2); break;
+                case '\t': sink.write("\\t", 2); break;
+                default:
+                    if ((uint8_t)c < 0x20) {
+                        sink.write("\\u00", 4);
+                        sink.put(HEX_DIGITS[(c >> 4) & 0x0F]);
+                        sink.put(HEX_DIGITS[c & 0x0F]);
+                    } else {
+                        sink.put(c);
+                    }
+                    break;
+            }
+        }
+        sink.put('"');
+    }
+
+    void writeUnsigned(uint64_t v) {
+        char digits[20];
+        int n = 0;
+        do {
+            digits[n++] = '0' + (char)(v % 10);
+            v /= 10;
+        } while (v != 0);
+        while (n > 0) {
+            sink.put(digits[--n]);
+        }
+    }
+
+    // Fixed-point formatting with trailing zeros trimmed: 72.50 -> 72.5, 98.0 -> 98
+    void writeFloat(double v, uint8_t decimals) {
+        static const uint32_t POW10[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+        if (isnan(v) || isinf(v)) {
+            sink.write("null", 4);
+            return;
+        }
+
+        if (decimals > 6) decimals = 6;
+        bool negative = v < 0;
+        if (negative) v = -v;
+
+        // Beyond this range the scaled value no longer fits; vitals never get here
+        if (v >= 1e12) {
+            if (negative) sink.put('-');
+            writeUnsigned((uint64_t)v);
+            return;
+        }
+
+        uint64_t scaled = (uint64_t)(v * POW10[decimals] + 0.5);
+        uint64_t integerPart = scaled / POW10[decimals];
+        uint32_t fraction = (uint32_t)(scaled % POW10[decimals]);
+
+        if (negative && scaled != 0) sink.put('-');
+        writeUnsigned(integerPart);
+
+        if (fraction == 0) return;
+
+        int width = decimals;
+        while (fraction % 10 == 0) {
+            fraction /= 10;
+            width--;
+        }
+
+        char digits[6];
+        for (int i = width - 1; i >= 0; i--) {
+            digits[i] = '0' + (char)(fraction % 10);
+            fraction /= 10;
+        }
+        sink.put('.');
+        sink.write(digits, width);
+    }
+};
+
+// ==================== CONVENIENCE ====================
+template <typename Schema = void, typename T>
+size_t jsonMeasure(const T& obj) {
+    JsonCountingSink sink;
+    JsonWriter<JsonCountingSink> writer(sink);
+    writer.template object<Schema>(obj);
+    return sink.getLength();
+}
+
+// Returns the document length; the output is truncated if it is >= size
+template <typename Schema = void, typename T>
+size_t jsonSerialize(const T& obj, char* buffer, size_t size) {
+    JsonBufferSink sink(buffer, size);
+    JsonWriter<JsonBufferSink> writer(sink);
+    writer.template object<Schema>(obj);
+    sink.finish();
+    return sink.getLength();
+}
+
+// Writes bytes [offset, offset + size) of the document; returns bytes written
+template <typename Schema = void, typename T>
+size_t jsonSerializeWindow(const T& obj, char* buffer, size_t size, size_t offset) {
+    JsonWindowSink sink(buffer, size, offset);
+    JsonWriter<JsonWindowSink> writer(sink);
+    writer.template object<Schema>(obj);
+    return sink.getWritten();
+}
+
+#endif
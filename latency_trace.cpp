@@ -0,0 +1,95 @@
+#include "latency_trace.h"
+#include <string.h>
+#include "metrics.h"
+
+LatencyTracer latencyTracer;
+
+// ==================== HISTOGRAMS ====================
+static const uint32_t LATENCY_BOUNDS_MS[] = {1, 5, 10, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 60000};
+
+// One family, declared together; indexed by LatencyPath
+static MetricHistogram latencyHistograms[LATENCY_PATH_COUNT] = {
+    MetricHistogram("cardiac_latency_ms{path=\"estimate\"}",
+        "Time from a sensor burst to an output derived from it, by path", LATENCY_BOUNDS_MS, 12),
+    MetricHistogram("cardiac_latency_ms{path=\"alarm\"}",
+        "Time from a sensor burst to an output derived from it, by path", LATENCY_BOUNDS_MS, 12),
+    MetricHistogram("cardiac_latency_ms{path=\"buzzer\"}",
+        "Time from a sensor burst to an output derived from it, by path", LATENCY_BOUNDS_MS, 12),
+    MetricHistogram("cardiac_latency_ms{path=\"alarm_banner\"}",
+        "Time from a sensor burst to an output derived from it, by path", LATENCY_BOUNDS_MS, 12),
+    MetricHistogram("cardiac_latency_ms{path=\"display\"}",
+        "Time from a sensor burst to an output derived from it, by path", LATENCY_BOUNDS_MS, 12),
+    MetricHistogram("cardiac_latency_ms{path=\"network\"}",
+        "Time from a sensor burst to an output derived from it, by path", LATENCY_BOUNDS_MS, 12),
+};
+
+const char* latencyPathName(LatencyPath path) {
+    switch (path) {
+        case LatencyPath::ESTIMATE: return "estimate";
+        case LatencyPath::ALARM: return "alarm";
+        case LatencyPath::BUZZER: return "buzzer";
+        case LatencyPath::ALARM_BANNER: return "alarm_banner";
+        case LatencyPath::DISPLAY: return "display";
+        default: return "network";
+    }
+}
+
+// ==================== TRACER ====================
+LatencyTracer::LatencyTracer() {
+    reset();
+}
+
+void LatencyTracer::reset() {
+    nextSequence = 1;
+    memset(ringSequence, 0, sizeof(ringSequence));
+    memset(ringArrival, 0, sizeof(ringArrival));
+    memset(pinnedSequence, 0, sizeof(pinnedSequence));
+    memset(pinnedArrival, 0, sizeof(pinnedArrival));
+    pinnedNext = 0;
+    memset(lastReached, 0, sizeof(lastReached));
+}
+
+uint32_t LatencyTracer::acquired(uint32_t nowUs) {
+    uint32_t sequence = nextSequence++;
+    if (nextSequence == 0) nextSequence = 1;
+    ringSequence[sequence % RING] = sequence;
+    ringArrival[sequence % RING] = nowUs;
+    return sequence;
+}
+
+bool LatencyTracer::arrivalOf(uint32_t sequence, uint32_t& arrivalUs) const {
+    if (sequence == 0) return false;
+    if (ringSequence[sequence % RING] == sequence) {
+        arrivalUs = ringArrival[sequence % RING];
+        return true;
+    }
+    for (int i = 0; i < PINNED; i++) {
+        if (pinnedSequence[i] == sequence) {
+            arrivalUs = pinnedArrival[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+int32_t LatencyTracer::reached(LatencyPath path, uint32_t sequence, uint32_t nowUs) {
+    int p = (int)path;
+    // Wrap-safe "not newer than the last one counted"
+    if (sequence == 0 || (int32_t)(sequence - lastReached[p]) <= 0) return -1;
+
+    uint32_t arrival;
+    if (!arrivalOf(sequence, arrival)) return -1;
+    lastReached[p] = sequence;
+
+    bool pinned = false;
+    for (int i = 0; i < PINNED; i++) pinned |= pinnedSequence[i] == sequence;
+    if (!pinned) {
+        pinnedSequence[pinnedNext] = sequence;
+        pinnedArrival[pinnedNext] = arrival;
+        pinnedNext = (pinnedNext + 1) % PINNED;
+    }
+
+    uint32_t latency = nowUs - arrival;
+    latencyHistograms[p].observe(latency / 1000);
+    return (int32_t)latency;
+}
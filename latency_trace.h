@@ -0,0 +1,66 @@
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Sample-to-output latency tracing.
+//
+// Every acquisition burst (a sensor FIFO read that delivered samples) gets
+// a sequence number, and its arrival time is kept in a short ring. Outputs
+// derived from the samples carry the newest sequence they depend on:
+// VitalSigns::sequence for estimates, AlarmEvent::sequence for alarms, and
+// the "seq" field of the vitals JSON. Wherever such an output leaves the
+// device, reached() looks the burst up and observes the elapsed time into
+// that path's histogram, exported as cardiac_latency_ms{path="..."}.
+//
+// Each sequence is counted once per path, so redrawing the same reading
+// every frame or serving it to several requests does not skew the figures.
+// A burst that reached any path is pinned, so a reading served long after
+// its window closed is still timed; other sequences older than the ring
+// are dropped rather than guessed.
+
+enum class LatencyPath : uint8_t {
+    ESTIMATE,       // Window completed, vitals re-estimated
+    ALARM,          // Alarm rules raised an alarm
+    BUZZER,         // Buzzer switched on for it
+    ALARM_BANNER,   // Alarm banner drawn
+    DISPLAY,        // Reading drawn on the main screen
+    NETWORK         // Reading sent to a client
+};
+
+static const int LATENCY_PATH_COUNT = 6;
+
+class LatencyTracer {
+public:
+    static const int RING = 64;     // Bursts; 2.6 s at the sketch's 40 ms sensor period
+    static const int PINNED = 8;    // Bursts that produced an output
+
+private:
+    uint32_t nextSequence;
+    uint32_t ringSequence[RING];
+    uint32_t ringArrival[RING];     // us
+    uint32_t pinnedSequence[PINNED];
+    uint32_t pinnedArrival[PINNED];
+    int pinnedNext;
+    uint32_t lastReached[LATENCY_PATH_COUNT];
+
+public:
+    LatencyTracer();
+
+    // Records a burst arriving at nowUs; returns its sequence number (never 0)
+    uint32_t acquired(uint32_t nowUs);
+    // Arrival time of a burst still in the ring
+    bool arrivalOf(uint32_t sequence, uint32_t& arrivalUs) const;
+    // Output derived from `sequence` reached `path`; returns the latency in
+    // us, or -1 if the sequence was 0, already counted or no longer known
+    int32_t reached(LatencyPath path, uint32_t sequence, uint32_t nowUs);
+    uint32_t getLastSequence() const { return nextSequence - 1; }
+    void reset();
+};
+
+const char* latencyPathName(LatencyPath path);
+
+extern LatencyTracer latencyTracer;
+
+#endif
@@ -0,0 +1,557 @@
+#include "dashboard_fleet.h"
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include "http_messages.h"
+#include "../gateway/ws_protocol.h"
+#include "../gateway/monitor_feed.h"
+
+static const uint64_t CONNECT_TIMEOUT = 5000000;    // us
+static const uint64_t RESPONSE_TIMEOUT = 10000000;
+static const uint64_t RETRY_DELAY = 1000000;
+static const uint64_t LATE_LIMIT = 1000000;         // Overdue polls past this are skipped
+static const uint64_t NEVER = UINT64_MAX;
+
+static uint64_t steadyMicros() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void DashboardFleetStats::add(const DashboardFleetStats& other) {
+    connected += other.connected;
+    connects += other.connects;
+    failures += other.failures;
+    responses += other.responses;
+    errors += other.errors;
+    late += other.late;
+    messages += other.messages;
+    bytes += other.bytes;
+    if (polls.size() < other.polls.size()) polls.resize(other.polls.size());
+    for (size_t i = 0; i < other.polls.size(); i++) polls[i].merge(other.polls[i]);
+    commands.merge(other.commands);
+    messageLatency.merge(other.messageLatency);
+}
+
+// ==================== DASHBOARDS ====================
+struct Dashboard;
+
+// One socket of a dashboard
+struct DashboardLink {
+    enum State : uint8_t {
+        IDLE,                       // Waiting to (re)connect
+        CONNECTING,
+        HANDSHAKE,                  // WebSocket upgrade sent
+        OPEN
+    };
+
+    Dashboard* owner;
+    bool websocket;
+    int fd = -1;
+    State state = IDLE;
+    uint64_t retryAt = 0;
+    uint64_t deadline = NEVER;      // Of the connect, handshake or response in flight
+    std::string in;
+    std::string out;
+    // HTTP
+    int poll = -1;                  // In flight, or -1
+    uint64_t dueAt = 0;
+    // WebSocket
+    std::string key;
+    WsDecoder decoder;
+    std::deque<uint64_t> commands;  // Send times of the unanswered ones
+    int64_t minDelay = INT64_MAX;   // ms, relative timing
+};
+
+struct Dashboard {
+    DashboardLink http;
+    DashboardLink ws;
+    std::vector<uint64_t> nextPoll;
+    uint64_t nextCommand = 0;
+    uint64_t wakeAt = NEVER;
+    uint32_t random;
+};
+
+// ==================== WORKER ====================
+class DashboardFleetWorker {
+private:
+    DashboardFleetOptions options;
+    std::string host;               // Host header
+    std::vector<std::unique_ptr<Dashboard>> dashboards;
+    typedef std::pair<uint64_t, Dashboard*> Wake;
+    std::priority_queue<Wake, std::vector<Wake>, std::greater<Wake>> wakes;
+    uint64_t armedAt;
+    int epoll;
+    int wakeup;
+    int timer;
+    std::thread thread;
+    std::mutex lock;
+    DashboardFleetStats stats;
+
+    uint64_t interval(Dashboard& dashboard, float rate);
+    void run();
+    void service(Dashboard& dashboard, uint64_t now);
+    void connect(DashboardLink& link, uint64_t now);
+    void fail(DashboardLink& link, uint64_t now);
+    void reconnect(DashboardLink& link, uint64_t now);
+    void onEvent(DashboardLink& link, uint32_t events, uint64_t now);
+    bool onHttpData(DashboardLink& link, bool atEnd, uint64_t now);
+    bool onWsData(DashboardLink& link, const char* data, size_t length, uint64_t now);
+    void onMessage(DashboardLink& link, uint8_t opcode, const char* payload, size_t length, uint64_t now);
+    bool flush(DashboardLink& link);
+    void arm();
+
+public:
+    explicit DashboardFleetWorker(const DashboardFleetOptions& fleetOptions);
+    ~DashboardFleetWorker();
+
+    // Before start(); the first connect is at `firstAt`
+    void add(uint32_t index, uint64_t firstAt);
+    void start();
+    void stop();
+    void collect(DashboardFleetStats& into, bool reset);
+};
+
+DashboardFleetWorker::DashboardFleetWorker(const DashboardFleetOptions& fleetOptions)
+    : options(fleetOptions), armedAt(NEVER), epoll(-1), wakeup(-1), timer(-1) {
+    host = options.device.host;
+    if (options.device.port != 80) host += ":" + std::to_string(options.device.port);
+    stats.polls.resize(options.polls.size());
+}
+
+DashboardFleetWorker::~DashboardFleetWorker() {
+    stop();
+}
+
+void DashboardFleetWorker::add(uint32_t index, uint64_t firstAt) {
+    std::unique_ptr<Dashboard> dashboard(new Dashboard());
+    dashboard->random = index * 2654435761u | 1;
+    dashboard->http.owner = dashboard->ws.owner = dashboard.get();
+    dashboard->http.websocket = false;
+    dashboard->ws.websocket = true;
+    dashboard->http.retryAt = dashboard->ws.retryAt = firstAt;
+    // First polls spread over their interval, so the fleet does not poll in step
+    for (const DashboardPoll& poll : options.polls) {
+        dashboard->nextPoll.push_back(firstAt + interval(*dashboard, poll.rate) * (index % 97) / 97);
+    }
+    dashboard->nextCommand = firstAt + (options.commandRate > 0 ? interval(*dashboard, options.commandRate) : 0);
+    dashboard->wakeAt = firstAt;
+    wakes.push(Wake(firstAt, dashboard.get()));
+    dashboards.push_back(std::move(dashboard));
+}
+
+uint64_t DashboardFleetWorker::interval(Dashboard& dashboard, float rate) {
+    double us = 1e6 / rate;
+    if (options.jitter > 0) {
+        dashboard.random ^= dashboard.random << 13;
+        dashboard.random ^= dashboard.random >> 17;
+        dashboard.random ^= dashboard.random << 5;
+        double spread = (dashboard.random >> 8) / (double)(1 << 24) * 2 - 1;
+        us *= 1 + options.jitter * spread;
+    }
+    return us < 1 ? 1 : (uint64_t)us;
+}
+
+void DashboardFleetWorker::start() {
+    epoll = epoll_create1(0);
+    wakeup = eventfd(0, EFD_NONBLOCK);
+    timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = (uint64_t)wakeup;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, wakeup, &event);
+    event.data.u64 = (uint64_t)timer;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, timer, &event);
+    thread = std::thread([this] { run(); });
+}
+
+void DashboardFleetWorker::stop() {
+    if (!thread.joinable()) return;
+    uint64_t one = 1;
+    (void)!write(wakeup, &one, sizeof(one));
+    thread.join();
+    for (auto& dashboard : dashboards) {
+        if (dashboard->http.fd >= 0) close(dashboard->http.fd);
+        if (dashboard->ws.fd >= 0) close(dashboard->ws.fd);
+    }
+    close(timer);
+    close(wakeup);
+    close(epoll);
+}
+
+void DashboardFleetWorker::collect(DashboardFleetStats& into, bool reset) {
+    std::lock_guard<std::mutex> guard(lock);
+    into.add(stats);
+    if (reset) {
+        int connected = stats.connected;
+        stats = DashboardFleetStats();
+        stats.connected = connected;
+        stats.polls.resize(options.polls.size());
+    }
+}
+
+// Sets the timer to the earliest wake, unless it is already set for it
+void DashboardFleetWorker::arm() {
+    if (wakes.empty() || wakes.top().first == armedAt) return;
+    armedAt = wakes.top().first;
+    itimerspec at = {};
+    // Clock values are the same CLOCK_MONOTONIC as steady_clock on Linux
+    at.it_value.tv_sec = armedAt / 1000000;
+    at.it_value.tv_nsec = (armedAt % 1000000) * 1000;
+    if (at.it_value.tv_sec == 0 && at.it_value.tv_nsec == 0) at.it_value.tv_nsec = 1;
+    timerfd_settime(timer, TFD_TIMER_ABSTIME, &at, nullptr);
+}
+
+void DashboardFleetWorker::run() {
+    epoll_event events[256];
+    bool running = true;
+    while (running) {
+        arm();
+        int ready = epoll_wait(epoll, events, 256, -1);
+        uint64_t now = steadyMicros();
+        for (int i = 0; i < ready; i++) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == (uint64_t)wakeup) {
+                running = false;
+            } else if (tag == (uint64_t)timer) {
+                uint64_t expirations;
+                (void)!read(timer, &expirations, sizeof(expirations));
+                armedAt = NEVER;
+            } else {
+                DashboardLink* link = (DashboardLink*)events[i].data.ptr;
+                onEvent(*link, events[i].events, now);
+                service(*link->owner, now);
+            }
+        }
+        // A stale wake (superseded by an earlier one) only costs a service()
+        while (!wakes.empty() && wakes.top().first <= now) {
+            Dashboard* dashboard = wakes.top().second;
+            uint64_t at = wakes.top().first;
+            wakes.pop();
+            if (at == dashboard->wakeAt) {
+                dashboard->wakeAt = NEVER;
+                service(*dashboard, now);
+            }
+        }
+    }
+}
+
+// Does whatever is due and schedules the next wake
+void DashboardFleetWorker::service(Dashboard& dashboard, uint64_t now) {
+    uint64_t next = NEVER;
+    DashboardLink* links[2] = {&dashboard.http, &dashboard.ws};
+    bool used[2] = {!options.polls.empty(), options.websocket};
+    for (int i = 0; i < 2; i++) {
+        DashboardLink& link = *links[i];
+        if (!used[i]) continue;
+        if (link.state == DashboardLink::IDLE && link.retryAt <= now) connect(link, now);
+        if (link.state != DashboardLink::IDLE && link.deadline <= now) fail(link, now);
+        if (link.state == DashboardLink::IDLE) next = std::min(next, link.retryAt);
+        if (link.deadline != NEVER) next = std::min(next, link.deadline);
+    }
+
+    DashboardLink& http = dashboard.http;
+    if (http.state == DashboardLink::OPEN && http.poll < 0 && !options.polls.empty()) {
+        size_t due = 0;
+        for (size_t i = 1; i < dashboard.nextPoll.size(); i++) {
+            if (dashboard.nextPoll[i] < dashboard.nextPoll[due]) due = i;
+        }
+        if (dashboard.nextPoll[due] <= now) {
+            http.poll = (int)due;
+            http.dueAt = dashboard.nextPoll[due];
+            http.deadline = now + RESPONSE_TIMEOUT;
+            httpAppendGet(http.out, host, options.polls[due].path);
+            uint64_t following = http.dueAt + interval(dashboard, options.polls[due].rate);
+            if (following + LATE_LIMIT < now) {
+                std::lock_guard<std::mutex> guard(lock);
+                stats.late++;
+                following = now;
+            }
+            dashboard.nextPoll[due] = following;
+            if (!flush(http)) fail(http, now);
+            next = std::min(next, http.deadline);
+        } else {
+            next = std::min(next, dashboard.nextPoll[due]);
+        }
+    }
+
+    DashboardLink& ws = dashboard.ws;
+    if (ws.state == DashboardLink::OPEN && options.commandRate > 0) {
+        if (dashboard.nextCommand <= now) {
+            static const char COMMAND[] = "{\"command\":\"getVitals\"}";
+            wsAppendFrame(ws.out, WS_OP_TEXT, COMMAND, sizeof(COMMAND) - 1, true);
+            ws.commands.push_back(now);
+            dashboard.nextCommand = std::max(dashboard.nextCommand + interval(dashboard, options.commandRate), now);
+            if (!flush(ws)) fail(ws, now);
+        }
+        next = std::min(next, dashboard.nextCommand);
+    }
+
+    if (next != NEVER && (next < dashboard.wakeAt || dashboard.wakeAt <= now)) {
+        dashboard.wakeAt = next;
+        wakes.push(Wake(next, &dashboard));
+    }
+}
+
+void DashboardFleetWorker::connect(DashboardLink& link, uint64_t now) {
+    link.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (link.fd < 0) {
+        fail(link, now);
+        return;
+    }
+    int yes = 1;
+    setsockopt(link.fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    const sockaddr_in& address = options.device.address;
+    if (::connect(link.fd, (const sockaddr*)&address, sizeof(address)) != 0 && errno != EINPROGRESS) {
+        fail(link, now);
+        return;
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLET | EPOLLRDHUP;
+    event.data.ptr = &link;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, link.fd, &event);
+    link.state = DashboardLink::CONNECTING;
+    link.deadline = now + CONNECT_TIMEOUT;
+    link.in.clear();
+    link.out.clear();
+    link.poll = -1;
+    link.commands.clear();
+    link.decoder.reset();
+    link.minDelay = INT64_MAX;
+}
+
+void DashboardFleetWorker::fail(DashboardLink& link, uint64_t now) {
+    if (link.fd >= 0) {
+        epoll_ctl(epoll, EPOLL_CTL_DEL, link.fd, nullptr);
+        close(link.fd);
+        link.fd = -1;
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    if (link.state == DashboardLink::OPEN) stats.connected--;
+    stats.failures++;
+    link.state = DashboardLink::IDLE;
+    link.retryAt = now + RETRY_DELAY;
+    link.deadline = NEVER;
+}
+
+// The device closed the connection between requests, as it may; not a failure
+void DashboardFleetWorker::reconnect(DashboardLink& link, uint64_t now) {
+    epoll_ctl(epoll, EPOLL_CTL_DEL, link.fd, nullptr);
+    close(link.fd);
+    link.fd = -1;
+    link.state = DashboardLink::IDLE;
+    link.retryAt = now;
+    link.deadline = NEVER;
+    std::lock_guard<std::mutex> guard(lock);
+    stats.connected--;
+}
+
+bool DashboardFleetWorker::flush(DashboardLink& link) {
+    while (!link.out.empty()) {
+        ssize_t n = send(link.fd, link.out.data(), link.out.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+            link.out.erase(0, n);
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void DashboardFleetWorker::onEvent(DashboardLink& link, uint32_t events, uint64_t now) {
+    if (link.state == DashboardLink::IDLE) return;     // Failed earlier in this batch
+
+    if (link.state == DashboardLink::CONNECTING) {
+        if (!(events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) return;
+        int error = 0;
+        socklen_t length = sizeof(error);
+        getsockopt(link.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+        if (error != 0) {
+            fail(link, now);
+            return;
+        }
+        if (link.websocket) {
+            link.key = wsMakeKey();
+            wsAppendUpgradeRequest(link.out, host, options.device.path, link.key);
+            link.state = DashboardLink::HANDSHAKE;
+        } else {
+            link.state = DashboardLink::OPEN;
+            link.deadline = NEVER;
+            std::lock_guard<std::mutex> guard(lock);
+            stats.connects++;
+            stats.connected++;
+        }
+    }
+
+    bool keep = true;
+    bool closed = false;
+    char buffer[16384];
+    ssize_t n = 0;
+    while (keep && (n = recv(link.fd, buffer, sizeof(buffer), 0)) > 0) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stats.bytes += n;
+        }
+        if (link.websocket) {
+            keep = onWsData(link, buffer, n, now);
+        } else {
+            link.in.append(buffer, n);
+            keep = onHttpData(link, false, now);
+            if (link.state == DashboardLink::IDLE) return;  // Closed after the response
+        }
+    }
+    if (n == 0) closed = true;
+    if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) keep = false;
+    if (keep && closed && !link.websocket && link.state == DashboardLink::OPEN) {
+        // A response without a length ends with the connection
+        if (link.poll >= 0) keep = onHttpData(link, true, now);
+        if (link.state == DashboardLink::IDLE) return;
+        if (keep && link.poll < 0) {
+            reconnect(link, now);
+            return;
+        }
+    }
+    if (keep && !closed) keep = flush(link);
+    if (!keep || closed) fail(link, now);
+}
+
+bool DashboardFleetWorker::onHttpData(DashboardLink& link, bool atEnd, uint64_t now) {
+    HttpResponse response;
+    HttpParse result = HTTP_INCOMPLETE;
+    while (link.poll >= 0 && (result = httpReadResponse(link.in, atEnd, response)) == HTTP_DONE) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stats.responses++;
+            if (response.code < 200 || response.code > 299) stats.errors++;
+            stats.polls[link.poll].record(now - link.dueAt);
+        }
+        link.in.erase(0, response.length);
+        link.poll = -1;
+        link.deadline = NEVER;
+        if (!response.keepAlive) {
+            reconnect(link, now);
+            return true;
+        }
+    }
+    if (link.poll < 0 && !link.in.empty()) return false;   // Bytes nobody asked for
+    return link.poll < 0 || result != HTTP_BAD;
+}
+
+bool DashboardFleetWorker::onWsData(DashboardLink& link, const char* data, size_t length, uint64_t now) {
+    if (link.state == DashboardLink::OPEN) {
+        bool keep = true;
+        keep = link.decoder.feed(data, length, [&](uint8_t opcode, const char* payload, size_t payloadLength) {
+            if (opcode == WS_OP_CLOSE) keep = false;
+            onMessage(link, opcode, payload, payloadLength, now);
+        }) && keep;
+        return keep;
+    }
+
+    link.in.append(data, length);
+    size_t consumed;
+    WsHandshakeResult result = wsCheckUpgradeResponse(link.in, link.key, consumed);
+    if (result == WS_HANDSHAKE_FAILED) return false;
+    if (result == WS_HANDSHAKE_INCOMPLETE) return true;
+    link.state = DashboardLink::OPEN;
+    link.deadline = NEVER;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stats.connects++;
+        stats.connected++;
+    }
+
+    // New clients are on vitals and alerts (ws_clients.cpp); ask for the rest
+    static const struct {
+        WsChannel channel;
+        const char* name;
+    } NAMES[] = {{WS_CHANNEL_VITALS, "vitals"}, {WS_CHANNEL_WAVEFORM, "waveform"}, {WS_CHANNEL_STATUS, "status"}};
+    std::string subscribe, unsubscribe;
+    for (const auto& entry : NAMES) {
+        bool wanted = options.channels & entry.channel;
+        bool given = (WS_CHANNEL_VITALS | WS_CHANNEL_ALERTS) & entry.channel;
+        if (wanted == given) continue;
+        std::string& list = wanted ? subscribe : unsubscribe;
+        list += (list.empty() ? "\"" : ",\"") + std::string(entry.name) + "\"";
+    }
+    for (int i = 0; i < 2; i++) {
+        const std::string& list = i == 0 ? subscribe : unsubscribe;
+        if (list.empty()) continue;
+        std::string message = std::string("{\"type\":\"") + (i == 0 ? "subscribe" : "unsubscribe") +
+                              "\",\"data\":[" + list + "]}";
+        wsAppendFrame(link.out, WS_OP_TEXT, message.data(), message.size(), true);
+    }
+
+    std::string rest = link.in.substr(consumed);
+    link.in.clear();
+    return rest.empty() || onWsData(link, rest.data(), rest.size(), now);
+}
+
+void DashboardFleetWorker::onMessage(DashboardLink& link, uint8_t opcode, const char* payload, size_t length,
+                                     uint64_t now) {
+    if (opcode == WS_OP_PING) {
+        wsAppendFrame(link.out, WS_OP_PONG, payload, length, true);
+        return;
+    }
+    if (opcode != WS_OP_TEXT) return;
+
+    MonitorMessage message;
+    if (!decodeMonitorMessage(payload, length, message)) return;
+    std::lock_guard<std::mutex> guard(lock);
+    if (message.type == MonitorMessageType::OTHER) {
+        // Replies come in the order the commands went
+        if (!link.commands.empty()) {
+            stats.commands.record(now - link.commands.front());
+            link.commands.pop_front();
+        }
+        return;
+    }
+    stats.messages++;
+    if (options.epoch >= 0) {
+        int64_t sent = (options.epoch + (int64_t)message.timestamp) * 1000;
+        stats.messageLatency.record((int64_t)now > sent ? now - sent : 0);
+    } else {
+        int64_t delay = (int64_t)(now / 1000) - (int64_t)message.timestamp;
+        if (delay < link.minDelay) link.minDelay = delay;
+        stats.messageLatency.record((uint64_t)(delay - link.minDelay) * 1000);
+    }
+}
+
+// ==================== FLEET ====================
+DashboardFleet::DashboardFleet() {}
+
+DashboardFleet::~DashboardFleet() {
+    stop();
+}
+
+void DashboardFleet::start(const DashboardFleetOptions& options) {
+    int threads = options.threads < 1 ? 1 : options.threads;
+    for (int i = 0; i < threads; i++) workers.emplace_back(new DashboardFleetWorker(options));
+    uint64_t now = steadyMicros();
+    for (int i = 0; i < options.dashboards; i++) {
+        workers[i % threads]->add((uint32_t)i + 1, now + (uint64_t)i * 1000000 / options.dashboards);
+    }
+    for (auto& worker : workers) worker->start();
+}
+
+void DashboardFleet::stop() {
+    for (auto& worker : workers) worker->stop();
+    workers.clear();
+}
+
+void DashboardFleet::collect(DashboardFleetStats& into, bool reset) {
+    for (auto& worker : workers) worker->collect(into, reset);
+}
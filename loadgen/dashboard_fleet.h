@@ -0,0 +1,75 @@
+#ifndef LOADGEN_DASHBOARD_FLEET_H
+#define LOADGEN_DASHBOARD_FLEET_H
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "latency_histogram.h"
+#include "../gateway/monitor_link.h"
+
+// N dashboard clients against one device: the monitor firmware (on the
+// board or the native build's --http), the gateway's merged feed, or
+// MonitorFleet. Each dashboard keeps an HTTP connection on which it polls
+// its paths, one request at a time, and optionally a WebSocket on which
+// it subscribes and sends getVitals commands.
+//
+// A poll is timed from when it was due, not from when it could be sent, so
+// a server that falls behind is charged for the queue it builds. A command
+// is timed to its reply. A WebSocket message is timed from its timestamp:
+// exactly when the fleet's epoch is known (the monitors are in this
+// process), otherwise as the delay beyond the fastest message of that
+// connection, as the gateway measures lag. Timestamps are in ms.
+
+struct DashboardPoll {
+    std::string path;
+    float rate = 1;                 // Requests per second per dashboard
+};
+
+struct DashboardFleetOptions {
+    int dashboards = 10;
+    MonitorTarget device;           // Host, port and WebSocket path
+    int threads = 2;
+    std::vector<DashboardPoll> polls;
+    bool websocket = false;
+    uint8_t channels = WS_CHANNEL_VITALS | WS_CHANNEL_ALERTS;
+    float commandRate = 0;          // getVitals per second per dashboard
+    float jitter = 0;               // Each interval varies by up to this fraction either way
+    int64_t epoch = -1;             // Steady-clock ms the device's timestamps count from, if known
+};
+
+// Sums over the fleet since the last reset
+struct DashboardFleetStats {
+    int connected = 0;              // Connections now open, HTTP and WebSocket
+    uint64_t connects = 0;
+    uint64_t failures = 0;          // Connections that failed or were closed by the device
+    uint64_t responses = 0;
+    uint64_t errors = 0;            // Responses other than 2xx
+    uint64_t late = 0;              // Polls skipped, more than a second overdue
+    uint64_t messages = 0;
+    uint64_t bytes = 0;             // Received
+    std::vector<LatencyHistogram> polls;    // One per DashboardPoll
+    LatencyHistogram commands;
+    LatencyHistogram messageLatency;
+
+    void add(const DashboardFleetStats& other);
+};
+
+class DashboardFleetWorker;
+
+class DashboardFleet {
+private:
+    std::vector<std::unique_ptr<DashboardFleetWorker>> workers;
+
+public:
+    DashboardFleet();
+    ~DashboardFleet();
+
+    // Connections open over the first second
+    void start(const DashboardFleetOptions& options);
+    void stop();
+
+    void collect(DashboardFleetStats& into, bool reset);
+};
+
+#endif
@@ -0,0 +1,109 @@
+#include "http_messages.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+#include "../gateway/ws_protocol.h"
+
+static const size_t MAX_HEAD = 8192;
+
+static bool headerIs(const std::string& in, size_t length, const char* name, const char* value) {
+    return strcasecmp(httpHeaderValue(in, length, name).c_str(), value) == 0;
+}
+
+// ==================== REQUESTS ====================
+HttpParse httpReadRequest(const std::string& in, HttpRequest& request) {
+    size_t end = in.find("\r\n\r\n");
+    if (end == std::string::npos) return in.size() > MAX_HEAD ? HTTP_BAD : HTTP_INCOMPLETE;
+
+    size_t methodEnd = in.find(' ');
+    size_t targetEnd = methodEnd == std::string::npos ? methodEnd : in.find(' ', methodEnd + 1);
+    if (targetEnd == std::string::npos || targetEnd > end) return HTTP_BAD;
+    request.method = in.substr(0, methodEnd);
+    request.target = in.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+    request.wsKey = httpHeaderValue(in, end + 2, "Sec-WebSocket-Key");
+    // HTTP/1.1 keeps the connection unless told otherwise; 1.0 the reverse
+    bool http10 = in.compare(targetEnd + 1, 8, "HTTP/1.0") == 0;
+    request.keepAlive = http10 ? headerIs(in, end + 2, "Connection", "keep-alive")
+                               : !headerIs(in, end + 2, "Connection", "close");
+
+    std::string contentLength = httpHeaderValue(in, end + 2, "Content-Length");
+    request.length = end + 4 + (contentLength.empty() ? 0 : strtoul(contentLength.c_str(), nullptr, 10));
+    return in.size() >= request.length ? HTTP_DONE : HTTP_INCOMPLETE;
+}
+
+void httpAppendResponse(std::string& out, int code, const char* contentType, const char* body, size_t length,
+                        bool keepAlive) {
+    const char* reason = code == 200 ? "OK" : code == 404 ? "Not Found" : code == 405 ? "Method Not Allowed" : "Error";
+    char head[256];
+    int n = snprintf(head, sizeof(head),
+                     "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %u\r\nConnection: %s\r\n\r\n",
+                     code, reason, contentType, (unsigned)length, keepAlive ? "keep-alive" : "close");
+    out.append(head, n);
+    out.append(body, length);
+}
+
+void httpAppendGet(std::string& out, const std::string& host, const std::string& target) {
+    out += "GET " + target + " HTTP/1.1\r\nHost: " + host + "\r\nConnection: keep-alive\r\n\r\n";
+}
+
+// ==================== RESPONSES ====================
+// A chunked body starting at `at`: its decoded length, and where the
+// response ends, trailer included
+static HttpParse chunkedLength(const std::string& in, size_t at, size_t& bodyLength, size_t& length) {
+    bodyLength = 0;
+    for (;;) {
+        size_t lineEnd = in.find("\r\n", at);
+        if (lineEnd == std::string::npos) return HTTP_INCOMPLETE;
+        char* stop;
+        unsigned long size = strtoul(in.c_str() + at, &stop, 16);
+        if (stop == in.c_str() + at) return HTTP_BAD;
+        at = lineEnd + 2;
+        if (size == 0) {
+            // Trailer headers, if any, end with a blank line
+            size_t trailerEnd = in.find("\r\n", at);
+            while (trailerEnd != std::string::npos && trailerEnd != at) {
+                at = trailerEnd + 2;
+                trailerEnd = in.find("\r\n", at);
+            }
+            if (trailerEnd == std::string::npos) return HTTP_INCOMPLETE;
+            length = at + 2;
+            return HTTP_DONE;
+        }
+        if (in.size() < at + size + 2) return HTTP_INCOMPLETE;
+        bodyLength += size;
+        at += size + 2;
+    }
+}
+
+HttpParse httpReadResponse(const std::string& in, bool atEnd, HttpResponse& response) {
+    size_t end = in.find("\r\n\r\n");
+    if (end == std::string::npos) {
+        if (atEnd && !in.empty()) return HTTP_BAD;
+        return in.size() > MAX_HEAD ? HTTP_BAD : HTTP_INCOMPLETE;
+    }
+    if (in.compare(0, 5, "HTTP/") != 0) return HTTP_BAD;
+    size_t space = in.find(' ');
+    if (space == std::string::npos || space > end) return HTTP_BAD;
+    response.code = atoi(in.c_str() + space + 1);
+    bool http10 = in.compare(0, 8, "HTTP/1.0") == 0;
+    response.keepAlive = http10 ? headerIs(in, end + 2, "Connection", "keep-alive")
+                                : !headerIs(in, end + 2, "Connection", "close");
+    size_t body = end + 4;
+
+    if (headerIs(in, end + 2, "Transfer-Encoding", "chunked")) {
+        return chunkedLength(in, body, response.bodyLength, response.length);
+    }
+    std::string contentLength = httpHeaderValue(in, end + 2, "Content-Length");
+    if (contentLength.empty() && (response.code == 204 || response.code == 304)) contentLength = "0";
+    if (!contentLength.empty()) {
+        response.bodyLength = strtoul(contentLength.c_str(), nullptr, 10);
+        response.length = body + response.bodyLength;
+        return in.size() >= response.length ? HTTP_DONE : HTTP_INCOMPLETE;
+    }
+    // Neither: the body runs to the end of the connection
+    if (!atEnd) return HTTP_INCOMPLETE;
+    response.keepAlive = false;
+    response.bodyLength = in.size() - body;
+    response.length = in.size();
+    return HTTP_DONE;
+}
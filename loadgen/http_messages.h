@@ -0,0 +1,46 @@
+#ifndef LOADGEN_HTTP_MESSAGES_H
+#define LOADGEN_HTTP_MESSAGES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+// Just enough HTTP/1.1 for the load generator: the requests the
+// impersonated monitors serve and the responses the dashboards read. One
+// request in flight per connection, as browsers and the ESP32 servers
+// handle them.
+
+enum HttpParse {
+    HTTP_INCOMPLETE,            // Need more bytes
+    HTTP_DONE,
+    HTTP_BAD
+};
+
+struct HttpRequest {
+    std::string method;
+    std::string target;         // path?query
+    std::string wsKey;          // Sec-WebSocket-Key of an upgrade, else empty
+    bool keepAlive;
+    size_t length;              // Head and body, to consume from the input
+};
+
+// The request at the start of `in`; a body is skipped over
+HttpParse httpReadRequest(const std::string& in, HttpRequest& request);
+void httpAppendResponse(std::string& out, int code, const char* contentType, const char* body, size_t length,
+                        bool keepAlive);
+
+// GET with keep-alive
+void httpAppendGet(std::string& out, const std::string& host, const std::string& target);
+
+struct HttpResponse {
+    int code;
+    size_t bodyLength;
+    bool keepAlive;
+    size_t length;              // To consume from the input
+};
+
+// The response at the start of `in`: Content-Length, chunked, or (with
+// `atEnd`, the peer having closed) everything up to the end
+HttpParse httpReadResponse(const std::string& in, bool atEnd, HttpResponse& response);
+
+#endif
@@ -0,0 +1,62 @@
+#include "latency_histogram.h"
+#include <string.h>
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+int LatencyHistogram::bucketOf(uint64_t us) {
+    if (us < 2 * SUB_BUCKETS) return (int)us;
+    int top = 63 - __builtin_clzll(us);
+    int shift = top - SUB_BITS;
+    int bucket = (shift + 1) * SUB_BUCKETS + (int)(us >> shift) - SUB_BUCKETS;
+    return bucket < BUCKETS ? bucket : BUCKETS - 1;
+}
+
+uint64_t LatencyHistogram::valueOf(int bucket) {
+    if (bucket < 2 * SUB_BUCKETS) return bucket;
+    int shift = bucket / SUB_BUCKETS - 1;
+    uint64_t low = (uint64_t)(bucket % SUB_BUCKETS + SUB_BUCKETS) << shift;
+    return low + ((1ull << shift) >> 1);
+}
+
+void LatencyHistogram::record(uint64_t us) {
+    counts[bucketOf(us)]++;
+    count++;
+    sum += us;
+    if (us > max) max = us;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int i = 0; i < BUCKETS; i++) counts[i] += other.counts[i];
+    count += other.count;
+    sum += other.sum;
+    if (other.max > max) max = other.max;
+}
+
+void LatencyHistogram::reset() {
+    memset(counts, 0, sizeof(counts));
+    count = 0;
+    sum = 0;
+    max = 0;
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const {
+    if (count == 0) return 0;
+    uint64_t rank = (uint64_t)(fraction * (count - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            uint64_t value = valueOf(i);
+            return value < max ? value : max;
+        }
+    }
+    return max;
+}
+
+void LatencyHistogram::writeJson(FILE* out) const {
+    fprintf(out, "{\"count\":%llu,\"meanMs\":%.3f,\"p50Ms\":%.3f,\"p90Ms\":%.3f,\"p99Ms\":%.3f,\"p999Ms\":%.3f,\"maxMs\":%.3f}",
+            (unsigned long long)count, getMean() / 1e3, percentile(0.5) / 1e3, percentile(0.9) / 1e3,
+            percentile(0.99) / 1e3, percentile(0.999) / 1e3, max / 1e3);
+}
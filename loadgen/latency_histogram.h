@@ -0,0 +1,45 @@
+#ifndef LOADGEN_LATENCY_HISTOGRAM_H
+#define LOADGEN_LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Latencies in us, in log-linear buckets: exact below 32 us, then 16
+// buckets per doubling, so a percentile is within 1/16 of the true value
+// however long the run. Fixed size, so every worker keeps its own and the
+// reporter merges them.
+
+class LatencyHistogram {
+public:
+    static const int SUB_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BITS;
+    static const int BUCKETS = 40 * SUB_BUCKETS;    // Up to 2^40 us
+
+private:
+    uint64_t counts[BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+
+    static int bucketOf(uint64_t us);
+    // Midpoint of a bucket
+    static uint64_t valueOf(int bucket);
+
+public:
+    LatencyHistogram();
+
+    void record(uint64_t us);
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    uint64_t getCount() const { return count; }
+    uint64_t getMax() const { return max; }
+    double getMean() const { return count > 0 ? (double)sum / count : 0; }
+    // us at `fraction` (0.5 = median); 0 if empty
+    uint64_t percentile(double fraction) const;
+
+    // {"count":N,"meanMs":..,"p50Ms":..,"p90Ms":..,"p99Ms":..,"p999Ms":..,"maxMs":..}
+    void writeJson(FILE* out) const;
+};
+
+#endif
@@ -0,0 +1,348 @@
+/*
+ * Load generator: finds out what the dashboard, the gateway and the
+ * monitor's own web server can take before more beds go on them.
+ *
+ * --monitors N impersonates N monitors, each on a port of its own from
+ * --base-port, speaking the firmware's API (monitor_fleet.h): /api/vitals,
+ * /api/status and /ws, with the real estimator and alarm rules behind
+ * them. Point a dashboard or the gateway at them:
+ *
+ *   pio run -e loadgen && .pio/build/loadgen/program --monitors 300 --seconds 600
+ *   .pio/build/gateway/program --monitors beds.txt          # 127.0.0.1:9000 ... :9299
+ *
+ * --dashboards N turns it around: N dashboard clients against one device
+ * (dashboard_fleet.h), polling HTTP paths and, with --ws, holding a
+ * WebSocket. Against the native build serving real sockets:
+ *
+ *   .pio/build/native/program --wifi ward:secret --http 8081 --seconds 120 --quiet &
+ *   .pio/build/loadgen/program --dashboards 50 --device 127.0.0.1:8081 \
+ *       --poll /api/status@1 --poll /data@2 --seconds 60 --json native.json
+ *
+ * Both at once measures a gateway end to end: the monitors' timestamps
+ * count from this process's clock, so every message is timed exactly from
+ * when its monitor sent it to when the feed delivered it:
+ *
+ *   .pio/build/loadgen/program --monitors 300 --dashboards 10 --device 127.0.0.1:8090/ \
+ *       --ws --channels all --seconds 60
+ *
+ * Every --report seconds a line goes to stderr; --json writes the whole
+ * run's latency percentiles, and --max-p99 turns them into the exit
+ * status. Linux only: the workers are epoll loops.
+ *
+ * With g++, from the repository root, once PlatformIO has fetched the
+ * MAX3010x library (pio pkg install -e loadgen):
+ *   MAXIM=$(ls -d .pio/libdeps/loadgen/SparkFun*)/src
+ *   g++ -O2 -std=gnu++17 -DARDUINO=10819 -Inative -I. -I"$MAXIM" -pthread -o loadgen loadgen/loadgen.cpp \
+ *       loadgen/monitor_fleet.cpp loadgen/dashboard_fleet.cpp loadgen/http_messages.cpp \
+ *       loadgen/latency_histogram.cpp gateway/ws_protocol.cpp gateway/monitor_feed.cpp \
+ *       gateway/monitor_link.cpp gateway/feed_server.cpp gateway/sim_bed.cpp store/vitals_store.cpp \
+ *       store/gorilla.cpp "$MAXIM"/spo2_algorithm.cpp vitals_pipeline.cpp signal_generator.cpp \
+ *       ws_clients.cpp ws_frame_pool.cpp
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "monitor_fleet.h"
+#include "dashboard_fleet.h"
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+    stopRequested = 1;
+}
+
+static void usage() {
+    fprintf(stderr,
+        "Usage: loadgen [options]\n"
+        "Monitors:\n"
+        "  --monitors N         impersonate N monitors, on consecutive ports\n"
+        "  --base-port P        port of the first monitor (default 9000)\n"
+        "  --bind ADDR          address they listen on (default 0.0.0.0)\n"
+        "  --vitals-rate HZ     vitals messages per second (default 1)\n"
+        "  --waveform-rate HZ   waveform frames per second (default 4)\n"
+        "  --status-interval S  seconds between status messages (default 5)\n"
+        "Dashboards:\n"
+        "  --dashboards N       run N dashboard clients against --device\n"
+        "  --device SPEC        HOST[:PORT][/PATH]; PATH is the WebSocket's (default /ws)\n"
+        "  --poll PATH[@HZ]     poll PATH, HZ times a second (default 1); repeatable.\n"
+        "                       Default /api/status@1 unless --ws is given\n"
+        "  --ws                 each dashboard also holds a WebSocket\n"
+        "  --channels LIST      its channels: vitals,alerts,waveform,status or all\n"
+        "                       (default vitals,alerts)\n"
+        "  --command-rate HZ    getVitals round trips per second on it (default 0)\n"
+        "Both:\n"
+        "  --jitter F           vary every interval by up to F either way (default 0.1)\n"
+        "  --threads N          worker threads for each side (default 2)\n"
+        "  --seconds S          run time (default 30)\n"
+        "  --report S           seconds between stats lines (default 5)\n"
+        "  --json FILE          write the run's totals and latency percentiles to FILE\n"
+        "  --max-p99 MS         exit with status 1 if any p99 latency exceeded MS\n");
+    exit(2);
+}
+
+static uint64_t steadyMillis() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static bool parseChannels(const char* text, uint8_t& channels) {
+    channels = WS_CHANNEL_ALERTS;
+    std::string list = text;
+    size_t at = 0;
+    while (at <= list.size()) {
+        size_t comma = list.find(',', at);
+        if (comma == std::string::npos) comma = list.size();
+        uint8_t channel = WsClientTable::parseChannel(list.substr(at, comma - at).c_str());
+        if (channel == 0) return false;
+        channels |= channel;
+        at = comma + 1;
+    }
+    return true;
+}
+
+static double ms(uint64_t us) {
+    return us / 1000.0;
+}
+
+// ==================== REPORTING ====================
+static void reportLine(const MonitorFleetStats* monitors, const DashboardFleetStats* dashboards,
+                       const std::vector<DashboardPoll>& polls, double seconds) {
+    std::string line = "loadgen:";
+    char part[256];
+    if (monitors) {
+        snprintf(part, sizeof(part),
+                 " monitors %d clients, %.0f req/s (p99 %.1f ms), %.0f msg/s (queued p99 %.1f ms), "
+                 "%.0f KB/s, %llu dropped;",
+                 monitors->clients, monitors->httpRequests / seconds, ms(monitors->http.percentile(0.99)),
+                 monitors->messages / seconds, ms(monitors->queue.percentile(0.99)), monitors->bytes / seconds / 1024,
+                 (unsigned long long)monitors->dropped);
+        line += part;
+    }
+    if (dashboards) {
+        snprintf(part, sizeof(part), " dashboards %d connected, %llu failures, %.0f resp/s, %llu errors",
+                 dashboards->connected, (unsigned long long)dashboards->failures, dashboards->responses / seconds,
+                 (unsigned long long)dashboards->errors);
+        line += part;
+        for (size_t i = 0; i < polls.size() && i < dashboards->polls.size(); i++) {
+            const LatencyHistogram& h = dashboards->polls[i];
+            snprintf(part, sizeof(part), ", %s p50 %.1f p99 %.1f ms", polls[i].path.c_str(), ms(h.percentile(0.5)),
+                     ms(h.percentile(0.99)));
+            line += part;
+        }
+        if (dashboards->commands.getCount() > 0) {
+            snprintf(part, sizeof(part), ", getVitals p50 %.1f p99 %.1f ms", ms(dashboards->commands.percentile(0.5)),
+                     ms(dashboards->commands.percentile(0.99)));
+            line += part;
+        }
+        if (dashboards->messages > 0) {
+            snprintf(part, sizeof(part), ", %.0f msg/s p50 %.1f p99 %.1f ms", dashboards->messages / seconds,
+                     ms(dashboards->messageLatency.percentile(0.5)), ms(dashboards->messageLatency.percentile(0.99)));
+            line += part;
+        }
+    }
+    if (line.back() == ';') line.pop_back();
+    fprintf(stderr, "%s\n", line.c_str());
+}
+
+static bool writeJson(const char* path, const MonitorFleetStats* monitors, const DashboardFleetStats* dashboards,
+                      const std::vector<DashboardPoll>& polls, double seconds) {
+    FILE* out = fopen(path, "w");
+    if (!out) return false;
+    fprintf(out, "{\"seconds\":%.1f", seconds);
+    if (monitors) {
+        fprintf(out,
+                ",\"monitors\":{\"clients\":%d,\"httpRequests\":%llu,\"messages\":%llu,\"messagesPerSecond\":%.1f,"
+                "\"bytesPerSecond\":%.0f,\"dropped\":%llu,\"http\":",
+                monitors->clients, (unsigned long long)monitors->httpRequests, (unsigned long long)monitors->messages,
+                monitors->messages / seconds, monitors->bytes / seconds, (unsigned long long)monitors->dropped);
+        monitors->http.writeJson(out);
+        fprintf(out, ",\"queue\":");
+        monitors->queue.writeJson(out);
+        fprintf(out, "}");
+    }
+    if (dashboards) {
+        fprintf(out,
+                ",\"dashboards\":{\"connects\":%llu,\"failures\":%llu,\"responses\":%llu,\"errors\":%llu,"
+                "\"late\":%llu,\"messages\":%llu,\"bytesPerSecond\":%.0f,\"polls\":[",
+                (unsigned long long)dashboards->connects, (unsigned long long)dashboards->failures,
+                (unsigned long long)dashboards->responses, (unsigned long long)dashboards->errors,
+                (unsigned long long)dashboards->late, (unsigned long long)dashboards->messages,
+                dashboards->bytes / seconds);
+        for (size_t i = 0; i < polls.size(); i++) {
+            fprintf(out, "%s{\"path\":\"%s\",\"rate\":%.2f,\"latency\":", i > 0 ? "," : "", polls[i].path.c_str(),
+                    polls[i].rate);
+            dashboards->polls[i].writeJson(out);
+            fprintf(out, "}");
+        }
+        fprintf(out, "],\"commands\":");
+        dashboards->commands.writeJson(out);
+        fprintf(out, ",\"messageLatency\":");
+        dashboards->messageLatency.writeJson(out);
+        fprintf(out, "}");
+    }
+    fprintf(out, "}\n");
+    fclose(out);
+    return true;
+}
+
+// ==================== MAIN ====================
+int main(int argc, char** argv) {
+    MonitorFleetOptions monitorOptions;
+    monitorOptions.monitors = 0;
+    DashboardFleetOptions dashboardOptions;
+    dashboardOptions.dashboards = 0;
+    bool hasDevice = false;
+    float jitter = 0.1f;
+    int threads = 2;
+    double duration = 30;
+    double reportInterval = 5;
+    const char* jsonPath = nullptr;
+    double maxP99 = -1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--ws") {
+            dashboardOptions.websocket = true;
+            continue;
+        }
+        if (i + 1 >= argc) usage();
+        const char* value = argv[++i];
+        if (option == "--monitors") monitorOptions.monitors = atoi(value);
+        else if (option == "--base-port") monitorOptions.basePort = (uint16_t)atoi(value);
+        else if (option == "--bind") monitorOptions.bindAddress = value;
+        else if (option == "--vitals-rate") monitorOptions.rates.vitalsRate = atof(value);
+        else if (option == "--waveform-rate") monitorOptions.rates.waveformRate = atof(value);
+        else if (option == "--status-interval") monitorOptions.rates.statusInterval = atof(value);
+        else if (option == "--dashboards") dashboardOptions.dashboards = atoi(value);
+        else if (option == "--device") {
+            if (!parseMonitorTarget(value, dashboardOptions.device)) usage();
+            hasDevice = true;
+        } else if (option == "--poll") {
+            DashboardPoll poll;
+            poll.path = value;
+            size_t at = poll.path.find('@');
+            if (at != std::string::npos) {
+                poll.rate = atof(poll.path.c_str() + at + 1);
+                poll.path.erase(at);
+            }
+            if (poll.path.empty() || poll.path[0] != '/' || poll.rate <= 0) usage();
+            dashboardOptions.polls.push_back(poll);
+        } else if (option == "--channels") {
+            if (!parseChannels(value, dashboardOptions.channels)) usage();
+        } else if (option == "--command-rate") dashboardOptions.commandRate = atof(value);
+        else if (option == "--jitter") jitter = atof(value);
+        else if (option == "--threads") threads = atoi(value);
+        else if (option == "--seconds") duration = atof(value);
+        else if (option == "--report") reportInterval = atof(value);
+        else if (option == "--json") jsonPath = value;
+        else if (option == "--max-p99") maxP99 = atof(value);
+        else usage();
+    }
+    bool runMonitors = monitorOptions.monitors > 0;
+    bool runDashboards = dashboardOptions.dashboards > 0;
+    if ((!runMonitors && !runDashboards) || (runDashboards && !hasDevice) || threads < 1 || duration <= 0 ||
+        reportInterval <= 0 || monitorOptions.rates.vitalsRate <= 0 || monitorOptions.rates.waveformRate <= 0 ||
+        monitorOptions.rates.statusInterval <= 0 || jitter < 0 || jitter >= 1 ||
+        monitorOptions.basePort + monitorOptions.monitors > 65536) {
+        usage();
+    }
+    if (dashboardOptions.polls.empty() && !dashboardOptions.websocket) {
+        DashboardPoll poll;
+        poll.path = "/api/status";
+        dashboardOptions.polls.push_back(poll);
+    }
+    monitorOptions.threads = dashboardOptions.threads = threads;
+    monitorOptions.rates.jitter = dashboardOptions.jitter = jitter;
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    uint64_t epoch = steadyMillis();
+    MonitorFleet monitors;
+    if (runMonitors) {
+        if (!monitors.start(monitorOptions, epoch)) return 1;
+        fprintf(stderr, "loadgen: %d monitors on %s:%u-%u, %d threads\n", monitorOptions.monitors,
+                monitorOptions.bindAddress.c_str(), monitorOptions.basePort,
+                monitorOptions.basePort + monitorOptions.monitors - 1, threads);
+        // Their clocks are ours, so delivery can be timed exactly
+        dashboardOptions.epoch = (int64_t)epoch;
+    }
+
+    DashboardFleet dashboards;
+    if (runDashboards) {
+        if (!resolveMonitorTarget(dashboardOptions.device)) {
+            fprintf(stderr, "Cannot resolve %s\n", dashboardOptions.device.host.c_str());
+            return 1;
+        }
+        dashboards.start(dashboardOptions);
+        fprintf(stderr, "loadgen: %d dashboards against %s:%u, %d threads\n", dashboardOptions.dashboards,
+                dashboardOptions.device.host.c_str(), dashboardOptions.device.port, threads);
+    }
+
+    MonitorFleetStats monitorTotals;
+    DashboardFleetStats dashboardTotals;
+    uint64_t started = steadyMillis();
+    uint64_t lastReport = started;
+    while (!stopRequested) {
+        usleep(100 * 1000);
+        uint64_t now = steadyMillis();
+        bool finished = now - started >= duration * 1000;
+        if (now - lastReport < reportInterval * 1000 && !finished) continue;
+
+        double seconds = (now - lastReport) / 1000.0;
+        MonitorFleetStats monitorPeriod;
+        DashboardFleetStats dashboardPeriod;
+        monitors.collect(monitorPeriod, true);
+        dashboards.collect(dashboardPeriod, true);
+        reportLine(runMonitors ? &monitorPeriod : nullptr, runDashboards ? &dashboardPeriod : nullptr,
+                   dashboardOptions.polls, seconds);
+        // Gauges are the latest, not a sum over periods
+        monitorPeriod.clients -= monitorTotals.clients;
+        dashboardPeriod.connected -= dashboardTotals.connected;
+        monitorTotals.add(monitorPeriod);
+        dashboardTotals.add(dashboardPeriod);
+        lastReport = now;
+        if (finished) break;
+    }
+
+    double seconds = (steadyMillis() - started) / 1000.0;
+    dashboards.stop();
+    monitors.stop();
+    if (jsonPath && !writeJson(jsonPath, runMonitors ? &monitorTotals : nullptr,
+                               runDashboards ? &dashboardTotals : nullptr, dashboardOptions.polls, seconds)) {
+        fprintf(stderr, "Could not write %s\n", jsonPath);
+    }
+
+    if (maxP99 >= 0) {
+        std::vector<std::pair<std::string, const LatencyHistogram*>> measured;
+        if (runMonitors) {
+            measured.push_back(std::make_pair("monitor http", &monitorTotals.http));
+            measured.push_back(std::make_pair("monitor queue", &monitorTotals.queue));
+        }
+        if (runDashboards) {
+            for (size_t i = 0; i < dashboardOptions.polls.size(); i++) {
+                measured.push_back(std::make_pair(dashboardOptions.polls[i].path, &dashboardTotals.polls[i]));
+            }
+            measured.push_back(std::make_pair("getVitals", &dashboardTotals.commands));
+            measured.push_back(std::make_pair("messages", &dashboardTotals.messageLatency));
+        }
+        bool over = false;
+        for (const auto& entry : measured) {
+            if (entry.second->getCount() == 0) continue;
+            double p99 = ms(entry.second->percentile(0.99));
+            bool exceeded = p99 > maxP99;
+            fprintf(stderr, "p99 %s %.1f ms (budget %.1f ms): %s\n", entry.first.c_str(), p99, maxP99,
+                    exceeded ? "over" : "ok");
+            over = over || exceeded;
+        }
+        if (over) return 1;
+    }
+    return 0;
+}
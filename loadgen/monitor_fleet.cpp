@@ -0,0 +1,468 @@
+#include "monitor_fleet.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include "http_messages.h"
+#include "../gateway/ws_protocol.h"
+#include "../gateway/monitor_feed.h"
+
+static const uint32_t TICK_MS = 10;
+static const size_t MAX_BACKLOG = 1024 * 1024;      // Unsent bytes before a client is dropped
+
+static uint64_t steadyMicros() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void MonitorFleetStats::add(const MonitorFleetStats& other) {
+    clients += other.clients;
+    httpRequests += other.httpRequests;
+    messages += other.messages;
+    bytes += other.bytes;
+    dropped += other.dropped;
+    http.merge(other.http);
+    queue.merge(other.queue);
+}
+
+// ==================== CONNECTIONS ====================
+// epoll carries a pointer to either; `kind` comes first in both
+enum FleetHandleKind : uint8_t { FLEET_MONITOR, FLEET_CONNECTION };
+
+struct FleetMonitor;
+
+struct FleetConnection {
+    FleetHandleKind kind = FLEET_CONNECTION;
+    int fd;
+    FleetMonitor* monitor;
+    bool websocket = false;
+    bool closing = false;
+    std::string in;                 // Until the upgrade, HTTP requests
+    std::string out;
+    uint64_t written = 0;           // Bytes ever sent
+    // Where a message or response ends in the stream, and when it was
+    // queued; timed when the socket takes its last byte
+    struct Mark {
+        uint64_t end;
+        uint64_t at;
+        bool http;
+    };
+    std::deque<Mark> marks;
+    WsDecoder decoder;
+    uint8_t channels = WS_CHANNEL_VITALS | WS_CHANNEL_ALERTS;
+};
+
+struct FleetMonitor {
+    FleetHandleKind kind = FLEET_MONITOR;
+    int listener = -1;
+    uint16_t port;
+    SimBed bed;
+    std::vector<FleetConnection*> clients;  // WebSocket ones
+};
+
+// ==================== WORKER ====================
+class MonitorFleetWorker {
+private:
+    std::vector<std::unique_ptr<FleetMonitor>> monitors;
+    std::unordered_set<FleetConnection*> connections;
+    std::vector<FleetConnection*> dropped;
+    uint64_t epoch;
+    int epoll;
+    int wakeup;
+    int timer;
+    std::thread thread;
+    std::string frame;
+    MonitorFleetStats local;        // This tick's, then added to shared
+    std::mutex lock;
+    MonitorFleetStats shared;
+
+    uint32_t deviceNow() const { return (uint32_t)(steadyMicros() / 1000 - epoch); }
+    void run();
+    void accept(FleetMonitor& monitor);
+    void onEvent(FleetConnection& connection);
+    void onRequest(FleetConnection& connection, const HttpRequest& request, uint64_t now);
+    void onMessage(FleetConnection& connection, uint8_t opcode, const char* payload, size_t length, uint64_t now);
+    void queue(FleetConnection& connection, uint64_t now, bool http);
+    bool flush(FleetConnection& connection);
+    void drop(FleetConnection& connection);
+    void tick();
+
+public:
+    MonitorFleetWorker() : epoch(0), epoll(-1), wakeup(-1), timer(-1) {}
+    ~MonitorFleetWorker();
+
+    // Before start(); false if the port could not be bound
+    bool listen(uint32_t bed, const std::string& address, uint16_t port, const SimBedRates& rates, uint64_t epochMs);
+    void start();
+    void stop();
+    void collect(MonitorFleetStats& into, bool reset);
+};
+
+bool MonitorFleetWorker::listen(uint32_t bed, const std::string& address, uint16_t port, const SimBedRates& rates,
+                                uint64_t epochMs) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (fd < 0) return false;
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in bound = {};
+    bound.sin_family = AF_INET;
+    bound.sin_port = htons(port);
+    if (inet_pton(AF_INET, address.c_str(), &bound.sin_addr) != 1 ||
+        bind(fd, (sockaddr*)&bound, sizeof(bound)) != 0 || ::listen(fd, 128) != 0) {
+        close(fd);
+        return false;
+    }
+    epoch = epochMs;
+    std::unique_ptr<FleetMonitor> monitor(new FleetMonitor());
+    monitor->listener = fd;
+    monitor->port = port;
+    monitor->bed.admit(bed, deviceNow(), rates);
+    monitors.push_back(std::move(monitor));
+    return true;
+}
+
+MonitorFleetWorker::~MonitorFleetWorker() {
+    stop();
+    for (auto& monitor : monitors) {
+        if (monitor->listener >= 0) close(monitor->listener);
+    }
+}
+
+void MonitorFleetWorker::start() {
+    epoll = epoll_create1(0);
+    wakeup = eventfd(0, EFD_NONBLOCK);
+    timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    itimerspec period = {};
+    period.it_interval.tv_nsec = TICK_MS * 1000000L;
+    period.it_value = period.it_interval;
+    timerfd_settime(timer, 0, &period, nullptr);
+
+    // data.u64 for the fixed descriptors, data.ptr for monitors and
+    // connections: the fixed ones are told apart by value, descriptors
+    // being small
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = (uint64_t)wakeup;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, wakeup, &event);
+    event.data.u64 = (uint64_t)timer;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, timer, &event);
+    for (auto& monitor : monitors) {
+        event.data.ptr = monitor.get();
+        epoll_ctl(epoll, EPOLL_CTL_ADD, monitor->listener, &event);
+    }
+    thread = std::thread([this] { run(); });
+}
+
+void MonitorFleetWorker::stop() {
+    if (!thread.joinable()) return;
+    uint64_t one = 1;
+    (void)!write(wakeup, &one, sizeof(one));
+    thread.join();
+    for (FleetConnection* connection : connections) {
+        if (!connection->closing) close(connection->fd);
+        delete connection;
+    }
+    connections.clear();
+    for (auto& monitor : monitors) {
+        close(monitor->listener);
+        monitor->listener = -1;
+    }
+    close(timer);
+    close(wakeup);
+    close(epoll);
+}
+
+void MonitorFleetWorker::collect(MonitorFleetStats& into, bool reset) {
+    std::lock_guard<std::mutex> guard(lock);
+    into.add(shared);
+    if (reset) {
+        int clients = shared.clients;
+        shared = MonitorFleetStats();
+        shared.clients = clients;
+    }
+}
+
+void MonitorFleetWorker::run() {
+    epoll_event events[256];
+    bool running = true;
+    while (running) {
+        int ready = epoll_wait(epoll, events, 256, -1);
+        for (int i = 0; i < ready; i++) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == (uint64_t)wakeup) {
+                running = false;
+            } else if (tag == (uint64_t)timer) {
+                uint64_t expirations;
+                (void)!read(timer, &expirations, sizeof(expirations));
+                tick();
+            } else if (*(FleetHandleKind*)events[i].data.ptr == FLEET_MONITOR) {
+                accept(*(FleetMonitor*)events[i].data.ptr);
+            } else {
+                FleetConnection* connection = (FleetConnection*)events[i].data.ptr;
+                if (!connection->closing) onEvent(*connection);
+            }
+        }
+        for (FleetConnection* connection : dropped) {
+            connections.erase(connection);
+            delete connection;
+        }
+        dropped.clear();
+    }
+}
+
+void MonitorFleetWorker::accept(FleetMonitor& monitor) {
+    int fd;
+    while ((fd = accept4(monitor.listener, nullptr, nullptr, SOCK_NONBLOCK)) >= 0) {
+        int yes = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        FleetConnection* connection = new FleetConnection();
+        connection->fd = fd;
+        connection->monitor = &monitor;
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLET | EPOLLRDHUP;
+        event.data.ptr = connection;
+        epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event);
+        connections.insert(connection);
+    }
+}
+
+void MonitorFleetWorker::drop(FleetConnection& connection) {
+    if (connection.closing) return;
+    connection.closing = true;
+    epoll_ctl(epoll, EPOLL_CTL_DEL, connection.fd, nullptr);
+    close(connection.fd);
+    if (connection.websocket) {
+        std::vector<FleetConnection*>& clients = connection.monitor->clients;
+        for (size_t i = 0; i < clients.size(); i++) {
+            if (clients[i] == &connection) {
+                clients[i] = clients.back();
+                clients.pop_back();
+                break;
+            }
+        }
+        local.clients--;
+    }
+    dropped.push_back(&connection);
+}
+
+// Marks what was just appended to `out` as one message or response
+void MonitorFleetWorker::queue(FleetConnection& connection, uint64_t now, bool http) {
+    connection.marks.push_back({connection.written + connection.out.size(), now, http});
+}
+
+bool MonitorFleetWorker::flush(FleetConnection& connection) {
+    while (!connection.out.empty()) {
+        ssize_t n = send(connection.fd, connection.out.data(), connection.out.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+            connection.out.erase(0, n);
+            connection.written += n;
+            local.bytes += n;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return false;
+        }
+    }
+    if (!connection.marks.empty()) {
+        uint64_t now = steadyMicros();
+        while (!connection.marks.empty() && connection.marks.front().end <= connection.written) {
+            const FleetConnection::Mark& mark = connection.marks.front();
+            (mark.http ? local.http : local.queue).record(now - mark.at);
+            connection.marks.pop_front();
+        }
+    }
+    return connection.out.size() <= MAX_BACKLOG;
+}
+
+void MonitorFleetWorker::onEvent(FleetConnection& connection) {
+    uint64_t now = steadyMicros();
+    bool keep = true;
+    char buffer[4096];
+    ssize_t n = 0;
+    while (keep && (n = recv(connection.fd, buffer, sizeof(buffer), 0)) > 0) {
+        if (connection.websocket) {
+            keep = connection.decoder.feed(buffer, n, [&](uint8_t opcode, const char* payload, size_t length) {
+                if (keep) onMessage(connection, opcode, payload, length, now);
+                if (opcode == WS_OP_CLOSE) keep = false;
+            }) && keep;
+            continue;
+        }
+        connection.in.append(buffer, n);
+        HttpRequest request;
+        HttpParse result = HTTP_INCOMPLETE;
+        while (keep && !connection.websocket && (result = httpReadRequest(connection.in, request)) == HTTP_DONE) {
+            std::string rest = connection.in.substr(request.length);
+            connection.in.clear();
+            onRequest(connection, request, now);
+            if (connection.websocket) {
+                keep = connection.decoder.feed(rest.data(), rest.size(), [&](uint8_t opcode, const char* payload,
+                                                                             size_t length) {
+                    if (keep) onMessage(connection, opcode, payload, length, now);
+                    if (opcode == WS_OP_CLOSE) keep = false;
+                }) && keep;
+            } else {
+                connection.in = rest;
+                if (!request.keepAlive) {
+                    flush(connection);
+                    keep = false;
+                }
+            }
+        }
+        if (result == HTTP_BAD) keep = false;
+    }
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) keep = false;
+    if (keep) keep = flush(connection);
+    if (!keep) drop(connection);
+}
+
+void MonitorFleetWorker::onRequest(FleetConnection& connection, const HttpRequest& request, uint64_t now) {
+    local.httpRequests++;
+    FleetMonitor& monitor = *connection.monitor;
+    std::string path = request.target.substr(0, request.target.find('?'));
+
+    if (!request.wsKey.empty() && path == "/ws") {
+        wsAppendUpgradeResponse(connection.out, request.wsKey);
+        queue(connection, now, true);
+        connection.websocket = true;
+        monitor.clients.push_back(&connection);
+        local.clients++;
+        return;
+    }
+
+    char body[256];
+    size_t length = 0;
+    int code = 200;
+    if (request.method != "GET") {
+        code = 405;
+    } else if (path == "/api/vitals") {
+        length = jsonSerialize(monitor.bed.getVitals(), body, sizeof(body));
+    } else if (path == "/api/status") {
+        length = jsonSerialize(monitor.bed.getStatus(deviceNow(), (int)monitor.clients.size()), body, sizeof(body));
+    } else {
+        code = 404;
+    }
+    if (code != 200) length = snprintf(body, sizeof(body), "Not found");
+    httpAppendResponse(connection.out, code, code == 200 ? "application/json" : "text/plain", body, length,
+                       request.keepAlive);
+    queue(connection, now, true);
+}
+
+// Subscriptions and commands as web_interface.cpp handles them
+void MonitorFleetWorker::onMessage(FleetConnection& connection, uint8_t opcode, const char* payload, size_t length,
+                                   uint64_t now) {
+    if (opcode == WS_OP_CLOSE) {
+        wsAppendFrame(connection.out, WS_OP_CLOSE, payload, length >= 2 ? 2 : 0, false);
+        flush(connection);
+        return;
+    }
+    if (opcode == WS_OP_PING) {
+        wsAppendFrame(connection.out, WS_OP_PONG, payload, length, false);
+        return;
+    }
+    if (opcode != WS_OP_TEXT) return;
+
+    bool subscribe;
+    uint8_t channels;
+    if (readSubscription(payload, length, subscribe, channels)) {
+        if (subscribe) {
+            connection.channels |= channels;
+        } else {
+            connection.channels &= ~(channels & ~WS_CHANNEL_ALERTS);
+        }
+        return;
+    }
+
+    char command[32];
+    readCommand(payload, length, command, sizeof(command));
+    FleetMonitor& monitor = *connection.monitor;
+    char reply[192];
+    size_t replyLength = 0;
+    if (strcmp(command, "getVitals") == 0) {
+        replyLength = jsonSerialize(monitor.bed.getVitals(), reply, sizeof(reply));
+    } else if (strcmp(command, "getStatus") == 0) {
+        replyLength = jsonSerialize(monitor.bed.getStatus(deviceNow(), (int)monitor.clients.size()), reply,
+                                    sizeof(reply));
+    }
+    if (replyLength > 0 && replyLength < sizeof(reply)) {
+        wsAppendFrame(connection.out, WS_OP_TEXT, reply, replyLength, false);
+        queue(connection, now, false);
+        local.messages++;
+    }
+}
+
+void MonitorFleetWorker::tick() {
+    uint64_t now = steadyMicros();
+    uint32_t device = deviceNow();
+    for (auto& entry : monitors) {
+        FleetMonitor& monitor = *entry;
+        uint8_t wanted = 0;
+        for (FleetConnection* client : monitor.clients) wanted |= client->channels;
+        // Encoded once, copied to every client that wants it
+        monitor.bed.advance(device, wanted, [&](WsChannel channel, const char* text, size_t length) {
+            frame.clear();
+            wsAppendFrame(frame, WS_OP_TEXT, text, length, false);
+            for (FleetConnection* client : monitor.clients) {
+                if (!(client->channels & channel)) continue;
+                client->out += frame;
+                queue(*client, now, false);
+                local.messages++;
+            }
+        });
+        // drop() edits the list
+        for (size_t i = monitor.clients.size(); i-- > 0;) {
+            FleetConnection* client = monitor.clients[i];
+            if (client->out.empty()) continue;
+            if (!flush(*client)) {
+                local.dropped++;
+                drop(*client);
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    shared.add(local);
+    local = MonitorFleetStats();
+}
+
+// ==================== FLEET ====================
+MonitorFleet::MonitorFleet() {}
+
+MonitorFleet::~MonitorFleet() {
+    stop();
+}
+
+bool MonitorFleet::start(const MonitorFleetOptions& options, uint64_t epoch) {
+    int threads = options.threads < 1 ? 1 : options.threads;
+    for (int i = 0; i < threads; i++) workers.emplace_back(new MonitorFleetWorker());
+    for (int i = 0; i < options.monitors; i++) {
+        uint16_t port = (uint16_t)(options.basePort + i);
+        if (!workers[i % threads]->listen((uint32_t)i + 1, options.bindAddress, port, options.rates, epoch)) {
+            fprintf(stderr, "Cannot listen on %s:%u\n", options.bindAddress.c_str(), port);
+            workers.clear();
+            return false;
+        }
+    }
+    for (auto& worker : workers) worker->start();
+    return true;
+}
+
+void MonitorFleet::stop() {
+    for (auto& worker : workers) worker->stop();
+    workers.clear();
+}
+
+void MonitorFleet::collect(MonitorFleetStats& into, bool reset) {
+    for (auto& worker : workers) worker->collect(into, reset);
+}
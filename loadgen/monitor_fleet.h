@@ -0,0 +1,63 @@
+#ifndef LOADGEN_MONITOR_FLEET_H
+#define LOADGEN_MONITOR_FLEET_H
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "latency_histogram.h"
+#include "../gateway/sim_bed.h"
+
+// N impersonated monitors for a dashboard or gateway to connect to. Monitor
+// i listens on a port of its own, basePort + i, and speaks the firmware's
+// API there: GET /api/vitals and /api/status, and /ws (web_interface.cpp)
+// with subscriptions, getVitals/getStatus commands and the vitals, alert,
+// waveform and status messages of its SimBed.
+//
+// The monitors are shared out over worker threads, each an epoll loop
+// that advances its beds every 10 ms. Every monitor boots at the fleet's
+// epoch, so a message's timestamp plus the epoch is when it was sent; a
+// client in the same process can time delivery exactly.
+
+struct MonitorFleetOptions {
+    int monitors = 100;
+    uint16_t basePort = 9000;       // Monitor i listens on basePort + i
+    std::string bindAddress = "0.0.0.0";
+    int threads = 2;
+    SimBedRates rates;
+};
+
+// Sums over the fleet since the last reset
+struct MonitorFleetStats {
+    int clients = 0;                // WebSocket clients now connected
+    uint64_t httpRequests = 0;
+    uint64_t messages = 0;          // WebSocket messages queued, counted per client
+    uint64_t bytes = 0;             // Sent, HTTP and WebSocket
+    uint64_t dropped = 0;           // Clients disconnected for falling too far behind
+    LatencyHistogram http;          // Request read to response written to the socket
+    LatencyHistogram queue;         // WebSocket message queued to written to the socket
+
+    void add(const MonitorFleetStats& other);
+};
+
+class MonitorFleetWorker;
+
+class MonitorFleet {
+private:
+    std::vector<std::unique_ptr<MonitorFleetWorker>> workers;
+
+public:
+    MonitorFleet();
+    ~MonitorFleet();
+
+    // Binds every port and starts the workers; false (with the port on
+    // stderr) if a port could not be bound. `epoch` is the steady-clock ms
+    // the monitors boot at.
+    bool start(const MonitorFleetOptions& options, uint64_t epoch);
+    void stop();
+
+    // Adds every worker's stats to `into`; `reset` starts a new period
+    void collect(MonitorFleetStats& into, bool reset);
+};
+
+#endif
@@ -0,0 +1,174 @@
+#include "memory_accounting.h"
+#include <stdio.h>
+#include "vital_signs.h"
+#include "trace_log.h"
+
+MemoryAccount* MemoryAccount::table[MemoryAccount::MAX_ACCOUNTS];
+int MemoryAccount::accountCount = 0;
+
+static MemoryTaskInfo tasks[MEMORY_MAX_TASKS];
+static std::atomic<int> taskCount(0);
+
+// ==================== STANDARD ACCOUNTS ====================
+// The sketch's dataBuffer holds DATA_BUFFER_SIZE (100) readings and is
+// reserved one past that, since it is trimmed after the push
+MemoryAccount memoryVitals("vitals", 101 * sizeof(VitalSigns));
+// alertHistory (51 at most) plus activeAlerts (reserved 16, 32 if a burst
+// outgrows that); an Alert is 28 bytes on the ESP32, 56 on the host
+MemoryAccount memoryAlerts("alerts", 5 * 1024);
+// The uplink (6 KB) and trace (3 KB) task stacks, with room for one more
+MemoryAccount memoryTaskStacks("task_stacks", 12 * 1024);
+
+// ==================== ACCOUNT ====================
+MemoryAccount::MemoryAccount(const char* accountName, size_t budgetBytes)
+    : name(accountName), budget(budgetBytes), current(0), peak(0), allocations(0), failures(0),
+      overBudgetReported(false) {
+    // Accounts past the table still count; they are just not listed
+    if (accountCount < MAX_ACCOUNTS) table[accountCount++] = this;
+}
+
+void MemoryAccount::charge(size_t bytes) {
+    size_t now = current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    size_t highest = peak.load(std::memory_order_relaxed);
+    while (now > highest && !peak.compare_exchange_weak(highest, now, std::memory_order_relaxed)) {
+    }
+    if (now > budget && !overBudgetReported.exchange(true, std::memory_order_relaxed)) {
+        TRACE("WARNING: %s memory over budget - %u of %u bytes\n", name, (unsigned)now, (unsigned)budget);
+    }
+}
+
+void MemoryAccount::credit(size_t bytes) {
+    current.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+// ==================== TASK STACKS ====================
+void memoryTrackTask(const char* name, TaskHandle_t handle, uint32_t stackBytes, bool chargeStack) {
+    int slot = taskCount.load(std::memory_order_relaxed);
+    if (slot >= MEMORY_MAX_TASKS) return;
+    tasks[slot].name = name;
+    tasks[slot].handle = handle;
+    tasks[slot].stackBytes = stackBytes;
+    taskCount.store(slot + 1, std::memory_order_release);
+    if (chargeStack) memoryTaskStacks.charge(stackBytes);
+}
+
+int memoryTaskCount() {
+    return taskCount.load(std::memory_order_acquire);
+}
+
+const MemoryTaskInfo& memoryTask(int i) {
+    return tasks[i];
+}
+
+int32_t memoryStackHighWater(const MemoryTaskInfo& task) {
+#if defined(ESP32)
+    // ESP-IDF reports the high-water mark in bytes
+    return task.handle ? (int32_t)uxTaskGetStackHighWaterMark(task.handle) : -1;
+#else
+    (void)task;
+    return -1;
+#endif
+}
+
+// ==================== HEAP ====================
+void readHeapStatus(HeapStatus& status) {
+    status.freeBytes = ESP.getFreeHeap();
+    status.minFreeBytes = ESP.getMinFreeHeap();
+    status.largestFreeBlock = ESP.getMaxAllocHeap();
+    status.fragmentation = status.freeBytes > 0 && status.largestFreeBlock < status.freeBytes
+        ? (uint8_t)(100 - (uint64_t)status.largestFreeBlock * 100 / status.freeBytes)
+        : 0;
+}
+
+// ==================== REPORT ====================
+// Stages: heap, accounts, tasks, end
+MemoryReportGenerator::MemoryReportGenerator(Format outputFormat, const char* firmwareVersion, bool wifiIsConnected)
+    : format(outputFormat), version(firmwareVersion), wifiConnected(wifiIsConnected) {
+    stage = 0;
+    next = 0;
+}
+
+size_t MemoryReportGenerator::renderNext(char* out, size_t size) {
+    int n = 0;
+
+    if (stage == 0) {
+        HeapStatus heap;
+        readHeapStatus(heap);
+        if (format == JSON) {
+            n = snprintf(out, size,
+                         "{\"wifiConnected\":%s,\"uptime\":%lu,\"version\":\"%s\",\"freeHeap\":%u,"
+                         "\"minFreeHeap\":%u,\"largestFreeBlock\":%u,\"fragmentation\":%u,\"subsystems\":[",
+                         wifiConnected ? "true" : "false", (unsigned long)millis(), version,
+                         (unsigned)heap.freeBytes, (unsigned)heap.minFreeBytes,
+                         (unsigned)heap.largestFreeBlock, (unsigned)heap.fragmentation);
+        } else {
+            n = snprintf(out, size,
+                         "Heap: %u free, %u lowest, %u largest block (%u%% fragmented)\n"
+                         "%-12s %9s %9s %9s %9s %6s\n",
+                         (unsigned)heap.freeBytes, (unsigned)heap.minFreeBytes,
+                         (unsigned)heap.largestFreeBlock, (unsigned)heap.fragmentation,
+                         "Subsystem", "Bytes", "Peak", "Budget", "Allocs", "Fails");
+        }
+        stage++;
+        return n > 0 ? (size_t)n : 0;
+    }
+
+    if (stage == 1) {
+        if (next < MemoryAccount::getAccountCount()) {
+            const MemoryAccount* account = MemoryAccount::getAccount(next);
+            if (format == JSON) {
+                n = snprintf(out, size,
+                             "%s{\"name\":\"%s\",\"bytes\":%u,\"peak\":%u,\"budget\":%u,\"allocations\":%u,"
+                             "\"failures\":%u}",
+                             next > 0 ? "," : "", account->getName(), (unsigned)account->getCurrent(),
+                             (unsigned)account->getPeak(), (unsigned)account->getBudget(),
+                             (unsigned)account->getAllocations(), (unsigned)account->getFailures());
+            } else {
+                n = snprintf(out, size, "%-12s %9u %9u %9u %9u %6u%s\n", account->getName(),
+                             (unsigned)account->getCurrent(), (unsigned)account->getPeak(),
+                             (unsigned)account->getBudget(), (unsigned)account->getAllocations(),
+                             (unsigned)account->getFailures(), account->isOverBudget() ? " OVER" : "");
+            }
+            next++;
+            return n > 0 ? (size_t)n : 0;
+        }
+        stage++;
+        next = 0;
+        if (format == JSON) {
+            n = snprintf(out, size, "],\"tasks\":[");
+        } else {
+            n = snprintf(out, size, "%-12s %9s %9s\n", "Task", "Stack", "Min free");
+        }
+        return n > 0 ? (size_t)n : 0;
+    }
+
+    if (stage == 2) {
+        if (next < memoryTaskCount()) {
+            const MemoryTaskInfo& task = memoryTask(next);
+            int32_t highWater = memoryStackHighWater(task);
+            if (format == JSON) {
+                if (highWater >= 0) {
+                    n = snprintf(out, size, "%s{\"name\":\"%s\",\"stack\":%u,\"minFree\":%d}",
+                                 next > 0 ? "," : "", task.name, (unsigned)task.stackBytes, (int)highWater);
+                } else {
+                    n = snprintf(out, size, "%s{\"name\":\"%s\",\"stack\":%u,\"minFree\":null}",
+                                 next > 0 ? "," : "", task.name, (unsigned)task.stackBytes);
+                }
+            } else if (highWater >= 0) {
+                n = snprintf(out, size, "%-12s %9u %9d\n", task.name, (unsigned)task.stackBytes, (int)highWater);
+            } else {
+                n = snprintf(out, size, "%-12s %9u %9s\n", task.name, (unsigned)task.stackBytes, "n/a");
+            }
+            next++;
+            return n > 0 ? (size_t)n : 0;
+        }
+        stage++;
+        if (format == JSON) {
+            n = snprintf(out, size, "]}");
+            return n > 0 ? (size_t)n : 0;
+        }
+    }
+    return 0;
+}
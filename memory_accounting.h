@@ -0,0 +1,157 @@
+#ifndef MEMORY_ACCOUNTING_H
+#define MEMORY_ACCOUNTING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <new>
+#include <Arduino.h>
+#include "http_stream.h"
+
+// Heap accounting by subsystem, task stack high-water marks and heap
+// fragmentation.
+//
+// Each subsystem is a statically allocated account with a declared budget;
+// it enters a fixed table when constructed. Containers charge it through
+// AccountedAllocator:
+//
+//   std::vector<Alert, AccountedAllocator<Alert>> alertHistory{AccountedAllocator<Alert>(memoryAlerts)};
+//
+// and other owners charge and credit it directly. Going over budget still
+// allocates, since dropping a reading or an alarm is worse than running
+// tight; it is counted, traced once and fails the host build's
+// --memory-budgets check. Only what a subsystem allocates through its
+// account is counted: the String bodies inside alerts and the WiFi and web
+// server libraries' own buffers are not.
+//
+// Counters are atomic, so accounts may be charged from any task.
+
+class MemoryAccount {
+public:
+    static const int MAX_ACCOUNTS = 16;
+
+private:
+    static MemoryAccount* table[MAX_ACCOUNTS];
+    static int accountCount;
+
+    const char* name;
+    size_t budget;
+    std::atomic<size_t> current;
+    std::atomic<size_t> peak;
+    std::atomic<uint32_t> allocations;
+    std::atomic<uint32_t> failures;
+    std::atomic<bool> overBudgetReported;
+
+public:
+    MemoryAccount(const char* accountName, size_t budgetBytes);
+
+    void charge(size_t bytes);
+    void credit(size_t bytes);
+    // Counts an allocation that came back empty
+    void failed() { failures.fetch_add(1, std::memory_order_relaxed); }
+
+    const char* getName() const { return name; }
+    size_t getBudget() const { return budget; }
+    size_t getCurrent() const { return current.load(std::memory_order_relaxed); }
+    size_t getPeak() const { return peak.load(std::memory_order_relaxed); }
+    uint32_t getAllocations() const { return allocations.load(std::memory_order_relaxed); }
+    uint32_t getFailures() const { return failures.load(std::memory_order_relaxed); }
+    bool isOverBudget() const { return getPeak() > budget; }
+
+    static int getAccountCount() { return accountCount; }
+    static MemoryAccount* getAccount(int i) { return table[i]; }
+};
+
+// Standard allocator that charges an account; for std containers
+template <typename T>
+class AccountedAllocator {
+public:
+    typedef T value_type;
+
+    MemoryAccount* account;
+
+    explicit AccountedAllocator(MemoryAccount& target) : account(&target) {}
+    template <typename U>
+    AccountedAllocator(const AccountedAllocator<U>& other) : account(other.account) {}
+
+    T* allocate(size_t n) {
+        T* memory = static_cast<T*>(::operator new(n * sizeof(T), std::nothrow));
+        if (!memory) {
+            account->failed();
+            throw std::bad_alloc();
+        }
+        account->charge(n * sizeof(T));
+        return memory;
+    }
+
+    void deallocate(T* memory, size_t n) {
+        account->credit(n * sizeof(T));
+        ::operator delete(memory);
+    }
+
+    template <typename U>
+    bool operator==(const AccountedAllocator<U>& other) const { return account == other.account; }
+    template <typename U>
+    bool operator!=(const AccountedAllocator<U>& other) const { return account != other.account; }
+};
+
+// ==================== TASK STACKS ====================
+struct MemoryTaskInfo {
+    const char* name;
+    TaskHandle_t handle;
+    uint32_t stackBytes;
+};
+
+static const int MEMORY_MAX_TASKS = 8;
+
+// Registers a task for the stack report. Tasks the firmware creates charge
+// their stack to memoryTaskStacks; pass chargeStack = false for ones it did
+// not allocate, such as the Arduino loop task.
+void memoryTrackTask(const char* name, TaskHandle_t handle, uint32_t stackBytes, bool chargeStack = true);
+int memoryTaskCount();
+const MemoryTaskInfo& memoryTask(int i);
+// Smallest amount of stack the task has had free, in bytes; -1 where it
+// cannot be measured (host threads)
+int32_t memoryStackHighWater(const MemoryTaskInfo& task);
+
+// ==================== HEAP ====================
+struct HeapStatus {
+    uint32_t freeBytes;
+    uint32_t minFreeBytes;      // Low-water mark since boot
+    uint32_t largestFreeBlock;
+    uint8_t fragmentation;      // Percent of free heap outside the largest block
+};
+
+void readHeapStatus(HeapStatus& status);
+
+// ==================== REPORT ====================
+// Heap, accounts and task stacks as a text table (the serial `memory`
+// command) or as JSON (/api/status), one row per piece
+class MemoryReportGenerator : public ChunkGenerator {
+public:
+    enum Format {
+        TEXT,
+        JSON
+    };
+
+private:
+    Format format;
+    const char* version;
+    bool wifiConnected;
+    int stage;
+    int next;
+
+public:
+    // The version and WiFi state head the /api/status JSON
+    MemoryReportGenerator(Format outputFormat, const char* firmwareVersion = "", bool wifiIsConnected = false);
+
+protected:
+    size_t renderNext(char* out, size_t size) override;
+};
+
+// ==================== STANDARD ACCOUNTS ====================
+extern MemoryAccount memoryVitals;
+extern MemoryAccount memoryAlerts;
+extern MemoryAccount memoryTaskStacks;
+
+#endif
@@ -0,0 +1,173 @@
+#include "metrics.h"
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+
+Metric* Metric::head = nullptr;
+Metric* Metric::tail = nullptr;
+
+// ==================== STANDARD METRICS ====================
+static const uint32_t LOOP_BOUNDS_US[] = {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000};
+static const uint32_t SAMPLE_BOUNDS_US[] = {50, 100, 250, 500, 1000, 2500, 5000, 10000, 50000};
+static const uint32_t FLUSH_BOUNDS_US[] = {500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000};
+
+MetricHistogram metricLoopDuration("cardiac_loop_duration_us",
+    "Main loop iteration time in microseconds", LOOP_BOUNDS_US, 10);
+MetricHistogram metricSampleLatency("cardiac_sample_latency_us",
+    "Time to read and process one sensor sample in microseconds", SAMPLE_BOUNDS_US, 9);
+MetricCounter metricFifoOverflows("cardiac_sensor_fifo_overflows_total",
+    "Sensor FIFO reads that found the FIFO full, so samples were lost");
+MetricCounter metricSpiBytes("cardiac_display_spi_bytes_total",
+    "Bytes sent to the display over SPI: window commands and pixels");
+MetricGauge metricWsQueueBytes("cardiac_ws_queue_bytes",
+    "Largest unacknowledged send backlog of any WebSocket client");
+MetricGauge metricWsHeldAlerts("cardiac_ws_held_alerts",
+    "Alerts held back for stalled WebSocket clients");
+MetricHistogram metricLogFlush("cardiac_log_flush_us",
+    "Vitals log flush time in microseconds", FLUSH_BOUNDS_US, 9);
+MetricCounter metricAlarmsInfo("cardiac_alarms_total{level=\"info\"}",
+    "Alarms raised, by level");
+MetricCounter metricAlarmsWarning("cardiac_alarms_total{level=\"warning\"}",
+    "Alarms raised, by level");
+MetricCounter metricAlarmsCritical("cardiac_alarms_total{level=\"critical\"}",
+    "Alarms raised, by level");
+MetricGauge metricFreeHeap("cardiac_free_heap_bytes",
+    "Free heap");
+MetricGauge metricMinFreeHeap("cardiac_min_free_heap_bytes",
+    "Lowest free heap since boot");
+MetricGauge metricLargestFreeBlock("cardiac_largest_free_block_bytes",
+    "Largest allocatable heap block");
+MetricGauge metricUptime("cardiac_uptime_seconds",
+    "Seconds since boot");
+
+// ==================== REGISTRY ====================
+Metric::Metric(const char* metricName, const char* metricHelp, MetricType metricType) {
+    name = metricName;
+    help = metricHelp;
+    type = metricType;
+    next = nullptr;
+
+    // Appended in declaration order so label families stay adjacent
+    if (tail) {
+        tail->next = this;
+    } else {
+        head = this;
+    }
+    tail = this;
+}
+
+MetricHistogram::MetricHistogram(const char* metricName, const char* metricHelp,
+                                 const uint32_t* upperBounds, int upperBoundCount)
+    : Metric(metricName, metricHelp, METRIC_HISTOGRAM), sum(0) {
+    bounds = upperBounds;
+    boundCount = upperBoundCount < MAX_BUCKETS ? upperBoundCount : MAX_BUCKETS;
+    for (int i = 0; i <= MAX_BUCKETS; i++) {
+        buckets[i].store(0);
+    }
+}
+
+MetricTimer::MetricTimer(MetricHistogram& target) : histogram(target) {
+    start = hal.clock->micros();
+}
+
+MetricTimer::~MetricTimer() {
+    histogram.observe(hal.clock->micros() - start);
+}
+
+// ==================== RENDERING ====================
+MetricsGenerator::MetricsGenerator() {
+    metric = Metric::first();
+    previous = nullptr;
+    line = 0;
+}
+
+void MetricsGenerator::advance() {
+    previous = metric;
+    metric = metric->getNext();
+    line = 0;
+}
+
+bool MetricsGenerator::sameFamily(const char* a, const char* b) {
+    size_t lengthA = strcspn(a, "{");
+    size_t lengthB = strcspn(b, "{");
+    return lengthA == lengthB && strncmp(a, b, lengthA) == 0;
+}
+
+size_t MetricsGenerator::renderNext(char* out, size_t size) {
+    static const char* TYPE_NAMES[] = {"counter", "gauge", "histogram"};
+
+    while (metric) {
+        Metric* current = metric;
+        int index = line++;
+        int n = 0;
+
+        // Lines 0 and 1 are HELP and TYPE, skipped inside a label family
+        if (index < 2) {
+            if (previous && sameFamily(previous->getName(), current->getName())) continue;
+
+            int familyLength = (int)strcspn(current->getName(), "{");
+            if (index == 0) {
+                n = snprintf(out, size, "# HELP %.*s %s\n", familyLength, current->getName(), current->getHelp());
+            } else {
+                n = snprintf(out, size, "# TYPE %.*s %s\n", familyLength, current->getName(),
+                             TYPE_NAMES[current->getType()]);
+            }
+            return n > 0 ? (size_t)n : 0;
+        }
+
+        index -= 2;
+        switch (current->getType()) {
+            case METRIC_COUNTER:
+                n = snprintf(out, size, "%s %u\n", current->getName(),
+                             (unsigned)static_cast<MetricCounter*>(current)->get());
+                break;
+            case METRIC_GAUGE:
+                n = snprintf(out, size, "%s %d\n", current->getName(),
+                             (int)static_cast<MetricGauge*>(current)->get());
+                break;
+            case METRIC_HISTOGRAM: {
+                MetricHistogram* histogram = static_cast<MetricHistogram*>(current);
+                int bounds = histogram->getBoundCount();
+                uint32_t cumulative = 0;
+
+                // Series suffixes go after the family name, le joins any labels
+                const char* name = current->getName();
+                int familyLength = (int)strcspn(name, "{");
+                const char* labels = name + familyLength;
+                const char* inner = *labels ? labels + 1 : labels;
+                int innerLength = *labels ? (int)strlen(labels) - 2 : 0;
+                const char* separator = innerLength > 0 ? "," : "";
+
+                if (index <= bounds) {
+                    for (int i = 0; i <= index; i++) cumulative += histogram->getBucket(i);
+                    if (index < bounds) {
+                        n = snprintf(out, size, "%.*s_bucket{%.*s%sle=\"%u\"} %u\n", familyLength, name,
+                                     innerLength, inner, separator,
+                                     (unsigned)histogram->getBound(index), (unsigned)cumulative);
+                    } else {
+                        n = snprintf(out, size, "%.*s_bucket{%.*s%sle=\"+Inf\"} %u\n", familyLength, name,
+                                     innerLength, inner, separator, (unsigned)cumulative);
+                    }
+                    return n > 0 ? (size_t)n : 0;
+                }
+                if (index == bounds + 1) {
+                    n = snprintf(out, size, "%.*s_sum%s %u\n", familyLength, name, labels,
+                                 (unsigned)histogram->getSum());
+                    return n > 0 ? (size_t)n : 0;
+                }
+                if (index == bounds + 2) {
+                    for (int i = 0; i <= bounds; i++) cumulative += histogram->getBucket(i);
+                    n = snprintf(out, size, "%.*s_count%s %u\n", familyLength, name, labels, (unsigned)cumulative);
+                    advance();
+                    return n > 0 ? (size_t)n : 0;
+                }
+                break;
+            }
+        }
+
+        // Single-value metric done
+        advance();
+        return n > 0 ? (size_t)n : 0;
+    }
+    return 0;
+}
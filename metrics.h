@@ -0,0 +1,155 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "http_stream.h"
+
+// Process-wide metrics, rendered at /metrics in the Prometheus text format.
+//
+// Every metric is a statically allocated object that links itself into the
+// registry when constructed, so declaring one is all it takes to export it:
+//
+//   MetricCounter fifoOverflows("cardiac_sensor_fifo_overflows_total", "...");
+//   fifoOverflows.inc();
+//
+// Updates are relaxed 32-bit atomic adds, safe from any task or core and a
+// handful of instructions each. Counters and histogram sums are 32-bit and
+// wrap; Prometheus treats a wrap like a counter reset.
+//
+// A name may carry labels, e.g. cardiac_alarms_total{level="critical"}.
+// Metrics of one family must be declared next to each other; HELP and TYPE
+// are written once for the family.
+
+enum MetricType {
+    METRIC_COUNTER,
+    METRIC_GAUGE,
+    METRIC_HISTOGRAM
+};
+
+class Metric {
+private:
+    static Metric* head;
+    static Metric* tail;
+    Metric* next;
+
+protected:
+    const char* name;
+    const char* help;
+    MetricType type;
+
+public:
+    Metric(const char* metricName, const char* metricHelp, MetricType metricType);
+
+    static Metric* first() { return head; }
+    Metric* getNext() const { return next; }
+    const char* getName() const { return name; }
+    const char* getHelp() const { return help; }
+    MetricType getType() const { return type; }
+};
+
+class MetricCounter : public Metric {
+private:
+    std::atomic<uint32_t> value;
+
+public:
+    MetricCounter(const char* metricName, const char* metricHelp)
+        : Metric(metricName, metricHelp, METRIC_COUNTER), value(0) {}
+
+    void inc() { value.fetch_add(1, std::memory_order_relaxed); }
+    void add(uint32_t amount) { value.fetch_add(amount, std::memory_order_relaxed); }
+    // For a total kept elsewhere, copied in before rendering
+    void set(uint32_t total) { value.store(total, std::memory_order_relaxed); }
+    uint32_t get() const { return value.load(std::memory_order_relaxed); }
+};
+
+class MetricGauge : public Metric {
+private:
+    std::atomic<int32_t> value;
+
+public:
+    MetricGauge(const char* metricName, const char* metricHelp)
+        : Metric(metricName, metricHelp, METRIC_GAUGE), value(0) {}
+
+    void set(int32_t v) { value.store(v, std::memory_order_relaxed); }
+    int32_t get() const { return value.load(std::memory_order_relaxed); }
+};
+
+// Fixed buckets given as ascending upper bounds; values above the last
+// bound land in +Inf. Bucket counts are stored per bucket and made
+// cumulative only when rendered.
+class MetricHistogram : public Metric {
+public:
+    static const int MAX_BUCKETS = 12;
+
+private:
+    const uint32_t* bounds;
+    int boundCount;
+    std::atomic<uint32_t> buckets[MAX_BUCKETS + 1];
+    std::atomic<uint32_t> sum;
+
+public:
+    MetricHistogram(const char* metricName, const char* metricHelp,
+                    const uint32_t* upperBounds, int upperBoundCount);
+
+    void observe(uint32_t v) {
+        int i = 0;
+        while (i < boundCount && v > bounds[i]) i++;
+        buckets[i].fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(v, std::memory_order_relaxed);
+    }
+
+    int getBoundCount() const { return boundCount; }
+    uint32_t getBound(int i) const { return bounds[i]; }
+    uint32_t getBucket(int i) const { return buckets[i].load(std::memory_order_relaxed); }
+    uint32_t getSum() const { return sum.load(std::memory_order_relaxed); }
+};
+
+// Times a scope into a histogram, in microseconds
+class MetricTimer {
+private:
+    MetricHistogram& histogram;
+    uint32_t start;
+
+public:
+    explicit MetricTimer(MetricHistogram& target);
+    ~MetricTimer();
+};
+
+// Streams the registry as Prometheus text, one line per piece, straight
+// from the live values; nothing is collected or copied first
+class MetricsGenerator : public ChunkGenerator {
+private:
+    Metric* metric;
+    Metric* previous;
+    int line;
+
+public:
+    MetricsGenerator();
+
+private:
+    void advance();
+    static bool sameFamily(const char* a, const char* b);
+
+protected:
+    size_t renderNext(char* out, size_t size) override;
+};
+
+// ==================== STANDARD METRICS ====================
+extern MetricHistogram metricLoopDuration;
+extern MetricHistogram metricSampleLatency;
+extern MetricCounter metricFifoOverflows;
+extern MetricCounter metricSpiBytes;
+extern MetricGauge metricWsQueueBytes;
+extern MetricGauge metricWsHeldAlerts;
+extern MetricHistogram metricLogFlush;
+extern MetricCounter metricAlarmsInfo;
+extern MetricCounter metricAlarmsWarning;
+extern MetricCounter metricAlarmsCritical;
+extern MetricGauge metricFreeHeap;
+extern MetricGauge metricMinFreeHeap;
+extern MetricGauge metricLargestFreeBlock;
+extern MetricGauge metricUptime;
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef MONITOR_CORE_H
+#define MONITOR_CORE_H
+
+#include <stdint.h>
+#include "target_profile.h"
+#include "vital_signs.h"
+#include "vitals_pipeline.h"
+
+// The monitor's sensor-to-alarm loop, once for every board: battery and
+// PPG samples in, vitals, logged readings and alarms out. Each sketch
+// instantiates it for its profile with a policy for each thing that
+// differs between boards:
+//
+//   Board     static uint16_t check();       sensor FIFO poll; samples arrived
+//             static bool available();
+//             static uint32_t getRed(), getIR();
+//             static void nextSample();
+//             static uint16_t readBattery();  raw ADC reading
+//             static uint32_t now();          ms, millis() or its stand-in
+//   Settings  static void load(AlertThresholds&);
+//             static void save(const AlertThresholds&);
+//   Log       static void append(const VitalSigns&);
+//             static void flush();            every Profile::LOG_SAVE_EVERY readings
+//   Events    see NoMonitorEvents
+//
+// Policies are static, so the core stores nothing for them and every call
+// is direct and inlinable; a hook a board does not use is an empty inline
+// function and leaves no code behind. The sketch keeps the schedule and
+// the screen, and calls the core at the profile's intervals.
+
+// ==================== EVENTS ====================
+// Instrumentation hooks; the ESP32 sketch fills them with metrics, the
+// profiler and the latency tracer, the Uno takes these
+struct NoMonitorEvents {
+    // Alive while a sample is read and windowed
+    struct SampleScope {};
+    static void burstArrived(uint16_t) {}
+    static void windowEstimated(VitalSigns&) {}
+    static void alarmRaised(const AlarmEvent&) {}
+};
+
+// ==================== CORE ====================
+template <typename Profile, typename Board, typename Settings, typename Log,
+          typename Events = NoMonitorEvents>
+class MonitorCore {
+public:
+    typedef BasicPpgEstimator<Profile::PPG_WINDOW, typename Profile::PpgSample> Estimator;
+
+private:
+    Estimator estimator;
+    AlarmRules rules;
+    VitalSigns vitals;
+    AlertThresholds thresholds;
+    uint8_t unsaved;            // Readings logged since the last flush
+
+public:
+    MonitorCore() : unsaved(0) {
+        static_assert(sizeof(*this) <= Profile::CORE_RAM_BUDGET, "monitor core outgrew the profile's RAM budget");
+    }
+
+    // Battery, then every sample the sensor has delivered; returns true
+    // when one of them completed a window and heart rate / SpO2 were
+    // re-estimated
+    bool updateSensors() {
+        vitals.batteryLevel = batteryPercent(Board::readBattery());
+        vitals.timestamp = Board::now();
+
+        // available() only looks at the driver's own 4-sample buffer, which
+        // check() fills from the sensor's 32-sample FIFO over I2C; without it
+        // no sample is ever seen. The count it returns costs nothing extra
+        // and is what the overflow metric is made from.
+        Events::burstArrived(Board::check());
+
+        bool estimated = false;
+        while (Board::available()) {
+            typename Events::SampleScope scope;
+            (void)scope;
+            if (estimator.addSample(Board::getRed(), Board::getIR(), vitals)) {
+                Events::windowEstimated(vitals);
+                estimated = true;
+            }
+            Board::nextSample();
+        }
+        return estimated;
+    }
+
+    // Logs the current reading if there is a finger and a heart rate;
+    // returns true if it did
+    bool logData() {
+        if (!vitals.isFingerDetected || vitals.heartRate <= 0) return false;
+        Log::append(vitals);
+        if (++unsaved >= Profile::LOG_SAVE_EVERY) {
+            unsaved = 0;
+            Log::flush();
+        }
+        return true;
+    }
+
+    // The most severe of heart rate, SpO2 and battery; the rules apply the
+    // cooldown.
+    // Returns true and fills `alarm` when one is raised.
+    bool checkAlerts(AlarmEvent& alarm) {
+        if (!thresholds.enabled) return false;
+        if (!rules.check(vitals, thresholds, Board::now(), alarm)) return false;
+        Events::alarmRaised(alarm);
+        return true;
+    }
+
+    // Gate for alarms the rules do not raise (faults, self-test): the same
+    // cooldown, so they and the vitals alarms together stay one per 5 s
+    bool admitAlarm(AlertLevel level) { return rules.admit(level, Board::now()); }
+
+    void loadSettings() { Settings::load(thresholds); }
+    void saveSettings() { Settings::save(thresholds); }
+
+    // Drops the partial window; settings, vitals and the alarm cooldown stay
+    void reset() { estimator.reset(); }
+
+    // 3.0 V = 0 %, 4.2 V = 100 %, through the profile's ADC and divider
+    static float batteryPercent(uint16_t raw) {
+        float voltage = (raw / Profile::ADC_FULL_SCALE) * Profile::ADC_REFERENCE * Profile::BATTERY_DIVIDER;
+        float percentage = ((voltage - 3.0) / 1.2) * 100.0;
+        return percentage < 0 ? 0 : (percentage > 100 ? 100 : percentage);
+    }
+
+    VitalSigns& getVitals() { return vitals; }
+    AlertThresholds& getThresholds() { return thresholds; }
+    const Estimator& getEstimator() const { return estimator; }
+};
+
+#endif
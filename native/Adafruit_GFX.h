@@ -0,0 +1,80 @@
+#ifndef NATIVE_ADAFRUIT_GFX_H
+#define NATIVE_ADAFRUIT_GFX_H
+
+// Adafruit_GFX for [env:native]. Primitives decompose into address windows
+// and pixel runs on hal.display the way the real library does, so the bus
+// byte counts match the device. Glyphs use the classic 6x8 cell with a
+// stand-in bitmap rather than the real font.
+
+#include "Arduino.h"
+
+class Adafruit_GFX : public Print {
+protected:
+    const int16_t rawWidth;
+    const int16_t rawHeight;
+    int16_t _width;
+    int16_t _height;
+    uint8_t rotation;
+    int16_t cursorX;
+    int16_t cursorY;
+    uint16_t textColor;
+    uint16_t textBackground;
+    uint8_t textSize;
+    bool wrap;
+
+    void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t background, uint8_t size);
+
+public:
+    Adafruit_GFX(int16_t w, int16_t h);
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color);
+    virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void fillScreen(uint16_t color) { fillRect(0, 0, _width, _height, color); }
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) { fillRect(x, y, w, 1, color); }
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) { fillRect(x, y, 1, h, color); }
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+    void fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+    void fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
+    void drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+    void fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+
+    virtual void setRotation(uint8_t r);
+    uint8_t getRotation() const { return rotation; }
+    int16_t width() const { return _width; }
+    int16_t height() const { return _height; }
+
+    void setCursor(int16_t x, int16_t y) { cursorX = x; cursorY = y; }
+    int16_t getCursorX() const { return cursorX; }
+    int16_t getCursorY() const { return cursorY; }
+    void setTextColor(uint16_t color) { textColor = textBackground = color; }
+    void setTextColor(uint16_t color, uint16_t background) { textColor = color; textBackground = background; }
+    void setTextSize(uint8_t size) { textSize = size > 0 ? size : 1; }
+    void setTextWrap(bool enabled) { wrap = enabled; }
+    void getTextBounds(const char* text, int16_t x, int16_t y,
+                       int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h);
+    void getTextBounds(const String& text, int16_t x, int16_t y,
+                       int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h) {
+        getTextBounds(text.c_str(), x, y, x1, y1, w, h);
+    }
+
+    size_t write(uint8_t c) override;
+    using Print::write;
+};
+
+// RGB565 drawing surface in RAM; nothing reaches the display bus
+class GFXcanvas16 : public Adafruit_GFX {
+private:
+    std::vector<uint16_t> buffer;
+
+public:
+    GFXcanvas16(uint16_t w, uint16_t h) : Adafruit_GFX(w, h), buffer((size_t)w * h, 0) {}
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    uint16_t getPixel(int16_t x, int16_t y) const;
+    uint16_t* getBuffer() { return buffer.data(); }
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef NATIVE_ADAFRUIT_ILI9341_H
+#define NATIVE_ADAFRUIT_ILI9341_H
+
+#include "Adafruit_GFX.h"
+
+#define ILI9341_TFTWIDTH 240
+#define ILI9341_TFTHEIGHT 320
+
+class Adafruit_ILI9341 : public Adafruit_GFX {
+public:
+    Adafruit_ILI9341(int8_t cs, int8_t dc, int8_t mosi, int8_t sclk, int8_t rst = -1, int8_t miso = -1)
+        : Adafruit_GFX(ILI9341_TFTWIDTH, ILI9341_TFTHEIGHT) {
+        (void)cs;
+        (void)dc;
+        (void)mosi;
+        (void)sclk;
+        (void)rst;
+        (void)miso;
+    }
+
+    void begin(uint32_t frequency = 0) { (void)frequency; }
+    void startWrite() {}
+    void endWrite() {}
+    virtual void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) { hal.display->setWindow(x, y, w, h); }
+    void writeColor(uint16_t color, uint32_t count) { hal.display->pushColor(color, count); }
+};
+
+#endif
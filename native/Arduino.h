@@ -0,0 +1,184 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+/*
+ * The slice of the ESP32 Arduino core the firmware uses, for [env:native].
+ * Time, pins and the ADC go through the simulated HAL (hal_sim.cpp), so
+ * millis() and delay() follow the virtual clock.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include "WString.h"
+#include "../hal.h"
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define PI 3.1415926535897932384626433832795
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define F(text) (text)
+#define PROGMEM
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+using std::min;
+using std::max;
+
+template <typename T, typename L, typename H>
+inline T constrain(T x, L low, H high) {
+    return x < (T)low ? (T)low : (x > (T)high ? (T)high : x);
+}
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// ==================== TIME ====================
+inline unsigned long millis() { return hal.clock->millis(); }
+inline unsigned long micros() { return hal.clock->micros(); }
+inline void delay(unsigned long ms) { hal.clock->delay(ms); }
+inline void yield() {}
+
+// ==================== PINS ====================
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+inline uint16_t analogRead(uint8_t pin) { return hal.adc->read(pin); }
+
+// Routed to hal.tone, whatever the pin; a timed tone counts as one beep of
+// no length, since nothing runs in the background to stop it
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0);
+void noTone(uint8_t pin);
+
+// ==================== RANDOM ====================
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+uint32_t esp_random();
+
+#if !defined(__GLIBC__) || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+size_t strlcpy(char* dst, const char* src, size_t size);
+#endif
+
+// ==================== PRINT ====================
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* text) { return text ? write((const uint8_t*)text, strlen(text)) : 0; }
+    size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+
+    size_t print(const char* text) { return write(text); }
+    size_t print(const String& text) { return write(text.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int number, int base = 10) { return print((long)number, base); }
+    size_t print(unsigned int number, int base = 10) { return print((unsigned long)number, base); }
+    size_t print(long number, int base = 10);
+    size_t print(unsigned long number, int base = 10);
+    size_t print(double number, int decimals = 2);
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T& value) { return print(value) + println(); }
+    template <typename T>
+    size_t println(const T& value, int format) { return print(value, format) + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() { return -1; }
+
+    String readStringUntil(char terminator);
+    size_t readBytesUntil(char terminator, char* buffer, size_t length);
+};
+
+// Serial goes to stdout; input is fed in by the harness with inject()
+class HardwareSerial : public Stream {
+private:
+    std::deque<uint8_t> input;
+    std::mutex inputLock;
+    bool muted = false;
+
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    void end() {}
+    void setMuted(bool mute) { muted = mute; }
+    void inject(const char* text);
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() { fflush(stdout); }
+    operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+// ==================== CHIP ====================
+class EspClass {
+public:
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getHeapSize();
+    uint32_t getMaxAllocHeap();
+    uint32_t getFlashChipSize() { return 4 * 1024 * 1024; }
+    uint32_t getCpuFreqMHz() { return 240; }
+    const char* getChipModel() { return "host"; }
+    uint8_t getChipRevision() { return 0; }
+    [[noreturn]] void restart();
+};
+
+extern EspClass ESP;
+
+// ==================== FREERTOS ====================
+typedef void* TaskHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void (*TaskFunction_t)(void*);
+typedef void* SemaphoreHandle_t;
+
+#define pdPASS 1
+#define pdFAIL 0
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xffffffffUL
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+// Tasks run as detached host threads; the core argument is ignored
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stackDepth,
+                                   void* parameter, UBaseType_t priority,
+                                   TaskHandle_t* handle, BaseType_t core);
+// Sleeps until the virtual clock has moved on by the given ticks
+void vTaskDelay(TickType_t ticks);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+// A std::mutex; Take waits however long it has to, whatever the ticks
+SemaphoreHandle_t xSemaphoreCreateMutex();
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+
+#endif
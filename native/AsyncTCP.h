@@ -0,0 +1,67 @@
+#ifndef NATIVE_ASYNCTCP_H
+#define NATIVE_ASYNCTCP_H
+
+// AsyncClient for [env:native]: one end of a connection with a send window
+// and nothing behind it. add() takes bytes as lwIP does, copied into the
+// window by default or left where they are with no flags, in which case
+// they must stay put until acknowledged. The harness plays the peer:
+// ackNative() acknowledges bytes, and the writes are kept for it to read.
+
+#include "Arduino.h"
+#include <atomic>
+#include <functional>
+
+// lwIP's send buffer per connection (sdkconfig default)
+#define CONFIG_TCP_SND_BUF_DEFAULT 5744
+
+#define ASYNC_WRITE_FLAG_COPY 0x01
+#define ASYNC_WRITE_FLAG_MORE 0x02
+
+class AsyncClient {
+public:
+    typedef std::function<void(void* arg, AsyncClient* client, size_t len, uint32_t time)> AcConnectHandler;
+
+    // One add() as the harness sees it
+    struct Write {
+        const uint8_t* data;    // The caller's bytes, or the copy in the window
+        size_t length;
+        bool copied;
+    };
+    static const int MAX_WRITES = 32;
+
+private:
+    uint8_t window[CONFIG_TCP_SND_BUF_DEFAULT];  // The copies, as lwIP's pbufs
+    size_t windowUsed;
+    size_t unacked;
+    bool connected;
+    Write writes[MAX_WRITES];
+    int writeCount;
+    AcConnectHandler onAckHandler;
+    void* onAckArg;
+
+    static std::atomic<size_t> copiedBytes;
+
+public:
+    AsyncClient() : windowUsed(0), unacked(0), connected(true), writeCount(0), onAckArg(nullptr) {}
+
+    bool canSend() const { return connected && space() > 0; }
+    size_t space() const { return connected ? CONFIG_TCP_SND_BUF_DEFAULT - unacked : 0; }
+    size_t add(const char* data, size_t size, uint8_t apiflags = ASYNC_WRITE_FLAG_COPY);
+    bool send() { return connected; }
+    void close(bool now = false) { (void)now; connected = false; }
+    void onAck(AcConnectHandler handler, void* arg = nullptr) {
+        onAckHandler = handler;
+        onAckArg = arg;
+    }
+
+    // Harness side: the peer acknowledges `length` bytes; once everything
+    // is, the writes are forgotten and the window is empty again
+    void ackNative(size_t length);
+    int getWriteCount() const { return writeCount; }
+    const Write& getWrite(int i) const { return writes[i]; }
+    // Bytes every connection has copied with ASYNC_WRITE_FLAG_COPY
+    static size_t getCopiedBytes() { return copiedBytes.load(); }
+    static void countCopy(size_t length) { copiedBytes += length; }
+};
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef NATIVE_DNSSERVER_H
+#define NATIVE_DNSSERVER_H
+
+// Captive portal DNS for [env:native]; there is no AP to answer for
+
+#include "WiFi.h"
+
+class DNSServer {
+public:
+    bool start(uint16_t port, const String& domain, const IPAddress& ip) {
+        (void)port;
+        (void)domain;
+        (void)ip;
+        return true;
+    }
+    void processNextRequest() {}
+    void stop() {}
+};
+
+#endif
@@ -0,0 +1,219 @@
+#ifndef NATIVE_ESPASYNCWEBSERVER_H
+#define NATIVE_ESPASYNCWEBSERVER_H
+
+// ESPAsyncWebServer 1.2.3 for [env:native], WebSocket only: the part
+// web_interface.cpp uses, with the library's message queue as it is. Every
+// queued message takes a list node from the heap; a message made from the
+// caller's bytes (text()) copies them, and its send() mallocs the frame
+// header and copies the payload into the TCP window, as AsyncWebSocket.cpp
+// does. A message the caller made itself is queued as given.
+//
+// Nothing listens on a socket. The harness opens connections in-process
+// with connectNative() and plays the browser on each one's AsyncClient.
+
+#include "Arduino.h"
+#include "AsyncTCP.h"
+#include "WiFi.h"
+#include <functional>
+
+#define WS_MAX_QUEUED_MESSAGES 32
+#define DEFAULT_MAX_WS_CLIENTS 8
+
+typedef enum { WS_CONTINUATION, WS_TEXT, WS_BINARY, WS_DISCONNECT = 0x08, WS_PING, WS_PONG } AwsFrameType;
+typedef enum { WS_MSG_SENDING, WS_MSG_SENT, WS_MSG_ERROR } AwsMessageStatus;
+typedef enum { WS_DISCONNECTED, WS_CONNECTED, WS_DISCONNECTING } AwsClientStatus;
+typedef enum { WS_EVT_CONNECT, WS_EVT_DISCONNECT, WS_EVT_PONG, WS_EVT_ERROR, WS_EVT_DATA } AwsEventType;
+
+typedef struct {
+    uint8_t message_opcode;
+    uint32_t num;
+    uint8_t final;
+    uint8_t masked;
+    uint8_t opcode;
+    uint64_t len;
+    uint8_t mask[4];
+    uint64_t index;
+} AwsFrameInfo;
+
+// The library's singly linked list (StringArray.h): a node from the heap
+// per add(), and onRemove runs on whatever leaves it
+template <typename T>
+class LinkedList {
+public:
+    typedef std::function<void(const T&)> OnRemove;
+
+private:
+    struct Node {
+        T value;
+        Node* next;
+    };
+    Node* root;
+    OnRemove onRemove;
+
+public:
+    class Iterator {
+    private:
+        Node* node;
+    public:
+        explicit Iterator(Node* at) : node(at) {}
+        bool operator!=(const Iterator& other) const { return node != other.node; }
+        Iterator& operator++() {
+            node = node->next;
+            return *this;
+        }
+        const T& operator*() const { return node->value; }
+    };
+
+    explicit LinkedList(OnRemove removed) : root(nullptr), onRemove(removed) {}
+    ~LinkedList() { free(); }
+
+    Iterator begin() const { return Iterator(root); }
+    Iterator end() const { return Iterator(nullptr); }
+    bool isEmpty() const { return root == nullptr; }
+    const T& front() const { return root->value; }
+
+    void add(const T& value) {
+        Node* node = new Node{value, nullptr};
+        if (!root) {
+            root = node;
+            return;
+        }
+        Node* last = root;
+        while (last->next) last = last->next;
+        last->next = node;
+    }
+
+    size_t length() const {
+        size_t count = 0;
+        for (Node* node = root; node; node = node->next) count++;
+        return count;
+    }
+
+    bool remove(const T& value) {
+        for (Node** at = &root; *at; at = &(*at)->next) {
+            if ((*at)->value == value) {
+                Node* node = *at;
+                *at = node->next;
+                if (onRemove) onRemove(node->value);
+                delete node;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void free() {
+        while (root) remove(root->value);
+    }
+};
+
+class AsyncWebSocket;
+class AsyncWebSocketClient;
+
+class AsyncWebSocketMessage {
+protected:
+    uint8_t _opcode;
+    bool _mask;
+    AwsMessageStatus _status;
+
+public:
+    AsyncWebSocketMessage() : _opcode(WS_TEXT), _mask(false), _status(WS_MSG_ERROR) {}
+    virtual ~AsyncWebSocketMessage() {}
+    virtual void ack(size_t len, uint32_t time) { (void)len; (void)time; }
+    virtual size_t send(AsyncClient* client) { (void)client; return 0; }
+    virtual bool finished() { return _status != WS_MSG_SENDING; }
+    virtual bool betweenFrames() const { return false; }
+};
+
+// text(data, len): a heap copy of the caller's bytes
+class AsyncWebSocketBasicMessage : public AsyncWebSocketMessage {
+private:
+    size_t _len;
+    size_t _sent;
+    size_t _ack;
+    size_t _acked;
+    uint8_t* _data;
+
+public:
+    AsyncWebSocketBasicMessage(const char* data, size_t len, uint8_t opcode = WS_TEXT);
+    ~AsyncWebSocketBasicMessage() override;
+    bool betweenFrames() const override { return _acked == _ack; }
+    void ack(size_t len, uint32_t time) override;
+    size_t send(AsyncClient* client) override;
+};
+
+class AsyncWebSocketClient {
+private:
+    AsyncClient* _client;
+    AsyncWebSocket* _server;
+    uint32_t _clientId;
+    AwsClientStatus _status;
+    LinkedList<AsyncWebSocketMessage*> _messageQueue;
+
+    void _queueMessage(AsyncWebSocketMessage* dataMessage);
+    void _runQueue();
+
+public:
+    AsyncWebSocketClient(AsyncClient* client, AsyncWebSocket* server, uint32_t id);
+    ~AsyncWebSocketClient();
+
+    uint32_t id() const { return _clientId; }
+    AwsClientStatus status() const { return _status; }
+    AsyncClient* client() { return _client; }
+    IPAddress remoteIP() const { return IPAddress(127, 0, 0, 1); }
+    bool queueIsFull() const { return _messageQueue.length() >= WS_MAX_QUEUED_MESSAGES || _status != WS_CONNECTED; }
+    size_t queueLength() const { return _messageQueue.length(); }
+
+    void close(uint16_t code = 0, const char* message = nullptr);
+    void message(AsyncWebSocketMessage* message) { _queueMessage(message); }
+    void text(const char* message, size_t len);
+    void text(const char* message) { text(message, strlen(message)); }
+
+    // From the AsyncClient
+    void _onAck(size_t len, uint32_t time);
+};
+
+typedef std::function<void(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg,
+                           uint8_t* data, size_t len)> AwsEventHandler;
+
+class AsyncWebHandler {
+public:
+    virtual ~AsyncWebHandler() {}
+};
+
+class AsyncWebSocket : public AsyncWebHandler {
+private:
+    String _url;
+    LinkedList<AsyncWebSocketClient*> _clients;
+    uint32_t _cNextId;
+    AwsEventHandler _eventHandler;
+
+public:
+    explicit AsyncWebSocket(const String& url);
+    ~AsyncWebSocket();
+
+    const char* url() const { return _url.c_str(); }
+    void onEvent(AwsEventHandler handler) { _eventHandler = handler; }
+    // Clients with status WS_CONNECTED
+    size_t count() const;
+    const LinkedList<AsyncWebSocketClient*>& getClients() const { return _clients; }
+    // Closes the oldest clients past maxClients, and forgets closed ones
+    void cleanupClients(uint16_t maxClients = DEFAULT_MAX_WS_CLIENTS);
+    void _handleEvent(AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len);
+
+    // Harness side: the socket serving `url`, a browser connecting, one
+    // text frame from it, and it going away
+    static AsyncWebSocket* findNative(const char* url);
+    AsyncWebSocketClient* connectNative();
+    void receiveNative(AsyncWebSocketClient* client, const char* text);
+    void disconnectNative(AsyncWebSocketClient* client);
+};
+
+class AsyncWebServer {
+public:
+    explicit AsyncWebServer(uint16_t port) { (void)port; }
+    void addHandler(AsyncWebHandler* handler) { (void)handler; }
+    void begin() {}
+};
+
+#endif
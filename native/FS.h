@@ -0,0 +1,55 @@
+#ifndef NATIVE_FS_H
+#define NATIVE_FS_H
+
+// Arduino File API for [env:native], over hal.storage handles
+
+#include "Arduino.h"
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+enum SeekMode {
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+// Copies share the handle, like the reference-counted File on the device
+class File : public Stream {
+private:
+    int handle;
+
+public:
+    File() : handle(HAL_INVALID_FILE) {}
+    explicit File(int file) : handle(file) {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t read(uint8_t* buffer, size_t size);
+
+    bool seek(uint32_t position, SeekMode mode = SeekSet);
+    size_t position();
+    size_t size();
+    void flush() {}
+    void close();
+    operator bool() const { return handle != HAL_INVALID_FILE; }
+};
+
+class FS {
+public:
+    File open(const char* path, const char* mode = FILE_READ);
+    File open(const String& path, const char* mode = FILE_READ) { return open(path.c_str(), mode); }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* from, const char* to);
+    bool mkdir(const char* path);
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef NATIVE_HTTPCLIENT_H
+#define NATIVE_HTTPCLIENT_H
+
+// HTTP/1.1 client for [env:native] over POSIX sockets, so the simulated
+// monitor can upload to a real collector (tools/uplink_collector.py).
+// Plain http:// only.
+
+#include "Arduino.h"
+#include <string>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+#define HTTP_CODE_OK 200
+
+class HTTPClient {
+private:
+    std::string host;
+    uint16_t port = 80;
+    std::string path;
+    std::string headers;
+    std::string response;
+    uint32_t timeout = 5000;
+    int socketFd = -1;
+
+    int request(const char* method, const uint8_t* payload, size_t size);
+    bool sendAll(const char* data, size_t size);
+
+public:
+    ~HTTPClient() { end(); }
+
+    void setTimeout(uint16_t ms) { timeout = ms; }
+    bool begin(const String& url);
+    void addHeader(const String& name, const String& value);
+    int GET() { return request("GET", nullptr, 0); }
+    int POST(uint8_t* payload, size_t size) { return request("POST", payload, size); }
+    int POST(const String& payload) { return request("POST", (const uint8_t*)payload.c_str(), payload.length()); }
+    String getString() { return String(response); }
+    void end();
+};
+
+#endif
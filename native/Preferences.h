@@ -0,0 +1,40 @@
+#ifndef NATIVE_PREFERENCES_H
+#define NATIVE_PREFERENCES_H
+
+// NVS key/value store for [env:native]. Namespaces are shared by every
+// Preferences instance, as on the device, and written through to nvs.txt
+// in the storage directory so they survive a restart like flash does.
+
+#include "Arduino.h"
+#include <map>
+#include <string>
+
+class Preferences {
+private:
+    std::string space;
+    bool opened = false;
+
+    bool lookup(const char* key, std::string& value);
+    void store(const char* key, const std::string& value);
+
+public:
+    bool begin(const char* name, bool readOnly = false);
+    void end() { opened = false; }
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putString(const char* key, const String& value);
+    size_t putFloat(const char* key, float value);
+    size_t putInt(const char* key, int32_t value);
+    size_t putUInt(const char* key, uint32_t value);
+    size_t putBool(const char* key, bool value);
+
+    String getString(const char* key, const String& defaultValue = String());
+    float getFloat(const char* key, float defaultValue = 0);
+    int32_t getInt(const char* key, int32_t defaultValue = 0);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    bool getBool(const char* key, bool defaultValue = false);
+};
+
+#endif
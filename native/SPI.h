@@ -0,0 +1,14 @@
+#ifndef NATIVE_SPI_H
+#define NATIVE_SPI_H
+
+// The display bus is simulated at the HAL level; nothing talks SPI directly
+
+class SPIClass {
+public:
+    void begin() {}
+    void end() {}
+};
+
+extern SPIClass SPI;
+
+#endif
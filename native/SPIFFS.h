@@ -0,0 +1,15 @@
+#ifndef NATIVE_SPIFFS_H
+#define NATIVE_SPIFFS_H
+
+#include "FS.h"
+
+class SPIFFSFS : public FS {
+public:
+    bool begin(bool formatOnFail = false, const char* basePath = "/spiffs",
+               uint8_t maxOpenFiles = 10, const char* partitionLabel = nullptr);
+    void end() {}
+};
+
+extern SPIFFSFS SPIFFS;
+
+#endif
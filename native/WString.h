@@ -0,0 +1,90 @@
+#ifndef NATIVE_WSTRING_H
+#define NATIVE_WSTRING_H
+
+// Arduino String for [env:native], backed by std::string
+
+#include <stddef.h>
+#include <string>
+#include <type_traits>
+
+class String {
+private:
+    std::string value;
+
+public:
+    String() {}
+    String(const char* text) : value(text ? text : "") {}
+    String(const std::string& text) : value(text) {}
+    explicit String(char c) : value(1, c) {}
+    String(float number, unsigned int decimals = 2);
+    String(double number, unsigned int decimals = 2);
+
+    template <typename T, typename std::enable_if<std::is_integral<T>::value &&
+                                                  !std::is_same<T, char>::value &&
+                                                  !std::is_same<T, bool>::value, int>::type = 0>
+    String(T number, unsigned int base = 10) {
+        if (std::is_signed<T>::value) {
+            fromSigned((long long)number, base);
+        } else {
+            fromUnsigned((unsigned long long)number, base);
+        }
+    }
+
+    const char* c_str() const { return value.c_str(); }
+    unsigned int length() const { return value.length(); }
+    bool isEmpty() const { return value.empty(); }
+    void reserve(unsigned int size) { value.reserve(size); }
+
+    char charAt(unsigned int index) const { return index < value.size() ? value[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index) { return value[index]; }
+
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String& text, unsigned int from = 0) const;
+    int lastIndexOf(char c) const;
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+
+    bool equals(const String& other) const { return value == other.value; }
+    bool equalsIgnoreCase(const String& other) const;
+    bool startsWith(const String& prefix) const;
+    bool endsWith(const String& suffix) const;
+
+    long toInt() const;
+    float toFloat() const;
+    double toDouble() const;
+
+    void trim();
+    void toLowerCase();
+    void toUpperCase();
+    void replace(const String& from, const String& to);
+    void remove(unsigned int index, unsigned int count = (unsigned int)-1);
+
+    bool concat(const String& text) { value += text.value; return true; }
+    String& operator+=(const String& text) { value += text.value; return *this; }
+    String& operator+=(const char* text) { if (text) value += text; return *this; }
+    String& operator+=(char c) { value += c; return *this; }
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value &&
+                                                  !std::is_same<T, char>::value, int>::type = 0>
+    String& operator+=(T number) { return *this += String(number); }
+
+    bool operator==(const String& other) const { return value == other.value; }
+    bool operator==(const char* other) const { return value == (other ? other : ""); }
+    bool operator!=(const String& other) const { return value != other.value; }
+    bool operator!=(const char* other) const { return !(*this == other); }
+    bool operator<(const String& other) const { return value < other.value; }
+
+    friend String operator+(const String& a, const String& b) { return String(a.value + b.value); }
+    friend String operator+(const String& a, const char* b) { return String(a.value + (b ? b : "")); }
+    friend String operator+(const char* a, const String& b) { return String((a ? a : "") + b.value); }
+    friend String operator+(const String& a, char b) { return String(a.value + b); }
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value &&
+                                                  !std::is_same<T, char>::value, int>::type = 0>
+    friend String operator+(const String& a, T b) { return a + String(b); }
+
+private:
+    void fromSigned(long long number, unsigned int base);
+    void fromUnsigned(unsigned long long number, unsigned int base);
+};
+
+#endif
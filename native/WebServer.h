@@ -0,0 +1,95 @@
+#ifndef NATIVE_WEBSERVER_H
+#define NATIVE_WEBSERVER_H
+
+// Synchronous WebServer for [env:native]. Nothing listens on a socket;
+// the harness drives requests in-process through dispatch(), which runs
+// the matching handler and captures what it sends. handleClient() serves
+// requests from a source the harness sets, so they are handled inside
+// loop() as on the device.
+
+#include "Arduino.h"
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+
+typedef enum {
+    HTTP_ANY = 0,
+    HTTP_GET = 1,
+    HTTP_POST = 3
+} HTTPMethod;
+
+class WebServer {
+public:
+    typedef std::function<void()> THandlerFunction;
+    // Gives the next "path?query" to serve and its header lines
+    // ("Name: value\r\n" each), or false if there is none
+    typedef std::function<bool(std::string& target, std::string& headers)> TRequestSource;
+    // Receives each response handleClient() produces
+    typedef std::function<void(const std::string& target, int code, const std::string& body)> TResponseSink;
+
+private:
+    struct Route {
+        std::string uri;
+        THandlerFunction handler;
+    };
+
+    std::vector<Route> routes;
+    THandlerFunction notFound;
+    TRequestSource requestSource;
+    TResponseSink responseSink;
+    std::string currentUri;
+    std::vector<std::pair<std::string, std::string>> currentArgs;
+    std::vector<std::string> collectedHeaders;
+    std::vector<std::pair<std::string, std::string>> currentHeaders;
+    int responseCode;
+    std::string responseType;
+    std::string responseHead;       // Headers sendHeader() added
+    std::string responseBody;
+
+    static std::string decode(const std::string& text);
+
+public:
+    explicit WebServer(int port = 80) : responseCode(0) { (void)port; }
+
+    void on(const char* uri, THandlerFunction handler);
+    void on(const char* uri, HTTPMethod method, THandlerFunction handler) { (void)method; on(uri, handler); }
+    void onNotFound(THandlerFunction handler) { notFound = handler; }
+    void begin() {}
+    void handleClient();
+    // Where handleClient() takes requests from and hands responses to, in
+    // place of the socket
+    void setRequestSource(TRequestSource source) { requestSource = source; }
+    void setResponseSink(TResponseSink sink) { responseSink = sink; }
+
+    String uri() const { return String(currentUri); }
+    String arg(const char* name) const;
+    String arg(const String& name) const { return arg(name.c_str()); }
+    bool hasArg(const char* name) const;
+    int args() const { return currentArgs.size(); }
+    String arg(int i) const { return String(currentArgs[i].second); }
+    String argName(int i) const { return String(currentArgs[i].first); }
+    // As on the device, only the headers named here are kept from a request
+    void collectHeaders(const char* headerKeys[], size_t count);
+    String header(const char* name) const;
+    String header(const String& name) const { return header(name.c_str()); }
+    bool hasHeader(const char* name) const;
+    bool hasHeader(const String& name) const { return hasHeader(name.c_str()); }
+
+    void sendHeader(const String& name, const String& value, bool first = false);
+    void send(int code, const char* contentType = nullptr, const String& content = String());
+    void setContentLength(size_t length) { (void)length; }
+    void sendContent(const char* content, size_t length) { responseBody.append(content, length); }
+    void sendContent(const String& content) { responseBody += content.c_str(); }
+
+    // Runs the handler for "path?query" with the given header lines;
+    // returns the status (404 if no route matches) and the full body
+    int dispatch(const char* target, std::string& body, const std::string& headers = std::string());
+    // Of the response dispatch() produced last
+    const std::string& responseContentType() const { return responseType; }
+    const std::string& responseHeaders() const { return responseHead; }
+};
+
+#endif
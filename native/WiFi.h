@@ -0,0 +1,62 @@
+#ifndef NATIVE_WIFI_H
+#define NATIVE_WIFI_H
+
+// WiFi station/AP API for [env:native], answered by the simulated network
+
+#include "Arduino.h"
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum {
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} wifi_mode_t;
+
+typedef enum {
+    WIFI_AUTH_OPEN = 0,
+    WIFI_AUTH_WPA2_PSK = 3
+} wifi_auth_mode_t;
+
+class IPAddress {
+private:
+    uint8_t octets[4];
+
+public:
+    IPAddress() : octets{0, 0, 0, 0} {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : octets{a, b, c, d} {}
+    uint8_t operator[](int index) const { return octets[index]; }
+    String toString() const;
+};
+
+class WiFiClass {
+public:
+    wl_status_t status();
+    bool mode(wifi_mode_t mode);
+    wl_status_t begin(const char* ssid, const char* password = nullptr);
+    bool disconnect();
+    bool setAutoReconnect(bool autoReconnect) { (void)autoReconnect; return true; }
+
+    bool softAP(const char* ssid, const char* password = nullptr);
+    IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+    IPAddress localIP();
+    String macAddress();
+
+    String SSID();
+    int8_t RSSI();
+    int16_t scanNetworks();
+    String SSID(uint8_t index);
+    int32_t RSSI(uint8_t index);
+    wifi_auth_mode_t encryptionType(uint8_t index);
+};
+
+extern WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+// The sensor is simulated at the HAL level; nothing talks I2C directly.
+// The master calls are here for the MAX3010x library's driver, which the
+// native builds compile along with its estimator: no device answers.
+
+#include <stdint.h>
+#include <stddef.h>
+
+class TwoWire {
+public:
+    bool begin() { return true; }
+    bool begin(int sda, int scl, uint32_t frequency = 0) {
+        (void)sda;
+        (void)scl;
+        (void)frequency;
+        return true;
+    }
+    void setClock(uint32_t frequency) { (void)frequency; }
+
+    void beginTransmission(uint8_t address) { (void)address; }
+    size_t write(uint8_t data) { (void)data; return 1; }
+    // 2: address NACK
+    uint8_t endTransmission(bool sendStop = true) { (void)sendStop; return 2; }
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true) {
+        (void)address;
+        (void)quantity;
+        (void)sendStop;
+        return 0;
+    }
+    int available() { return 0; }
+    int read() { return -1; }
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,326 @@
+// Arduino core shim implementation for [env:native]; see Arduino.h
+#include "Arduino.h"
+#include <ctype.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <thread>
+#include <random>
+
+// ==================== STRING ====================
+static std::string formatFloat(double number, unsigned int decimals) {
+    char text[48];
+    snprintf(text, sizeof(text), "%.*f", (int)decimals, number);
+    return text;
+}
+
+String::String(float number, unsigned int decimals) : value(formatFloat(number, decimals)) {}
+String::String(double number, unsigned int decimals) : value(formatFloat(number, decimals)) {}
+
+void String::fromSigned(long long number, unsigned int base) {
+    if (number < 0 && base == 10) {
+        fromUnsigned(0ULL - (unsigned long long)number, base);
+        value.insert(value.begin(), '-');
+    } else {
+        fromUnsigned((unsigned long long)number, base);
+    }
+}
+
+void String::fromUnsigned(unsigned long long number, unsigned int base) {
+    if (base < 2 || base > 36) base = 10;
+    char digits[66];
+    int i = sizeof(digits);
+    digits[--i] = 0;
+    do {
+        int digit = number % base;
+        digits[--i] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        number /= base;
+    } while (number > 0);
+    value = &digits[i];
+}
+
+int String::indexOf(char c, unsigned int from) const {
+    size_t at = value.find(c, from);
+    return at == std::string::npos ? -1 : (int)at;
+}
+
+int String::indexOf(const String& text, unsigned int from) const {
+    size_t at = value.find(text.value, from);
+    return at == std::string::npos ? -1 : (int)at;
+}
+
+int String::lastIndexOf(char c) const {
+    size_t at = value.rfind(c);
+    return at == std::string::npos ? -1 : (int)at;
+}
+
+String String::substring(unsigned int from) const {
+    return from < value.size() ? String(value.substr(from)) : String();
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= value.size()) return String();
+    return String(value.substr(from, to - from));
+}
+
+bool String::equalsIgnoreCase(const String& other) const {
+    if (value.size() != other.value.size()) return false;
+    for (size_t i = 0; i < value.size(); i++) {
+        if (tolower((unsigned char)value[i]) != tolower((unsigned char)other.value[i])) return false;
+    }
+    return true;
+}
+
+bool String::startsWith(const String& prefix) const {
+    return value.compare(0, prefix.value.size(), prefix.value) == 0;
+}
+
+bool String::endsWith(const String& suffix) const {
+    return value.size() >= suffix.value.size() &&
+           value.compare(value.size() - suffix.value.size(), suffix.value.size(), suffix.value) == 0;
+}
+
+long String::toInt() const { return strtol(value.c_str(), nullptr, 10); }
+float String::toFloat() const { return strtof(value.c_str(), nullptr); }
+double String::toDouble() const { return strtod(value.c_str(), nullptr); }
+
+void String::trim() {
+    size_t start = 0;
+    while (start < value.size() && isspace((unsigned char)value[start])) start++;
+    size_t end = value.size();
+    while (end > start && isspace((unsigned char)value[end - 1])) end--;
+    value = value.substr(start, end - start);
+}
+
+void String::toLowerCase() {
+    for (char& c : value) c = tolower((unsigned char)c);
+}
+
+void String::toUpperCase() {
+    for (char& c : value) c = toupper((unsigned char)c);
+}
+
+void String::replace(const String& from, const String& to) {
+    if (from.value.empty()) return;
+    size_t at = 0;
+    while ((at = value.find(from.value, at)) != std::string::npos) {
+        value.replace(at, from.value.size(), to.value);
+        at += to.value.size();
+    }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+    if (index < value.size()) value.erase(index, count);
+}
+
+// ==================== PRINT ====================
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t written = 0;
+    while (written < size && write(buffer[written])) written++;
+    return written;
+}
+
+size_t Print::print(long number, int base) {
+    return print(String(number, base));
+}
+
+size_t Print::print(unsigned long number, int base) {
+    return print(String(number, base));
+}
+
+size_t Print::print(double number, int decimals) {
+    return print(String(number, decimals));
+}
+
+size_t Print::printf(const char* format, ...) {
+    char small[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(small, sizeof(small), format, args);
+    va_end(args);
+    if (length < 0) return 0;
+    if ((size_t)length < sizeof(small)) return write((const uint8_t*)small, length);
+
+    std::string large(length + 1, 0);
+    va_start(args, format);
+    vsnprintf(&large[0], large.size(), format, args);
+    va_end(args);
+    return write((const uint8_t*)large.data(), length);
+}
+
+String Stream::readStringUntil(char terminator) {
+    String text;
+    int c;
+    while (available() && (c = read()) >= 0 && c != terminator) {
+        text += (char)c;
+    }
+    return text;
+}
+
+size_t Stream::readBytesUntil(char terminator, char* buffer, size_t length) {
+    size_t count = 0;
+    int c;
+    while (count < length && available() && (c = read()) >= 0 && c != terminator) {
+        buffer[count++] = (char)c;
+    }
+    return count;
+}
+
+// ==================== SERIAL ====================
+HardwareSerial Serial;
+
+void HardwareSerial::inject(const char* text) {
+    std::lock_guard<std::mutex> guard(inputLock);
+    while (*text) input.push_back((uint8_t)*text++);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    if (!muted) fputc(c, stdout);
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (!muted) fwrite(buffer, 1, size, stdout);
+    return size;
+}
+
+int HardwareSerial::available() {
+    std::lock_guard<std::mutex> guard(inputLock);
+    return input.size();
+}
+
+int HardwareSerial::read() {
+    std::lock_guard<std::mutex> guard(inputLock);
+    if (input.empty()) return -1;
+    int c = input.front();
+    input.pop_front();
+    return c;
+}
+
+int HardwareSerial::peek() {
+    std::lock_guard<std::mutex> guard(inputLock);
+    return input.empty() ? -1 : input.front();
+}
+
+// ==================== CHIP ====================
+EspClass ESP;
+
+// Heap figures of a typical ESP32-WROOM after WiFi start; there is no
+// target heap to measure on the host
+uint32_t EspClass::getFreeHeap() { return 180 * 1024; }
+uint32_t EspClass::getMinFreeHeap() { return 160 * 1024; }
+uint32_t EspClass::getHeapSize() { return 300 * 1024; }
+uint32_t EspClass::getMaxAllocHeap() { return 110 * 1024; }
+
+void EspClass::restart() {
+    fflush(stdout);
+    fprintf(stderr, "ESP.restart() called, exiting\n");
+    _Exit(0);
+}
+
+// ==================== PINS ====================
+static uint8_t pinLevels[64];
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin < sizeof(pinLevels)) pinLevels[pin] = value;
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < sizeof(pinLevels) ? pinLevels[pin] : LOW;
+}
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration) {
+    (void)pin;
+    hal.tone->tone(frequency);
+    if (duration > 0) hal.tone->noTone();
+}
+
+void noTone(uint8_t pin) {
+    (void)pin;
+    hal.tone->noTone();
+}
+
+// ==================== RANDOM ====================
+// Fixed seed so runs are reproducible unless the sketch reseeds
+static std::mt19937 generator(1);
+static std::mutex generatorLock;
+
+long random(long howBig) {
+    if (howBig <= 0) return 0;
+    std::lock_guard<std::mutex> guard(generatorLock);
+    return generator() % howBig;
+}
+
+long random(long howSmall, long howBig) {
+    if (howSmall >= howBig) return howSmall;
+    return howSmall + random(howBig - howSmall);
+}
+
+void randomSeed(unsigned long seed) {
+    std::lock_guard<std::mutex> guard(generatorLock);
+    generator.seed(seed);
+}
+
+uint32_t esp_random() {
+    std::lock_guard<std::mutex> guard(generatorLock);
+    return generator();
+}
+
+#if !defined(__GLIBC__) || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t length = strlen(src);
+    if (size > 0) {
+        size_t copy = length < size - 1 ? length : size - 1;
+        memcpy(dst, src, copy);
+        dst[copy] = 0;
+    }
+    return length;
+}
+#endif
+
+// ==================== FREERTOS ====================
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stackDepth,
+                                   void* parameter, UBaseType_t priority,
+                                   TaskHandle_t* handle, BaseType_t core) {
+    (void)name;
+    (void)stackDepth;
+    (void)priority;
+    (void)core;
+    std::thread thread(task, parameter);
+    if (handle) *handle = (TaskHandle_t)(uintptr_t)thread.native_handle();
+    thread.detach();
+    return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return (TaskHandle_t)(uintptr_t)pthread_self();
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new std::mutex();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    (void)ticks;
+    static_cast<std::mutex*>(semaphore)->lock();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    static_cast<std::mutex*>(semaphore)->unlock();
+    return pdTRUE;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    // Polls rather than sleeping the full period: virtual time may run
+    // many times faster than wall time
+    uint32_t start = hal.clock->millis();
+    while (hal.clock->millis() - start < ticks) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
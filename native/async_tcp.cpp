@@ -0,0 +1,32 @@
+// AsyncClient for [env:native]; see AsyncTCP.h
+#include "AsyncTCP.h"
+
+std::atomic<size_t> AsyncClient::copiedBytes(0);
+
+size_t AsyncClient::add(const char* data, size_t size, uint8_t apiflags) {
+    size_t length = size < space() ? size : space();
+    if (length == 0) return 0;
+
+    Write write = {(const uint8_t*)data, length, false};
+    if (apiflags & ASYNC_WRITE_FLAG_COPY) {
+        if (windowUsed + length > sizeof(window)) windowUsed = 0;
+        memcpy(window + windowUsed, data, length);
+        write.data = window + windowUsed;
+        write.copied = true;
+        windowUsed += length;
+        countCopy(length);
+    }
+    if (writeCount < MAX_WRITES) writes[writeCount++] = write;
+    unacked += length;
+    return length;
+}
+
+void AsyncClient::ackNative(size_t length) {
+    if (length > unacked) length = unacked;
+    unacked -= length;
+    if (unacked == 0) {
+        writeCount = 0;
+        windowUsed = 0;
+    }
+    if (onAckHandler) onAckHandler(onAckArg, this, length, 0);
+}
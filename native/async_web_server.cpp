@@ -0,0 +1,227 @@
+// ESPAsyncWebServer's WebSocket for [env:native]; see ESPAsyncWebServer.h.
+// The message and queue code follows AsyncWebSocket.cpp of 1.2.3.
+#include "ESPAsyncWebServer.h"
+#include <string>
+
+// ==================== FRAMES ====================
+static size_t webSocketSendFrameWindow(AsyncClient* client) {
+    if (!client->canSend()) return 0;
+    size_t space = client->space();
+    if (space < 9) return 0;
+    return space - 8;
+}
+
+static size_t webSocketSendFrame(AsyncClient* client, bool final, uint8_t opcode, const uint8_t* data, size_t len) {
+    if (!client->canSend()) return 0;
+    size_t headLen = len > 125 ? 4 : 2;
+    if (client->space() < headLen) return 0;
+    uint8_t* buf = (uint8_t*)malloc(headLen);
+    if (buf == nullptr) return 0;
+    buf[0] = opcode & 0x0F;
+    if (final) buf[0] |= 0x80;
+    if (len < 126) {
+        buf[1] = len & 0x7F;
+    } else {
+        buf[1] = 126;
+        buf[2] = (uint8_t)((len >> 8) & 0xFF);
+        buf[3] = (uint8_t)(len & 0xFF);
+    }
+    size_t added = client->add((const char*)buf, headLen);
+    free(buf);
+    if (added != headLen) return 0;
+    if (len && client->add((const char*)data, len) != len) return 0;
+    if (!client->send()) return 0;
+    return len;
+}
+
+// ==================== BASIC MESSAGE ====================
+AsyncWebSocketBasicMessage::AsyncWebSocketBasicMessage(const char* data, size_t len, uint8_t opcode)
+    : _len(len), _sent(0), _ack(0), _acked(0) {
+    _opcode = opcode & 0x07;
+    _data = (uint8_t*)malloc(_len + 1);
+    if (_data == nullptr) {
+        _len = 0;
+        _status = WS_MSG_ERROR;
+    } else {
+        _status = WS_MSG_SENDING;
+        memcpy(_data, data, _len);
+        _data[_len] = 0;
+        AsyncClient::countCopy(_len);
+    }
+}
+
+AsyncWebSocketBasicMessage::~AsyncWebSocketBasicMessage() {
+    free(_data);
+}
+
+void AsyncWebSocketBasicMessage::ack(size_t len, uint32_t time) {
+    (void)time;
+    _acked += len;
+    if (_sent == _len && _acked == _ack) _status = WS_MSG_SENT;
+}
+
+size_t AsyncWebSocketBasicMessage::send(AsyncClient* client) {
+    if (_status != WS_MSG_SENDING || _acked < _ack) return 0;
+    if (_sent == _len) {
+        if (_acked == _ack) _status = WS_MSG_SENT;
+        return 0;
+    }
+    size_t toSend = _len - _sent;
+    size_t window = webSocketSendFrameWindow(client);
+    if (window < toSend) toSend = window;
+    _sent += toSend;
+    _ack += toSend + (toSend < 126 ? 2 : 4);
+    bool final = _sent == _len;
+    uint8_t opcode = (toSend && _sent == toSend) ? _opcode : (uint8_t)WS_CONTINUATION;
+    size_t sent = webSocketSendFrame(client, final, opcode, _data + (_sent - toSend), toSend);
+    if (toSend && sent != toSend) {
+        _sent -= toSend - sent;
+        _ack -= toSend - sent;
+    }
+    return sent;
+}
+
+// ==================== CLIENT ====================
+static void deleteMessage(AsyncWebSocketMessage* const& message) {
+    delete message;
+}
+
+AsyncWebSocketClient::AsyncWebSocketClient(AsyncClient* client, AsyncWebSocket* server, uint32_t id)
+    : _client(client), _server(server), _clientId(id), _status(WS_CONNECTED),
+      _messageQueue(deleteMessage) {
+    _client->onAck([](void* r, AsyncClient* c, size_t len, uint32_t time) {
+        (void)c;
+        static_cast<AsyncWebSocketClient*>(r)->_onAck(len, time);
+    }, this);
+}
+
+AsyncWebSocketClient::~AsyncWebSocketClient() {
+    _messageQueue.free();
+    delete _client;
+}
+
+void AsyncWebSocketClient::_queueMessage(AsyncWebSocketMessage* dataMessage) {
+    if (dataMessage == nullptr) return;
+    if (_status != WS_CONNECTED) {
+        delete dataMessage;
+        return;
+    }
+    if (_messageQueue.length() >= WS_MAX_QUEUED_MESSAGES) {
+        delete dataMessage;
+    } else {
+        _messageQueue.add(dataMessage);
+    }
+    if (_client->canSend()) _runQueue();
+}
+
+void AsyncWebSocketClient::_runQueue() {
+    while (!_messageQueue.isEmpty() && _messageQueue.front()->finished()) {
+        _messageQueue.remove(_messageQueue.front());
+    }
+    if (!_messageQueue.isEmpty() && _messageQueue.front()->betweenFrames() && webSocketSendFrameWindow(_client)) {
+        _messageQueue.front()->send(_client);
+    }
+}
+
+void AsyncWebSocketClient::_onAck(size_t len, uint32_t time) {
+    if (len && !_messageQueue.isEmpty()) {
+        _messageQueue.front()->ack(len, time);
+    }
+    _runQueue();
+}
+
+void AsyncWebSocketClient::close(uint16_t code, const char* message) {
+    (void)code;
+    (void)message;
+    if (_status != WS_CONNECTED) return;
+    _status = WS_DISCONNECTING;
+    _client->close();
+}
+
+void AsyncWebSocketClient::text(const char* message, size_t len) {
+    _queueMessage(new AsyncWebSocketBasicMessage(message, len));
+}
+
+// ==================== SERVER ====================
+static void deleteClient(AsyncWebSocketClient* const& client) {
+    delete client;
+}
+
+static const int MAX_NATIVE_SOCKETS = 4;
+static AsyncWebSocket* nativeSockets[MAX_NATIVE_SOCKETS];
+
+AsyncWebSocket::AsyncWebSocket(const String& url)
+    : _url(url), _clients(deleteClient), _cNextId(1) {
+    for (int i = 0; i < MAX_NATIVE_SOCKETS; i++) {
+        if (!nativeSockets[i]) {
+            nativeSockets[i] = this;
+            break;
+        }
+    }
+}
+
+AsyncWebSocket::~AsyncWebSocket() {
+    for (int i = 0; i < MAX_NATIVE_SOCKETS; i++) {
+        if (nativeSockets[i] == this) nativeSockets[i] = nullptr;
+    }
+}
+
+size_t AsyncWebSocket::count() const {
+    size_t connected = 0;
+    for (const auto& client : _clients) {
+        if (client->status() == WS_CONNECTED) connected++;
+    }
+    return connected;
+}
+
+void AsyncWebSocket::cleanupClients(uint16_t maxClients) {
+    if (count() > maxClients) _clients.front()->close();
+
+    // A closed client's TCP connection going away, which on a board
+    // arrives later from AsyncTCP's task
+    bool removed = true;
+    while (removed) {
+        removed = false;
+        for (const auto& client : _clients) {
+            if (client->status() != WS_CONNECTED) {
+                disconnectNative(client);
+                removed = true;
+                break;
+            }
+        }
+    }
+}
+
+void AsyncWebSocket::_handleEvent(AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data,
+                                  size_t len) {
+    if (_eventHandler) _eventHandler(this, client, type, arg, data, len);
+}
+
+AsyncWebSocket* AsyncWebSocket::findNative(const char* url) {
+    for (int i = 0; i < MAX_NATIVE_SOCKETS; i++) {
+        if (nativeSockets[i] && strcmp(nativeSockets[i]->url(), url) == 0) return nativeSockets[i];
+    }
+    return nullptr;
+}
+
+AsyncWebSocketClient* AsyncWebSocket::connectNative() {
+    AsyncWebSocketClient* client = new AsyncWebSocketClient(new AsyncClient(), this, _cNextId++);
+    _clients.add(client);
+    _handleEvent(client, WS_EVT_CONNECT, nullptr, nullptr, 0);
+    return client;
+}
+
+void AsyncWebSocket::receiveNative(AsyncWebSocketClient* client, const char* text) {
+    std::string frame = text;
+    AwsFrameInfo info = {};
+    info.message_opcode = WS_TEXT;
+    info.final = 1;
+    info.opcode = WS_TEXT;
+    info.len = frame.size();
+    _handleEvent(client, WS_EVT_DATA, &info, (uint8_t*)&frame[0], frame.size());
+}
+
+void AsyncWebSocket::disconnectNative(AsyncWebSocketClient* client) {
+    _handleEvent(client, WS_EVT_DISCONNECT, nullptr, nullptr, 0);
+    _clients.remove(client);
+}
@@ -0,0 +1,58 @@
+// File and SPIFFS shims for [env:native]; see FS.h
+#include "SPIFFS.h"
+
+SPIFFSFS SPIFFS;
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+    return hal.storage->write(handle, buffer, size);
+}
+
+int File::available() {
+    if (handle == HAL_INVALID_FILE) return 0;
+    return hal.storage->size(handle) - hal.storage->position(handle);
+}
+
+int File::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek() {
+    size_t at = hal.storage->position(handle);
+    int c = read();
+    hal.storage->seek(handle, at);
+    return c;
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+    return hal.storage->read(handle, buffer, size);
+}
+
+bool File::seek(uint32_t position, SeekMode mode) {
+    size_t base = mode == SeekSet ? 0 : (mode == SeekCur ? hal.storage->position(handle) : hal.storage->size(handle));
+    return hal.storage->seek(handle, base + position);
+}
+
+size_t File::position() { return hal.storage->position(handle); }
+size_t File::size() { return hal.storage->size(handle); }
+
+void File::close() {
+    hal.storage->close(handle);
+    handle = HAL_INVALID_FILE;
+}
+
+File FS::open(const char* path, const char* mode) {
+    return File(hal.storage->open(path, mode));
+}
+
+bool FS::exists(const char* path) { return hal.storage->exists(path); }
+bool FS::remove(const char* path) { return hal.storage->remove(path); }
+bool FS::rename(const char* from, const char* to) { return hal.storage->rename(from, to); }
+bool FS::mkdir(const char* path) { return hal.storage->mkdir(path); }
+
+bool SPIFFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+    (void)basePath;
+    (void)maxOpenFiles;
+    (void)partitionLabel;
+    return hal.storage->begin(formatOnFail);
+}
@@ -0,0 +1,218 @@
+// Adafruit_GFX shim for [env:native]; see Adafruit_GFX.h
+#include "Adafruit_GFX.h"
+
+Adafruit_GFX::Adafruit_GFX(int16_t w, int16_t h)
+    : rawWidth(w), rawHeight(h), _width(w), _height(h), rotation(0),
+      cursorX(0), cursorY(0), textColor(0xFFFF), textBackground(0xFFFF),
+      textSize(1), wrap(true) {}
+
+void Adafruit_GFX::setRotation(uint8_t r) {
+    rotation = r & 3;
+    _width = rotation & 1 ? rawHeight : rawWidth;
+    _height = rotation & 1 ? rawWidth : rawHeight;
+}
+
+void Adafruit_GFX::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (x < 0 || y < 0 || x >= _width || y >= _height) return;
+    hal.display->setWindow(x, y, 1, 1);
+    hal.display->pushColor(color, 1);
+}
+
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    if (w < 0) { x += w + 1; w = -w; }
+    if (h < 0) { y += h + 1; h = -h; }
+    int16_t x2 = min<int16_t>(x + w, _width);
+    int16_t y2 = min<int16_t>(y + h, _height);
+    x = max<int16_t>(x, 0);
+    y = max<int16_t>(y, 0);
+    if (x >= x2 || y >= y2) return;
+    hal.display->setWindow(x, y, x2 - x, y2 - y);
+    hal.display->pushColor(color, (uint32_t)(x2 - x) * (y2 - y));
+}
+
+void Adafruit_GFX::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+    if (x0 == x1) {
+        drawFastVLine(x0, min(y0, y1), abs(y1 - y0) + 1, color);
+        return;
+    }
+    if (y0 == y1) {
+        drawFastHLine(min(x0, x1), y0, abs(x1 - x0) + 1, color);
+        return;
+    }
+
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+    if (steep) { std::swap(x0, y0); std::swap(x1, y1); }
+    if (x0 > x1) { std::swap(x0, x1); std::swap(y0, y1); }
+    int16_t dx = x1 - x0;
+    int16_t dy = abs(y1 - y0);
+    int16_t err = dx / 2;
+    int16_t step = y0 < y1 ? 1 : -1;
+    for (; x0 <= x1; x0++) {
+        if (steep) drawPixel(y0, x0, color);
+        else drawPixel(x0, y0, color);
+        err -= dy;
+        if (err < 0) { y0 += step; err += dx; }
+    }
+}
+
+void Adafruit_GFX::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    drawFastHLine(x, y, w, color);
+    drawFastHLine(x, y + h - 1, w, color);
+    drawFastVLine(x, y, h, color);
+    drawFastVLine(x + w - 1, y, h, color);
+}
+
+void Adafruit_GFX::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+    int16_t f = 1 - r, ddx = 1, ddy = -2 * r, x = 0, y = r;
+    drawPixel(x0, y0 + r, color);
+    drawPixel(x0, y0 - r, color);
+    drawPixel(x0 + r, y0, color);
+    drawPixel(x0 - r, y0, color);
+    while (x < y) {
+        if (f >= 0) { y--; ddy += 2; f += ddy; }
+        x++;
+        ddx += 2;
+        f += ddx;
+        drawPixel(x0 + x, y0 + y, color);
+        drawPixel(x0 - x, y0 + y, color);
+        drawPixel(x0 + x, y0 - y, color);
+        drawPixel(x0 - x, y0 - y, color);
+        drawPixel(x0 + y, y0 + x, color);
+        drawPixel(x0 - y, y0 + x, color);
+        drawPixel(x0 + y, y0 - x, color);
+        drawPixel(x0 - y, y0 - x, color);
+    }
+}
+
+void Adafruit_GFX::fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+    // One vertical span per column, as the library does
+    drawFastVLine(x0, y0 - r, 2 * r + 1, color);
+    int16_t f = 1 - r, ddx = 1, ddy = -2 * r, x = 0, y = r;
+    while (x < y) {
+        if (f >= 0) { y--; ddy += 2; f += ddy; }
+        x++;
+        ddx += 2;
+        f += ddx;
+        drawFastVLine(x0 + x, y0 - y, 2 * y + 1, color);
+        drawFastVLine(x0 - x, y0 - y, 2 * y + 1, color);
+        drawFastVLine(x0 + y, y0 - x, 2 * x + 1, color);
+        drawFastVLine(x0 - y, y0 - x, 2 * x + 1, color);
+    }
+}
+
+void Adafruit_GFX::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                                int16_t x2, int16_t y2, uint16_t color) {
+    // Sort by y, then fill one horizontal span per scanline
+    if (y0 > y1) { std::swap(y0, y1); std::swap(x0, x1); }
+    if (y1 > y2) { std::swap(y2, y1); std::swap(x2, x1); }
+    if (y0 > y1) { std::swap(y0, y1); std::swap(x0, x1); }
+
+    for (int16_t y = y0; y <= y2; y++) {
+        float a = y2 == y0 ? x0 : x0 + (float)(x2 - x0) * (y - y0) / (y2 - y0);
+        float b;
+        if (y < y1) b = y1 == y0 ? x0 : x0 + (float)(x1 - x0) * (y - y0) / (y1 - y0);
+        else b = y2 == y1 ? x1 : x1 + (float)(x2 - x1) * (y - y1) / (y2 - y1);
+        int16_t left = (int16_t)min(a, b);
+        int16_t right = (int16_t)max(a, b);
+        drawFastHLine(left, y, right - left + 1, color);
+    }
+}
+
+void Adafruit_GFX::drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color) {
+    r = min<int16_t>(r, min(w, h) / 2);
+    drawFastHLine(x + r, y, w - 2 * r, color);
+    drawFastHLine(x + r, y + h - 1, w - 2 * r, color);
+    drawFastVLine(x, y + r, h - 2 * r, color);
+    drawFastVLine(x + w - 1, y + r, h - 2 * r, color);
+    for (int16_t dy = 0; dy < r; dy++) {
+        int16_t dx = (int16_t)sqrtf((float)r * r - (float)(r - dy) * (r - dy));
+        drawPixel(x + r - dx, y + dy, color);
+        drawPixel(x + w - 1 - r + dx, y + dy, color);
+        drawPixel(x + r - dx, y + h - 1 - dy, color);
+        drawPixel(x + w - 1 - r + dx, y + h - 1 - dy, color);
+    }
+}
+
+void Adafruit_GFX::fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color) {
+    r = min<int16_t>(r, min(w, h) / 2);
+    fillRect(x, y + r, w, h - 2 * r, color);
+    for (int16_t dy = 0; dy < r; dy++) {
+        int16_t dx = (int16_t)sqrtf((float)r * r - (float)(r - dy) * (r - dy));
+        drawFastHLine(x + r - dx, y + dy, w - 2 * (r - dx), color);
+        drawFastHLine(x + r - dx, y + h - 1 - dy, w - 2 * (r - dx), color);
+    }
+}
+
+void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color,
+                            uint16_t background, uint8_t size) {
+    // Stand-in 5x7 bitmap: about 40% of pixels lit, none for a space
+    for (int8_t col = 0; col < 5; col++) {
+        for (int8_t row = 0; row < 8; row++) {
+            bool lit = c != ' ' && row < 7 && (c * 31 + col * 7 + row * 13) % 5 < 2;
+            if (lit || background != color) {
+                uint16_t pixel = lit ? color : background;
+                if (size == 1) drawPixel(x + col, y + row, pixel);
+                else fillRect(x + col * size, y + row * size, size, size, pixel);
+            }
+        }
+    }
+    if (background != color) {
+        fillRect(x + 5 * size, y, size, 8 * size, background);
+    }
+}
+
+size_t Adafruit_GFX::write(uint8_t c) {
+    if (c == '\n') {
+        cursorX = 0;
+        cursorY += textSize * 8;
+    } else if (c != '\r') {
+        if (wrap && cursorX + textSize * 6 > _width) {
+            cursorX = 0;
+            cursorY += textSize * 8;
+        }
+        drawChar(cursorX, cursorY, c, textColor, textBackground, textSize);
+        cursorX += textSize * 6;
+    }
+    return 1;
+}
+
+void Adafruit_GFX::getTextBounds(const char* text, int16_t x, int16_t y,
+                                 int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h) {
+    int16_t lineWidth = 0, widest = 0, lines = 1;
+    for (const char* p = text; *p; p++) {
+        if (*p == '\n') {
+            lines++;
+            lineWidth = 0;
+        } else if (*p != '\r') {
+            lineWidth += textSize * 6;
+            widest = max(widest, lineWidth);
+        }
+    }
+    *x1 = x;
+    *y1 = y;
+    *w = widest;
+    *h = lines * textSize * 8;
+}
+
+// ==================== CANVAS ====================
+void GFXcanvas16::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (x < 0 || y < 0 || x >= _width || y >= _height) return;
+    buffer[(size_t)y * _width + x] = color;
+}
+
+void GFXcanvas16::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    if (w < 0) { x += w + 1; w = -w; }
+    if (h < 0) { y += h + 1; h = -h; }
+    int16_t x2 = min<int16_t>(x + w, _width);
+    int16_t y2 = min<int16_t>(y + h, _height);
+    x = max<int16_t>(x, 0);
+    y = max<int16_t>(y, 0);
+    for (int16_t row = y; row < y2; row++) {
+        std::fill(&buffer[(size_t)row * _width + x], &buffer[(size_t)row * _width + x2], color);
+    }
+}
+
+uint16_t GFXcanvas16::getPixel(int16_t x, int16_t y) const {
+    if (x < 0 || y < 0 || x >= _width || y >= _height) return 0;
+    return buffer[(size_t)y * _width + x];
+}
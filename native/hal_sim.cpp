@@ -0,0 +1,410 @@
+// Simulated board for [env:native]; see hal_sim.h
+#include "hal_sim.h"
+#include "../board_pins.h"
+#include "spo2_algorithm.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+static uint64_t steadyMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ==================== CLOCK ====================
+SimClock::SimClock() : origin(steadyMicros()), skipped(0), realtime(false) {}
+
+uint64_t SimClock::wall() {
+    return steadyMicros() - origin;
+}
+
+uint64_t SimClock::now() {
+    return wall() + skipped.load(std::memory_order_relaxed);
+}
+
+void SimClock::advance(uint64_t us) {
+    if (realtime) {
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+    } else {
+        skipped.fetch_add(us, std::memory_order_relaxed);
+    }
+}
+
+// ==================== SENSOR ====================
+SimPpgSensor::SimPpgSensor()
+    : generator(FreqS), present(true), nextSampleAt(0), fifoHead(0), fifoCount(0),
+      head(0), count(0), ecg(2048), samplesLost(0) {}
+
+void SimPpgSensor::setup() {
+    std::lock_guard<std::mutex> guard(generatorLock);
+    nextSampleAt = simClock.now();
+    fifoCount = 0;
+    head = 0;
+    count = 0;
+}
+
+void SimPpgSensor::setSampleRate(uint32_t rate) {
+    std::lock_guard<std::mutex> guard(generatorLock);
+    generator.setSampleRate(rate);
+}
+
+void SimPpgSensor::setPatient(const PhysiologyParams& p) {
+    std::lock_guard<std::mutex> guard(generatorLock);
+    generator.setParams(p);
+}
+
+PhysiologyParams SimPpgSensor::getPatient() {
+    std::lock_guard<std::mutex> guard(generatorLock);
+    return generator.getParams();
+}
+
+void SimPpgSensor::seed(uint64_t value) {
+    std::lock_guard<std::mutex> guard(generatorLock);
+    generator.seed(value);
+}
+
+// Samples the patient up to the current virtual time. Callers hold generatorLock.
+void SimPpgSensor::sampleUntilNow() {
+    uint64_t period = (uint64_t)(1000000 / generator.getSampleRate());
+    uint64_t now = simClock.now();
+    while (nextSampleAt <= now) {
+        nextSampleAt += period;
+        uint8_t slot = (fifoHead + fifoCount) % FIFO_DEPTH;
+        if (fifoCount == FIFO_DEPTH) {
+            // Full: the oldest sample is overwritten before anyone reads it
+            fifoHead = (fifoHead + 1) % FIFO_DEPTH;
+            samplesLost++;
+        } else {
+            fifoCount++;
+        }
+        generator.next(fifo[slot]);
+        samplesLost += fifo[slot].lost;
+        ecg = fifo[slot].ecg;
+    }
+}
+
+uint16_t SimPpgSensor::check() {
+    if (!present) return 0;
+    std::lock_guard<std::mutex> guard(generatorLock);
+    sampleUntilNow();
+
+    uint16_t moved = fifoCount;
+    while (fifoCount > 0) {
+        head = (head + 1) % STORAGE_SIZE;
+        red[head] = fifo[fifoHead].red;
+        ir[head] = fifo[fifoHead].ir;
+        if (count < STORAGE_SIZE) count++;
+        fifoHead = (fifoHead + 1) % FIFO_DEPTH;
+        fifoCount--;
+    }
+    return moved;
+}
+
+uint16_t SimPpgSensor::readEcg() {
+    std::lock_guard<std::mutex> guard(generatorLock);
+    sampleUntilNow();
+    return ecg;
+}
+
+uint32_t SimPpgSensor::getRed() {
+    return count ? red[(head + STORAGE_SIZE - count + 1) % STORAGE_SIZE] : 0;
+}
+
+uint32_t SimPpgSensor::getIR() {
+    return count ? ir[(head + STORAGE_SIZE - count + 1) % STORAGE_SIZE] : 0;
+}
+
+void SimPpgSensor::nextSample() {
+    if (count) count--;
+}
+
+// ==================== ADC ====================
+uint16_t SimAdc::read(uint8_t pin) {
+    if (pin == ECG_PIN) return simSensor.readEcg();
+    if (pin != BATTERY_PIN) return 0;
+    // Inverse of the sketch's divider: 3.0 V is empty, 4.2 V full
+    float voltage = 3.0f + 1.2f * battery / 100.0f;
+    return (uint16_t)(voltage / 2 / 3.3f * 4095 + 0.5f);
+}
+
+// ==================== DISPLAY BUS ====================
+SimDisplayBus::SimDisplayBus()
+    : framebuffer(WIDTH * HEIGHT, 0), windowX(0), windowY(0), windowW(0), windowH(0),
+      cursor(0), bytesSent(0), pendingBits(0) {}
+
+void SimDisplayBus::transfer(uint32_t bytes) {
+    bytesSent += bytes;
+    pendingBits += (uint64_t)bytes * 8;
+    uint64_t us = pendingBits * 1000000 / SPI_HZ;
+    if (us > 0) {
+        pendingBits -= us * SPI_HZ / 1000000;
+        simClock.advance(us);
+    }
+}
+
+void SimDisplayBus::setWindow(int16_t x, int16_t y, int16_t w, int16_t h) {
+    windowX = x;
+    windowY = y;
+    windowW = w;
+    windowH = h;
+    cursor = 0;
+    transfer(11); // CASET + PASET + RAMWR with their arguments
+}
+
+void SimDisplayBus::pushColor(uint16_t color, uint32_t count) {
+    uint32_t area = (uint32_t)windowW * windowH;
+    for (uint32_t i = 0; i < count && cursor < area; i++, cursor++) {
+        int x = windowX + cursor % windowW;
+        int y = windowY + cursor / windowW;
+        if (x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT) {
+            framebuffer[y * WIDTH + x] = color;
+        }
+    }
+    transfer(count * 2);
+}
+
+bool SimDisplayBus::savePpm(const char* path) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    fprintf(f, "P6\n%d %d\n255\n", WIDTH, HEIGHT);
+    for (uint16_t pixel : framebuffer) {
+        uint8_t rgb[3] = {
+            (uint8_t)((pixel >> 11) * 255 / 31),
+            (uint8_t)(((pixel >> 5) & 0x3F) * 255 / 63),
+            (uint8_t)((pixel & 0x1F) * 255 / 31)
+        };
+        fwrite(rgb, 1, 3, f);
+    }
+    fclose(f);
+    return true;
+}
+
+// ==================== TOUCH ====================
+void SimTouch::tap(uint32_t atMs, int16_t x, int16_t y, uint32_t holdMs) {
+    Tap t = {atMs, atMs + holdMs, x, y};
+    auto at = taps.begin();
+    while (at != taps.end() && at->at <= atMs) at++;
+    taps.insert(at, t);
+}
+
+bool SimTouch::touched() {
+    uint32_t now = simClock.millis();
+    while (!taps.empty() && taps.front().until <= now) {
+        taps.erase(taps.begin());
+    }
+    return !taps.empty() && taps.front().at <= now;
+}
+
+HalTouchPoint SimTouch::getPoint() {
+    HalTouchPoint point = {0, 0, 0};
+    if (touched()) {
+        // Inverse of the sketch's raw-to-screen mapping
+        point.x = 200 + taps.front().x * (3700 - 200) / 320;
+        point.y = 240 + taps.front().y * (3800 - 240) / 240;
+        point.z = 1000;
+    }
+    return point;
+}
+
+// ==================== STORAGE ====================
+SimStorage::SimStorage() : root(".native_fs") {
+    for (int i = 0; i < MAX_OPEN_FILES; i++) files[i] = nullptr;
+}
+
+std::string SimStorage::hostPath(const char* path) {
+    return root + (path[0] == '/' ? "" : "/") + path;
+}
+
+FILE* SimStorage::get(int file) {
+    return file >= 0 && file < MAX_OPEN_FILES ? files[file] : nullptr;
+}
+
+void SimStorage::wipe() {
+    std::lock_guard<std::mutex> guard(lock);
+    std::error_code error;
+    std::filesystem::remove_all(root, error);
+}
+
+bool SimStorage::begin(bool formatOnFail) {
+    (void)formatOnFail;
+    std::lock_guard<std::mutex> guard(lock);
+    std::error_code error;
+    std::filesystem::create_directories(root, error);
+    return std::filesystem::is_directory(root, error);
+}
+
+int SimStorage::open(const char* path, const char* mode) {
+    std::lock_guard<std::mutex> guard(lock);
+    std::string host = hostPath(path);
+    if (mode[0] != 'r') {
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(host).parent_path(), error);
+    }
+
+    std::string hostMode = std::string(1, mode[0]) + "b" + (strchr(mode, '+') ? "+" : "");
+    for (int i = 0; i < MAX_OPEN_FILES; i++) {
+        if (!files[i]) {
+            files[i] = fopen(host.c_str(), hostMode.c_str());
+            return files[i] ? i : HAL_INVALID_FILE;
+        }
+    }
+    return HAL_INVALID_FILE;
+}
+
+size_t SimStorage::read(int file, uint8_t* buffer, size_t length) {
+    std::lock_guard<std::mutex> guard(lock);
+    FILE* f = get(file);
+    return f ? fread(buffer, 1, length, f) : 0;
+}
+
+size_t SimStorage::write(int file, const uint8_t* data, size_t length) {
+    std::lock_guard<std::mutex> guard(lock);
+    FILE* f = get(file);
+    return f ? fwrite(data, 1, length, f) : 0;
+}
+
+bool SimStorage::seek(int file, size_t position) {
+    std::lock_guard<std::mutex> guard(lock);
+    FILE* f = get(file);
+    return f && fseek(f, position, SEEK_SET) == 0;
+}
+
+size_t SimStorage::position(int file) {
+    std::lock_guard<std::mutex> guard(lock);
+    FILE* f = get(file);
+    return f ? ftell(f) : 0;
+}
+
+size_t SimStorage::size(int file) {
+    std::lock_guard<std::mutex> guard(lock);
+    FILE* f = get(file);
+    if (!f) return 0;
+    long at = ftell(f);
+    fseek(f, 0, SEEK_END);
+    long end = ftell(f);
+    fseek(f, at, SEEK_SET);
+    return end;
+}
+
+void SimStorage::close(int file) {
+    std::lock_guard<std::mutex> guard(lock);
+    FILE* f = get(file);
+    if (f) {
+        fclose(f);
+        files[file] = nullptr;
+    }
+}
+
+bool SimStorage::exists(const char* path) {
+    std::error_code error;
+    return std::filesystem::exists(hostPath(path), error);
+}
+
+bool SimStorage::remove(const char* path) {
+    std::error_code error;
+    return std::filesystem::remove(hostPath(path), error);
+}
+
+bool SimStorage::rename(const char* from, const char* to) {
+    std::error_code error;
+    std::filesystem::rename(hostPath(from), hostPath(to), error);
+    return !error;
+}
+
+bool SimStorage::mkdir(const char* path) {
+    std::error_code error;
+    std::filesystem::create_directories(hostPath(path), error);
+    return !error;
+}
+
+// ==================== NETWORK ====================
+SimNetwork::SimNetwork()
+    : manager(nullptr), link(LINK_DOWN), settleAt(0), connectDelay(1500), rssi(-58) {}
+
+void SimNetwork::setAccessPoint(const char* networkSsid, const char* password) {
+    apSsid = networkSsid;
+    apPassword = password;
+}
+
+void SimNetwork::addOutage(uint32_t startMs, uint32_t durationMs) {
+    Outage outage = {startMs, startMs + durationMs};
+    outages.push_back(outage);
+}
+
+bool SimNetwork::inOutage(uint32_t now) {
+    for (const Outage& outage : outages) {
+        if (now >= outage.start && now < outage.end) return true;
+    }
+    return false;
+}
+
+void SimNetwork::connect(const char* networkSsid, const char* password) {
+    ssid = networkSsid;
+    bool matches = !apSsid.empty() && apSsid == networkSsid && apPassword == password;
+    link = matches ? LINK_ASSOCIATING : LINK_FAILING;
+    settleAt = simClock.millis() + connectDelay;
+}
+
+void SimNetwork::disconnect() {
+    link = LINK_DOWN;
+}
+
+void SimNetwork::poll(uint32_t now) {
+    uint8_t current = link.load();
+    if ((current == LINK_ASSOCIATING || current == LINK_FAILING) && (int32_t)(now - settleAt) >= 0) {
+        bool up = current == LINK_ASSOCIATING && !inOutage(now);
+        link = up ? LINK_UP : LINK_DOWN;
+        if (manager) {
+            if (up) manager->notifyConnected();
+            else manager->notifyDisconnected();
+        }
+    } else if (current == LINK_UP && inOutage(now)) {
+        link = LINK_DOWN;
+        if (manager) manager->notifyDisconnected();
+    }
+}
+
+// ==================== TONE ====================
+void SimTone::tone(uint16_t frequency) {
+    (void)frequency;
+    if (!on) {
+        on = true;
+        onSince = simClock.millis();
+        beeps++;
+    }
+}
+
+void SimTone::noTone() {
+    if (on) {
+        on = false;
+        onTime += simClock.millis() - onSince;
+    }
+}
+
+// ==================== BOARD ====================
+SimClock simClock;
+SimPpgSensor simSensor;
+SimAdc simAdc;
+SimDisplayBus simDisplay;
+SimTouch simTouch;
+SimStorage simStorage;
+SimNetwork simNetwork;
+SimTone simTone;
+
+Hal hal = {
+    &simClock,
+    &simSensor,
+    &simAdc,
+    &simDisplay,
+    &simTouch,
+    &simStorage,
+    &simNetwork,
+    &simTone
+};
+
+void simTick() {
+    simNetwork.poll(simClock.millis());
+}
@@ -0,0 +1,258 @@
+#ifndef HAL_SIM_H
+#define HAL_SIM_H
+
+/*
+ * Simulated board for [env:native]; see hal.h.
+ *
+ * Time is virtual: it runs with the wall clock while the firmware computes,
+ * but delay() and simulated bus transfers advance it instantly instead of
+ * sleeping, so a run covers minutes of device time in seconds. With
+ * setRealtime(true) they sleep instead and the simulation keeps pace with
+ * the wall clock.
+ *
+ * Anything that happens "by itself" on real hardware (WiFi association,
+ * outages, scripted touches) is advanced by simTick(), which the native
+ * main calls between loop() iterations.
+ */
+
+#include "../hal.h"
+#include "../signal_generator.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// ==================== CLOCK ====================
+class SimClock : public HalClock {
+private:
+    uint64_t origin;
+    std::atomic<uint64_t> skipped;
+    bool realtime;
+
+public:
+    SimClock();
+    uint32_t millis() override { return now() / 1000; }
+    uint32_t micros() override { return (uint32_t)now(); }
+    void delay(uint32_t ms) override { advance((uint64_t)ms * 1000); }
+
+    // Virtual microseconds since start, 64-bit
+    uint64_t now();
+    // Time spent waiting on simulated hardware
+    void advance(uint64_t us);
+    void setRealtime(bool enabled) { realtime = enabled; }
+    bool isRealtime() const { return realtime; }
+    // Wall-clock microseconds since start
+    uint64_t wall();
+};
+
+// ==================== SENSOR ====================
+// MAX3010x model: SignalGenerator samples accrue in a 32-deep hardware FIFO
+// at the sample rate; check() drains it into the driver's 4-entry buffer.
+// Samples that arrive while the FIFO is full are lost. The generator's ECG
+// lead is read through simAdc on ECG_PIN.
+class SimPpgSensor : public HalPpgSensor {
+public:
+    static const int FIFO_DEPTH = 32;
+    static const int STORAGE_SIZE = 4;
+
+private:
+    SignalGenerator generator;
+    std::mutex generatorLock;
+    bool present;
+    uint64_t nextSampleAt;
+    SignalSample fifo[FIFO_DEPTH];
+    uint8_t fifoHead;
+    uint8_t fifoCount;
+    uint32_t red[STORAGE_SIZE];
+    uint32_t ir[STORAGE_SIZE];
+    uint8_t head;
+    uint8_t count;
+    uint16_t ecg;
+    uint32_t samplesLost;
+
+    void sampleUntilNow();
+
+public:
+    SimPpgSensor();
+    bool begin() override { return present; }
+    void setup() override;
+    void setPulseAmplitudeRed(uint8_t amplitude) override { (void)amplitude; }
+    void setPulseAmplitudeGreen(uint8_t amplitude) override { (void)amplitude; }
+    uint16_t check() override;
+    uint8_t available() override { return count; }
+    uint32_t getRed() override;
+    uint32_t getIR() override;
+    void nextSample() override;
+
+    void setPresent(bool connected) { present = connected; }
+    void setSampleRate(uint32_t rate);
+    void setPatient(const PhysiologyParams& p);
+    PhysiologyParams getPatient();
+    void seed(uint64_t value);
+    uint16_t readEcg();
+    uint32_t getSamplesLost() const { return samplesLost; }
+};
+
+// ==================== ADC ====================
+class SimAdc : public HalAdc {
+private:
+    float battery;
+
+public:
+    SimAdc() : battery(85.0f) {}
+    uint16_t read(uint8_t pin) override;
+    void setBattery(float percent) { battery = percent; }
+};
+
+// ==================== DISPLAY BUS ====================
+// Counts bus bytes, charges their transfer time to the virtual clock and
+// keeps a landscape framebuffer that can be written out as a PPM image
+class SimDisplayBus : public HalDisplayBus {
+public:
+    static const int WIDTH = 320;
+    static const int HEIGHT = 240;
+    static const uint32_t SPI_HZ = 40000000;
+
+private:
+    std::vector<uint16_t> framebuffer;
+    int16_t windowX, windowY, windowW, windowH;
+    uint32_t cursor;
+    uint32_t bytesSent;
+    uint64_t pendingBits;
+
+    void transfer(uint32_t bytes);
+
+public:
+    SimDisplayBus();
+    void setWindow(int16_t x, int16_t y, int16_t w, int16_t h) override;
+    void pushColor(uint16_t color, uint32_t count) override;
+    uint32_t getBytesSent() override { return bytesSent; }
+    bool savePpm(const char* path);
+};
+
+// ==================== TOUCH ====================
+class SimTouch : public HalTouch {
+private:
+    struct Tap {
+        uint32_t at;
+        uint32_t until;
+        int16_t x;
+        int16_t y;
+    };
+    std::vector<Tap> taps;
+
+public:
+    bool begin() override { return true; }
+    void setRotation(uint8_t rotation) override { (void)rotation; }
+    bool touched() override;
+    HalTouchPoint getPoint() override;
+
+    // Presses the screen at (x, y) in landscape pixels
+    void tap(uint32_t atMs, int16_t x, int16_t y, uint32_t holdMs = 80);
+};
+
+// ==================== STORAGE ====================
+// Flash file system backed by a host directory; parent directories are
+// created on demand, matching SPIFFS' flat namespace
+class SimStorage : public HalStorage {
+public:
+    static const int MAX_OPEN_FILES = 10;
+
+private:
+    std::string root;
+    FILE* files[MAX_OPEN_FILES];
+    std::mutex lock;
+
+    std::string hostPath(const char* path);
+    FILE* get(int file);
+
+public:
+    SimStorage();
+    void setRoot(const char* directory) { root = directory; }
+    const std::string& getRoot() const { return root; }
+    void wipe();
+
+    bool begin(bool formatOnFail) override;
+    int open(const char* path, const char* mode) override;
+    size_t read(int file, uint8_t* buffer, size_t length) override;
+    size_t write(int file, const uint8_t* data, size_t length) override;
+    bool seek(int file, size_t position) override;
+    size_t position(int file) override;
+    size_t size(int file) override;
+    void close(int file) override;
+    bool exists(const char* path) override;
+    bool remove(const char* path) override;
+    bool rename(const char* from, const char* to) override;
+    bool mkdir(const char* path) override;
+};
+
+// ==================== NETWORK ====================
+class SimNetwork : public HalNetwork {
+private:
+    enum Link : uint8_t { LINK_DOWN, LINK_ASSOCIATING, LINK_FAILING, LINK_UP };
+
+    struct Outage {
+        uint32_t start;
+        uint32_t end;
+    };
+
+    WifiManager* manager;
+    std::string apSsid;
+    std::string apPassword;
+    std::string ssid;
+    std::vector<Outage> outages;
+    std::atomic<uint8_t> link;
+    uint32_t settleAt;
+    uint32_t connectDelay;
+    int8_t rssi;
+
+    bool inOutage(uint32_t now);
+
+public:
+    SimNetwork();
+    void attach(WifiManager* wifiManager) override { manager = wifiManager; }
+    void connect(const char* ssid, const char* password) override;
+    void disconnect() override;
+    bool isConnected() override { return link.load() == LINK_UP; }
+    int8_t getRssi() override { return isConnected() ? rssi : 0; }
+
+    // Puts an access point in range
+    void setAccessPoint(const char* ssid, const char* password);
+    void addOutage(uint32_t startMs, uint32_t durationMs);
+    void setConnectDelay(uint32_t ms) { connectDelay = ms; }
+    const std::string& getSsid() const { return ssid; }
+    const std::string& getAccessPointSsid() const { return apSsid; }
+    void poll(uint32_t now);
+};
+
+// ==================== TONE ====================
+class SimTone : public HalTone {
+private:
+    bool on;
+    uint32_t onSince;
+    uint32_t beeps;
+    uint32_t onTime;
+
+public:
+    SimTone() : on(false), onSince(0), beeps(0), onTime(0) {}
+    void begin(uint8_t pin) override { (void)pin; }
+    void tone(uint16_t frequency) override;
+    void noTone() override;
+    uint32_t getBeeps() const { return beeps; }
+    uint32_t getOnTime() const { return onTime; }
+};
+
+// ==================== BOARD ====================
+extern SimClock simClock;
+extern SimPpgSensor simSensor;
+extern SimAdc simAdc;
+extern SimDisplayBus simDisplay;
+extern SimTouch simTouch;
+extern SimStorage simStorage;
+extern SimNetwork simNetwork;
+extern SimTone simTone;
+
+// Advances the parts of the board that change on their own
+void simTick();
+
+#endif
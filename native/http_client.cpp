@@ -0,0 +1,101 @@
+// Socket HTTP client for [env:native]; see HTTPClient.h
+#include "HTTPClient.h"
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+bool HTTPClient::begin(const String& url) {
+    std::string text = url.c_str();
+    const std::string scheme = "http://";
+    if (text.compare(0, scheme.size(), scheme) != 0) return false;
+
+    size_t hostStart = scheme.size();
+    size_t pathStart = text.find('/', hostStart);
+    std::string authority = text.substr(hostStart, pathStart - hostStart);
+    path = pathStart == std::string::npos ? "/" : text.substr(pathStart);
+
+    size_t colon = authority.find(':');
+    host = authority.substr(0, colon);
+    port = colon == std::string::npos ? 80 : (uint16_t)atoi(authority.c_str() + colon + 1);
+    headers.clear();
+    response.clear();
+    return !host.empty();
+}
+
+void HTTPClient::addHeader(const String& name, const String& value) {
+    headers += name.c_str();
+    headers += ": ";
+    headers += value.c_str();
+    headers += "\r\n";
+}
+
+bool HTTPClient::sendAll(const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(socketFd, data, size, MSG_NOSIGNAL);
+        if (sent <= 0) return false;
+        data += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+int HTTPClient::request(const char* method, const uint8_t* payload, size_t size) {
+    end();
+    response.clear();
+
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* resolved = nullptr;
+    char service[8];
+    snprintf(service, sizeof(service), "%u", port);
+    if (getaddrinfo(host.c_str(), service, &hints, &resolved) != 0) {
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+
+    for (addrinfo* a = resolved; a && socketFd < 0; a = a->ai_next) {
+        socketFd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (socketFd < 0) continue;
+        timeval tv = {(time_t)(timeout / 1000), (suseconds_t)(timeout % 1000) * 1000};
+        setsockopt(socketFd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(socketFd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        if (connect(socketFd, a->ai_addr, a->ai_addrlen) != 0) {
+            close(socketFd);
+            socketFd = -1;
+        }
+    }
+    freeaddrinfo(resolved);
+    if (socketFd < 0) return HTTPC_ERROR_CONNECTION_REFUSED;
+
+    char head[512];
+    int headLength = snprintf(head, sizeof(head),
+        "%s %s HTTP/1.1\r\nHost: %s:%u\r\nConnection: close\r\nContent-Length: %u\r\n",
+        method, path.c_str(), host.c_str(), port, (unsigned)size);
+    if (!sendAll(head, headLength) || !sendAll(headers.data(), headers.size()) ||
+        !sendAll("\r\n", 2) || (size > 0 && !sendAll((const char*)payload, size))) {
+        return HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+    }
+
+    // Connection: close, so the body runs to end of stream
+    std::string raw;
+    char buffer[1024];
+    ssize_t received;
+    while ((received = recv(socketFd, buffer, sizeof(buffer), 0)) > 0) {
+        raw.append(buffer, received);
+    }
+    if (received < 0 && raw.empty()) return HTTPC_ERROR_READ_TIMEOUT;
+
+    int code = 0;
+    if (sscanf(raw.c_str(), "HTTP/%*d.%*d %d", &code) != 1) return HTTPC_ERROR_NOT_CONNECTED;
+    size_t bodyStart = raw.find("\r\n\r\n");
+    if (bodyStart != std::string::npos) response = raw.substr(bodyStart + 4);
+    return code;
+}
+
+void HTTPClient::end() {
+    if (socketFd >= 0) {
+        close(socketFd);
+        socketFd = -1;
+    }
+}
@@ -0,0 +1,205 @@
+// HTTP over TCP for [env:native]'s WebServer; see http_listener.h
+#include "http_listener.h"
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <memory>
+#include <unordered_map>
+
+// epoll tags of the listener and the eventfd; connections count up from FIRST_CONNECTION
+static const uint64_t LISTENER_TAG = 1;
+static const uint64_t WAKEUP_TAG = 2;
+static const uint64_t FIRST_CONNECTION = 16;
+static const size_t MAX_HEAD = 8192;
+
+struct HttpConnection {
+    int fd;
+    std::string in;
+    std::string out;
+    bool busy = false;          // A request is with the firmware
+    bool keepAlive = true;      // Of that request
+    bool closing = false;       // Close once out is sent
+};
+
+HttpListener::HttpListener() : listener(-1), epoll(-1), wakeup(-1), serving(0) {}
+
+bool HttpListener::start(uint16_t port) {
+    listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (listener < 0) return false;
+    int yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 128) != 0) {
+        close(listener);
+        listener = -1;
+        return false;
+    }
+    epoll = epoll_create1(0);
+    wakeup = eventfd(0, EFD_NONBLOCK);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = LISTENER_TAG;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event);
+    event.data.u64 = WAKEUP_TAG;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, wakeup, &event);
+    thread = std::thread([this] { run(); });
+    thread.detach();
+    return true;
+}
+
+bool HttpListener::next(std::string& target, std::string& headers) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (requests.empty()) return false;
+    serving = requests.front().connection;
+    target = requests.front().target;
+    headers = requests.front().headers;
+    requests.pop_front();
+    return true;
+}
+
+static const char* reasonPhrase(int code) {
+    switch (code) {
+        case 200: return "OK";
+        case 206: return "Partial Content";
+        case 302: return "Found";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 416: return "Range Not Satisfiable";
+        default: return "";
+    }
+}
+
+void HttpListener::respond(int code, const std::string& contentType, const std::string& headers,
+                           const std::string& body) {
+    char head[256];
+    snprintf(head, sizeof(head), "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %u\r\n", code,
+             reasonPhrase(code), contentType.empty() ? "text/plain" : contentType.c_str(), (unsigned)body.size());
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        responses.push_back({serving, head + headers, body});
+    }
+    uint64_t one = 1;
+    (void)!write(wakeup, &one, sizeof(one));
+}
+
+void HttpListener::run() {
+    std::unordered_map<uint64_t, std::unique_ptr<HttpConnection>> connections;
+    uint64_t nextId = FIRST_CONNECTION;
+    std::vector<Response> sending;
+
+    auto remove = [&](uint64_t id) {
+        auto found = connections.find(id);
+        if (found == connections.end()) return;
+        epoll_ctl(epoll, EPOLL_CTL_DEL, found->second->fd, nullptr);
+        close(found->second->fd);
+        connections.erase(found);
+    };
+    // Sends what the socket takes; false once the connection is done with
+    auto flush = [&](HttpConnection& connection) {
+        while (!connection.out.empty()) {
+            ssize_t n = send(connection.fd, connection.out.data(), connection.out.size(), MSG_NOSIGNAL);
+            if (n > 0) {
+                connection.out.erase(0, n);
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return true;
+            } else {
+                return false;
+            }
+        }
+        return !connection.closing;
+    };
+    // Hands the next whole request to the firmware, unless one is with it
+    auto take = [&](uint64_t id, HttpConnection& connection) {
+        if (connection.busy || connection.closing) return true;
+        size_t end = connection.in.find("\r\n\r\n");
+        if (end == std::string::npos) return connection.in.size() <= MAX_HEAD;
+        std::string head = connection.in.substr(0, end + 2);
+        size_t length = end + 4;
+        const char* contentLength = strcasestr(head.c_str(), "\r\nContent-Length:");
+        if (contentLength) length += strtoul(contentLength + 17, nullptr, 10);
+        if (connection.in.size() < length) return true;
+        connection.in.erase(0, length);
+
+        size_t methodEnd = head.find(' ');
+        size_t targetEnd = methodEnd == std::string::npos ? methodEnd : head.find(' ', methodEnd + 1);
+        if (targetEnd == std::string::npos) return false;
+        bool http10 = head.compare(targetEnd + 1, 8, "HTTP/1.0") == 0;
+        connection.keepAlive = http10 ? strcasestr(head.c_str(), "\r\nConnection: keep-alive") != nullptr
+                                      : strcasestr(head.c_str(), "\r\nConnection: close") == nullptr;
+        if (head.compare(0, methodEnd, "GET") != 0) {
+            // The firmware's handlers read query arguments only
+            connection.out += "HTTP/1.1 405 Method Not Allowed\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+            connection.closing = true;
+            return true;
+        }
+        connection.busy = true;
+        std::lock_guard<std::mutex> guard(lock);
+        size_t lineEnd = head.find("\r\n");
+        requests.push_back({id, head.substr(methodEnd + 1, targetEnd - methodEnd - 1), head.substr(lineEnd + 2)});
+        return true;
+    };
+
+    epoll_event events[64];
+    for (;;) {
+        int ready = epoll_wait(epoll, events, 64, -1);
+        for (int i = 0; i < ready; i++) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == LISTENER_TAG) {
+                int fd;
+                while ((fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK)) >= 0) {
+                    int yes = 1;
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+                    std::unique_ptr<HttpConnection> connection(new HttpConnection());
+                    connection->fd = fd;
+                    epoll_event added = {};
+                    added.events = EPOLLIN | EPOLLOUT | EPOLLET | EPOLLRDHUP;
+                    added.data.u64 = nextId;
+                    epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &added);
+                    connections[nextId++] = std::move(connection);
+                }
+            } else if (tag == WAKEUP_TAG) {
+                uint64_t count;
+                (void)!read(wakeup, &count, sizeof(count));
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    sending.swap(responses);
+                }
+                for (const Response& response : sending) {
+                    auto found = connections.find(response.connection);
+                    if (found == connections.end()) continue;      // Gone while the firmware worked
+                    HttpConnection& connection = *found->second;
+                    connection.out += response.head;
+                    connection.out += connection.keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+                    connection.out += response.body;
+                    connection.busy = false;
+                    connection.closing = !connection.keepAlive;
+                    if (!take(response.connection, connection) || !flush(connection)) remove(response.connection);
+                }
+                sending.clear();
+            } else {
+                auto found = connections.find(tag);
+                if (found == connections.end()) continue;
+                HttpConnection& connection = *found->second;
+                bool keep = true;
+                char buffer[4096];
+                ssize_t n = 0;
+                while ((n = recv(connection.fd, buffer, sizeof(buffer), 0)) > 0) connection.in.append(buffer, n);
+                if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) keep = false;
+                if (keep) keep = take(tag, connection) && flush(connection);
+                if (!keep) remove(tag);
+            }
+        }
+    }
+}
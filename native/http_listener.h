@@ -0,0 +1,56 @@
+#ifndef NATIVE_HTTP_LISTENER_H
+#define NATIVE_HTTP_LISTENER_H
+
+// Real sockets for [env:native]'s WebServer (--http PORT), so dashboards
+// and the load generator can reach the firmware over TCP. A thread of its
+// own accepts connections and reads GET requests; the firmware's
+// server.handleClient() takes them inside loop() through the request
+// source, as on the device, and each response goes back on the connection
+// it came from. HTTP/1.1 keep-alive, one request in flight per connection.
+
+#include <stdint.h>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class HttpListener {
+private:
+    struct Request {
+        uint64_t connection;
+        std::string target;
+        std::string headers;    // The header lines after the request line
+    };
+    struct Response {
+        uint64_t connection;
+        std::string head;       // Up to the Connection header, which is the thread's to add
+        std::string body;
+    };
+
+    int listener;
+    int epoll;
+    int wakeup;                 // eventfd: responses to send
+    std::thread thread;
+    std::mutex lock;
+    std::deque<Request> requests;
+    std::vector<Response> responses;
+    uint64_t serving;           // Connection of the request handleClient() took last
+
+    void run();
+
+public:
+    HttpListener();
+
+    // Listens on all interfaces; the thread runs until the process exits
+    bool start(uint16_t port);
+
+    // From the loop: the next request's "path?query" and headers, if any
+    bool next(std::string& target, std::string& headers);
+    // From the loop: the response to the request next() gave last, with
+    // the header lines the handler added
+    void respond(int code, const std::string& contentType, const std::string& headers, const std::string& body);
+};
+
+#endif
@@ -0,0 +1,417 @@
+/*
+ * Entry point for [env:native]: runs the unmodified firmware setup()/loop()
+ * against the simulated board in hal_sim.cpp.
+ *
+ *   .pio/build/native/program --seconds 600 --wifi ward:secret \
+ *       --collector http://127.0.0.1:8080/ingest --metrics
+ *
+ * Times given to options are virtual seconds since boot.
+ *
+ * --step changes the patient mid-run. Each step from the normal into the
+ * critical range (HR below 50 or above 120, SpO2 below 90) is timed to the
+ * first critical alarm after it, and --max-alarm-latency turns the worst of those into
+ * the exit status:
+ *
+ *   .pio/build/native/program --seconds 400 --quiet \
+ *       --step 100:72:85 --step 200:72:97 --step 260:72:85 --max-alarm-latency 10
+ *
+ * --memory-budgets fails the run if any subsystem in memory_accounting.h
+ * went over its declared budget at any point.
+ *
+ * --journal records the run's inputs to journal.bin in the storage
+ * directory, as `journal on` does on the device; --replay runs setup() and
+ * loop() again on a journal from either, as fast as the CPU allows, and
+ * fails if the firmware stops matching it (see journal.h):
+ *
+ *   .pio/build/native/program --seconds 3600 --quiet --journal --fs run
+ *   .pio/build/native/program --replay run/journal.bin --fs replay
+ *
+ * --http serves the firmware's routes on a real TCP port, paced by the wall
+ * clock, as the device under test of the load generator (loadgen/). The
+ * routes are registered once WiFi connects, so it wants --wifi:
+ *
+ *   .pio/build/native/program --seconds 120 --quiet --wifi ward:secret --http 8081
+ */
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <WebServer.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+#include "hal_sim.h"
+#include "http_listener.h"
+#include "../metrics.h"
+#include "../trace_log.h"
+#include "../memory_accounting.h"
+#include "../journal.h"
+
+// The unit tests in test/ bring their own main()
+#ifndef PIO_UNIT_TESTING
+
+void setup();
+void loop();
+extern WebServer server;
+
+struct ScriptedEvent {
+    uint32_t at;
+    enum { COMMAND, GET } kind;
+    std::string text;
+};
+
+struct PatientStep {
+    uint32_t at;
+    float heartRate;
+    float spO2;
+    bool critical;          // Into the fixed critical limits of the alarm rules from outside them
+    int32_t latency;        // ms to the first critical alarm, -1 if none came
+};
+
+static void usage() {
+    fprintf(stderr,
+        "Usage: program [options]\n"
+        "  --seconds N        virtual seconds to run (default 60)\n"
+        "  --realtime         pace virtual time with the wall clock\n"
+        "  --fs DIR           host directory backing SPIFFS (default .native_fs)\n"
+        "  --wipe             empty that directory first\n"
+        "  --wifi SSID:PASS   put an access point in range and store its credentials\n"
+        "  --collector URL    uplink collector URL\n"
+        "  --outage S:D       drop WiFi at S seconds for D seconds\n"
+        "  --hr BPM           simulated heart rate (default 72)\n"
+        "  --spo2 PCT         simulated saturation (default 97)\n"
+        "  --no-finger        nothing on the sensor\n"
+        "  --perfusion F      pulsatile share of the IR signal (default 0.02)\n"
+        "  --hrv F            beat-to-beat RR jitter as a fraction (default 0.03)\n"
+        "  --motion N         motion artifacts per minute\n"
+        "  --seed N           seed of the simulated patient's signals (default 1)\n"
+        "  --step S:BPM:PCT   change heart rate and saturation at S seconds\n"
+        "  --max-alarm-latency S  fail unless every step into the critical range\n"
+        "                     alarms within S seconds\n"
+        "  --memory-budgets   fail if any subsystem exceeded its memory budget\n"
+        "  --journal          record the inputs to journal.bin in the --fs directory\n"
+        "  --replay FILE      run on the inputs of a recorded journal instead of the\n"
+        "                     simulated board; other board options are ignored\n"
+        "  --battery PCT      battery charge (default 85)\n"
+        "  --tap S:X:Y        touch the screen at S seconds\n"
+        "  --command S:TEXT   type TEXT on the serial console at S seconds\n"
+        "  --get S:PATH       request PATH from the web server at S seconds\n"
+        "  --http PORT        serve the web server on a TCP port; implies --realtime\n"
+        "  --frame FILE       write the final screen as a PPM image\n"
+        "  --metrics          print /metrics at the end\n"
+        "  --quiet            hide the firmware's serial output\n");
+    exit(2);
+}
+
+static uint32_t seconds(const char* text) {
+    return (uint32_t)(atof(text) * 1000);
+}
+
+// ==================== REPLAY ====================
+static struct {
+    std::vector<uint8_t> recorded;
+    const char* frame = nullptr;
+} replayRun;
+
+// Reports and exits; called after the last loop() or from inside the
+// firmware, when it reads past the end of the journal or diverges
+static void finishReplay() {
+    traceLog.drain();
+    if (replayRun.frame && !simDisplay.savePpm(replayRun.frame)) {
+        fprintf(stderr, "Could not write %s\n", replayRun.frame);
+    }
+
+    double deviceSeconds = millis() / 1e3;
+    double wallSeconds = simClock.wall() / 1e6;
+    fflush(stdout);
+    fprintf(stderr, "replay: %llu loops, %.1f s of device time in %.2f s wall (%.0fx), %u of %u bytes\n",
+            (unsigned long long)journal.getLoops(), deviceSeconds, wallSeconds,
+            wallSeconds > 0 ? deviceSeconds / wallSeconds : 0.0,
+            (unsigned)journal.getBytes(), (unsigned)replayRun.recorded.size());
+    if (journal.hasDiverged()) {
+        fprintf(stderr, "replay diverged from the journal at %s\n", journal.getDivergence());
+    }
+    _Exit(journal.hasDiverged() ? 1 : 0);
+}
+
+int main(int argc, char** argv) {
+    uint32_t duration = 60000;
+    bool wipe = false;
+    bool printMetrics = false;
+    bool checkBudgets = false;
+    const char* frame = nullptr;
+    std::string wifi, collector;
+    PhysiologyParams patient;
+    uint64_t seed = 1;
+    std::vector<ScriptedEvent> events;
+    std::vector<PatientStep> steps;
+    float maxAlarmLatency = 0;
+    bool record = false;
+    const char* replayPath = nullptr;
+    int httpPort = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        bool hasValue = i + 1 < argc;
+        const char* value = hasValue ? argv[i + 1] : "";
+
+        if (option == "--realtime") simClock.setRealtime(true);
+        else if (option == "--wipe") wipe = true;
+        else if (option == "--no-finger") patient.fingerPresent = false;
+        else if (option == "--metrics") printMetrics = true;
+        else if (option == "--memory-budgets") checkBudgets = true;
+        else if (option == "--journal") record = true;
+        else if (option == "--quiet") Serial.setMuted(true);
+        else if (!hasValue) usage();
+        else {
+            i++;
+            if (option == "--seconds") duration = seconds(value);
+            else if (option == "--fs") simStorage.setRoot(value);
+            else if (option == "--wifi") wifi = value;
+            else if (option == "--collector") collector = value;
+            else if (option == "--hr") patient.heartRate = atof(value);
+            else if (option == "--spo2") patient.spO2 = atof(value);
+            else if (option == "--perfusion") patient.perfusion = atof(value);
+            else if (option == "--hrv") patient.hrv = atof(value);
+            else if (option == "--motion") patient.motionRate = atof(value);
+            else if (option == "--seed") seed = strtoull(value, nullptr, 10);
+            else if (option == "--max-alarm-latency") maxAlarmLatency = atof(value);
+            else if (option == "--battery") simAdc.setBattery(atof(value));
+            else if (option == "--frame") frame = value;
+            else if (option == "--replay") replayPath = value;
+            else if (option == "--http") httpPort = atoi(value);
+            else if (option == "--outage") {
+                const char* colon = strchr(value, ':');
+                if (!colon) usage();
+                simNetwork.addOutage(seconds(value), seconds(colon + 1));
+            } else if (option == "--tap") {
+                float at;
+                int x, y;
+                if (sscanf(value, "%f:%d:%d", &at, &x, &y) != 3) usage();
+                simTouch.tap((uint32_t)(at * 1000), x, y);
+            } else if (option == "--step") {
+                float at;
+                PatientStep step;
+                if (sscanf(value, "%f:%f:%f", &at, &step.heartRate, &step.spO2) != 3) usage();
+                step.at = (uint32_t)(at * 1000);
+                step.latency = -1;
+                steps.push_back(step);
+            } else if (option == "--command" || option == "--get") {
+                const char* colon = strchr(value, ':');
+                if (!colon) usage();
+                ScriptedEvent event = {seconds(value), option == "--command" ? ScriptedEvent::COMMAND : ScriptedEvent::GET, colon + 1};
+                events.push_back(event);
+            } else {
+                usage();
+            }
+        }
+    }
+
+    if (wipe) simStorage.wipe();
+
+    // Served by the firmware's server.handleClient(), inside loop(): the
+    // scripted --get requests, then those from the socket
+    static HttpListener listener;
+    if (httpPort > 0) {
+        if (!listener.start((uint16_t)httpPort)) {
+            fprintf(stderr, "Could not listen on port %d\n", httpPort);
+            return 2;
+        }
+        simClock.setRealtime(true);
+    }
+    std::deque<std::string> requests;
+    bool fromSocket = false;
+    server.setRequestSource([&requests, &fromSocket, httpPort](std::string& target, std::string& headers) {
+        fromSocket = false;
+        headers.clear();
+        if (!requests.empty()) {
+            target = requests.front();
+            requests.pop_front();
+            return true;
+        }
+        fromSocket = httpPort > 0 && listener.next(target, headers);
+        return fromSocket;
+    });
+    server.setResponseSink([&fromSocket](const std::string& target, int code, const std::string& body) {
+        if (fromSocket) {
+            listener.respond(code, server.responseContentType(), server.responseHeaders(), body);
+        } else {
+            printf("GET %s -> %d, %u bytes\n%s\n", target.c_str(), code, (unsigned)body.size(), body.c_str());
+        }
+    });
+
+    if (replayPath) {
+        std::vector<uint8_t>& recorded = replayRun.recorded;
+        FILE* f = fopen(replayPath, "rb");
+        if (f) {
+            uint8_t block[4096];
+            size_t length;
+            while ((length = fread(block, 1, sizeof(block), f)) > 0) recorded.insert(recorded.end(), block, block + length);
+            fclose(f);
+        }
+        if (!journal.replay(recorded.data(), recorded.size(), finishReplay)) {
+            fprintf(stderr, "%s is not a journal\n", replayPath);
+            return 2;
+        }
+        replayRun.frame = frame;
+        String target;
+        server.setRequestSource([&target](std::string& next, std::string& headers) {
+            if (!journal.nextRequest(target)) return false;
+            next = target.c_str();
+            headers.clear();
+            return true;
+        });
+
+        setup();
+        while (journal.hasMore()) loop();
+        finishReplay();
+    }
+    simSensor.setPatient(patient);
+    simSensor.seed(seed);
+
+    // Provision the monitor the way the config portal would
+    Preferences provisioning;
+    provisioning.begin("cardiac", false);
+    if (!wifi.empty()) {
+        size_t colon = wifi.find(':');
+        std::string ssid = wifi.substr(0, colon);
+        std::string password = colon == std::string::npos ? "" : wifi.substr(colon + 1);
+        simNetwork.setAccessPoint(ssid.c_str(), password.c_str());
+        provisioning.putString("wifi_ssid", ssid.c_str());
+        provisioning.putString("wifi_pass", password.c_str());
+    }
+    if (!collector.empty()) {
+        provisioning.putString("uplink_url", collector.c_str());
+    }
+    provisioning.end();
+    if (record) {
+        Preferences settings;
+        settings.begin("journal", false);
+        settings.putBool("enabled", true);
+        settings.end();
+    }
+
+    setup();
+
+    std::sort(steps.begin(), steps.end(),
+              [](const PatientStep& a, const PatientStep& b) { return a.at < b.at; });
+    // A step inside the critical range already alarms for the one before it
+    auto isCritical = [](float hr, float spO2) { return hr < 50 || hr > 120 || spO2 < 90; };
+    bool wasCritical = isCritical(patient.heartRate, patient.spO2);
+    for (PatientStep& step : steps) {
+        bool critical = isCritical(step.heartRate, step.spO2);
+        step.critical = critical && !wasCritical;
+        wasCritical = critical;
+    }
+    size_t nextStep = 0;
+    PatientStep* pending = nullptr;
+    uint32_t criticalAlarms = 0;
+
+    uint64_t loops = 0;
+    while (simClock.millis() < duration) {
+        simTick();
+
+        uint32_t now = simClock.millis();
+        while (nextStep < steps.size() && steps[nextStep].at <= now) {
+            // A step that changes the patient again ends the wait for the previous one
+            PatientStep& step = steps[nextStep++];
+            patient.heartRate = step.heartRate;
+            patient.spO2 = step.spO2;
+            simSensor.setPatient(patient);
+            pending = step.critical ? &step : nullptr;
+            criticalAlarms = metricAlarmsCritical.get();
+        }
+        for (size_t i = 0; i < events.size();) {
+            if (events[i].at > now) {
+                i++;
+                continue;
+            }
+            if (events[i].kind == ScriptedEvent::COMMAND) {
+                Serial.inject((events[i].text + "\n").c_str());
+            } else {
+                requests.push_back(events[i].text);
+            }
+            events.erase(events.begin() + i);
+        }
+
+        loop();
+        loops++;
+
+        // Timed to the start of the iteration that raised the alarm and
+        // switched the buzzer on
+        if (pending && metricAlarmsCritical.get() != criticalAlarms) {
+            pending->latency = (int32_t)(now - pending->at);
+            pending = nullptr;
+        }
+    }
+
+    if (record) {
+        journal.save();
+        fprintf(stderr, "journal: %u bytes, %u loops in %s%s\n", (unsigned)journal.getBytes(),
+                (unsigned)journal.getLoops(), simStorage.getRoot().c_str(), JOURNAL_PATH);
+    }
+
+    // Whatever the trace task has not written out yet
+    traceLog.drain();
+
+    if (frame && !simDisplay.savePpm(frame)) {
+        fprintf(stderr, "Could not write %s\n", frame);
+    }
+
+    if (printMetrics) {
+        MetricsGenerator metrics;
+        uint8_t buffer[512];
+        size_t length;
+        while ((length = metrics.fill(buffer, sizeof(buffer))) > 0) {
+            fwrite(buffer, 1, length, stdout);
+        }
+    }
+
+    double virtualSeconds = simClock.now() / 1e6;
+    double wallSeconds = simClock.wall() / 1e6;
+    fflush(stdout);
+    fprintf(stderr,
+        "native: %llu loops, %.1f s virtual in %.2f s wall (%.0fx), "
+        "%u sensor samples lost, %u display bytes, %u beeps\n",
+        (unsigned long long)loops, virtualSeconds, wallSeconds,
+        wallSeconds > 0 ? virtualSeconds / wallSeconds : 0.0,
+        simSensor.getSamplesLost(), simDisplay.getBytesSent(), simTone.getBeeps());
+
+    bool failed = false;
+    int32_t worst = -1;
+    for (const PatientStep& step : steps) {
+        if (!step.critical) continue;
+        if (step.latency < 0) {
+            fprintf(stderr, "step at %.1f s to %.0f BPM / %.0f%%: no critical alarm\n",
+                    step.at / 1000.0, step.heartRate, step.spO2);
+            failed = true;
+            continue;
+        }
+        fprintf(stderr, "step at %.1f s to %.0f BPM / %.0f%%: critical alarm after %.1f s\n",
+                step.at / 1000.0, step.heartRate, step.spO2, step.latency / 1000.0);
+        if (step.latency > worst) worst = step.latency;
+    }
+    if (maxAlarmLatency > 0) {
+        if (worst > maxAlarmLatency * 1000) failed = true;
+        fprintf(stderr, "worst alarm latency %.1f s, limit %.1f s: %s\n",
+                worst / 1000.0, maxAlarmLatency, failed ? "FAIL" : "ok");
+    } else {
+        failed = false;
+    }
+
+    if (checkBudgets) {
+        for (int i = 0; i < MemoryAccount::getAccountCount(); i++) {
+            const MemoryAccount* account = MemoryAccount::getAccount(i);
+            bool over = account->isOverBudget() || account->getFailures() > 0;
+            fprintf(stderr, "memory %s: peak %u of %u bytes, %u failed allocations: %s\n",
+                    account->getName(), (unsigned)account->getPeak(), (unsigned)account->getBudget(),
+                    (unsigned)account->getFailures(), over ? "FAIL" : "ok");
+            if (over) failed = true;
+        }
+    }
+
+    // The uplink task is still running; skip static destructors under it
+    _Exit(failed ? 1 : 0);
+}
+#endif
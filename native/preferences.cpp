@@ -0,0 +1,170 @@
+// NVS for [env:native]; see Preferences.h
+#include "Preferences.h"
+#include "hal_sim.h"
+
+static std::map<std::string, std::map<std::string, std::string>> namespaces;
+static std::mutex namespacesLock;
+static bool loaded = false;
+
+// One "namespace<TAB>key<TAB>value" line per entry, with \\, \t and \n escaped
+static std::string nvsPath() {
+    return simStorage.getRoot() + "/nvs.txt";
+}
+
+static std::string escape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '\t') out += "\\t";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+    return out;
+}
+
+static std::string unescape(const std::string& text) {
+    std::string out;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '\\' && i + 1 < text.size()) {
+            char c = text[++i];
+            out += c == 't' ? '\t' : (c == 'n' ? '\n' : c);
+        } else {
+            out += text[i];
+        }
+    }
+    return out;
+}
+
+// Caller holds namespacesLock
+static void load() {
+    loaded = true;
+    FILE* f = fopen(nvsPath().c_str(), "r");
+    if (!f) return;
+    char line[1024];
+    while (fgets(line, sizeof(line), f)) {
+        std::string entry = line;
+        if (!entry.empty() && entry.back() == '\n') entry.pop_back();
+        size_t first = entry.find('\t');
+        size_t second = entry.find('\t', first + 1);
+        if (first == std::string::npos || second == std::string::npos) continue;
+        namespaces[unescape(entry.substr(0, first))][unescape(entry.substr(first + 1, second - first - 1))] =
+            unescape(entry.substr(second + 1));
+    }
+    fclose(f);
+}
+
+// Caller holds namespacesLock. Written aside and renamed over the old file,
+// so a run that exits mid-write (a power cut) keeps the previous contents,
+// as NVS does.
+static void save() {
+    hal.storage->begin(true);
+    std::string path = nvsPath();
+    FILE* f = fopen((path + ".tmp").c_str(), "w");
+    if (!f) return;
+    for (const auto& space : namespaces) {
+        for (const auto& entry : space.second) {
+            fprintf(f, "%s\t%s\t%s\n", escape(space.first).c_str(),
+                    escape(entry.first).c_str(), escape(entry.second).c_str());
+        }
+    }
+    fclose(f);
+    rename((path + ".tmp").c_str(), path.c_str());
+}
+
+bool Preferences::begin(const char* name, bool readOnly) {
+    (void)readOnly;
+    std::lock_guard<std::mutex> guard(namespacesLock);
+    if (!loaded) load();
+    space = name;
+    opened = true;
+    return true;
+}
+
+bool Preferences::lookup(const char* key, std::string& value) {
+    std::lock_guard<std::mutex> guard(namespacesLock);
+    auto& entries = namespaces[space];
+    auto it = entries.find(key);
+    if (!opened || it == entries.end()) return false;
+    value = it->second;
+    return true;
+}
+
+void Preferences::store(const char* key, const std::string& value) {
+    std::lock_guard<std::mutex> guard(namespacesLock);
+    if (!opened) return;
+    std::string& slot = namespaces[space][key];
+    if (slot != value) {
+        slot = value;
+        save();
+    }
+}
+
+bool Preferences::clear() {
+    std::lock_guard<std::mutex> guard(namespacesLock);
+    if (!opened) return false;
+    namespaces[space].clear();
+    save();
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    std::lock_guard<std::mutex> guard(namespacesLock);
+    if (!opened || namespaces[space].erase(key) == 0) return false;
+    save();
+    return true;
+}
+
+bool Preferences::isKey(const char* key) {
+    std::string value;
+    return lookup(key, value);
+}
+
+size_t Preferences::putString(const char* key, const String& value) {
+    store(key, value.c_str());
+    return value.length();
+}
+
+size_t Preferences::putFloat(const char* key, float value) {
+    store(key, String(value, 6).c_str());
+    return sizeof(value);
+}
+
+size_t Preferences::putInt(const char* key, int32_t value) {
+    store(key, String(value).c_str());
+    return sizeof(value);
+}
+
+size_t Preferences::putUInt(const char* key, uint32_t value) {
+    store(key, String(value).c_str());
+    return sizeof(value);
+}
+
+size_t Preferences::putBool(const char* key, bool value) {
+    store(key, value ? "1" : "0");
+    return 1;
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+    std::string value;
+    return lookup(key, value) ? String(value) : defaultValue;
+}
+
+float Preferences::getFloat(const char* key, float defaultValue) {
+    std::string value;
+    return lookup(key, value) ? strtof(value.c_str(), nullptr) : defaultValue;
+}
+
+int32_t Preferences::getInt(const char* key, int32_t defaultValue) {
+    std::string value;
+    return lookup(key, value) ? (int32_t)strtol(value.c_str(), nullptr, 10) : defaultValue;
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+    std::string value;
+    return lookup(key, value) ? (uint32_t)strtoul(value.c_str(), nullptr, 10) : defaultValue;
+}
+
+bool Preferences::getBool(const char* key, bool defaultValue) {
+    std::string value;
+    return lookup(key, value) ? value == "1" : defaultValue;
+}
@@ -0,0 +1,3 @@
+// Compiles the firmware sketch as a plain C++ translation unit for
+// [env:native]; the Arduino builder does the equivalent on the device
+#include "../cardiac_monitor_complete.ino"
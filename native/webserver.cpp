@@ -0,0 +1,135 @@
+// In-process WebServer for [env:native]; see WebServer.h
+#include "WebServer.h"
+#include <strings.h>
+
+void WebServer::on(const char* uri, THandlerFunction handler) {
+    Route route = {uri, handler};
+    routes.push_back(route);
+}
+
+std::string WebServer::decode(const std::string& text) {
+    std::string out;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '+') {
+            out += ' ';
+        } else if (text[i] == '%' && i + 2 < text.size()) {
+            out += (char)strtol(text.substr(i + 1, 2).c_str(), nullptr, 16);
+            i += 2;
+        } else {
+            out += text[i];
+        }
+    }
+    return out;
+}
+
+String WebServer::arg(const char* name) const {
+    for (const auto& a : currentArgs) {
+        if (a.first == name) return String(a.second);
+    }
+    return String();
+}
+
+bool WebServer::hasArg(const char* name) const {
+    for (const auto& a : currentArgs) {
+        if (a.first == name) return true;
+    }
+    return false;
+}
+
+void WebServer::collectHeaders(const char* headerKeys[], size_t count) {
+    collectedHeaders.assign(headerKeys, headerKeys + count);
+}
+
+String WebServer::header(const char* name) const {
+    for (const auto& h : currentHeaders) {
+        if (strcasecmp(h.first.c_str(), name) == 0) return String(h.second);
+    }
+    return String();
+}
+
+bool WebServer::hasHeader(const char* name) const {
+    for (const auto& h : currentHeaders) {
+        if (strcasecmp(h.first.c_str(), name) == 0) return true;
+    }
+    return false;
+}
+
+void WebServer::sendHeader(const String& name, const String& value, bool first) {
+    std::string line = std::string(name.c_str()) + ": " + value.c_str() + "\r\n";
+    responseHead = first ? line + responseHead : responseHead + line;
+}
+
+void WebServer::send(int code, const char* contentType, const String& content) {
+    responseCode = code;
+    if (contentType) responseType = contentType;
+    responseBody += content.c_str();
+}
+
+int WebServer::dispatch(const char* target, std::string& body, const std::string& headers) {
+    std::string request = target;
+    size_t query = request.find('?');
+    currentUri = request.substr(0, query);
+    currentArgs.clear();
+
+    if (query != std::string::npos) {
+        size_t at = query + 1;
+        while (at <= request.size()) {
+            size_t end = request.find('&', at);
+            if (end == std::string::npos) end = request.size();
+            std::string pair = request.substr(at, end - at);
+            size_t equals = pair.find('=');
+            if (!pair.empty()) {
+                currentArgs.push_back(std::make_pair(
+                    decode(pair.substr(0, equals)),
+                    equals == std::string::npos ? std::string() : decode(pair.substr(equals + 1))));
+            }
+            at = end + 1;
+        }
+    }
+
+    currentHeaders.clear();
+    size_t at = 0;
+    while (at < headers.size()) {
+        size_t end = headers.find("\r\n", at);
+        if (end == std::string::npos) end = headers.size();
+        std::string line = headers.substr(at, end - at);
+        size_t colon = line.find(':');
+        if (colon != std::string::npos) {
+            std::string name = line.substr(0, colon);
+            size_t value = line.find_first_not_of(" \t", colon + 1);
+            for (const auto& collected : collectedHeaders) {
+                if (strcasecmp(collected.c_str(), name.c_str()) == 0) {
+                    currentHeaders.push_back(std::make_pair(name, value == std::string::npos ? std::string() : line.substr(value)));
+                }
+            }
+        }
+        at = end + 2;
+    }
+
+    responseCode = 404;
+    responseType.clear();
+    responseHead.clear();
+    responseBody.clear();
+
+    // First registered route wins, as on the device
+    bool handled = false;
+    for (const auto& route : routes) {
+        if (route.uri == currentUri) {
+            route.handler();
+            handled = true;
+            break;
+        }
+    }
+    if (!handled && notFound) notFound();
+
+    body = responseBody;
+    return responseCode;
+}
+
+void WebServer::handleClient() {
+    std::string target, headers, body;
+    while (requestSource && requestSource(target, headers)) {
+        int code = dispatch(target.c_str(), body, headers);
+        if (responseSink) responseSink(target, code, body);
+    }
+}
@@ -0,0 +1,74 @@
+// WiFi, SPI and Wire shims for [env:native]; see WiFi.h
+#include "WiFi.h"
+#include "SPI.h"
+#include "Wire.h"
+#include "hal_sim.h"
+
+WiFiClass WiFi;
+SPIClass SPI;
+TwoWire Wire;
+
+String IPAddress::toString() const {
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(text);
+}
+
+wl_status_t WiFiClass::status() {
+    return hal.network->isConnected() ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+bool WiFiClass::mode(wifi_mode_t mode) {
+    if (mode == WIFI_OFF) hal.network->disconnect();
+    return true;
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* password) {
+    hal.network->connect(ssid, password ? password : "");
+    return WL_DISCONNECTED;
+}
+
+bool WiFiClass::disconnect() {
+    hal.network->disconnect();
+    return true;
+}
+
+bool WiFiClass::softAP(const char* ssid, const char* password) {
+    (void)ssid;
+    (void)password;
+    return true;
+}
+
+IPAddress WiFiClass::localIP() {
+    return hal.network->isConnected() ? IPAddress(10, 0, 0, 42) : IPAddress();
+}
+
+String WiFiClass::macAddress() {
+    return String("24:0A:C4:00:00:01");
+}
+
+String WiFiClass::SSID() {
+    return String(simNetwork.getSsid());
+}
+
+int8_t WiFiClass::RSSI() {
+    return hal.network->getRssi();
+}
+
+// The configured access point, if any, plus a neighbour that is always there
+int16_t WiFiClass::scanNetworks() {
+    return simNetwork.getAccessPointSsid().empty() ? 1 : 2;
+}
+
+String WiFiClass::SSID(uint8_t index) {
+    if (index == 1) return String(simNetwork.getAccessPointSsid());
+    return String("guest");
+}
+
+int32_t WiFiClass::RSSI(uint8_t index) {
+    return index == 1 ? -58 : -77;
+}
+
+wifi_auth_mode_t WiFiClass::encryptionType(uint8_t index) {
+    return index == 1 ? WIFI_AUTH_WPA2_PSK : WIFI_AUTH_OPEN;
+}
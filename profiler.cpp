@@ -0,0 +1,148 @@
+#include "profiler.h"
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+
+ProfileSection* ProfileSection::table[ProfileSection::MAX_SECTIONS];
+int ProfileSection::sectionCount = 0;
+static uint32_t windowStart = 0;
+
+// ==================== STANDARD SECTIONS ====================
+ProfileSection profileLoop("loop");
+ProfileSection profileSerial("serial");
+ProfileSection profileNetwork("network");
+ProfileSection profileTouch("touch");
+ProfileSection profileSensors("sensors");
+ProfileSection profileEstimator("estimator");
+ProfileSection profileDisplay("display");
+ProfileSection profileLog("log");
+ProfileSection profileAlerts("alerts");
+ProfileSection profileMaintenance("maintenance");
+
+uint32_t profileTicksPerMicro() {
+#if defined(ARDUINO) && defined(ESP32)
+    return getCpuFrequencyMhz();
+#else
+    return 1000;
+#endif
+}
+
+// ==================== SECTION ====================
+ProfileSection::ProfileSection(const char* sectionName) : name(sectionName), resetRequested(false) {
+    clear();
+    // Sections past the table still time themselves; they are just not listed
+    if (sectionCount < MAX_SECTIONS) table[sectionCount++] = this;
+}
+
+void ProfileSection::clear() {
+    count = 0;
+    minTicks = UINT32_MAX;
+    maxTicks = 0;
+    totalTicks = 0;
+    memset(buckets, 0, sizeof(buckets));
+    resetRequested.store(false, std::memory_order_relaxed);
+}
+
+uint32_t ProfileSection::getCount() const {
+    return resetRequested.load(std::memory_order_relaxed) ? 0 : count;
+}
+
+uint32_t ProfileSection::getMin() const {
+    return getCount() ? minTicks : 0;
+}
+
+uint32_t ProfileSection::getMax() const {
+    return getCount() ? maxTicks : 0;
+}
+
+uint32_t ProfileSection::getAverage() const {
+    uint32_t n = getCount();
+    return n ? (uint32_t)(totalTicks / n) : 0;
+}
+
+uint32_t ProfileSection::getPercentile(float percent) const {
+    uint32_t n = getCount();
+    if (n == 0) return 0;
+
+    // Rank of the percentile, rounded up so p100 is the last value
+    uint64_t rank = (uint64_t)(percent / 100.0f * n + 0.999f);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            uint32_t bound = bucketUpperBound(i);
+            return bound < maxTicks ? bound : maxTicks;
+        }
+    }
+    return maxTicks;
+}
+
+uint32_t ProfileSection::bucketUpperBound(int bucket) {
+    if (bucket < 4) return (uint32_t)bucket;
+    int octave = bucket / 4 + 1;
+    uint64_t step = 1ULL << (octave - 2);
+    return (uint32_t)((1ULL << octave) + (uint64_t)(bucket % 4 + 1) * step - 1);
+}
+
+void ProfileSection::resetAll() {
+    for (int i = 0; i < sectionCount; i++) table[i]->reset();
+    windowStart = hal.clock->millis();
+}
+
+uint32_t ProfileSection::getWindowStart() {
+    return windowStart;
+}
+
+// ==================== RENDERING ====================
+ProfileGenerator::ProfileGenerator(Format outputFormat) : format(outputFormat) {
+    next = 0;
+    headerSent = false;
+    footerSent = false;
+}
+
+size_t ProfileGenerator::renderNext(char* out, size_t size) {
+    int n = 0;
+    float perMicro = (float)profileTicksPerMicro();
+
+    if (!headerSent) {
+        headerSent = true;
+        uint32_t window = hal.clock->millis() - ProfileSection::getWindowStart();
+        if (format == JSON) {
+            n = snprintf(out, size, "{\"window_ms\":%u,\"ticks_per_us\":%u,\"sections\":[",
+                         (unsigned)window, (unsigned)profileTicksPerMicro());
+        } else {
+            n = snprintf(out, size, "Profile over %.1f s (us)\n%-12s %9s %9s %9s %9s %9s\n",
+                         window / 1000.0f, "Section", "Count", "Min", "Avg", "P99", "Max");
+        }
+        return n > 0 ? (size_t)n : 0;
+    }
+
+    if (next < ProfileSection::getSectionCount()) {
+        const ProfileSection* section = ProfileSection::getSection(next);
+        float minUs = section->getMin() / perMicro;
+        float avgUs = section->getAverage() / perMicro;
+        float p99Us = section->getPercentile(99) / perMicro;
+        float maxUs = section->getMax() / perMicro;
+        if (format == JSON) {
+            n = snprintf(out, size,
+                         "%s{\"name\":\"%s\",\"count\":%u,\"min\":%.1f,\"avg\":%.1f,\"p99\":%.1f,\"max\":%.1f}",
+                         next > 0 ? "," : "", section->getName(), (unsigned)section->getCount(),
+                         minUs, avgUs, p99Us, maxUs);
+        } else {
+            n = snprintf(out, size, "%-12s %9u %9.1f %9.1f %9.1f %9.1f\n", section->getName(),
+                         (unsigned)section->getCount(), minUs, avgUs, p99Us, maxUs);
+        }
+        next++;
+        return n > 0 ? (size_t)n : 0;
+    }
+
+    if (!footerSent) {
+        footerSent = true;
+        if (format == JSON) {
+            n = snprintf(out, size, "]}");
+            return n > 0 ? (size_t)n : 0;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "http_stream.h"
+
+#if defined(ARDUINO) && defined(ESP32)
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+// Section profiler: per-section min/avg/max/p99 of how long a scope takes,
+// in CPU cycles on the ESP32 (CCOUNT) and nanoseconds on the host.
+//
+// Sections are statically allocated and enter a fixed table when
+// constructed; timing one is a scoped object:
+//
+//   void updateDisplay() {
+//       PROFILE_SCOPE(profileDisplay);
+//       ...
+//   }
+//
+// Recording is two cycle-counter reads, a count-leading-zeros and a few
+// adds, with no locks or atomic read-modify-writes, so it stays on in
+// production builds; build with -DPROFILING_ENABLED=0 to compile the scopes
+// out. A section is written by one task only. Readers on other tasks may
+// see a record half applied, which is harmless for a diagnostic dump;
+// resets are requested and carried out by the writer on its next record.
+//
+// Durations are 32-bit: a scope longer than one counter wrap (about 17 s
+// of CCOUNT at 240 MHz, 4.2 s on the host) is misreported.
+
+#ifndef PROFILING_ENABLED
+#define PROFILING_ENABLED 1
+#endif
+
+// Monotonic tick counter; wraps, so only differences mean anything
+static inline uint32_t profileTicks() {
+#if defined(ARDUINO) && defined(ESP32)
+    return ESP.getCycleCount();
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Ticks per microsecond on this target
+uint32_t profileTicksPerMicro();
+
+class ProfileSection {
+public:
+    // Log-linear buckets: values below 4 exactly, then every power of two
+    // split into four, so a percentile is off by at most a quarter octave
+    static const int BUCKETS = 124;
+    static const int MAX_SECTIONS = 24;
+
+private:
+    static ProfileSection* table[MAX_SECTIONS];
+    static int sectionCount;
+
+    const char* name;
+    uint32_t count;
+    uint32_t minTicks;
+    uint32_t maxTicks;
+    uint64_t totalTicks;
+    uint32_t buckets[BUCKETS];
+    std::atomic<bool> resetRequested;
+
+    void clear();
+
+public:
+    explicit ProfileSection(const char* sectionName);
+
+    void record(uint32_t ticks) {
+        if (resetRequested.load(std::memory_order_relaxed)) clear();
+        count++;
+        totalTicks += ticks;
+        if (ticks < minTicks) minTicks = ticks;
+        if (ticks > maxTicks) maxTicks = ticks;
+        buckets[bucketOf(ticks)]++;
+    }
+
+    // Takes effect on the next record() from the writing task
+    void reset() { resetRequested.store(true, std::memory_order_relaxed); }
+
+    const char* getName() const { return name; }
+    uint32_t getCount() const;
+    uint32_t getMin() const;
+    uint32_t getMax() const;
+    uint32_t getAverage() const;
+    // Upper bound of the bucket holding the given percentile, capped at max
+    uint32_t getPercentile(float percent) const;
+
+    static int bucketOf(uint32_t ticks) {
+        if (ticks < 4) return (int)ticks;
+        int octave = 31 - __builtin_clz(ticks);
+        return 4 * (octave - 1) + (int)((ticks >> (octave - 2)) & 3);
+    }
+    static uint32_t bucketUpperBound(int bucket);
+
+    static int getSectionCount() { return sectionCount; }
+    static ProfileSection* getSection(int i) { return table[i]; }
+    // Requests a reset of every section and restarts the reporting window
+    static void resetAll();
+    static uint32_t getWindowStart();
+};
+
+class ProfileScope {
+private:
+    ProfileSection& section;
+    uint32_t start;
+
+public:
+    explicit ProfileScope(ProfileSection& target) : section(target), start(profileTicks()) {}
+    ~ProfileScope() { section.record(profileTicks() - start); }
+};
+
+#if PROFILING_ENABLED
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(section) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(section)
+#else
+#define PROFILE_SCOPE(section) do {} while (0)
+#endif
+
+// The section table as a text table (the serial `profile` command) or as
+// JSON (/api/profile), in microseconds, one section per piece
+class ProfileGenerator : public ChunkGenerator {
+public:
+    enum Format {
+        TEXT,
+        JSON
+    };
+
+private:
+    Format format;
+    int next;
+    bool headerSent;
+    bool footerSent;
+
+public:
+    explicit ProfileGenerator(Format outputFormat);
+
+protected:
+    size_t renderNext(char* out, size_t size) override;
+};
+
+// ==================== STANDARD SECTIONS ====================
+extern ProfileSection profileLoop;
+extern ProfileSection profileSerial;
+extern ProfileSection profileNetwork;
+extern ProfileSection profileTouch;
+extern ProfileSection profileSensors;
+extern ProfileSection profileEstimator;
+extern ProfileSection profileDisplay;
+extern ProfileSection profileLog;
+extern ProfileSection profileAlerts;
+extern ProfileSection profileMaintenance;
+
+#endif
@@ -0,0 +1,184 @@
+#include "self_benchmark.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include "hal.h"
+#include "http_stream.h"
+#include "profiler.h"
+#include "signal_generator.h"
+#include "vitals_pipeline.h"
+#include "spo2_algorithm.h"       // FreqS, from the MAX3010x library
+
+static const int FIFO_POLLS = 200;              // 2 s at the loop's 10 ms
+static const int FIFO_BYTES_PER_SAMPLE = 6;     // 18-bit red and IR
+static const int FULL_FILLS = 4;
+static const int PARTIAL_FILLS = 50;
+static const int STORAGE_APPENDS = 20;
+static const int STORAGE_APPEND_BYTES = 256;
+static const float DSP_SAMPLE_RATE = FreqS;
+static const int DSP_SECONDS = 30;
+static const int JSON_REPEATS = 100;
+static const int JSON_HISTORY = 100;
+
+static float ticksToMicros(uint64_t ticks) {
+    return ticks / (float)profileTicksPerMicro();
+}
+
+// ==================== SENSOR ====================
+static void benchFifo(SelfBenchResults& results) {
+    uint64_t readTicks = 0;
+    uint32_t samples = 0;
+    uint32_t start = millis();
+
+    for (int i = 0; i < FIFO_POLLS; i++) {
+        uint32_t t0 = profileTicks();
+        hal.sensor->check();
+        while (hal.sensor->available()) {
+            hal.sensor->getRed();
+            hal.sensor->getIR();
+            hal.sensor->nextSample();
+            samples++;
+        }
+        readTicks += profileTicks() - t0;
+        delay(10);
+    }
+
+    uint32_t elapsed = millis() - start;
+    results.fifoSamples = samples;
+    if (samples == 0) return;
+    float readUs = ticksToMicros(readTicks);
+    results.fifoSamplesPerSecond = elapsed > 0 ? samples * 1000.0f / elapsed : 0;
+    results.fifoReadUsPerSample = readUs / samples;
+    results.fifoBusBytesPerSecond = readUs > 0 ? samples * FIFO_BYTES_PER_SAMPLE * 1e6f / readUs : 0;
+}
+
+// ==================== DISPLAY ====================
+static void benchDisplay(const SelfBenchConfig& config, SelfBenchResults& results) {
+    static const uint16_t COLORS[] = {0xF800, 0x07E0, 0x001F, 0x0000};
+    uint32_t pixels = (uint32_t)config.screenWidth * config.screenHeight;
+
+    uint32_t t0 = profileTicks();
+    for (int i = 0; i < FULL_FILLS; i++) {
+        hal.display->setWindow(0, 0, config.screenWidth, config.screenHeight);
+        hal.display->pushColor(COLORS[i % 4], pixels);
+    }
+    float fullUs = ticksToMicros(profileTicks() - t0) / FULL_FILLS;
+    results.fullFillMs = fullUs / 1000.0f;
+    results.fullFillBytesPerSecond = fullUs > 0 ? pixels * 2 * 1e6f / fullUs : 0;
+
+    t0 = profileTicks();
+    for (int i = 0; i < PARTIAL_FILLS; i++) {
+        hal.display->setWindow((i * 7) % (config.screenWidth - 100), 30, 100, 25);
+        hal.display->pushColor(COLORS[i % 4], 100 * 25);
+    }
+    results.partialFillUs = ticksToMicros(profileTicks() - t0) / PARTIAL_FILLS;
+}
+
+// ==================== STORAGE ====================
+static void benchStorage(const SelfBenchConfig& config, SelfBenchResults& results) {
+    uint8_t block[STORAGE_APPEND_BYTES];
+    for (int i = 0; i < STORAGE_APPEND_BYTES; i++) block[i] = (uint8_t)i;
+
+    uint64_t appendTicks = 0, flushTicks = 0;
+    uint32_t appendMax = 0, flushMax = 0;
+    int done = 0;
+    hal.storage->remove(config.scratchPath);
+
+    for (int i = 0; i < STORAGE_APPENDS; i++) {
+        int file = hal.storage->open(config.scratchPath, "a");
+        if (file == HAL_INVALID_FILE) break;
+
+        uint32_t t0 = profileTicks();
+        hal.storage->write(file, block, sizeof(block));
+        uint32_t t1 = profileTicks();
+        hal.storage->close(file);
+        uint32_t t2 = profileTicks();
+
+        appendTicks += t1 - t0;
+        flushTicks += t2 - t1;
+        if (t1 - t0 > appendMax) appendMax = t1 - t0;
+        if (t2 - t1 > flushMax) flushMax = t2 - t1;
+        done++;
+    }
+    hal.storage->remove(config.scratchPath);
+
+    if (done == 0) return;
+    results.storageAppendUs = ticksToMicros(appendTicks) / done;
+    results.storageAppendMaxUs = ticksToMicros(appendMax);
+    results.storageFlushUs = ticksToMicros(flushTicks) / done;
+    results.storageFlushMaxUs = ticksToMicros(flushMax);
+}
+
+// ==================== DSP ====================
+static void benchDsp(SelfBenchResults& results) {
+    // Static: its red and IR windows would crowd the loop task's stack
+    static PpgEstimator estimator;
+    SignalGenerator generator(DSP_SAMPLE_RATE, 1);
+    estimator.reset();
+    VitalSigns vitals;
+    SignalSample sample;
+    int samples = (int)(DSP_SAMPLE_RATE * DSP_SECONDS);
+
+    uint64_t ticks = 0;
+    for (int i = 0; i < samples; i++) {
+        generator.next(sample);
+        uint32_t t0 = profileTicks();
+        estimator.addSample(sample.red, sample.ir, vitals);
+        ticks += profileTicks() - t0;
+    }
+    estimator.reset();
+
+    results.dspUsPerSecond = ticksToMicros(ticks) / DSP_SECONDS;
+    results.dspLoadPercent = results.dspUsPerSecond / 1e4f;
+}
+
+// ==================== JSON ====================
+static void benchJson(SelfBenchResults& results) {
+    static VitalSigns history[JSON_HISTORY];
+    for (int i = 0; i < JSON_HISTORY; i++) {
+        history[i].heartRate = 60.0f + (i % 40);
+        history[i].spO2 = 95.0f + (i % 5) * 0.5f;
+        history[i].batteryLevel = 80.0f;
+        history[i].isFingerDetected = true;
+        history[i].timestamp = 1000u * i;
+    }
+    char buffer[256];
+
+    uint32_t t0 = profileTicks();
+    for (int i = 0; i < JSON_REPEATS; i++) {
+        jsonSerialize(history[i % JSON_HISTORY], buffer, sizeof(buffer));
+    }
+    results.jsonVitalsUs = ticksToMicros(profileTicks() - t0) / JSON_REPEATS;
+
+    // The body is rendered as it is sent, chunk by chunk, so that is timed
+    uint8_t chunk[512];
+    uint32_t bytes = 0;
+    t0 = profileTicks();
+    for (int i = 0; i < 10; i++) {
+        VitalsJsonGenerator body(history[0], history, JSON_HISTORY);
+        size_t length;
+        bytes = 0;
+        while ((length = body.fill(chunk, sizeof(chunk))) > 0) bytes += length;
+    }
+    results.jsonDataBodyUs = ticksToMicros(profileTicks() - t0) / 10;
+    results.jsonDataBodyBytes = bytes;
+}
+
+// ==================== RUN ====================
+void runSelfBenchmark(const SelfBenchConfig& config, SelfBenchResults& results) {
+    memset(&results, 0, sizeof(results));
+    uint32_t start = millis();
+
+    results.firmware = config.firmwareVersion;
+    strlcpy(results.device, WiFi.macAddress().c_str(), sizeof(results.device));
+    results.chip = ESP.getChipModel();
+    results.chipRevision = ESP.getChipRevision();
+    results.cpuMhz = ESP.getCpuFreqMHz();
+
+    benchFifo(results);
+    benchDisplay(config, results);
+    benchStorage(config, results);
+    benchDsp(results);
+    benchJson(results);
+
+    results.durationMs = millis() - start;
+}
@@ -0,0 +1,95 @@
+#ifndef SELF_BENCHMARK_H
+#define SELF_BENCHMARK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "json_schema.h"
+
+// On-device self-benchmark: times this board's sensor link, panel, flash
+// and CPU against the workloads the monitor runs, so that hardware batches
+// can be compared across the fleet. Run from the serial `bench` command or
+// at boot; it takes a few seconds and blocks the loop meanwhile, and it
+// draws over the screen.
+//
+// Everything is timed with profileTicks() (CPU cycles on the ESP32). The
+// DSP and JSON workloads are generated from fixed seeds, so their figures
+// differ between boards only by the board.
+
+struct SelfBenchConfig {
+    const char* firmwareVersion = "";
+    int16_t screenWidth = 320;
+    int16_t screenHeight = 240;
+    const char* scratchPath = "/bench.tmp";     // Created and removed again
+};
+
+struct SelfBenchResults {
+    const char* firmware;
+    char device[18];                // WiFi MAC address
+    const char* chip;
+    uint32_t chipRevision;
+    uint32_t cpuMhz;
+
+    // Sensor FIFO bursts over I2C, polled at the sketch's 10 ms loop rate
+    uint32_t fifoSamples;
+    float fifoSamplesPerSecond;     // Delivered by the sensor
+    float fifoReadUsPerSample;      // Spent reading them out
+    float fifoBusBytesPerSecond;    // 6 bytes per sample while reading
+
+    // Panel
+    float fullFillMs;               // One full-screen fill
+    float fullFillBytesPerSecond;
+    float partialFillUs;            // One 100x25 fill, the size of a banner
+
+    // Flash file system, 256-byte appends (a vitals log flush)
+    float storageAppendUs;
+    float storageAppendMaxUs;
+    float storageFlushUs;           // Close, which commits the write
+    float storageFlushMaxUs;
+
+    // PPG estimator at the sensor's FreqS
+    float dspUsPerSecond;           // CPU time per second of samples
+    float dspLoadPercent;
+
+    // JSON
+    float jsonVitalsUs;             // One vitals object
+    float jsonDataBodyUs;           // The /data body with 100 history records
+    uint32_t jsonDataBodyBytes;
+
+    uint32_t durationMs;
+};
+
+template <>
+struct JsonSchema<SelfBenchResults> {
+    static constexpr auto fields() {
+        return std::make_tuple(
+            jsonConstant("type", "bench"),
+            jsonMember("firmware", &SelfBenchResults::firmware),
+            jsonMember("device", &SelfBenchResults::device),
+            jsonMember("chip", &SelfBenchResults::chip),
+            jsonMember("chipRevision", &SelfBenchResults::chipRevision),
+            jsonMember("cpuMhz", &SelfBenchResults::cpuMhz),
+            jsonMember("fifoSamples", &SelfBenchResults::fifoSamples),
+            jsonMember("fifoSamplesPerSecond", &SelfBenchResults::fifoSamplesPerSecond, 1),
+            jsonMember("fifoReadUsPerSample", &SelfBenchResults::fifoReadUsPerSample, 1),
+            jsonMember("fifoBusBytesPerSecond", &SelfBenchResults::fifoBusBytesPerSecond, 0),
+            jsonMember("fullFillMs", &SelfBenchResults::fullFillMs, 2),
+            jsonMember("fullFillBytesPerSecond", &SelfBenchResults::fullFillBytesPerSecond, 0),
+            jsonMember("partialFillUs", &SelfBenchResults::partialFillUs, 1),
+            jsonMember("storageAppendUs", &SelfBenchResults::storageAppendUs, 1),
+            jsonMember("storageAppendMaxUs", &SelfBenchResults::storageAppendMaxUs, 1),
+            jsonMember("storageFlushUs", &SelfBenchResults::storageFlushUs, 1),
+            jsonMember("storageFlushMaxUs", &SelfBenchResults::storageFlushMaxUs, 1),
+            jsonMember("dspUsPerSecond", &SelfBenchResults::dspUsPerSecond, 1),
+            jsonMember("dspLoadPercent", &SelfBenchResults::dspLoadPercent, 3),
+            jsonMember("jsonVitalsUs", &SelfBenchResults::jsonVitalsUs, 2),
+            jsonMember("jsonDataBodyUs", &SelfBenchResults::jsonDataBodyUs, 1),
+            jsonMember("jsonDataBodyBytes", &SelfBenchResults::jsonDataBodyBytes),
+            jsonMember("durationMs", &SelfBenchResults::durationMs));
+    }
+};
+
+// Runs every measurement; a part whose hardware does not respond reports
+// zeros. Consumes sensor samples and leaves the panel drawn over.
+void runSelfBenchmark(const SelfBenchConfig& config, SelfBenchResults& results);
+
+#endif
@@ -0,0 +1,179 @@
+#include "signal_generator.h"
+#include <math.h>
+
+static const double TWO_PI = 6.283185307179586;
+
+// Single-lead ECG as a sum of Gaussian waves placed on the beat phase (the
+// R peak at 0), after McSharry et al.'s ECGSYN. Amplitudes in mV.
+struct EcgWave {
+    float center;
+    float width;
+    float amplitude;
+};
+
+static const EcgWave ECG_WAVES[] = {
+    {-0.17f, 0.030f, 0.15f},    // P
+    {-0.025f, 0.012f, -0.12f},  // Q
+    {0.0f, 0.012f, 1.00f},      // R
+    {0.025f, 0.012f, -0.25f},   // S
+    {0.30f, 0.060f, 0.30f},     // T
+};
+
+// exp(-x^2) that skips the call where the result would not show in the output
+static inline double bump(double x) {
+    return (x > -4 && x < 4) ? exp(-x * x) : 0.0;
+}
+
+double ratioForSpO2(double spO2) {
+    double c = spO2 - 94.845;
+    double discriminant = 30.354 * 30.354 - 4 * 45.060 * c;
+    if (discriminant <= 0) return 30.354 / (2 * 45.060);
+    return (30.354 + sqrt(discriminant)) / (2 * 45.060);
+}
+
+// ==================== RANDOM ====================
+// splitmix64: one multiply-xorshift round per call, full 64-bit period
+uint64_t SignalGenerator::nextRandom() {
+    uint64_t z = (rng += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+double SignalGenerator::uniform() {
+    return (nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Irwin-Hall approximation from four 16-bit uniforms; close enough to
+// normal for sensor noise and far cheaper than Box-Muller
+double SignalGenerator::gaussian() {
+    uint64_t r = nextRandom();
+    double sum = (double)(r & 0xFFFF) + (double)((r >> 16) & 0xFFFF) +
+                 (double)((r >> 32) & 0xFFFF) + (double)(r >> 48);
+    return (sum / 65536.0 - 2.0) * 1.7320508075688772;
+}
+
+double SignalGenerator::eventChance(float perMinute) {
+    return perMinute / 60.0 / sampleRate;
+}
+
+// ==================== GENERATOR ====================
+SignalGenerator::SignalGenerator(float samplesPerSecond, uint64_t seedValue) : sampleRate(samplesPerSecond) {
+    setParams(PhysiologyParams());
+    seed(seedValue);
+}
+
+void SignalGenerator::setParams(const PhysiologyParams& p) {
+    params = p;
+    ratio = ratioForSpO2(p.spO2);
+}
+
+void SignalGenerator::setSampleRate(float samplesPerSecond) {
+    beatLength *= samplesPerSecond / sampleRate;
+    sampleRate = samplesPerSecond;
+}
+
+void SignalGenerator::seed(uint64_t value) {
+    rng = value;
+    sampleIndex = 0;
+    phase = 0;
+    breathPhase = uniform();
+    wanderPhase[0] = uniform();
+    wanderPhase[1] = uniform();
+    motionLeft = 0;
+    motionLength = 0;
+    motionPeak = 0;
+    startBeat();
+}
+
+void SignalGenerator::startBeat() {
+    double rr = 60.0 / (params.heartRate > 1 ? params.heartRate : 1);
+    rr *= 1 + params.hrv * gaussian() + params.respiratorySinus * sin(TWO_PI * breathPhase);
+    if (rr < 0.25) rr = 0.25;
+    if (rr > 3.0) rr = 3.0;
+    beatLength = rr * sampleRate;
+}
+
+void SignalGenerator::advance(SignalSample& out, bool emit) {
+    sampleIndex++;
+    uint8_t beat = 0;
+    phase += 1.0 / beatLength;
+    if (phase >= 1.0) {
+        phase -= 1.0;
+        startBeat();
+        beat = 1;
+    }
+
+    breathPhase += params.respirationRate / 60.0 / sampleRate;
+    breathPhase -= floor(breathPhase);
+    wanderPhase[0] += 0.05 / sampleRate;
+    wanderPhase[1] += 0.13 / sampleRate;
+
+    double motion = 0;
+    if (motionLeft == 0 && params.motionRate > 0 && uniform() < eventChance(params.motionRate)) {
+        motionLength = motionLeft = (uint32_t)((1.0 + 2.0 * uniform()) * sampleRate);
+        motionPeak = params.motionAmplitude * (uniform() < 0.5 ? -1 : 1) * (0.5 + 0.5 * uniform());
+    }
+    if (motionLeft > 0) {
+        // A decaying 3 Hz shake
+        double t = (double)(motionLength - motionLeft) / sampleRate;
+        motion = motionPeak * (double)motionLeft / motionLength * sin(TWO_PI * 3.0 * t);
+        motionLeft--;
+    }
+
+    if (!emit) return;
+
+    double breath = sin(TWO_PI * breathPhase);
+    double wander = params.baselineWander *
+                    (sin(TWO_PI * wanderPhase[0]) + 0.5 * sin(TWO_PI * wanderPhase[1]));
+
+    // ECG: waves wrap around the beat so the P wave leads the next R peak
+    double mv = 0;
+    for (const EcgWave& wave : ECG_WAVES) {
+        double d = phase - wave.center;
+        if (d >= 0.5) d -= 1.0;
+        else if (d < -0.5) d += 1.0;
+        mv += wave.amplitude * bump(d / wave.width);
+    }
+    double ecg = params.ecgBaseline + params.ecgGain * (mv + 0.05 * breath + 20 * wander + 0.02 * gaussian() + 10 * motion);
+    out.ecg = (uint16_t)(ecg < 0 ? 0 : (ecg > 4095 ? 4095 : ecg));
+
+    if (params.fingerPresent) {
+        // Systolic upstroke, then a diastolic runoff with the dicrotic wave
+        // as a shoulder on it, as at the fingertip; more blood absorbs more
+        // light
+        double pulse = bump((phase - 0.15) / 0.07) + 0.4 * bump((phase - 0.30) / 0.15) +
+                       0.15 * bump((phase - 0.45) / 0.06);
+        pulse *= params.perfusion * (1 + params.respirationDepth * breath);
+        double level = 1 + wander + 0.2 * params.respirationDepth * params.perfusion * breath + motion;
+
+        double ir = params.irDc * (level - pulse + params.noise * gaussian());
+        double red = params.redDc * (level - ratio * pulse + params.noise * gaussian());
+        out.ir = (uint32_t)(ir < 0 ? 0 : (ir > params.fullScale ? params.fullScale : ir));
+        out.red = (uint32_t)(red < 0 ? 0 : (red > params.fullScale ? params.fullScale : red));
+    } else {
+        // Ambient light only
+        out.ir = (uint32_t)(3000 + 30 * gaussian());
+        out.red = (uint32_t)(2000 + 30 * gaussian());
+    }
+
+    out.beat = beat;
+    out.lost = 0;
+    out.heartRate = (float)(60.0 * sampleRate / beatLength);
+}
+
+void SignalGenerator::next(SignalSample& out) {
+    uint16_t lost = 0;
+    if (params.fifoOverflowRate > 0 && uniform() < eventChance(params.fifoOverflowRate)) {
+        // Samples that never reach the host; the signal goes on without them
+        SignalSample skipped;
+        for (uint16_t i = 0; i < params.fifoOverflowSamples; i++) advance(skipped, false);
+        lost = params.fifoOverflowSamples;
+    }
+    advance(out, true);
+    out.lost = lost;
+}
+
+void SignalGenerator::generate(SignalSample* out, size_t count) {
+    for (size_t i = 0; i < count; i++) next(out[i]);
+}
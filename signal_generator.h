@@ -0,0 +1,97 @@
+#ifndef SIGNAL_GENERATOR_H
+#define SIGNAL_GENERATOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Synthetic patient for the simulated board, the benchmarks and the replay
+// tool: MAX30102 red/IR counts and a single-lead ECG on a common beat
+// clock. Everything is derived from one seeded generator, so a seed and a
+// parameter set always give the same samples, and the per-sample cost is a
+// handful of multiply-adds so that millions of samples take well under a
+// second.
+
+// ==================== PARAMETERS ====================
+struct PhysiologyParams {
+    // Rhythm
+    float heartRate = 72.0f;            // BPM, mean
+    float hrv = 0.03f;                  // Beat-to-beat RR jitter, SD as a fraction of RR
+    float respirationRate = 15.0f;      // Breaths per minute
+    float respiratorySinus = 0.04f;     // RR modulation by breathing, fraction of RR
+
+    // Oximetry
+    float spO2 = 97.0f;                 // %, through the red/IR ratio of ratios
+    float perfusion = 0.02f;            // IR pulsatile amplitude as a fraction of DC
+    float respirationDepth = 0.05f;     // Pulse amplitude modulation by breathing
+    bool fingerPresent = true;
+
+    // Disturbances
+    float baselineWander = 0.005f;      // Slow DC drift, fraction of DC
+    float noise = 0.001f;               // Gaussian noise SD, fraction of DC
+    float motionRate = 0.0f;            // Motion artifacts per minute
+    float motionAmplitude = 0.05f;      // Artifact peak, fraction of DC
+    float fifoOverflowRate = 0.0f;      // Dropped-sample bursts per minute
+    uint16_t fifoOverflowSamples = 32;  // Samples lost per burst
+
+    // Front end
+    uint32_t irDc = 120000;             // Counts with a finger in place
+    uint32_t redDc = 90000;
+    uint32_t fullScale = 262143;        // 18-bit ADC; brighter LEDs saturate here
+    float ecgGain = 1000.0f;            // ADC counts per mV
+    uint16_t ecgBaseline = 2048;        // 12-bit ADC mid-scale
+};
+
+struct SignalSample {
+    uint32_t red;
+    uint32_t ir;
+    float heartRate;        // Instantaneous, 60 / current RR
+    uint16_t ecg;           // 12-bit ADC counts
+    uint16_t lost;          // Samples dropped just before this one (FIFO overflow)
+    uint8_t beat;           // 1 on the sample holding an R peak
+};
+
+// ==================== GENERATOR ====================
+class SignalGenerator {
+private:
+    PhysiologyParams params;
+    float sampleRate;
+    uint64_t rng;
+
+    double phase;           // Within the current beat, 0..1
+    double beatLength;      // Current RR in samples
+    double breathPhase;
+    double wanderPhase[2];
+    double ratio;           // Red/IR ratio of ratios for params.spO2
+
+    uint32_t motionLeft;    // Samples left in the current artifact
+    uint32_t motionLength;
+    float motionPeak;
+    uint64_t sampleIndex;
+
+    uint64_t nextRandom();
+    double uniform();
+    double gaussian();
+    double eventChance(float perMinute);
+    void startBeat();
+    void advance(SignalSample& out, bool emit);
+
+public:
+    SignalGenerator(float samplesPerSecond = 100.0f, uint64_t seed = 1);
+
+    void setParams(const PhysiologyParams& p);
+    const PhysiologyParams& getParams() const { return params; }
+    void setSampleRate(float samplesPerSecond);
+    float getSampleRate() const { return sampleRate; }
+    // Restarts the sequence; the same seed replays the same samples
+    void seed(uint64_t value);
+
+    void next(SignalSample& out);
+    void generate(SignalSample* out, size_t count);
+    uint64_t getSampleIndex() const { return sampleIndex; }
+};
+
+// Red/IR ratio of ratios for a saturation, from the calibration curve the
+// MAX3010x estimator inverts (the branch above its maximum)
+double ratioForSpO2(double spO2);
+
+#endif
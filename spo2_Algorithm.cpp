@@ -1,4 +1,4 @@
-#include "spo2_algorithm.h"
+#include "spo2_Algorithm.h"
 
 SpO2Calculator spO2Calc;
 
@@ -0,0 +1,157 @@
+// Gorilla bit codecs; see gorilla.h
+#include "gorilla.h"
+#include <string.h>
+
+// ==================== BIT STREAMS ====================
+void BitWriter::write(uint64_t value, int bits) {
+    if (bits > 32) {
+        write(value >> 32, bits - 32);
+        bits = 32;
+    }
+    value &= (1ULL << bits) - 1;
+    pending = (pending << bits) | value;
+    pendingBits += bits;
+    while (pendingBits >= 8) {
+        pendingBits -= 8;
+        bytes.push_back((uint8_t)(pending >> pendingBits));
+    }
+    pending &= (1ULL << pendingBits) - 1;
+}
+
+void BitWriter::copyTo(std::vector<uint8_t>& out) const {
+    out.assign(bytes.begin(), bytes.end());
+    if (pendingBits > 0) out.push_back((uint8_t)(pending << (8 - pendingBits)));
+}
+
+void BitWriter::clear() {
+    bytes.clear();
+    pending = 0;
+    pendingBits = 0;
+}
+
+uint64_t BitReader::read(int bits) {
+    if (bits > 32) {
+        uint64_t high = read(bits - 32);
+        return (high << 32) | read(32);
+    }
+    size_t byte = position >> 3;
+    int shift = position & 7;
+    uint64_t window = 0;
+    if (byte + 8 <= size) {
+        memcpy(&window, data + byte, 8);
+        window = __builtin_bswap64(window);
+    } else {
+        for (size_t i = 0; i < 8; i++) window = (window << 8) | (byte + i < size ? data[byte + i] : 0);
+    }
+    position += bits;
+    return (window << shift) >> (64 - bits);
+}
+
+// ==================== TIMESTAMPS ====================
+void TimestampEncoder::add(BitWriter& out, int64_t value) {
+    if (count++ == 0) {
+        out.write((uint64_t)value, 64);
+        previous = value;
+        return;
+    }
+    int64_t delta = value - previous;
+    int64_t change = delta - previousDelta;
+    if (change == 0) {
+        out.writeBit(false);
+    } else if (change >= -63 && change <= 64) {
+        out.write(0x2, 2);
+        out.write((uint64_t)(change + 63), 7);
+    } else if (change >= -255 && change <= 256) {
+        out.write(0x6, 3);
+        out.write((uint64_t)(change + 255), 9);
+    } else if (change >= -2047 && change <= 2048) {
+        out.write(0xE, 4);
+        out.write((uint64_t)(change + 2047), 12);
+    } else {
+        out.write(0xF, 4);
+        out.write((uint64_t)change, 64);
+    }
+    previous = value;
+    previousDelta = delta;
+}
+
+int64_t TimestampDecoder::next(BitReader& in) {
+    if (count++ == 0) {
+        previous = (int64_t)in.read(64);
+        return previous;
+    }
+    int64_t change;
+    if (!in.readBit()) {
+        change = 0;
+    } else if (!in.readBit()) {
+        change = (int64_t)in.read(7) - 63;
+    } else if (!in.readBit()) {
+        change = (int64_t)in.read(9) - 255;
+    } else if (!in.readBit()) {
+        change = (int64_t)in.read(12) - 2047;
+    } else {
+        change = (int64_t)in.read(64);
+    }
+    previousDelta += change;
+    previous += previousDelta;
+    return previous;
+}
+
+// ==================== FLOATS ====================
+static uint32_t floatBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float bitsFloat(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void FloatEncoder::add(BitWriter& out, float value) {
+    uint32_t bits = floatBits(value);
+    if (count++ == 0) {
+        out.write(bits, 32);
+        previous = bits;
+        return;
+    }
+    uint32_t change = bits ^ previous;
+    previous = bits;
+    if (change == 0) {
+        out.writeBit(false);
+        return;
+    }
+    int lead = __builtin_clz(change);
+    int trail = __builtin_ctz(change);
+    if (lead > 31) lead = 31;
+    if (leading >= 0 && lead >= leading && trail >= trailing) {
+        out.write(0x2, 2);
+        out.write(change >> trailing, 32 - leading - trailing);
+        return;
+    }
+    leading = lead;
+    trailing = trail;
+    int length = 32 - lead - trail;
+    out.write(0x3, 2);
+    out.write((uint64_t)lead, 5);
+    out.write((uint64_t)(length - 1), 5);
+    out.write(change >> trail, length);
+}
+
+float FloatDecoder::next(BitReader& in) {
+    if (count++ == 0) {
+        previous = (uint32_t)in.read(32);
+        return bitsFloat(previous);
+    }
+    if (!in.readBit()) return bitsFloat(previous);
+    if (in.readBit()) {
+        leading = (int)in.read(5);
+        int length = (int)in.read(5) + 1;
+        trailing = 32 - leading - length;
+    }
+    uint32_t change = (uint32_t)in.read(32 - leading - trailing) << trailing;
+    previous ^= change;
+    return bitsFloat(previous);
+}
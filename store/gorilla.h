@@ -0,0 +1,110 @@
+#ifndef STORE_GORILLA_H
+#define STORE_GORILLA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Bit-level codecs of the vitals store, after Facebook's Gorilla (Pelkonen
+// et al., VLDB 2015): delta-of-delta timestamps and XOR-compressed floats.
+// Each column of a chunk is its own bit stream, MSB first, so a scan reads
+// only the columns it asks for.
+
+// ==================== BIT STREAMS ====================
+class BitWriter {
+private:
+    std::vector<uint8_t> bytes;
+    uint64_t pending;           // Low `pendingBits` bits not yet a whole byte
+    int pendingBits;
+
+public:
+    BitWriter() : pending(0), pendingBits(0) {}
+
+    void write(uint64_t value, int bits);
+    void writeBit(bool bit) { write(bit ? 1 : 0, 1); }
+
+    size_t bitCount() const { return bytes.size() * 8 + pendingBits; }
+    // The stream so far, the last byte zero padded; the writer can go on
+    void copyTo(std::vector<uint8_t>& out) const;
+    void clear();
+};
+
+class BitReader {
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t position;            // In bits
+
+public:
+    BitReader(const uint8_t* bytes, size_t length) : data(bytes), size(length), position(0) {}
+
+    // Past the end reads as zeros
+    uint64_t read(int bits);
+    bool readBit() { return read(1) != 0; }
+};
+
+// ==================== TIMESTAMPS ====================
+// The first value whole; after it, the change from the previous delta:
+//   '0'                 unchanged
+//   '10'   +  7 bits    [-63, 64]
+//   '110'  +  9 bits    [-255, 256]
+//   '1110' + 12 bits    [-2047, 2048]
+//   '1111' + 64 bits    anything else (a gap, a clock step)
+// Vitals arrive once a second, give or take the network, so most values
+// take 9 bits or less.
+class TimestampEncoder {
+private:
+    int64_t previous;
+    int64_t previousDelta;
+    uint32_t count;
+
+public:
+    TimestampEncoder() : previous(0), previousDelta(0), count(0) {}
+    void add(BitWriter& out, int64_t value);
+    void clear() { previous = previousDelta = 0; count = 0; }
+};
+
+class TimestampDecoder {
+private:
+    int64_t previous;
+    int64_t previousDelta;
+    uint32_t count;
+
+public:
+    TimestampDecoder() : previous(0), previousDelta(0), count(0) {}
+    int64_t next(BitReader& in);
+};
+
+// ==================== FLOATS ====================
+// Single precision, the firmware's own: the first value whole, then the
+// XOR with the previous one:
+//   '0'                 same value
+//   '10'  + bits        meaningful bits inside the previous window
+//   '11'  + 5 bits leading zeros + 5 bits length - 1 + bits
+// A steady battery level costs a bit per row.
+class FloatEncoder {
+private:
+    uint32_t previous;
+    int leading;                // Window of the last '11', -1 before one
+    int trailing;
+    uint32_t count;
+
+public:
+    FloatEncoder() : previous(0), leading(-1), trailing(0), count(0) {}
+    void add(BitWriter& out, float value);
+    void clear() { previous = 0; leading = -1; trailing = 0; count = 0; }
+};
+
+class FloatDecoder {
+private:
+    uint32_t previous;
+    int leading;
+    int trailing;
+    uint32_t count;
+
+public:
+    FloatDecoder() : previous(0), leading(0), trailing(0), count(0) {}
+    float next(BitReader& in);
+};
+
+#endif
@@ -0,0 +1,500 @@
+// Columnar vitals store; see vitals_store.h
+#include "vitals_store.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+static const char SEGMENT_MAGIC[4] = {'V', 'T', 'S', '1'};
+static const size_t SEGMENT_FOOTER = 8 + 4 + 4;
+
+// A read-only mapping of one segment file
+struct VitalsStore::Segment {
+    const uint8_t* base;
+    size_t length;
+
+    Segment(const uint8_t* mapped, size_t size) : base(mapped), length(size) {}
+    ~Segment() { munmap((void*)base, length); }
+};
+
+VitalsStore::VitalsStore() : segmentCount(0), nextSegment(1), segmentBytes(0) {}
+
+// ==================== SEGMENTS ====================
+std::shared_ptr<VitalsStore::Segment> VitalsStore::map(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat info;
+    void* mapped = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (mapped == MAP_FAILED) return nullptr;
+    return std::make_shared<Segment>((const uint8_t*)mapped, (size_t)info.st_size);
+}
+
+// Reads a little native-order value and moves past it
+template <typename T>
+static bool take(const uint8_t*& p, const uint8_t* end, T& value) {
+    if ((size_t)(end - p) < sizeof(T)) return false;
+    memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+bool VitalsStore::load(const std::string& path) {
+    std::shared_ptr<Segment> segment = map(path);
+    if (!segment) return false;
+    const uint8_t* base = segment->base;
+    size_t length = segment->length;
+    if (length < sizeof(SEGMENT_MAGIC) + SEGMENT_FOOTER || memcmp(base, SEGMENT_MAGIC, 4) != 0 ||
+        memcmp(base + length - 4, SEGMENT_MAGIC, 4) != 0) {
+        return false;
+    }
+    uint64_t indexOffset;
+    uint32_t count;
+    memcpy(&indexOffset, base + length - SEGMENT_FOOTER, 8);
+    memcpy(&count, base + length - SEGMENT_FOOTER + 8, 4);
+    if (indexOffset > length - SEGMENT_FOOTER) return false;
+
+    // Parsed whole before any of it is added, so a damaged index adds nothing
+    std::vector<std::pair<std::string, Chunk>> parsed;
+    const uint8_t* p = base + indexOffset;
+    const uint8_t* end = base + length - SEGMENT_FOOTER;
+    for (uint32_t i = 0; i < count; i++) {
+        uint16_t nameLength;
+        if (!take(p, end, nameLength) || (size_t)(end - p) < nameLength) return false;
+        std::string name((const char*)p, nameLength);
+        p += nameLength;
+        Chunk chunk;
+        if (!take(p, end, chunk.minTime) || !take(p, end, chunk.maxTime) || !take(p, end, chunk.rows)) return false;
+        for (int c = 0; c < VITALS_COLUMNS; c++) {
+            uint64_t offset;
+            if (!take(p, end, offset) || !take(p, end, chunk.lengths[c])) return false;
+            if (offset > indexOffset || chunk.lengths[c] > indexOffset - offset) return false;
+            chunk.columns[c] = base + offset;
+        }
+        chunk.owner = segment;
+        parsed.push_back(std::make_pair(name, chunk));
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    for (auto& entry : parsed) {
+        Device& owner = device(entry.first);
+        owner.chunks.push_back(entry.second);
+        owner.flushed = owner.chunks.size();
+    }
+    segmentCount++;
+    segmentBytes += length;
+    return true;
+}
+
+bool VitalsStore::open(const char* dir) {
+    directory = dir;
+    mkdir(dir, 0755);
+    DIR* listing = opendir(dir);
+    if (!listing) return false;
+    std::vector<std::string> names;
+    while (struct dirent* entry = readdir(listing)) {
+        size_t length = strlen(entry->d_name);
+        if (length > 4 && strcmp(entry->d_name + length - 4, ".vts") == 0) names.push_back(entry->d_name);
+    }
+    closedir(listing);
+
+    // Numbered in the order they were written, so each device's chunks stay oldest first
+    std::sort(names.begin(), names.end());
+    bool ok = true;
+    for (const std::string& name : names) {
+        if (!load(directory + "/" + name)) {
+            fprintf(stderr, "store: %s/%s is not a segment, skipped\n", dir, name.c_str());
+            ok = false;
+        }
+        uint32_t number = strtoul(name.c_str(), nullptr, 10);
+        if (number >= nextSegment) nextSegment = number + 1;
+    }
+    return ok;
+}
+
+bool VitalsStore::close() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto& entry : devices) seal(*entry);
+    }
+    bool ok = flush();
+    std::lock_guard<std::mutex> guard(lock);
+    devices.clear();
+    byName.clear();
+    segmentCount = 0;
+    segmentBytes = 0;
+    return ok;
+}
+
+bool VitalsStore::flush() {
+    std::lock_guard<std::mutex> one(flushing);
+
+    // What to write; the chunks stay where they are while the lock is let go
+    struct Pending {
+        Device* device;
+        size_t first;
+        std::vector<Chunk> chunks;
+    };
+    std::vector<Pending> pending;
+    uint32_t number;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto& entry : devices) {
+            Device& d = *entry;
+            if (d.flushed == d.chunks.size()) continue;
+            pending.push_back({&d, d.flushed, std::vector<Chunk>(d.chunks.begin() + d.flushed, d.chunks.end())});
+        }
+        if (pending.empty()) return true;
+        number = nextSegment++;
+    }
+    if (directory.empty()) return false;
+
+    char name[32];
+    snprintf(name, sizeof(name), "/%06u.vts", (unsigned)number);
+    std::string path = directory + name;
+    std::string temporary = path + ".tmp";
+    FILE* f = fopen(temporary.c_str(), "wb");
+    if (!f) return false;
+
+    std::vector<uint64_t> offsets;
+    uint64_t at = sizeof(SEGMENT_MAGIC);
+    fwrite(SEGMENT_MAGIC, 1, sizeof(SEGMENT_MAGIC), f);
+    for (const Pending& p : pending) {
+        for (const Chunk& chunk : p.chunks) {
+            for (int c = 0; c < VITALS_COLUMNS; c++) {
+                fwrite(chunk.columns[c], 1, chunk.lengths[c], f);
+                offsets.push_back(at);
+                at += chunk.lengths[c];
+            }
+        }
+    }
+    uint64_t indexOffset = at;
+    uint32_t count = 0;
+    size_t column = 0;
+    for (const Pending& p : pending) {
+        uint16_t nameLength = (uint16_t)std::min(p.device->name.size(), (size_t)UINT16_MAX);
+        for (const Chunk& chunk : p.chunks) {
+            fwrite(&nameLength, sizeof(nameLength), 1, f);
+            fwrite(p.device->name.data(), 1, nameLength, f);
+            fwrite(&chunk.minTime, sizeof(chunk.minTime), 1, f);
+            fwrite(&chunk.maxTime, sizeof(chunk.maxTime), 1, f);
+            fwrite(&chunk.rows, sizeof(chunk.rows), 1, f);
+            for (int c = 0; c < VITALS_COLUMNS; c++) {
+                fwrite(&offsets[column++], sizeof(uint64_t), 1, f);
+                fwrite(&chunk.lengths[c], sizeof(uint32_t), 1, f);
+            }
+            count++;
+        }
+    }
+    fwrite(&indexOffset, sizeof(indexOffset), 1, f);
+    fwrite(&count, sizeof(count), 1, f);
+    fwrite(SEGMENT_MAGIC, 1, sizeof(SEGMENT_MAGIC), f);
+    bool written = fflush(f) == 0 && fsync(fileno(f)) == 0 && !ferror(f);
+    written = fclose(f) == 0 && written;
+    if (!written || rename(temporary.c_str(), path.c_str()) != 0) {
+        unlink(temporary.c_str());
+        return false;
+    }
+
+    // Swap the buffers for the mapping; scans still holding the buffers keep them
+    std::shared_ptr<Segment> segment = map(path);
+    if (!segment) return false;
+    std::lock_guard<std::mutex> guard(lock);
+    column = 0;
+    for (const Pending& p : pending) {
+        for (size_t i = 0; i < p.chunks.size(); i++) {
+            Chunk& chunk = p.device->chunks[p.first + i];
+            for (int c = 0; c < VITALS_COLUMNS; c++) chunk.columns[c] = segment->base + offsets[column++];
+            chunk.owner = segment;
+        }
+        p.device->flushed = p.first + p.chunks.size();
+    }
+    segmentCount++;
+    segmentBytes += segment->length;
+    return true;
+}
+
+// ==================== APPEND ====================
+VitalsStore::Device& VitalsStore::device(const std::string& name) {
+    auto found = byName.find(name);
+    if (found != byName.end()) return *found->second;
+    devices.emplace_back(new Device());
+    Device& added = *devices.back();
+    added.name = name;
+    added.flushed = 0;
+    added.head.rows = 0;
+    byName[name] = &added;
+    return added;
+}
+
+VitalsStore::Chunk VitalsStore::snapshot(const Head& head) {
+    std::shared_ptr<std::vector<uint8_t>> buffer = std::make_shared<std::vector<uint8_t>>();
+    std::vector<uint8_t> stream;
+    uint32_t starts[VITALS_COLUMNS];
+    Chunk chunk;
+    for (int c = 0; c < VITALS_COLUMNS; c++) {
+        head.streams[c].copyTo(stream);
+        starts[c] = buffer->size();
+        chunk.lengths[c] = stream.size();
+        buffer->insert(buffer->end(), stream.begin(), stream.end());
+    }
+    for (int c = 0; c < VITALS_COLUMNS; c++) chunk.columns[c] = buffer->data() + starts[c];
+    chunk.minTime = head.minTime;
+    chunk.maxTime = head.maxTime;
+    chunk.rows = head.rows;
+    chunk.owner = buffer;
+    return chunk;
+}
+
+void VitalsStore::seal(Device& device) {
+    Head& head = device.head;
+    if (head.rows == 0) return;
+    device.chunks.push_back(snapshot(head));
+    for (int c = 0; c < VITALS_COLUMNS; c++) head.streams[c].clear();
+    head.time.clear();
+    head.heartRate.clear();
+    head.spO2.clear();
+    head.batteryLevel.clear();
+    head.rows = 0;
+}
+
+void VitalsStore::append(const std::string& name, const VitalSigns& vitals) {
+    int64_t time = (int64_t)vitals.timestamp;
+    std::lock_guard<std::mutex> guard(lock);
+    Device& d = device(name);
+    Head& head = d.head;
+    if (head.rows >= CHUNK_ROWS || (head.rows > 0 && time - head.minTime >= CHUNK_SPAN)) seal(d);
+    if (head.rows == 0) {
+        head.minTime = head.maxTime = time;
+    } else {
+        head.minTime = std::min(head.minTime, time);
+        head.maxTime = std::max(head.maxTime, time);
+    }
+    head.time.add(head.streams[VITALS_COLUMN_TIME], time);
+    head.heartRate.add(head.streams[VITALS_COLUMN_HEART_RATE], vitals.heartRate);
+    head.spO2.add(head.streams[VITALS_COLUMN_SPO2], vitals.spO2);
+    head.batteryLevel.add(head.streams[VITALS_COLUMN_BATTERY], vitals.batteryLevel);
+    head.streams[VITALS_COLUMN_FINGER].writeBit(vitals.isFingerDetected);
+    head.rows++;
+}
+
+// ==================== SCANS ====================
+template <typename T>
+static void decodeFloats(const uint8_t* data, uint32_t length, uint32_t rows, std::vector<T>& out) {
+    BitReader in(data, length);
+    FloatDecoder decoder;
+    out.resize(rows);
+    for (uint32_t i = 0; i < rows; i++) out[i] = decoder.next(in);
+}
+
+template <typename T>
+static void keepRows(std::vector<T>& column, const std::vector<uint8_t>& keep) {
+    if (column.empty()) return;
+    size_t kept = 0;
+    for (size_t i = 0; i < column.size(); i++) {
+        if (keep[i]) column[kept++] = column[i];
+    }
+    column.resize(kept);
+}
+
+void VitalsStore::decode(const Chunk& chunk, uint8_t columns, int64_t from, int64_t to, VitalsColumns& out) {
+    uint32_t rows = chunk.rows;
+    {
+        BitReader in(chunk.columns[VITALS_COLUMN_TIME], chunk.lengths[VITALS_COLUMN_TIME]);
+        TimestampDecoder decoder;
+        out.time.resize(rows);
+        for (uint32_t i = 0; i < rows; i++) out.time[i] = decoder.next(in);
+    }
+    out.heartRate.clear();
+    out.spO2.clear();
+    out.batteryLevel.clear();
+    out.finger.clear();
+    if (columns & VITALS_READ_HEART_RATE) {
+        decodeFloats(chunk.columns[VITALS_COLUMN_HEART_RATE], chunk.lengths[VITALS_COLUMN_HEART_RATE], rows, out.heartRate);
+    }
+    if (columns & VITALS_READ_SPO2) {
+        decodeFloats(chunk.columns[VITALS_COLUMN_SPO2], chunk.lengths[VITALS_COLUMN_SPO2], rows, out.spO2);
+    }
+    if (columns & VITALS_READ_BATTERY) {
+        decodeFloats(chunk.columns[VITALS_COLUMN_BATTERY], chunk.lengths[VITALS_COLUMN_BATTERY], rows, out.batteryLevel);
+    }
+    if (columns & VITALS_READ_FINGER) {
+        BitReader in(chunk.columns[VITALS_COLUMN_FINGER], chunk.lengths[VITALS_COLUMN_FINGER]);
+        out.finger.resize(rows);
+        for (uint32_t i = 0; i < rows; i++) out.finger[i] = in.readBit();
+    }
+
+    // Chunks at the window's edges keep only the rows inside it
+    if (chunk.minTime >= from && chunk.maxTime < to) return;
+    std::vector<uint8_t> keep(rows);
+    for (uint32_t i = 0; i < rows; i++) keep[i] = out.time[i] >= from && out.time[i] < to;
+    keepRows(out.time, keep);
+    keepRows(out.heartRate, keep);
+    keepRows(out.spO2, keep);
+    keepRows(out.batteryLevel, keep);
+    keepRows(out.finger, keep);
+}
+
+void VitalsStore::scan(const VitalsScan& scan, const ScanVisitor& visit) {
+    struct Task {
+        std::string device;
+        std::vector<Chunk> chunks;
+    };
+    std::vector<Task> tasks;
+    auto overlaps = [&scan](int64_t minTime, int64_t maxTime) { return maxTime >= scan.from && minTime < scan.to; };
+    auto collect = [&](Device& d) {
+        Task task;
+        task.device = d.name;
+        for (const Chunk& chunk : d.chunks) {
+            if (overlaps(chunk.minTime, chunk.maxTime)) task.chunks.push_back(chunk);
+        }
+        if (d.head.rows > 0 && overlaps(d.head.minTime, d.head.maxTime)) task.chunks.push_back(snapshot(d.head));
+        if (!task.chunks.empty()) tasks.push_back(std::move(task));
+    };
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (scan.devices.empty()) {
+            for (auto& entry : devices) collect(*entry);
+        } else {
+            for (const std::string& name : scan.devices) {
+                auto found = byName.find(name);
+                if (found != byName.end()) collect(*found->second);
+            }
+        }
+    }
+
+    // Devices are handed out one at a time, biggest share of the window first
+    std::sort(tasks.begin(), tasks.end(),
+              [](const Task& a, const Task& b) { return a.chunks.size() > b.chunks.size(); });
+    std::atomic<size_t> next(0);
+    auto work = [&](int worker) {
+        VitalsColumns rows;
+        for (size_t i; (i = next.fetch_add(1)) < tasks.size();) {
+            for (const Chunk& chunk : tasks[i].chunks) {
+                decode(chunk, scan.columns, scan.from, scan.to, rows);
+                if (rows.size() > 0) visit(worker, tasks[i].device, rows);
+            }
+        }
+    };
+    int threads = std::max(1, std::min(scan.threads, (int)tasks.size()));
+    std::vector<std::thread> helpers;
+    for (int w = 1; w < threads; w++) helpers.emplace_back(work, w);
+    work(0);
+    for (std::thread& helper : helpers) helper.join();
+}
+
+size_t VitalsStore::read(const std::string& device, int64_t from, int64_t to, std::vector<VitalSigns>& out) {
+    VitalsScan one;
+    one.from = from;
+    one.to = to;
+    one.devices.push_back(device);
+    one.threads = 1;
+    size_t before = out.size();
+    scan(one, [&out](int, const std::string&, const VitalsColumns& rows) {
+        for (size_t i = 0; i < rows.size(); i++) {
+            VitalSigns vitals;
+            vitals.timestamp = (unsigned long)rows.time[i];
+            vitals.heartRate = rows.heartRate[i];
+            vitals.spO2 = rows.spO2[i];
+            vitals.batteryLevel = rows.batteryLevel[i];
+            vitals.isFingerDetected = rows.finger[i] != 0;
+            out.push_back(vitals);
+        }
+    });
+    return out.size() - before;
+}
+
+void VitalsStore::rollup(const VitalsScan& scan, int64_t resolution, std::vector<VitalsRollup>& out) {
+    if (resolution <= 0) resolution = 1;
+    VitalsScan columns = scan;
+    columns.columns = VITALS_READ_HEART_RATE | VITALS_READ_SPO2 | VITALS_READ_FINGER;
+    std::vector<std::vector<VitalsRollup>> perWorker(std::max(1, scan.threads));
+
+    // Means are sums until the buckets of all workers are in
+    this->scan(columns, [&](int worker, const std::string& device, const VitalsColumns& rows) {
+        std::vector<VitalsRollup>& buckets = perWorker[worker];
+        for (size_t i = 0; i < rows.size(); i++) {
+            if (!rows.finger[i]) continue;
+            int64_t offset = rows.time[i] - scan.from;
+            int64_t start = scan.from + (offset - ((offset % resolution) + resolution) % resolution);
+            if (buckets.empty() || buckets.back().start != start || buckets.back().device != device) {
+                VitalsRollup bucket;
+                bucket.device = device;
+                bucket.start = start;
+                bucket.rows = 0;
+                bucket.heartRateMin = bucket.spO2Min = INFINITY;
+                bucket.heartRateMax = bucket.spO2Max = -INFINITY;
+                bucket.heartRateMean = bucket.spO2Mean = 0;
+                buckets.push_back(bucket);
+            }
+            VitalsRollup& bucket = buckets.back();
+            float heartRate = rows.heartRate[i];
+            float spO2 = rows.spO2[i];
+            bucket.rows++;
+            bucket.heartRateMin = std::min(bucket.heartRateMin, heartRate);
+            bucket.heartRateMax = std::max(bucket.heartRateMax, heartRate);
+            bucket.heartRateMean += heartRate;
+            bucket.spO2Min = std::min(bucket.spO2Min, spO2);
+            bucket.spO2Max = std::max(bucket.spO2Max, spO2);
+            bucket.spO2Mean += spO2;
+        }
+    });
+
+    size_t first = out.size();
+    for (auto& buckets : perWorker) out.insert(out.end(), buckets.begin(), buckets.end());
+    std::sort(out.begin() + first, out.end(), [](const VitalsRollup& a, const VitalsRollup& b) {
+        return a.device != b.device ? a.device < b.device : a.start < b.start;
+    });
+    // Rows out of time order can split a bucket
+    size_t kept = first;
+    for (size_t i = first; i < out.size(); i++) {
+        if (kept > first && out[kept - 1].device == out[i].device && out[kept - 1].start == out[i].start) {
+            VitalsRollup& into = out[kept - 1];
+            into.rows += out[i].rows;
+            into.heartRateMin = std::min(into.heartRateMin, out[i].heartRateMin);
+            into.heartRateMax = std::max(into.heartRateMax, out[i].heartRateMax);
+            into.heartRateMean += out[i].heartRateMean;
+            into.spO2Min = std::min(into.spO2Min, out[i].spO2Min);
+            into.spO2Max = std::max(into.spO2Max, out[i].spO2Max);
+            into.spO2Mean += out[i].spO2Mean;
+        } else {
+            if (kept != i) out[kept] = std::move(out[i]);
+            kept++;
+        }
+    }
+    out.resize(kept);
+    for (size_t i = first; i < out.size(); i++) {
+        out[i].heartRateMean /= out[i].rows;
+        out[i].spO2Mean /= out[i].rows;
+    }
+}
+
+VitalsStoreStats VitalsStore::getStats() {
+    std::lock_guard<std::mutex> guard(lock);
+    VitalsStoreStats stats = {};
+    stats.devices = devices.size();
+    stats.segments = segmentCount;
+    stats.segmentBytes = segmentBytes;
+    for (auto& entry : devices) {
+        const Device& d = *entry;
+        for (size_t i = 0; i < d.chunks.size(); i++) {
+            stats.rows += d.chunks[i].rows;
+            if (i < d.flushed) continue;
+            for (int c = 0; c < VITALS_COLUMNS; c++) stats.memoryBytes += d.chunks[i].lengths[c];
+        }
+        stats.chunks += d.chunks.size();
+        stats.rows += d.head.rows;
+        for (int c = 0; c < VITALS_COLUMNS; c++) stats.memoryBytes += (d.head.streams[c].bitCount() + 7) / 8;
+    }
+    return stats;
+}
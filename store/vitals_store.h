@@ -0,0 +1,175 @@
+#ifndef STORE_VITALS_STORE_H
+#define STORE_VITALS_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "gorilla.h"
+#include "../vital_signs.h"
+
+// Embedded time-series store for the central station: days of 1 Hz vitals
+// for a ward of monitors, keyed by device id. Linux only.
+//
+// Rows are the firmware's VitalSigns, with `timestamp` as the store's time
+// key: ms since an epoch the writer picks (the gateway uses Unix time, as
+// the monitors' own millis() restart with every boot). `sequence` is not
+// kept.
+//
+// Each device appends to an open head chunk in memory. A head is sealed
+// once it holds CHUNK_ROWS rows or spans CHUNK_SPAN, and flush() writes the
+// sealed chunks of every device into a new segment file, which is then read
+// through a read-only memory map. A chunk stores each column as its own
+// Gorilla bit stream (gorilla.h): under 2 bytes a row against the 16 of
+// VitalsRecord on the monitor's flash.
+//
+// Segment file, native byte order:
+//   "VTS1"
+//   column streams of each chunk, back to back
+//   index: per chunk {u16 nameLength, name, i64 minTime, i64 maxTime,
+//          u32 rows, VITALS_COLUMNS x {u64 offset, u32 length}}
+//   u64 index offset, u32 chunks, "VTS1"
+// A segment is written under a temporary name and renamed, so a crash
+// leaves whole segments only; rows still in the heads are lost with it.
+//
+// Scans take a snapshot under the lock and decode outside it, one device
+// per task across worker threads, so appends carry on meanwhile.
+
+enum VitalsColumn : uint8_t {
+    VITALS_COLUMN_TIME = 0,
+    VITALS_COLUMN_HEART_RATE,
+    VITALS_COLUMN_SPO2,
+    VITALS_COLUMN_BATTERY,
+    VITALS_COLUMN_FINGER,
+    VITALS_COLUMNS
+};
+
+// Column masks for VitalsScan; time is always read
+#define VITALS_READ_HEART_RATE (1 << VITALS_COLUMN_HEART_RATE)
+#define VITALS_READ_SPO2 (1 << VITALS_COLUMN_SPO2)
+#define VITALS_READ_BATTERY (1 << VITALS_COLUMN_BATTERY)
+#define VITALS_READ_FINGER (1 << VITALS_COLUMN_FINGER)
+#define VITALS_READ_ALL 0xFF
+
+// Decoded rows of one chunk, trimmed to the scan's window; columns the
+// scan did not ask for are empty
+struct VitalsColumns {
+    std::vector<int64_t> time;
+    std::vector<float> heartRate;
+    std::vector<float> spO2;
+    std::vector<float> batteryLevel;
+    std::vector<uint8_t> finger;
+
+    size_t size() const { return time.size(); }
+};
+
+struct VitalsScan {
+    int64_t from = 0;                   // Inclusive
+    int64_t to = INT64_MAX;             // Exclusive
+    std::vector<std::string> devices;   // Empty for all
+    uint8_t columns = VITALS_READ_ALL;
+    int threads = 4;
+};
+
+// Statistics of one bucket of one device, over rows with a finger on the sensor
+struct VitalsRollup {
+    std::string device;
+    int64_t start;
+    uint32_t rows;
+    float heartRateMin, heartRateMax, heartRateMean;
+    float spO2Min, spO2Max, spO2Mean;
+};
+
+struct VitalsStoreStats {
+    uint32_t devices;
+    uint64_t rows;
+    uint32_t chunks;                // Sealed, in segments or waiting for flush()
+    uint32_t segments;
+    uint64_t segmentBytes;
+    uint64_t memoryBytes;           // Encoded rows not yet in a segment
+};
+
+class VitalsStore {
+public:
+    static const uint32_t CHUNK_ROWS = 7200;
+    static const int64_t CHUNK_SPAN = 2 * 3600 * 1000LL;
+
+    // Called on a worker thread; one device's chunks come in time order on
+    // the same worker, so per-worker state needs no locking
+    typedef std::function<void(int worker, const std::string& device, const VitalsColumns& rows)> ScanVisitor;
+
+private:
+    struct Segment;
+
+    // A sealed chunk, in a mapped segment or waiting for flush()
+    struct Chunk {
+        int64_t minTime;
+        int64_t maxTime;
+        uint32_t rows;
+        const uint8_t* columns[VITALS_COLUMNS];
+        uint32_t lengths[VITALS_COLUMNS];
+        std::shared_ptr<const void> owner;  // Keeps the mapping or the buffers alive
+    };
+
+    struct Head {
+        BitWriter streams[VITALS_COLUMNS];
+        TimestampEncoder time;
+        FloatEncoder heartRate;
+        FloatEncoder spO2;
+        FloatEncoder batteryLevel;
+        int64_t minTime;
+        int64_t maxTime;
+        uint32_t rows;
+    };
+
+    struct Device {
+        std::string name;
+        std::vector<Chunk> chunks;      // Oldest first
+        size_t flushed;                 // chunks[0, flushed) are in segments
+        Head head;
+    };
+
+    std::string directory;
+    std::vector<std::unique_ptr<Device>> devices;
+    std::unordered_map<std::string, Device*> byName;
+    uint32_t segmentCount;
+    uint32_t nextSegment;
+    uint64_t segmentBytes;
+    std::mutex lock;
+    std::mutex flushing;            // One flush() at a time; `lock` is let go while it writes
+
+    Device& device(const std::string& name);
+    void seal(Device& device);
+    static Chunk snapshot(const Head& head);
+    static std::shared_ptr<Segment> map(const std::string& path);
+    bool load(const std::string& path);
+    static void decode(const Chunk& chunk, uint8_t columns, int64_t from, int64_t to, VitalsColumns& out);
+
+public:
+    VitalsStore();
+
+    // Maps the segments already in `dir`, creating it if needed
+    bool open(const char* dir);
+    // Seals every head and flushes; the store can be opened again after.
+    // Nothing else may run alongside it.
+    bool close();
+
+    void append(const std::string& device, const VitalSigns& vitals);
+    // Writes the sealed chunks to a new segment; true if there were none
+    bool flush();
+
+    // Runs `visit` over every row in the window
+    void scan(const VitalsScan& scan, const ScanVisitor& visit);
+    // One device's rows, oldest first
+    size_t read(const std::string& device, int64_t from, int64_t to, std::vector<VitalSigns>& out);
+    // `resolution`-wide buckets, by device and then time
+    void rollup(const VitalsScan& scan, int64_t resolution, std::vector<VitalsRollup>& out);
+
+    VitalsStoreStats getStats();
+};
+
+#endif
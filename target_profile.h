@@ -0,0 +1,131 @@
+#ifndef TARGET_PROFILE_H
+#define TARGET_PROFILE_H
+
+#include <stdint.h>
+
+// What the monitor core needs to know about the board it is built for, as
+// compile-time constants. One build has one profile, picked by the
+// environment in platformio.ini:
+//
+//   -DTARGET_UNO              Arduino Uno: buttons, EEPROM, no WiFi
+//   -DTARGET_ESP32_SPI        ESP32 with the ILI9341 on SPI (default)
+//   -DTARGET_ESP32_PARALLEL   ESP32 with the ILI9341 on an 8-bit parallel bus
+//   -DTARGET_ESP32_ECG        ESP32 on SPI with an AD8232 ECG lead traced on screen
+//
+// The profile sizes the core's buffers and sets its intervals and battery
+// conversion; monitor_core.h drops whatever a profile does not have. Code
+// that needs a whole library gone (WiFi, the web server, the JSON schemas)
+// tests the TARGET_ macro instead, since an #include cannot be discarded
+// by `if constexpr`. tools/profile_size.py reports what each costs.
+
+#if !defined(TARGET_UNO) && !defined(TARGET_ESP32_PARALLEL) && !defined(TARGET_ESP32_SPI) && \
+    !defined(TARGET_ESP32_ECG)
+#define TARGET_ESP32_SPI
+#endif
+
+enum class DisplayBus : uint8_t {
+    SPI,
+    PARALLEL_8BIT
+};
+
+enum class SettingsStore : uint8_t {
+    EEPROM,
+    PREFERENCES     // NVS through Preferences
+};
+
+enum class InputKind : uint8_t {
+    BUTTONS,
+    TOUCH
+};
+
+// ==================== PROFILES ====================
+struct UnoProfile {
+    static constexpr const char* NAME = "uno";
+    static constexpr DisplayBus DISPLAY_BUS = DisplayBus::SPI;
+    static constexpr SettingsStore SETTINGS = SettingsStore::EEPROM;
+    static constexpr InputKind INPUT_KIND = InputKind::BUTTONS;
+    static constexpr bool HAS_WIFI = false;
+    static constexpr bool HAS_FLASH_LOG = false;
+    static constexpr bool HAS_INSTRUMENTATION = false;
+    static constexpr bool HAS_ECG_TRACE = false;
+
+    // SparkFun's estimator takes 16-bit samples on AVR; 50 of them are a
+    // 2 s window at FreqS, the shortest it estimates from
+    typedef uint16_t PpgSample;
+    static constexpr int PPG_WINDOW = 50;
+    static constexpr int HISTORY = 10;              // Readings kept, and in EEPROM
+    static constexpr int LOG_SAVE_EVERY = 6;        // Readings per EEPROM write
+
+    // One FreqS period. Each update drains what has arrived; the driver
+    // holds 4 samples, so an update may run up to 160 ms late losing none.
+    static constexpr uint16_t SENSOR_INTERVAL_MS = 40;
+    static constexpr uint16_t DISPLAY_INTERVAL_MS = 500;
+    static constexpr uint16_t LOG_INTERVAL_MS = 5000;
+    static constexpr uint16_t ALERT_INTERVAL_MS = 1000;
+
+    // 10-bit ADC against the 5 V rail, battery straight on the pin
+    static constexpr double ADC_FULL_SCALE = 1023.0;
+    static constexpr double ADC_REFERENCE = 5.0;
+    static constexpr double BATTERY_DIVIDER = 1.0;
+
+    static constexpr uint32_t FLASH_BYTES = 32256;  // ATmega328P less the bootloader
+    static constexpr uint32_t RAM_BYTES = 2048;
+    static constexpr uint16_t CORE_RAM_BUDGET = 640;
+};
+
+struct Esp32SpiProfile {
+    static constexpr const char* NAME = "esp32_spi";
+    static constexpr DisplayBus DISPLAY_BUS = DisplayBus::SPI;
+    static constexpr SettingsStore SETTINGS = SettingsStore::PREFERENCES;
+    static constexpr InputKind INPUT_KIND = InputKind::TOUCH;
+    static constexpr bool HAS_WIFI = true;
+    static constexpr bool HAS_FLASH_LOG = true;
+    static constexpr bool HAS_INSTRUMENTATION = true;
+    static constexpr bool HAS_ECG_TRACE = false;
+
+    typedef uint32_t PpgSample;
+    static constexpr int PPG_WINDOW = 100;          // 4 s at FreqS, the estimator's BUFFER_SIZE
+    static constexpr int HISTORY = 100;
+    static constexpr int LOG_SAVE_EVERY = 10;       // Readings per /data.csv rewrite
+
+    static constexpr uint16_t SENSOR_INTERVAL_MS = 40;     // As the Uno's
+    static constexpr uint16_t DISPLAY_INTERVAL_MS = 100;
+    static constexpr uint16_t LOG_INTERVAL_MS = 1000;
+    static constexpr uint16_t ALERT_INTERVAL_MS = 1000;
+    // ECG_PIN is read at 50 Hz where the trace is on, one pixel per sample
+    static constexpr uint16_t ECG_INTERVAL_MS = 20;
+
+    // 12-bit ADC at 3.3 V behind a 1:2 divider
+    static constexpr double ADC_FULL_SCALE = 4095.0;
+    static constexpr double ADC_REFERENCE = 3.3;
+    static constexpr double BATTERY_DIVIDER = 2.0;
+
+    static constexpr uint32_t FLASH_BYTES = 2097152; // partitions.csv app partition
+    static constexpr uint32_t RAM_BYTES = 327680;
+    static constexpr uint16_t CORE_RAM_BUDGET = 4608;
+};
+
+// Same board and features; only the panel's bus differs
+struct Esp32ParallelProfile : Esp32SpiProfile {
+    static constexpr const char* NAME = "esp32_parallel";
+    static constexpr DisplayBus DISPLAY_BUS = DisplayBus::PARALLEL_8BIT;
+};
+
+// The SPI board with the AD8232 front end on ECG_PIN, as cardiac.ino had
+// it: the main screen's waveform box traces the lead instead of the pulse
+struct Esp32EcgProfile : Esp32SpiProfile {
+    static constexpr const char* NAME = "esp32_ecg";
+    static constexpr bool HAS_ECG_TRACE = true;
+};
+
+#if defined(TARGET_UNO)
+typedef UnoProfile TargetProfile;
+#elif defined(TARGET_ESP32_PARALLEL)
+typedef Esp32ParallelProfile TargetProfile;
+#elif defined(TARGET_ESP32_ECG)
+typedef Esp32EcgProfile TargetProfile;
+#else
+typedef Esp32SpiProfile TargetProfile;
+#endif
+
+#endif
@@ -0,0 +1,160 @@
+/*
+ * Time from a desaturation to its critical alarm, through the ESP32
+ * profile's monitor core on the simulated sensor: the step lands at
+ * several points of the estimator's window and each must alarm within
+ * MAX_ALARM_LATENCY_MS. Then the alarm rules' cooldown: a critical
+ * reading is not held back by the warning raised on its way down.
+ *
+ *   pio test -e native -f test_alarm_latency
+ */
+
+#include <unity.h>
+#include "monitor_core.h"
+#include "hal_sim.h"
+
+static const uint32_t MAX_ALARM_LATENCY_MS = 10000;
+static const uint32_t STEP_AT_MS = 60000;
+
+struct TestBoard {
+    static uint16_t check() { return simSensor.check(); }
+    static bool available() { return simSensor.available(); }
+    static uint32_t getRed() { return simSensor.getRed(); }
+    static uint32_t getIR() { return simSensor.getIR(); }
+    static void nextSample() { simSensor.nextSample(); }
+    static uint16_t readBattery() { return 4095; }
+    static uint32_t now() { return simClock.millis(); }
+};
+
+struct TestSettings {
+    static void load(AlertThresholds& thresholds) {}
+    static void save(const AlertThresholds& thresholds) {}
+};
+
+struct TestLog {
+    static void append(const VitalSigns& vitals) {}
+    static void flush() {}
+};
+
+typedef MonitorCore<Esp32SpiProfile, TestBoard, TestSettings, TestLog> TestMonitor;
+
+static PhysiologyParams patient(float heartRate, float spO2) {
+    PhysiologyParams p;
+    p.heartRate = heartRate;
+    p.spO2 = spO2;
+    return p;
+}
+
+// Runs the core at the sketch's intervals from boot; the patient steps to
+// 85 % at STEP_AT_MS + offset. Returns ms from the step to the first
+// critical SpO2 alarm, or UINT32_MAX if none came in 30 s.
+static uint32_t desaturationLatency(uint32_t offset, uint64_t seed) {
+    TestMonitor* monitor = new TestMonitor();
+    simSensor.seed(seed);
+    simSensor.setPatient(patient(72, 97));
+    simSensor.setup();
+
+    uint32_t start = TestBoard::now();
+    uint32_t stepAt = start + STEP_AT_MS + offset;
+    uint32_t lastAlertCheck = start;
+    bool stepped = false;
+    uint32_t latency = UINT32_MAX;
+
+    while (TestBoard::now() - start < STEP_AT_MS + offset + 30000) {
+        simClock.advance(Esp32SpiProfile::SENSOR_INTERVAL_MS * 1000);
+        uint32_t now = TestBoard::now();
+        if (!stepped && now >= stepAt) {
+            simSensor.setPatient(patient(72, 85));
+            stepped = true;
+        }
+        monitor->updateSensors();
+
+        if (now - lastAlertCheck < Esp32SpiProfile::ALERT_INTERVAL_MS) continue;
+        lastAlertCheck = now;
+        AlarmEvent alarm;
+        if (monitor->checkAlerts(alarm) && stepped && alarm.kind == AlarmKind::SPO2 &&
+            alarm.level == AlertLevel::CRITICAL) {
+            latency = now - stepAt;
+            break;
+        }
+    }
+    delete monitor;
+    return latency;
+}
+
+static VitalSigns reading(float heartRate, float spO2) {
+    VitalSigns vitals;
+    vitals.heartRate = heartRate;
+    vitals.spO2 = spO2;
+    vitals.batteryLevel = 80;
+    vitals.isFingerDetected = true;
+    vitals.timestamp = 0;
+    vitals.sequence = 0;
+    return vitals;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static void test_desaturation_alarms_in_time_at_every_window_phase(void) {
+    // Five offsets 0.8 s apart cover the 4 s window
+    for (uint64_t seed = 1; seed <= 3; seed++) {
+        for (uint32_t offset = 0; offset < 4000; offset += 800) {
+            uint32_t latency = desaturationLatency(offset, seed);
+            char message[64];
+            snprintf(message, sizeof(message), "seed %d, step %d ms into the window", (int)seed, (int)offset);
+            TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE(MAX_ALARM_LATENCY_MS, latency, message);
+        }
+    }
+}
+
+static void test_critical_escalates_through_warning_cooldown(void) {
+    AlarmRules rules;
+    AlertThresholds thresholds;
+    AlarmEvent alarm;
+
+    TEST_ASSERT_TRUE(rules.check(reading(72, 93), thresholds, 10000, alarm));
+    TEST_ASSERT_EQUAL_INT((int)AlertLevel::WARNING, (int)alarm.level);
+
+    // Another warning waits out the cooldown, a critical reading does not
+    TEST_ASSERT_FALSE(rules.check(reading(72, 92), thresholds, 11000, alarm));
+    TEST_ASSERT_TRUE(rules.check(reading(72, 85), thresholds, 12000, alarm));
+    TEST_ASSERT_EQUAL_INT((int)AlertLevel::CRITICAL, (int)alarm.level);
+
+    // Which starts a cooldown of its own
+    TEST_ASSERT_FALSE(rules.check(reading(72, 84), thresholds, 13000, alarm));
+    TEST_ASSERT_TRUE(rules.check(reading(72, 84), thresholds, 12000 + AlarmRules::COOLDOWN_MS, alarm));
+}
+
+static void test_boot_cooldown_holds_critical_alarms(void) {
+    AlarmRules rules;
+    AlertThresholds thresholds;
+    AlarmEvent alarm;
+    TEST_ASSERT_FALSE(rules.check(reading(72, 85), thresholds, AlarmRules::COOLDOWN_MS - 1, alarm));
+    TEST_ASSERT_TRUE(rules.check(reading(72, 85), thresholds, AlarmRules::COOLDOWN_MS, alarm));
+}
+
+static void test_most_severe_kind_wins(void) {
+    AlarmRules rules;
+    AlertThresholds thresholds;
+    AlarmEvent alarm;
+
+    // A heart rate warning does not hide a critical saturation
+    TEST_ASSERT_TRUE(rules.check(reading(110, 85), thresholds, 10000, alarm));
+    TEST_ASSERT_EQUAL_INT((int)AlarmKind::SPO2, (int)alarm.kind);
+    TEST_ASSERT_EQUAL_INT((int)AlertLevel::CRITICAL, (int)alarm.level);
+
+    // On a tie heart rate comes first
+    rules.reset();
+    TEST_ASSERT_TRUE(rules.check(reading(130, 85), thresholds, 10000, alarm));
+    TEST_ASSERT_EQUAL_INT((int)AlarmKind::HEART_RATE, (int)alarm.kind);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_desaturation_alarms_in_time_at_every_window_phase);
+    RUN_TEST(test_critical_escalates_through_warning_cooldown);
+    RUN_TEST(test_boot_cooldown_holds_critical_alarms);
+    RUN_TEST(test_most_severe_kind_wins);
+    return UNITY_END();
+}
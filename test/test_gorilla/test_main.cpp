@@ -0,0 +1,161 @@
+/*
+ * The vitals store's Gorilla codecs at their edges: delta-of-delta changes
+ * on both ends of each bucket and just past them, the 64-bit fallback, and
+ * floats whose XOR fills all 32 bits, NaNs and negative zero. Every value
+ * must come back bit for bit, in the number of bits gorilla.h gives.
+ *
+ *   pio test -e native -f test_gorilla
+ */
+
+#include <unity.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "store/gorilla.h"
+
+static uint32_t bitsOf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float floatOf(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Encodes the timestamps, checks they decode unchanged; returns the bits taken
+static size_t roundTripTimestamps(const std::vector<int64_t>& values) {
+    BitWriter writer;
+    TimestampEncoder encoder;
+    for (int64_t value : values) encoder.add(writer, value);
+    std::vector<uint8_t> bytes;
+    writer.copyTo(bytes);
+
+    BitReader reader(bytes.data(), bytes.size());
+    TimestampDecoder decoder;
+    for (size_t i = 0; i < values.size(); i++) {
+        TEST_ASSERT_EQUAL_INT64(values[i], decoder.next(reader));
+    }
+    return writer.bitCount();
+}
+
+// Bits taken by a third timestamp whose delta differs from the second's by `change`
+static size_t bitsForChange(int64_t change) {
+    const int64_t start = 1700000000000LL;
+    const int64_t delta = 1000;
+    std::vector<int64_t> values = {start, start + delta, start + 2 * delta + change};
+    return roundTripTimestamps(values) - roundTripTimestamps({start, start + delta});
+}
+
+// Encodes the floats, checks they decode to the same bits; returns the bits taken
+static size_t roundTripFloats(const std::vector<uint32_t>& bits) {
+    BitWriter writer;
+    FloatEncoder encoder;
+    for (uint32_t value : bits) encoder.add(writer, floatOf(value));
+    std::vector<uint8_t> bytes;
+    writer.copyTo(bytes);
+
+    BitReader reader(bytes.data(), bytes.size());
+    FloatDecoder decoder;
+    for (size_t i = 0; i < bits.size(); i++) {
+        TEST_ASSERT_EQUAL_HEX32(bits[i], bitsOf(decoder.next(reader)));
+    }
+    return writer.bitCount();
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ==================== TIMESTAMPS ====================
+static void test_unchanged_delta_takes_a_bit(void) {
+    TEST_ASSERT_EQUAL_INT(1, bitsForChange(0));
+}
+
+static void test_seven_bit_bucket_edges(void) {
+    TEST_ASSERT_EQUAL_INT(2 + 7, bitsForChange(-63));
+    TEST_ASSERT_EQUAL_INT(2 + 7, bitsForChange(64));
+    TEST_ASSERT_EQUAL_INT(2 + 7, bitsForChange(1));
+    TEST_ASSERT_EQUAL_INT(2 + 7, bitsForChange(-1));
+}
+
+static void test_nine_bit_bucket_edges(void) {
+    TEST_ASSERT_EQUAL_INT(3 + 9, bitsForChange(-64));
+    TEST_ASSERT_EQUAL_INT(3 + 9, bitsForChange(65));
+    TEST_ASSERT_EQUAL_INT(3 + 9, bitsForChange(-255));
+    TEST_ASSERT_EQUAL_INT(3 + 9, bitsForChange(256));
+}
+
+static void test_twelve_bit_bucket_edges(void) {
+    TEST_ASSERT_EQUAL_INT(4 + 12, bitsForChange(-256));
+    TEST_ASSERT_EQUAL_INT(4 + 12, bitsForChange(257));
+    TEST_ASSERT_EQUAL_INT(4 + 12, bitsForChange(-2047));
+    TEST_ASSERT_EQUAL_INT(4 + 12, bitsForChange(2048));
+}
+
+static void test_sixty_four_bit_fallback(void) {
+    TEST_ASSERT_EQUAL_INT(4 + 64, bitsForChange(-2048));
+    TEST_ASSERT_EQUAL_INT(4 + 64, bitsForChange(2049));
+    // An hour's gap, a clock stepped back, and the extremes of the field
+    TEST_ASSERT_EQUAL_INT(4 + 64, bitsForChange(3600000));
+    TEST_ASSERT_EQUAL_INT(4 + 64, bitsForChange(-1700000000000LL));
+    roundTripTimestamps({0, INT64_MAX / 2, 0, INT64_MIN / 2, -1, 1});
+}
+
+static void test_first_timestamp_is_whole(void) {
+    TEST_ASSERT_EQUAL_INT(64, roundTripTimestamps({INT64_MIN}));
+    TEST_ASSERT_EQUAL_INT(64, roundTripTimestamps({-1}));
+    // Then a delta of 1 against the 0 before it, then an unchanged one
+    TEST_ASSERT_EQUAL_INT(64 + 9 + 1, roundTripTimestamps({INT64_MAX - 2, INT64_MAX - 1, INT64_MAX}));
+}
+
+// ==================== FLOATS ====================
+static void test_xor_of_thirty_two_bits(void) {
+    // Sign and lowest mantissa bit differ: no leading zeros, length 32
+    size_t bits = roundTripFloats({0x3F800000, 0xBF800001});
+    TEST_ASSERT_EQUAL_INT(32 + 2 + 5 + 5 + 32, bits);
+    // And again inside that window: '10' and all 32 bits
+    bits = roundTripFloats({0x3F800000, 0xBF800001, 0x3F800000});
+    TEST_ASSERT_EQUAL_INT(32 + 44 + 2 + 32, bits);
+}
+
+static void test_nan_round_trips_bit_for_bit(void) {
+    const uint32_t quiet = bitsOf(NAN);
+    const uint32_t payload = 0x7FC00123;
+    const uint32_t signalling = 0x7F800001;
+    const uint32_t negative = 0xFFC00000;
+    roundTripFloats({quiet, quiet, payload, signalling, negative, bitsOf(72.0f), quiet});
+    TEST_ASSERT_EQUAL_INT(32 + 1, roundTripFloats({quiet, quiet}));
+}
+
+static void test_negative_zero_is_kept(void) {
+    const uint32_t zero = 0x00000000;
+    const uint32_t negativeZero = 0x80000000;
+    // Only the sign bit differs: no leading zeros, a window of one bit
+    TEST_ASSERT_EQUAL_INT(32 + 2 + 5 + 5 + 1, roundTripFloats({zero, negativeZero}));
+    roundTripFloats({negativeZero, zero, negativeZero, bitsOf(-1.0f), negativeZero});
+}
+
+static void test_window_reuse_and_new_window(void) {
+    // 97.0 -> 96.0 -> 97.0 reuses the window; a far value opens a new one
+    roundTripFloats({bitsOf(97.0f), bitsOf(96.0f), bitsOf(97.0f), bitsOf(1e-30f), bitsOf(97.0f)});
+    // The smallest change at the bottom: 31 leading zeros, length 1
+    TEST_ASSERT_EQUAL_INT(32 + 2 + 5 + 5 + 1, roundTripFloats({0x00000000, 0x00000001}));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_unchanged_delta_takes_a_bit);
+    RUN_TEST(test_seven_bit_bucket_edges);
+    RUN_TEST(test_nine_bit_bucket_edges);
+    RUN_TEST(test_twelve_bit_bucket_edges);
+    RUN_TEST(test_sixty_four_bit_fallback);
+    RUN_TEST(test_first_timestamp_is_whole);
+    RUN_TEST(test_xor_of_thirty_two_bits);
+    RUN_TEST(test_nan_round_trips_bit_for_bit);
+    RUN_TEST(test_negative_zero_is_kept);
+    RUN_TEST(test_window_reuse_and_new_window);
+    return UNITY_END();
+}
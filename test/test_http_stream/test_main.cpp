@@ -0,0 +1,133 @@
+/*
+ * Range header parsing against RFC 7233: what is served whole, what is a
+ * partial response and what is refused. Then the conditional and encoding
+ * headers the dashboard assets are served by, and their table.
+ *
+ *   pio test -e native -f test_http_stream
+ */
+
+#include <unity.h>
+#include "http_stream.h"
+
+static ByteRange range;
+
+static RangeResult parse(const char* header, size_t totalSize) {
+    range.start = range.end = 12345;
+    return parseRangeHeader(header, totalSize, range);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_satisfiable_ranges(void) {
+    TEST_ASSERT_EQUAL_INT(RANGE_SATISFIABLE, parse("bytes=0-99", 1000));
+    TEST_ASSERT_EQUAL_INT(0, range.start);
+    TEST_ASSERT_EQUAL_INT(99, range.end);
+
+    TEST_ASSERT_EQUAL_INT(RANGE_SATISFIABLE, parse("bytes=500-", 1000));
+    TEST_ASSERT_EQUAL_INT(500, range.start);
+    TEST_ASSERT_EQUAL_INT(999, range.end);
+
+    // A last byte past the end is clipped to it
+    TEST_ASSERT_EQUAL_INT(RANGE_SATISFIABLE, parse("bytes=900-5000", 1000));
+    TEST_ASSERT_EQUAL_INT(999, range.end);
+
+    TEST_ASSERT_EQUAL_INT(RANGE_SATISFIABLE, parse("bytes=-100", 1000));
+    TEST_ASSERT_EQUAL_INT(900, range.start);
+    TEST_ASSERT_EQUAL_INT(999, range.end);
+
+    TEST_ASSERT_EQUAL_INT(RANGE_SATISFIABLE, parse("bytes=-5000", 1000));
+    TEST_ASSERT_EQUAL_INT(0, range.start);
+}
+
+static void test_invalid_ranges_are_ignored(void) {
+    TEST_ASSERT_EQUAL_INT(RANGE_IGNORED, parse("bytes=5-3", 1000));
+    TEST_ASSERT_EQUAL_INT(RANGE_IGNORED, parse("bytes=abc", 1000));
+    TEST_ASSERT_EQUAL_INT(RANGE_IGNORED, parse("bytes=-", 1000));
+    TEST_ASSERT_EQUAL_INT(RANGE_IGNORED, parse("bytes=1-2x", 1000));
+    TEST_ASSERT_EQUAL_INT(RANGE_IGNORED, parse("bytes=--5", 1000));
+    TEST_ASSERT_EQUAL_INT(RANGE_IGNORED, parse("items=0-10", 1000));
+    TEST_ASSERT_EQUAL_INT(RANGE_IGNORED, parse("bytes=0-1,5-6", 1000));
+    TEST_ASSERT_EQUAL_INT(RANGE_IGNORED, parse(nullptr, 1000));
+
+    // An ignored range is not even invalid past the end
+    TEST_ASSERT_EQUAL_INT(RANGE_IGNORED, parse("bytes=5000-3", 1000));
+}
+
+static void test_unsatisfiable_ranges_are_refused(void) {
+    TEST_ASSERT_EQUAL_INT(RANGE_UNSATISFIABLE, parse("bytes=1000-", 1000));
+    TEST_ASSERT_EQUAL_INT(RANGE_UNSATISFIABLE, parse("bytes=2000-3000", 1000));
+    TEST_ASSERT_EQUAL_INT(RANGE_UNSATISFIABLE, parse("bytes=-0", 1000));
+    TEST_ASSERT_EQUAL_INT(RANGE_UNSATISFIABLE, parse("bytes=0-", 0));
+    TEST_ASSERT_EQUAL_INT(RANGE_UNSATISFIABLE, parse("bytes=-10", 0));
+}
+
+static void test_etag_lists_and_wildcard(void) {
+    const char* etag = "\"058e176abef0\"";
+    TEST_ASSERT_TRUE(etagMatches("\"058e176abef0\"", etag));
+    TEST_ASSERT_TRUE(etagMatches("\"aaa\", \"058e176abef0\"", etag));
+    TEST_ASSERT_TRUE(etagMatches("\"aaa\",\"058e176abef0\",\"bbb\"", etag));
+    TEST_ASSERT_TRUE(etagMatches("*", etag));
+    TEST_ASSERT_FALSE(etagMatches("\"aaa\", \"bbb\"", etag));
+    TEST_ASSERT_FALSE(etagMatches("\"058e176abef\"", etag));
+    TEST_ASSERT_FALSE(etagMatches("058e176abef0", etag));
+    TEST_ASSERT_FALSE(etagMatches("", etag));
+    TEST_ASSERT_FALSE(etagMatches(nullptr, etag));
+
+    // A comma inside a tag does not split it
+    TEST_ASSERT_TRUE(etagMatches("\"a,b\"", "\"a,b\""));
+    TEST_ASSERT_FALSE(etagMatches("\"a,b\"", "\"a\""));
+}
+
+static void test_etag_weak_comparison(void) {
+    const char* etag = "\"058e176abef0\"";
+    TEST_ASSERT_TRUE(etagMatches("W/\"058e176abef0\"", etag));
+    TEST_ASSERT_TRUE(etagMatches("\"x\", W/\"058e176abef0\"", etag));
+    TEST_ASSERT_TRUE(etagMatches("\"058e176abef0\"", "W/\"058e176abef0\""));
+    TEST_ASSERT_FALSE(etagMatches("W/\"other\"", etag));
+}
+
+static void test_accept_encoding(void) {
+    TEST_ASSERT_TRUE(acceptsGzip("gzip"));
+    TEST_ASSERT_TRUE(acceptsGzip("gzip, deflate, br"));
+    TEST_ASSERT_TRUE(acceptsGzip("br;q=1.0, GZIP;q=0.5"));
+    TEST_ASSERT_TRUE(acceptsGzip("*"));
+    TEST_ASSERT_TRUE(acceptsGzip("identity, *;q=0.1"));
+    TEST_ASSERT_FALSE(acceptsGzip("identity"));
+    TEST_ASSERT_FALSE(acceptsGzip("deflate, br"));
+    TEST_ASSERT_FALSE(acceptsGzip("gzip;q=0"));
+    TEST_ASSERT_FALSE(acceptsGzip("gzip;q=0.0, *"));
+    TEST_ASSERT_FALSE(acceptsGzip("*;q=0"));
+    TEST_ASSERT_FALSE(acceptsGzip("x-gzip"));
+    TEST_ASSERT_FALSE(acceptsGzip(""));
+    TEST_ASSERT_FALSE(acceptsGzip(nullptr));
+}
+
+static void test_asset_table_lines(void) {
+    StaticAsset asset;
+    TEST_ASSERT_TRUE(parseAssetLine("/app.058e176abef0.js \"058e176abef0\" 1", asset));
+    TEST_ASSERT_EQUAL_STRING("/app.058e176abef0.js", asset.url);
+    TEST_ASSERT_EQUAL_STRING("\"058e176abef0\"", asset.etag);
+    TEST_ASSERT_TRUE(asset.immutable);
+    TEST_ASSERT_TRUE(parseAssetLine("/index.html \"1a4584bc682d\" 0\r", asset));
+    TEST_ASSERT_FALSE(asset.immutable);
+    TEST_ASSERT_FALSE(parseAssetLine("/index.html", asset));
+    TEST_ASSERT_FALSE(parseAssetLine("", asset));
+
+    TEST_ASSERT_EQUAL_STRING("text/html", assetContentType("/index.html"));
+    TEST_ASSERT_EQUAL_STRING("application/javascript", assetContentType("/app.058e176abef0.js"));
+    TEST_ASSERT_EQUAL_STRING("text/css", assetContentType("/styles.bec4e50dccd1.css"));
+    TEST_ASSERT_EQUAL_STRING("application/octet-stream", assetContentType("/favicon"));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_satisfiable_ranges);
+    RUN_TEST(test_invalid_ranges_are_ignored);
+    RUN_TEST(test_unsatisfiable_ranges_are_refused);
+    RUN_TEST(test_etag_lists_and_wildcard);
+    RUN_TEST(test_etag_weak_comparison);
+    RUN_TEST(test_accept_encoding);
+    RUN_TEST(test_asset_table_lines);
+    return UNITY_END();
+}
@@ -0,0 +1,207 @@
+/*
+ * The input journal end to end: the sketch runs on the simulated board
+ * with `journal on`, a serial command and a web request, and then setup()
+ * and loop() run again on the journal alone in an empty file system. The
+ * replay must take every record without diverging, run as many loops and
+ * leave the same screen. Each run needs the firmware fresh from boot, so
+ * both run in child processes and report through files.
+ *
+ *   pio test -e native -f test_journal
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "journal.h"
+#include "hal_sim.h"
+#include <WebServer.h>
+
+// The sketch, compiled in by native/sketch.cpp
+void setup();
+void loop();
+extern WebServer server;
+
+static const char* RECORD_ROOT = ".native_fs_test_journal";
+static const char* REPLAY_ROOT = ".native_fs_test_journal_replay";
+static const uint32_t RECORD_MS = 120000;
+
+struct RunReport {
+    unsigned loops;
+    unsigned bytes;
+    int diverged;
+};
+
+static std::string inRoot(const char* root, const char* name) {
+    return std::string(root) + "/" + name;
+}
+
+static bool readFile(const std::string& path, std::vector<uint8_t>& data) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    uint8_t block[4096];
+    size_t length;
+    while ((length = fread(block, 1, sizeof(block), f)) > 0) data.insert(data.end(), block, block + length);
+    fclose(f);
+    return true;
+}
+
+static void writeReport(const char* root, const RunReport& report) {
+    FILE* f = fopen(inRoot(root, "report.txt").c_str(), "w");
+    if (!f) return;
+    fprintf(f, "%u %u %d\n", report.loops, report.bytes, report.diverged);
+    fclose(f);
+}
+
+static bool readReport(const char* root, RunReport& report) {
+    FILE* f = fopen(inRoot(root, "report.txt").c_str(), "r");
+    if (!f) return false;
+    bool read = fscanf(f, "%u %u %d", &report.loops, &report.bytes, &report.diverged) == 3;
+    fclose(f);
+    return read;
+}
+
+// Runs `body` in a child process; true if it exited with status 0
+template <typename Body>
+static bool inChild(Body body) {
+    fflush(stdout);
+    pid_t child = fork();
+    if (child == 0) {
+        _exit(body());
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// ==================== RECORDING ====================
+// As `program --journal --wifi ward:secret` with a command and a request
+static int record() {
+    simStorage.setRoot(RECORD_ROOT);
+    simStorage.wipe();
+    simNetwork.setAccessPoint("ward", "secret");
+    Preferences settings;
+    settings.begin("cardiac", false);
+    settings.putString("wifi_ssid", "ward");
+    settings.putString("wifi_pass", "secret");
+    settings.end();
+    settings.begin("journal", false);
+    settings.putBool("enabled", true);
+    settings.end();
+
+    bool requested = false;
+    server.setRequestSource([&requested](std::string& target, std::string& headers) {
+        if (requested || simClock.millis() < RECORD_MS / 2) return false;
+        requested = true;
+        target = "/api/status";
+        headers.clear();
+        return true;
+    });
+    server.setResponseSink([](const std::string&, int, const std::string&) {});
+
+    setup();
+    bool commanded = false;
+    while (simClock.millis() < RECORD_MS) {
+        simTick();
+        if (!commanded && simClock.millis() >= RECORD_MS / 4) {
+            Serial.inject("info\n");
+            commanded = true;
+        }
+        loop();
+    }
+    if (!journal.save()) return 1;
+
+    RunReport report = {journal.getLoops(), (unsigned)journal.getBytes(), 0};
+    writeReport(RECORD_ROOT, report);
+    return simDisplay.savePpm(inRoot(RECORD_ROOT, "screen.ppm").c_str()) && requested ? 0 : 1;
+}
+
+// ==================== REPLAY ====================
+static std::vector<uint8_t> replayed;
+
+static void finishReplay() {
+    RunReport report = {journal.getLoops(), (unsigned)journal.getBytes(), journal.hasDiverged() ? 1 : 0};
+    writeReport(REPLAY_ROOT, report);
+    if (journal.hasDiverged()) printf("%s\n", journal.getDivergence());
+    bool saved = simDisplay.savePpm(inRoot(REPLAY_ROOT, "screen.ppm").c_str());
+    fflush(stdout);
+    _exit(saved ? 0 : 1);
+}
+
+// As `program --replay journal.bin`, in a file system of its own
+static int replay() {
+    if (!readFile(inRoot(RECORD_ROOT, JOURNAL_PATH + 1), replayed)) return 1;
+    simStorage.setRoot(REPLAY_ROOT);
+    simStorage.wipe();
+    // Replay never begins the board's storage, which would create it
+    mkdir(REPLAY_ROOT, 0755);
+    if (!journal.replay(replayed.data(), replayed.size(), finishReplay)) return 1;
+
+    String target;
+    server.setRequestSource([&target](std::string& next, std::string& headers) {
+        if (!journal.nextRequest(target)) return false;
+        next = target.c_str();
+        headers.clear();
+        return true;
+    });
+    server.setResponseSink([](const std::string&, int, const std::string&) {});
+
+    setup();
+    while (journal.hasMore()) loop();
+    finishReplay();
+    return 1;
+}
+
+// ==================== TESTS ====================
+static RunReport recorded;
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_recording_is_written(void) {
+    TEST_ASSERT_TRUE(inChild(record));
+    TEST_ASSERT_TRUE(readReport(RECORD_ROOT, recorded));
+
+    std::vector<uint8_t> journalFile;
+    TEST_ASSERT_TRUE(readFile(inRoot(RECORD_ROOT, JOURNAL_PATH + 1), journalFile));
+    TEST_ASSERT_EQUAL_INT(recorded.bytes, journalFile.size());
+    TEST_ASSERT_EQUAL_MEMORY("JRN1", journalFile.data(), 4);
+    TEST_ASSERT_TRUE(recorded.loops > 1000);
+}
+
+void test_replay_matches_recording(void) {
+    TEST_ASSERT_TRUE(inChild(replay));
+    RunReport report;
+    TEST_ASSERT_TRUE(readReport(REPLAY_ROOT, report));
+    TEST_ASSERT_EQUAL_INT(0, report.diverged);
+    TEST_ASSERT_EQUAL_INT(recorded.bytes, report.bytes);
+    TEST_ASSERT_EQUAL_INT(recorded.loops, report.loops);
+
+    std::vector<uint8_t> recordedScreen, replayedScreen;
+    TEST_ASSERT_TRUE(readFile(inRoot(RECORD_ROOT, "screen.ppm"), recordedScreen));
+    TEST_ASSERT_TRUE(readFile(inRoot(REPLAY_ROOT, "screen.ppm"), replayedScreen));
+    TEST_ASSERT_EQUAL_INT(recordedScreen.size(), replayedScreen.size());
+    TEST_ASSERT_TRUE(recordedScreen == replayedScreen);
+}
+
+void test_device_limit_holds_the_stated_minutes(void) {
+    // journal.h promises about 14 minutes after boot on the ESP32
+    double bytesPerSecond = recorded.bytes / (RECORD_MS / 1000.0);
+    double minutes = JOURNAL_DEVICE_FILE_LIMIT / bytesPerSecond / 60;
+    printf("journal: %.0f bytes/s, %.1f minutes in %u bytes\n", bytesPerSecond, minutes, JOURNAL_DEVICE_FILE_LIMIT);
+    TEST_ASSERT_TRUE(minutes >= 12);
+}
+
+int main(int argc, char** argv) {
+    // The firmware's serial output would bury the results
+    Serial.setMuted(true);
+    UNITY_BEGIN();
+    RUN_TEST(test_recording_is_written);
+    RUN_TEST(test_replay_matches_recording);
+    RUN_TEST(test_device_limit_holds_the_stated_minutes);
+    return UNITY_END();
+}
@@ -0,0 +1,94 @@
+/*
+ * The schema serializer's edge cases: integer limits, float trimming and a
+ * document that does not fit its buffer.
+ *
+ *   pio test -e native -f test_json_schema
+ */
+
+#include <unity.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include "json_schema.h"
+
+static size_t writeInt(int64_t v, char* buffer, size_t size) {
+    JsonBufferSink sink(buffer, size);
+    JsonWriter<JsonBufferSink> writer(sink);
+    writer.value(v);
+    sink.finish();
+    return sink.getLength();
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_int64_limits(void) {
+    char buffer[32];
+    TEST_ASSERT_EQUAL_INT(20, writeInt(INT64_MIN, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_STRING("-9223372036854775808", buffer);
+    writeInt(INT64_MAX, buffer, sizeof(buffer));
+    TEST_ASSERT_EQUAL_STRING("9223372036854775807", buffer);
+    writeInt(-1, buffer, sizeof(buffer));
+    TEST_ASSERT_EQUAL_STRING("-1", buffer);
+    writeInt(0, buffer, sizeof(buffer));
+    TEST_ASSERT_EQUAL_STRING("0", buffer);
+}
+
+static void test_narrow_signed_minimum(void) {
+    char buffer[32];
+    JsonBufferSink sink(buffer, sizeof(buffer));
+    JsonWriter<JsonBufferSink> writer(sink);
+    writer.beginArray();
+    writer.value((int8_t)INT8_MIN);
+    writer.value((int32_t)INT32_MIN);
+    writer.endArray();
+    sink.finish();
+    TEST_ASSERT_FALSE(sink.overflowed());
+    TEST_ASSERT_EQUAL_STRING("[-128,-2147483648]", buffer);
+}
+
+static void test_floats_are_trimmed(void) {
+    char buffer[32];
+    JsonBufferSink sink(buffer, sizeof(buffer));
+    JsonWriter<JsonBufferSink> writer(sink);
+    writer.beginArray();
+    writer.value(72.5f);
+    writer.value(98.0);
+    writer.value(-0.004);
+    writer.endArray();
+    sink.finish();
+    TEST_ASSERT_EQUAL_STRING("[72.5,98,0]", buffer);
+}
+
+static void test_truncated_document_is_terminated(void) {
+    char buffer[8];
+    memset(buffer, 'x', sizeof(buffer));
+    size_t length = writeInt(INT64_MIN, buffer, sizeof(buffer));
+
+    // The full length is reported; what fit is terminated in the last byte
+    TEST_ASSERT_EQUAL_INT(20, length);
+    TEST_ASSERT_EQUAL_STRING("-922337", buffer);
+}
+
+static void test_terminator_written_once_at_the_end(void) {
+    char buffer[16];
+    memset(buffer, 'x', sizeof(buffer));
+    JsonBufferSink sink(buffer, sizeof(buffer));
+    sink.write("abc", 3);
+
+    // Nothing past the content until finish()
+    TEST_ASSERT_EQUAL_INT('x', buffer[3]);
+    sink.finish();
+    TEST_ASSERT_EQUAL_STRING("abc", buffer);
+    TEST_ASSERT_EQUAL_INT('x', buffer[4]);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_int64_limits);
+    RUN_TEST(test_narrow_signed_minimum);
+    RUN_TEST(test_floats_are_trimmed);
+    RUN_TEST(test_truncated_document_is_terminated);
+    RUN_TEST(test_terminator_written_once_at_the_end);
+    return UNITY_END();
+}
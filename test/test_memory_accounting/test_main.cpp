@@ -0,0 +1,163 @@
+/*
+ * Memory accounts: charge, credit and peak, containers through
+ * AccountedAllocator, going over budget, charging from several threads,
+ * and the text and JSON reports.
+ *
+ *   pio test -e native -f test_memory_accounting
+ */
+
+#include <unity.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "memory_accounting.h"
+
+// Accounts enter a fixed table when constructed, so the test's are static
+static MemoryAccount testAccount("test", 1024);
+static MemoryAccount testSmall("test_small", 64);
+static MemoryAccount testThreads("test_threads", 1 << 20);
+
+static std::string render(MemoryReportGenerator& generator) {
+    std::string body;
+    uint8_t buffer[100];
+    size_t n;
+    while ((n = generator.fill(buffer, sizeof(buffer))) > 0) {
+        body.append((const char*)buffer, n);
+    }
+    return body;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static void test_charge_credit_and_peak(void) {
+    size_t before = testAccount.getCurrent();
+    uint32_t allocations = testAccount.getAllocations();
+
+    testAccount.charge(300);
+    testAccount.charge(200);
+    testAccount.credit(300);
+    TEST_ASSERT_EQUAL_UINT32(before + 200, testAccount.getCurrent());
+    TEST_ASSERT_GREATER_OR_EQUAL(before + 500, testAccount.getPeak());
+    TEST_ASSERT_EQUAL_UINT32(allocations + 2, testAccount.getAllocations());
+
+    testAccount.credit(200);
+    TEST_ASSERT_EQUAL_UINT32(before, testAccount.getCurrent());
+    TEST_ASSERT_FALSE(testAccount.isOverBudget());
+}
+
+static void test_allocator_follows_the_container(void) {
+    size_t before = testAccount.getCurrent();
+    {
+        std::vector<uint32_t, AccountedAllocator<uint32_t>> values{AccountedAllocator<uint32_t>(testAccount)};
+        values.reserve(16);
+        TEST_ASSERT_EQUAL_UINT32(before + 16 * sizeof(uint32_t), testAccount.getCurrent());
+
+        // Growth charges the new block and credits the old one
+        for (uint32_t i = 0; i < 40; i++) values.push_back(i);
+        TEST_ASSERT_EQUAL_UINT32(before + values.capacity() * sizeof(uint32_t), testAccount.getCurrent());
+
+        values.clear();
+        values.shrink_to_fit();
+        TEST_ASSERT_EQUAL_UINT32(before, testAccount.getCurrent());
+    }
+    TEST_ASSERT_EQUAL_UINT32(before, testAccount.getCurrent());
+    TEST_ASSERT_EQUAL_UINT32(0, testAccount.getFailures());
+}
+
+static void test_over_budget_still_allocates(void) {
+    std::vector<uint8_t, AccountedAllocator<uint8_t>> bytes{AccountedAllocator<uint8_t>(testSmall)};
+    bytes.resize(100);
+    TEST_ASSERT_EQUAL_UINT8(0, bytes[99]);
+    TEST_ASSERT_TRUE(testSmall.isOverBudget());
+    TEST_ASSERT_EQUAL_UINT32(100, testSmall.getPeak());
+
+    // The peak stays over budget after the memory is given back
+    bytes.clear();
+    bytes.shrink_to_fit();
+    TEST_ASSERT_EQUAL_UINT32(0, testSmall.getCurrent());
+    TEST_ASSERT_TRUE(testSmall.isOverBudget());
+}
+
+static void test_charges_from_several_threads(void) {
+    const int THREADS = 4;
+    const int ROUNDS = 20000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([]() {
+            for (int i = 0; i < ROUNDS; i++) {
+                testThreads.charge(8);
+                testThreads.credit(8);
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, testThreads.getCurrent());
+    TEST_ASSERT_EQUAL_UINT32(THREADS * ROUNDS, testThreads.getAllocations());
+    TEST_ASSERT_LESS_OR_EQUAL(THREADS * 8, testThreads.getPeak());
+    TEST_ASSERT_GREATER_OR_EQUAL(8, testThreads.getPeak());
+}
+
+static void test_tracked_task_charges_its_stack(void) {
+    size_t before = memoryTaskStacks.getCurrent();
+    int tasks = memoryTaskCount();
+    memoryTrackTask("test_task", nullptr, 2048);
+    memoryTrackTask("test_loop", nullptr, 8192, false);
+
+    TEST_ASSERT_EQUAL_INT(tasks + 2, memoryTaskCount());
+    TEST_ASSERT_EQUAL_STRING("test_task", memoryTask(tasks).name);
+    TEST_ASSERT_EQUAL_UINT32(before + 2048, memoryTaskStacks.getCurrent());
+    // No high-water mark for host threads
+    TEST_ASSERT_EQUAL_INT(-1, memoryStackHighWater(memoryTask(tasks)));
+}
+
+static void test_json_report(void) {
+    testAccount.charge(100);
+    MemoryReportGenerator generator(MemoryReportGenerator::JSON, "9.9.9", true);
+    std::string body = render(generator);
+    testAccount.credit(100);
+
+    TEST_ASSERT_EQUAL_INT(0, body.find("{\"wifiConnected\":true,"));
+    TEST_ASSERT_TRUE(body.find("\"version\":\"9.9.9\"") != std::string::npos);
+    TEST_ASSERT_TRUE(body.find("{\"name\":\"test\",\"bytes\":100,") != std::string::npos);
+    TEST_ASSERT_TRUE(body.find("\"name\":\"test_small\"") != std::string::npos);
+    TEST_ASSERT_TRUE(body.find("{\"name\":\"test_task\",\"stack\":2048,\"minFree\":null}") != std::string::npos);
+    TEST_ASSERT_EQUAL_STRING("]}", body.substr(body.size() - 2).c_str());
+
+    // Every account is listed once, in construction order
+    size_t vitals = body.find("\"name\":\"vitals\"");
+    size_t test = body.find("\"name\":\"test\"");
+    TEST_ASSERT_TRUE(vitals != std::string::npos);
+    TEST_ASSERT_TRUE(body.find("\"name\":\"vitals\"", vitals + 1) == std::string::npos);
+    TEST_ASSERT_TRUE(test != std::string::npos);
+}
+
+static void test_text_report_flags_over_budget(void) {
+    MemoryReportGenerator generator(MemoryReportGenerator::TEXT);
+    std::string body = render(generator);
+
+    TEST_ASSERT_EQUAL_INT(0, body.find("Heap: "));
+    size_t row = body.find("\ntest_small ");
+    TEST_ASSERT_TRUE(row != std::string::npos);
+    size_t end = body.find('\n', row + 1);
+    TEST_ASSERT_TRUE(body.substr(row, end - row).find(" OVER") != std::string::npos);
+
+    row = body.find("\ntest ");
+    end = body.find('\n', row + 1);
+    TEST_ASSERT_TRUE(body.substr(row, end - row).find(" OVER") == std::string::npos);
+    TEST_ASSERT_TRUE(body.find("\ntest_task ") != std::string::npos);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_charge_credit_and_peak);
+    RUN_TEST(test_allocator_follows_the_container);
+    RUN_TEST(test_over_budget_still_allocates);
+    RUN_TEST(test_charges_from_several_threads);
+    RUN_TEST(test_tracked_task_charges_its_stack);
+    RUN_TEST(test_json_report);
+    RUN_TEST(test_text_report_flags_over_budget);
+    return UNITY_END();
+}
@@ -0,0 +1,154 @@
+/*
+ * The vitals log across a power cut: a torn final record is trimmed on
+ * boot so later appends and reads stay record-aligned, including when the
+ * cut lands in the middle of the trim itself.
+ *
+ *   pio test -e native -f test_vitals_log
+ */
+
+#include <unity.h>
+#include "vitals_log.h"
+#include "hal.h"
+#include "hal_sim.h"
+
+static const char* SEGMENT = "/logs/vitals.0.bin";
+static const char* TRIM_COPY = "/logs/vitals.0.tmp";
+
+static VitalSigns vitalsFor(uint32_t i) {
+    VitalSigns vitals;
+    vitals.heartRate = 60.0f + i % 40;
+    vitals.spO2 = 95.0f;
+    vitals.batteryLevel = 80;
+    vitals.isFingerDetected = true;
+    vitals.timestamp = 0;
+    return vitals;
+}
+
+static void appendRecords(VitalsLog& log, uint32_t count) {
+    uint32_t first = log.getNextSequence();
+    for (uint32_t i = 0; i < count; i++) {
+        log.append(vitalsFor(first + i));
+    }
+    log.flush();
+}
+
+static size_t fileSize(const char* path) {
+    int file = hal.storage->open(path, "r");
+    if (file == HAL_INVALID_FILE) return 0;
+    size_t size = hal.storage->size(file);
+    hal.storage->close(file);
+    return size;
+}
+
+static void appendGarbage(const char* path, size_t length) {
+    const uint8_t garbage[sizeof(VitalsRecord)] = {0xde, 0xad, 0xbe, 0xef, 0xde, 0xad, 0xbe, 0xef};
+    int file = hal.storage->open(path, "a");
+    hal.storage->write(file, garbage, length);
+    hal.storage->close(file);
+}
+
+static void assertAligned(VitalsLog& log, uint32_t expected) {
+    TEST_ASSERT_EQUAL_INT(0, log.getFirstSequence());
+    TEST_ASSERT_EQUAL_INT(expected, log.getNextSequence());
+    TEST_ASSERT_EQUAL_INT(expected * sizeof(VitalsRecord), fileSize(SEGMENT));
+
+    for (uint32_t sequence = 0; sequence < expected; sequence++) {
+        VitalsRecord record;
+        TEST_ASSERT_TRUE(log.read(sequence, record));
+        TEST_ASSERT_EQUAL_INT(sequence, record.sequence);
+        TEST_ASSERT_EQUAL_INT((uint16_t)((60 + sequence % 40) * 10), record.heartRate);
+    }
+}
+
+void setUp(void) {
+    simStorage.setRoot(".native_fs_test_vitals_log");
+    simStorage.wipe();
+    hal.storage->begin(true);
+}
+
+void tearDown(void) {
+    simStorage.wipe();
+}
+
+static void test_reopen_without_damage(void) {
+    VitalsLog* first = new VitalsLog();
+    first->begin();
+    appendRecords(*first, 40);
+    delete first;
+
+    VitalsLog* second = new VitalsLog();
+    second->begin();
+    appendRecords(*second, 24);
+    assertAligned(*second, 64);
+    delete second;
+}
+
+static void test_torn_record_is_trimmed_on_boot(void) {
+    VitalsLog* first = new VitalsLog();
+    first->begin();
+    appendRecords(*first, 40);
+    delete first;
+
+    // Power cut part way through the next record
+    appendGarbage(SEGMENT, 7);
+    TEST_ASSERT_EQUAL_INT(40 * sizeof(VitalsRecord) + 7, fileSize(SEGMENT));
+
+    VitalsLog* second = new VitalsLog();
+    second->begin();
+    TEST_ASSERT_EQUAL_INT(40 * sizeof(VitalsRecord), fileSize(SEGMENT));
+    TEST_ASSERT_FALSE(hal.storage->exists(TRIM_COPY));
+
+    appendRecords(*second, 30);
+    assertAligned(*second, 70);
+    delete second;
+
+    // And the next boot sees the same log
+    VitalsLog* third = new VitalsLog();
+    third->begin();
+    assertAligned(*third, 70);
+    delete third;
+}
+
+static void test_cut_after_trim_copy_is_recovered(void) {
+    VitalsLog* first = new VitalsLog();
+    first->begin();
+    appendRecords(*first, 40);
+    delete first;
+
+    // The trimmed copy was written and the torn segment removed, then power went
+    TEST_ASSERT_TRUE(hal.storage->rename(SEGMENT, TRIM_COPY));
+
+    VitalsLog* second = new VitalsLog();
+    second->begin();
+    TEST_ASSERT_FALSE(hal.storage->exists(TRIM_COPY));
+    appendRecords(*second, 8);
+    assertAligned(*second, 48);
+    delete second;
+}
+
+static void test_stale_trim_copy_is_replaced(void) {
+    VitalsLog* first = new VitalsLog();
+    first->begin();
+    appendRecords(*first, 40);
+    delete first;
+
+    // Cut during the copy: a short side file next to the still-torn segment
+    appendGarbage(SEGMENT, 9);
+    appendGarbage(TRIM_COPY, 5);
+
+    VitalsLog* second = new VitalsLog();
+    second->begin();
+    TEST_ASSERT_FALSE(hal.storage->exists(TRIM_COPY));
+    appendRecords(*second, 8);
+    assertAligned(*second, 48);
+    delete second;
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_reopen_without_damage);
+    RUN_TEST(test_torn_record_is_trimmed_on_boot);
+    RUN_TEST(test_cut_after_trim_copy_is_recovered);
+    RUN_TEST(test_stale_trim_copy_is_replaced);
+    return UNITY_END();
+}
@@ -0,0 +1,241 @@
+/*
+ * The WiFi state machine against a scripted driver: connect, drop and
+ * reconnect, exponential backoff, the captive portal fallback, and events
+ * that arrive faster than update() runs. Then the same machine on the
+ * simulated radio through an outage.
+ *
+ *   pio test -e native -f test_wifi_manager
+ */
+
+#include <unity.h>
+#include "wifi_manager.h"
+#include "hal_sim.h"
+
+// Records what the state machine asks of the radio; the test delivers the
+// outcomes through notifyConnected()/notifyDisconnected()
+class ScriptedWifiDriver : public WifiDriver {
+public:
+    int connects = 0;
+    int disconnects = 0;
+
+    void connect(const char* ssid, const char* password) override { connects++; }
+    void disconnect() override { disconnects++; }
+};
+
+static ScriptedWifiDriver driver;
+static WifiManager* manager;
+static int transitions;
+
+static void onStateChange(WifiState previous, WifiState current) {
+    transitions++;
+}
+
+static void start(const char* ssid) {
+    manager->begin(&driver, ssid, "secret", onStateChange, 0);
+}
+
+void setUp(void) {
+    driver = ScriptedWifiDriver();
+    manager = new WifiManager();
+    transitions = 0;
+}
+
+void tearDown(void) {
+    delete manager;
+}
+
+static void test_idle_without_credentials(void) {
+    start("");
+    manager->update(100000);
+    TEST_ASSERT_EQUAL_INT((int)WifiState::IDLE, (int)manager->getState());
+    TEST_ASSERT_EQUAL_INT(0, driver.connects);
+}
+
+static void test_connect(void) {
+    start("ward");
+    TEST_ASSERT_EQUAL_INT((int)WifiState::CONNECTING, (int)manager->getState());
+    TEST_ASSERT_EQUAL_INT(1, driver.connects);
+
+    manager->update(500);
+    TEST_ASSERT_EQUAL_INT((int)WifiState::CONNECTING, (int)manager->getState());
+
+    manager->notifyConnected();
+    manager->update(1500);
+    TEST_ASSERT_TRUE(manager->isConnected());
+    TEST_ASSERT_EQUAL_INT(0, manager->getFailures());
+}
+
+static void test_drop_reconnects_at_once(void) {
+    start("ward");
+    manager->notifyConnected();
+    manager->update(1000);
+
+    manager->notifyDisconnected();
+    manager->update(60000);
+    TEST_ASSERT_EQUAL_INT((int)WifiState::CONNECTING, (int)manager->getState());
+    TEST_ASSERT_EQUAL_INT(2, driver.connects);
+
+    manager->notifyConnected();
+    manager->update(61000);
+    TEST_ASSERT_TRUE(manager->isConnected());
+}
+
+static void test_backoff_doubles_up_to_the_cap(void) {
+    start("ward");
+    manager->notifyConnected();
+    manager->update(0);
+    manager->notifyDisconnected();
+    manager->update(0);
+
+    // Once connected, failures keep retrying and never open the portal
+    uint32_t now = 0;
+    uint32_t expected = WifiManager::BACKOFF_MIN;
+    for (int i = 0; i < 10; i++) {
+        now += WifiManager::CONNECT_TIMEOUT;
+        manager->update(now);
+        TEST_ASSERT_EQUAL_INT((int)WifiState::BACKOFF, (int)manager->getState());
+        TEST_ASSERT_EQUAL_UINT32(expected, manager->getBackoff());
+
+        // Not before the backoff has passed
+        manager->update(now + manager->getBackoff() - 1);
+        TEST_ASSERT_EQUAL_INT((int)WifiState::BACKOFF, (int)manager->getState());
+        now += manager->getBackoff();
+        manager->update(now);
+        TEST_ASSERT_EQUAL_INT((int)WifiState::CONNECTING, (int)manager->getState());
+
+        expected = expected * 2 > WifiManager::BACKOFF_MAX ? WifiManager::BACKOFF_MAX : expected * 2;
+    }
+    TEST_ASSERT_EQUAL_UINT32(WifiManager::BACKOFF_MAX, manager->getBackoff());
+
+    // A success resets the backoff
+    manager->notifyConnected();
+    manager->update(now);
+    manager->notifyDisconnected();
+    manager->update(now);
+    manager->notifyDisconnected();
+    manager->update(now);
+    TEST_ASSERT_EQUAL_UINT32(WifiManager::BACKOFF_MIN, manager->getBackoff());
+}
+
+static void test_portal_after_failures_from_boot(void) {
+    start("wrong");
+    uint32_t now = 0;
+    for (int i = 0; i < WifiManager::PORTAL_AFTER_FAILURES; i++) {
+        TEST_ASSERT_EQUAL_INT((int)WifiState::CONNECTING, (int)manager->getState());
+        manager->notifyDisconnected();
+        now += 100;
+        manager->update(now);
+        if (manager->getState() == WifiState::BACKOFF) {
+            now += manager->getBackoff();
+            manager->update(now);
+        }
+    }
+    TEST_ASSERT_EQUAL_INT((int)WifiState::PORTAL, (int)manager->getState());
+    TEST_ASSERT_EQUAL_INT(WifiManager::PORTAL_AFTER_FAILURES, driver.connects);
+    TEST_ASSERT_EQUAL_INT(WifiManager::PORTAL_AFTER_FAILURES, driver.disconnects);
+
+    // The portal stays up until the user leaves it
+    manager->update(now + 3600000);
+    TEST_ASSERT_EQUAL_INT((int)WifiState::PORTAL, (int)manager->getState());
+}
+
+static void test_connect_timeout_counts_as_failure(void) {
+    start("ward");
+    manager->update(WifiManager::CONNECT_TIMEOUT - 1);
+    TEST_ASSERT_EQUAL_INT((int)WifiState::CONNECTING, (int)manager->getState());
+    manager->update(WifiManager::CONNECT_TIMEOUT);
+    TEST_ASSERT_EQUAL_INT((int)WifiState::BACKOFF, (int)manager->getState());
+    TEST_ASSERT_EQUAL_INT(1, manager->getFailures());
+}
+
+static void test_connect_then_drop_between_updates(void) {
+    start("ward");
+
+    // Both arrive before the loop gets to update(): the link did come up,
+    // so this is a drop to retry at once, not a failure towards the portal
+    manager->notifyConnected();
+    manager->notifyDisconnected();
+    manager->update(1000);
+    TEST_ASSERT_EQUAL_INT((int)WifiState::CONNECTING, (int)manager->getState());
+    TEST_ASSERT_EQUAL_INT(0, manager->getFailures());
+    TEST_ASSERT_EQUAL_INT(2, driver.connects);
+    TEST_ASSERT_EQUAL_INT(3, transitions);     // Connecting, connected, connecting
+}
+
+static void test_drop_then_reconnect_between_updates(void) {
+    start("ward");
+    manager->notifyConnected();
+    manager->update(1000);
+    transitions = 0;
+
+    // The drop is not hidden by the reconnect after it: the manager
+    // associates again and ignores the stale connect
+    manager->notifyDisconnected();
+    manager->notifyConnected();
+    manager->update(2000);
+    TEST_ASSERT_EQUAL_INT((int)WifiState::CONNECTING, (int)manager->getState());
+    TEST_ASSERT_EQUAL_INT(2, driver.connects);
+    TEST_ASSERT_EQUAL_INT(1, transitions);
+
+    manager->notifyConnected();
+    manager->update(3000);
+    TEST_ASSERT_TRUE(manager->isConnected());
+}
+
+static void test_overflow_reassociates(void) {
+    start("ward");
+    manager->notifyConnected();
+    manager->update(1000);
+
+    // More events than the queue holds; the last one, a drop, is lost
+    for (int i = 0; i < WifiManager::EVENT_QUEUE_SIZE; i++) {
+        manager->notifyConnected();
+    }
+    manager->notifyDisconnected();
+    manager->update(2000);
+    TEST_ASSERT_EQUAL_INT((int)WifiState::CONNECTING, (int)manager->getState());
+    TEST_ASSERT_EQUAL_INT(2, driver.connects);
+
+    manager->update(3000);
+    TEST_ASSERT_EQUAL_INT((int)WifiState::CONNECTING, (int)manager->getState());
+}
+
+static void test_simulated_radio_outage(void) {
+    SimNetwork network;
+    network.setAccessPoint("ward", "secret");
+    network.setConnectDelay(0);
+    network.addOutage(20000, 15000);
+    network.attach(manager);
+    manager->begin(&network, "ward", "secret", onStateChange, 0);
+
+    uint32_t droppedAt = 0, backAt = 0;
+    for (uint32_t now = 0; now < 60000; now += 100) {
+        network.poll(now);
+        bool wasConnected = manager->isConnected();
+        manager->update(now);
+        if (wasConnected && !manager->isConnected() && !droppedAt) droppedAt = now;
+        if (droppedAt && !backAt && manager->isConnected()) backAt = now;
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(20000, droppedAt);
+    // Back within one backoff step of the outage ending, without the portal
+    TEST_ASSERT_GREATER_OR_EQUAL(35000, backAt);
+    TEST_ASSERT_LESS_OR_EQUAL(35000 + WifiManager::BACKOFF_MAX / 4 + WifiManager::CONNECT_TIMEOUT, backAt);
+    TEST_ASSERT_TRUE(manager->isConnected());
+    TEST_ASSERT_TRUE(network.isConnected());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_idle_without_credentials);
+    RUN_TEST(test_connect);
+    RUN_TEST(test_drop_reconnects_at_once);
+    RUN_TEST(test_backoff_doubles_up_to_the_cap);
+    RUN_TEST(test_portal_after_failures_from_boot);
+    RUN_TEST(test_connect_timeout_counts_as_failure);
+    RUN_TEST(test_connect_then_drop_between_updates);
+    RUN_TEST(test_drop_then_reconnect_between_updates);
+    RUN_TEST(test_overflow_reassociates);
+    RUN_TEST(test_simulated_radio_outage);
+    return UNITY_END();
+}
@@ -0,0 +1,194 @@
+/*
+ * One broadcast through web_interface.cpp to N WebSocket clients, on the
+ * native ESPAsyncWebServer (native/ESPAsyncWebServer.h): what it costs in
+ * heap calls and copied bytes, that every client sends the one pool frame,
+ * and that the frame goes back to the pool when the last client's TCP has
+ * acknowledged it or the client has gone. Heap calls are counted by
+ * interposing malloc, which operator new goes through.
+ *
+ *   pio test -e native -f test_ws_broadcast
+ */
+
+#include <unity.h>
+#include <string.h>
+#include "web_interface.h"
+#include "ws_frame_pool.h"
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+
+// Only the test thread's calls between startCounting() and stopCounting()
+static thread_local bool counting = false;
+static size_t heapCalls = 0;
+static size_t heapBytes = 0;
+
+static void countHeap(size_t size) {
+    if (counting) {
+        heapCalls++;
+        heapBytes += size;
+    }
+}
+
+extern "C" void* malloc(size_t size) {
+    countHeap(size);
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+    countHeap(count * size);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size) {
+    countHeap(size);
+    return __libc_realloc(pointer, size);
+}
+
+static const int PEERS = 6;
+
+static AsyncWebSocket* feed;
+static AsyncWebSocketClient* peers[PEERS];
+static size_t copiedAtStart;
+
+static void startCounting() {
+    heapCalls = 0;
+    heapBytes = 0;
+    copiedAtStart = AsyncClient::getCopiedBytes();
+    counting = true;
+}
+
+static size_t stopCounting() {
+    counting = false;
+    return AsyncClient::getCopiedBytes() - copiedAtStart;
+}
+
+static void broadcast() {
+    webInterface.broadcastVitalSigns(72.0f, 98.0f, 80.0f, true);
+}
+
+// Header and payload bytes a client has handed to TCP since its last full ack
+static size_t unacked(AsyncWebSocketClient* peer) {
+    size_t total = 0;
+    for (int i = 0; i < peer->client()->getWriteCount(); i++) {
+        total += peer->client()->getWrite(i).length;
+    }
+    return total;
+}
+
+void setUp(void) {
+    for (int i = 0; i < PEERS; i++) {
+        peers[i] = feed->connectNative();
+    }
+}
+
+void tearDown(void) {
+    for (int i = 0; i < PEERS; i++) {
+        if (peers[i]) feed->disconnectNative(peers[i]);
+        peers[i] = nullptr;
+    }
+}
+
+void test_broadcast_copies_nothing(void) {
+    startCounting();
+    broadcast();
+    size_t copied = stopCounting();
+
+    // AsyncWebSocket's queue node per client, and nothing else
+    TEST_ASSERT_EQUAL_INT(0, copied);
+    TEST_ASSERT_EQUAL_INT(PEERS, heapCalls);
+    TEST_ASSERT_TRUE(heapBytes <= PEERS * 4 * sizeof(void*));
+
+    // Every client sends the same pool bytes, after a header of its own
+    const AsyncClient::Write& first = peers[0]->client()->getWrite(1);
+    TEST_ASSERT_EQUAL_INT(1, wsFramePool.getInFlight());
+    TEST_ASSERT_EQUAL_INT(0, strncmp((const char*)first.data, "{\"type\":\"vitals\"", 16));
+    for (int i = 0; i < PEERS; i++) {
+        AsyncClient* tcp = peers[i]->client();
+        TEST_ASSERT_EQUAL_INT(2, tcp->getWriteCount());
+        TEST_ASSERT_FALSE(tcp->getWrite(0).copied);
+        TEST_ASSERT_FALSE(tcp->getWrite(1).copied);
+        TEST_ASSERT_EQUAL_HEX8(0x81, tcp->getWrite(0).data[0]);   // FIN, text
+        TEST_ASSERT_EQUAL_INT(first.length, tcp->getWrite(0).data[1]);
+        TEST_ASSERT_EQUAL_PTR(first.data, tcp->getWrite(1).data);
+        TEST_ASSERT_EQUAL_INT(first.length, tcp->getWrite(1).length);
+    }
+}
+
+void test_frame_is_held_until_the_last_ack(void) {
+    broadcast();
+    for (int i = 0; i < PEERS - 1; i++) {
+        peers[i]->client()->ackNative(unacked(peers[i]));
+        TEST_ASSERT_EQUAL_INT(0, peers[i]->queueLength());
+    }
+    TEST_ASSERT_EQUAL_INT(1, wsFramePool.getInFlight());
+
+    peers[PEERS - 1]->client()->ackNative(unacked(peers[PEERS - 1]));
+    TEST_ASSERT_EQUAL_INT(0, wsFramePool.getInFlight());
+}
+
+void test_queued_frames_go_out_as_acks_arrive(void) {
+    broadcast();
+    broadcast();
+
+    // The second frame waits in the queue behind the unacknowledged first
+    AsyncClient* tcp = peers[0]->client();
+    TEST_ASSERT_EQUAL_INT(2, peers[0]->queueLength());
+    TEST_ASSERT_EQUAL_INT(2, tcp->getWriteCount());
+    TEST_ASSERT_EQUAL_INT(2, wsFramePool.getInFlight());
+
+    const uint8_t* firstFrame = tcp->getWrite(1).data;
+    tcp->ackNative(unacked(peers[0]));
+    TEST_ASSERT_EQUAL_INT(1, peers[0]->queueLength());
+    TEST_ASSERT_EQUAL_INT(2, tcp->getWriteCount());
+    TEST_ASSERT_TRUE(tcp->getWrite(1).data != firstFrame);
+}
+
+void test_disconnect_releases_the_frame(void) {
+    broadcast();
+    TEST_ASSERT_EQUAL_INT(1, wsFramePool.getInFlight());
+
+    for (int i = 0; i < PEERS; i++) {
+        feed->disconnectNative(peers[i]);
+        peers[i] = nullptr;
+    }
+    TEST_ASSERT_EQUAL_INT(0, wsFramePool.getInFlight());
+}
+
+void test_spare_frame_is_copied_per_client(void) {
+    // Every pool frame still held: the broadcast goes out of a stack frame,
+    // which cannot outlive the call, so each client copies it
+    WsFrame* held[WsFramePool::POOL_SIZE];
+    for (int i = 0; i < WsFramePool::POOL_SIZE; i++) {
+        held[i] = wsFramePool.acquire();
+    }
+
+    startCounting();
+    broadcast();
+    size_t copied = stopCounting();
+
+    size_t length = peers[0]->client()->getWrite(1).length;
+    TEST_ASSERT_TRUE(copied >= PEERS * 2 * length);
+    TEST_ASSERT_TRUE(heapCalls > PEERS);
+    for (int i = 0; i < PEERS; i++) {
+        TEST_ASSERT_TRUE(peers[i]->client()->getWrite(1).copied);
+    }
+
+    for (int i = 0; i < WsFramePool::POOL_SIZE; i++) {
+        wsFramePool.release(held[i]);
+    }
+}
+
+int main(int argc, char** argv) {
+    // No service task: handleClients() would race the test's acks
+    webInterface.begin(false);
+    feed = AsyncWebSocket::findNative("/ws");
+
+    UNITY_BEGIN();
+    RUN_TEST(test_broadcast_copies_nothing);
+    RUN_TEST(test_frame_is_held_until_the_last_ack);
+    RUN_TEST(test_queued_frames_go_out_as_acks_arrive);
+    RUN_TEST(test_disconnect_releases_the_frame);
+    RUN_TEST(test_spare_frame_is_copied_per_client);
+    return UNITY_END();
+}
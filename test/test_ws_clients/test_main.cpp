@@ -0,0 +1,358 @@
+/*
+ * WebSocket fan-out on the host: one serialized frame to many clients,
+ * per-client lag decimation, the frame pool's reference counting, and what
+ * happens to a slow consumer: held alerts, their flush and eviction. Also
+ * the subscribe and command messages as web_interface.cpp reads them.
+ *
+ *   pio test -e native -f test_ws_clients
+ */
+
+#include <unity.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ws_clients.h"
+#include "ws_frame_pool.h"
+
+// A client with a scripted send window that records what it was sent
+class FakePeer : public WsPeer {
+public:
+    uint32_t clientId;
+    bool full;
+    size_t space;
+    bool closed;
+    std::vector<WsFrame*> frames;
+    std::vector<std::string> texts;     // Held alerts, sent as copies
+
+    explicit FakePeer(uint32_t id) : clientId(id), full(false), space(5744), closed(false) {}
+
+    uint32_t id() override { return clientId; }
+    bool queueIsFull() override { return full; }
+    size_t sendSpace() override { return space; }
+    void sendFrame(WsFrame* frame) override { frames.push_back(frame); }
+    void sendText(const char* data, size_t length) override { texts.push_back(std::string(data, length)); }
+    size_t sendBacklog() override { return 5744 - space; }
+    void close() override { closed = true; }
+};
+
+static WsClientTable table;
+static std::vector<FakePeer*> fakes;
+static WsPeer* peers[WsClientTable::MAX_CLIENTS];
+
+static void connect(int count) {
+    for (int i = 0; i < count; i++) {
+        FakePeer* peer = new FakePeer(100 + i);
+        TEST_ASSERT_TRUE(table.attach(peer->id()));
+        fakes.push_back(peer);
+        peers[i] = peer;
+    }
+}
+
+static WsFrame* frameWith(const char* text) {
+    WsFrame* frame = wsFramePool.acquire();
+    TEST_ASSERT_NOT_NULL(frame);
+    frame->length = strlen(text);
+    memcpy(frame->data, text, frame->length);
+    return frame;
+}
+
+void setUp(void) {
+    fakes.clear();
+}
+
+void tearDown(void) {
+    for (FakePeer* peer : fakes) {
+        table.detach(peer->id());
+        delete peer;
+    }
+    fakes.clear();
+}
+
+static void test_every_client_gets_the_one_frame(void) {
+    connect(WsClientTable::MAX_CLIENTS);
+    int inFlight = wsFramePool.getInFlight();
+
+    WsFrame* frame = frameWith("{\"type\":\"vitals\",\"heartRate\":72}");
+    int sent = table.broadcast(frame, WS_CHANNEL_VITALS, peers, WsClientTable::MAX_CLIENTS, 1000);
+    wsFramePool.release(frame);
+
+    TEST_ASSERT_EQUAL_INT(WsClientTable::MAX_CLIENTS, sent);
+    for (FakePeer* peer : fakes) {
+        // The same bytes, not a copy per client
+        TEST_ASSERT_EQUAL_INT(1, peer->frames.size());
+        TEST_ASSERT_EQUAL_PTR(frame, peer->frames[0]);
+    }
+    TEST_ASSERT_EQUAL_INT(inFlight, wsFramePool.getInFlight());
+}
+
+static void test_table_refuses_a_client_past_capacity(void) {
+    connect(WsClientTable::MAX_CLIENTS);
+    TEST_ASSERT_FALSE(table.attach(999));
+    TEST_ASSERT_EQUAL_INT(WsClientTable::MAX_CLIENTS, table.getClientCount());
+}
+
+static void test_only_subscribers_get_a_channel(void) {
+    connect(4);
+    table.subscribe(table.find(fakes[1]->id()), WS_CHANNEL_WAVEFORM);
+    table.unsubscribe(table.find(fakes[2]->id()), WS_CHANNEL_VITALS);
+
+    WsFrame* waveform = frameWith("{\"type\":\"waveform\"}");
+    TEST_ASSERT_EQUAL_INT(1, table.broadcast(waveform, WS_CHANNEL_WAVEFORM, peers, 4, 0));
+    wsFramePool.release(waveform);
+
+    WsFrame* vitals = frameWith("{\"type\":\"vitals\"}");
+    TEST_ASSERT_EQUAL_INT(3, table.broadcast(vitals, WS_CHANNEL_VITALS, peers, 4, 0));
+    wsFramePool.release(vitals);
+
+    TEST_ASSERT_EQUAL_INT(1, fakes[0]->frames.size());
+    TEST_ASSERT_EQUAL_INT(2, fakes[1]->frames.size());
+    TEST_ASSERT_EQUAL_INT(0, fakes[2]->frames.size());
+}
+
+static void test_lagging_clients_are_decimated_alone(void) {
+    connect(3);
+    fakes[1]->space = 1024;     // Light lag: every 2nd frame
+    fakes[2]->space = 256;      // Heavy lag: every 4th frame
+
+    for (int i = 0; i < 8; i++) {
+        WsFrame* frame = frameWith("{\"type\":\"vitals\"}");
+        table.broadcast(frame, WS_CHANNEL_VITALS, peers, 3, i * 100);
+        wsFramePool.release(frame);
+    }
+
+    TEST_ASSERT_EQUAL_INT(8, fakes[0]->frames.size());
+    TEST_ASSERT_EQUAL_INT(4, fakes[1]->frames.size());
+    TEST_ASSERT_EQUAL_INT(2, fakes[2]->frames.size());
+    TEST_ASSERT_EQUAL_UINT32(6, table.find(fakes[2]->id())->droppedFrames);
+}
+
+static void test_exhausted_pool_broadcasts_from_the_spare(void) {
+    connect(2);
+    std::vector<WsFrame*> held;
+    WsFrame* frame;
+    while ((frame = wsFramePool.acquire()) != nullptr) held.push_back(frame);
+    uint32_t exhausted = wsFramePool.getExhaustedCount();
+
+    WsFrame spare;
+    frame = wsFramePool.acquire(&spare);
+    TEST_ASSERT_EQUAL_PTR(&spare, frame);
+    TEST_ASSERT_EQUAL_UINT32(exhausted + 1, wsFramePool.getExhaustedCount());
+    frame->length = 2;
+    memcpy(frame->data, "{}", 2);
+    TEST_ASSERT_EQUAL_INT(2, table.broadcast(frame, WS_CHANNEL_VITALS, peers, 2, 0));
+    wsFramePool.release(frame);
+    TEST_ASSERT_EQUAL_UINT8(0, spare.refCount.load());
+
+    for (WsFrame* each : held) wsFramePool.release(each);
+    TEST_ASSERT_EQUAL_INT(0, wsFramePool.getInFlight());
+}
+
+static void test_release_never_wraps_the_count(void) {
+    WsFrame* frame = wsFramePool.acquire();
+    uint32_t overReleased = wsFramePool.getOverReleasedCount();
+    wsFramePool.release(frame);
+    wsFramePool.release(frame);
+
+    TEST_ASSERT_EQUAL_UINT8(0, frame->refCount.load());
+    TEST_ASSERT_EQUAL_UINT32(overReleased + 1, wsFramePool.getOverReleasedCount());
+    TEST_ASSERT_EQUAL_INT(0, wsFramePool.getInFlight());
+}
+
+static void test_concurrent_holders_balance(void) {
+    WsFrame* frame = wsFramePool.acquire();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([frame]() {
+            for (int i = 0; i < 100000; i++) {
+                wsFramePool.retain(frame);
+                wsFramePool.release(frame);
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    TEST_ASSERT_EQUAL_UINT8(1, frame->refCount.load());
+    wsFramePool.release(frame);
+    TEST_ASSERT_EQUAL_INT(0, wsFramePool.getInFlight());
+}
+
+static void alert(const char* text, int peerCount, unsigned long now) {
+    WsFrame* frame = frameWith(text);
+    table.broadcast(frame, WS_CHANNEL_ALERTS, peers, peerCount, now);
+    wsFramePool.release(frame);
+}
+
+static void test_stalled_client_gets_held_alerts_in_order(void) {
+    connect(2);
+    fakes[1]->full = true;
+    alert("{\"type\":\"alert\",\"n\":1}", 2, 0);
+    alert("{\"type\":\"alert\",\"n\":2}", 2, 100);
+
+    // Vitals are dropped for it meanwhile; alerts are not
+    WsFrame* vitals = frameWith("{\"type\":\"vitals\"}");
+    table.broadcast(vitals, WS_CHANNEL_VITALS, peers, 2, 200);
+    wsFramePool.release(vitals);
+    TEST_ASSERT_EQUAL_INT(3, fakes[0]->frames.size());
+    TEST_ASSERT_EQUAL_INT(0, fakes[1]->frames.size());
+    TEST_ASSERT_EQUAL_INT(2, table.getHeldAlertCount());
+
+    WsServiceStats stats;
+    table.service(peers, 2, 300, stats);
+    TEST_ASSERT_EQUAL_INT(2, stats.heldAlerts);
+    TEST_ASSERT_EQUAL_INT(0, fakes[1]->texts.size());
+
+    fakes[1]->full = false;
+    table.service(peers, 2, 400, stats);
+    TEST_ASSERT_EQUAL_INT(0, stats.heldAlerts);
+    TEST_ASSERT_EQUAL_INT(2, fakes[1]->texts.size());
+    TEST_ASSERT_EQUAL_STRING("{\"type\":\"alert\",\"n\":1}", fakes[1]->texts[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("{\"type\":\"alert\",\"n\":2}", fakes[1]->texts[1].c_str());
+    TEST_ASSERT_EQUAL_INT(0, table.getHeldAlertCount());
+    TEST_ASSERT_FALSE(fakes[1]->closed);
+}
+
+static void test_held_alerts_leave_the_pool_free(void) {
+    connect(WsClientTable::MAX_CLIENTS);
+    for (FakePeer* peer : fakes) peer->full = true;
+    for (int i = 0; i < WsClientState::MAX_PENDING_ALERTS; i++) {
+        alert("{\"type\":\"alert\"}", WsClientTable::MAX_CLIENTS, i);
+    }
+
+    // Every client stalled with alerts held, and no pool frame pinned
+    TEST_ASSERT_EQUAL_INT(0, wsFramePool.getInFlight());
+    uint32_t exhausted = wsFramePool.getExhaustedCount();
+    WsFrame* frame = frameWith("{\"type\":\"vitals\"}");
+    wsFramePool.release(frame);
+    TEST_ASSERT_EQUAL_UINT32(exhausted, wsFramePool.getExhaustedCount());
+}
+
+static void test_client_behind_on_alerts_is_closed(void) {
+    connect(1);
+    fakes[0]->full = true;
+    uint32_t evicted = table.getEvictedCount();
+    for (int i = 0; i < WsClientState::MAX_PENDING_ALERTS; i++) {
+        alert("{\"type\":\"alert\"}", 1, i);
+    }
+    TEST_ASSERT_FALSE(fakes[0]->closed);
+
+    // One more than it can hold: closed, so it reconnects and resyncs
+    alert("{\"type\":\"alert\"}", 1, 10);
+    TEST_ASSERT_TRUE(fakes[0]->closed);
+    TEST_ASSERT_EQUAL_UINT32(evicted + 1, table.getEvictedCount());
+}
+
+static void test_held_alerts_are_capped_across_clients(void) {
+    connect(WsClientTable::MAX_CLIENTS);
+    for (FakePeer* peer : fakes) peer->full = true;
+    alert("{\"type\":\"alert\"}", WsClientTable::MAX_CLIENTS, 0);
+    TEST_ASSERT_EQUAL_INT(WsClientTable::MAX_HELD_ALERTS, table.getHeldAlertCount());
+    alert("{\"type\":\"alert\"}", WsClientTable::MAX_CLIENTS, 1);
+
+    // No room for a second round: closed rather than silently skipped
+    int closed = 0;
+    for (FakePeer* peer : fakes) closed += peer->closed;
+    TEST_ASSERT_EQUAL_INT(WsClientTable::MAX_CLIENTS, closed);
+    TEST_ASSERT_EQUAL_INT(WsClientTable::MAX_HELD_ALERTS, table.getHeldAlertCount());
+
+    // Detaching returns the held alerts
+    tearDown();
+    TEST_ASSERT_EQUAL_INT(0, table.getHeldAlertCount());
+}
+
+static void test_stalled_client_is_evicted_after_the_timeout(void) {
+    connect(2);
+    fakes[1]->full = true;
+    fakes[1]->space = 0;
+    WsServiceStats stats;
+
+    table.service(peers, 2, 1000, stats);
+    TEST_ASSERT_EQUAL_INT(0, stats.evicted);
+    TEST_ASSERT_EQUAL_INT32(5744, stats.maxBacklog);
+
+    table.service(peers, 2, 1000 + WsClientTable::SLOW_CLIENT_TIMEOUT, stats);
+    TEST_ASSERT_FALSE(fakes[1]->closed);
+
+    table.service(peers, 2, 1001 + WsClientTable::SLOW_CLIENT_TIMEOUT, stats);
+    TEST_ASSERT_EQUAL_INT(1, stats.evicted);
+    TEST_ASSERT_TRUE(fakes[1]->closed);
+    TEST_ASSERT_FALSE(fakes[0]->closed);
+}
+
+static void test_recovering_client_is_not_evicted(void) {
+    connect(1);
+    fakes[0]->full = true;
+    WsServiceStats stats;
+    table.service(peers, 1, 0, stats);
+
+    fakes[0]->full = false;
+    table.service(peers, 1, 5000, stats);
+    fakes[0]->full = true;
+    table.service(peers, 1, 12000, stats);
+
+    // Stalled twice, but never for SLOW_CLIENT_TIMEOUT at a stretch
+    TEST_ASSERT_EQUAL_INT(0, stats.evicted);
+    TEST_ASSERT_FALSE(fakes[0]->closed);
+}
+
+static void test_subscription_names_all_four_channels(void) {
+    // The longest message the dashboard sends
+    const char* json = "{\"type\":\"subscribe\",\"data\":[\"vitals\",\"alerts\",\"waveform\",\"status\"]}";
+    bool subscribe = false;
+    uint8_t channels = 0;
+    TEST_ASSERT_TRUE(readSubscription(json, strlen(json), subscribe, channels));
+    TEST_ASSERT_TRUE(subscribe);
+    TEST_ASSERT_EQUAL_HEX8(WS_CHANNEL_VITALS | WS_CHANNEL_ALERTS | WS_CHANNEL_WAVEFORM | WS_CHANNEL_STATUS, channels);
+
+    connect(1);
+    WsClientState* state = table.find(fakes[0]->id());
+    table.subscribe(state, channels);
+    WsFrame* frame = frameWith("{\"type\":\"status\"}");
+    TEST_ASSERT_EQUAL_INT(1, table.broadcast(frame, WS_CHANNEL_STATUS, peers, 1, 1000));
+    wsFramePool.release(frame);
+}
+
+static void test_subscription_names_one_channel(void) {
+    const char* json = "{ \"type\" : \"unsubscribe\", \"data\" : \"waveform\" }";
+    bool subscribe = true;
+    uint8_t channels = 0;
+    TEST_ASSERT_TRUE(readSubscription(json, strlen(json), subscribe, channels));
+    TEST_ASSERT_FALSE(subscribe);
+    TEST_ASSERT_EQUAL_HEX8(WS_CHANNEL_WAVEFORM, channels);
+
+    // Not a subscription; read without a terminator, as from the frame
+    const char* command = "{\"command\":\"getVitals\"}trailing";
+    TEST_ASSERT_FALSE(readSubscription(command, 24, subscribe, channels));
+}
+
+static void test_command_is_read_in_place(void) {
+    const char* json = "{\"id\":7,\"options\":{\"command\":\"x\"},\"command\":\"getStatus\"}";
+    char command[32];
+    TEST_ASSERT_TRUE(readCommand(json, strlen(json), command, sizeof(command)));
+    TEST_ASSERT_EQUAL_STRING("getStatus", command);
+
+    TEST_ASSERT_TRUE(readCommand("{}", 2, command, sizeof(command)));
+    TEST_ASSERT_EQUAL_STRING("", command);
+    TEST_ASSERT_FALSE(readCommand("getStatus", 9, command, sizeof(command)));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_client_gets_the_one_frame);
+    RUN_TEST(test_table_refuses_a_client_past_capacity);
+    RUN_TEST(test_only_subscribers_get_a_channel);
+    RUN_TEST(test_lagging_clients_are_decimated_alone);
+    RUN_TEST(test_exhausted_pool_broadcasts_from_the_spare);
+    RUN_TEST(test_release_never_wraps_the_count);
+    RUN_TEST(test_concurrent_holders_balance);
+    RUN_TEST(test_stalled_client_gets_held_alerts_in_order);
+    RUN_TEST(test_held_alerts_leave_the_pool_free);
+    RUN_TEST(test_client_behind_on_alerts_is_closed);
+    RUN_TEST(test_held_alerts_are_capped_across_clients);
+    RUN_TEST(test_stalled_client_is_evicted_after_the_timeout);
+    RUN_TEST(test_recovering_client_is_not_evicted);
+    RUN_TEST(test_subscription_names_all_four_channels);
+    RUN_TEST(test_subscription_names_one_channel);
+    RUN_TEST(test_command_is_read_in_place);
+    return UNITY_END();
+}
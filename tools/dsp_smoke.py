@@ -0,0 +1,201 @@
+"""
+Smoke test for a built libcardiac_dsp: loads the shared library with plain
+ctypes (no numpy) and checks that:
+  - cardiac_dsp_abi_version() is the CARDIAC_DSP_ABI_VERSION of
+    dsp/cardiac_dsp.h, so cardiac_dsp.py and the library agree
+  - a few known windows come out of cardiac_ppg_process() with the heart
+    rate and SpO2 that the MAX3010x library's
+    maxim_heart_rate_and_oxygen_saturation() gives for the same samples,
+    with a finger detected; a clean pulse at 75 BPM must read 75 BPM
+  - cardiac_alarm_format() writes the monitor's alarm message
+
+The reference is the vendor code itself: its spo2_algorithm.cpp is built
+into a shared object of its own with --cxx and called directly.
+
+Exits non-zero on the first failed check.
+
+Usage:
+    g++ ... -o libcardiac_dsp.so ...     (see dsp/cardiac_dsp.h)
+    python tools/dsp_smoke.py
+Options:
+    --lib PATH       shared library (default $CARDIAC_DSP_LIB, else
+                     libcardiac_dsp.so in the repository root)
+    --estimator DIR  the MAX3010x library's src/, holding
+                     spo2_algorithm.cpp (default: the one PlatformIO fetched
+                     into .pio/libdeps)
+    --cxx PATH       host C++ compiler for the reference (default $CXX, else g++)
+"""
+
+import argparse
+import ctypes
+import glob
+import math
+import os
+import random
+import re
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+HEADER = os.path.join(ROOT, "dsp", "cardiac_dsp.h")
+
+PULSE_PERIOD = 20           # samples; 75 BPM at the estimator's 25 Hz
+IR_DC, IR_AC = 100000, 2000
+RED_DC, RED_AC = 60000, 900
+
+# (name, samples per beat, red AC, noise SD in counts): the first is the clean
+# pulse whose heart rate is checked outright
+WINDOWS = [("clean 75 BPM", PULSE_PERIOD, RED_AC, 0), ("noisy 60 BPM", 25, 700, 40),
+           ("noisy 94 BPM", 16, 1100, 40), ("noisy 125 BPM", 12, 900, 25)]
+
+# C linkage for ctypes over the library's C++ function
+REFERENCE = """
+#include "spo2_algorithm.h"
+extern "C" void reference_estimate(uint32_t* ir, int32_t length, uint32_t* red, int32_t* spo2,
+                                   int8_t* spo2_valid, int32_t* heart_rate, int8_t* heart_rate_valid) {
+    maxim_heart_rate_and_oxygen_saturation(ir, length, red, spo2, spo2_valid, heart_rate, heart_rate_valid);
+}
+"""
+
+
+class Vitals(ctypes.Structure):
+    _fields_ = [("heart_rate", ctypes.c_float), ("spo2", ctypes.c_float), ("battery_level", ctypes.c_float),
+                ("finger_detected", ctypes.c_int32), ("timestamp_ms", ctypes.c_uint32), ("sequence", ctypes.c_uint32)]
+
+
+class Alarm(ctypes.Structure):
+    _fields_ = [("kind", ctypes.c_int32), ("level", ctypes.c_int32), ("value", ctypes.c_float),
+                ("timestamp_ms", ctypes.c_uint32), ("sequence", ctypes.c_uint32)]
+
+
+def header_value(name):
+    """A #define or enum constant of dsp/cardiac_dsp.h"""
+    with open(HEADER) as f:
+        match = re.search(r"(?:#define\s+%s\s+|\b%s\s*=\s*)(\d+)" % (name, name), f.read())
+    if not match:
+        sys.exit("FAIL: %s not in %s" % (name, HEADER))
+    return int(match.group(1))
+
+
+def check(condition, message):
+    if not condition:
+        sys.exit("FAIL: " + message)
+    print("ok   " + message)
+
+
+def pulse(dc, ac, count, period=PULSE_PERIOD, noise=0, rng=None):
+    """Dips once per period as absorption rises with each beat"""
+    return [int(dc - ac * (0.5 - 0.5 * math.cos(2 * math.pi * i / period)) + (rng.gauss(0, noise) if noise else 0))
+            for i in range(count)]
+
+
+def estimator_dir(given):
+    """The MAX3010x library's src/, which holds spo2_algorithm.cpp"""
+    if given:
+        return given
+    found = sorted(glob.glob(os.path.join(ROOT, ".pio", "libdeps", "*", "SparkFun*MAX3010x*", "src")))
+    if not found:
+        sys.exit("FAIL: SparkFun MAX3010x library not found: run `pio pkg install -e native` or pass --estimator")
+    return found[0]
+
+
+def build_reference(cxx, estimator, workdir):
+    """The vendor estimator on its own, as a shared object"""
+    source = os.path.join(workdir, "reference.cpp")
+    library = os.path.join(workdir, "reference.so")
+    with open(source, "w") as f:
+        f.write(REFERENCE)
+    command = [cxx, "-std=gnu++17", "-DARDUINO=10819", "-I" + os.path.join(ROOT, "native"), "-I" + estimator,
+               "-fPIC", "-shared", "-o", library, source, os.path.join(estimator, "spo2_algorithm.cpp")]
+    result = subprocess.run(command, capture_output=True, text=True)
+    if result.returncode != 0:
+        sys.stderr.write(result.stderr)
+        sys.exit("FAIL: cannot build the reference estimator from %s" % estimator)
+    reference = ctypes.CDLL(library)
+    reference.reference_estimate.restype = None
+    reference.reference_estimate.argtypes = [
+        ctypes.POINTER(ctypes.c_uint32), ctypes.c_int32, ctypes.POINTER(ctypes.c_uint32), ctypes.POINTER(ctypes.c_int32),
+        ctypes.POINTER(ctypes.c_int8), ctypes.POINTER(ctypes.c_int32), ctypes.POINTER(ctypes.c_int8)]
+    return reference
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Smoke test a built libcardiac_dsp")
+    parser.add_argument("--lib", default=os.environ.get("CARDIAC_DSP_LIB", os.path.join(ROOT, "libcardiac_dsp.so")))
+    parser.add_argument("--estimator")
+    parser.add_argument("--cxx", default=os.environ.get("CXX", "g++"))
+    args = parser.parse_args()
+
+    try:
+        lib = ctypes.CDLL(args.lib)
+    except OSError as error:
+        sys.exit("FAIL: cannot load %s: %s" % (args.lib, error))
+
+    # ==================== ABI ====================
+    lib.cardiac_dsp_abi_version.restype = ctypes.c_uint32
+    expected = header_value("CARDIAC_DSP_ABI_VERSION")
+    version = lib.cardiac_dsp_abi_version()
+    check(version == expected, "ABI version %d, header says %d" % (version, expected))
+
+    # ==================== KNOWN WINDOWS ====================
+    window = header_value("CARDIAC_PPG_WINDOW_SAMPLES")
+    rate = header_value("CARDIAC_PPG_SAMPLE_RATE")
+    lib.cardiac_ppg_create.restype = ctypes.c_void_p
+    lib.cardiac_ppg_destroy.argtypes = [ctypes.c_void_p]
+    lib.cardiac_ppg_process.restype = ctypes.c_size_t
+    lib.cardiac_ppg_process.argtypes = [
+        ctypes.c_void_p, ctypes.POINTER(ctypes.c_uint32), ctypes.POINTER(ctypes.c_uint32), ctypes.c_size_t,
+        ctypes.POINTER(ctypes.c_uint8), ctypes.POINTER(Vitals), ctypes.POINTER(ctypes.c_uint32),
+        ctypes.c_size_t, ctypes.POINTER(ctypes.c_size_t)]
+
+    with tempfile.TemporaryDirectory() as workdir:
+        reference = build_reference(args.cxx, estimator_dir(args.estimator), workdir)
+        rng = random.Random(1)
+        samples = ctypes.c_uint32 * window
+        for name, period, red_ac, noise in WINDOWS:
+            red = samples(*pulse(RED_DC, red_ac, window, period, noise, rng))
+            ir = samples(*pulse(IR_DC, IR_AC, window, period, noise, rng))
+            finger = (ctypes.c_uint8 * window)()
+            windows = (Vitals * 2)()
+            ends = (ctypes.c_uint32 * 2)()
+            consumed = ctypes.c_size_t()
+
+            estimator = lib.cardiac_ppg_create()
+            check(estimator is not None, "%s: cardiac_ppg_create" % name)
+            count = lib.cardiac_ppg_process(estimator, red, ir, window, finger, windows, ends, 2,
+                                            ctypes.byref(consumed))
+            lib.cardiac_ppg_destroy(estimator)
+
+            spo2, spo2_valid = ctypes.c_int32(), ctypes.c_int8()
+            heart_rate, heart_rate_valid = ctypes.c_int32(), ctypes.c_int8()
+            reference.reference_estimate(ir, window, red, ctypes.byref(spo2),
+                                         ctypes.byref(spo2_valid), ctypes.byref(heart_rate),
+                                         ctypes.byref(heart_rate_valid))
+
+            check(count == 1 and consumed.value == window and ends[0] == window - 1,
+                  "%s: %d samples make one window, ending at sample %d" % (name, window, window - 1))
+            check(heart_rate_valid.value and spo2_valid.value,
+                  "%s: vendor estimate valid, %d BPM, %d %%" % (name, heart_rate.value, spo2.value))
+            check(windows[0].heart_rate == heart_rate.value,
+                  "%s: heart rate %g BPM, vendor %d" % (name, windows[0].heart_rate, heart_rate.value))
+            check(windows[0].spo2 == spo2.value, "%s: SpO2 %g %%, vendor %d" % (name, windows[0].spo2, spo2.value))
+            check(windows[0].finger_detected and all(finger), "%s: finger detected" % name)
+            if (period, noise) == (PULSE_PERIOD, 0):
+                expected = rate * 60 // PULSE_PERIOD
+                check(windows[0].heart_rate == expected,
+                      "%s: heart rate %g BPM, expected %d" % (name, windows[0].heart_rate, expected))
+    # ==================== ALARM MESSAGE ====================
+    lib.cardiac_alarm_format.restype = ctypes.c_size_t
+    lib.cardiac_alarm_format.argtypes = [ctypes.POINTER(Alarm), ctypes.c_char_p, ctypes.c_size_t]
+    alarm = Alarm(kind=header_value("CARDIAC_ALARM_HEART_RATE"), level=header_value("CARDIAC_ALERT_CRITICAL"),
+                  value=42.0)
+    buffer = ctypes.create_string_buffer(64)
+    lib.cardiac_alarm_format(ctypes.byref(alarm), buffer, len(buffer))
+    check(buffer.value == b"Heart rate: 42 BPM", "alarm message %r" % buffer.value.decode())
+
+    print("libcardiac_dsp ABI %d: all checks passed" % version)
+
+
+if __name__ == "__main__":
+    main()
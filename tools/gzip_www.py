@@ -0,0 +1,104 @@
+"""
+Build step: precompress the dashboard into the SPIFFS image.
+
+Gzips index.html, app.js and styles.css into data/www/ (the SPIFFS image
+PlatformIO uploads with `pio run -t uploadfs`), next to a plain copy for
+clients that do not accept gzip. Scripts and stylesheets get
+a content hash in their name so the device can serve them with a long
+Cache-Control; index.html keeps its name and is revalidated with its ETag.
+data/www/etags.txt lists "<url> <etag> <immutable>" for the web server.
+
+Runs automatically as a PlatformIO pre-script, or standalone:
+    python tools/gzip_www.py
+"""
+
+import gzip
+import hashlib
+import os
+import re
+
+PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+OUTPUT_DIR = os.path.join(PROJECT_DIR, "data", "www")
+
+# Assets referenced by index.html that get hashed names
+HASHED_ASSETS = ["app.js", "styles.css"]
+ENTRY_PAGE = "index.html"
+
+
+def content_hash(data):
+    return hashlib.sha256(data).hexdigest()[:12]
+
+
+def write_gzip(name, data):
+    # mtime=0 keeps the output byte-identical across builds
+    compressed = gzip.compress(data, compresslevel=9, mtime=0)
+    with open(os.path.join(OUTPUT_DIR, name + ".gz"), "wb") as f:
+        f.write(compressed)
+    with open(os.path.join(OUTPUT_DIR, name), "wb") as f:
+        f.write(data)
+    return len(compressed)
+
+
+def build():
+    os.makedirs(OUTPUT_DIR, exist_ok=True)
+    # The previous build's outputs, as listed in its etags.txt; other files
+    # uploaded to /www/ stay
+    listing = os.path.join(OUTPUT_DIR, "etags.txt")
+    if os.path.exists(listing):
+        with open(listing) as f:
+            for line in f:
+                url = line.split(" ", 1)[0].lstrip("/")
+                for name in (url, url + ".gz"):
+                    if url and os.path.exists(os.path.join(OUTPUT_DIR, name)):
+                        os.remove(os.path.join(OUTPUT_DIR, name))
+    for name in os.listdir(OUTPUT_DIR):
+        if name.endswith(".gz") or name == "etags.txt":
+            os.remove(os.path.join(OUTPUT_DIR, name))
+
+    etags = []
+    renamed = {}
+    total_raw = 0
+    total_gz = 0
+
+    for asset in HASHED_ASSETS:
+        with open(os.path.join(PROJECT_DIR, asset), "rb") as f:
+            data = f.read()
+        digest = content_hash(data)
+        stem, ext = os.path.splitext(asset)
+        hashed_name = "%s.%s%s" % (stem, digest, ext)
+        renamed[asset] = hashed_name
+
+        size = write_gzip(hashed_name, data)
+        etags.append("/%s \"%s\" 1" % (hashed_name, digest))
+        total_raw += len(data)
+        total_gz += size
+        print("www: %-28s %7d -> %6d bytes" % (hashed_name, len(data), size))
+
+    with open(os.path.join(PROJECT_DIR, ENTRY_PAGE), "rb") as f:
+        page = f.read().decode("utf-8")
+
+    # Point the page at the hashed names
+    for original, hashed_name in renamed.items():
+        page = re.sub(r'(src|href)="/?%s"' % re.escape(original),
+                      r'\1="%s"' % hashed_name, page)
+
+    page_bytes = page.encode("utf-8")
+    digest = content_hash(page_bytes)
+    size = write_gzip(ENTRY_PAGE, page_bytes)
+    etags.append("/%s \"%s\" 0" % (ENTRY_PAGE, digest))
+    total_raw += len(page_bytes)
+    total_gz += size
+    print("www: %-28s %7d -> %6d bytes" % (ENTRY_PAGE, len(page_bytes), size))
+
+    with open(os.path.join(OUTPUT_DIR, "etags.txt"), "w") as f:
+        f.write("\n".join(etags) + "\n")
+
+    print("www: total %d -> %d bytes (%.1f%%)" % (total_raw, total_gz, 100.0 * total_gz / total_raw))
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+    build()
+except NameError:
+    if __name__ == "__main__":
+        build()
@@ -0,0 +1,176 @@
+"""
+Measure dashboard load cost against a running monitor.
+
+Performs a cold load (empty cache) and a warm load (validators and
+immutable assets remembered from the cold load) and reports, per load,
+bytes on the wire and the time until index.html plus its render-blocking
+stylesheet and script have arrived. That is the earliest point a browser
+can paint the dashboard, so it is used as time-to-first-render.
+
+--local serves data/www (tools/gzip_www.py's output) from this machine by
+the rules of the sketch's serveAsset() and measures that instead: the
+bytes are what a monitor sends, apart from its header formatting; the
+times are loopback times and say nothing about the device. The native
+build's --http serves the sketch's own routes, given data/www in its
+--fs directory.
+
+Usage:
+    python tools/measure_dashboard.py 192.168.1.50
+    python tools/measure_dashboard.py --local
+    cp -r data/www run/ && .pio/build/native/program --fs run --wifi ward:secret --http 8081 --seconds 600 &
+    python tools/measure_dashboard.py 127.0.0.1:8081
+Options:
+    --identity    do not accept gzip
+"""
+
+import argparse
+import gzip as gzip_module
+import http.server
+import json
+import os
+import re
+import threading
+import time
+import urllib.error
+import urllib.request
+
+WWW_DIR = os.path.join(os.path.dirname(os.path.dirname(os.path.abspath(__file__))), "data", "www")
+CONTENT_TYPES = {".html": "text/html", ".js": "application/javascript", ".css": "text/css"}
+
+
+def fetch(base, path, cache, encoding):
+    request = urllib.request.Request(base + path, headers={"Accept-Encoding": encoding})
+    entry = cache.get(path)
+    if entry and entry["immutable"]:
+        # Browser serves immutable assets from cache without asking
+        return 0, 304, entry["body"]
+    if entry and entry["etag"]:
+        request.add_header("If-None-Match", entry["etag"])
+
+    try:
+        with urllib.request.urlopen(request, timeout=10) as response:
+            body = response.read()
+            status = response.status
+            headers = response.headers
+    except urllib.error.HTTPError as error:
+        if error.code != 304:
+            raise
+        return len(str(error.headers)), 304, entry["body"]
+
+    cache[path] = {
+        "etag": headers.get("ETag"),
+        "immutable": "immutable" in (headers.get("Cache-Control") or ""),
+        "body": body,
+    }
+    # Header bytes count too; they dominate a 304
+    return len(body) + len(str(headers)), status, body
+
+
+def load(base, cache, encoding):
+    start = time.perf_counter()
+    total_bytes, _, page = fetch(base, "/index.html", cache, encoding)
+
+    if page[:2] == b"\x1f\x8b":
+        page = gzip_module.decompress(page)
+
+    assets = re.findall(r'(?:href|src)="([^":]+\.(?:css|js))"', page.decode("utf-8", "replace"))
+    for asset in assets:
+        size, _, _ = fetch(base, "/" + asset.lstrip("/"), cache, encoding)
+        total_bytes += size
+
+    return {"bytes": total_bytes, "firstRenderMs": round((time.perf_counter() - start) * 1000, 1),
+            "assets": len(assets) + 1}
+
+
+# ==================== LOCAL STAND-IN ====================
+def etag_matches(header, etag):
+    # As etagMatches() in http_stream.cpp: a list, "*", weak comparison
+    def opaque(tag):
+        return tag[2:] if tag.startswith("W/") else tag
+    for entry in re.findall(r'(?:W/)?"[^"]*"|[^,\s]+', header):
+        if entry == "*" or opaque(entry) == opaque(etag):
+            return True
+    return False
+
+
+def accepts_gzip(header):
+    # As acceptsGzip() in http_stream.cpp
+    listed, wildcard = None, False
+    for part in header.split(","):
+        fields = [field.strip() for field in part.split(";")]
+        allowed = True
+        for field in fields[1:]:
+            if field.lower().startswith("q="):
+                allowed = float(field[2:] or 0) > 0
+        if fields[0].lower() == "gzip":
+            listed = allowed
+        elif fields[0] == "*":
+            wildcard = allowed
+    return listed if listed is not None else wildcard
+
+
+class AssetHandler(http.server.BaseHTTPRequestHandler):
+    assets = {}
+
+    def do_GET(self):
+        url = self.path
+        asset = self.assets.get(url)
+        if not asset:
+            self.send_error(404)
+            return
+        etag, immutable = asset
+        cache_control = "public, max-age=31536000, immutable" if immutable else "no-cache"
+        if etag_matches(self.headers.get("If-None-Match", ""), etag):
+            self.send_response(304)
+            self.send_header("ETag", etag)
+            self.send_header("Cache-Control", cache_control)
+            self.end_headers()
+            return
+
+        gzip = accepts_gzip(self.headers.get("Accept-Encoding", ""))
+        with open(os.path.join(WWW_DIR, url.lstrip("/") + (".gz" if gzip else "")), "rb") as f:
+            body = f.read()
+        self.send_response(200)
+        self.send_header("Content-Type", CONTENT_TYPES.get(os.path.splitext(url)[1], "application/octet-stream"))
+        self.send_header("Content-Length", str(len(body)))
+        if gzip:
+            self.send_header("Content-Encoding", "gzip")
+        self.send_header("ETag", etag)
+        self.send_header("Cache-Control", cache_control)
+        self.send_header("Vary", "Accept-Encoding")
+        self.end_headers()
+        self.wfile.write(body)
+
+    def log_message(self, format, *args):
+        pass
+
+
+def serve_local():
+    with open(os.path.join(WWW_DIR, "etags.txt")) as f:
+        for line in f:
+            url, etag, immutable = line.split()
+            AssetHandler.assets[url] = (etag, immutable == "1")
+    server = http.server.ThreadingHTTPServer(("127.0.0.1", 0), AssetHandler)
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    return "127.0.0.1:%d" % server.server_address[1]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("host", nargs="?")
+    parser.add_argument("--local", action="store_true")
+    parser.add_argument("--identity", action="store_true")
+    args = parser.parse_args()
+    if not args.host and not args.local:
+        parser.error("give a monitor's address or --local")
+
+    base = "http://" + (serve_local() if args.local else args.host)
+    encoding = "identity" if args.identity else "gzip"
+    cache = {}
+    cold = load(base, cache, encoding)
+    warm = load(base, cache, encoding)
+    print(json.dumps({"cold": cold, "warm": warm}, indent=2))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,194 @@
+"""
+Report the flash and RAM each target profile costs.
+
+For every profile in target_profile.h this compiles a probe of the monitor
+core on the host, with the profile's TARGET_ macro, and prints what the
+profile sets and how big the core's state is against the budget the
+core's static_assert holds it to. Host sizes are an upper bound for the
+Uno: AVR packs structs to the byte and its int is two bytes.
+
+With --build each profile's PlatformIO environment is built as well, and
+the flash and RAM of the firmware image are taken from the build summary.
+That needs PlatformIO and the board toolchains; without them the column
+is left empty.
+
+uno, esp32_parallel and esp32_ecg are experimental: their environments
+have never been built, so their rows are marked * and their probe figures
+are all there is to go on.
+
+Usage:
+    python tools/profile_size.py
+    python tools/profile_size.py --build
+Options:
+    --build       also build every profile's environment with pio
+    --json FILE   write the figures as JSON too
+    --cxx CXX     host compiler (default c++)
+    --estimator DIR
+                  src/ of the SparkFun MAX3010x library, for
+                  spo2_algorithm.cpp (default: the one PlatformIO fetched
+                  into .pio/libdeps, e.g. by `pio pkg install -e native`)
+"""
+
+import argparse
+import glob
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# environment in platformio.ini, macro selecting the profile, experimental
+# (never built)
+PROFILES = [
+    ("uno", "TARGET_UNO", True),
+    ("esp32dev", "TARGET_ESP32_SPI", False),
+    ("esp32_parallel", "TARGET_ESP32_PARALLEL", True),
+    ("esp32_ecg", "TARGET_ESP32_ECG", True),
+]
+
+PROBE = r"""
+#include <stdio.h>
+#include "monitor_core.h"
+
+struct ProbeBoard {
+    static uint16_t check() { return 0; }
+    static bool available() { return false; }
+    static uint32_t getRed() { return 0; }
+    static uint32_t getIR() { return 0; }
+    static void nextSample() {}
+    static uint16_t readBattery() { return 0; }
+    static uint32_t now() { return 0; }
+};
+
+struct ProbeSettings {
+    static void load(AlertThresholds&) {}
+    static void save(const AlertThresholds&) {}
+};
+
+struct ProbeLog {
+    static void append(const VitalSigns&) {}
+    static void flush() {}
+};
+
+typedef MonitorCore<TargetProfile, ProbeBoard, ProbeSettings, ProbeLog> Core;
+
+static const char* const BUSES[] = {"spi", "parallel_8bit"};
+static const char* const STORES[] = {"eeprom", "preferences"};
+static const char* const INPUTS[] = {"buttons", "touch"};
+
+int main() {
+    typedef TargetProfile P;
+    printf("{\"profile\": \"%s\", \"display\": \"%s\", \"settings\": \"%s\", \"input\": \"%s\", "
+           "\"wifi\": %s, \"flashLog\": %s, \"instrumentation\": %s, \"ecgTrace\": %s, "
+           "\"window\": %d, \"sampleBytes\": %u, \"history\": %d, \"historyBytes\": %u, "
+           "\"coreBytes\": %u, \"estimatorBytes\": %u, \"coreBudget\": %u, "
+           "\"flashBytes\": %u, \"ramBytes\": %u}\n",
+           P::NAME, BUSES[(int)P::DISPLAY_BUS], STORES[(int)P::SETTINGS], INPUTS[(int)P::INPUT_KIND],
+           P::HAS_WIFI ? "true" : "false", P::HAS_FLASH_LOG ? "true" : "false",
+           P::HAS_INSTRUMENTATION ? "true" : "false", P::HAS_ECG_TRACE ? "true" : "false",
+           P::PPG_WINDOW, (unsigned)sizeof(P::PpgSample), P::HISTORY,
+           (unsigned)(P::HISTORY * sizeof(VitalSigns)),
+           (unsigned)sizeof(Core), (unsigned)sizeof(Core::Estimator), (unsigned)P::CORE_RAM_BUDGET,
+           (unsigned)P::FLASH_BYTES, (unsigned)P::RAM_BYTES);
+    return 0;
+}
+"""
+
+SUMMARY = re.compile(r"(RAM|Flash):\s*\[.*?\]\s*[\d.]+%\s*\(used (\d+) bytes from (\d+) bytes\)")
+
+
+def estimator_dir(given):
+    """The MAX3010x library's src/, which holds spo2_algorithm.cpp"""
+    if given:
+        return given
+    found = sorted(glob.glob(os.path.join(ROOT, ".pio", "libdeps", "*", "SparkFun*MAX3010x*", "src")))
+    if not found:
+        raise SystemExit("SparkFun MAX3010x library not found: run `pio pkg install -e native` or pass --estimator")
+    return found[0]
+
+
+def probe(cxx, macro, workdir, estimator):
+    source = os.path.join(workdir, "probe.cpp")
+    program = os.path.join(workdir, "probe_" + macro.lower())
+    with open(source, "w") as f:
+        f.write(PROBE)
+    command = [cxx, "-std=gnu++17", "-DARDUINO=10819", "-D" + macro, "-I" + ROOT, "-I" + os.path.join(ROOT, "native"),
+               "-I" + estimator, "-o", program, source, os.path.join(ROOT, "vitals_pipeline.cpp"),
+               os.path.join(estimator, "spo2_algorithm.cpp")]
+    result = subprocess.run(command, capture_output=True, text=True)
+    if result.returncode != 0:
+        # A core over budget fails here, on its static_assert
+        sys.stderr.write(result.stderr)
+        raise SystemExit("probe for %s failed to build" % macro)
+    return json.loads(subprocess.run([program], capture_output=True, text=True, check=True).stdout)
+
+
+def build(env):
+    pio = shutil.which("pio") or shutil.which("platformio")
+    if not pio:
+        return None, "pio not found"
+    result = subprocess.run([pio, "run", "-e", env], cwd=ROOT, capture_output=True, text=True)
+    if result.returncode != 0:
+        lines = (result.stdout + result.stderr).strip().splitlines()
+        return None, "build failed: " + (lines[-1] if lines else "")
+    used = {}
+    for kind, size, total in SUMMARY.findall(result.stdout):
+        used[kind.lower()] = {"used": int(size), "total": int(total)}
+    return used, None
+
+
+def percent(used, total):
+    return "%d (%.1f%%)" % (used, 100.0 * used / total) if total else str(used)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--build", action="store_true")
+    parser.add_argument("--json")
+    parser.add_argument("--cxx", default=os.environ.get("CXX", "c++"))
+    parser.add_argument("--estimator")
+    args = parser.parse_args()
+    estimator = estimator_dir(args.estimator)
+
+    rows = []
+    with tempfile.TemporaryDirectory() as workdir:
+        for env, macro, experimental in PROFILES:
+            row = probe(args.cxx, macro, workdir, estimator)
+            row["env"] = env
+            row["experimental"] = experimental
+            if args.build:
+                row["firmware"], row["firmwareError"] = build(env)
+            rows.append(row)
+
+    print("%-15s %-14s %-8s %-12s %-5s %-4s %-8s %-10s %-10s %-17s %-22s %s" % (
+        "env", "display", "input", "settings", "wifi", "ecg", "window", "history", "core", "core budget",
+        "firmware flash", "firmware RAM"))
+    for row in rows:
+        firmware = row.get("firmware") or {}
+        flash = firmware.get("flash")
+        ram = firmware.get("ram")
+        print("%-15s %-14s %-8s %-12s %-5s %-4s %-8s %-10s %-10s %-17s %-22s %s" % (
+            row["env"] + ("*" if row["experimental"] else ""), row["display"], row["input"], row["settings"],
+            "yes" if row["wifi"] else "no", "yes" if row["ecgTrace"] else "no",
+            "%dx%d" % (row["window"], row["sampleBytes"] * 8),
+            "%d B" % row["historyBytes"],
+            "%d B" % row["coreBytes"],
+            "%d B (%d%%)" % (row["coreBudget"], 100 * row["coreBytes"] // row["coreBudget"]),
+            percent(flash["used"], flash["total"]) if flash else "-",
+            percent(ram["used"], ram["total"]) if ram else "-"))
+        if row.get("firmwareError"):
+            print("    %s: %s" % (row["env"], row["firmwareError"]))
+
+    print("\nCore sizes are host builds: an upper bound on the Uno, which packs to the byte.")
+    print("* experimental: the environment has never been built.")
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(rows, f, indent=2)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,232 @@
+"""
+Decoder for the monitor's binary trace log (see trace_log.h).
+
+In binary mode the firmware sends each TRACE() as a frame holding the
+address of its format string, a timestamp and the raw arguments. The
+timestamp is the CPU cycle counter on the ESP32 (nanoseconds on the host)
+and wraps every few seconds; it is unwrapped here, which holds as long as
+messages come more often than one wrap apart. This looks the format strings up in the firmware ELF the device
+is running and prints the messages. Bytes outside frames (serial command
+output, boot messages) are passed through unchanged.
+
+The ELF must be the exact build on the device; with a different one the
+addresses point at the wrong strings, and frames whose address is not a
+string in the ELF are shown as raw bytes.
+
+Usage:
+    python tools/trace_decode.py .pio/build/esp32dev/firmware.elf capture.bin
+    python tools/trace_decode.py firmware.elf --port /dev/ttyUSB0   (needs pyserial)
+    ./program --command 1:"trace binary" | python tools/trace_decode.py program - --tick-mhz 1000
+Options:
+    --timestamps      prefix each message with the time since the first one, in seconds
+    --tick-mhz F      timestamp ticks per microsecond (default 240, the ESP32's CPU clock)
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+FRAME_START = 0xA5
+MAX_RECORD = 128
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+# printf conversion: flags, width, precision, length modifier, conversion
+CONVERSION = re.compile(r"%([-+ #0]*)(\d*)(\.\d+)?(hh|h|ll|l|L|q|j|z|t)?([diouxXcsfFeEgGaAp%])")
+
+
+class Elf:
+    """Allocated sections of an ELF file, enough to read strings by address"""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF":
+            raise ValueError("%s is not an ELF file" % path)
+        self.is64 = data[4] == 2
+        endian = "<" if data[5] == 1 else ">"
+        self.pointer_size = 8 if self.is64 else 4
+        # Widths of long and size_t on the target, for the %l and %z arguments
+        self.long_size = self.pointer_size
+
+        if self.is64:
+            shoff, = struct.unpack_from(endian + "Q", data, 0x28)
+            shentsize, shnum = struct.unpack_from(endian + "HH", data, 0x3A)
+            entry = endian + "IIQQQQIIQQ"
+        else:
+            shoff, = struct.unpack_from(endian + "I", data, 0x20)
+            shentsize, shnum = struct.unpack_from(endian + "HH", data, 0x2E)
+            entry = endian + "IIIIIIIIII"
+
+        self.sections = []
+        for i in range(shnum):
+            fields = struct.unpack_from(entry, data, shoff + i * shentsize)
+            kind, flags, address, offset, size = fields[1], fields[2], fields[3], fields[4], fields[5]
+            if flags & SHF_ALLOC and kind != SHT_NOBITS and address and size:
+                self.sections.append((address, data[offset:offset + size]))
+
+    def string_at(self, address):
+        for start, contents in self.sections:
+            if start <= address < start + len(contents):
+                at = address - start
+                end = contents.find(b"\0", at)
+                if end < 0:
+                    return None
+                return contents[at:end].decode("utf-8", "replace")
+        return None
+
+
+def format_record(fmt, args, elf):
+    """printf over the packed arguments, as TraceLog::emitText does"""
+    out = []
+    at = 0
+    pos = 0
+    for match in CONVERSION.finditer(fmt):
+        out.append(fmt[pos:match.start()])
+        pos = match.end()
+        flags, width, precision, length, conversion = match.groups()
+        if conversion == "%":
+            out.append("%")
+            continue
+
+        spec = "%" + flags + width + (precision or "")
+        if conversion == "s":
+            size = args[at]
+            value = args[at + 1:at + 1 + size].decode("utf-8", "replace")
+            at += 1 + size
+            out.append((spec + "s") % value)
+        elif conversion in "fFeEgGaA":
+            value, = struct.unpack_from("<f", args, at)
+            at += 4
+            out.append((spec + ("e" if conversion in "aA" else conversion)) % value)
+        elif conversion == "p":
+            size = elf.pointer_size
+            value = int.from_bytes(args[at:at + size], "little")
+            at += size
+            out.append("0x%x" % value)
+        else:
+            wide = length in ("ll", "q", "j") or (length in ("l", "z", "t") and elf.long_size == 8)
+            size = 8 if wide and conversion != "c" else 4
+            signed = conversion in "di"
+            value = int.from_bytes(args[at:at + size], "little", signed=signed)
+            at += size
+            if conversion == "c":
+                out.append((spec + "c") % chr(value & 0xFF))
+            else:
+                out.append((spec + conversion.replace("u", "d")) % value)
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+class Decoder:
+    def __init__(self, elf, output, timestamps, tick_mhz=240.0):
+        self.elf = elf
+        self.output = output
+        self.timestamps = timestamps
+        self.tick_mhz = tick_mhz
+        self.ticks = None
+        self.last_raw = 0
+        self.pending = b""
+        self.line_start = True
+
+    def unwrap(self, raw):
+        """Ticks since the first record, from the wrapping 32-bit counter"""
+        if self.ticks is None:
+            self.ticks = 0
+        else:
+            self.ticks += (raw - self.last_raw) & 0xFFFFFFFF
+        self.last_raw = raw
+        return self.ticks
+
+    def emit(self, text, timestamp=None):
+        if not text:
+            return
+        if self.timestamps and timestamp is not None and self.line_start:
+            text = "[%12.6f] %s" % (timestamp / self.tick_mhz / 1e6, text)
+        self.output.write(text)
+        self.line_start = text.endswith("\n")
+
+    def feed(self, data):
+        buffer = self.pending + data
+        self.pending = b""
+        header = self.elf.pointer_size + 4
+        pos = 0
+        passthrough = bytearray()
+        while pos < len(buffer):
+            if buffer[pos] != FRAME_START:
+                passthrough.append(buffer[pos])
+                pos += 1
+                continue
+            if pos + 2 > len(buffer):
+                break
+            length = buffer[pos + 1]
+            if length < header or length > MAX_RECORD:
+                passthrough.append(buffer[pos])
+                pos += 1
+                continue
+            if pos + 3 + length > len(buffer):
+                break
+            payload = buffer[pos + 2:pos + 2 + length]
+            fmt = None
+            if sum(payload) & 0xFF == buffer[pos + 2 + length]:
+                address = int.from_bytes(payload[:self.elf.pointer_size], "little")
+                fmt = self.elf.string_at(address)
+            if fmt is None:
+                # Not a frame after all, or one from a different build
+                passthrough.append(buffer[pos])
+                pos += 1
+                continue
+
+            self.emit(passthrough.decode("utf-8", "replace"))
+            passthrough.clear()
+            timestamp = self.unwrap(struct.unpack_from("<I", payload, self.elf.pointer_size)[0])
+            try:
+                text = format_record(fmt, payload[header:], self.elf)
+            except (IndexError, ValueError, TypeError, OverflowError):
+                text = "<undecodable record for %r>\n" % fmt
+            self.emit(text, timestamp)
+            pos += 3 + length
+
+        self.emit(passthrough.decode("utf-8", "replace"))
+        # An incomplete frame at the end waits for the next read
+        self.pending = buffer[pos:]
+        self.output.flush()
+
+
+def read_chunks(args):
+    if args.port:
+        import serial
+        port = serial.Serial(args.port, args.baud, timeout=0.1)
+        while True:
+            yield port.read(4096)
+    stream = sys.stdin.buffer if args.input in (None, "-") else open(args.input, "rb")
+    while True:
+        chunk = os.read(stream.fileno(), 4096)
+        if not chunk:
+            return
+        yield chunk
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("elf", help="firmware ELF the device is running")
+    parser.add_argument("input", nargs="?", help="captured serial output, or - for stdin (default)")
+    parser.add_argument("--port", help="read from a serial port instead")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--timestamps", action="store_true")
+    parser.add_argument("--tick-mhz", type=float, default=240.0)
+    args = parser.parse_args()
+
+    decoder = Decoder(Elf(args.elf), sys.stdout, args.timestamps, args.tick_mhz)
+    try:
+        for chunk in read_chunks(args):
+            decoder.feed(chunk)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
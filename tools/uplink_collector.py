@@ -0,0 +1,174 @@
+"""
+Stand-in for the central collector that monitors upload to (see uplink.h).
+
+Accepts POSTed VLB1 batches, appends the decoded records to
+<out>/<device>.csv and answers with the next sequence it expects from that
+device. Per-device expected sequences are kept in <out>/state.json, so
+restarting the collector behaves like the real one.
+
+Failures can be injected to exercise the monitor's retry path:
+    --fail-rate 0.3   answer 503 to 30% of posts
+    --delay 2.5       sleep before answering (try > 10 s to hit the timeout)
+    --forget          start with empty state, forcing monitors to resend
+
+Usage:
+    python tools/uplink_collector.py --port 8080 --out collected
+    then set the monitor's collector URL to http://<host>:8080/ingest
+"""
+
+import argparse
+import json
+import os
+import random
+import struct
+import sys
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from threading import Lock
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return value, pos
+        shift += 7
+
+
+def read_signed_varint(data, pos):
+    value, pos = read_varint(data, pos)
+    return (value >> 1) ^ -(value & 1), pos
+
+
+def decode_batch(data):
+    """Returns (device_id, records); raises ValueError on a malformed batch."""
+    try:
+        if data[:4] != b"VLB1":
+            raise ValueError("bad magic")
+        pos = 4
+        id_length = data[pos]
+        pos += 1
+        device = data[pos:pos + id_length].decode("ascii")
+        pos += id_length
+        first_sequence, first_timestamp, count = struct.unpack_from("<IIH", data, pos)
+        pos += 10
+
+        sequence = first_sequence - 1
+        timestamp = first_timestamp
+        heart_rate = spo2 = battery = 0
+        records = []
+        for _ in range(count):
+            gap, pos = read_varint(data, pos)
+            delta, pos = read_varint(data, pos)
+            sequence += gap + 1
+            timestamp += delta
+            d, pos = read_signed_varint(data, pos)
+            heart_rate += d
+            d, pos = read_signed_varint(data, pos)
+            spo2 += d
+            d, pos = read_signed_varint(data, pos)
+            battery += d
+            flags = data[pos]
+            pos += 1
+            records.append((sequence, timestamp, heart_rate / 10.0, spo2 / 10.0, battery, flags))
+    except (IndexError, struct.error, UnicodeDecodeError) as error:
+        raise ValueError("truncated batch") from error
+
+    if pos != len(data):
+        raise ValueError("trailing bytes")
+    return device, records
+
+
+class Collector:
+    def __init__(self, out, forget):
+        self.out = out
+        self.lock = Lock()
+        self.state_path = os.path.join(out, "state.json")
+        os.makedirs(out, exist_ok=True)
+        self.expected = {}
+        if not forget and os.path.exists(self.state_path):
+            with open(self.state_path) as f:
+                self.expected = json.load(f)
+
+    def ingest(self, device, records):
+        """Stores records past the device's expected sequence; returns the new ack."""
+        with self.lock:
+            expected = self.expected.get(device, 0)
+            fresh = [r for r in records if r[0] >= expected]
+            if fresh and fresh[0][0] > expected and device in self.expected:
+                # Records rotated out of the device log before reaching us
+                print(f"{device}: gap {expected}..{fresh[0][0] - 1}", file=sys.stderr)
+
+            path = os.path.join(self.out, device.replace(":", "") + ".csv")
+            new_file = not os.path.exists(path)
+            with open(path, "a") as f:
+                if new_file:
+                    f.write("sequence,timestamp,heartRate,spO2,battery,flags\n")
+                for r in fresh:
+                    f.write("%d,%d,%.1f,%.1f,%d,%d\n" % r)
+
+            if fresh:
+                self.expected[device] = fresh[-1][0] + 1
+                # Replaced whole so a reader never sees it half written
+                with open(self.state_path + ".tmp", "w") as f:
+                    json.dump(self.expected, f)
+                os.replace(self.state_path + ".tmp", self.state_path)
+
+            duplicates = len(records) - len(fresh)
+            print(f"{device}: {len(fresh)} stored, {duplicates} duplicate, "
+                  f"ack {self.expected.get(device, 0)}")
+            return self.expected.get(device, 0)
+
+
+def make_handler(collector, args):
+    class Handler(BaseHTTPRequestHandler):
+        def do_POST(self):
+            if args.delay:
+                time.sleep(args.delay)
+            if random.random() < args.fail_rate:
+                self.reply(503, "unavailable")
+                return
+
+            body = self.rfile.read(int(self.headers.get("Content-Length", 0)))
+            try:
+                device, records = decode_batch(body)
+            except ValueError as error:
+                self.reply(400, str(error))
+                return
+            self.reply(200, str(collector.ingest(device, records)))
+
+        def reply(self, code, text):
+            payload = text.encode()
+            self.send_response(code)
+            self.send_header("Content-Type", "text/plain")
+            self.send_header("Content-Length", str(len(payload)))
+            self.end_headers()
+            self.wfile.write(payload)
+
+        def log_message(self, format, *log_args):
+            pass
+
+    return Handler
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--out", default="collected")
+    parser.add_argument("--fail-rate", type=float, default=0.0)
+    parser.add_argument("--delay", type=float, default=0.0)
+    parser.add_argument("--forget", action="store_true")
+    args = parser.parse_args()
+
+    collector = Collector(args.out, args.forget)
+    server = ThreadingHTTPServer(("", args.port), make_handler(collector, args))
+    print(f"Collector listening on :{args.port}, writing to {args.out}/")
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,195 @@
+"""
+Soak the uplink against a flaky collector across WiFi outages and reboots.
+
+Starts tools/uplink_collector.py with --fail-rate, then boots the native
+program several times on the same flash directory, each boot with a WiFi
+outage part way through. Afterwards checks that:
+  - the collector's CSV holds every sequence from 0 exactly once, in order
+  - each boot's uplink resumed from the cursor the last boot left in NVS
+  - that cursor is at most one batch behind the collector: a boot can end
+    after the collector stored a batch but before its ack was saved, and
+    that batch is then sent again and dropped as a duplicate
+  - everything logged before the last boot reached the collector
+  - posts really failed and were retried
+
+Exits non-zero on the first failed check.
+
+Usage:
+    pio run -e native
+    python tools/uplink_soak.py
+Options:
+    --program PATH   native program (default .pio/build/native/program)
+    --fail-rate F    share of posts the collector refuses (default 0.3)
+    --boots N        number of boots (default 3)
+    --seconds S      virtual seconds per boot (default 900)
+    --keep DIR       keep the flash and collector output in DIR
+"""
+
+import argparse
+import csv
+import json
+import os
+import re
+import shutil
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+COLLECTOR = os.path.join(ROOT, "tools", "uplink_collector.py")
+BATCH_RECORDS = 128     # Uplink::BATCH_RECORDS
+
+
+def free_port():
+    with socket.socket() as s:
+        s.bind(("127.0.0.1", 0))
+        return s.getsockname()[1]
+
+
+def wait_for_port(port, timeout=10.0):
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        try:
+            with socket.create_connection(("127.0.0.1", port), timeout=0.5):
+                return True
+        except OSError:
+            time.sleep(0.1)
+    return False
+
+
+def read_state(out):
+    path = os.path.join(out, "state.json")
+    if not os.path.exists(path):
+        return 0
+    with open(path) as f:
+        return next(iter(json.load(f).values()), 0)
+
+
+def read_cursor(fs):
+    path = os.path.join(fs, "nvs.txt")
+    if not os.path.exists(path):
+        return 0
+    with open(path) as f:
+        for line in f:
+            fields = line.rstrip("\n").split("\t")
+            if fields[:2] == ["uplink", "cursor"]:
+                return int(fields[2])
+    return 0
+
+
+def read_sequences(out):
+    sequences = []
+    for name in os.listdir(out):
+        if name.endswith(".csv"):
+            with open(os.path.join(out, name)) as f:
+                sequences += [int(row["sequence"]) for row in csv.DictReader(f)]
+    return sequences
+
+
+class Soak:
+    def __init__(self, args, work):
+        self.args = args
+        self.fs = os.path.join(work, "fs")
+        self.out = os.path.join(work, "collected")
+        self.failures = 0
+
+    def check_cursor(self, cursor, acknowledged, when):
+        self.check(cursor <= acknowledged <= cursor + BATCH_RECORDS,
+                   "%s: cursor %d, collector expects %d" % (when, cursor, acknowledged))
+
+    def check(self, ok, message):
+        print(("ok    " if ok else "FAIL  ") + message)
+        if not ok:
+            self.failures += 1
+
+    def boot(self, number, url):
+        # Outages at different points of each boot, the last one mid-batch
+        outage_at = 120 + 150 * number
+        command = [self.args.program, "--fs", self.fs, "--seconds", str(self.args.seconds),
+                   "--wifi", "ward:secret", "--outage", "%d:%d" % (outage_at, 90 + 30 * number)]
+        if number == 0:
+            command += ["--wipe", "--collector", url]
+        result = subprocess.run(command, capture_output=True, text=True)
+        if result.returncode != 0:
+            sys.exit("boot %d exited with %d:\n%s" % (number, result.returncode, result.stderr))
+        # Let the collector finish a post that was in flight at power off
+        time.sleep(0.5)
+        return result.stdout
+
+    def run(self):
+        port = free_port()
+        url = "http://127.0.0.1:%d/ingest" % port
+        collector = subprocess.Popen(
+            [sys.executable, COLLECTOR, "--port", str(port), "--out", self.out,
+             "--fail-rate", str(self.args.fail_rate)],
+            stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+        try:
+            if not wait_for_port(port):
+                sys.exit("collector did not start")
+
+            failed_posts = 0
+            logged_before_last = 0
+            for number in range(self.args.boots):
+                saved = read_cursor(self.fs) if number > 0 else 0
+                acknowledged = read_state(self.out)
+                output = self.boot(number, url)
+
+                match = re.search(r"Uplink to \S+, cursor (\d+)", output)
+                resumed = int(match.group(1)) if match else -1
+                self.check(resumed == saved, "boot %d resumed at cursor %d, NVS held %d" %
+                           (number, resumed, saved))
+                self.check_cursor(resumed, acknowledged, "boot %d" % number)
+
+                match = re.search(r"Vitals log: \d+ records, next sequence (\d+)", output)
+                logged_before_last = int(match.group(1)) if match else 0
+                failed_posts += len(re.findall(r"Uplink POST failed", output))
+        finally:
+            collector.terminate()
+            log, _ = collector.communicate()
+
+        sequences = read_sequences(self.out)
+        expected = read_state(self.out)
+        duplicates = len(sequences) - len(set(sequences))
+        self.check(duplicates == 0, "%d records in the CSV, %d duplicated" % (len(sequences), duplicates))
+        self.check(sequences == list(range(len(sequences))), "CSV sequences run 0..%d without gaps" %
+                   (len(sequences) - 1))
+        self.check(" gap " not in log, "collector reported no gaps")
+        self.check(expected == len(sequences), "collector expects %d next" % expected)
+        self.check_cursor(read_cursor(self.fs), expected, "after the last boot")
+        self.check(expected >= logged_before_last,
+                   "records logged before the last boot delivered (%d of %d)" %
+                   (min(expected, logged_before_last), logged_before_last))
+        self.check(failed_posts > 0, "%d posts failed and were retried" % failed_posts)
+        return self.failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--program", default=os.path.join(ROOT, ".pio", "build", "native", "program"))
+    parser.add_argument("--fail-rate", type=float, default=0.3)
+    parser.add_argument("--boots", type=int, default=3)
+    parser.add_argument("--seconds", type=int, default=900)
+    parser.add_argument("--keep")
+    args = parser.parse_args()
+
+    if not os.path.exists(args.program):
+        sys.exit("%s not found, run: pio run -e native" % args.program)
+
+    work = args.keep or tempfile.mkdtemp(prefix="uplink_soak_")
+    if args.keep:
+        shutil.rmtree(work, ignore_errors=True)
+        os.makedirs(work)
+    try:
+        failures = Soak(args, work).run()
+    finally:
+        if not args.keep:
+            shutil.rmtree(work, ignore_errors=True)
+
+    print("%d checks failed" % failures if failures else "uplink soak passed")
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == "__main__":
+    main()
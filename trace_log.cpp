@@ -0,0 +1,216 @@
+#include "trace_log.h"
+#include <stdio.h>
+#include "memory_accounting.h"
+
+TraceLog traceLog;
+
+static const uint32_t RING_MASK = TraceLog::RING_SIZE - 1;
+
+TraceLog::TraceLog() : reserved(0), consumed(0), dropped(0), draining(false) {
+    memset(ring, 0, sizeof(ring));
+    reportedDrops = 0;
+    task = nullptr;
+#if defined(ESP32)
+    binary = true;
+#else
+    // No firmware ELF with fixed addresses to decode against on the host
+    binary = false;
+#endif
+}
+
+void TraceLog::begin() {
+    if (task) return;
+    // Lowest priority above idle, on the core that does not run the sketch loop
+    const uint32_t stackBytes = 3072;
+    xTaskCreatePinnedToCore(taskEntry, "trace", stackBytes, this, 1, &task, 0);
+    memoryTrackTask("trace", task, stackBytes);
+}
+
+void TraceLog::taskEntry(void* param) {
+    TraceLog* log = static_cast<TraceLog*>(param);
+    while (true) {
+        log->drain();
+        vTaskDelay(pdMS_TO_TICKS(DRAIN_INTERVAL));
+    }
+}
+
+// ==================== PRODUCERS ====================
+uint8_t* TraceLog::reserve(size_t length, uint32_t& slot) {
+    if (length > MAX_RECORD) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    uint32_t total = (uint32_t)length + 2;
+    uint32_t start = reserved.load(std::memory_order_relaxed);
+    uint32_t skip;
+    do {
+        uint32_t offset = start & RING_MASK;
+        skip = offset + total > RING_SIZE ? RING_SIZE - offset : 0;
+        if (start + skip + total - consumed.load(std::memory_order_acquire) > RING_SIZE) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+    } while (!reserved.compare_exchange_weak(start, start + skip + total, std::memory_order_relaxed));
+
+    if (skip) __atomic_store_n(&ring[start & RING_MASK], RECORD_SKIP, __ATOMIC_RELEASE);
+    slot = start + skip;
+    ring[(slot + 1) & RING_MASK] = (uint8_t)length;
+    return ring + ((slot + 2) & RING_MASK);
+}
+
+// ==================== DRAIN ====================
+void TraceLog::drain() {
+    // One consumer at a time: the task, or a caller flushing before a restart
+    if (draining.exchange(true, std::memory_order_acquire)) return;
+
+    uint8_t payload[MAX_RECORD];
+    uint32_t position = consumed.load(std::memory_order_relaxed);
+    while (position != reserved.load(std::memory_order_acquire)) {
+        // Reserved but still being written; records are emitted in order
+        uint8_t* record = ring + (position & RING_MASK);
+        uint8_t flag = __atomic_load_n(record, __ATOMIC_ACQUIRE);
+        // Zeroed so a stale byte never reads as the ready flag of a later record
+        if (flag == RECORD_SKIP) {
+            uint32_t total = RING_SIZE - (position & RING_MASK);
+            memset(record, 0, total);
+            position += total;
+            consumed.store(position, std::memory_order_release);
+            continue;
+        }
+        if (flag != RECORD_READY) break;
+
+        size_t length = record[1];
+        memcpy(payload, record + 2, length);
+        memset(record, 0, length + 2);
+        position += length + 2;
+        consumed.store(position, std::memory_order_release);
+
+        if (binary) emitBinary(payload, length);
+        else emitText(payload, length);
+    }
+
+    uint32_t drops = getDropped();
+    if (drops != reportedDrops) {
+        const char* format = "trace: %u records dropped\n";
+        unsigned count = drops - reportedDrops;
+        size_t length = tracePackRecord(payload, TRACE_HEADER + traceSizeAll(count), format, count);
+        reportedDrops = drops;
+        if (binary) emitBinary(payload, length);
+        else emitText(payload, length);
+    }
+
+    draining.store(false, std::memory_order_release);
+}
+
+void TraceLog::emitBinary(const uint8_t* payload, size_t length) {
+    uint8_t frame[MAX_RECORD + 3];
+    uint8_t sum = 0;
+    frame[0] = FRAME_START;
+    frame[1] = (uint8_t)length;
+    for (size_t i = 0; i < length; i++) {
+        frame[2 + i] = payload[i];
+        sum += payload[i];
+    }
+    frame[2 + length] = sum;
+    Serial.write(frame, length + 3);
+}
+
+// printf over the packed arguments, one conversion at a time
+void TraceLog::emitText(const uint8_t* payload, size_t length) {
+    uintptr_t address;
+    memcpy(&address, payload, sizeof(address));
+    const char* format = (const char*)address;
+    size_t at = sizeof(address) + 4;
+
+    char out[256];
+    size_t used = 0;
+    const char* p = format;
+    while (*p && used < sizeof(out) - 1) {
+        if (*p != '%') {
+            out[used++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[used++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // Flags, width and precision are kept; the length modifier is
+        // replaced by one matching what was packed
+        char spec[24];
+        size_t s = 0;
+        spec[s++] = *p++;
+        while (*p && strchr("-+ #0123456789.", *p) && s < 12) spec[s++] = *p++;
+        int longs = 0;
+        bool wide = false;
+        while (*p && strchr("hlLqjzt", *p)) {
+            if (*p == 'l') longs++;
+            if (*p == 'q' || *p == 'j') wide = true;
+            if ((*p == 'z' || *p == 't') && sizeof(size_t) == 8) wide = true;
+            p++;
+        }
+        if (longs >= 2 || (longs == 1 && sizeof(long) == 8)) wide = true;
+        char conversion = *p;
+        if (!conversion) break;
+        p++;
+
+        size_t room = sizeof(out) - used;
+        int n = 0;
+        if (conversion == 's') {
+            if (at + 1 > length || at + 1 + payload[at] > length) break;
+            char text[MAX_STRING + 1];
+            size_t textLength = payload[at];
+            memcpy(text, payload + at + 1, textLength);
+            text[textLength] = '\0';
+            at += 1 + textLength;
+            spec[s++] = 's';
+            spec[s] = '\0';
+            n = snprintf(out + used, room, spec, text);
+        } else if (strchr("fFeEgGaA", conversion)) {
+            if (at + 4 > length) break;
+            float f;
+            memcpy(&f, payload + at, 4);
+            at += 4;
+            spec[s++] = conversion;
+            spec[s] = '\0';
+            n = snprintf(out + used, room, spec, (double)f);
+        } else if (conversion == 'p') {
+            if (at + sizeof(uintptr_t) > length) break;
+            uintptr_t pointer;
+            memcpy(&pointer, payload + at, sizeof(pointer));
+            at += sizeof(pointer);
+            spec[s++] = 'p';
+            spec[s] = '\0';
+            n = snprintf(out + used, room, spec, (void*)pointer);
+        } else if (strchr("diouxXc", conversion)) {
+            bool isSigned = conversion == 'd' || conversion == 'i';
+            if (wide && conversion != 'c') {
+                if (at + 8 > length) break;
+                uint64_t value;
+                memcpy(&value, payload + at, 8);
+                at += 8;
+                spec[s++] = 'l';
+                spec[s++] = 'l';
+                spec[s++] = conversion;
+                spec[s] = '\0';
+                n = isSigned ? snprintf(out + used, room, spec, (long long)value)
+                             : snprintf(out + used, room, spec, (unsigned long long)value);
+            } else {
+                if (at + 4 > length) break;
+                uint32_t value;
+                memcpy(&value, payload + at, 4);
+                at += 4;
+                spec[s++] = conversion;
+                spec[s] = '\0';
+                n = isSigned || conversion == 'c' ? snprintf(out + used, room, spec, (int)value)
+                                                  : snprintf(out + used, room, spec, (unsigned)value);
+            }
+        } else {
+            break;
+        }
+        if (n > 0) used += (size_t)n < room ? (size_t)n : room - 1;
+    }
+    Serial.write((const uint8_t*)out, used);
+}
@@ -0,0 +1,213 @@
+#ifndef TRACE_LOG_H
+#define TRACE_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+#include <Arduino.h>
+#include "profiler.h"
+
+// Deferred binary trace log for messages from hot paths.
+//
+//   TRACE("ALERT [%s]: %s\n", levelName, message.c_str());
+//
+// The caller reserves a slot in a lock-free ring and packs the address of
+// the format string, a profileTicks() timestamp (CCOUNT on the ESP32) and
+// the raw arguments straight into it; it never formats, never copies a
+// staged record and never waits for the UART. A full ring drops the record
+// and counts it. A low-priority task drains the ring to Serial, either as
+// binary frames for tools/trace_decode.py, which looks the format strings
+// up in the firmware ELF, or formatted on the device in text mode.
+//
+// Arguments are packed by type: integers as 4 or 8 bytes, floating point
+// as a 4-byte float, strings inline (up to MAX_STRING bytes). The compiler
+// checks them against the format as it does for printf. Width and
+// precision must be literal; '*' is not supported.
+//
+// Frame on the wire:
+//   0xA5, length, format address (pointer size), timestamp (4), arguments,
+//   checksum (sum of the bytes between length and checksum)
+// The timestamp counts CPU cycles on the ESP32 and nanoseconds on the host,
+// and wraps; trace_decode.py unwraps it.
+// All multi-byte fields little endian, as the ESP32 stores them.
+
+class TraceLog {
+public:
+    static const size_t RING_SIZE = 4096;       // Power of two
+    static const size_t MAX_RECORD = 128;
+    static const size_t MAX_STRING = 48;
+    static const uint8_t FRAME_START = 0xA5;
+    static const uint32_t DRAIN_INTERVAL = 20;  // ms
+    static const uint8_t RECORD_READY = 1;
+    static const uint8_t RECORD_SKIP = 2;       // Unused tail up to the end of the ring
+
+private:
+    // Each record is a ready flag, its length and its payload, and never
+    // wraps: a record that would is placed at the start of the ring, and
+    // the tail it skips is marked for the drain to pass over. Producers
+    // reserve space by advancing `reserved`, fill it and then raise the
+    // flag; the drain takes records in order while their flag is up and
+    // zeroes what it consumed.
+    uint8_t ring[RING_SIZE];
+    std::atomic<uint32_t> reserved;
+    std::atomic<uint32_t> consumed;
+    std::atomic<uint32_t> dropped;
+    uint32_t reportedDrops;
+    std::atomic<bool> draining;
+    bool binary;
+    TaskHandle_t task;
+
+    static void taskEntry(void* param);
+    void emitBinary(const uint8_t* payload, size_t length);
+    void emitText(const uint8_t* payload, size_t length);
+
+public:
+    TraceLog();
+
+    // Starts the drain task
+    void begin();
+    // Binary frames (default on the ESP32) or on-device formatting
+    void setBinary(bool enabled) { binary = enabled; }
+    bool isBinary() const { return binary; }
+
+    // Reserves a contiguous record of `length` payload bytes and returns
+    // where to pack it, or nullptr if it was dropped for lack of room.
+    // commit() with the returned slot publishes it.
+    uint8_t* reserve(size_t length, uint32_t& slot);
+    void commit(uint32_t slot) { __atomic_store_n(&ring[slot & (RING_SIZE - 1)], RECORD_READY, __ATOMIC_RELEASE); }
+    // Emits everything committed so far; called by the drain task, and
+    // usable before a restart so nothing is lost
+    void drain();
+
+    uint32_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+};
+
+extern TraceLog traceLog;
+
+// ==================== RECORD PACKING ====================
+// Each argument is sized first, then written straight into the slot the
+// ring reserved for the record; nothing is staged on the caller's stack.
+// Multi-byte fields are stored a byte at a time, little endian: a slot has
+// no alignment and the ESP32 faults on unaligned word stores.
+static inline uint8_t* tracePut(uint8_t* out, uint32_t word) {
+    out[0] = (uint8_t)word;
+    out[1] = (uint8_t)(word >> 8);
+    out[2] = (uint8_t)(word >> 16);
+    out[3] = (uint8_t)(word >> 24);
+    return out + 4;
+}
+
+static inline uint8_t* tracePut(uint8_t* out, uint64_t word) {
+    return tracePut(tracePut(out, (uint32_t)word), (uint32_t)(word >> 32));
+}
+
+static inline size_t traceStringLength(const char* text) {
+    size_t length = 0;
+    while (length < TraceLog::MAX_STRING && text[length]) length++;
+    return length;
+}
+
+static inline size_t traceSize(const char* text) {
+    return 1 + traceStringLength(text ? text : "(null)");
+}
+
+static inline size_t traceSize(char* text) {
+    return traceSize((const char*)text);
+}
+
+template <typename T>
+static inline size_t traceSize(T value) {
+    static_assert(std::is_arithmetic<T>::value || std::is_pointer<T>::value || std::is_enum<T>::value,
+                  "TRACE takes numbers, pointers and C strings");
+    (void)value;
+    if constexpr (std::is_floating_point<T>::value) return 4;
+    else if constexpr (std::is_pointer<T>::value) return sizeof(uintptr_t);
+    else return sizeof(T) > 4 ? sizeof(T) : 4;
+}
+
+static inline size_t traceSizeAll() {
+    return 0;
+}
+
+template <typename T, typename... Rest>
+static inline size_t traceSizeAll(T first, Rest... rest) {
+    return traceSize(first) + traceSizeAll(rest...);
+}
+
+// A string that grew since it was sized is cut to the room left at `end`
+static inline uint8_t* tracePack(uint8_t* out, uint8_t* end, const char* text) {
+    if (!text) text = "(null)";
+    size_t length = traceStringLength(text);
+    if (length > (size_t)(end - out) - 1) length = end - out - 1;
+    *out++ = (uint8_t)length;
+    for (size_t i = 0; i < length; i++) out[i] = (uint8_t)text[i];
+    return out + length;
+}
+
+static inline uint8_t* tracePack(uint8_t* out, uint8_t* end, char* text) {
+    return tracePack(out, end, (const char*)text);
+}
+
+template <typename T>
+static inline uint8_t* tracePack(uint8_t* out, uint8_t* end, T value) {
+    (void)end;
+    if constexpr (std::is_floating_point<T>::value) {
+        float f = (float)value;
+        uint32_t bits;
+        static_assert(sizeof(bits) == sizeof(f), "32-bit float");
+        __builtin_memcpy(&bits, &f, 4);
+        return tracePut(out, bits);
+    } else if constexpr (std::is_pointer<T>::value) {
+        return tracePut(out, (typename std::conditional<sizeof(uintptr_t) == 8, uint64_t, uint32_t>::type)(uintptr_t)value);
+    } else if constexpr (sizeof(T) > 4) {
+        return tracePut(out, (uint64_t)value);
+    } else {
+        // Default argument promotion, as printf sees it
+        return tracePut(out, std::is_signed<T>::value ? (uint32_t)(int32_t)value : (uint32_t)value);
+    }
+}
+
+static inline uint8_t* tracePackAll(uint8_t* out, uint8_t* end) {
+    (void)end;
+    return out;
+}
+
+template <typename T, typename... Rest>
+static inline uint8_t* tracePackAll(uint8_t* out, uint8_t* end, T first, Rest... rest) {
+    return tracePackAll(tracePack(out, end, first), end, rest...);
+}
+
+static const size_t TRACE_HEADER = sizeof(uintptr_t) + 4;   // Format address, timestamp
+
+// Header and arguments into `out`, which holds `length` bytes as sized by
+// traceSizeAll(); returns the bytes written
+template <typename... Args>
+static inline size_t tracePackRecord(uint8_t* out, size_t length, const char* format, Args... args) {
+    uint8_t* end = out + length;
+    uint8_t* at = tracePack(out, end, (const void*)format);
+    at = tracePut(at, profileTicks());
+    return tracePackAll(at, end, args...) - out;
+}
+
+template <typename... Args>
+static inline void traceRecord(const char* format, Args... args) {
+    size_t length = TRACE_HEADER + traceSizeAll(args...);
+    uint32_t slot;
+    uint8_t* out = traceLog.reserve(length, slot);
+    if (!out) return;
+    tracePackRecord(out, length, format, args...);
+    traceLog.commit(slot);
+}
+
+// Never called; lets the compiler check TRACE arguments against the format
+static inline void traceFormatCheck(const char* format, ...) __attribute__((format(printf, 1, 2)));
+static inline void traceFormatCheck(const char* format, ...) { (void)format; }
+
+#define TRACE(format, ...) do { \
+    if (false) traceFormatCheck(format, ##__VA_ARGS__); \
+    traceRecord(format, ##__VA_ARGS__); \
+} while (0)
+
+#endif
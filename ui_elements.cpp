@@ -1,7 +1,8 @@
 #include "ui_elements.h"
+#include "confi.h"
 
-UIElements::UIElements(Adafruit_ILI9341* tft) {
-    display = tft;
+UIElements::UIElements(Adafruit_GFX* gfx) {
+    display = gfx;
 }
 
 void UIElements::drawButton(int x, int y, int w, int h, String text, uint16_t bgColor, uint16_t textColor) {
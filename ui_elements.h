@@ -4,12 +4,14 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_ILI9341.h>
 
+// Draws on any GFX target: the panel itself, or a GFXcanvas16 in RAM that is
+// pushed to the panel in one go
 class UIElements {
 private:
-    Adafruit_ILI9341* display;
+    Adafruit_GFX* display;
     
 public:
-    UIElements(Adafruit_ILI9341* tft);
+    UIElements(Adafruit_GFX* gfx);
     
     // Button functions
     void drawButton(int x, int y, int w, int h, String text, uint16_t bgColor, uint16_t textColor);
@@ -0,0 +1,152 @@
+#include "uplink.h"
+#include "hal.h"
+#include "memory_accounting.h"
+#include <WiFi.h>
+#include <HTTPClient.h>
+
+Uplink uplink;
+
+Uplink::Uplink() {
+    endpoint[0] = '\0';
+    deviceId[0] = '\0';
+    task = nullptr;
+    cursor = 0;
+    backoff = BACKOFF_MIN;
+    retryAt = 0;
+    lastUpload = 0;
+    uploadedRecords = 0;
+    uploadedBytes = 0;
+    failedPosts = 0;
+    lostRecords = 0;
+}
+
+bool Uplink::begin(const char* url) {
+    if (url == nullptr || url[0] == '\0') {
+        Serial.println("Uplink disabled (no collector URL)");
+        return false;
+    }
+
+    strlcpy(endpoint, url, sizeof(endpoint));
+    strlcpy(deviceId, WiFi.macAddress().c_str(), sizeof(deviceId));
+
+    prefs.begin("uplink", false);
+    cursor = prefs.getUInt("cursor", 0);
+
+    // Core 0 runs the WiFi stack; the sketch loop stays on core 1
+    const uint32_t stackBytes = 6144;
+    xTaskCreatePinnedToCore(taskEntry, "uplink", stackBytes, this, 1, &task, 0);
+    memoryTrackTask("uplink", task, stackBytes);
+
+    Serial.printf("Uplink to %s, cursor %u\n", endpoint, (unsigned)cursor);
+    return true;
+}
+
+uint32_t Uplink::getPending() {
+    uint32_t next = vitalsLog.getNextSequence();
+    return next > cursor ? next - cursor : 0;
+}
+
+void Uplink::taskEntry(void* param) {
+    static_cast<Uplink*>(param)->run();
+}
+
+void Uplink::run() {
+    lastUpload = hal.clock->millis();
+
+    while (true) {
+        if (hal.network->isConnected() && (long)(hal.clock->millis() - retryAt) >= 0 && shouldSend()) {
+            if (sendBatch()) {
+                backoff = BACKOFF_MIN;
+                lastUpload = hal.clock->millis();
+                continue; // Drain the backlog without waiting
+            }
+            scheduleRetry();
+        }
+        vTaskDelay(pdMS_TO_TICKS(POLL_INTERVAL));
+    }
+}
+
+bool Uplink::shouldSend() {
+    // Anything older than the log now holds is gone; move past it
+    uint32_t first = vitalsLog.getFirstSequence();
+    if (cursor < first) {
+        lostRecords += first - cursor;
+        cursor = first;
+        prefs.putUInt("cursor", cursor);
+    }
+
+    uint32_t pending = getPending();
+    return pending >= (uint32_t)BATCH_RECORDS ||
+           (pending > 0 && hal.clock->millis() - lastUpload >= FLUSH_INTERVAL);
+}
+
+bool Uplink::sendBatch() {
+    VitalsRecord record;
+    if (!vitalsLog.read(cursor, record)) {
+        return false;
+    }
+
+    UplinkBatchEncoder encoder;
+    encoder.begin(batch, sizeof(batch), deviceId, record);
+    uint32_t sequence = cursor;
+    while (encoder.getCount() < BATCH_RECORDS && vitalsLog.read(sequence, record) && encoder.add(record)) {
+        sequence++;
+    }
+    size_t length = encoder.finish();
+
+    HTTPClient http;
+    http.setTimeout(HTTP_TIMEOUT);
+    if (!http.begin(endpoint)) {
+        failedPosts++;
+        return false;
+    }
+    http.addHeader("Content-Type", "application/octet-stream");
+    http.addHeader("X-Device-Id", deviceId);
+
+    int code = http.POST(batch, length);
+    bool ok = false;
+    if (code == 200) {
+        // Body is the next sequence the collector expects
+        String body = http.getString();
+        char* end;
+        uint32_t ack = strtoul(body.c_str(), &end, 10);
+        ok = end != body.c_str() && acknowledge(ack, encoder.getLastSequence());
+    }
+    http.end();
+
+    if (ok) {
+        uploadedRecords += encoder.getCount();
+        uploadedBytes += length;
+    } else {
+        failedPosts++;
+        Serial.printf("Uplink POST failed: %d\n", code);
+    }
+    return ok;
+}
+
+bool Uplink::acknowledge(uint32_t ack, uint32_t lastSent) {
+    // Never move past what was actually sent. A lower ack means the
+    // collector lost data and wants it again, as far back as the log goes.
+    if (ack > lastSent + 1) {
+        ack = lastSent + 1;
+    }
+    if (ack < vitalsLog.getFirstSequence()) {
+        ack = vitalsLog.getFirstSequence();
+    }
+
+    // An ack that does not move the cursor is treated as a failure and backed off
+    if (ack == cursor) {
+        return false;
+    }
+    cursor = ack;
+    prefs.putUInt("cursor", cursor);
+    return true;
+}
+
+void Uplink::scheduleRetry() {
+    // Equal jitter: wait between half and all of the current backoff, so a
+    // ward of monitors coming back online does not retry in lockstep
+    uint32_t wait = backoff / 2 + esp_random() % (backoff / 2 + 1);
+    retryAt = hal.clock->millis() + wait;
+    backoff = backoff * 2 > BACKOFF_MAX ? BACKOFF_MAX : backoff * 2;
+}
@@ -0,0 +1,67 @@
+#ifndef UPLINK_H
+#define UPLINK_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "vitals_log.h"
+#include "uplink_codec.h"
+
+// Store-and-forward upload of the vitals log to a central collector.
+//
+// The log itself is the outbox: the uplink only keeps a cursor (the next
+// sequence to send), persisted in NVS so nothing is resent or skipped
+// across reboots. Batches are POSTed as application/octet-stream (see
+// uplink_codec.h); the collector answers with the next sequence it expects,
+// which becomes the new cursor. Runs as its own task on the network core.
+class Uplink {
+public:
+    static const int BATCH_RECORDS = 128;
+    static const size_t BATCH_BYTES = UPLINK_HEADER_BYTES + BATCH_RECORDS * UPLINK_MAX_RECORD_BYTES;
+    static const uint32_t FLUSH_INTERVAL = 30000;     // Send a partial batch after this long
+    static const uint32_t POLL_INTERVAL = 1000;
+    static const uint32_t BACKOFF_MIN = 2000;
+    static const uint32_t BACKOFF_MAX = 300000;
+    static const uint16_t HTTP_TIMEOUT = 10000;
+
+private:
+    char endpoint[128];
+    char deviceId[18];
+    uint8_t batch[BATCH_BYTES];
+    Preferences prefs;
+    TaskHandle_t task;
+
+    uint32_t cursor;
+    uint32_t backoff;
+    unsigned long retryAt;
+    unsigned long lastUpload;
+
+    uint32_t uploadedRecords;
+    uint32_t uploadedBytes;
+    uint32_t failedPosts;
+    uint32_t lostRecords;     // Rotated out of the log before they could be sent
+
+public:
+    Uplink();
+
+    // Starts the uplink task; does nothing when url is empty
+    bool begin(const char* url);
+
+    uint32_t getCursor() { return cursor; }
+    uint32_t getPending();
+    uint32_t getUploadedRecords() { return uploadedRecords; }
+    uint32_t getUploadedBytes() { return uploadedBytes; }
+    uint32_t getFailedPosts() { return failedPosts; }
+    uint32_t getLostRecords() { return lostRecords; }
+
+private:
+    static void taskEntry(void* param);
+    void run();
+    bool shouldSend();
+    bool sendBatch();
+    bool acknowledge(uint32_t ack, uint32_t lastSent);
+    void scheduleRetry();
+};
+
+extern Uplink uplink;
+
+#endif
@@ -0,0 +1,91 @@
+#include "uplink_codec.h"
+#include <string.h>
+
+UplinkBatchEncoder::UplinkBatchEncoder() {
+    buffer = nullptr;
+    size = 0;
+    length = 0;
+    countOffset = 0;
+    count = 0;
+    memset(&previous, 0, sizeof(previous));
+}
+
+bool UplinkBatchEncoder::begin(uint8_t* buf, size_t bufSize, const char* deviceId, const VitalsRecord& first) {
+    buffer = buf;
+    size = bufSize;
+    length = 0;
+    count = 0;
+
+    if (size < UPLINK_HEADER_BYTES + UPLINK_MAX_RECORD_BYTES) {
+        return false;
+    }
+
+    size_t idLength = strlen(deviceId);
+    if (idLength > 32) idLength = 32;
+
+    memcpy(buffer, "VLB1", 4);
+    length = 4;
+    putByte((uint8_t)idLength);
+    memcpy(buffer + length, deviceId, idLength);
+    length += idLength;
+    putU32(first.sequence);
+    putU32(first.timestamp);
+    countOffset = length;
+    putU16(0);
+
+    memset(&previous, 0, sizeof(previous));
+    previous.sequence = first.sequence - 1;
+    previous.timestamp = first.timestamp;
+    return true;
+}
+
+bool UplinkBatchEncoder::add(const VitalsRecord& record) {
+    if (length + UPLINK_MAX_RECORD_BYTES > size || count == UINT16_MAX) {
+        return false;
+    }
+
+    putVarint(record.sequence - previous.sequence - 1);
+    putVarint(record.timestamp - previous.timestamp);
+    putSignedVarint((int32_t)record.heartRate - (int32_t)previous.heartRate);
+    putSignedVarint((int32_t)record.spO2 - (int32_t)previous.spO2);
+    putSignedVarint((int32_t)record.batteryLevel - (int32_t)previous.batteryLevel);
+    putByte(record.flags);
+
+    previous = record;
+    count++;
+    return true;
+}
+
+size_t UplinkBatchEncoder::finish() {
+    buffer[countOffset] = count & 0xFF;
+    buffer[countOffset + 1] = count >> 8;
+    return length;
+}
+
+void UplinkBatchEncoder::putByte(uint8_t value) {
+    buffer[length++] = value;
+}
+
+void UplinkBatchEncoder::putU16(uint16_t value) {
+    putByte(value & 0xFF);
+    putByte(value >> 8);
+}
+
+void UplinkBatchEncoder::putU32(uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        putByte((value >> (8 * i)) & 0xFF);
+    }
+}
+
+void UplinkBatchEncoder::putVarint(uint32_t value) {
+    while (value >= 0x80) {
+        putByte((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    putByte((uint8_t)value);
+}
+
+void UplinkBatchEncoder::putSignedVarint(int32_t value) {
+    // Zigzag: small negative deltas stay one byte
+    putVarint(((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
@@ -0,0 +1,62 @@
+#ifndef UPLINK_CODEC_H
+#define UPLINK_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "vitals_log.h"
+
+// Binary batch posted to the collector (all integers little endian):
+//
+//   "VLB1"                     magic + format version
+//   u8   idLength, id[idLength] device id
+//   u32  firstSequence
+//   u32  firstTimestamp        log time of the first record, ms
+//   u16  count
+//   count x {
+//     varint   sequence gap    (0 when contiguous)
+//     varint   timestamp delta
+//     svarint  heartRate delta (BPM x10)
+//     svarint  spO2 delta      (% x10)
+//     svarint  battery delta
+//     u8       flags
+//   }
+//
+// Deltas are taken against the previous record (the first one against
+// firstSequence - 1, firstTimestamp and zero vitals), so a steady 1 Hz
+// stream packs into about 6 bytes per record instead of 16.
+static const size_t UPLINK_MAX_RECORD_BYTES = 5 + 5 + 3 + 3 + 2 + 1;
+static const size_t UPLINK_HEADER_BYTES = 4 + 1 + 32 + 4 + 4 + 2;
+
+class UplinkBatchEncoder {
+private:
+    uint8_t* buffer;
+    size_t size;
+    size_t length;
+    size_t countOffset;
+    uint16_t count;
+    VitalsRecord previous;
+
+public:
+    UplinkBatchEncoder();
+
+    // Starts a batch; deviceId is truncated to 32 bytes
+    bool begin(uint8_t* buf, size_t bufSize, const char* deviceId, const VitalsRecord& first);
+
+    // False when the buffer cannot take another worst-case record
+    bool add(const VitalsRecord& record);
+
+    // Patches the record count and returns the batch length
+    size_t finish();
+
+    uint16_t getCount() const { return count; }
+    uint32_t getLastSequence() const { return previous.sequence; }
+
+private:
+    void putByte(uint8_t value);
+    void putU16(uint16_t value);
+    void putU32(uint32_t value);
+    void putVarint(uint32_t value);
+    void putSignedVarint(int32_t value);
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef VITAL_SIGNS_H
+#define VITAL_SIGNS_H
+
+#include <stdint.h>
+
+// AVR has no <tuple>, and the Uno serves no JSON
+#if !defined(__AVR__)
+#include "json_schema.h"
+#endif
+
+// ==================== DATA STRUCTURES ====================
+struct VitalSigns {
+    float heartRate = 0;
+    float spO2 = 0;
+    float batteryLevel = 0;
+    bool isFingerDetected = false;
+    unsigned long timestamp = 0;
+    uint32_t sequence = 0;      // Newest sensor burst behind the reading; see latency_trace.h
+};
+
+#if !defined(__AVR__)
+// Shape served by /api/vitals
+template <>
+struct JsonSchema<VitalSigns> {
+    static constexpr auto fields() {
+        return std::make_tuple(
+            jsonMember("heartRate", &VitalSigns::heartRate, 1),
+            jsonMember("spO2", &VitalSigns::spO2, 1),
+            jsonMember("batteryLevel", &VitalSigns::batteryLevel, 1),
+            jsonMember("isFingerDetected", &VitalSigns::isFingerDetected),
+            jsonMember("timestamp", &VitalSigns::timestamp));
+    }
+};
+
+// Entry of a history array; the finger flag is implied by being logged
+struct VitalsHistorySchema {
+    static constexpr auto fields() {
+        return std::make_tuple(
+            jsonMember("heartRate", &VitalSigns::heartRate, 1),
+            jsonMember("spO2", &VitalSigns::spO2, 1),
+            jsonMember("batteryLevel", &VitalSigns::batteryLevel, 1),
+            jsonMember("timestamp", &VitalSigns::timestamp));
+    }
+};
+
+// "current" object of /data
+struct VitalsCurrentSchema {
+    static constexpr auto fields() {
+        return std::make_tuple(
+            jsonMember("heartRate", &VitalSigns::heartRate, 1),
+            jsonMember("spO2", &VitalSigns::spO2, 1),
+            jsonMember("batteryLevel", &VitalSigns::batteryLevel, 1),
+            jsonMember("fingerDetected", &VitalSigns::isFingerDetected),
+            jsonMember("timestamp", &VitalSigns::timestamp),
+            jsonMember("seq", &VitalSigns::sequence));
+    }
+};
+
+// WebSocket "vitals" message
+struct VitalsMessageSchema {
+    static constexpr auto fields() {
+        return std::make_tuple(
+            jsonConstant("type", "vitals"),
+            jsonMember("heartRate", &VitalSigns::heartRate, 1),
+            jsonMember("spO2", &VitalSigns::spO2, 1),
+            jsonMember("battery", &VitalSigns::batteryLevel, 1),
+            jsonMember("fingerDetected", &VitalSigns::isFingerDetected),
+            jsonMember("timestamp", &VitalSigns::timestamp),
+            jsonMember("seq", &VitalSigns::sequence));
+    }
+};
+#endif
+
+#endif
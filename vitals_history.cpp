@@ -0,0 +1,162 @@
+#include "vitals_history.h"
+
+// ==================== BUCKET READER ====================
+HistoryBucketReader::HistoryBucketReader(VitalsLog* vitalsLog, const HistoryQuery& historyQuery, uint32_t start) {
+    log = vitalsLog;
+    query = historyQuery;
+    startSequence = start;
+    rewind();
+}
+
+void HistoryBucketReader::rewind() {
+    sequence = startSequence;
+    produced = 0;
+}
+
+bool HistoryBucketReader::next(HistorySample& sample) {
+    if (produced >= query.limit) {
+        return false;
+    }
+
+    VitalsRecord record;
+    if (!log->read(sequence, record) || record.timestamp >= query.to) {
+        return false;
+    }
+
+    // Average every record that falls into the same bucket as the first one
+    uint32_t bucketEnd = query.resolution > 0
+        ? record.timestamp - (record.timestamp % query.resolution) + query.resolution
+        : record.timestamp + 1;
+
+    uint32_t samples = 0;
+    float heartRateSum = 0, spO2Sum = 0;
+    sample.timestamp = record.timestamp;
+
+    while (record.timestamp < bucketEnd && record.timestamp < query.to) {
+        heartRateSum += record.heartRate / 10.0f;
+        spO2Sum += record.spO2 / 10.0f;
+        sample.batteryLevel = record.batteryLevel;
+        samples++;
+        sequence++;
+
+        if (query.resolution == 0 || !log->read(sequence, record)) {
+            break;
+        }
+    }
+
+    sample.heartRate = heartRateSum / samples;
+    sample.spO2 = spO2Sum / samples;
+    produced++;
+    return true;
+}
+
+bool HistoryBucketReader::hasMore() {
+    VitalsRecord record;
+    return log->read(sequence, record) && record.timestamp < query.to;
+}
+
+// ==================== COLUMNAR GENERATOR ====================
+static uint32_t startSequenceFor(VitalsLog* vitalsLog, const HistoryQuery& query) {
+    uint32_t start = vitalsLog->findSequence(query.from);
+    if (query.hasCursor && query.cursor > start) {
+        start = query.cursor;
+    }
+    return start;
+}
+
+VitalsHistoryGenerator::VitalsHistoryGenerator(VitalsLog* vitalsLog, const HistoryQuery& query)
+    : reader(vitalsLog, query, startSequenceFor(vitalsLog, query)),
+      sink(nullptr, 0),
+      writer(sink) {
+    resolution = query.resolution;
+    stage = STAGE_HEADER;
+    column = 0;
+    columnIndex = 0;
+    previousTimestamp = 0;
+    firstTimestamp = 0;
+    count = 0;
+    nextCursor = 0;
+    more = false;
+}
+
+size_t VitalsHistoryGenerator::renderNext(char* out, size_t size) {
+    static const char* COLUMN_NAMES[COLUMN_COUNT] = {"dt", "heartRate", "spO2", "battery"};
+
+    sink.reset(out, size);
+
+    switch (stage) {
+        case STAGE_HEADER:
+            // Resolution is echoed so clients can tell a decimated page from raw data
+            writer.beginObject();
+            writer.key("resolution");
+            writer.value(resolution);
+            writer.key(COLUMN_NAMES[0]);
+            writer.beginArray();
+            stage = STAGE_COLUMN;
+            return sink.getLength();
+
+        case STAGE_COLUMN: {
+            HistorySample sample;
+            if (reader.next(sample)) {
+                switch (column) {
+                    case 0:
+                        if (columnIndex == 0) {
+                            firstTimestamp = sample.timestamp;
+                            previousTimestamp = sample.timestamp;
+                        }
+                        writer.value(sample.timestamp - previousTimestamp);
+                        previousTimestamp = sample.timestamp;
+                        break;
+                    case 1:
+                        writer.value(sample.heartRate, 1);
+                        break;
+                    case 2:
+                        writer.value(sample.spO2, 1);
+                        break;
+                    default:
+                        writer.value((int)(sample.batteryLevel + 0.5f));
+                        break;
+                }
+                columnIndex++;
+                return sink.getLength();
+            }
+
+            // Column finished; the first pass decides count and cursor
+            if (column == 0) {
+                count = columnIndex;
+                nextCursor = reader.getSequence();
+                more = reader.hasMore();
+            }
+
+            writer.endArray();
+            column++;
+            if (column < COLUMN_COUNT) {
+                columnIndex = 0;
+                reader.rewind();
+                writer.key(COLUMN_NAMES[column]);
+                writer.beginArray();
+            } else {
+                stage = STAGE_FOOTER;
+            }
+            return sink.getLength();
+        }
+
+        case STAGE_FOOTER: {
+            stage = STAGE_DONE;
+            writer.key("t0");
+            writer.value(firstTimestamp);
+            writer.key("count");
+            writer.value(count);
+            writer.key("next");
+            char cursor[12];
+            snprintf(cursor, sizeof(cursor), "%u", (unsigned)nextCursor);
+            writer.value(more ? (const char*)cursor : (const char*)nullptr);
+            writer.endObject();
+            return sink.getLength();
+        }
+
+        case STAGE_DONE:
+        default:
+            return 0;
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef VITALS_HISTORY_H
+#define VITALS_HISTORY_H
+
+#include "http_stream.h"
+#include "vitals_log.h"
+
+// Parameters of GET /api/vitals/history
+struct HistoryQuery {
+    uint32_t from;          // Log time, ms (inclusive)
+    uint32_t to;            // Log time, ms (exclusive)
+    uint32_t resolution;    // Bucket width, ms; 0 = every record
+    uint32_t limit;         // Max points per page
+    uint32_t cursor;        // Sequence to resume from; 0 = start at `from`
+    bool hasCursor;
+};
+
+static const uint32_t HISTORY_DEFAULT_LIMIT = 600;
+static const uint32_t HISTORY_MAX_LIMIT = 3600;
+
+// One point of the history; a bucket average when resolution > 0
+struct HistorySample {
+    uint32_t timestamp;
+    float heartRate;
+    float spO2;
+    float batteryLevel;
+};
+
+// Walks the log from a start sequence, averaging records into resolution-wide buckets
+class HistoryBucketReader {
+private:
+    VitalsLog* log;
+    HistoryQuery query;
+    uint32_t startSequence;
+    uint32_t sequence;
+    uint32_t produced;
+
+public:
+    HistoryBucketReader(VitalsLog* vitalsLog, const HistoryQuery& historyQuery, uint32_t start);
+    void rewind();
+    bool next(HistorySample& sample);
+    uint32_t getSequence() { return sequence; }
+    bool hasMore();
+};
+
+// Columnar page of history:
+// {"resolution":R,"dt":[0,1000,...],"heartRate":[...],"spO2":[...],
+//  "battery":[...],"t0":T,"count":N,"next":"<cursor>"|null}
+// Timestamps are t0 plus the running sum of dt. Each column is a separate
+// pass over the same range, so memory stays at one sample.
+class VitalsHistoryGenerator : public ChunkGenerator {
+private:
+    enum Stage { STAGE_HEADER, STAGE_COLUMN, STAGE_FOOTER, STAGE_DONE };
+    static const int COLUMN_COUNT = 4;
+
+    HistoryBucketReader reader;
+    JsonBufferSink sink;
+    JsonWriter<JsonBufferSink> writer;   // Persists nesting state across pieces
+    uint32_t resolution;
+    Stage stage;
+    int column;
+    uint32_t columnIndex;
+    uint32_t previousTimestamp;
+    uint32_t firstTimestamp;
+    uint32_t count;
+    uint32_t nextCursor;
+    bool more;
+
+public:
+    VitalsHistoryGenerator(VitalsLog* vitalsLog, const HistoryQuery& query);
+
+protected:
+    size_t renderNext(char* out, size_t size) override;
+};
+
+// Fills query from request parameters; getParam returns nullptr when absent
+template <typename GetParam>
+void parseHistoryQuery(GetParam getParam, uint32_t now, HistoryQuery& query) {
+    const char* value;
+    query.to = (value = getParam("to")) ? strtoul(value, nullptr, 10) : now + 1;
+    query.from = (value = getParam("from")) ? strtoul(value, nullptr, 10)
+                                            : (query.to > 3600000UL ? query.to - 3600000UL : 0);
+    query.resolution = (value = getParam("resolution")) ? strtoul(value, nullptr, 10) : 0;
+    query.limit = (value = getParam("limit")) ? strtoul(value, nullptr, 10) : HISTORY_DEFAULT_LIMIT;
+    if (query.limit == 0 || query.limit > HISTORY_MAX_LIMIT) query.limit = HISTORY_MAX_LIMIT;
+    query.hasCursor = (value = getParam("cursor")) != nullptr;
+    query.cursor = query.hasCursor ? strtoul(value, nullptr, 10) : 0;
+}
+
+#endif
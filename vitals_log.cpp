@@ -0,0 +1,342 @@
+#include "vitals_log.h"
+#include "metrics.h"
+#include "hal.h"
+
+VitalsLog vitalsLog;
+
+VitalsLog::VitalsLog() {
+    for (int i = 0; i < 2; i++) {
+        segments[i].firstSequence = 0;
+        segments[i].count = 0;
+        segments[i].sealed = false;
+    }
+    activeSegment = 0;
+    indexCount = 0;
+    buffered = 0;
+    nextSequence = 0;
+    timeOffset = 0;
+    ready = false;
+    readCacheFirst = 0;
+    readCacheCount = 0;
+}
+
+bool VitalsLog::begin() {
+    if (!hal.storage->exists("/logs")) {
+        hal.storage->mkdir("/logs");
+    }
+
+    loadSegment(0);
+    loadSegment(1);
+
+    // The segment holding the newest records is the one we append to
+    if (segments[1].count > 0 &&
+        (segments[0].count == 0 || segments[1].firstSequence > segments[0].firstSequence)) {
+        activeSegment = 1;
+    } else {
+        activeSegment = 0;
+    }
+
+    Segment& active = segments[activeSegment];
+    nextSequence = active.firstSequence + active.count;
+    ready = true;
+
+    // Continue log time after the last record so ranges stay ordered across reboots
+    VitalsRecord last;
+    if (nextSequence > 0 && read(nextSequence - 1, last)) {
+        timeOffset = last.timestamp + 1000;
+    }
+
+    rebuildIndex();
+
+    Serial.printf("Vitals log: %u records, next sequence %u\n",
+                  (unsigned)(nextSequence - getFirstSequence()), (unsigned)nextSequence);
+    return true;
+}
+
+void VitalsLog::append(const VitalSigns& vitals) {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    if (!ready) return;
+
+    VitalsRecord& record = writeBuffer[buffered];
+    record.sequence = nextSequence++;
+    record.timestamp = now();
+    record.heartRate = (uint16_t)constrain(vitals.heartRate * 10.0f + 0.5f, 0.0f, 65535.0f);
+    record.spO2 = (uint16_t)constrain(vitals.spO2 * 10.0f + 0.5f, 0.0f, 65535.0f);
+    record.batteryLevel = (uint8_t)constrain(vitals.batteryLevel + 0.5f, 0.0f, 100.0f);
+    record.flags = vitals.isFingerDetected ? VITALS_FLAG_FINGER : 0;
+    record.reserved = 0;
+
+    if (record.sequence % INDEX_STRIDE == 0) {
+        addIndexEntry(record.sequence, record.timestamp);
+    }
+
+    buffered++;
+    if (buffered >= WRITE_BUFFER_RECORDS) {
+        flush();
+    }
+}
+
+void VitalsLog::flush() {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    if (buffered == 0) return;
+    MetricTimer timer(metricLogFlush);
+
+    int written = 0;
+
+    while (written < buffered) {
+        if (segments[activeSegment].count >= SEGMENT_RECORDS || segments[activeSegment].sealed) {
+            rotate();
+        }
+
+        Segment& segment = segments[activeSegment];
+        uint32_t space = SEGMENT_RECORDS - segment.count;
+        int count = min((int)space, buffered - written);
+
+        int file = hal.storage->open(segmentPath(activeSegment), "a");
+        if (file == HAL_INVALID_FILE) {
+            Serial.println("Failed to open vitals log segment");
+            break;
+        }
+
+        if (segment.count == 0) {
+            segment.firstSequence = writeBuffer[written].sequence;
+        }
+        hal.storage->write(file, (const uint8_t*)&writeBuffer[written], count * sizeof(VitalsRecord));
+        hal.storage->close(file);
+
+        segment.count += count;
+        written += count;
+    }
+
+    buffered = 0;
+}
+
+uint32_t VitalsLog::now() {
+    return timeOffset + hal.clock->millis();
+}
+
+uint32_t VitalsLog::getFirstSequence() {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    uint32_t first = nextSequence - buffered;
+    for (int i = 0; i < 2; i++) {
+        if (segments[i].count > 0 && segments[i].firstSequence < first) {
+            first = segments[i].firstSequence;
+        }
+    }
+    return first;
+}
+
+uint32_t VitalsLog::getNextSequence() {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    return nextSequence;
+}
+
+uint32_t VitalsLog::findSequence(uint32_t timestamp) {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    // Last index entry at or before the requested time
+    uint32_t sequence = getFirstSequence();
+    int low = 0, high = indexCount - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        if (index[mid].timestamp <= timestamp) {
+            sequence = index[mid].sequence;
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+
+    // At most INDEX_STRIDE records to scan from there
+    VitalsRecord record;
+    while (sequence < nextSequence && read(sequence, record) && record.timestamp < timestamp) {
+        sequence++;
+    }
+    return sequence;
+}
+
+bool VitalsLog::read(uint32_t sequence, VitalsRecord& record) {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    if (sequence < getFirstSequence() || sequence >= nextSequence) {
+        return false;
+    }
+
+    // Not flushed yet
+    uint32_t firstBuffered = nextSequence - buffered;
+    if (sequence >= firstBuffered) {
+        record = writeBuffer[sequence - firstBuffered];
+        return true;
+    }
+
+    if (sequence < readCacheFirst || sequence >= readCacheFirst + readCacheCount) {
+        if (!fillReadCache(sequence)) {
+            return false;
+        }
+    }
+
+    record = readCache[sequence - readCacheFirst];
+    return true;
+}
+
+VitalSigns VitalsLog::toVitalSigns(const VitalsRecord& record) {
+    VitalSigns vitals;
+    vitals.heartRate = record.heartRate / 10.0f;
+    vitals.spO2 = record.spO2 / 10.0f;
+    vitals.batteryLevel = record.batteryLevel;
+    vitals.isFingerDetected = (record.flags & VITALS_FLAG_FINGER) != 0;
+    vitals.timestamp = record.timestamp;
+    return vitals;
+}
+
+const char* VitalsLog::segmentPath(int segment) {
+    return segment == 0 ? "/logs/vitals.0.bin" : "/logs/vitals.1.bin";
+}
+
+const char* VitalsLog::trimPath(int segment) {
+    return segment == 0 ? "/logs/vitals.0.tmp" : "/logs/vitals.1.tmp";
+}
+
+void VitalsLog::loadSegment(int segment) {
+    segments[segment].firstSequence = 0;
+    segments[segment].count = 0;
+    segments[segment].sealed = false;
+
+    int file = hal.storage->open(segmentPath(segment), "r");
+    if (file == HAL_INVALID_FILE) {
+        // Power cut between removing a torn segment and renaming its trimmed copy
+        if (hal.storage->exists(trimPath(segment)) &&
+            hal.storage->rename(trimPath(segment), segmentPath(segment))) {
+            file = hal.storage->open(segmentPath(segment), "r");
+        }
+        if (file == HAL_INVALID_FILE) return;
+    }
+
+    size_t size = hal.storage->size(file);
+    segments[segment].count = size / sizeof(VitalsRecord);
+    VitalsRecord first;
+    if (segments[segment].count > 0 &&
+        hal.storage->read(file, (uint8_t*)&first, sizeof(first)) == sizeof(first)) {
+        segments[segment].firstSequence = first.sequence;
+    } else {
+        segments[segment].count = 0;
+    }
+    hal.storage->close(file);
+
+    // A torn final record from a power cut would misalign every later append
+    if (size % sizeof(VitalsRecord) != 0) {
+        Serial.printf("Vitals log: trimming %u torn bytes from segment %d\n",
+                      (unsigned)(size % sizeof(VitalsRecord)), segment);
+        if (!trimSegment(segment)) {
+            Serial.println("Vitals log: trim failed, segment sealed");
+            segments[segment].sealed = true;
+        }
+    }
+}
+
+// SPIFFS cannot truncate, so the whole records are copied to a side file
+// that replaces the segment. A copy left by a power cut mid-way is stale
+// and is overwritten; one left after the remove is picked up by loadSegment.
+bool VitalsLog::trimSegment(int segment) {
+    int from = hal.storage->open(segmentPath(segment), "r");
+    int to = hal.storage->open(trimPath(segment), "w");
+
+    size_t remaining = segments[segment].count * sizeof(VitalsRecord);
+    bool copied = from != HAL_INVALID_FILE && to != HAL_INVALID_FILE;
+    while (copied && remaining > 0) {
+        size_t chunk = min(remaining, sizeof(readCache));
+        copied = hal.storage->read(from, (uint8_t*)readCache, chunk) == chunk &&
+                 hal.storage->write(to, (const uint8_t*)readCache, chunk) == chunk;
+        remaining -= chunk;
+    }
+    if (from != HAL_INVALID_FILE) hal.storage->close(from);
+    if (to != HAL_INVALID_FILE) hal.storage->close(to);
+    readCacheCount = 0;
+
+    if (!copied) {
+        hal.storage->remove(trimPath(segment));
+        return false;
+    }
+    return hal.storage->remove(segmentPath(segment)) &&
+           hal.storage->rename(trimPath(segment), segmentPath(segment));
+}
+
+void VitalsLog::rebuildIndex() {
+    indexCount = 0;
+
+    // Older segment first so the index stays sorted by sequence
+    int order[2] = {1 - activeSegment, activeSegment};
+    for (int i = 0; i < 2; i++) {
+        Segment& segment = segments[order[i]];
+        if (segment.count == 0) continue;
+
+        int file = hal.storage->open(segmentPath(order[i]), "r");
+        if (file == HAL_INVALID_FILE) continue;
+
+        uint32_t offset = (INDEX_STRIDE - segment.firstSequence % INDEX_STRIDE) % INDEX_STRIDE;
+        for (; offset < segment.count; offset += INDEX_STRIDE) {
+            VitalsRecord record;
+            hal.storage->seek(file, offset * sizeof(VitalsRecord));
+            if (hal.storage->read(file, (uint8_t*)&record, sizeof(record)) != sizeof(record)) break;
+            addIndexEntry(record.sequence, record.timestamp);
+        }
+        hal.storage->close(file);
+    }
+}
+
+void VitalsLog::addIndexEntry(uint32_t sequence, uint32_t timestamp) {
+    if (indexCount >= INDEX_CAPACITY) {
+        // Only reachable if rotation did not trim; drop the oldest entry
+        memmove(&index[0], &index[1], (INDEX_CAPACITY - 1) * sizeof(IndexEntry));
+        indexCount--;
+    }
+    index[indexCount].sequence = sequence;
+    index[indexCount].timestamp = timestamp;
+    indexCount++;
+}
+
+void VitalsLog::dropIndexBefore(uint32_t sequence) {
+    int keep = 0;
+    while (keep < indexCount && index[keep].sequence < sequence) {
+        keep++;
+    }
+    if (keep > 0) {
+        memmove(&index[0], &index[keep], (indexCount - keep) * sizeof(IndexEntry));
+        indexCount -= keep;
+    }
+}
+
+void VitalsLog::rotate() {
+    // Reuse the older segment; history now starts at the current one
+    int older = 1 - activeSegment;
+    hal.storage->remove(segmentPath(older));
+    segments[older].firstSequence = 0;
+    segments[older].count = 0;
+    segments[older].sealed = false;
+
+    dropIndexBefore(segments[activeSegment].firstSequence);
+    readCacheCount = 0;
+    activeSegment = older;
+}
+
+bool VitalsLog::fillReadCache(uint32_t sequence) {
+    for (int i = 0; i < 2; i++) {
+        Segment& segment = segments[i];
+        if (segment.count == 0 || sequence < segment.firstSequence ||
+            sequence >= segment.firstSequence + segment.count) {
+            continue;
+        }
+
+        int file = hal.storage->open(segmentPath(i), "r");
+        if (file == HAL_INVALID_FILE) return false;
+
+        uint32_t offset = sequence - segment.firstSequence;
+        uint32_t count = min((uint32_t)READ_CACHE_RECORDS, segment.count - offset);
+        hal.storage->seek(file, offset * sizeof(VitalsRecord));
+        size_t bytes = hal.storage->read(file, (uint8_t*)readCache, count * sizeof(VitalsRecord));
+        hal.storage->close(file);
+
+        readCacheFirst = sequence;
+        readCacheCount = bytes / sizeof(VitalsRecord);
+        return readCacheCount > 0;
+    }
+    return false;
+}
@@ -0,0 +1,98 @@
+#ifndef VITALS_LOG_H
+#define VITALS_LOG_H
+
+#include <Arduino.h>
+#include <mutex>
+#include "vital_signs.h"
+
+#define VITALS_FLAG_FINGER 0x01
+
+// Fixed-size on-flash record. Values are scaled to integers to keep it at 16 bytes.
+struct VitalsRecord {
+    uint32_t sequence;      // Monotonic across reboots, never reused
+    uint32_t timestamp;     // Log time in ms, see VitalsLog::now()
+    uint16_t heartRate;     // BPM x10
+    uint16_t spO2;          // % x10
+    uint8_t batteryLevel;   // %
+    uint8_t flags;          // VITALS_FLAG_*
+    uint16_t reserved;
+};
+
+static_assert(sizeof(VitalsRecord) == 16, "VitalsRecord must stay 16 bytes on flash");
+
+// Append-only binary vitals log on flash (hal.storage).
+//
+// Records go to one of two segment files; when the active one is full the
+// older one is deleted and reused, so the log holds between one and two
+// segments of history. A sparse RAM index (one entry per INDEX_STRIDE
+// records) maps log time to sequence numbers for range queries.
+// Safe to call from the loop and from the async web server task.
+class VitalsLog {
+public:
+    static const uint32_t SEGMENT_RECORDS = 16384;   // 256 KB, ~4.5 h at 1 Hz
+    static const uint32_t INDEX_STRIDE = 64;
+    static const int WRITE_BUFFER_RECORDS = 16;
+    static const int READ_CACHE_RECORDS = 16;
+
+private:
+    static const int INDEX_CAPACITY = 2 * SEGMENT_RECORDS / INDEX_STRIDE;
+
+    struct Segment {
+        uint32_t firstSequence;
+        uint32_t count;
+        bool sealed;        // Torn tail that could not be trimmed; never appended to
+    };
+
+    struct IndexEntry {
+        uint32_t sequence;
+        uint32_t timestamp;
+    };
+
+    Segment segments[2];
+    int activeSegment;
+    IndexEntry index[INDEX_CAPACITY];
+    int indexCount;
+
+    VitalsRecord writeBuffer[WRITE_BUFFER_RECORDS];
+    int buffered;
+    uint32_t nextSequence;
+    uint32_t timeOffset;
+    bool ready;
+
+    VitalsRecord readCache[READ_CACHE_RECORDS];
+    uint32_t readCacheFirst;
+    int readCacheCount;
+
+    std::recursive_mutex lock;
+
+public:
+    VitalsLog();
+    bool begin();
+    void append(const VitalSigns& vitals);
+    void flush();
+
+    // Log time: the HAL clock shifted so timestamps keep increasing across reboots
+    uint32_t now();
+
+    uint32_t getFirstSequence();
+    uint32_t getNextSequence();
+    uint32_t findSequence(uint32_t timestamp);
+    bool read(uint32_t sequence, VitalsRecord& record);
+
+    static VitalSigns toVitalSigns(const VitalsRecord& record);
+
+private:
+    static const char* segmentPath(int segment);
+    static const char* trimPath(int segment);
+    void loadSegment(int segment);
+    bool trimSegment(int segment);
+    void rebuildIndex();
+    void addIndexEntry(uint32_t sequence, uint32_t timestamp);
+    void dropIndexBefore(uint32_t sequence);
+    void rotate();
+    bool fillReadCache(uint32_t sequence);
+};
+
+extern VitalsLog vitalsLog;
+
+#endif
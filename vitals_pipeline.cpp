@@ -0,0 +1,173 @@
+#include "vitals_pipeline.h"
+#include "spo2_algorithm.h"
+#include "target_profile.h"
+#include <stdio.h>
+#include <string.h>
+#if !defined(ESP32) && !defined(__AVR__)
+#include <mutex>
+#endif
+
+// ==================== ALARM RULES ====================
+AlarmRules::AlarmRules() {
+    reset();
+}
+
+void AlarmRules::reset() {
+    lastAlarmTime = 0;
+    lastAlarmLevel = AlertLevel::CRITICAL;     // Nothing escalates through the boot cooldown
+}
+
+bool AlarmRules::admit(AlertLevel level, uint32_t now) {
+    if (now - lastAlarmTime < COOLDOWN_MS && level <= lastAlarmLevel) return false;
+    lastAlarmTime = now;
+    lastAlarmLevel = level;
+    return true;
+}
+
+// Takes the candidate unless an earlier kind already gave one as severe
+static void offerAlarm(AlarmEvent& alarm, bool& raised, AlarmKind kind, float value, AlertLevel level) {
+    if (raised && level <= alarm.level) return;
+    alarm.kind = kind;
+    alarm.value = value;
+    alarm.level = level;
+    raised = true;
+}
+
+bool AlarmRules::check(const VitalSigns& vitals, const AlertThresholds& thresholds, uint32_t now, AlarmEvent& alarm) {
+    if (!thresholds.enabled) return false;
+
+    alarm.timestamp = now;
+    alarm.sequence = vitals.sequence;
+    bool raised = false;
+
+    // Heart rate, then SpO2, then battery; the most severe wins, the first on a tie
+    if (vitals.isFingerDetected && vitals.heartRate > 0 &&
+        (vitals.heartRate < thresholds.heartRateMin || vitals.heartRate > thresholds.heartRateMax)) {
+        offerAlarm(alarm, raised, AlarmKind::HEART_RATE, vitals.heartRate,
+                   (vitals.heartRate < 50 || vitals.heartRate > 120) ? AlertLevel::CRITICAL : AlertLevel::WARNING);
+    }
+    if (vitals.isFingerDetected && vitals.spO2 > 0 && vitals.spO2 < thresholds.spO2Min) {
+        offerAlarm(alarm, raised, AlarmKind::SPO2, vitals.spO2,
+                   vitals.spO2 < 90 ? AlertLevel::CRITICAL : AlertLevel::WARNING);
+    }
+    if (vitals.batteryLevel < thresholds.batteryMin) {
+        offerAlarm(alarm, raised, AlarmKind::BATTERY, vitals.batteryLevel,
+                   vitals.batteryLevel < 10 ? AlertLevel::CRITICAL : AlertLevel::WARNING);
+    }
+
+    return raised && admit(alarm.level, now);
+}
+
+size_t formatAlarmMessage(const AlarmEvent& alarm, char* buffer, size_t size) {
+    int length;
+    switch (alarm.kind) {
+        case AlarmKind::HEART_RATE:
+            length = snprintf(buffer, size, "Heart rate: %d BPM", (int)alarm.value);
+            break;
+        case AlarmKind::SPO2:
+            length = snprintf(buffer, size, "Low SpO2: %d%%", (int)alarm.value);
+            break;
+        default:
+            length = snprintf(buffer, size, "Low battery: %d%%", (int)alarm.value);
+            break;
+    }
+    return length < 0 ? 0 : (size_t)length;
+}
+
+const char* alarmKindName(AlarmKind kind) {
+    switch (kind) {
+        case AlarmKind::HEART_RATE: return "heart_rate";
+        case AlarmKind::SPO2: return "spo2";
+        default: return "battery";
+    }
+}
+
+// ==================== PPG ESTIMATOR ====================
+// The estimator's working arrays are BUFFER_SIZE long, whatever it is handed
+static_assert(PpgEstimator::WINDOW_SAMPLES <= BUFFER_SIZE, "PPG window overruns the estimator's buffers");
+static_assert(UnoProfile::PPG_WINDOW <= BUFFER_SIZE && Esp32SpiProfile::PPG_WINDOW <= BUFFER_SIZE,
+              "PPG window overruns the estimator's buffers");
+
+#if !defined(ESP32) && !defined(__AVR__)
+// The library works in an_x / an_y, statics of its own, so two windows at
+// once would write over each other: analyze's workers and the DSP library's
+// handles take turns. On the device one task runs it.
+static std::mutex estimatorLock;
+#endif
+
+template <typename Sample>
+static void estimateWindow(Sample* irBuffer, Sample* redBuffer, int length, VitalSigns& vitals) {
+    int32_t spo2, heartRate;
+    int8_t validSpO2, validHeartRate;
+    {
+#if !defined(ESP32) && !defined(__AVR__)
+        std::lock_guard<std::mutex> guard(estimatorLock);
+#endif
+        maxim_heart_rate_and_oxygen_saturation(irBuffer, length, redBuffer,
+                                               &spo2, &validSpO2, &heartRate, &validHeartRate);
+    }
+
+    if (validHeartRate && heartRate > 0 && heartRate < 200) {
+        vitals.heartRate = heartRate;
+    }
+    if (validSpO2 && spo2 > 0 && spo2 <= 100) {
+        vitals.spO2 = spo2;
+    }
+}
+
+#if !defined(__AVR__)
+void estimatePpgWindow(uint32_t* irBuffer, uint32_t* redBuffer, int length, VitalSigns& vitals) {
+    estimateWindow(irBuffer, redBuffer, length, vitals);
+}
+#endif
+
+#if !defined(ESP32)
+void estimatePpgWindow(uint16_t* irBuffer, uint16_t* redBuffer, int length, VitalSigns& vitals) {
+#if defined(__AVR__)
+    estimateWindow(irBuffer, redBuffer, length, vitals);
+#else
+    // The library has its 16-bit form on AVR only. Its arithmetic is 32-bit
+    // either way, so widened samples give the Uno's results.
+    uint32_t ir[BUFFER_SIZE];
+    uint32_t red[BUFFER_SIZE];
+    for (int i = 0; i < length; i++) {
+        ir[i] = irBuffer[i];
+        red[i] = redBuffer[i];
+    }
+    estimateWindow(ir, red, length, vitals);
+#endif
+}
+#endif
+
+#if !defined(ESP32) && !defined(__AVR__)
+// maxim_heart_rate_and_oxygen_saturation() keeps the valleys in a local, so
+// this repeats the front end it runs before maxim_find_peaks() (DC removed,
+// the signal inverted, a 4-point moving average, the threshold held to
+// 30..60) and calls the library's own maxim_find_peaks(), which only works
+// in the buffers it is given. A plateau running to the end of the window
+// makes it read one past the buffer; in the library that is the next static,
+// a raw red count above any filtered sample, so the copy ends in one too.
+static_assert(PpgEstimator::WINDOW_SAMPLES == BUFFER_SIZE, "the estimator's front end runs over BUFFER_SIZE");
+
+int32_t findPpgValleys(const uint32_t* irBuffer, int32_t* locs, int32_t& count) {
+    int32_t x[BUFFER_SIZE + 1];
+    x[BUFFER_SIZE] = INT32_MAX;
+    uint32_t mean = 0;
+    for (int k = 0; k < BUFFER_SIZE; k++) mean += irBuffer[k];
+    mean /= BUFFER_SIZE;
+    for (int k = 0; k < BUFFER_SIZE; k++) x[k] = -1 * (int32_t)(irBuffer[k] - mean);
+    for (int k = 0; k < BUFFER_SIZE - MA4_SIZE; k++) x[k] = (x[k] + x[k + 1] + x[k + 2] + x[k + 3]) / 4;
+    int32_t threshold = 0;
+    for (int k = 0; k < BUFFER_SIZE; k++) threshold += x[k];
+    threshold /= BUFFER_SIZE;
+    threshold = threshold < 30 ? 30 : (threshold > 60 ? 60 : threshold);
+
+    for (int k = 0; k < PPG_MAX_VALLEYS; k++) locs[k] = 0;
+    count = 0;
+    maxim_find_peaks(locs, &count, x, BUFFER_SIZE, threshold, 4, PPG_MAX_VALLEYS);
+    if (count < 2) return -999;
+    int32_t intervals = 0;
+    for (int k = 1; k < count; k++) intervals += locs[k] - locs[k - 1];
+    return (FreqS * 60) / (intervals / (count - 1));
+}
+#endif
@@ -0,0 +1,146 @@
+#ifndef VITALS_PIPELINE_H
+#define VITALS_PIPELINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "vital_signs.h"
+
+// The sample-to-alarm path of the monitor with no hardware or UI behind it:
+// PPG samples are windowed and run through the MAX3010x estimator, and the
+// resulting vitals are checked against the alarm rules. The sketch feeds it
+// from hal.sensor; bench/replay.cpp feeds it from recordings.
+
+// ==================== ALARM RULES ====================
+struct AlertThresholds {
+    float heartRateMin = 60.0f;
+    float heartRateMax = 100.0f;
+    float spO2Min = 95.0f;
+    float batteryMin = 20.0f;
+    bool enabled = true;
+};
+
+enum class AlertLevel {
+    INFO,
+    WARNING,
+    CRITICAL
+};
+
+enum class AlarmKind : uint8_t {
+    HEART_RATE,
+    SPO2,
+    BATTERY
+};
+
+static const int ALARM_KIND_COUNT = 3;
+
+struct AlarmEvent {
+    AlarmKind kind;
+    AlertLevel level;
+    float value;            // Reading that broke the threshold
+    uint32_t timestamp;     // ms
+    uint32_t sequence;      // VitalSigns::sequence of the reading
+};
+
+// Thresholds come from the settings; the critical limits are fixed. At most
+// one alarm is raised per cooldown, across all kinds, unless it is more
+// severe than the one that started the cooldown: a critical reading is not
+// held back by the warning raised on its way down. The first alarm cannot
+// fire until the cooldown has passed after boot.
+class AlarmRules {
+public:
+    static const uint32_t COOLDOWN_MS = 5000;
+
+private:
+    uint32_t lastAlarmTime;
+    AlertLevel lastAlarmLevel;
+
+public:
+    AlarmRules();
+    // Checks one reading; returns true and fills `alarm` when one is raised
+    bool check(const VitalSigns& vitals, const AlertThresholds& thresholds, uint32_t now, AlarmEvent& alarm);
+    // For alarms raised outside check(): returns true and starts the shared
+    // cooldown, or false while one holds back an alarm of this level
+    bool admit(AlertLevel level, uint32_t now);
+    void reset();
+};
+
+// "Heart rate: 42 BPM" etc., as shown on screen and logged
+size_t formatAlarmMessage(const AlarmEvent& alarm, char* buffer, size_t size);
+const char* alarmKindName(AlarmKind kind);
+
+// ==================== PPG ESTIMATOR ====================
+// Runs the MAX3010x heart rate / SpO2 estimator over a full window of
+// samples and updates `vitals` with what it accepts. The 16-bit form is
+// SparkFun's AVR entry point, so each exists where the library has it.
+#if !defined(__AVR__)
+void estimatePpgWindow(uint32_t* irBuffer, uint32_t* redBuffer, int length, VitalSigns& vitals);
+#endif
+#if !defined(ESP32)
+void estimatePpgWindow(uint16_t* irBuffer, uint16_t* redBuffer, int length, VitalSigns& vitals);
+#endif
+
+// Collects MAX30102 samples into a window and runs the estimator each time
+// it fills. Finger presence follows every sample. The window length and
+// sample width come from the target profile; PpgEstimator is the ESP32's.
+template <int WINDOW, typename Sample>
+class BasicPpgEstimator {
+public:
+    static const int WINDOW_SAMPLES = WINDOW;
+    static const uint32_t FINGER_THRESHOLD = 50000;
+    // The MAX30102 gives 18-bit readings; a narrower window keeps their top
+    // bits, which leaves the pulse shape and the red/IR ratios as they were
+    static const int SAMPLE_SHIFT = sizeof(Sample) < 4 ? 18 - 8 * (int)sizeof(Sample) : 0;
+
+private:
+    Sample irBuffer[WINDOW];
+    Sample redBuffer[WINDOW];
+    int count;
+    bool fingerDetected;
+
+public:
+    BasicPpgEstimator() { reset(); }
+
+    // Adds one sample; returns true when it completed a window and the
+    // heart rate / SpO2 in `vitals` were re-estimated
+    bool addSample(uint32_t red, uint32_t ir, VitalSigns& vitals) {
+        redBuffer[count] = (Sample)(red >> SAMPLE_SHIFT);
+        irBuffer[count] = (Sample)(ir >> SAMPLE_SHIFT);
+        fingerDetected = ir > FINGER_THRESHOLD;
+        vitals.isFingerDetected = fingerDetected;
+
+        if (++count < WINDOW) return false;
+        count = 0;
+
+        if (fingerDetected) {
+            estimatePpgWindow(irBuffer, redBuffer, WINDOW, vitals);
+        } else {
+            vitals.heartRate = 0;
+            vitals.spO2 = 0;
+        }
+        return true;
+    }
+
+    void reset() {
+        count = 0;
+        fingerDetected = false;
+        memset(irBuffer, 0, sizeof(irBuffer));
+        memset(redBuffer, 0, sizeof(redBuffer));
+    }
+
+    bool isFingerDetected() const { return fingerDetected; }
+};
+
+typedef BasicPpgEstimator<100, uint32_t> PpgEstimator;
+
+#if !defined(ESP32) && !defined(__AVR__)
+// The IR valleys the estimator finds in a full PpgEstimator window, whose
+// mean spacing is the heart rate it reports: up to PPG_MAX_VALLEYS sample
+// indices into `irBuffer`, in `locs`. Returns that heart rate, or -999 with
+// fewer than two valleys, as the estimator does. These are the monitor's
+// beats; the host tools score and time them, the device has no use for them.
+static const int PPG_MAX_VALLEYS = 15;
+int32_t findPpgValleys(const uint32_t* irBuffer, int32_t* locs, int32_t& count);
+#endif
+
+#endif
@@ -1,71 +1,197 @@
 #include "web_interface.h"
+#include "metrics.h"
+#include "memory_accounting.h"
 
 WebInterface webInterface;
 
-WebInterface::WebInterface() : server(80), ws("/ws") {
+extern VitalSigns& currentVitals;
+
+// A pool frame queued to one client as it is: the frame's bytes and its
+// header go to TCP without ASYNC_WRITE_FLAG_COPY, and the message holds a
+// reference to the frame until the client's TCP has acknowledged them.
+// Messages come from a fixed slab, one per client per pool frame, so the
+// only heap a broadcast takes is AsyncWebSocket's queue node per client.
+class FrameMessage : public AsyncWebSocketMessage {
+private:
+    WsFrame *frame;
+    uint8_t header[4];  // The fragment in flight's; sent once the last is acked
+    size_t sent;        // Payload bytes handed to TCP
+    size_t expected;    // Header and payload bytes handed to TCP
+    size_t acked;
+
+public:
+    explicit FrameMessage(WsFrame *sharedFrame) : frame(sharedFrame), sent(0), expected(0), acked(0) {
+        _status = WS_MSG_SENDING;
+        wsFramePool.retain(frame);
+    }
+    ~FrameMessage() override { wsFramePool.release(frame); }
+
+    // nullptr once the slab is used up; the caller copies instead
+    static void *operator new(size_t size) noexcept;
+    static void operator delete(void *message) noexcept;
+
+    bool betweenFrames() const override { return acked == expected; }
+
+    void ack(size_t len, uint32_t time) override {
+        (void)time;
+        acked += len;
+        if (sent == frame->length && acked == expected) _status = WS_MSG_SENT;
+    }
+
+    size_t send(AsyncClient *client) override {
+        if (_status != WS_MSG_SENDING || acked < expected) return 0;
+        if (sent == frame->length) {
+            _status = WS_MSG_SENT;
+            return 0;
+        }
+        // As AsyncWebSocket fragments: what fits the window less a header
+        size_t space = client->space();
+        if (!client->canSend() || space < 9) return 0;
+        size_t toSend = frame->length - sent;
+        if (toSend > space - 8) toSend = space - 8;
+        
+        header[0] = (sent == 0 ? WS_TEXT : WS_CONTINUATION) | (sent + toSend == frame->length ? 0x80 : 0);
+        size_t headLen = 2;
+        if (toSend < 126) {
+            header[1] = toSend;
+        } else {
+            header[1] = 126;
+            header[2] = (uint8_t)(toSend >> 8);
+            header[3] = (uint8_t)toSend;
+            headLen = 4;
+        }
+        if (client->add((const char *)header, headLen, 0) != headLen) return 0;
+        client->add(frame->data + sent, toSend, 0);
+        client->send();
+        sent += toSend;
+        expected += headLen + toSend;
+        return toSend;
+    }
+};
+
+static const int FRAME_MESSAGE_SLOTS = WsClientTable::MAX_CLIENTS * WsFramePool::POOL_SIZE;
+alignas(FrameMessage) static uint8_t frameMessageSlab[FRAME_MESSAGE_SLOTS][sizeof(FrameMessage)];
+static std::atomic<uint8_t> frameMessageInUse[FRAME_MESSAGE_SLOTS];
+
+void *FrameMessage::operator new(size_t size) noexcept {
+    (void)size;
+    for (int i = 0; i < FRAME_MESSAGE_SLOTS; i++) {
+        uint8_t expected = 0;
+        if (frameMessageInUse[i].compare_exchange_strong(expected, 1)) {
+            return frameMessageSlab[i];
+        }
+    }
+    return nullptr;
+}
+
+void FrameMessage::operator delete(void *message) noexcept {
+    int slot = ((uint8_t *)message - frameMessageSlab[0]) / sizeof(FrameMessage);
+    frameMessageInUse[slot].store(0);
+}
+
+// An AsyncWebSocketClient as the client table drives it
+class AsyncWsPeer : public WsPeer {
+private:
+    AsyncWebSocketClient *client;
+
+public:
+    AsyncWsPeer() : client(nullptr) {}
+    void bind(AsyncWebSocketClient *wsClient) { client = wsClient; }
+
+    uint32_t id() override { return client->id(); }
+    bool queueIsFull() override { return client->queueIsFull(); }
+    size_t sendSpace() override { return client->client()->space(); }
+    void close() override { client->close(); }
+
+    void sendFrame(WsFrame *frame) override {
+        // A spare frame is gone when the broadcast returns, and the slab
+        // runs out only if the pool does: both are copied
+        FrameMessage *message = wsFramePool.owns(frame) ? new FrameMessage(frame) : nullptr;
+        if (message) {
+            client->message(message);
+        } else {
+            client->text(frame->data, frame->length);
+        }
+    }
+
+    void sendText(const char *data, size_t length) override {
+        client->text(data, length);
+    }
+
+    size_t sendBacklog() override {
+        size_t space = client->client()->space();
+        return space < CONFIG_TCP_SND_BUF_DEFAULT ? CONFIG_TCP_SND_BUF_DEFAULT - space : 0;
+    }
+};
+
+WebInterface::WebInterface() : server(PORT), ws("/ws") {
+    clientsLock = nullptr;
+    serviceTask = nullptr;
 }
 
-void WebInterface::begin() {
+void WebInterface::begin(bool withServiceTask) {
     // Setup WebSocket
     ws.onEvent([this](AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
         this->onEvent(server, client, type, arg, data, len);
     });
     server.addHandler(&ws);
-    
-    setupRoutes();
     server.begin();
     
-    Serial.println("Web server started on port 80");
+    // The client table is shared by AsyncTCP's task (connects, subscriptions),
+    // the broadcasting task and the service task below
+    clientsLock = xSemaphoreCreateMutex();
+    if (withServiceTask) {
+        const uint32_t stackBytes = 3072;
+        xTaskCreatePinnedToCore(serviceTaskEntry, "ws_clients", stackBytes, this, 1, &serviceTask, 1);
+        memoryTrackTask("ws_clients", serviceTask, stackBytes);
+    }
+    
+    Serial.printf("WebSocket feed on port %u\n", PORT);
 }
 
-void WebInterface::setupRoutes() {
-    // Serve static files from SPIFFS
-    server.serveStatic("/", SPIFFS, "/www/").setDefaultFile("index.html");
-    
-    // API endpoints
-    server.on("/api/vitals", HTTP_GET, [this](AsyncWebServerRequest *request) {
-        request->send(200, "application/json", getVitalSignsJSON());
-    });
-    
-    server.on("/api/status", HTTP_GET, [this](AsyncWebServerRequest *request) {
-        request->send(200, "application/json", getSystemStatusJSON());
-    });
-    
-    server.on("/api/logs", HTTP_GET, [this](AsyncWebServerRequest *request) {
-        if (SPIFFS.exists("/logs/vitals.json")) {
-            request->send(SPIFFS, "/logs/vitals.json", "application/json");
-        } else {
-            request->send(404, "text/plain", "Log file not found");
-        }
-    });
-    
-    // Settings endpoint
-    server.on("/api/settings", HTTP_POST, [this](AsyncWebServerRequest *request) {
-        // Handle settings update
-        request->send(200, "text/plain", "Settings updated");
-    });
-    // Settings endpoint
-    server.on("/api/settings", HTTP_POST, [this](AsyncWebServerRequest *request) {
-        // Handle settings update
-        request->send(200, "text/plain", "Settings updated");
-    });
-    
-    // Handle 404
-    server.onNotFound([](AsyncWebServerRequest *request) {
-        request->send(404, "text/plain", "Not found");
-    });
+void WebInterface::serviceTaskEntry(void* param) {
+    WebInterface* web = static_cast<WebInterface*>(param);
+    while (true) {
+        web->handleClients();
+        vTaskDelay(pdMS_TO_TICKS(SERVICE_INTERVAL));
+    }
+}
+
+// Wraps the connected clients for the client table; at most MAX_CLIENTS,
+// which is all cleanupClients() leaves
+int WebInterface::collectPeers(AsyncWsPeer* peers, WsPeer** list) {
+    int count = 0;
+    for (const auto& client : ws.getClients()) {
+        if (client->status() != WS_CONNECTED || count == WsClientTable::MAX_CLIENTS) continue;
+        peers[count].bind(client);
+        list[count] = &peers[count];
+        count++;
+    }
+    return count;
 }
 
 void WebInterface::onEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
     switch (type) {
-        case WS_EVT_CONNECT:
+        case WS_EVT_CONNECT: {
+            xSemaphoreTake(clientsLock, portMAX_DELAY);
+            bool attached = wsClients.attach(client->id());
+            xSemaphoreGive(clientsLock);
+            if (!attached) {
+                Serial.printf("WebSocket client #%u rejected, table full\n", client->id());
+                client->close();
+                break;
+            }
             Serial.printf("WebSocket client #%u connected from %s\n", client->id(), client->remoteIP().toString().c_str());
             break;
+        }
         case WS_EVT_DISCONNECT:
+            xSemaphoreTake(clientsLock, portMAX_DELAY);
+            wsClients.detach(client->id());
+            xSemaphoreGive(clientsLock);
             Serial.printf("WebSocket client #%u disconnected\n", client->id());
             break;
         case WS_EVT_DATA:
-            handleWebSocketMessage(arg, data, len);
+            handleWebSocketMessage(client, arg, data, len);
             break;
         case WS_EVT_PONG:
         case WS_EVT_ERROR:
@@ -73,74 +199,155 @@ void WebInterface::onEvent(AsyncWebSocket *server, AsyncWebSocketClient *client,
     }
 }
 
-void WebInterface::handleWebSocketMessage(void *arg, uint8_t *data, size_t len) {
+void WebInterface::handleWebSocketMessage(AsyncWebSocketClient *client, void *arg, uint8_t *data, size_t len) {
     AwsFrameInfo *info = (AwsFrameInfo*)arg;
     if (info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT) {
-        data[len] = 0;
-        String message = (char*)data;
-        
-        DynamicJsonDocument doc(1024);
-        DeserializationError error = deserializeJson(doc, message);
-        
-        if (!error) {
-            String command = doc["command"];
-            if (command == "getVitals") {
-                ws.textAll(getVitalSignsJSON());
-            } else if (command == "getStatus") {
-                ws.textAll(getSystemStatusJSON());
+        // Read in place from AsyncWebSocket's receive buffer: no document,
+        // so no size limit short of the frame itself
+        const char* json = (const char*)data;
+        bool subscribe;
+        uint8_t channels;
+        if (readSubscription(json, len, subscribe, channels)) {
+            xSemaphoreTake(clientsLock, portMAX_DELAY);
+            WsClientState* state = wsClients.find(client->id());
+            if (state && subscribe) {
+                wsClients.subscribe(state, channels);
+            } else if (state) {
+                wsClients.unsubscribe(state, channels);
             }
+            xSemaphoreGive(clientsLock);
+            return;
+        }
+        
+        char command[32];
+        if (!readCommand(json, len, command, sizeof(command))) return;
+        char reply[192];
+        size_t length = 0;
+        if (strcmp(command, "getVitals") == 0) {
+            length = jsonSerialize(currentVitals, reply, sizeof(reply));
+        } else if (strcmp(command, "getStatus") == 0) {
+            length = jsonSerialize(getSystemStatus(), reply, sizeof(reply));
+        }
+        if (length > 0 && length < sizeof(reply)) {
+            client->text(reply, length);
         }
     }
 }
 
 void WebInterface::broadcastVitalSigns(float heartRate, float spO2, float battery, bool fingerDetected) {
-    DynamicJsonDocument doc(512);
-    doc["type"] = "vitals";
-    doc["heartRate"] = heartRate;
-    doc["spO2"] = spO2;
-    doc["battery"] = battery;
-    doc["fingerDetected"] = fingerDetected;
-    doc["timestamp"] = millis();
+    if (ws.count() == 0) return;
+    
+    WsFrame spare;
+    WsFrame* frame = acquireFrame(spare);
     
-    String jsonString;
-    serializeJson(doc, jsonString);
-    ws.textAll(jsonString);
+    VitalSigns vitals;
+    vitals.heartRate = heartRate;
+    vitals.spO2 = spO2;
+    vitals.batteryLevel = battery;
+    vitals.isFingerDetected = fingerDetected;
+    vitals.timestamp = millis();
+    
+    frame->length = jsonSerialize<VitalsMessageSchema>(vitals, frame->data, WsFrame::CAPACITY);
+    broadcastFrame(frame, WS_CHANNEL_VITALS);
 }
 
-void WebInterface::sendAlert(String alertMessage) {
-    DynamicJsonDocument doc(256);
-    doc["type"] = "alert";
-    doc["message"] = alertMessage;
-    doc["timestamp"] = millis();
+void WebInterface::broadcastWaveform(const float* samples, int count) {
+    if (ws.count() == 0) return;
+    
+    WsFrame spare;
+    WsFrame* frame = acquireFrame(spare);
+    
+    JsonBufferSink sink(frame->data, WsFrame::CAPACITY);
+    JsonWriter<JsonBufferSink> writer(sink);
+    writer.beginObject();
+    writer.key("type");
+    writer.value("waveform");
+    writer.key("timestamp");
+    writer.value(millis());
+    writer.key("data");
+    writer.beginArray();
+    for (int i = 0; i < count; i++) {
+        writer.value((int)samples[i]);
+    }
+    writer.endArray();
+    writer.endObject();
+    sink.finish();
     
-    String jsonString;
-    serializeJson(doc, jsonString);
-    ws.textAll(jsonString);
+    frame->length = sink.getLength();
+    broadcastFrame(frame, WS_CHANNEL_WAVEFORM);
 }
 
-String WebInterface::getVitalSignsJSON() {
-    extern VitalSigns currentVitals;
+void WebInterface::broadcastStatus() {
+    if (ws.count() == 0) return;
+    
+    WsFrame spare;
+    WsFrame* frame = acquireFrame(spare);
+    
+    frame->length = jsonSerialize<StatusMessageSchema>(getSystemStatus(), frame->data, WsFrame::CAPACITY);
+    broadcastFrame(frame, WS_CHANNEL_STATUS);
+}
+
+void WebInterface::sendAlert(String alertMessage) {
+    AlertMessage alert;
+    alert.message = alertMessage.c_str();
+    alert.timestamp = millis();
     
-    DynamicJsonDocument doc(512);
-    doc["heartRate"] = currentVitals.heartRate;
-    doc["spO2"] = currentVitals.spO2;
-    doc["batteryLevel"] = currentVitals.batteryLevel;
-    doc["isFingerDetected"] = currentVitals.isFingerDetected;
-    doc["timestamp"] = currentVitals.timestamp;
+    WsFrame spare;
+    WsFrame* frame = acquireFrame(spare);
+    frame->length = jsonSerialize(alert, frame->data, WsFrame::CAPACITY);
+    broadcastFrame(frame, WS_CHANNEL_ALERTS);
+}
+
+WsFrame* WebInterface::acquireFrame(WsFrame& spare) {
+    // Clients hold a pool frame until their TCP has acknowledged it. With
+    // every frame held, one on the caller's stack takes this broadcast and
+    // each client gets a copy of it.
+    WsFrame* frame = wsFramePool.acquire(&spare);
+    if (frame == &spare) {
+        Serial.println("WS frame pool exhausted, broadcasting from the stack");
+    }
+    return frame;
+}
+
+void WebInterface::broadcastFrame(WsFrame* frame, WsChannel channel) {
+    if (frame->length > 0 && frame->length < WsFrame::CAPACITY) {
+        AsyncWsPeer peers[WsClientTable::MAX_CLIENTS];
+        WsPeer* list[WsClientTable::MAX_CLIENTS];
+        xSemaphoreTake(clientsLock, portMAX_DELAY);
+        int count = collectPeers(peers, list);
+        wsClients.broadcast(frame, channel, list, count, millis());
+        xSemaphoreGive(clientsLock);
+    }
     
-    String jsonString;
-    serializeJson(doc, jsonString);
-    return jsonString;
+    // The broadcaster's reference; the clients' go as their TCP acks
+    wsFramePool.release(frame);
 }
 
-String WebInterface::getSystemStatusJSON() {
-    DynamicJsonDocument doc(512);
-    doc["wifiConnected"] = WiFi.status() == WL_CONNECTED;
-    doc["freeHeap"] = ESP.getFreeHeap();
-    doc["uptime"] = millis();
-    doc["version"] = "1.0.0";
+void WebInterface::handleClients() {
+    AsyncWsPeer peers[WsClientTable::MAX_CLIENTS];
+    WsPeer* list[WsClientTable::MAX_CLIENTS];
+    WsServiceStats stats;
+    
+    xSemaphoreTake(clientsLock, portMAX_DELAY);
+    int count = collectPeers(peers, list);
+    wsClients.service(list, count, millis(), stats);
+    xSemaphoreGive(clientsLock);
     
-    String jsonString;
-    serializeJson(doc, jsonString);
-    return jsonString;
+    if (stats.evicted > 0) {
+        Serial.printf("Evicted %d WebSocket clients stalled for over %lu ms\n",
+                      stats.evicted, WsClientTable::SLOW_CLIENT_TIMEOUT);
+    }
+    metricWsQueueBytes.set(stats.maxBacklog);
+    metricWsHeldAlerts.set(stats.heldAlerts);
+    ws.cleanupClients(WsClientTable::MAX_CLIENTS);
+}
+
+SystemStatus WebInterface::getSystemStatus() {
+    SystemStatus status;
+    status.wifiConnected = WiFi.status() == WL_CONNECTED;
+    status.freeHeap = ESP.getFreeHeap();
+    status.uptime = millis();
+    status.version = "1.0.0";
+    status.clients = wsClients.getClientCount();
+    return status;
 }
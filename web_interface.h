@@ -4,26 +4,45 @@
 #include <WiFi.h>
 #include <AsyncTCP.h>
 #include <ESPAsyncWebServer.h>
-#include <ArduinoJson.h>
-#include <SPIFFS.h>
+#include "ws_frame_pool.h"
+#include "ws_clients.h"
+#include "vital_signs.h"
+#include "ws_messages.h"
 
+class AsyncWsPeer;
+
+// The dashboard's live feed on ws://<device>:81/ws. Plain HTTP on port 80,
+// the dashboard's files included, is the sketch's WebServer
+// (cardiac_monitor_complete.ino).
 class WebInterface {
 private:
+    static const uint16_t PORT = 81;
+    static const uint32_t SERVICE_INTERVAL = 100; // ms between handleClients() passes
     AsyncWebServer server;
     AsyncWebSocket ws;
+    SemaphoreHandle_t clientsLock;  // Guards wsClients
+    TaskHandle_t serviceTask;
     
 public:
     WebInterface();
-    void begin();
-    void handleWebSocketMessage(void *arg, uint8_t *data, size_t len);
+    // Starts the server and, unless the caller runs handleClients() itself
+    // (the native tests), a task that runs it every SERVICE_INTERVAL ms
+    void begin(bool withServiceTask = true);
+    // Slow-consumer eviction, held-alert flush and the WebSocket metrics
+    void handleClients();
+    void handleWebSocketMessage(AsyncWebSocketClient *client, void *arg, uint8_t *data, size_t len);
     void onEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len);
     void broadcastVitalSigns(float heartRate, float spO2, float battery, bool fingerDetected);
+    void broadcastWaveform(const float* samples, int count);
+    void broadcastStatus();
     void sendAlert(String alertMessage);
     
 private:
-    void setupRoutes();
-    String getVitalSignsJSON();
-    String getSystemStatusJSON();
+    static void serviceTaskEntry(void* param);
+    int collectPeers(AsyncWsPeer* peers, WsPeer** list);
+    WsFrame* acquireFrame(WsFrame& spare);
+    void broadcastFrame(WsFrame* frame, WsChannel channel);
+    SystemStatus getSystemStatus();
 };
 
 extern WebInterface webInterface;
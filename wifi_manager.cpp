@@ -0,0 +1,158 @@
+#include "wifi_manager.h"
+#include <string.h>
+
+WifiManager::WifiManager() : eventHead(0), eventTail(0), eventsLost(false) {
+    driver = nullptr;
+    callback = nullptr;
+    eventFilter = nullptr;
+    ssid[0] = '\0';
+    password[0] = '\0';
+    state = WifiState::IDLE;
+    stateSince = 0;
+    backoff = BACKOFF_MIN;
+    currentBackoff = 0;
+    failures = 0;
+    everConnected = false;
+}
+
+void WifiManager::begin(WifiDriver* wifiDriver, const char* networkSsid, const char* networkPassword,
+                        StateCallback stateCallback, uint32_t now) {
+    driver = wifiDriver;
+    callback = stateCallback;
+    strncpy(ssid, networkSsid, sizeof(ssid) - 1);
+    ssid[sizeof(ssid) - 1] = '\0';
+    strncpy(password, networkPassword, sizeof(password) - 1);
+    password[sizeof(password) - 1] = '\0';
+
+    if (ssid[0] != '\0') {
+        attempt(now);
+    }
+}
+
+void WifiManager::notifyConnected() {
+    pushEvent(EVENT_CONNECTED);
+}
+
+void WifiManager::notifyDisconnected() {
+    pushEvent(EVENT_DISCONNECTED);
+}
+
+void WifiManager::update(uint32_t now) {
+    // Every event since the last update in order, then the timeouts
+    for (int i = 0; i <= EVENT_QUEUE_SIZE; i++) {
+        uint8_t event = takeEvent();
+        if (eventFilter) event = eventFilter(event);
+        if (event == EVENT_NONE) break;
+        handle(event, now);
+    }
+    handle(EVENT_NONE, now);
+}
+
+void WifiManager::pushEvent(uint8_t event) {
+    uint8_t head = eventHead.load(std::memory_order_relaxed);
+    if ((uint8_t)(head - eventTail.load(std::memory_order_acquire)) >= EVENT_QUEUE_SIZE) {
+        eventsLost.store(true);
+        return;
+    }
+    events[head % EVENT_QUEUE_SIZE] = event;
+    eventHead.store(head + 1, std::memory_order_release);
+}
+
+uint8_t WifiManager::takeEvent() {
+    uint8_t tail = eventTail.load(std::memory_order_relaxed);
+    if (tail == eventHead.load(std::memory_order_acquire)) {
+        // The queue overflowed: whatever was lost, a disconnect makes the
+        // state machine associate again, which recovers from all of it
+        return eventsLost.exchange(false) ? EVENT_DISCONNECTED : EVENT_NONE;
+    }
+    uint8_t event = events[tail % EVENT_QUEUE_SIZE];
+    eventTail.store(tail + 1, std::memory_order_release);
+    return event;
+}
+
+void WifiManager::clearEvents() {
+    eventTail.store(eventHead.load(std::memory_order_acquire), std::memory_order_release);
+    eventsLost.store(false);
+}
+
+void WifiManager::handle(uint8_t event, uint32_t now) {
+    switch (state) {
+        case WifiState::CONNECTING:
+            if (event == EVENT_CONNECTED) {
+                failures = 0;
+                backoff = BACKOFF_MIN;
+                everConnected = true;
+                enter(WifiState::CONNECTED, now);
+            } else if (event == EVENT_DISCONNECTED || now - stateSince >= CONNECT_TIMEOUT) {
+                fail(now);
+            }
+            break;
+
+        case WifiState::CONNECTED:
+            // Dropped: try again straight away, back off only if that fails
+            if (event == EVENT_DISCONNECTED) {
+                attempt(now);
+            }
+            break;
+
+        case WifiState::BACKOFF:
+            if (now - stateSince >= currentBackoff) {
+                attempt(now);
+            }
+            break;
+
+        case WifiState::IDLE:
+        case WifiState::PORTAL:
+        default:
+            break;
+    }
+}
+
+void WifiManager::openPortal(uint32_t now) {
+    if (state == WifiState::PORTAL) return;
+    if (driver && state != WifiState::IDLE) {
+        driver->disconnect();
+    }
+    enter(WifiState::PORTAL, now);
+}
+
+const char* WifiManager::stateName(WifiState state) {
+    switch (state) {
+        case WifiState::IDLE: return "idle";
+        case WifiState::CONNECTING: return "connecting";
+        case WifiState::CONNECTED: return "connected";
+        case WifiState::BACKOFF: return "backoff";
+        case WifiState::PORTAL: return "portal";
+    }
+    return "unknown";
+}
+
+void WifiManager::enter(WifiState next, uint32_t now) {
+    WifiState previous = state;
+    state = next;
+    stateSince = now;
+    if (callback && previous != next) {
+        callback(previous, next);
+    }
+}
+
+void WifiManager::attempt(uint32_t now) {
+    // Drop any event left over from the previous association
+    clearEvents();
+    driver->connect(ssid, password);
+    enter(WifiState::CONNECTING, now);
+}
+
+void WifiManager::fail(uint32_t now) {
+    failures++;
+    driver->disconnect();
+
+    if (!everConnected && failures >= PORTAL_AFTER_FAILURES) {
+        enter(WifiState::PORTAL, now);
+        return;
+    }
+
+    currentBackoff = backoff;
+    backoff = backoff * 2 > BACKOFF_MAX ? BACKOFF_MAX : backoff * 2;
+    enter(WifiState::BACKOFF, now);
+}
@@ -0,0 +1,100 @@
+#ifndef WIFI_MANAGER_H
+#define WIFI_MANAGER_H
+
+#include <stdint.h>
+#include <atomic>
+
+enum class WifiState {
+    IDLE,        // No credentials
+    CONNECTING,  // Association in progress, waiting for an event or timeout
+    CONNECTED,
+    BACKOFF,     // Waiting before the next attempt
+    PORTAL       // Access point + captive portal for configuration
+};
+
+// The radio operations the state machine issues. Both must return at once;
+// the outcome arrives later through notifyConnected()/notifyDisconnected().
+class WifiDriver {
+public:
+    virtual ~WifiDriver() {}
+    virtual void connect(const char* ssid, const char* password) = 0;
+    virtual void disconnect() = 0;
+};
+
+// Event-driven WiFi connection management. update() is called from the main
+// loop and never blocks, so acquisition, display and alarms keep running
+// while a connection is attempted.
+//
+// Failed attempts back off exponentially. If the monitor has never been
+// connected since boot, repeated failures open the captive portal, as the
+// credentials are probably wrong; after a connection has once worked it
+// keeps retrying instead, so a ward-wide outage does not leave every
+// monitor sitting in AP mode.
+class WifiManager {
+public:
+    static const uint32_t CONNECT_TIMEOUT = 10000;
+    static const uint32_t BACKOFF_MIN = 1000;
+    static const uint32_t BACKOFF_MAX = 60000;
+    static const int PORTAL_AFTER_FAILURES = 3;
+    static const int EVENT_QUEUE_SIZE = 8;     // Power of two
+
+    enum Event : uint8_t { EVENT_NONE, EVENT_CONNECTED, EVENT_DISCONNECTED };
+
+    typedef void (*StateCallback)(WifiState previous, WifiState current);
+    // Sees each event as update() takes it and returns the one to act on;
+    // the input journal records and replays events through it
+    typedef uint8_t (*EventFilter)(uint8_t event);
+
+private:
+    WifiDriver* driver;
+    StateCallback callback;
+    EventFilter eventFilter;
+    char ssid[33];
+    char password[65];
+
+    WifiState state;
+    uint32_t stateSince;
+    uint32_t backoff;
+    uint32_t currentBackoff;
+    int failures;
+    bool everConnected;
+
+    // Written by the WiFi event task, consumed in order by update(): a drop
+    // and reconnect between two updates are both seen
+    uint8_t events[EVENT_QUEUE_SIZE];
+    std::atomic<uint8_t> eventHead;
+    std::atomic<uint8_t> eventTail;
+    std::atomic<bool> eventsLost;
+
+public:
+    WifiManager();
+    void begin(WifiDriver* wifiDriver, const char* ssid, const char* password,
+               StateCallback stateCallback, uint32_t now);
+    void update(uint32_t now);
+
+    // Safe to call from any one task
+    void notifyConnected();
+    void notifyDisconnected();
+
+    void setEventFilter(EventFilter filter) { eventFilter = filter; }
+
+    // User asked for the configuration portal
+    void openPortal(uint32_t now);
+
+    WifiState getState() { return state; }
+    bool isConnected() { return state == WifiState::CONNECTED; }
+    int getFailures() { return failures; }
+    uint32_t getBackoff() { return currentBackoff; }
+    static const char* stateName(WifiState state);
+
+private:
+    void pushEvent(uint8_t event);
+    uint8_t takeEvent();
+    void clearEvents();
+    void handle(uint8_t event, uint32_t now);
+    void enter(WifiState next, uint32_t now);
+    void attempt(uint32_t now);
+    void fail(uint32_t now);
+};
+
+#endif
@@ -0,0 +1,318 @@
+#include "ws_clients.h"
+#include "json_reader.h"
+
+WsClientTable wsClients;
+
+// Default subscription keeps the existing dashboard working without a subscribe message
+static const uint8_t DEFAULT_SUBSCRIPTIONS = WS_CHANNEL_VITALS | WS_CHANNEL_ALERTS;
+
+WsClientTable::WsClientTable() {
+    evictedCount = 0;
+    for (int i = 0; i < MAX_HELD_ALERTS; i++) {
+        heldAlerts[i].length = 0;
+        heldAlerts[i].inUse = false;
+    }
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        clients[i].inUse = false;
+        clients[i].pendingCount = 0;
+        resetSlot(&clients[i]);
+    }
+}
+
+bool WsClientTable::attach(uint32_t clientId) {
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (!clients[i].inUse) {
+            resetSlot(&clients[i]);
+            clients[i].clientId = clientId;
+            clients[i].inUse = true;
+            return true;
+        }
+    }
+    return false; // Table full, caller should refuse the client
+}
+
+void WsClientTable::detach(uint32_t clientId) {
+    WsClientState* state = find(clientId);
+    if (state) {
+        state->inUse = false;
+        resetSlot(state);
+    }
+}
+
+WsClientState* WsClientTable::find(uint32_t clientId) {
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (clients[i].inUse && clients[i].clientId == clientId) {
+            return &clients[i];
+        }
+    }
+    return nullptr;
+}
+
+void WsClientTable::subscribe(WsClientState* state, uint8_t channels) {
+    state->subscriptions |= channels;
+}
+
+void WsClientTable::unsubscribe(WsClientState* state, uint8_t channels) {
+    // Alerts cannot be unsubscribed; a monitor must always see them
+    state->subscriptions &= ~(channels & ~WS_CHANNEL_ALERTS);
+}
+
+uint8_t WsClientTable::parseChannel(const char* name) {
+    if (strcmp(name, "vitals") == 0) return WS_CHANNEL_VITALS;
+    if (strcmp(name, "alerts") == 0) return WS_CHANNEL_ALERTS;
+    if (strcmp(name, "waveform") == 0) return WS_CHANNEL_WAVEFORM;
+    if (strcmp(name, "status") == 0) return WS_CHANNEL_STATUS;
+    if (strcmp(name, "all") == 0) {
+        return WS_CHANNEL_VITALS | WS_CHANNEL_ALERTS | WS_CHANNEL_WAVEFORM | WS_CHANNEL_STATUS;
+    }
+    return 0;
+}
+
+void WsClientTable::updateLag(WsClientState* state, WsLagLevel level, unsigned long now) {
+    if (level == WS_LAG_STALLED) {
+        if (state->lagLevel != WS_LAG_STALLED) {
+            state->stalledSince = now;
+        }
+    } else {
+        state->stalledSince = 0;
+    }
+    state->lagLevel = level;
+}
+
+bool WsClientTable::shouldSend(WsClientState* state, WsChannel channel) {
+    if (!(state->subscriptions & channel)) {
+        return false;
+    }
+
+    // Alerts bypass decimation; the caller queues them if the client is stalled
+    if (channel == WS_CHANNEL_ALERTS) {
+        return true;
+    }
+
+    state->frameCounter++;
+
+    bool send;
+    switch (state->lagLevel) {
+        case WS_LAG_NONE:
+            send = true;
+            break;
+        case WS_LAG_LIGHT:
+            send = (state->frameCounter % 2) == 0;
+            break;
+        case WS_LAG_HEAVY:
+            send = (state->frameCounter % 4) == 0;
+            break;
+        default:
+            send = false;
+            break;
+    }
+
+    if (!send) {
+        state->droppedFrames++;
+    }
+    return send;
+}
+
+bool WsClientTable::isEvictable(WsClientState* state, unsigned long now) {
+    return state->lagLevel == WS_LAG_STALLED &&
+           (now - state->stalledSince) > SLOW_CLIENT_TIMEOUT;
+}
+
+int WsClientTable::broadcast(WsFrame* frame, WsChannel channel, WsPeer* const* peers, int count, unsigned long now) {
+    // The frame was serialized exactly once; every client gets the same bytes
+    int sent = 0;
+    for (int i = 0; i < count; i++) {
+        WsPeer* peer = peers[i];
+        WsClientState* state = find(peer->id());
+        if (!state) continue;
+
+        updateLag(state, measureLag(peer), now);
+        if (!shouldSend(state, channel)) continue;
+
+        if (channel == WS_CHANNEL_ALERTS) {
+            if (deliverAlert(peer, state, frame)) sent++;
+            continue;
+        }
+
+        peer->sendFrame(frame);
+        sent++;
+    }
+    return sent;
+}
+
+WsLagLevel WsClientTable::measureLag(WsPeer* peer) {
+    if (peer->queueIsFull()) {
+        return WS_LAG_STALLED;
+    }
+
+    // Free TCP send window tells us how much is still unacknowledged
+    size_t space = peer->sendSpace();
+    if (space < 512) return WS_LAG_HEAVY;
+    if (space < 2048) return WS_LAG_LIGHT;
+    return WS_LAG_NONE;
+}
+
+bool WsClientTable::deliverAlert(WsPeer* peer, WsClientState* state, WsFrame* frame) {
+    // Keep alert order: older pending alerts go first
+    if (state->pendingCount > 0 || peer->queueIsFull()) {
+        if (!queueAlert(state, frame)) {
+            // Closing makes the dashboard reconnect and resync, which loses
+            // nothing; dropping the alert would
+            evictedCount++;
+            peer->close();
+            return false;
+        }
+        return true;
+    }
+
+    peer->sendFrame(frame);
+    return true;
+}
+
+void WsClientTable::service(WsPeer* const* peers, int count, unsigned long now, WsServiceStats& stats) {
+    stats.maxBacklog = 0;
+    stats.heldAlerts = 0;
+    stats.evicted = 0;
+
+    for (int i = 0; i < count; i++) {
+        WsPeer* peer = peers[i];
+        WsClientState* state = find(peer->id());
+        if (!state) continue;
+
+        updateLag(state, measureLag(peer), now);
+
+        int32_t backlog = (int32_t)peer->sendBacklog();
+        if (backlog > stats.maxBacklog) stats.maxBacklog = backlog;
+
+        // Flush alerts that were held back while the client was stalled
+        const WsHeldAlert* pending = peekAlert(state);
+        while (pending && !peer->queueIsFull()) {
+            peer->sendText(pending->data, pending->length);
+            popAlert(state);
+            pending = peekAlert(state);
+        }
+
+        if (isEvictable(state, now)) {
+            evictedCount++;
+            stats.evicted++;
+            peer->close();
+        }
+        stats.heldAlerts += state->pendingCount;
+    }
+}
+
+bool WsClientTable::queueAlert(WsClientState* state, const WsFrame* frame) {
+    // Caller evicts the client rather than drop an alert
+    if (state->pendingCount >= WsClientState::MAX_PENDING_ALERTS || frame->length > WsHeldAlert::CAPACITY) {
+        return false;
+    }
+
+    int held = 0;
+    while (held < MAX_HELD_ALERTS && heldAlerts[held].inUse) held++;
+    if (held == MAX_HELD_ALERTS) {
+        return false;
+    }
+
+    memcpy(heldAlerts[held].data, frame->data, frame->length);
+    heldAlerts[held].length = frame->length;
+    heldAlerts[held].inUse = true;
+
+    int slot = (state->pendingHead + state->pendingCount) % WsClientState::MAX_PENDING_ALERTS;
+    state->pendingAlerts[slot] = held;
+    state->pendingCount++;
+    return true;
+}
+
+const WsHeldAlert* WsClientTable::peekAlert(WsClientState* state) {
+    if (state->pendingCount == 0) {
+        return nullptr;
+    }
+    return &heldAlerts[state->pendingAlerts[state->pendingHead]];
+}
+
+void WsClientTable::popAlert(WsClientState* state) {
+    if (state->pendingCount == 0) {
+        return;
+    }
+
+    heldAlerts[state->pendingAlerts[state->pendingHead]].inUse = false;
+    state->pendingHead = (state->pendingHead + 1) % WsClientState::MAX_PENDING_ALERTS;
+    state->pendingCount--;
+}
+
+int WsClientTable::getHeldAlertCount() {
+    int count = 0;
+    for (int i = 0; i < MAX_HELD_ALERTS; i++) {
+        if (heldAlerts[i].inUse) {
+            count++;
+        }
+    }
+    return count;
+}
+
+uint32_t WsClientTable::getEvictedCount() {
+    return evictedCount;
+}
+
+int WsClientTable::getClientCount() {
+    int count = 0;
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (clients[i].inUse) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void WsClientTable::resetSlot(WsClientState* state) {
+    // Free the alerts still held for this client
+    while (state->pendingCount > 0) {
+        popAlert(state);
+    }
+
+    state->clientId = 0;
+    state->subscriptions = DEFAULT_SUBSCRIPTIONS;
+    state->lagLevel = WS_LAG_NONE;
+    state->frameCounter = 0;
+    state->stalledSince = 0;
+    state->droppedFrames = 0;
+    state->pendingHead = 0;
+    state->pendingCount = 0;
+    for (int i = 0; i < WsClientState::MAX_PENDING_ALERTS; i++) {
+        state->pendingAlerts[i] = 0;
+    }
+}
+
+bool readSubscription(const char* json, size_t length, bool& subscribe, uint8_t& channels) {
+    FlatJsonReader reader(json, length);
+    const char* key;
+    size_t keyLength;
+    char type[16] = "";
+    channels = 0;
+    while (reader.next(key, keyLength)) {
+        if (jsonKeyIs(key, keyLength, "type")) {
+            reader.readString(type, sizeof(type));
+        } else if (jsonKeyIs(key, keyLength, "data")) {
+            reader.readStrings([&](const char* name) { channels |= WsClientTable::parseChannel(name); });
+        } else {
+            reader.skip();
+        }
+    }
+    subscribe = strcmp(type, "subscribe") == 0;
+    return subscribe || strcmp(type, "unsubscribe") == 0;
+}
+
+bool readCommand(const char* json, size_t length, char* command, size_t size) {
+    FlatJsonReader reader(json, length);
+    const char* key;
+    size_t keyLength;
+    command[0] = '\0';
+    while (reader.next(key, keyLength)) {
+        if (jsonKeyIs(key, keyLength, "command")) {
+            reader.readString(command, size);
+        } else {
+            reader.skip();
+        }
+    }
+    return !reader.hasFailed();
+}
@@ -0,0 +1,130 @@
+#ifndef WS_CLIENTS_H
+#define WS_CLIENTS_H
+
+#include <Arduino.h>
+#include "ws_frame_pool.h"
+
+// Message channels a WebSocket client can subscribe to
+enum WsChannel : uint8_t {
+    WS_CHANNEL_VITALS   = 0x01,
+    WS_CHANNEL_ALERTS   = 0x02,
+    WS_CHANNEL_WAVEFORM = 0x04,
+    WS_CHANNEL_STATUS   = 0x08
+};
+
+// How far behind a client's send queue is
+enum WsLagLevel : uint8_t {
+    WS_LAG_NONE,
+    WS_LAG_LIGHT,    // send every 2nd frame
+    WS_LAG_HEAVY,    // send every 4th frame
+    WS_LAG_STALLED   // queue full, only alerts are kept
+};
+
+struct WsClientState {
+    static const int MAX_PENDING_ALERTS = 4;
+
+    bool inUse;
+    uint32_t clientId;
+    uint8_t subscriptions;
+    uint8_t lagLevel;
+    uint8_t frameCounter;
+    unsigned long stalledSince;
+    uint32_t droppedFrames;
+
+    // Alerts that could not be queued yet, as slots of the table's held alerts
+    uint8_t pendingAlerts[MAX_PENDING_ALERTS];
+    uint8_t pendingHead;
+    uint8_t pendingCount;
+};
+
+// An alert held for a stalled client. It is a copy: a pool frame pinned for
+// as long as a client stays stalled would starve the broadcasts.
+struct WsHeldAlert {
+    static const size_t CAPACITY = 192;
+    char data[CAPACITY];
+    uint16_t length;
+    bool inUse;
+};
+
+// What one service pass found, for /metrics
+struct WsServiceStats {
+    int32_t maxBacklog;     // Largest unacknowledged send backlog, bytes
+    int32_t heldAlerts;
+    int evicted;
+};
+
+// One connected client as the table drives it. web_interface.cpp wraps
+// AsyncWebSocketClient in it; the native tests use a fake.
+class WsPeer {
+public:
+    virtual ~WsPeer() {}
+    virtual uint32_t id() = 0;
+    virtual bool queueIsFull() = 0;
+    virtual size_t sendSpace() = 0;     // Free TCP send window in bytes
+    // Queues a frame's bytes; a broadcast frame is shared by every client
+    // it goes to, so this must not copy it per client
+    virtual void sendFrame(WsFrame* frame) = 0;
+    virtual void sendText(const char* data, size_t length) = 0;
+    virtual size_t sendBacklog() = 0;   // Sent but unacknowledged bytes
+    virtual void close() = 0;
+};
+
+class WsClientTable {
+public:
+    static const int MAX_CLIENTS = 8;
+    static const unsigned long SLOW_CLIENT_TIMEOUT = 10000; // ms stalled before eviction
+    static const int MAX_HELD_ALERTS = 8;                   // Across all clients
+
+private:
+    WsClientState clients[MAX_CLIENTS];
+    WsHeldAlert heldAlerts[MAX_HELD_ALERTS];
+    uint32_t evictedCount;      // Clients closed for falling behind
+
+public:
+    WsClientTable();
+    bool attach(uint32_t clientId);
+    void detach(uint32_t clientId);
+    WsClientState* find(uint32_t clientId);
+
+    void subscribe(WsClientState* state, uint8_t channels);
+    void unsubscribe(WsClientState* state, uint8_t channels);
+    static uint8_t parseChannel(const char* name);
+
+    void updateLag(WsClientState* state, WsLagLevel level, unsigned long now);
+    bool shouldSend(WsClientState* state, WsChannel channel);
+    bool isEvictable(WsClientState* state, unsigned long now);
+
+    // Sends one serialized frame to every peer subscribed to the channel,
+    // as far as each one's lag allows; returns how many it went to
+    int broadcast(WsFrame* frame, WsChannel channel, WsPeer* const* peers, int count, unsigned long now);
+    static WsLagLevel measureLag(WsPeer* peer);
+    bool deliverAlert(WsPeer* peer, WsClientState* state, WsFrame* frame);
+    // Per-client upkeep between broadcasts: re-measures lag, sends the alerts
+    // held while a client was stalled, and closes clients stalled too long
+    void service(WsPeer* const* peers, int count, unsigned long now, WsServiceStats& stats);
+
+    bool queueAlert(WsClientState* state, const WsFrame* frame);
+    const WsHeldAlert* peekAlert(WsClientState* state);
+    void popAlert(WsClientState* state);
+    int getHeldAlertCount();
+
+    int getClientCount();
+    uint32_t getEvictedCount();
+
+private:
+    void resetSlot(WsClientState* state);
+};
+
+// The messages a dashboard sends, read in place (json_reader.h) by
+// web_interface.cpp and by the host tools that stand in for a monitor:
+//   {"type":"subscribe","data":"waveform"}
+//   {"type":"unsubscribe","data":["vitals","alerts","waveform","status"]}
+//   {"command":"getVitals"}, {"command":"getStatus"}
+// A subscribe or unsubscribe and its channels; false if it is neither
+bool readSubscription(const char* json, size_t length, bool& subscribe, uint8_t& channels);
+// The "command" member, "" if there is none; false if not a JSON object
+bool readCommand(const char* json, size_t length, char* command, size_t size);
+
+extern WsClientTable wsClients;
+
+#endif
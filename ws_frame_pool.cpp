@@ -0,0 +1,86 @@
+#include "ws_frame_pool.h"
+
+WsFramePool wsFramePool;
+
+WsFramePool::WsFramePool() {
+    nextSlot = 0;
+    acquiredCount = 0;
+    exhaustedCount = 0;
+    overReleasedCount = 0;
+
+    for (int i = 0; i < POOL_SIZE; i++) {
+        frames[i].length = 0;
+        frames[i].refCount.store(0);
+    }
+}
+
+WsFrame* WsFramePool::acquire(WsFrame* spare) {
+    // Round-robin scan so a recently released frame is not reused immediately
+    for (int i = 0; i < POOL_SIZE; i++) {
+        WsFrame* frame = &frames[(nextSlot + i) % POOL_SIZE];
+        uint8_t expected = 0;
+        if (frame->refCount.compare_exchange_strong(expected, 1)) {
+            nextSlot = (nextSlot + i + 1) % POOL_SIZE;
+            frame->length = 0;
+            acquiredCount++;
+            return frame;
+        }
+    }
+
+    // Every frame is still referenced. The caller's spare, usually on its
+    // stack, takes this one broadcast rather than it being skipped; release()
+    // works on it like on a pooled frame.
+    exhaustedCount++;
+    if (spare) {
+        spare->length = 0;
+        spare->refCount.store(1);
+    }
+    return spare;
+}
+
+void WsFramePool::retain(WsFrame* frame) {
+    if (frame) {
+        frame->refCount.fetch_add(1);
+    }
+}
+
+void WsFramePool::release(WsFrame* frame) {
+    if (!frame) {
+        return;
+    }
+
+    // One atomic step: a separate check and decrement would let two holders
+    // both see a count of 1 and take it below zero
+    uint8_t previous = frame->refCount.fetch_sub(1);
+    if (previous == 0) {
+        // Released more often than retained; undo rather than wrap to 255
+        frame->refCount.fetch_add(1);
+        overReleasedCount++;
+    }
+}
+
+bool WsFramePool::owns(const WsFrame* frame) const {
+    return frame >= &frames[0] && frame < &frames[POOL_SIZE];
+}
+
+int WsFramePool::getInFlight() {
+    int count = 0;
+    for (int i = 0; i < POOL_SIZE; i++) {
+        if (frames[i].refCount.load() != 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+uint32_t WsFramePool::getAcquiredCount() {
+    return acquiredCount;
+}
+
+uint32_t WsFramePool::getExhaustedCount() {
+    return exhaustedCount;
+}
+
+uint32_t WsFramePool::getOverReleasedCount() {
+    return overReleasedCount;
+}
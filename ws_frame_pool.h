@@ -0,0 +1,44 @@
+#ifndef WS_FRAME_POOL_H
+#define WS_FRAME_POOL_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// A serialized WebSocket text frame shared by every client it is sent to.
+// The frame is written once and then only read; each holder owns one reference.
+struct WsFrame {
+    static const size_t CAPACITY = 512;
+    char data[CAPACITY];
+    size_t length;
+    std::atomic<uint8_t> refCount;
+};
+
+// Fixed pool of frames so broadcasts never touch the heap.
+class WsFramePool {
+public:
+    static const int POOL_SIZE = 8;
+
+private:
+    WsFrame frames[POOL_SIZE];
+    int nextSlot;
+    uint32_t acquiredCount;
+    uint32_t exhaustedCount;
+    std::atomic<uint32_t> overReleasedCount;
+
+public:
+    WsFramePool();
+    // A frame with one reference, or `spare` if every frame is in use
+    WsFrame* acquire(WsFrame* spare = nullptr);
+    void retain(WsFrame* frame);
+    void release(WsFrame* frame);
+    // Whether the frame is one of the pool's, not a caller's spare
+    bool owns(const WsFrame* frame) const;
+    int getInFlight();
+    uint32_t getAcquiredCount();
+    uint32_t getExhaustedCount();
+    uint32_t getOverReleasedCount();
+};
+
+extern WsFramePool wsFramePool;
+
+#endif
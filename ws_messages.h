@@ -0,0 +1,61 @@
+#ifndef WS_MESSAGES_H
+#define WS_MESSAGES_H
+
+#include <stdint.h>
+#include "json_schema.h"
+#include "vital_signs.h"
+
+// Shapes of the WebSocket messages a monitor sends on /ws, shared by
+// web_interface.cpp and the host tools that speak the protocol (gateway/).
+// The "vitals" message is VitalsMessageSchema in vital_signs.h; "waveform"
+// is {"type":"waveform","timestamp":ms,"data":[counts...]}.
+
+struct SystemStatus {
+    bool wifiConnected;
+    uint32_t freeHeap;
+    unsigned long uptime;
+    const char* version;
+    int clients;
+};
+
+// Shape served by /api/status
+template <>
+struct JsonSchema<SystemStatus> {
+    static constexpr auto fields() {
+        return std::make_tuple(
+            jsonMember("wifiConnected", &SystemStatus::wifiConnected),
+            jsonMember("freeHeap", &SystemStatus::freeHeap),
+            jsonMember("uptime", &SystemStatus::uptime),
+            jsonMember("version", &SystemStatus::version));
+    }
+};
+
+// WebSocket "status" message
+struct StatusMessageSchema {
+    static constexpr auto fields() {
+        return std::make_tuple(
+            jsonConstant("type", "status"),
+            jsonMember("wifiConnected", &SystemStatus::wifiConnected),
+            jsonMember("freeHeap", &SystemStatus::freeHeap),
+            jsonMember("uptime", &SystemStatus::uptime),
+            jsonMember("clients", &SystemStatus::clients));
+    }
+};
+
+struct AlertMessage {
+    const char* message;
+    unsigned long timestamp;
+};
+
+// WebSocket "alert" message
+template <>
+struct JsonSchema<AlertMessage> {
+    static constexpr auto fields() {
+        return std::make_tuple(
+            jsonConstant("type", "alert"),
+            jsonMember("message", &AlertMessage::message),
+            jsonMember("timestamp", &AlertMessage::timestamp));
+    }
+};
+
+#endif